@@ -4,6 +4,7 @@
 #include "file_manager/file_manager.h"
 #include "ai_assistant/ai_assistant.h"
 #include "compiler/esp32_compiler.h"
+#include "compiler/library_index.h"
 #include "serial/serial_monitor.h"
 #include "emulator/vm_emulator.h"
 #include "gui/device_library.h"
@@ -11,11 +12,15 @@
 #include "gui/console_widget.h"
 #include "blueprint/blueprint_editor.h"
 #include "utils/ml_device_detector.h"
+#include "search/project_search.h"
+#include "visualization/serial_plotter.h"
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <filesystem>
+#include <cstdlib>
 
 namespace esp32_ide {
 
@@ -32,6 +37,8 @@ BackendFramework::BackendFramework()
     : initialized_(false),
       is_compiling_(false),
       is_uploading_(false),
+      search_index_loaded_(false),
+      library_index_loaded_(false),
       status_message_("Ready") {
 }
 
@@ -52,12 +59,15 @@ bool BackendFramework::Initialize() {
         ai_assistant_ = std::make_unique<AIAssistant>();
         compiler_ = std::make_unique<ESP32Compiler>();
         serial_monitor_ = std::make_unique<SerialMonitor>();
+        serial_plotter_ = std::make_unique<visualization::SerialPlotter>();
         vm_emulator_ = std::make_unique<VMEmulator>();
         device_library_ = std::make_unique<gui::DeviceLibrary>();
         terminal_ = std::make_unique<gui::IntegratedTerminal>();
         console_ = std::make_unique<gui::ConsoleWidget>();
         blueprint_editor_ = std::make_unique<blueprint::BlueprintEditor>();
         device_detector_ = std::make_unique<ml::MLDeviceDetector>();
+        search_index_ = std::make_unique<search::TrigramIndex>();
+        library_index_ = std::make_unique<LibraryIndex>();
         
         // Initialize device library
         device_library_->Initialize();
@@ -73,9 +83,7 @@ bool BackendFramework::Initialize() {
         LoadRecentFiles();
         
         // Create default sketch
-        file_manager_->CreateFile("sketch.ino", FileManager::GetDefaultSketch());
-        current_file_ = "sketch.ino";
-        text_editor_->SetText(FileManager::GetDefaultSketch());
+        OpenDefaultSketch();
         
         initialized_ = true;
         SetStatusMessage("ESP32 Driver IDE initialized");
@@ -100,12 +108,17 @@ void BackendFramework::Shutdown() {
     SaveRecentFiles();
     
     // Cleanup components
+    search_index_.reset();
+    search_index_loaded_ = false;
+    library_index_.reset();
+    library_index_loaded_ = false;
     device_detector_.reset();
     blueprint_editor_.reset();
     console_.reset();
     terminal_.reset();
     device_library_.reset();
     vm_emulator_.reset();
+    serial_plotter_.reset();
     serial_monitor_.reset();
     compiler_.reset();
     ai_assistant_.reset();
@@ -116,6 +129,12 @@ void BackendFramework::Shutdown() {
     initialized_ = false;
 }
 
+void BackendFramework::OpenDefaultSketch() {
+    file_manager_->CreateFile("sketch.ino", FileManager::GetDefaultSketch());
+    current_file_ = "sketch.ino";
+    text_editor_->SetText(FileManager::GetDefaultSketch());
+}
+
 void BackendFramework::InitializeDefaultBoard() {
     current_board_.name = "ESP32 Dev Module";
     current_board_.fqbn = "esp32:esp32:esp32";
@@ -318,14 +337,37 @@ bool BackendFramework::Verify() {
     EmitEvent({EventType::COMPILE_STARTED, "compiler", "Verification started", {}});
     SetStatusMessage("Compiling...");
     
+    // Libraries the sketch includes go on the include path of project
+    // builds, and their sources are compiled and linked with it. They are
+    // resolved again for every build, so the persistent build settings
+    // never collect libraries the sketch no longer uses.
+    ESP32Compiler::LibraryInputs libraries;
+    if (!compiler_->GetBuildSettings().project_dir.empty() && ResolveLibraries()) {
+        for (const auto& name : project_.libraries) {
+            const LibraryIndex::Library* library = library_index_->FindLibrary(name);
+            if (!library) continue;
+            if (std::find(libraries.include_paths.begin(), libraries.include_paths.end(),
+                          library->include_dir) == libraries.include_paths.end()) {
+                libraries.include_paths.push_back(library->include_dir);
+            }
+            libraries.sources.insert(libraries.sources.end(), library->sources.begin(), library->sources.end());
+        }
+    }
+    
     auto result = compiler_->Compile(text_editor_->GetText(), 
-                                     compiler_->GetBoard());
+                                     compiler_->GetBoard(), libraries);
     
     is_compiling_ = false;
     
     if (result.status == ESP32Compiler::CompileStatus::SUCCESS) {
         EmitEvent({EventType::COMPILE_SUCCESS, "compiler", "Compilation successful", {}});
         SetStatusMessage("Compilation successful");
+        // Crash output from the board is symbolized against the image just
+        // built; symbols of an older one would name the wrong functions
+        if (!result.output_file.empty() &&
+            !serial_monitor_->LoadFirmwareSymbols(result.output_file)) {
+            serial_monitor_->ClearFirmwareSymbols();
+        }
         return true;
     } else {
         std::string errors;
@@ -352,7 +394,7 @@ bool BackendFramework::Upload() {
     EmitEvent({EventType::UPLOAD_STARTED, "compiler", "Upload started", {}});
     SetStatusMessage("Uploading to " + current_board_.port + "...");
     
-    bool success = compiler_->Upload(compiler_->GetBoard());
+    bool success = compiler_->Upload(compiler_->GetBoard(), current_board_.port);
     
     is_uploading_ = false;
     
@@ -414,6 +456,22 @@ bool BackendFramework::IsSerialOpen() const {
     return serial_monitor_ && serial_monitor_->IsConnected();
 }
 
+bool BackendFramework::OpenSerialPlotter() {
+    if (!serial_monitor_->IsConnected() && !OpenSerialMonitor()) {
+        return false;
+    }
+    // Device output only, not the monitor's own status messages
+    serial_monitor_->SetBatchCallback([this](const SerialMonitor::SerialMessage* messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (messages[i].type == SerialMonitor::MessageType::NORMAL) {
+                serial_plotter_->AddLine(messages[i].content);
+            }
+        }
+    });
+    SetStatusMessage("Serial plotter: " + current_board_.port);
+    return true;
+}
+
 // Emulator operations
 bool BackendFramework::StartEmulator() {
     vm_emulator_->Start();
@@ -462,9 +520,131 @@ bool BackendFramework::CreateProject(const std::string& name, const std::string&
 }
 
 bool BackendFramework::OpenProject(const std::string& path) {
-    project_.path = path;
-    // Would scan directory for project files
-    SetStatusMessage("Opened project: " + path);
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+        EmitEvent({EventType::ERROR_MESSAGE, "file_manager", "Not a project directory: " + path, {}});
+        return false;
+    }
+    project_ = ProjectConfig();
+    project_.path = std::filesystem::absolute(path, ec).lexically_normal().string();
+    project_.name = std::filesystem::path(project_.path).filename().string();
+    search_index_loaded_ = false;
+    library_index_loaded_ = false;
+    
+    // Project builds run in the project directory instead of syntax-only
+    ESP32Compiler::BuildSettings settings = compiler_->GetBuildSettings();
+    settings.project_dir = project_.path;
+    compiler_->SetBuildSettings(settings);
+    
+    // The sketch named after the folder, as in the Arduino IDE, else the first one
+    std::string sketch;
+    for (const auto& entry : std::filesystem::directory_iterator(project_.path, ec)) {
+        if (entry.path().extension() != ".ino") continue;
+        if (sketch.empty() || entry.path().stem() == project_.name) {
+            sketch = entry.path().string();
+        }
+    }
+    if (!sketch.empty()) {
+        std::ifstream in(sketch, std::ios::binary);
+        std::stringstream content;
+        content << in.rdbuf();
+        project_.mainFile = std::filesystem::path(sketch).filename().string();
+        if (!file_manager_->FileExists(project_.mainFile)) {
+            file_manager_->CreateFile(project_.mainFile, content.str());
+        } else {
+            file_manager_->SetFileContent(project_.mainFile, content.str());
+        }
+        current_file_ = project_.mainFile;
+        text_editor_->SetText(content.str());
+    }
+    SetStatusMessage("Opened project: " + project_.path);
+    return true;
+}
+
+std::string BackendFramework::GetProjectRoot() const {
+    return project_.path.empty() ? "." : project_.path;
+}
+
+std::string BackendFramework::GetSearchIndexPath() const {
+    return GetProjectRoot() + "/.esp32ide/search.idx";
+}
+
+size_t BackendFramework::UpdateSearchIndex() {
+    if (!search_index_) {
+        return 0;
+    }
+    
+    // Reuse the persisted index so only files changed since the last run
+    // are re-read
+    if (!search_index_loaded_) {
+        search_index_->Load(GetSearchIndexPath());
+        search_index_loaded_ = true;
+    }
+    
+    size_t disk_changes = search_index_->Refresh();
+    disk_changes += search_index_->IndexDirectory(GetProjectRoot());
+    
+    // Unsaved buffers only live in memory, so they never force a rewrite
+    size_t buffer_changes = search_index_->IndexFileManager(*file_manager_);
+    
+    if (disk_changes > 0) {
+        std::error_code ec;
+        std::filesystem::create_directories(GetProjectRoot() + "/.esp32ide", ec);
+        if (!ec) {
+            search_index_->Save(GetSearchIndexPath());
+        }
+    }
+    return disk_changes + buffer_changes;
+}
+
+std::string BackendFramework::GetLibraryIndexPath() const {
+    return GetProjectRoot() + "/.esp32ide/libraries.idx";
+}
+
+size_t BackendFramework::UpdateLibraryIndex() {
+    // The index is saved inside the project; without one it would land in
+    // whatever the working directory happens to be
+    if (!library_index_ || project_.path.empty()) {
+        return 0;
+    }
+    
+    if (!library_index_loaded_) {
+        library_index_->Load(GetLibraryIndexPath());
+        library_index_loaded_ = true;
+    }
+    
+    const char* home = std::getenv("HOME");
+    std::string sketchbook = home ? std::string(home) + "/Arduino/libraries" : "";
+    library_index_->ClearSearchRoots();
+    library_index_->AddSearchRoot(GetProjectRoot() + "/libraries", LibraryIndex::Location::PROJECT);
+    library_index_->AddSearchRoot(GetPreference("libraries.user", sketchbook), LibraryIndex::Location::USER);
+    library_index_->AddSearchRoot(GetPreference("libraries.platform"), LibraryIndex::Location::PLATFORM);
+    library_index_->AddSearchRoot(GetPreference("libraries.builtin"), LibraryIndex::Location::BUILTIN);
+    
+    // Only libraries whose folders changed since the last run are re-read
+    size_t changes = library_index_->Update();
+    if (library_index_->IsDirty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(GetProjectRoot() + "/.esp32ide", ec);
+        if (!ec) {
+            library_index_->Save(GetLibraryIndexPath());
+        }
+    }
+    return changes;
+}
+
+bool BackendFramework::ResolveLibraries() {
+    if (!library_index_ || !text_editor_ || project_.path.empty()) {
+        return false;
+    }
+    UpdateLibraryIndex();
+    
+    std::string architecture = LibraryIndex::GetArchitecture(current_board_.fqbn);
+    LibraryIndex::Resolution resolution = library_index_->ResolveSource(text_editor_->GetText(), architecture);
+    project_.libraries.clear();
+    for (const auto* library : resolution.libraries) {
+        project_.libraries.push_back(library->folder);
+    }
     return true;
 }
 
@@ -479,6 +659,41 @@ bool BackendFramework::CloseProject() {
     return true;
 }
 
+struct BackendFramework::WorkspaceBaseline {
+    BoardConfig board;
+    ESP32Compiler::BoardType compiler_board;
+    ESP32Compiler::BuildSettings build_settings;
+};
+
+void BackendFramework::CaptureWorkspace() {
+    workspace_baseline_ = std::make_unique<WorkspaceBaseline>();
+    workspace_baseline_->board = current_board_;
+    workspace_baseline_->compiler_board = compiler_->GetBoard();
+    workspace_baseline_->build_settings = compiler_->GetBuildSettings();
+}
+
+void BackendFramework::ResetWorkspace() {
+    project_ = ProjectConfig();
+    // Open files and the editor's buffer and history start over
+    file_manager_ = std::make_unique<FileManager>();
+    text_editor_ = std::make_unique<TextEditor>();
+    OpenDefaultSketch();
+    if (workspace_baseline_) {
+        current_board_ = workspace_baseline_->board;
+        compiler_->SetBoard(workspace_baseline_->compiler_board);
+        compiler_->SetBuildSettings(workspace_baseline_->build_settings);
+    } else {
+        ESP32Compiler::BuildSettings settings = compiler_->GetBuildSettings();
+        settings.project_dir.clear();
+        compiler_->SetBuildSettings(settings);
+    }
+    if (search_index_) {
+        search_index_->Clear();
+    }
+    search_index_loaded_ = false;
+    library_index_loaded_ = false;
+}
+
 // AI operations
 std::string BackendFramework::QueryAI(const std::string& query) {
     EmitEvent({EventType::AI_QUERY_STARTED, "ai", query, {}});
@@ -651,9 +866,21 @@ void ShowSketchFolder() {
 }
 
 void IncludeLibrary(const std::string& library) {
-    auto* editor = BackendFramework::GetInstance().GetTextEditor();
+    auto& framework = BackendFramework::GetInstance();
+    auto* editor = framework.GetTextEditor();
     if (editor) {
-        std::string include = "#include <" + library + ".h>\n";
+        // The headers the library asks for, else the one named after it
+        std::string include;
+        framework.UpdateLibraryIndex();
+        const LibraryIndex::Library* found =
+            framework.GetLibraryIndex() ? framework.GetLibraryIndex()->FindLibrary(library) : nullptr;
+        if (found) {
+            for (const auto& header : found->default_includes) {
+                include += "#include <" + header + ">\n";
+            }
+        } else {
+            include = "#include <" + library + ".h>\n";
+        }
         editor->InsertText(include, 0);
     }
 }
@@ -689,8 +916,7 @@ void SerialMonitor() {
 }
 
 void SerialPlotter() {
-    // Would open serial plotter
-    std::cout << "Tools > Serial Plotter\n";
+    BackendFramework::GetInstance().OpenSerialPlotter();
 }
 
 void ManageLibraries() {
@@ -15,6 +15,7 @@ class SyntaxHighlighter;
 class FileManager;
 class AIAssistant;
 class ESP32Compiler;
+class LibraryIndex;
 class SerialMonitor;
 class VMEmulator;
 
@@ -32,6 +33,14 @@ namespace ml {
 class MLDeviceDetector;
 }
 
+namespace search {
+class TrigramIndex;
+}
+
+namespace visualization {
+class SerialPlotter;
+}
+
 /**
  * @brief Backend framework that centralizes IDE component management
  * 
@@ -157,11 +166,14 @@ public:
     AIAssistant* GetAIAssistant() { return ai_assistant_.get(); }
     ESP32Compiler* GetCompiler() { return compiler_.get(); }
     SerialMonitor* GetSerialMonitor() { return serial_monitor_.get(); }
+    visualization::SerialPlotter* GetSerialPlotter() { return serial_plotter_.get(); }
     VMEmulator* GetEmulator() { return vm_emulator_.get(); }
     gui::DeviceLibrary* GetDeviceLibrary() { return device_library_.get(); }
     gui::IntegratedTerminal* GetTerminal() { return terminal_.get(); }
     blueprint::BlueprintEditor* GetBlueprintEditor() { return blueprint_editor_.get(); }
     ml::MLDeviceDetector* GetDeviceDetector() { return device_detector_.get(); }
+    search::TrigramIndex* GetSearchIndex() { return search_index_.get(); }
+    LibraryIndex* GetLibraryIndex() { return library_index_.get(); }
     
     // Event system
     void AddEventHandler(EventType type, EventHandler handler);
@@ -196,6 +208,8 @@ public:
     void SetSerialBaudRate(int baud);
     void SendSerialData(const std::string& data);
     bool IsSerialOpen() const;
+    // Opens the monitor if needed and plots the device's output
+    bool OpenSerialPlotter();
     
     // Emulator operations
     bool StartEmulator();
@@ -208,6 +222,27 @@ public:
     bool SaveProject();
     bool CloseProject();
     ProjectConfig GetProjectConfig() const { return project_; }
+    // Forgets the open project and files, the editor buffer, the board
+    // and build settings chosen since CaptureWorkspace(), and the indexes
+    // built for the working directory, so the daemon's next client starts
+    // from its own directory
+    void ResetWorkspace();
+    // Remembers the board and build settings ResetWorkspace() returns to
+    void CaptureWorkspace();
+    
+    // Project search
+    std::string GetProjectRoot() const;
+    std::string GetSearchIndexPath() const;
+    size_t UpdateSearchIndex();
+    
+    // Library index over the project, sketchbook, platform and builtin
+    // library folders ("libraries.user", "libraries.platform" and
+    // "libraries.builtin" preferences); kept in the project, so nothing is
+    // indexed while no project is open
+    std::string GetLibraryIndexPath() const;
+    size_t UpdateLibraryIndex();
+    // Fills the project's libraries from the sketch's includes
+    bool ResolveLibraries();
     
     // AI operations
     std::string QueryAI(const std::string& query);
@@ -240,12 +275,15 @@ private:
     std::unique_ptr<AIAssistant> ai_assistant_;
     std::unique_ptr<ESP32Compiler> compiler_;
     std::unique_ptr<SerialMonitor> serial_monitor_;
+    std::unique_ptr<visualization::SerialPlotter> serial_plotter_;
     std::unique_ptr<VMEmulator> vm_emulator_;
     std::unique_ptr<gui::DeviceLibrary> device_library_;
     std::unique_ptr<gui::IntegratedTerminal> terminal_;
     std::unique_ptr<gui::ConsoleWidget> console_;
     std::unique_ptr<blueprint::BlueprintEditor> blueprint_editor_;
     std::unique_ptr<ml::MLDeviceDetector> device_detector_;
+    std::unique_ptr<search::TrigramIndex> search_index_;
+    std::unique_ptr<LibraryIndex> library_index_;
     
     // Event handlers
     std::map<EventType, std::vector<EventHandler>> event_handlers_;
@@ -254,6 +292,8 @@ private:
     bool initialized_;
     bool is_compiling_;
     bool is_uploading_;
+    bool search_index_loaded_;
+    bool library_index_loaded_;
     std::string status_message_;
     std::string current_file_;
     
@@ -262,9 +302,12 @@ private:
     ProjectConfig project_;
     std::map<std::string, std::string> preferences_;
     std::vector<std::string> recent_files_;
+    struct WorkspaceBaseline;
+    std::unique_ptr<WorkspaceBaseline> workspace_baseline_;
     
     // Helper methods
     void InitializeDefaultBoard();
+    void OpenDefaultSketch();
     void LoadRecentFiles();
     void SaveRecentFiles();
     void AddToRecentFiles(const std::string& filename);
@@ -562,16 +562,16 @@ void CodeReviewSystem::TrackChange(const std::string& file_path, int line_number
                                    const std::string& old_content,
                                    const std::string& new_content, 
                                    const std::string& author) {
-    ChangeTracker change;
+    StoredChange change;
     change.file_path = file_path;
     change.line_number = line_number;
     change.change_type = change_type;
-    change.old_content = old_content;
-    change.new_content = new_content;
+    change.old_content = utils::BlobRef(old_content);
+    change.new_content = utils::BlobRef(new_content);
     change.author = author;
     change.timestamp = std::chrono::system_clock::now();
     
-    change_history_.push_back(change);
+    change_history_.push_back(std::move(change));
 }
 
 std::vector<CodeReviewSystem::ChangeTracker> CodeReviewSystem::GetChanges(
@@ -580,7 +580,7 @@ std::vector<CodeReviewSystem::ChangeTracker> CodeReviewSystem::GetChanges(
     
     for (const auto& change : change_history_) {
         if (change.file_path == file_path) {
-            result.push_back(change);
+            result.push_back(ToChangeTracker(change));
         }
     }
     
@@ -592,12 +592,24 @@ std::vector<CodeReviewSystem::ChangeTracker> CodeReviewSystem::GetRecentChanges(
     
     int start = std::max(0, static_cast<int>(change_history_.size()) - max_count);
     for (int i = start; i < static_cast<int>(change_history_.size()); ++i) {
-        result.push_back(change_history_[i]);
+        result.push_back(ToChangeTracker(change_history_[i]));
     }
     
     return result;
 }
 
+CodeReviewSystem::ChangeTracker CodeReviewSystem::ToChangeTracker(const StoredChange& change) {
+    ChangeTracker tracker;
+    tracker.file_path = change.file_path;
+    tracker.line_number = change.line_number;
+    tracker.change_type = change.change_type;
+    tracker.old_content = change.old_content.Get();
+    tracker.new_content = change.new_content.Get();
+    tracker.author = change.author;
+    tracker.timestamp = change.timestamp;
+    return tracker;
+}
+
 void CodeReviewSystem::ClearChangeHistory() {
     change_history_.clear();
 }
@@ -8,6 +8,8 @@
 #include <functional>
 #include <chrono>
 
+#include "utils/blob_store.h"
+
 namespace esp32_ide {
 namespace collaboration {
 
@@ -338,11 +340,24 @@ public:
 private:
     std::map<std::string, CodeReview> reviews_;
     std::map<std::string, ReviewComment> comments_;
-    std::vector<ChangeTracker> change_history_;
+    // Change history keeps old/new contents as blob handles; ChangeTracker
+    // values are materialized only when queried
+    struct StoredChange {
+        std::string file_path;
+        int line_number;
+        std::string change_type;
+        utils::BlobRef old_content;
+        utils::BlobRef new_content;
+        std::string author;
+        std::chrono::system_clock::time_point timestamp;
+    };
+    
+    std::vector<StoredChange> change_history_;
     int next_review_id_;
     int next_comment_id_;
     
     std::string GenerateId(const std::string& prefix);
+    static ChangeTracker ToChangeTracker(const StoredChange& change);
 };
 
 } // namespace collaboration
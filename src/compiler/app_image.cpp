@@ -0,0 +1,271 @@
+#include "compiler/app_image.h"
+#include "utils/mapped_file.h"
+#include "utils/sha256.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace esp32_ide {
+
+namespace {
+
+// ELF constants
+const uint8_t kElfClass32 = 1;
+const uint8_t kElfClass64 = 2;
+const uint8_t kElfDataLittle = 1;
+const uint32_t kPtLoad = 1;
+
+// esp_app_format.h
+const uint8_t kImageMagic = 0xE9;
+const uint8_t kSpiModeDio = 2;
+const uint8_t kSpiSize4MbDefaultSpeed = 0x20;    // size code in the high nibble, speed 0
+const uint8_t kWpPinDisabled = 0xEE;
+const size_t kMaxSegments = 16;
+const size_t kSegmentHeaderSize = 8;
+const uint32_t kMmuPageSize = 0x10000;
+// Older second-stage bootloaders skip the last MMU page of a flash
+// segment ending less than this far into it (esptool pads the same way)
+const uint32_t kMinPageTail = 0x24;
+
+uint16_t Read16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t Read32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t Read64(const unsigned char* p) {
+    return static_cast<uint64_t>(Read32(p)) | (static_cast<uint64_t>(Read32(p + 4)) << 32);
+}
+
+void Put16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xFF));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void Put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+std::string Hex32(uint32_t value) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "0x%08x", value);
+    return buffer;
+}
+
+// Sorted by address, touching segments merged, each padded to whole words
+void Coalesce(std::vector<AppImage::Segment>& segments) {
+    std::sort(segments.begin(), segments.end(), [](const AppImage::Segment& a, const AppImage::Segment& b) {
+        return a.address < b.address;
+    });
+    std::vector<AppImage::Segment> merged;
+    for (auto& segment : segments) {
+        if (!merged.empty() && merged.back().address + merged.back().data.size() == segment.address) {
+            merged.back().data += segment.data;
+        } else {
+            merged.push_back(std::move(segment));
+        }
+    }
+    for (auto& segment : merged) {
+        segment.data.append((4 - segment.data.size() % 4) % 4, '\0');
+    }
+    segments = std::move(merged);
+}
+
+// False when a flash segment for `address` written at `position` already
+// has its data at the address's offset within an MMU page; otherwise `pad`
+// is the filler segment data that puts it there
+bool NeedsPadding(size_t position, uint32_t address, size_t& pad) {
+    size_t page_offset = address % kMmuPageSize;
+    if ((position + kSegmentHeaderSize) % kMmuPageSize == page_offset) {
+        return false;
+    }
+    pad = (page_offset + 2 * kMmuPageSize - (position + 2 * kSegmentHeaderSize) % kMmuPageSize) % kMmuPageSize;
+    return true;
+}
+
+} // namespace
+
+AppImage::AppImage() : entry_(0) {
+}
+
+bool AppImage::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool AppImage::LoadElf(const std::string& elf_path) {
+    segments_.clear();
+    entry_ = 0;
+    error_.clear();
+
+    utils::MappedFile file;
+    if (!file.Open(elf_path)) {
+        return Fail("Cannot open " + elf_path);
+    }
+    const unsigned char* data = file.Data();
+    size_t size = file.Size();
+    if (size < 52 || std::memcmp(data, "\x7f" "ELF", 4) != 0) {
+        return Fail(elf_path + " is not an ELF file");
+    }
+    bool is64 = data[4] == kElfClass64;
+    if ((data[4] != kElfClass32 && !is64) || data[5] != kElfDataLittle) {
+        return Fail(elf_path + ": only little-endian ELF32/ELF64 is supported");
+    }
+    if (is64 && size < 64) {
+        return Fail(elf_path + ": truncated header");
+    }
+
+    uint64_t entry = is64 ? Read64(data + 24) : Read32(data + 24);
+    uint64_t header_offset = is64 ? Read64(data + 32) : Read32(data + 28);
+    uint16_t entry_size = Read16(data + (is64 ? 54 : 42));
+    uint16_t header_count = Read16(data + (is64 ? 56 : 44));
+    size_t min_entry = is64 ? 56 : 32;
+    if (header_offset == 0 || header_count == 0 || entry_size < min_entry ||
+        header_offset > size || (size - header_offset) / entry_size < header_count) {
+        return Fail(elf_path + ": no program headers");
+    }
+    if (entry > UINT32_MAX) {
+        return Fail(elf_path + ": entry point beyond 32 bits");
+    }
+    entry_ = static_cast<uint32_t>(entry);
+
+    for (uint16_t i = 0; i < header_count; ++i) {
+        const unsigned char* p = data + header_offset + static_cast<size_t>(i) * entry_size;
+        if (Read32(p) != kPtLoad) continue;
+        uint64_t offset = is64 ? Read64(p + 8) : Read32(p + 4);
+        // The load address: where the bootloader copies or maps the bytes
+        uint64_t address = is64 ? Read64(p + 24) : Read32(p + 12);
+        uint64_t file_size = is64 ? Read64(p + 32) : Read32(p + 16);
+        if (file_size == 0) continue;           // .bss-like, zeroed at startup
+        if (offset > size || file_size > size - offset) {
+            return Fail(elf_path + ": segment " + std::to_string(i) + " runs past the end of the file");
+        }
+        if (address + file_size > UINT32_MAX) {
+            return Fail(elf_path + ": segment " + std::to_string(i) + " is beyond the 32-bit address space");
+        }
+        Segment segment;
+        segment.address = static_cast<uint32_t>(address);
+        segment.data.assign(reinterpret_cast<const char*>(data + offset), static_cast<size_t>(file_size));
+        segments_.push_back(std::move(segment));
+    }
+    if (segments_.empty()) {
+        return Fail(elf_path + ": nothing to load");
+    }
+    std::sort(segments_.begin(), segments_.end(), [](const Segment& a, const Segment& b) {
+        return a.address < b.address;
+    });
+    return true;
+}
+
+bool AppImage::Build(const Chip& chip, std::string& image) {
+    auto in_flash = [&chip](uint32_t address) {
+        return (address >= chip.irom_start && address < chip.irom_end) ||
+               (address >= chip.drom_start && address < chip.drom_end);
+    };
+    std::vector<Segment> flash;
+    std::vector<Segment> ram;
+    for (const auto& segment : segments_) {
+        (in_flash(segment.address) ? flash : ram).push_back(segment);
+    }
+    Coalesce(flash);
+    Coalesce(ram);
+    // The MMU maps whole pages, so two flash segments cannot share one
+    for (size_t i = 1; i < flash.size(); ++i) {
+        if (flash[i].address / kMmuPageSize == flash[i - 1].address / kMmuPageSize) {
+            return Fail("Segments at " + Hex32(flash[i - 1].address) + " and " + Hex32(flash[i].address) +
+                        " share a 64 KiB flash page; merge them in the linker script");
+        }
+    }
+
+    image.clear();
+    image.push_back(static_cast<char>(kImageMagic));
+    image.push_back(0);                             // segment count, set below
+    image.push_back(static_cast<char>(kSpiModeDio));
+    image.push_back(static_cast<char>(kSpiSize4MbDefaultSpeed));
+    Put32(image, entry_);
+    image.push_back(static_cast<char>(kWpPinDisabled));
+    image.append(3, '\0');                          // SPI pin drive strengths
+    Put16(image, chip.chip_id);
+    image.push_back(0);                             // min_chip_rev (legacy)
+    Put16(image, 0);                                // min_chip_rev_full
+    Put16(image, 0xFFFF);                           // max_chip_rev_full: any
+    image.append(4, '\0');
+    image.push_back(1);                             // SHA-256 appended
+
+    uint8_t checksum = 0xEF;
+    size_t count = 0;
+    auto put_segment = [&](uint32_t address, const char* bytes, size_t length) {
+        Put32(image, address);
+        Put32(image, static_cast<uint32_t>(length));
+        image.append(bytes, length);
+        for (size_t i = 0; i < length; ++i) {
+            checksum ^= static_cast<uint8_t>(bytes[i]);
+        }
+        count++;
+    };
+
+    size_t ram_next = 0;
+    size_t ram_used = 0;                            // of ram[ram_next], split off as filler
+    for (auto& segment : flash) {
+        size_t pad = 0;
+        while (NeedsPadding(image.size(), segment.address, pad)) {
+            if (pad > 0 && ram_next < ram.size()) {
+                // RAM segments are loaded wherever they sit in the image,
+                // so pieces of them make useful filler
+                const Segment& source = ram[ram_next];
+                size_t take = std::min(pad, source.data.size() - ram_used);
+                put_segment(source.address + static_cast<uint32_t>(ram_used), source.data.data() + ram_used, take);
+                ram_used += take;
+                if (ram_used == source.data.size()) {
+                    ram_next++;
+                    ram_used = 0;
+                }
+            } else {
+                // Load address 0 marks padding the bootloader skips
+                std::string zeros(pad, '\0');
+                put_segment(0, zeros.data(), zeros.size());
+            }
+        }
+        size_t tail = (image.size() + kSegmentHeaderSize + segment.data.size()) % kMmuPageSize;
+        if (tail < kMinPageTail) {
+            segment.data.append(kMinPageTail - tail, '\0');
+        }
+        put_segment(segment.address, segment.data.data(), segment.data.size());
+    }
+    for (; ram_next < ram.size(); ++ram_next, ram_used = 0) {
+        const Segment& source = ram[ram_next];
+        put_segment(source.address + static_cast<uint32_t>(ram_used), source.data.data() + ram_used,
+                    source.data.size() - ram_used);
+    }
+    if (count > kMaxSegments) {
+        return Fail("Image needs " + std::to_string(count) + " segments; the bootloader loads at most " +
+                    std::to_string(kMaxSegments));
+    }
+    image[1] = static_cast<char>(count);
+
+    // The checksum byte ends a 16-byte block; the digest covers everything before it
+    image.append(15 - image.size() % 16, '\0');
+    image.push_back(static_cast<char>(checksum));
+    image += utils::Sha256::Digest(image.data(), image.size());
+    return true;
+}
+
+bool AppImage::Write(const Chip& chip, const std::string& path) {
+    std::string image;
+    if (!Build(chip, image)) {
+        return false;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open() || !(out << image) || !out.flush()) {
+        return Fail("Cannot write " + path);
+    }
+    return true;
+}
+
+} // namespace esp32_ide
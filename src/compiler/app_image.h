@@ -0,0 +1,64 @@
+#ifndef APP_IMAGE_H
+#define APP_IMAGE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief ESP app image made from a linked ELF, as esptool elf2image does
+ *
+ * The ELF's PT_LOAD segments with file contents become image segments at
+ * their load addresses, sorted, with adjacent ones of the same kind
+ * merged. Segments the chip maps from flash through its MMU (IROM/DROM,
+ * see Chip) are executed in place, so each is placed where its offset in
+ * the image equals its address modulo the 64 KiB MMU page; RAM segments,
+ * or zero filler when none is left, fill the gaps. The result has the
+ * esp_image_header_t layout: header and extended header, segments, the
+ * seeded XOR checksum on a 16-byte boundary and the SHA-256 digest the
+ * second-stage bootloader checks.
+ */
+class AppImage {
+public:
+    struct Segment {
+        uint32_t address;
+        std::string data;
+    };
+
+    // What the image header and segment placement depend on
+    struct Chip {
+        uint16_t chip_id;           // esp_chip_id_t
+        uint32_t irom_start;        // flash-mapped instruction window
+        uint32_t irom_end;
+        uint32_t drom_start;        // flash-mapped data window
+        uint32_t drom_end;
+    };
+
+    AppImage();
+
+    // Reads the loadable segments and entry point of a 32- or 64-bit little-endian ELF
+    bool LoadElf(const std::string& elf_path);
+
+    const std::vector<Segment>& GetSegments() const { return segments_; }
+    uint32_t GetEntry() const { return entry_; }
+
+    // The image as the bootloader expects it at the start of an app partition
+    bool Build(const Chip& chip, std::string& image);
+    // Build() into a file, rewritten only when the bytes change
+    bool Write(const Chip& chip, const std::string& path);
+
+    const std::string& GetError() const { return error_; }
+
+private:
+    std::vector<Segment> segments_;
+    uint32_t entry_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+};
+
+} // namespace esp32_ide
+
+#endif // APP_IMAGE_H
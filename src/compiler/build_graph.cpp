@@ -0,0 +1,1072 @@
+#include "compiler/build_graph.h"
+#include "compiler/build_scheduler.h"
+#include "compiler/object_cache.h"
+#include "plugins/plugin_system.h"
+#include "plugins/diagnostic_parser.h"
+#include "utils/mapped_file.h"
+#include "utils/blob_store.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// On-disk layout of a saved graph (native byte order)
+//   [Header][file nodes][targets]
+const char kGraphMagic[4] = {'E', '3', 'B', 'G'};
+const uint32_t kGraphVersion = 2;
+
+struct GraphHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t file_count;
+    uint32_t target_count;
+};
+
+template <typename T>
+void AppendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendString(std::string& out, const std::string& value) {
+    AppendRaw(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+template <typename T>
+bool ReadRaw(const unsigned char*& cursor, const unsigned char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+bool ReadString(const unsigned char*& cursor, const unsigned char* end, std::string& value) {
+    uint32_t length = 0;
+    if (!ReadRaw(cursor, end, length) || static_cast<size_t>(end - cursor) < length) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(cursor), length);
+    cursor += length;
+    return true;
+}
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\f' || c == '\v' || c == '\r';
+}
+
+bool HasExtension(const std::string& path, std::initializer_list<const char*> extensions) {
+    std::string ext = fs::path(path).extension().string();
+    for (const char* candidate : extensions) {
+        if (ext == candidate) return true;
+    }
+    return false;
+}
+
+bool IsTranslationUnit(const std::string& path) {
+    return HasExtension(path, {".c", ".cpp", ".cc", ".cxx", ".S", ".ino"});
+}
+
+// GCC's .gch lookup through -include is what the precompiled header relies on
+bool SupportsPrecompiledHeaders(const plugins::CompilerConfig& compiler) {
+    std::string name = fs::path(compiler.compiler_path).filename().string();
+    return name.find("clang") == std::string::npos &&
+           (name.find("g++") != std::string::npos || name.find("gcc") != std::string::npos);
+}
+
+std::string NormalizePath(const std::string& path) {
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    return (ec ? fs::path(path) : absolute).lexically_normal().string();
+}
+
+std::string HexHash(uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        out[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+} // namespace
+
+// ============================================================================
+// IncludeScanner
+// ============================================================================
+
+std::vector<IncludeDirective> IncludeScanner::Scan(const std::string& content) {
+    return Scan(content.data(), content.size());
+}
+
+std::vector<IncludeDirective> IncludeScanner::Scan(const char* data, size_t size) {
+    std::vector<IncludeDirective> includes;
+    size_t i = 0;
+    bool line_start = true;
+
+    while (i < size) {
+        char c = data[i];
+
+        if (c == '\n') {
+            line_start = true;
+            ++i;
+            continue;
+        }
+        if (IsSpace(c)) {
+            ++i;
+            continue;
+        }
+
+        // Comments may precede a directive on the same line
+        if (c == '/' && i + 1 < size && data[i + 1] == '*') {
+            const char* close = nullptr;
+            for (size_t j = i + 2; j + 1 < size; ++j) {
+                if (data[j] == '*' && data[j + 1] == '/') {
+                    close = data + j;
+                    break;
+                }
+            }
+            if (!close) break;
+            // The comment counts as whitespace, so line_start carries over
+            i = static_cast<size_t>(close - data) + 2;
+            continue;
+        }
+        if (c == '/' && i + 1 < size && data[i + 1] == '/') {
+            while (i < size && data[i] != '\n') ++i;
+            continue;
+        }
+
+        if (c == '#' && line_start) {
+            ++i;
+            while (i < size && IsSpace(data[i])) ++i;
+            static const char kInclude[] = "include";
+            const size_t keyword_length = sizeof(kInclude) - 1;
+            if (size - i >= keyword_length && std::memcmp(data + i, kInclude, keyword_length) == 0) {
+                i += keyword_length;
+                if (size - i >= 5 && std::memcmp(data + i, "_next", 5) == 0) i += 5;
+                while (i < size && IsSpace(data[i])) ++i;
+                if (i < size && (data[i] == '"' || data[i] == '<')) {
+                    char terminator = data[i] == '"' ? '"' : '>';
+                    size_t name_start = ++i;
+                    while (i < size && data[i] != terminator && data[i] != '\n') ++i;
+                    if (i < size && data[i] == terminator && i > name_start) {
+                        includes.push_back({std::string(data + name_start, i - name_start), terminator == '>'});
+                    }
+                }
+            }
+        }
+
+        // Rest of the line cannot start a directive; skip it, minding
+        // string literals and comments that hide a newline or a '#'
+        line_start = false;
+        while (i < size && data[i] != '\n') {
+            char d = data[i];
+            if (d == '"' || d == '\'') {
+                ++i;
+                while (i < size && data[i] != d && data[i] != '\n') {
+                    if (data[i] == '\\' && i + 1 < size) ++i;
+                    ++i;
+                }
+                if (i < size && data[i] == d) ++i;
+                continue;
+            }
+            if (d == '/' && i + 1 < size && (data[i + 1] == '*' || data[i + 1] == '/')) {
+                break;
+            }
+            if (d == '\\' && i + 1 < size && data[i + 1] == '\n') {
+                i += 2;  // line continuation
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    return includes;
+}
+
+// ============================================================================
+// BuildGraph
+// ============================================================================
+
+BuildGraph::BuildGraph() : files_rehashed_(0), dirty_(false) {}
+
+void BuildGraph::Clear() {
+    files_.clear();
+    targets_.clear();
+    refreshed_.clear();
+    resolved_.clear();
+    files_rehashed_ = 0;
+    dirty_ = false;
+}
+
+void BuildGraph::SetIncludePaths(const std::vector<std::string>& paths) {
+    include_paths_.clear();
+    for (const auto& path : paths) {
+        include_paths_.push_back(NormalizePath(path));
+    }
+    resolved_.clear();
+}
+
+void BuildGraph::BeginPass() {
+    refreshed_.clear();
+    resolved_.clear();
+    files_rehashed_ = 0;
+}
+
+const BuildGraph::FileNode* BuildGraph::Refresh(const std::string& path) {
+    auto seen = refreshed_.find(path);
+    if (seen != refreshed_.end()) {
+        if (!seen->second) return nullptr;
+        auto it = files_.find(path);
+        return it != files_.end() ? &it->second : nullptr;
+    }
+
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    int64_t mtime = 0;
+    if (!ec) {
+        mtime = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+    }
+    if (ec) {
+        refreshed_[path] = false;
+        if (files_.erase(path) > 0) dirty_ = true;
+        return nullptr;
+    }
+    refreshed_[path] = true;
+
+    auto it = files_.find(path);
+    if (it != files_.end() && it->second.size == size && it->second.mtime == mtime) {
+        return &it->second;
+    }
+
+    utils::MappedFile file;
+    if (!file.Open(path)) {
+        refreshed_[path] = false;
+        return nullptr;
+    }
+    const char* data = reinterpret_cast<const char*>(file.Data());
+    uint64_t hash = utils::BlobStore::HashContent(data, file.Size());
+    ++files_rehashed_;
+    dirty_ = true;
+
+    FileNode& node = files_[path];
+    bool content_changed = it == files_.end() || node.hash != hash || node.size != file.Size();
+    node.size = file.Size();
+    node.mtime = mtime;
+    node.hash = hash;
+    if (content_changed) {
+        node.includes = IncludeScanner::Scan(data, file.Size());
+    }
+    return &node;
+}
+
+void BuildGraph::ImportPass(const BuildGraph& other) {
+    for (const auto& seen : other.refreshed_) {
+        if (refreshed_.count(seen.first)) continue;
+        refreshed_[seen.first] = seen.second;
+        auto source = other.files_.find(seen.first);
+        if (!seen.second || source == other.files_.end()) {
+            if (files_.erase(seen.first) > 0) dirty_ = true;
+            continue;
+        }
+        FileNode& node = files_[seen.first];
+        if (node.hash != source->second.hash || node.mtime != source->second.mtime ||
+            node.size != source->second.size) {
+            node = source->second;
+            dirty_ = true;
+        }
+    }
+    if (include_paths_ == other.include_paths_) {
+        resolved_.insert(other.resolved_.begin(), other.resolved_.end());
+    }
+}
+
+std::string BuildGraph::ResolveInclude(const IncludeDirective& include, const std::string& from_dir) {
+    std::string key = include.system ? std::string() : from_dir;
+    key.push_back('\0');
+    key += include.name;
+
+    auto cached = resolved_.find(key);
+    if (cached != resolved_.end()) return cached->second;
+
+    std::string resolved;
+    std::error_code ec;
+    auto try_dir = [&](const std::string& dir) {
+        fs::path candidate = fs::path(dir) / include.name;
+        if (fs::is_regular_file(candidate, ec)) {
+            resolved = candidate.lexically_normal().string();
+            return true;
+        }
+        return false;
+    };
+
+    if (fs::path(include.name).is_absolute()) {
+        if (fs::is_regular_file(include.name, ec)) resolved = include.name;
+    } else if (include.system || !try_dir(from_dir)) {
+        for (const auto& dir : include_paths_) {
+            if (try_dir(dir)) break;
+        }
+    }
+
+    // Unresolved names are toolchain/system headers; they are not tracked
+    resolved_[key] = resolved;
+    return resolved;
+}
+
+uint64_t BuildGraph::ComputeSignature(const std::string& source,
+                                      const std::vector<std::string>& command,
+                                      std::vector<std::string>* dependencies) {
+    std::string root = NormalizePath(source);
+    if (!Refresh(root)) return 0;
+
+    // Walk the include graph depth-first; the visit order is a function of
+    // file contents alone, so equal inputs always give equal signatures
+    std::string accumulator;
+    AppendRaw(accumulator, HashCommand(command));
+
+    std::unordered_set<std::string> visited;
+    std::vector<std::string> stack = {root};
+    while (!stack.empty()) {
+        std::string path = std::move(stack.back());
+        stack.pop_back();
+        if (!visited.insert(path).second) continue;
+
+        const FileNode* node = Refresh(path);
+        if (!node) continue;
+
+        AppendString(accumulator, path);
+        AppendRaw(accumulator, node->hash);
+        if (dependencies) dependencies->push_back(path);
+
+        std::string dir = fs::path(path).parent_path().string();
+        std::vector<IncludeDirective> includes = node->includes;
+        for (auto it = includes.rbegin(); it != includes.rend(); ++it) {
+            std::string resolved = ResolveInclude(*it, dir);
+            if (!resolved.empty() && visited.find(resolved) == visited.end()) {
+                stack.push_back(resolved);
+            }
+        }
+    }
+
+    uint64_t signature = utils::BlobStore::HashContent(accumulator.data(), accumulator.size());
+    return signature ? signature : 1;
+}
+
+uint64_t BuildGraph::HashCommand(const std::vector<std::string>& command) {
+    std::string joined;
+    for (const auto& arg : command) {
+        joined += arg;
+        joined.push_back('\0');
+    }
+    return utils::BlobStore::HashContent(joined.data(), joined.size());
+}
+
+uint64_t BuildGraph::GetTargetSignature(const std::string& target) const {
+    auto it = targets_.find(target);
+    return it != targets_.end() ? it->second.signature : 0;
+}
+
+void BuildGraph::SetTargetSignature(const std::string& target, uint64_t signature) {
+    auto it = targets_.find(target);
+    if (it == targets_.end()) {
+        targets_[target] = TargetRecord{signature, 0};
+        dirty_ = true;
+    } else if (it->second.signature != signature) {
+        it->second.signature = signature;
+        dirty_ = true;
+    }
+}
+
+void BuildGraph::ForgetTarget(const std::string& target) {
+    auto it = targets_.find(target);
+    if (it != targets_.end() && it->second.signature != 0) {
+        // The duration stays useful for scheduling the retry
+        it->second.signature = 0;
+        dirty_ = true;
+    }
+}
+
+uint32_t BuildGraph::GetTargetDuration(const std::string& target) const {
+    auto it = targets_.find(target);
+    return it != targets_.end() ? it->second.duration_ms : 0;
+}
+
+void BuildGraph::SetTargetDuration(const std::string& target, uint32_t milliseconds) {
+    TargetRecord& record = targets_.emplace(target, TargetRecord{0, 0}).first->second;
+    if (record.duration_ms != milliseconds) {
+        record.duration_ms = milliseconds;
+        dirty_ = true;
+    }
+}
+
+bool BuildGraph::Save(const std::string& path) {
+    std::string body;
+    for (const auto& pair : files_) {
+        const FileNode& node = pair.second;
+        AppendString(body, pair.first);
+        AppendRaw(body, node.size);
+        AppendRaw(body, node.mtime);
+        AppendRaw(body, node.hash);
+        AppendRaw(body, static_cast<uint32_t>(node.includes.size()));
+        for (const auto& include : node.includes) {
+            AppendRaw(body, static_cast<uint8_t>(include.system ? 1 : 0));
+            AppendString(body, include.name);
+        }
+    }
+    for (const auto& pair : targets_) {
+        AppendString(body, pair.first);
+        AppendRaw(body, pair.second.signature);
+        AppendRaw(body, pair.second.duration_ms);
+    }
+
+    GraphHeader header;
+    std::memcpy(header.magic, kGraphMagic, sizeof(header.magic));
+    header.version = kGraphVersion;
+    header.file_count = static_cast<uint32_t>(files_.size());
+    header.target_count = static_cast<uint32_t>(targets_.size());
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out.good()) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool BuildGraph::Load(const std::string& path) {
+    Clear();
+
+    utils::MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    const unsigned char* cursor = file.Data();
+    const unsigned char* end = cursor + file.Size();
+
+    GraphHeader header;
+    if (!cursor || !ReadRaw(cursor, end, header) ||
+        std::memcmp(header.magic, kGraphMagic, sizeof(header.magic)) != 0 ||
+        header.version != kGraphVersion) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.file_count; ++i) {
+        std::string file_path;
+        FileNode node;
+        uint32_t include_count = 0;
+        if (!ReadString(cursor, end, file_path) || !ReadRaw(cursor, end, node.size) ||
+            !ReadRaw(cursor, end, node.mtime) || !ReadRaw(cursor, end, node.hash) ||
+            !ReadRaw(cursor, end, include_count)) {
+            Clear();
+            return false;
+        }
+        node.includes.reserve(include_count);
+        for (uint32_t j = 0; j < include_count; ++j) {
+            uint8_t system = 0;
+            IncludeDirective include;
+            if (!ReadRaw(cursor, end, system) || !ReadString(cursor, end, include.name)) {
+                Clear();
+                return false;
+            }
+            include.system = system != 0;
+            node.includes.push_back(std::move(include));
+        }
+        files_.emplace(std::move(file_path), std::move(node));
+    }
+
+    for (uint32_t i = 0; i < header.target_count; ++i) {
+        std::string target;
+        TargetRecord record;
+        if (!ReadString(cursor, end, target) || !ReadRaw(cursor, end, record.signature) ||
+            !ReadRaw(cursor, end, record.duration_ms)) {
+            Clear();
+            return false;
+        }
+        targets_[target] = record;
+    }
+    return true;
+}
+
+// ============================================================================
+// BuildEngine
+// ============================================================================
+
+BuildEngine::BuildEngine(plugins::CustomCompilerManager& compilers)
+    : compilers_(compilers), object_cache_(nullptr), shared_scan_(nullptr) {
+}
+
+BuildEngine::~BuildEngine() {
+    if (graph_.IsDirty() && !loaded_graph_path_.empty()) {
+        graph_.Save(loaded_graph_path_);
+    }
+}
+
+void BuildEngine::SetConfig(const BuildConfig& config) {
+    config_ = config;
+    if (config_.output_name.empty()) {
+        config_.output_name = "firmware.elf";
+    }
+    graph_.SetIncludePaths(config_.include_paths);
+}
+
+void BuildEngine::Output(const std::string& message, bool is_error) {
+    if (output_callback_) {
+        output_callback_(message, is_error);
+    }
+}
+
+std::string BuildEngine::GetGraphPath() const {
+    return (fs::path(config_.build_dir) / "build_graph.bin").string();
+}
+
+std::vector<std::string> BuildEngine::CollectSources() const {
+    std::vector<std::string> sources;
+    for (const auto& source : config_.sources) {
+        sources.push_back(NormalizePath(source));
+    }
+
+    std::string build_dir = NormalizePath(config_.build_dir);
+    for (const auto& dir : config_.source_dirs) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec);
+        fs::recursive_directory_iterator end;
+        for (; !ec && it != end; it.increment(ec)) {
+            const fs::path& path = it->path();
+            std::string name = path.filename().string();
+            if (it->is_directory(ec)) {
+                // Hidden trees hold IDE state and VCS data; never descend
+                // into our own output either
+                if ((!name.empty() && name[0] == '.') || NormalizePath(path.string()) == build_dir) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            // Sketch files are merged by the caller, not compiled one by one
+            if (it->is_regular_file(ec) && IsTranslationUnit(name) && !HasExtension(name, {".ino"})) {
+                sources.push_back(NormalizePath(path.string()));
+            }
+        }
+    }
+
+    std::sort(sources.begin(), sources.end());
+    sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+    return sources;
+}
+
+std::string BuildEngine::GetObjectPath(const std::string& source) const {
+    std::string extension = compilers_.GetCompilerConfig(config_.compiler_id).output_extension;
+    if (extension.empty()) extension = ".o";
+
+    // Mirror the source tree for files under a source directory so object
+    // names stay readable; anything else is keyed by its full path
+    fs::path normalized(NormalizePath(source));
+    for (const auto& dir : config_.source_dirs) {
+        std::string root = NormalizePath(dir);
+        fs::path relative = normalized.lexically_relative(root);
+        if (!relative.empty() && *relative.begin() != "..") {
+            std::string tree = HexHash(utils::BlobStore::HashContent(root.data(), root.size())).substr(0, 8);
+            return (fs::path(config_.build_dir) / "obj" / tree / relative).string() + extension;
+        }
+    }
+    std::string key = normalized.string();
+    std::string prefix = HexHash(utils::BlobStore::HashContent(key.data(), key.size())).substr(0, 8);
+    return (fs::path(config_.build_dir) / "obj" / prefix / normalized.filename()).string() + extension;
+}
+
+std::vector<std::string> BuildEngine::GetUnitFlags(const std::string& source) const {
+    std::vector<std::string> flags;
+    if (HasExtension(source, {".ino"})) {
+        flags.push_back("-x");
+        flags.push_back("c++");
+    }
+    flags.insert(flags.end(), config_.flags.begin(), config_.flags.end());
+    std::istringstream board_flags(config_.board_flags);
+    std::string flag;
+    while (board_flags >> flag) {
+        flags.push_back(flag);
+    }
+    for (const auto& dir : config_.include_paths) {
+        flags.push_back("-I" + dir);
+    }
+    return flags;
+}
+
+bool BuildEngine::PlanPrecompiledHeader(PchPlan& plan) {
+    if (config_.precompiled_header.empty() ||
+        !SupportsPrecompiledHeaders(compilers_.GetCompilerConfig(config_.compiler_id))) {
+        return false;
+    }
+
+    std::error_code ec;
+    plan.header.clear();
+    if (fs::path(config_.precompiled_header).is_absolute()) {
+        if (fs::is_regular_file(config_.precompiled_header, ec)) {
+            plan.header = NormalizePath(config_.precompiled_header);
+        }
+    } else {
+        for (const auto& dir : config_.include_paths) {
+            fs::path candidate = fs::path(dir) / config_.precompiled_header;
+            if (fs::is_regular_file(candidate, ec)) {
+                plan.header = NormalizePath(candidate.string());
+                break;
+            }
+        }
+    }
+    if (plan.header.empty()) {
+        return false;
+    }
+
+    // Keyed like a unit: the command line plus every file reachable from
+    // the header, so flag, board, core or header changes make a new one
+    plan.flags = GetUnitFlags(plan.header);
+    plan.flags.insert(plan.flags.begin(), {"-x", "c++-header"});
+    std::vector<std::string> command = compilers_.GetCompileCommand(config_.compiler_id, plan.header, "-", plan.flags);
+    command.push_back("core=" + config_.core_version);
+    plan.signature = graph_.ComputeSignature(plan.header, command);
+    if (plan.signature == 0) {
+        return false;
+    }
+    const BuildGraph::FileNode* header = graph_.Refresh(plan.header);
+    plan.header_hash = header ? header->hash : 0;
+
+    fs::path dir = fs::path(config_.build_dir) / "pch" / HexHash(plan.signature);
+    plan.stub = (dir / fs::path(plan.header).filename()).string();
+    plan.output = plan.stub + ".gch";
+    plan.needs_build = graph_.GetTargetSignature(plan.output) != plan.signature || !fs::exists(plan.output, ec);
+    if (plan.needs_build) {
+        // Earlier keys are never used again
+        for (fs::directory_iterator it(dir.parent_path(), ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->path() != dir) {
+                std::error_code remove_ec;
+                fs::remove_all(it->path(), remove_ec);
+            }
+        }
+        fs::create_directories(dir, ec);
+        std::ofstream stub(plan.stub, std::ios::binary | std::ios::trunc);
+        stub << "#include \"" << plan.header << "\"\n";
+        if (!stub.good()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BuildEngine::UsesPrecompiledHeader(const std::string& source, const PchPlan& plan) {
+    if (!HasExtension(source, {".cpp", ".cc", ".cxx", ".ino"})) {
+        return false;
+    }
+    const BuildGraph::FileNode* node = graph_.Refresh(NormalizePath(source));
+    if (!node) {
+        return false;
+    }
+    std::string name = fs::path(plan.header).filename().string();
+    for (const auto& include : node->includes) {
+        if (include.name == config_.precompiled_header || include.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string BuildEngine::ComputeCacheKey(const std::string& source, const std::vector<std::string>& flags,
+                                         const PchPlan* pch) {
+    // The stub lives under build_dir and would put that path in the text;
+    // the header it wraps gives the same text in every build directory
+    std::vector<std::string> unit_flags = flags;
+    if (pch) {
+        std::replace(unit_flags.begin(), unit_flags.end(), pch->stub, pch->header);
+    }
+    auto preprocessed = compilers_.Preprocess(config_.compiler_id, source, unit_flags);
+    if (preprocessed.exit_code != 0) {
+        // Let the real compile report the problem
+        return std::string();
+    }
+    // The key covers everything on the command line except where the
+    // source lives and where the object goes
+    plugins::CompilerConfig compiler = compilers_.GetCompilerConfig(config_.compiler_id);
+    std::vector<std::string> key_flags = compiler.default_flags;
+    key_flags.insert(key_flags.end(), unit_flags.begin(), unit_flags.end());
+    std::error_code ec;
+    if (pch && fs::exists(pch->output, ec)) {
+        // Objects built against the .gch are kept apart from plain ones
+        key_flags.push_back("pch=" + HexHash(pch->header_hash));
+    }
+    for (const auto& define : compiler.defines) {
+        key_flags.push_back("-D" + define.first + "=" + define.second);
+    }
+    return object_cache_->ComputeKey(preprocessed.stdout_output, compiler.compiler_path,
+                                     key_flags, config_.board_flags);
+}
+
+void BuildEngine::ReportDiagnostic(const plugins::AnalysisResult& diagnostic) {
+    if (!diagnostic_callback_) return;
+    std::lock_guard<std::mutex> lock(diagnostic_mutex_);
+    diagnostic_callback_(diagnostic);
+}
+
+void BuildEngine::CollectDiagnostics(const std::string& output,
+                                     const std::vector<plugins::AnalysisResult>& diagnostics,
+                                     BuildResult& result) {
+    result.log += output;
+    result.diagnostics.insert(result.diagnostics.end(), diagnostics.begin(), diagnostics.end());
+}
+
+uint64_t BuildEngine::EstimateCost(const std::string& source, const std::vector<std::string>& dependencies) {
+    // Roughly one millisecond of compile time per 4 KiB of input, so
+    // estimates are comparable with durations recorded by earlier builds
+    uint64_t bytes = 0;
+    for (const auto& path : dependencies) {
+        const BuildGraph::FileNode* node = graph_.Refresh(path);
+        if (node) bytes += node->size;
+    }
+    if (dependencies.empty()) {
+        const BuildGraph::FileNode* node = graph_.Refresh(NormalizePath(source));
+        if (node) bytes = node->size;
+    }
+    return bytes / 4096 + 1;
+}
+
+BuildEngine::BuildResult BuildEngine::Build() {
+    auto start = std::chrono::steady_clock::now();
+    BuildResult result;
+    result.success = false;
+    result.units_total = 0;
+    result.units_compiled = 0;
+    result.units_failed = 0;
+    result.linked = false;
+    result.peak_parallelism = 0;
+    result.cache_hits = 0;
+    result.cache_misses = 0;
+    result.pch_built = false;
+    result.pch_units = 0;
+    result.elapsed_ms = 0;
+
+    auto finish = [&]() {
+        if (graph_.IsDirty()) {
+            graph_.Save(GetGraphPath());
+        }
+        result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return result;
+    };
+
+    if (!compilers_.CompilerExists(config_.compiler_id)) {
+        result.error_message = "Compiler not found: " + config_.compiler_id;
+        return result;
+    }
+    if (config_.build_dir.empty()) {
+        result.error_message = "No build directory configured";
+        return result;
+    }
+
+    std::error_code ec;
+    fs::create_directories(config_.build_dir, ec);
+    if (ec) {
+        result.error_message = "Cannot create " + config_.build_dir + ": " + ec.message();
+        return result;
+    }
+
+    std::string graph_path = GetGraphPath();
+    if (loaded_graph_path_ != graph_path) {
+        if (graph_.IsDirty() && !loaded_graph_path_.empty()) {
+            graph_.Save(loaded_graph_path_);
+        }
+        graph_.Load(graph_path);
+        graph_.SetIncludePaths(config_.include_paths);
+        loaded_graph_path_ = graph_path;
+    }
+    graph_.BeginPass();
+    if (shared_scan_) {
+        graph_.ImportPass(*shared_scan_->files);
+    }
+
+    std::vector<std::string> sources = shared_scan_ ? shared_scan_->sources : CollectSources();
+    result.units_total = sources.size();
+    if (sources.empty()) {
+        result.error_message = "No source files to build";
+        return finish();
+    }
+
+    // Out-of-date units are decided up front on this thread; the graph is
+    // not touched again until every job has finished
+    struct UnitJob {
+        std::string source;
+        std::string object;
+        std::vector<std::string> flags;
+        uint64_t signature;
+        uint64_t cost;
+        plugins::ToolExecutionResult compile;
+        std::vector<plugins::AnalysisResult> diagnostics;
+        uint32_t duration_ms;
+        bool cache_hit;
+        bool uses_pch;
+    };
+    std::vector<UnitJob> units;
+    std::vector<std::string> objects;
+    objects.reserve(sources.size());
+
+    PchPlan pch;
+    bool use_pch = PlanPrecompiledHeader(pch);
+    bool pch_needed = false;
+
+    for (const auto& source : sources) {
+        std::string object = GetObjectPath(source);
+        objects.push_back(object);
+
+        std::vector<std::string> flags = GetUnitFlags(source);
+        bool uses_pch = use_pch && UsesPrecompiledHeader(source, pch);
+        if (uses_pch) {
+            // -Winvalid-pch reports a .gch that could not be used
+            flags.insert(flags.begin(), {"-include", pch.stub, "-Winvalid-pch"});
+            result.pch_units++;
+            pch_needed = true;
+        }
+        std::vector<std::string> command = compilers_.GetCompileCommand(config_.compiler_id, source, object, flags);
+        std::vector<std::string> dependencies;
+        uint64_t signature = graph_.ComputeSignature(source, command, &dependencies);
+        if (signature == 0) {
+            result.units_failed++;
+            result.error_message = "Missing source file: " + source;
+            Output(result.error_message, true);
+            continue;
+        }
+        if (signature == graph_.GetTargetSignature(object) && fs::exists(object, ec)) {
+            continue;
+        }
+
+        uint32_t recorded = graph_.GetTargetDuration(object);
+        UnitJob unit;
+        unit.source = source;
+        unit.object = object;
+        unit.flags = std::move(flags);
+        unit.signature = signature;
+        unit.cost = recorded ? recorded : EstimateCost(source, dependencies);
+        unit.compile.exit_code = -1;
+        unit.duration_ms = 0;
+        unit.cache_hit = false;
+        unit.uses_pch = uses_pch;
+        units.push_back(std::move(unit));
+    }
+    if (result.units_failed > 0) {
+        return finish();
+    }
+
+    result.output_file = (fs::path(config_.build_dir) / config_.output_name).string();
+    std::vector<std::string> link_command =
+        compilers_.GetLinkCommand(config_.compiler_id, objects, result.output_file, config_.libraries,
+                                  config_.link_flags);
+    uint64_t link_signature = BuildGraph::HashCommand(link_command);
+    bool needs_link = !units.empty() || link_signature != graph_.GetTargetSignature(result.output_file) ||
+                      !fs::exists(result.output_file, ec);
+
+    BuildScheduler scheduler(config_.jobs);
+    scheduler.SetMemoryBudget(config_.memory_budget_mb);
+    scheduler.SetOutputCallback([this](const std::string& line, bool is_error) {
+        Output(line, is_error || line.find("error") != std::string::npos);
+    });
+
+    const size_t kCompileMemoryMB = 300;
+    const size_t kLinkMemoryMB = 600;
+
+    // Units wait for the precompiled header; one that failed to build is
+    // removed and the units include the header as text instead
+    std::vector<BuildScheduler::JobId> pch_jobs;
+    bool pch_ok = false;
+    uint32_t pch_duration = 0;
+    if (pch_needed && pch.needs_build && !units.empty()) {
+        pch_jobs.push_back(scheduler.AddJob(
+            fs::path(pch.output).filename().string(),
+            [&](std::string& output) {
+                scheduler.Emit("Precompiling " + fs::path(pch.header).filename().string());
+                auto begin = std::chrono::steady_clock::now();
+                auto compile = compilers_.Compile(config_.compiler_id, pch.stub, pch.output, pch.flags);
+                pch_duration = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                pch_ok = compile.exit_code == 0;
+                if (!pch_ok) {
+                    std::error_code remove_ec;
+                    fs::remove(pch.output, remove_ec);
+                    output = "Precompiled header failed, compiling without it\n" + compile.stderr_output;
+                }
+                return true;
+            },
+            {}, graph_.GetTargetDuration(pch.output) ? graph_.GetTargetDuration(pch.output) : 1, kCompileMemoryMB));
+    }
+
+    std::vector<BuildScheduler::JobId> compile_jobs;
+    compile_jobs.reserve(units.size());
+    for (auto& unit : units) {
+        UnitJob* job = &unit;
+        compile_jobs.push_back(scheduler.AddJob(
+            fs::path(unit.source).filename().string(),
+            [this, job, &scheduler, &pch](std::string& output) {
+                std::error_code dir_ec;
+                fs::create_directories(fs::path(job->object).parent_path(), dir_ec);
+
+                std::string key;
+                if (object_cache_) {
+                    key = ComputeCacheKey(job->source, job->flags, job->uses_pch ? &pch : nullptr);
+                    std::string cached_output;
+                    if (!key.empty() && object_cache_->Fetch(key, job->object, cached_output)) {
+                        scheduler.Emit("Cached " + fs::path(job->source).filename().string());
+                        job->cache_hit = true;
+                        job->compile.exit_code = 0;
+                        job->compile.stderr_output = cached_output;
+                        job->diagnostics = plugins::DiagnosticParser::ParseAll(cached_output);
+                        for (const auto& diagnostic : job->diagnostics) {
+                            ReportDiagnostic(diagnostic);
+                        }
+                        output = cached_output;
+                        return true;
+                    }
+                }
+
+                scheduler.Emit("Compiling " + fs::path(job->source).filename().string());
+                auto begin = std::chrono::steady_clock::now();
+                job->compile = compilers_.Compile(config_.compiler_id, job->source, job->object, job->flags,
+                    [this, job](const plugins::AnalysisResult& diagnostic) {
+                        job->diagnostics.push_back(diagnostic);
+                        ReportDiagnostic(diagnostic);
+                    });
+                job->duration_ms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                output = job->compile.stdout_output + job->compile.stderr_output;
+                if (!job->compile.error_message.empty()) {
+                    output += job->compile.error_message + "\n";
+                }
+                if (job->compile.exit_code != 0) {
+                    return false;
+                }
+                if (!key.empty()) {
+                    object_cache_->Store(key, job->object, output);
+                }
+                return true;
+            },
+            pch_jobs, unit.cost, kCompileMemoryMB));
+    }
+
+    plugins::ToolExecutionResult link;
+    std::vector<plugins::AnalysisResult> link_diagnostics;
+    uint32_t link_duration = 0;
+    BuildScheduler::JobId link_job = 0;
+    if (needs_link) {
+        uint32_t recorded = graph_.GetTargetDuration(result.output_file);
+        link_job = scheduler.AddJob(
+            config_.output_name,
+            [&](std::string& output) {
+                scheduler.Emit("Linking " + config_.output_name);
+                auto begin = std::chrono::steady_clock::now();
+                link = compilers_.Link(config_.compiler_id, objects, result.output_file, config_.libraries,
+                    config_.link_flags,
+                    [&](const plugins::AnalysisResult& diagnostic) {
+                        link_diagnostics.push_back(diagnostic);
+                        ReportDiagnostic(diagnostic);
+                    });
+                link_duration = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - begin).count());
+                output = link.stdout_output + link.stderr_output;
+                if (link.exit_code != 0) {
+                    output += (link.error_message.empty() ? "Link failed" : link.error_message) + "\n";
+                }
+                return link.exit_code == 0;
+            },
+            compile_jobs, recorded ? recorded : 1, kLinkMemoryMB);
+    }
+
+    scheduler.Run();
+    result.peak_parallelism = scheduler.GetStats().peak_parallelism;
+
+    if (!pch_jobs.empty()) {
+        result.pch_built = pch_ok;
+        if (pch_ok) {
+            graph_.SetTargetSignature(pch.output, pch.signature);
+            graph_.SetTargetDuration(pch.output, pch_duration);
+        } else {
+            graph_.ForgetTarget(pch.output);
+        }
+    }
+
+    // Record outcomes in source order so diagnostics are deterministic
+    for (size_t i = 0; i < units.size(); ++i) {
+        UnitJob& unit = units[i];
+        CollectDiagnostics(unit.compile.stdout_output + unit.compile.stderr_output, unit.diagnostics, result);
+        if (object_cache_) {
+            (unit.cache_hit ? result.cache_hits : result.cache_misses)++;
+        }
+        // A cache hit says nothing about how long a real compile takes
+        if (!unit.cache_hit) {
+            graph_.SetTargetDuration(unit.object, unit.duration_ms);
+        }
+        if (scheduler.GetJobState(compile_jobs[i]) == BuildScheduler::JobState::SUCCEEDED) {
+            result.units_compiled++;
+            graph_.SetTargetSignature(unit.object, unit.signature);
+        } else {
+            // A failed unit must rebuild next time even if nothing changes
+            result.units_failed++;
+            graph_.ForgetTarget(unit.object);
+            if (!unit.compile.error_message.empty()) {
+                result.error_message = unit.compile.error_message;
+            }
+        }
+    }
+    if (result.units_failed > 0) {
+        return finish();
+    }
+
+    if (needs_link) {
+        CollectDiagnostics(link.stdout_output + link.stderr_output, link_diagnostics, result);
+        if (scheduler.GetJobState(link_job) != BuildScheduler::JobState::SUCCEEDED) {
+            graph_.ForgetTarget(result.output_file);
+            result.error_message = link.error_message.empty() ? "Link failed" : link.error_message;
+            return finish();
+        }
+        result.linked = true;
+        graph_.SetTargetSignature(result.output_file, link_signature);
+        graph_.SetTargetDuration(result.output_file, link_duration);
+    }
+
+    result.success = true;
+    return finish();
+}
+
+bool BuildEngine::Clean() {
+    std::error_code ec;
+    fs::remove_all(fs::path(config_.build_dir) / "obj", ec);
+    bool ok = !ec;
+    fs::remove_all(fs::path(config_.build_dir) / "pch", ec);
+    ok = ok && !ec;
+    fs::remove(fs::path(config_.build_dir) / config_.output_name, ec);
+    ok = ok && !ec;
+    fs::remove(GetGraphPath(), ec);
+    graph_.Clear();
+    loaded_graph_path_.clear();
+    return ok && !ec;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,274 @@
+#ifndef BUILD_GRAPH_H
+#define BUILD_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace esp32_ide {
+
+namespace plugins {
+class CustomCompilerManager;
+struct AnalysisResult;
+}
+
+class ObjectCache;
+
+/**
+ * @brief One #include directive found in a source file
+ */
+struct IncludeDirective {
+    std::string name;
+    bool system;  // <...> rather than "..."
+};
+
+/**
+ * @brief Fast #include scanner
+ *
+ * Reads directives straight from the text without running the
+ * preprocessor; comments are skipped, conditionals are not evaluated, so
+ * the result is a superset of what the compiler would open. Good enough
+ * for dependency tracking, where an extra edge only costs a recompile.
+ */
+class IncludeScanner {
+public:
+    static std::vector<IncludeDirective> Scan(const char* data, size_t size);
+    static std::vector<IncludeDirective> Scan(const std::string& content);
+};
+
+/**
+ * @brief Persistent file dependency graph with content hashes
+ *
+ * Every source and header seen by a build is a node holding its size,
+ * modification time, content hash and #include directives. A node is
+ * re-read only when its size or mtime changed, and a changed mtime with
+ * identical content keeps the old hash, so touching a file (or a checkout
+ * that rewrites it unchanged) does not trigger recompiles.
+ *
+ * Targets record the signature of the inputs they were last built from:
+ * the command line plus the hashes of every file reachable through
+ * resolved includes. A target is out of date when its signature differs.
+ * The last build duration is kept alongside to order the next build.
+ */
+class BuildGraph {
+public:
+    struct FileNode {
+        uint64_t size;
+        int64_t mtime;
+        uint64_t hash;
+        std::vector<IncludeDirective> includes;
+    };
+
+    BuildGraph();
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path);
+    void Clear();
+    bool IsDirty() const { return dirty_; }
+
+    // Directories searched for includes after the including file's own
+    void SetIncludePaths(const std::vector<std::string>& paths);
+
+    // Starts a new build pass; files are stat'ed at most once per pass
+    void BeginPass();
+
+    // Brings a node up to date with the disk; nullptr if the file is missing
+    const FileNode* Refresh(const std::string& path);
+
+    /**
+     * @brief Takes over the files another graph refreshed in its current pass
+     *
+     * Their nodes count as refreshed for this pass, so they are neither
+     * stat'ed nor re-read; include resolutions are shared too when both
+     * graphs search the same include paths.
+     */
+    void ImportPass(const BuildGraph& other);
+
+    /**
+     * @brief Hash of a translation unit's transitive inputs
+     *
+     * @param command Compiler command line; flag changes force a rebuild
+     * @param dependencies If set, receives every file the unit depends on
+     * @return 0 if the source file is missing
+     */
+    uint64_t ComputeSignature(const std::string& source,
+                              const std::vector<std::string>& command,
+                              std::vector<std::string>* dependencies = nullptr);
+
+    // Signature a target was last built from (0 if never built)
+    uint64_t GetTargetSignature(const std::string& target) const;
+    void SetTargetSignature(const std::string& target, uint64_t signature);
+    void ForgetTarget(const std::string& target);
+
+    // How long the target took to build last time; drives scheduling
+    uint32_t GetTargetDuration(const std::string& target) const;
+    void SetTargetDuration(const std::string& target, uint32_t milliseconds);
+
+    size_t GetFileCount() const { return files_.size(); }
+    size_t GetTargetCount() const { return targets_.size(); }
+    // Files whose content had to be re-read during the current pass
+    size_t GetFilesRehashed() const { return files_rehashed_; }
+
+    static uint64_t HashCommand(const std::vector<std::string>& command);
+
+private:
+    struct TargetRecord {
+        uint64_t signature;
+        uint32_t duration_ms;
+    };
+
+    std::unordered_map<std::string, FileNode> files_;
+    std::map<std::string, TargetRecord> targets_;
+    std::vector<std::string> include_paths_;
+    std::unordered_map<std::string, bool> refreshed_;          // path -> exists, this pass
+    std::unordered_map<std::string, std::string> resolved_;    // dir + name -> path, this pass
+    size_t files_rehashed_;
+    bool dirty_;
+
+    std::string ResolveInclude(const IncludeDirective& include, const std::string& from_dir);
+};
+
+/**
+ * @brief Incremental compile/link driver on top of CustomCompilerManager
+ *
+ * Collects translation units from explicit sources and source trees,
+ * recompiles only those whose signature changed since the last successful
+ * build and relinks when any object (or the link command) changed. The
+ * graph is kept in the build directory, so a fresh process resumes
+ * incrementally.
+ *
+ * Out-of-date units and the link run as a DAG on BuildScheduler, ordered
+ * by how long each unit took last time. With an ObjectCache attached, a
+ * unit whose preprocessed input was compiled before (by any project) is
+ * copied from the cache instead.
+ *
+ * With a precompiled_header set and a GCC toolchain, C++ units that
+ * include that header get it force-included from a .gch built once per
+ * key: the header command line (board flags and extra flags included),
+ * the core version and the hashes of everything the header includes. The
+ * .gch lives in build_dir/pch/<key>/ and is rebuilt as a job the units
+ * wait for; if it cannot be built the units compile without it.
+ */
+class BuildEngine {
+public:
+    struct BuildConfig {
+        std::string build_dir;
+        std::string compiler_id;
+        std::vector<std::string> sources;          // explicit translation units
+        std::vector<std::string> source_dirs;      // trees scanned for .c/.cpp/.cc/.S files
+        std::vector<std::string> include_paths;
+        std::vector<std::string> flags;            // extra compile flags
+        std::string board_flags;                   // MultiBoardSupport::GetCompilerFlags()
+        std::vector<std::string> libraries;
+        std::vector<std::string> link_flags;       // e.g. -Wl,-Map=...
+        std::string output_name;                   // linked image, relative to build_dir
+        std::string precompiled_header;            // e.g. "Arduino.h", found on include_paths; empty = none
+        std::string core_version;                  // part of the precompiled header's key
+        size_t jobs;                               // parallel jobs, 0 = one per core
+        size_t memory_budget_mb;                   // 0 = memory available at start
+    };
+
+    /**
+     * @brief Board-independent work done once for several engines
+     *
+     * Holds the translation units of a config and a graph whose current
+     * pass has refreshed every file they include. An engine given a scan
+     * skips walking the source trees and re-reading those files, so N
+     * boards pay for dependency scanning once. Must not change while an
+     * engine using it builds.
+     */
+    struct SharedScan {
+        std::vector<std::string> sources;
+        const BuildGraph* files;
+    };
+
+    struct BuildResult {
+        bool success;
+        size_t units_total;
+        size_t units_compiled;
+        size_t units_failed;
+        bool linked;
+        std::string output_file;
+        std::vector<plugins::AnalysisResult> diagnostics;
+        std::string log;                // raw toolchain output
+        std::string error_message;      // set when the build could not run at all
+        size_t peak_parallelism;
+        size_t cache_hits;
+        size_t cache_misses;
+        bool pch_built;                 // the precompiled header was (re)generated
+        size_t pch_units;               // units compiled against it
+        long long elapsed_ms;
+    };
+
+    using OutputCallback = std::function<void(const std::string& message, bool is_error)>;
+    // Called from build threads as each diagnostic is parsed, one at a time
+    using DiagnosticCallback = std::function<void(const plugins::AnalysisResult& diagnostic)>;
+
+    explicit BuildEngine(plugins::CustomCompilerManager& compilers);
+    ~BuildEngine();
+
+    void SetConfig(const BuildConfig& config);
+    const BuildConfig& GetConfig() const { return config_; }
+    void SetOutputCallback(OutputCallback callback) { output_callback_ = callback; }
+    void SetDiagnosticCallback(DiagnosticCallback callback) { diagnostic_callback_ = callback; }
+    // Shared, not owned; nullptr compiles every unit
+    void SetObjectCache(ObjectCache* cache) { object_cache_ = cache; }
+    // Shared, not owned; nullptr scans the sources itself
+    void SetSharedScan(const SharedScan* scan) { shared_scan_ = scan; }
+
+    BuildResult Build();
+    // Removes objects, the linked image and the saved graph
+    bool Clean();
+
+    // Translation units the current config would compile, sorted
+    std::vector<std::string> CollectSources() const;
+    std::string GetObjectPath(const std::string& source) const;
+    std::string GetGraphPath() const;
+
+    BuildGraph& GetGraph() { return graph_; }
+
+private:
+    plugins::CustomCompilerManager& compilers_;
+    BuildConfig config_;
+    BuildGraph graph_;
+    std::string loaded_graph_path_;
+    OutputCallback output_callback_;
+    DiagnosticCallback diagnostic_callback_;
+    std::mutex diagnostic_mutex_;
+    ObjectCache* object_cache_;
+    const SharedScan* shared_scan_;
+
+    void Output(const std::string& message, bool is_error);
+    void ReportDiagnostic(const plugins::AnalysisResult& diagnostic);
+    void CollectDiagnostics(const std::string& output,
+                            const std::vector<plugins::AnalysisResult>& diagnostics,
+                            BuildResult& result);
+    // Estimated compile cost when a unit has no recorded duration
+    uint64_t EstimateCost(const std::string& source, const std::vector<std::string>& dependencies);
+    std::vector<std::string> GetUnitFlags(const std::string& source) const;
+
+    struct PchPlan {
+        std::string header;             // the real header
+        std::string stub;               // force-included; includes the header
+        std::string output;             // stub + ".gch"
+        std::vector<std::string> flags;
+        uint64_t signature;
+        uint64_t header_hash;           // content of the real header
+        bool needs_build;
+    };
+    // False when no precompiled header applies to this config
+    bool PlanPrecompiledHeader(PchPlan& plan);
+    bool UsesPrecompiledHeader(const std::string& source, const PchPlan& plan);
+    // Empty when the unit cannot be preprocessed; pch is the precompiled
+    // header the unit is compiled against, if any
+    std::string ComputeCacheKey(const std::string& source, const std::vector<std::string>& flags,
+                                const PchPlan* pch);
+};
+
+} // namespace esp32_ide
+
+#endif // BUILD_GRAPH_H
@@ -0,0 +1,189 @@
+#include "compiler/build_matrix.h"
+#include "compiler/build_scheduler.h"
+#include "compiler/elf_size_analyzer.h"
+#include "platform/platform_expansion.h"
+#include "plugins/plugin_system.h"
+#include "utils/string_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::vector<std::string> SplitFlags(const std::string& flags) {
+    std::vector<std::string> result;
+    std::istringstream in(flags);
+    std::string flag;
+    while (in >> flag) {
+        result.push_back(flag);
+    }
+    return result;
+}
+
+} // namespace
+
+BuildMatrix::BuildMatrix(plugins::CustomCompilerManager& compilers)
+    : compilers_(compilers), max_concurrent_(0), object_cache_(nullptr) {
+    base_.jobs = 0;
+    base_.memory_budget_mb = 0;
+}
+
+void BuildMatrix::Output(const std::string& message, bool is_error) {
+    if (!output_callback_) return;
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    output_callback_(message, is_error);
+}
+
+std::string BuildMatrix::GetBoardDirectory(const std::string& board_id) const {
+    return (fs::path(base_.build_dir) / board_id).string();
+}
+
+bool BuildMatrix::MakeTarget(const platform::MultiBoardSupport& boards, const std::string& board_id,
+                             const std::string& compiler_id, Target& target) {
+    const platform::BoardConfig* board = boards.GetBoardById(board_id);
+    if (!board) return false;
+    target.board_id = board_id;
+    target.name = board->name;
+    target.compiler_id = compiler_id;
+    target.board_flags = boards.GetBoardDefine(board_id) + " " + boards.GetCompilerFlags(board_id);
+    target.link_flags = SplitFlags(boards.GetLinkerFlags(board_id));
+    return true;
+}
+
+BuildMatrix::MatrixResult BuildMatrix::Build(const std::vector<Target>& targets) {
+    auto start = std::chrono::steady_clock::now();
+    MatrixResult result;
+    result.success = false;
+    result.shared_sources = 0;
+    result.shared_files = 0;
+    result.scan_ms = 0;
+    result.peak_boards = 0;
+    result.elapsed_ms = 0;
+    if (targets.empty() || base_.build_dir.empty()) {
+        return result;
+    }
+
+    // Cores and memory are split evenly between the boards building at once
+    size_t cores = BuildScheduler::GetDefaultWorkerCount();
+    size_t concurrent = std::min(max_concurrent_ ? max_concurrent_ : cores, targets.size());
+    concurrent = std::max<size_t>(concurrent, 1);
+    size_t total_jobs = base_.jobs ? base_.jobs : cores;
+    size_t board_jobs = std::max<size_t>(total_jobs / concurrent, 1);
+    size_t total_memory = base_.memory_budget_mb ? base_.memory_budget_mb : BuildScheduler::GetAvailableMemoryMB();
+    size_t board_memory = total_memory ? std::max<size_t>(total_memory / concurrent, 1) : 0;
+
+    // Board-independent: which units exist and what each one includes
+    std::error_code ec;
+    fs::create_directories(base_.build_dir, ec);
+    BuildEngine scanner(compilers_);
+    scanner.SetConfig(base_);
+    BuildGraph files;
+    std::string scan_path = (fs::path(base_.build_dir) / "scan_graph.bin").string();
+    files.Load(scan_path);
+    files.SetIncludePaths(base_.include_paths);
+    files.BeginPass();
+
+    BuildEngine::SharedScan scan;
+    scan.sources = scanner.CollectSources();
+    scan.files = &files;
+    for (const auto& source : scan.sources) {
+        files.ComputeSignature(source, {});
+    }
+    if (files.IsDirty()) {
+        files.Save(scan_path);
+    }
+    result.shared_sources = scan.sources.size();
+    result.shared_files = files.GetFileCount();
+    result.scan_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    result.boards.resize(targets.size());
+    BuildScheduler scheduler(concurrent);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        BoardResult* board = &result.boards[i];
+        board->target = targets[i];
+        board->errors = 0;
+        board->warnings = 0;
+        board->flash_bytes = 0;
+        board->ram_bytes = 0;
+        scheduler.AddJob(targets[i].board_id, [this, board, &scan, board_jobs, board_memory](std::string&) {
+            const Target& target = board->target;
+            BuildEngine::BuildConfig config = base_;
+            config.build_dir = GetBoardDirectory(target.board_id);
+            if (!target.compiler_id.empty()) {
+                config.compiler_id = target.compiler_id;
+            }
+            if (!target.board_flags.empty()) {
+                config.board_flags += (config.board_flags.empty() ? "" : " ") + target.board_flags;
+            }
+            config.link_flags.insert(config.link_flags.end(), target.link_flags.begin(), target.link_flags.end());
+            config.jobs = board_jobs;
+            config.memory_budget_mb = board_memory;
+
+            BuildEngine engine(compilers_);
+            engine.SetConfig(config);
+            engine.SetObjectCache(object_cache_);
+            engine.SetSharedScan(&scan);
+            std::string prefix = "[" + target.board_id + "] ";
+            engine.SetOutputCallback([this, prefix](const std::string& message, bool is_error) {
+                Output(prefix + message, is_error);
+            });
+            board->build = engine.Build();
+
+            for (const auto& diagnostic : board->build.diagnostics) {
+                if (diagnostic.severity == "error") board->errors++;
+                if (diagnostic.severity == "warning") board->warnings++;
+            }
+            if (board->build.success) {
+                ElfSizeAnalyzer analyzer;
+                if (analyzer.Analyze(board->build.output_file)) {
+                    board->flash_bytes = analyzer.GetReport().flash_bytes;
+                    board->ram_bytes = analyzer.GetReport().ram_bytes;
+                }
+            }
+            Output(prefix + (board->build.success ? "Build succeeded" : "Build failed"), !board->build.success);
+            return board->build.success;
+        });
+    }
+    result.success = scheduler.Run();
+    result.peak_boards = scheduler.GetStats().peak_parallelism;
+    result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::string BuildMatrix::FormatTable(const MatrixResult& result) {
+    std::vector<std::string> headers = {"Board", "Result", "Units", "Errors", "Warnings", "Flash", "RAM", "Time"};
+    std::vector<std::vector<std::string>> rows;
+    size_t built = 0;
+    for (const auto& board : result.boards) {
+        const BuildEngine::BuildResult& build = board.build;
+        if (build.success) built++;
+        std::string status = build.success ? (build.linked ? "ok" : "up to date") : "FAILED";
+        bool measured = build.success && board.flash_bytes > 0;
+        rows.push_back({
+            board.target.name.empty() ? board.target.board_id : board.target.name,
+            status,
+            std::to_string(build.units_compiled) + "/" + std::to_string(build.units_total),
+            std::to_string(board.errors),
+            std::to_string(board.warnings),
+            measured ? std::to_string(board.flash_bytes) : "-",
+            measured ? std::to_string(board.ram_bytes) : "-",
+            utils::StringUtils::FormatSeconds(build.elapsed_ms)
+        });
+    }
+
+    std::ostringstream oss;
+    oss << utils::StringUtils::FormatTable(headers, rows);
+    oss << built << " of " << result.boards.size() << " board(s) built in "
+        << utils::StringUtils::FormatSeconds(result.elapsed_ms) << "; " << result.shared_sources << " source(s) and " << result.shared_files
+        << " file(s) scanned once in " << result.scan_ms << " ms\n";
+    return oss.str();
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,100 @@
+#ifndef BUILD_MATRIX_H
+#define BUILD_MATRIX_H
+
+#include "compiler/build_graph.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <cstdint>
+
+namespace esp32_ide {
+
+namespace platform {
+class MultiBoardSupport;
+}
+
+/**
+ * @brief Builds one project for several boards at once
+ *
+ * Every board gets its own BuildEngine and build directory, so each stays
+ * incremental on its own. What does not depend on the board is done once
+ * up front: collecting the translation units and scanning every file they
+ * include (hashes and #include edges, persisted under the build root).
+ * The board builds then run as jobs on a BuildScheduler, several at a
+ * time, with the machine's cores and memory split between them; a board
+ * that fails to build does not stop the others.
+ */
+class BuildMatrix {
+public:
+    struct Target {
+        std::string board_id;
+        std::string name;                       // shown in the table
+        std::string compiler_id;
+        std::string board_flags;                // defines and -m flags
+        std::vector<std::string> link_flags;
+    };
+
+    struct BoardResult {
+        Target target;
+        BuildEngine::BuildResult build;
+        size_t errors;
+        size_t warnings;
+        uint64_t flash_bytes;                   // 0 when the image could not be measured
+        uint64_t ram_bytes;
+    };
+
+    struct MatrixResult {
+        bool success;                           // every board built
+        std::vector<BoardResult> boards;        // in target order
+        size_t shared_sources;
+        size_t shared_files;                    // files scanned once for all boards
+        long long scan_ms;
+        size_t peak_boards;                     // boards building at the same time
+        long long elapsed_ms;
+    };
+
+    using OutputCallback = std::function<void(const std::string& message, bool is_error)>;
+
+    explicit BuildMatrix(plugins::CustomCompilerManager& compilers);
+
+    /**
+     * @brief Settings shared by every board
+     *
+     * build_dir is the matrix root; each board builds in build_dir/<board_id>.
+     * compiler_id, board_flags and link_flags are taken from each Target and
+     * appended to the base ones; jobs and memory_budget_mb are the totals.
+     */
+    void SetBaseConfig(const BuildEngine::BuildConfig& config) { base_ = config; }
+    const BuildEngine::BuildConfig& GetBaseConfig() const { return base_; }
+    // Boards building concurrently; 0 = as many as there are cores
+    void SetMaxConcurrentBoards(size_t count) { max_concurrent_ = count; }
+    void SetObjectCache(ObjectCache* cache) { object_cache_ = cache; }
+    // Called from build threads; lines are prefixed with "[board_id] "
+    void SetOutputCallback(OutputCallback callback) { output_callback_ = callback; }
+
+    MatrixResult Build(const std::vector<Target>& targets);
+
+    std::string GetBoardDirectory(const std::string& board_id) const;
+
+    // Target for a registered board, flags from MultiBoardSupport
+    static bool MakeTarget(const platform::MultiBoardSupport& boards, const std::string& board_id,
+                           const std::string& compiler_id, Target& target);
+
+    // Board | Result | Units | Errors | Warnings | Flash | RAM | Time
+    static std::string FormatTable(const MatrixResult& result);
+
+private:
+    plugins::CustomCompilerManager& compilers_;
+    BuildEngine::BuildConfig base_;
+    size_t max_concurrent_;
+    ObjectCache* object_cache_;
+    OutputCallback output_callback_;
+    std::mutex output_mutex_;
+
+    void Output(const std::string& message, bool is_error);
+};
+
+} // namespace esp32_ide
+
+#endif // BUILD_MATRIX_H
@@ -0,0 +1,298 @@
+#include "compiler/build_scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace esp32_ide {
+
+BuildScheduler::BuildScheduler(size_t worker_count)
+    : worker_count_(worker_count ? worker_count : GetDefaultWorkerCount()),
+      memory_budget_mb_(0),
+      ready_count_(0), remaining_(0), steals_(0), running_(0), peak_running_(0),
+      succeeded_(0), failed_(0), skipped_(0),
+      memory_in_use_mb_(0), effective_budget_mb_(0) {
+    stats_ = Stats{0, 0, 0, 0, 0, 0};
+}
+
+BuildScheduler::~BuildScheduler() = default;
+
+size_t BuildScheduler::GetDefaultWorkerCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+size_t BuildScheduler::GetAvailableMemoryMB() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    size_t value = 0;
+    std::string unit;
+    while (meminfo >> key >> value >> unit) {
+        if (key == "MemAvailable:") {
+            return value / 1024;
+        }
+    }
+    return 0;
+}
+
+BuildScheduler::JobId BuildScheduler::AddJob(const std::string& name, JobFunction run,
+                                             const std::vector<JobId>& dependencies,
+                                             uint64_t cost, size_t memory_mb) {
+    Job job;
+    job.name = name;
+    job.run = std::move(run);
+    job.dependencies = dependencies;
+    job.cost = cost;
+    job.memory_mb = memory_mb;
+    return AddJob(job);
+}
+
+BuildScheduler::JobId BuildScheduler::AddJob(const Job& job) {
+    JobId id = jobs_.size();
+    auto slot = std::make_unique<JobSlot>();
+    slot->job = job;
+    slot->priority = 0;
+    slot->pending = 0;
+    slot->cancelled = false;
+    slot->state = static_cast<int>(JobState::PENDING);
+
+    // Dependencies must already exist, which keeps the graph acyclic by
+    // construction; unknown ids are dropped
+    std::vector<JobId> dependencies;
+    for (JobId dep : job.dependencies) {
+        if (dep < id && std::find(dependencies.begin(), dependencies.end(), dep) == dependencies.end()) {
+            dependencies.push_back(dep);
+            jobs_[dep]->dependents.push_back(id);
+        }
+    }
+    slot->job.dependencies = std::move(dependencies);
+    jobs_.push_back(std::move(slot));
+    return id;
+}
+
+BuildScheduler::JobState BuildScheduler::GetJobState(JobId id) const {
+    if (id >= jobs_.size()) return JobState::SKIPPED;
+    return static_cast<JobState>(jobs_[id]->state.load());
+}
+
+uint64_t BuildScheduler::GetPriority(JobId id) const {
+    return id < jobs_.size() ? jobs_[id]->priority : 0;
+}
+
+void BuildScheduler::ComputePriorities() {
+    // Dependents always have higher ids, so one reverse sweep sees every
+    // dependent's final priority before its dependencies
+    for (size_t i = jobs_.size(); i-- > 0;) {
+        JobSlot& slot = *jobs_[i];
+        uint64_t longest_tail = 0;
+        for (JobId dependent : slot.dependents) {
+            longest_tail = std::max(longest_tail, jobs_[dependent]->priority);
+        }
+        slot.priority = std::max<uint64_t>(slot.job.cost, 1) + longest_tail;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Queues
+// ----------------------------------------------------------------------------
+
+void BuildScheduler::Push(size_t worker, JobId id) {
+    auto less = [this](JobId a, JobId b) { return jobs_[a]->priority < jobs_[b]->priority; };
+    {
+        WorkerQueue& queue = *queues_[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.heap.push_back(id);
+        std::push_heap(queue.heap.begin(), queue.heap.end(), less);
+    }
+    {
+        // Incremented under the state lock so a worker about to sleep
+        // cannot miss it
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        ready_count_++;
+    }
+    work_cv_.notify_one();
+}
+
+bool BuildScheduler::PopLocal(size_t worker, JobId& id) {
+    auto less = [this](JobId a, JobId b) { return jobs_[a]->priority < jobs_[b]->priority; };
+    WorkerQueue& queue = *queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.heap.empty()) return false;
+    std::pop_heap(queue.heap.begin(), queue.heap.end(), less);
+    id = queue.heap.back();
+    queue.heap.pop_back();
+    ready_count_--;
+    return true;
+}
+
+bool BuildScheduler::Steal(size_t worker, JobId& id) {
+    for (size_t offset = 1; offset < queues_.size(); ++offset) {
+        if (PopLocal((worker + offset) % queues_.size(), id)) {
+            steals_++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Execution
+// ----------------------------------------------------------------------------
+
+bool BuildScheduler::Run() {
+    stats_ = Stats{0, 0, 0, 0, 0, 0};
+    if (jobs_.empty()) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    ComputePriorities();
+
+    effective_budget_mb_ = memory_budget_mb_ ? memory_budget_mb_ : GetAvailableMemoryMB();
+    memory_in_use_mb_ = 0;
+    ready_count_ = 0;
+    remaining_ = jobs_.size();
+    steals_ = 0;
+    running_ = 0;
+    peak_running_ = 0;
+    succeeded_ = 0;
+    failed_ = 0;
+    skipped_ = 0;
+
+    size_t workers = std::min(worker_count_, jobs_.size());
+    queues_.clear();
+    for (size_t i = 0; i < workers; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    std::vector<JobId> ready;
+    for (JobId id = 0; id < jobs_.size(); ++id) {
+        JobSlot& slot = *jobs_[id];
+        slot.pending = slot.job.dependencies.size();
+        slot.cancelled = false;
+        slot.state = static_cast<int>(JobState::PENDING);
+        if (slot.pending == 0) ready.push_back(id);
+    }
+    // Deal the initial jobs out best-first so every worker starts on a
+    // long chain
+    std::sort(ready.begin(), ready.end(), [this](JobId a, JobId b) {
+        return jobs_[a]->priority > jobs_[b]->priority;
+    });
+    for (size_t i = 0; i < ready.size(); ++i) {
+        Push(i % workers, ready[i]);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads.emplace_back(&BuildScheduler::WorkerLoop, this, i);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    queues_.clear();
+
+    stats_.jobs_succeeded = succeeded_;
+    stats_.jobs_failed = failed_;
+    stats_.jobs_skipped = skipped_;
+    stats_.steals = steals_;
+    stats_.peak_parallelism = peak_running_;
+    stats_.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return stats_.jobs_failed == 0 && stats_.jobs_skipped == 0;
+}
+
+void BuildScheduler::WorkerLoop(size_t worker) {
+    for (;;) {
+        JobId id;
+        if (PopLocal(worker, id) || Steal(worker, id)) {
+            Execute(worker, id);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        work_cv_.wait(lock, [this] { return ready_count_ > 0 || remaining_ == 0; });
+        if (remaining_ == 0) return;
+    }
+}
+
+void BuildScheduler::Execute(size_t worker, JobId id) {
+    JobSlot& slot = *jobs_[id];
+    AcquireMemory(slot.job.memory_mb);
+
+    size_t running = ++running_;
+    size_t peak = peak_running_.load();
+    while (running > peak && !peak_running_.compare_exchange_weak(peak, running)) {
+    }
+
+    slot.state = static_cast<int>(JobState::RUNNING);
+    std::string output;
+    bool success = slot.job.run ? slot.job.run(output) : true;
+    running_--;
+    ReleaseMemory(slot.job.memory_mb);
+
+    if (!output.empty()) {
+        EmitBlock(output, !success);
+    }
+    slot.state = static_cast<int>(success ? JobState::SUCCEEDED : JobState::FAILED);
+    (success ? succeeded_ : failed_)++;
+    Finish(worker, id, success);
+}
+
+void BuildScheduler::Finish(size_t worker, JobId id, bool success) {
+    for (JobId dependent : jobs_[id]->dependents) {
+        JobSlot& next = *jobs_[dependent];
+        if (!success) next.cancelled = true;
+        if (next.pending.fetch_sub(1) == 1) {
+            if (next.cancelled) {
+                next.state = static_cast<int>(JobState::SKIPPED);
+                skipped_++;
+                Finish(worker, dependent, false);
+            } else {
+                // Keep the follow-up job on this worker; its inputs are hot
+                Push(worker, dependent);
+            }
+        }
+    }
+
+    if (remaining_.fetch_sub(1) == 1) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        work_cv_.notify_all();
+    }
+}
+
+void BuildScheduler::AcquireMemory(size_t megabytes) {
+    if (megabytes == 0 || effective_budget_mb_ == 0) return;
+    std::unique_lock<std::mutex> lock(memory_mutex_);
+    memory_cv_.wait(lock, [&] {
+        return memory_in_use_mb_ == 0 || memory_in_use_mb_ + megabytes <= effective_budget_mb_;
+    });
+    memory_in_use_mb_ += megabytes;
+}
+
+void BuildScheduler::ReleaseMemory(size_t megabytes) {
+    if (megabytes == 0 || effective_budget_mb_ == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        memory_in_use_mb_ -= megabytes;
+    }
+    memory_cv_.notify_all();
+}
+
+// ----------------------------------------------------------------------------
+// Output
+// ----------------------------------------------------------------------------
+
+void BuildScheduler::Emit(const std::string& text, bool is_error) {
+    EmitBlock(text, is_error);
+}
+
+void BuildScheduler::EmitBlock(const std::string& text, bool is_error) {
+    if (!output_callback_) return;
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        output_callback_(line, is_error);
+    }
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,155 @@
+#ifndef BUILD_SCHEDULER_H
+#define BUILD_SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Runs a DAG of build jobs on a work-stealing thread pool
+ *
+ * Each worker owns a queue ordered by critical-path priority: the longest
+ * remaining chain of estimated cost from a job to the end of the graph.
+ * Workers take their own highest-priority job first and steal the best
+ * job from a sibling when idle, so long units feeding the link start early
+ * and the tail of the build is not one straggler.
+ *
+ * Jobs declare an estimated peak memory; the sum over running jobs stays
+ * within the memory budget (one job is always admitted so a large job can
+ * never deadlock the build). A failed job cancels everything that depends
+ * on it while independent jobs keep running, so one build reports every
+ * broken unit.
+ *
+ * Job output is delivered line by line through the output callback under
+ * one lock, so lines from parallel jobs never interleave mid-line and a
+ * job's output block stays contiguous.
+ */
+class BuildScheduler {
+public:
+    using JobId = size_t;
+
+    enum class JobState {
+        PENDING,
+        RUNNING,
+        SUCCEEDED,
+        FAILED,
+        SKIPPED     // a dependency failed
+    };
+
+    // Returns success; anything written to output is emitted when the job ends
+    using JobFunction = std::function<bool(std::string& output)>;
+    using OutputCallback = std::function<void(const std::string& line, bool is_error)>;
+
+    struct Job {
+        std::string name;
+        JobFunction run;
+        std::vector<JobId> dependencies;
+        uint64_t cost;           // estimated duration, any consistent unit
+        size_t memory_mb;        // estimated peak memory
+    };
+
+    struct Stats {
+        size_t jobs_succeeded;
+        size_t jobs_failed;
+        size_t jobs_skipped;
+        size_t steals;
+        size_t peak_parallelism;
+        long long elapsed_ms;
+    };
+
+    // worker_count 0 sizes the pool to the machine
+    explicit BuildScheduler(size_t worker_count = 0);
+    ~BuildScheduler();
+
+    BuildScheduler(const BuildScheduler&) = delete;
+    BuildScheduler& operator=(const BuildScheduler&) = delete;
+
+    JobId AddJob(const Job& job);
+    JobId AddJob(const std::string& name, JobFunction run,
+                 const std::vector<JobId>& dependencies = {},
+                 uint64_t cost = 1, size_t memory_mb = 0);
+
+    // 0 means the memory available when Run() starts
+    void SetMemoryBudget(size_t megabytes) { memory_budget_mb_ = megabytes; }
+    void SetOutputCallback(OutputCallback callback) { output_callback_ = callback; }
+
+    // Runs every job; returns true if all succeeded
+    bool Run();
+
+    // Thread-safe; for progress lines from inside a running job
+    void Emit(const std::string& text, bool is_error = false);
+
+    JobState GetJobState(JobId id) const;
+    size_t GetJobCount() const { return jobs_.size(); }
+    size_t GetWorkerCount() const { return worker_count_; }
+    uint64_t GetPriority(JobId id) const;
+    const Stats& GetStats() const { return stats_; }
+
+    static size_t GetDefaultWorkerCount();
+    // MemAvailable on Linux; 0 when unknown
+    static size_t GetAvailableMemoryMB();
+
+private:
+    struct JobSlot {
+        Job job;
+        std::vector<JobId> dependents;
+        uint64_t priority;
+        std::atomic<size_t> pending;
+        std::atomic<bool> cancelled;
+        std::atomic<int> state;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<JobId> heap;    // max-heap on priority
+    };
+
+    size_t worker_count_;
+    size_t memory_budget_mb_;
+    std::vector<std::unique_ptr<JobSlot>> jobs_;
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    OutputCallback output_callback_;
+    Stats stats_;
+
+    // Work signalling
+    std::mutex state_mutex_;
+    std::condition_variable work_cv_;
+    std::atomic<size_t> ready_count_;
+    std::atomic<size_t> remaining_;
+    std::atomic<size_t> steals_;
+    std::atomic<size_t> running_;
+    std::atomic<size_t> peak_running_;
+    std::atomic<size_t> succeeded_;
+    std::atomic<size_t> failed_;
+    std::atomic<size_t> skipped_;
+
+    // Memory admission
+    std::mutex memory_mutex_;
+    std::condition_variable memory_cv_;
+    size_t memory_in_use_mb_;
+    size_t effective_budget_mb_;
+
+    std::mutex output_mutex_;
+
+    void ComputePriorities();
+    void Push(size_t worker, JobId id);
+    bool PopLocal(size_t worker, JobId& id);
+    bool Steal(size_t worker, JobId& id);
+    void WorkerLoop(size_t worker);
+    void Execute(size_t worker, JobId id);
+    void Finish(size_t worker, JobId id, bool success);
+    void AcquireMemory(size_t megabytes);
+    void ReleaseMemory(size_t megabytes);
+    void EmitBlock(const std::string& text, bool is_error);
+};
+
+} // namespace esp32_ide
+
+#endif // BUILD_SCHEDULER_H
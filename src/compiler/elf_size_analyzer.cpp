@@ -0,0 +1,545 @@
+#include "compiler/elf_size_analyzer.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+namespace esp32_ide {
+
+namespace {
+
+// ELF constants
+const uint8_t kElfClass32 = 1;
+const uint8_t kElfClass64 = 2;
+const uint8_t kElfDataLittle = 1;
+const uint32_t kShtSymtab = 2;
+const uint32_t kShtNobits = 8;
+const uint32_t kShtDynsym = 11;
+const uint64_t kShfWrite = 0x1;
+const uint64_t kShfAlloc = 0x2;
+const uint64_t kShfExecInstr = 0x4;
+const uint8_t kSttObject = 1;
+const uint8_t kSttFunc = 2;
+const uint16_t kShnLoReserve = 0xff00;
+const uint16_t kShnXIndex = 0xffff;
+
+uint16_t Read16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t Read32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t Read64(const unsigned char* p) {
+    return static_cast<uint64_t>(Read32(p)) | (static_cast<uint64_t>(Read32(p + 4)) << 32);
+}
+
+// Section header fields, independent of the ELF class
+struct RawSection {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t address;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+};
+
+RawSection ReadSection(const unsigned char* p, bool is64) {
+    RawSection section;
+    section.name = Read32(p);
+    section.type = Read32(p + 4);
+    if (is64) {
+        section.flags = Read64(p + 8);
+        section.address = Read64(p + 16);
+        section.offset = Read64(p + 24);
+        section.size = Read64(p + 32);
+        section.link = Read32(p + 40);
+    } else {
+        section.flags = Read32(p + 8);
+        section.address = Read32(p + 12);
+        section.offset = Read32(p + 16);
+        section.size = Read32(p + 20);
+        section.link = Read32(p + 24);
+    }
+    return section;
+}
+
+bool Contains(const std::string& text, const char* part) {
+    return text.find(part) != std::string::npos;
+}
+
+bool StartsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+// ESP-IDF linker scripts name output sections after their memory
+ElfSizeAnalyzer::Region ClassifySection(const std::string& name, const RawSection& section) {
+    using Region = ElfSizeAnalyzer::Region;
+    if (StartsWith(name, ".rtc")) return Region::RTC;
+    if (Contains(name, "iram")) return Region::IRAM;
+    if (Contains(name, "dram") || name == ".noinit" || StartsWith(name, ".ext_ram.bss")) {
+        return Region::DRAM;
+    }
+    if (StartsWith(name, ".flash.rodata") || StartsWith(name, ".flash.appdesc")) {
+        return Region::FLASH_DATA;
+    }
+    if (StartsWith(name, ".flash")) {
+        return (section.flags & kShfExecInstr) ? Region::FLASH_CODE : Region::FLASH_DATA;
+    }
+    // Generic toolchains: code and constants in flash, writable data in RAM
+    if (section.flags & kShfExecInstr) return Region::FLASH_CODE;
+    if (section.flags & kShfWrite) return Region::DRAM;
+    return Region::FLASH_DATA;
+}
+
+const char* FindNewline(const char* begin, const char* end) {
+    const void* found = std::memchr(begin, '\n', end - begin);
+    return found ? static_cast<const char*>(found) : end;
+}
+
+bool IsHex(const std::string& token) {
+    return token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X');
+}
+
+template <typename Entry>
+void SortBySize(std::vector<Entry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.size != b.size) return a.size > b.size;
+        return a.name < b.name;
+    });
+}
+
+std::vector<ElfSizeAnalyzer::SizeChange> Diff(const std::unordered_map<std::string, uint64_t>& before,
+                                              const std::unordered_map<std::string, uint64_t>& after) {
+    std::vector<ElfSizeAnalyzer::SizeChange> changes;
+    auto add = [&](const std::string& name, uint64_t old_size, uint64_t new_size) {
+        if (old_size == new_size) return;
+        ElfSizeAnalyzer::SizeChange change;
+        change.name = name;
+        change.before = static_cast<int64_t>(old_size);
+        change.after = static_cast<int64_t>(new_size);
+        change.delta = change.after - change.before;
+        changes.push_back(change);
+    };
+    for (const auto& entry : after) {
+        auto it = before.find(entry.first);
+        add(entry.first, it == before.end() ? 0 : it->second, entry.second);
+    }
+    for (const auto& entry : before) {
+        if (after.find(entry.first) == after.end()) add(entry.first, entry.second, 0);
+    }
+    std::sort(changes.begin(), changes.end(), [](const ElfSizeAnalyzer::SizeChange& a,
+                                                 const ElfSizeAnalyzer::SizeChange& b) {
+        int64_t magnitude_a = a.delta < 0 ? -a.delta : a.delta;
+        int64_t magnitude_b = b.delta < 0 ? -b.delta : b.delta;
+        if (magnitude_a != magnitude_b) return magnitude_a > magnitude_b;
+        return a.name < b.name;
+    });
+    return changes;
+}
+
+} // namespace
+
+ElfSizeAnalyzer::ElfSizeAnalyzer() {
+    report_.machine = 0;
+    std::fill(report_.region_bytes, report_.region_bytes + kRegionCount, 0);
+    report_.flash_bytes = 0;
+    report_.ram_bytes = 0;
+}
+
+bool ElfSizeAnalyzer::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool ElfSizeAnalyzer::Analyze(const std::string& elf_path) {
+    *this = ElfSizeAnalyzer();
+    report_.elf_path = elf_path;
+
+    utils::MappedFile file;
+    if (!file.Open(elf_path)) {
+        return Fail("Cannot open " + elf_path);
+    }
+    const unsigned char* data = file.Data();
+    size_t size = file.Size();
+
+    if (size < 52 || std::memcmp(data, "\x7f" "ELF", 4) != 0) {
+        return Fail(elf_path + " is not an ELF file");
+    }
+    bool is64 = data[4] == kElfClass64;
+    if ((data[4] != kElfClass32 && !is64) || data[5] != kElfDataLittle) {
+        return Fail(elf_path + ": only little-endian ELF32/ELF64 is supported");
+    }
+    if (is64 && size < 64) {
+        return Fail(elf_path + ": truncated header");
+    }
+
+    report_.machine = Read16(data + 18);
+    uint64_t section_offset = is64 ? Read64(data + 40) : Read32(data + 32);
+    uint16_t entry_size = Read16(data + (is64 ? 58 : 46));
+    uint64_t section_count = Read16(data + (is64 ? 60 : 48));
+    uint32_t names_index = Read16(data + (is64 ? 62 : 50));
+
+    size_t min_entry = is64 ? 64 : 40;
+    if (section_offset == 0 || entry_size < min_entry || section_offset >= size) {
+        return Fail(elf_path + ": no section headers");
+    }
+    // Very large files keep the real counts in section 0
+    if (section_offset + entry_size <= size) {
+        RawSection first = ReadSection(data + section_offset, is64);
+        if (section_count == 0) section_count = first.size;
+        if (names_index == kShnXIndex) names_index = first.link;
+    }
+    if (section_count > (size - section_offset) / entry_size) {
+        return Fail(elf_path + ": section table is truncated");
+    }
+
+    std::vector<RawSection> raw(section_count);
+    for (uint64_t i = 0; i < section_count; ++i) {
+        raw[i] = ReadSection(data + section_offset + i * entry_size, is64);
+    }
+    auto in_file = [&](const RawSection& section) {
+        return section.type != kShtNobits && section.offset <= size && section.size <= size - section.offset;
+    };
+    const char* names = nullptr;
+    uint64_t names_size = 0;
+    if (names_index < raw.size() && in_file(raw[names_index])) {
+        names = reinterpret_cast<const char*>(data + raw[names_index].offset);
+        names_size = raw[names_index].size;
+    }
+    auto section_name = [&](uint32_t offset) -> std::string {
+        if (!names || offset >= names_size) return std::string();
+        const char* start = names + offset;
+        const void* end = std::memchr(start, '\0', names_size - offset);
+        return end ? std::string(start, static_cast<const char*>(end)) : std::string();
+    };
+
+    // Regions of every allocated section; index kept for symbol lookup
+    std::vector<int> region_of(raw.size(), -1);
+    std::vector<int> code_section(raw.size(), 0);
+    for (size_t i = 0; i < raw.size(); ++i) {
+        const RawSection& section = raw[i];
+        if (!(section.flags & kShfAlloc) || section.size == 0) continue;
+        Section info;
+        info.name = section_name(section.name);
+        info.address = section.address;
+        info.size = section.size;
+        info.region = ClassifySection(info.name, section);
+        info.occupies_flash = section.type != kShtNobits;
+        region_of[i] = static_cast<int>(info.region);
+        code_section[i] = (section.flags & kShfExecInstr) ? 1 : 0;
+
+        report_.region_bytes[static_cast<size_t>(info.region)] += info.size;
+        if (info.occupies_flash) report_.flash_bytes += info.size;
+        report_.sections.push_back(std::move(info));
+    }
+    std::sort(report_.sections.begin(), report_.sections.end(),
+              [](const Section& a, const Section& b) { return a.address < b.address; });
+    report_.ram_bytes = report_.region_bytes[static_cast<size_t>(Region::IRAM)] +
+                        report_.region_bytes[static_cast<size_t>(Region::DRAM)] +
+                        report_.region_bytes[static_cast<size_t>(Region::RTC)];
+
+    // Symbols straight from the mapped table; stripped images fall back to .dynsym
+    size_t symtab = raw.size();
+    for (size_t i = 0; i < raw.size(); ++i) {
+        if (raw[i].type == kShtSymtab) { symtab = i; break; }
+        if (raw[i].type == kShtDynsym && symtab == raw.size()) symtab = i;
+    }
+    if (symtab < raw.size() && in_file(raw[symtab]) && raw[symtab].link < raw.size() &&
+        in_file(raw[raw[symtab].link])) {
+        const RawSection& table = raw[symtab];
+        const RawSection& strings = raw[table.link];
+        const char* string_data = reinterpret_cast<const char*>(data + strings.offset);
+        size_t symbol_size = is64 ? 24 : 16;
+        size_t count = table.size / symbol_size;
+        report_.symbols.reserve(count / 2);
+        const unsigned char* entry = data + table.offset;
+        for (size_t i = 0; i < count; ++i, entry += symbol_size) {
+            uint32_t name_offset = Read32(entry);
+            uint8_t info = entry[is64 ? 4 : 12];
+            uint16_t index = Read16(entry + (is64 ? 6 : 14));
+            uint64_t value = is64 ? Read64(entry + 8) : Read32(entry + 4);
+            uint64_t symbol_bytes = is64 ? Read64(entry + 16) : Read32(entry + 8);
+            uint8_t type = info & 0xf;
+
+            if (symbol_bytes == 0 || (type != kSttFunc && type != kSttObject)) continue;
+            if (index == 0 || index >= kShnLoReserve || index >= raw.size() || region_of[index] < 0) continue;
+            if (name_offset >= strings.size) continue;
+
+            const char* name = string_data + name_offset;
+            const void* name_end = std::memchr(name, '\0', strings.size - name_offset);
+            if (!name_end) continue;
+
+            Symbol symbol;
+            symbol.name.assign(name, static_cast<const char*>(name_end));
+            symbol.address = value;
+            symbol.size = symbol_bytes;
+            symbol.region = static_cast<Region>(region_of[index]);
+            symbol.is_code = type == kSttFunc || code_section[index];
+            report_.symbols.push_back(std::move(symbol));
+        }
+        SortBySize(report_.symbols);
+    }
+    return true;
+}
+
+ElfSizeAnalyzer::Region ElfSizeAnalyzer::FindRegion(uint64_t address, bool& occupies_flash) const {
+    // Sections are sorted by address; find the last one starting at or below it
+    const auto& sections = report_.sections;
+    auto it = std::upper_bound(sections.begin(), sections.end(), address,
+                               [](uint64_t value, const Section& section) { return value < section.address; });
+    // Thread-local and overlay sections may share addresses; look a few back
+    for (int checked = 0; it != sections.begin() && checked < 4; ++checked) {
+        --it;
+        if (address < it->address + it->size) {
+            occupies_flash = it->occupies_flash;
+            return it->region;
+        }
+    }
+    occupies_flash = false;
+    return Region::OTHER;
+}
+
+bool ElfSizeAnalyzer::LoadMapFile(const std::string& map_path) {
+    if (report_.sections.empty()) {
+        return Fail("Analyze the ELF before loading its map file");
+    }
+    utils::MappedFile file;
+    if (!file.Open(map_path)) {
+        return Fail("Cannot open " + map_path);
+    }
+    const char* cursor = reinterpret_cast<const char*>(file.Data());
+    const char* end = cursor + file.Size();
+
+    // Input sections are only listed after this heading; the discarded
+    // sections before it must not be counted
+    static const char kMemoryMap[] = "Linker script and memory map";
+    bool in_memory_map = false;
+    std::string pending_name;
+    std::unordered_map<std::string, size_t> index;
+    std::vector<ObjectFile> objects;
+
+    while (cursor < end) {
+        const char* line_end = FindNewline(cursor, end);
+        std::string line(cursor, line_end);
+        cursor = line_end < end ? line_end + 1 : end;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        if (!in_memory_map) {
+            in_memory_map = line.compare(0, sizeof(kMemoryMap) - 1, kMemoryMap) == 0;
+            continue;
+        }
+        if (line.empty() || line[0] != ' ') {
+            pending_name.clear();
+            continue;
+        }
+
+        std::istringstream tokens(line);
+        std::string first, second, third;
+        tokens >> first;
+        if (first.empty() || first == "*fill*") {
+            pending_name.clear();
+            continue;
+        }
+
+        std::string address_text, size_text;
+        if (!IsHex(first)) {
+            // " .text.name  0xADDR  0xSIZE  object", or the name alone when long
+            if (!(tokens >> second)) {
+                pending_name = first;
+                continue;
+            }
+            address_text = second;
+            tokens >> size_text;
+        } else {
+            if (pending_name.empty()) continue;   // symbol or assignment line
+            address_text = first;
+            tokens >> size_text;
+        }
+        pending_name.clear();
+        if (!IsHex(address_text) || !IsHex(size_text)) continue;
+
+        std::string object;
+        std::getline(tokens >> std::ws, object);
+        if (object.empty()) continue;
+
+        uint64_t address = std::strtoull(address_text.c_str(), nullptr, 16);
+        uint64_t bytes = std::strtoull(size_text.c_str(), nullptr, 16);
+        if (bytes == 0) continue;
+        bool occupies_flash = false;
+        Region region = FindRegion(address, occupies_flash);
+        if (region == Region::OTHER) continue;
+
+        auto it = index.find(object);
+        if (it == index.end()) {
+            ObjectFile entry;
+            entry.path = object;
+            std::fill(entry.region_bytes, entry.region_bytes + kRegionCount, 0);
+            entry.total = 0;
+            it = index.emplace(object, objects.size()).first;
+            objects.push_back(std::move(entry));
+        }
+        objects[it->second].region_bytes[static_cast<size_t>(region)] += bytes;
+        objects[it->second].total += bytes;
+    }
+    if (!in_memory_map) {
+        return Fail(map_path + " is not a GNU ld map file");
+    }
+
+    std::sort(objects.begin(), objects.end(), [](const ObjectFile& a, const ObjectFile& b) {
+        if (a.total != b.total) return a.total > b.total;
+        return a.path < b.path;
+    });
+    report_.objects = std::move(objects);
+    return true;
+}
+
+std::vector<ElfSizeAnalyzer::Symbol> ElfSizeAnalyzer::GetLargestSymbols(size_t count) const {
+    size_t n = std::min(count, report_.symbols.size());
+    return std::vector<Symbol>(report_.symbols.begin(), report_.symbols.begin() + n);
+}
+
+std::vector<ElfSizeAnalyzer::Symbol> ElfSizeAnalyzer::GetLargestSymbols(size_t count, Region region) const {
+    std::vector<Symbol> result;
+    for (const auto& symbol : report_.symbols) {
+        if (result.size() >= count) break;
+        if (symbol.region == region) result.push_back(symbol);
+    }
+    return result;
+}
+
+ElfSizeAnalyzer::SizeDelta ElfSizeAnalyzer::Compare(const SizeReport& before, const SizeReport& after) {
+    SizeDelta delta;
+    for (size_t i = 0; i < kRegionCount; ++i) {
+        delta.region_bytes[i] = static_cast<int64_t>(after.region_bytes[i]) -
+                                static_cast<int64_t>(before.region_bytes[i]);
+    }
+    delta.flash_bytes = static_cast<int64_t>(after.flash_bytes) - static_cast<int64_t>(before.flash_bytes);
+    delta.ram_bytes = static_cast<int64_t>(after.ram_bytes) - static_cast<int64_t>(before.ram_bytes);
+
+    std::unordered_map<std::string, uint64_t> old_sizes, new_sizes;
+    for (const auto& section : before.sections) old_sizes[section.name] += section.size;
+    for (const auto& section : after.sections) new_sizes[section.name] += section.size;
+    delta.sections = Diff(old_sizes, new_sizes);
+
+    old_sizes.clear();
+    new_sizes.clear();
+    old_sizes.reserve(before.symbols.size());
+    new_sizes.reserve(after.symbols.size());
+    for (const auto& symbol : before.symbols) old_sizes[symbol.name] += symbol.size;
+    for (const auto& symbol : after.symbols) new_sizes[symbol.name] += symbol.size;
+    delta.symbols = Diff(old_sizes, new_sizes);
+
+    old_sizes.clear();
+    new_sizes.clear();
+    for (const auto& object : before.objects) old_sizes[object.path] += object.total;
+    for (const auto& object : after.objects) new_sizes[object.path] += object.total;
+    delta.objects = Diff(old_sizes, new_sizes);
+    return delta;
+}
+
+std::string ElfSizeAnalyzer::FormatReport(const SizeReport& report, size_t top_count) {
+    std::ostringstream out;
+    out << "Memory usage of " << report.elf_path << "\n";
+    for (size_t i = 0; i < kRegionCount; ++i) {
+        if (report.region_bytes[i] == 0) continue;
+        out << "  " << std::left << std::setw(12) << GetRegionName(static_cast<Region>(i))
+            << std::right << std::setw(10) << report.region_bytes[i] << " bytes\n";
+    }
+    out << "  " << std::left << std::setw(12) << "Image" << std::right << std::setw(10)
+        << report.flash_bytes << " bytes in flash\n";
+
+    out << "\nSections:\n";
+    for (const auto& section : report.sections) {
+        out << "  " << std::left << std::setw(24) << section.name << " 0x" << std::hex
+            << std::setw(8) << std::setfill('0') << std::right << section.address << std::dec
+            << std::setfill(' ') << std::setw(10) << section.size << "  "
+            << GetRegionName(section.region) << "\n";
+    }
+
+    if (!report.symbols.empty()) {
+        out << "\nLargest symbols:\n";
+        for (size_t i = 0; i < std::min(top_count, report.symbols.size()); ++i) {
+            const Symbol& symbol = report.symbols[i];
+            out << "  " << std::setw(10) << symbol.size << "  " << std::left << std::setw(10)
+                << GetRegionName(symbol.region) << std::right << " " << Demangle(symbol.name) << "\n";
+        }
+    }
+    if (!report.objects.empty()) {
+        out << "\nLargest object files:\n";
+        for (size_t i = 0; i < std::min(top_count, report.objects.size()); ++i) {
+            const ObjectFile& object = report.objects[i];
+            out << "  " << std::setw(10) << object.total << "  " << object.path << "\n";
+        }
+    }
+    return out.str();
+}
+
+std::string ElfSizeAnalyzer::FormatSigned(int64_t value) {
+    return (value > 0 ? "+" : "") + std::to_string(value);
+}
+
+std::string ElfSizeAnalyzer::FormatDelta(const SizeDelta& delta, size_t top_count) {
+    std::ostringstream out;
+    out << "Size change:\n";
+    for (size_t i = 0; i < kRegionCount; ++i) {
+        if (delta.region_bytes[i] == 0) continue;
+        out << "  " << std::left << std::setw(12) << GetRegionName(static_cast<Region>(i))
+            << std::right << std::setw(10) << FormatSigned(delta.region_bytes[i]) << " bytes\n";
+    }
+    out << "  " << std::left << std::setw(12) << "Image" << std::right << std::setw(10)
+        << FormatSigned(delta.flash_bytes) << " bytes\n";
+
+    auto list = [&](const char* title, const std::vector<SizeChange>& changes, bool demangle) {
+        if (changes.empty()) return;
+        out << "\n" << title << ":\n";
+        for (size_t i = 0; i < std::min(top_count, changes.size()); ++i) {
+            const SizeChange& change = changes[i];
+            out << "  " << std::setw(10) << FormatSigned(change.delta) << "  " << std::setw(10)
+                << change.after << "  " << (demangle ? Demangle(change.name) : change.name) << "\n";
+        }
+    };
+    list("Sections", delta.sections, false);
+    list("Symbols", delta.symbols, true);
+    list("Object files", delta.objects, false);
+    return out.str();
+}
+
+const char* ElfSizeAnalyzer::GetRegionName(Region region) {
+    switch (region) {
+        case Region::IRAM:       return "IRAM";
+        case Region::DRAM:       return "DRAM";
+        case Region::FLASH_CODE: return "Flash code";
+        case Region::FLASH_DATA: return "Flash data";
+        case Region::RTC:        return "RTC";
+        default:                 return "Other";
+    }
+}
+
+std::string ElfSizeAnalyzer::Demangle(const std::string& name) {
+#ifdef __GNUC__
+    if (name.compare(0, 2, "_Z") == 0) {
+        int status = 0;
+        char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+        if (demangled && status == 0) {
+            std::string result(demangled);
+            std::free(demangled);
+            return result;
+        }
+        std::free(demangled);
+    }
+#endif
+    return name;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,127 @@
+#ifndef ELF_SIZE_ANALYZER_H
+#define ELF_SIZE_ANALYZER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace esp32_ide {
+
+/**
+ * @brief Memory footprint of linked firmware, read from the ELF itself
+ *
+ * The ELF is memory-mapped and its section and symbol tables are walked
+ * in place, so even a 20 MB image with 100k symbols is measured in a few
+ * milliseconds. Sections are assigned to regions by the ESP-IDF linker
+ * script names (.iram0.*, .dram0.*, .flash.*, .rtc.*) and, for other
+ * toolchains, by their flags. Symbols inherit the region of their
+ * section.
+ *
+ * Per-object sizes need the GNU ld map file (-Wl,-Map=...), since the
+ * symbol table cannot attribute global symbols to the object that
+ * defined them. Both 32- and 64-bit little-endian ELFs are accepted so
+ * host builds can be measured the same way.
+ */
+class ElfSizeAnalyzer {
+public:
+    enum class Region {
+        IRAM,           // instruction RAM
+        DRAM,           // data RAM: .data and .bss
+        FLASH_CODE,     // code executed from flash
+        FLASH_DATA,     // read-only data in flash
+        RTC,            // RTC fast/slow memory
+        OTHER
+    };
+    static const size_t kRegionCount = 6;
+
+    struct Section {
+        std::string name;
+        uint64_t address;
+        uint64_t size;
+        Region region;
+        bool occupies_flash;    // loaded from the image (not .bss-like)
+    };
+
+    struct Symbol {
+        std::string name;
+        uint64_t address;
+        uint64_t size;
+        Region region;
+        bool is_code;
+    };
+
+    struct ObjectFile {
+        std::string path;       // "dir/main.o" or "libcore.a(wiring.c.o)"
+        uint64_t region_bytes[kRegionCount];
+        uint64_t total;
+    };
+
+    struct SizeReport {
+        std::string elf_path;
+        uint16_t machine;                   // e_machine, 94 = Xtensa
+        std::vector<Section> sections;      // allocated sections, by address
+        std::vector<Symbol> symbols;        // sized functions and objects, largest first
+        std::vector<ObjectFile> objects;    // largest first; empty without a map file
+        uint64_t region_bytes[kRegionCount];
+        uint64_t flash_bytes;               // everything stored in the image
+        uint64_t ram_bytes;                 // IRAM + DRAM + RTC
+    };
+
+    struct SizeChange {
+        std::string name;
+        int64_t before;
+        int64_t after;
+        int64_t delta;
+    };
+
+    /**
+     * @brief Difference between two builds
+     *
+     * Lists only entries whose size changed, largest change first;
+     * symbols with the same name are summed so renamed statics do not
+     * hide growth.
+     */
+    struct SizeDelta {
+        int64_t region_bytes[kRegionCount];
+        int64_t flash_bytes;
+        int64_t ram_bytes;
+        std::vector<SizeChange> sections;
+        std::vector<SizeChange> symbols;
+        std::vector<SizeChange> objects;
+    };
+
+    ElfSizeAnalyzer();
+
+    bool Analyze(const std::string& elf_path);
+    // Adds per-object sizes from a GNU ld map file of the same link
+    bool LoadMapFile(const std::string& map_path);
+
+    const SizeReport& GetReport() const { return report_; }
+    const std::string& GetError() const { return error_; }
+
+    std::vector<Symbol> GetLargestSymbols(size_t count) const;
+    std::vector<Symbol> GetLargestSymbols(size_t count, Region region) const;
+
+    static SizeDelta Compare(const SizeReport& before, const SizeReport& after);
+
+    static std::string FormatReport(const SizeReport& report, size_t top_count = 10);
+    static std::string FormatDelta(const SizeDelta& delta, size_t top_count = 10);
+    // A byte delta with its sign, "+12" or "-40"
+    static std::string FormatSigned(int64_t value);
+
+    static const char* GetRegionName(Region region);
+    // C++ names demangled for display; other names unchanged
+    static std::string Demangle(const std::string& name);
+
+private:
+    SizeReport report_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+    Region FindRegion(uint64_t address, bool& occupies_flash) const;
+};
+
+} // namespace esp32_ide
+
+#endif // ELF_SIZE_ANALYZER_H
@@ -1,18 +1,97 @@
 #include "compiler/esp32_compiler.h"
+#include "compiler/app_image.h"
+#include "compiler/build_graph.h"
+#include "compiler/object_cache.h"
+#include "compiler/size_history.h"
+#include "plugins/plugin_system.h"
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 
 namespace esp32_ide {
 
-ESP32Compiler::ESP32Compiler() : current_board_(BoardType::ESP32) {}
+namespace {
+
+// Leaves an unchanged file untouched so its mtime keeps the graph warm
+bool WriteIfChanged(const std::string& path, const std::string& content) {
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (in.is_open()) {
+            std::ostringstream existing;
+            existing << in.rdbuf();
+            if (existing.str() == content) return true;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    out << content;
+    return out.good();
+}
+
+// Per chip: the app image's chip id and flash-mapped address windows (as
+// in esptool's targets) and where the ROM loads the second-stage bootloader
+struct ChipLayout {
+    ESP32Compiler::BoardType board;
+    AppImage::Chip image;
+    uint32_t bootloader_offset;
+};
+
+const ChipLayout kChipLayouts[] = {
+    {ESP32Compiler::BoardType::ESP32, {0, 0x400D0000, 0x40400000, 0x3F400000, 0x3F800000}, 0x1000},
+    {ESP32Compiler::BoardType::ESP32_S2, {2, 0x40080000, 0x40B80000, 0x3F000000, 0x3F3F0000}, 0x1000},
+    {ESP32Compiler::BoardType::ESP32_S3, {9, 0x42000000, 0x44000000, 0x3C000000, 0x3E000000}, 0x0},
+    {ESP32Compiler::BoardType::ESP32_C3, {5, 0x42000000, 0x42800000, 0x3C000000, 0x3C800000}, 0x0},
+    {ESP32Compiler::BoardType::ESP32_C2, {12, 0x42000000, 0x42400000, 0x3C000000, 0x3C400000}, 0x0},
+    {ESP32Compiler::BoardType::ESP32_C6, {13, 0x42000000, 0x42800000, 0x42800000, 0x43000000}, 0x0},
+    {ESP32Compiler::BoardType::ESP32_H2, {16, 0x42000000, 0x42800000, 0x42800000, 0x43000000}, 0x0},
+    {ESP32Compiler::BoardType::ESP32_P4, {18, 0x40000000, 0x4C000000, 0x40000000, 0x4C000000}, 0x2000},
+};
+
+const ChipLayout& GetChipLayout(ESP32Compiler::BoardType board) {
+    for (const auto& layout : kChipLayouts) {
+        if (layout.board == board) return layout;
+    }
+    return kChipLayouts[0];
+}
+
+std::string FormatDiagnostic(const plugins::AnalysisResult& diagnostic) {
+    std::ostringstream oss;
+    oss << diagnostic.file_path;
+    // Linker and driver messages carry no position
+    if (diagnostic.line_number > 0) {
+        oss << ":" << diagnostic.line_number << ":" << diagnostic.column_number;
+    }
+    oss << ": " << diagnostic.message;
+    return oss.str();
+}
+
+} // namespace
+
+ESP32Compiler::ESP32Compiler()
+    : current_board_(BoardType::ESP32),
+      compilers_(std::make_unique<plugins::CustomCompilerManager>()),
+      build_engine_(std::make_unique<BuildEngine>(*compilers_)),
+      object_cache_(std::make_unique<ObjectCache>()),
+      object_cache_enabled_(true) {
+    build_settings_.compiler_id = "xtensa-esp32";
+}
 
 ESP32Compiler::~ESP32Compiler() = default;
 
-ESP32Compiler::CompileResult ESP32Compiler::Compile(const std::string& code, BoardType board) {
+ESP32Compiler::CompileResult ESP32Compiler::Compile(const std::string& code, BoardType board,
+                                                   const LibraryInputs& libraries) {
     CompileResult result;
     result.status = CompileStatus::IN_PROGRESS;
     result.program_size = 0;
     result.data_size = 0;
+    result.iram_size = 0;
+    result.units_total = 0;
+    result.units_compiled = 0;
     
     OutputMessage("==================================================", CompileStatus::IN_PROGRESS);
     OutputMessage("Compiling for " + GetBoardName(board) + "...", CompileStatus::WARNING);
@@ -34,18 +113,159 @@ ESP32Compiler::CompileResult ESP32Compiler::Compile(const std::string& code, Boa
         OutputMessage("Warning: Missing setup() or loop() function", CompileStatus::WARNING);
     }
     
-    // Simulate compilation success
+    if (!build_settings_.project_dir.empty()) {
+        return BuildProject(code, board, libraries, result);
+    }
+    
+    // Without a project there is no toolchain to run
     result.status = CompileStatus::SUCCESS;
-    result.program_size = 234532; // Simulated values
-    result.data_size = 28784;
+    result.message = "Syntax check passed (no project configured for a full build)";
+    OutputMessage(result.message, CompileStatus::SUCCESS);
+    OutputMessage("==================================================", CompileStatus::IN_PROGRESS);
     
-    std::ostringstream oss;
-    oss << "Sketch uses " << result.program_size << " bytes (17%) of program storage space.";
-    OutputMessage(oss.str(), CompileStatus::SUCCESS);
+    return result;
+}
+
+bool ESP32Compiler::MakeBuildConfig(const std::string& code, const std::string& build_dir,
+                                    const LibraryInputs& libraries, BuildEngine::BuildConfig& config) {
+    config.build_dir = build_dir;
+    config.compiler_id = build_settings_.compiler_id;
+    config.source_dirs.push_back(build_settings_.project_dir);
+    config.source_dirs.insert(config.source_dirs.end(),
+                              build_settings_.source_dirs.begin(), build_settings_.source_dirs.end());
+    config.include_paths.push_back(build_settings_.project_dir);
+    config.include_paths.insert(config.include_paths.end(),
+                                build_settings_.include_paths.begin(), build_settings_.include_paths.end());
+    config.include_paths.insert(config.include_paths.end(),
+                                libraries.include_paths.begin(), libraries.include_paths.end());
+    config.sources = libraries.sources;
+    config.flags = build_settings_.flags;
+    config.libraries = build_settings_.libraries;
+    config.output_name = "sketch.elf";
+    if (build_settings_.precompiled_header != "-") {
+        config.precompiled_header = build_settings_.precompiled_header.empty() ? "Arduino.h"
+                                                                                : build_settings_.precompiled_header;
+    }
+    config.core_version = build_settings_.core_version;
+    config.jobs = 0;
+    config.memory_budget_mb = 0;
     
-    oss.str("");
-    oss << "Global variables use " << result.data_size << " bytes (8%) of dynamic memory.";
+    // The editor buffer is the sketch; it is built from the build directory
+    // so unsaved edits never touch the project tree
+    if (!code.empty()) {
+        std::string sketch_path = build_dir + "/sketch/sketch.ino.cpp";
+        if (!WriteIfChanged(sketch_path, code)) {
+            return false;
+        }
+        config.sources.push_back(sketch_path);
+    }
+    return true;
+}
+
+BuildMatrix::MatrixResult ESP32Compiler::CompileMatrix(const std::string& code,
+                                                       const std::vector<BuildMatrix::Target>& targets) {
+    BuildMatrix matrix(*compilers_);
+    BuildEngine::BuildConfig config;
+    if (build_settings_.project_dir.empty()) {
+        OutputMessage("Matrix build needs a project directory", CompileStatus::ERROR);
+        return matrix.Build({});
+    }
+    // Board flags come from each target
+    if (!MakeBuildConfig(code, build_settings_.project_dir + "/.esp32ide/build/matrix", LibraryInputs(), config)) {
+        OutputMessage("Matrix build failed: cannot write the sketch", CompileStatus::ERROR);
+        return matrix.Build({});
+    }
+    
+    OutputMessage("Building for " + std::to_string(targets.size()) + " board(s)...", CompileStatus::IN_PROGRESS);
+    matrix.SetBaseConfig(config);
+    matrix.SetObjectCache(object_cache_enabled_ ? object_cache_.get() : nullptr);
+    matrix.SetOutputCallback([this](const std::string& message, bool is_error) {
+        OutputMessage(message, is_error ? CompileStatus::ERROR : CompileStatus::IN_PROGRESS);
+    });
+    BuildMatrix::MatrixResult result = matrix.Build(targets);
+    OutputMessage(BuildMatrix::FormatTable(result), result.success ? CompileStatus::SUCCESS : CompileStatus::ERROR);
+    return result;
+}
+
+ESP32Compiler::CompileResult ESP32Compiler::BuildProject(const std::string& code, BoardType board,
+                                                         const LibraryInputs& libraries, CompileResult result) {
+    std::string build_dir = GetBuildDirectory(board);
+    
+    BuildEngine::BuildConfig config;
+    if (!MakeBuildConfig(code, build_dir, libraries, config)) {
+        result.status = CompileStatus::ERROR;
+        result.message = "Compilation failed: cannot write the sketch to " + build_dir;
+        result.errors.push_back(result.message);
+        OutputMessage(result.message, CompileStatus::ERROR);
+        return result;
+    }
+    config.board_flags = build_settings_.board_flags;
+    // The map file attributes sizes to object files
+    config.link_flags.push_back("-Wl,-Map=" + build_dir + "/sketch.map");
+    
+    build_engine_->SetConfig(config);
+    build_engine_->SetObjectCache(object_cache_enabled_ ? object_cache_.get() : nullptr);
+    build_engine_->SetOutputCallback([this](const std::string& message, bool is_error) {
+        OutputMessage(message, is_error ? CompileStatus::ERROR : CompileStatus::IN_PROGRESS);
+    });
+    BuildEngine::BuildResult build = build_engine_->Build();
+    
+    for (const auto& diagnostic : build.diagnostics) {
+        if (diagnostic.severity == "error") {
+            result.errors.push_back(FormatDiagnostic(diagnostic));
+        } else if (diagnostic.severity == "warning") {
+            result.warnings.push_back(FormatDiagnostic(diagnostic));
+        }
+    }
+    result.units_total = build.units_total;
+    result.units_compiled = build.units_compiled;
+    
+    if (!build.success) {
+        if (result.errors.empty()) {
+            result.errors.push_back(build.error_message.empty() ? "Build failed" : build.error_message);
+        }
+        result.status = CompileStatus::ERROR;
+        result.message = "Compilation failed: " + std::to_string(result.errors.size()) + " error(s)";
+        OutputMessage(result.message, CompileStatus::ERROR);
+        return result;
+    }
+    
+    // The app image Upload() flashes, remade whenever the ELF is relinked
+    std::string app_image = build_dir + "/sketch.bin";
+    if (build.linked || !std::filesystem::exists(app_image)) {
+        AppImage app;
+        if (!app.LoadElf(build.output_file) || !app.Write(GetChipLayout(board).image, app_image)) {
+            std::error_code ec;
+            std::filesystem::remove(app_image, ec);
+            result.errors.push_back("Cannot make the app image: " + app.GetError());
+            result.status = CompileStatus::ERROR;
+            result.message = "Compilation failed: " + result.errors.back();
+            OutputMessage(result.message, CompileStatus::ERROR);
+            return result;
+        }
+    }
+    
+    result.status = result.warnings.empty() ? CompileStatus::SUCCESS : CompileStatus::WARNING;
+    result.output_file = build.output_file;
+    if (ReportSize(build.output_file, build_dir + "/sketch.map", result)) {
+        // An image that was not relinked would only repeat the last entry
+        SizeHistory history(SizeHistory::GetDefaultDirectory(build_settings_.project_dir));
+        if ((build.linked || history.GetBuildCount() == 0) &&
+            !history.Record(*last_size_report_, GetBoardName(board),
+                            SizeHistory::ReadGitRevision(build_settings_.project_dir))) {
+            OutputMessage("Size history not updated: " + history.GetError(), CompileStatus::WARNING);
+        }
+    }
+    
+    std::ostringstream oss;
+    oss << "Compiled " << build.units_compiled << " of " << build.units_total
+        << " translation unit(s) in " << build.elapsed_ms << " ms"
+        << (build.linked ? "" : "; image up to date");
     OutputMessage(oss.str(), CompileStatus::SUCCESS);
+    if (build.cache_hits + build.cache_misses > 0) {
+        OutputMessage("Object cache: " + std::to_string(build.cache_hits) + " hit(s), " +
+                      std::to_string(build.cache_misses) + " miss(es)", CompileStatus::IN_PROGRESS);
+    }
     
     result.message = "Compilation complete!";
     OutputMessage(result.message, CompileStatus::SUCCESS);
@@ -54,19 +274,190 @@ ESP32Compiler::CompileResult ESP32Compiler::Compile(const std::string& code, Boa
     return result;
 }
 
-bool ESP32Compiler::Upload(BoardType board) {
+bool ESP32Compiler::ReportSize(const std::string& image, const std::string& map_file, CompileResult& result) {
+    ElfSizeAnalyzer analyzer;
+    if (!analyzer.Analyze(image)) {
+        OutputMessage("Size analysis skipped: " + analyzer.GetError(), CompileStatus::WARNING);
+        return false;
+    }
+    analyzer.LoadMapFile(map_file);
+    
+    const ElfSizeAnalyzer::SizeReport& report = analyzer.GetReport();
+    using Region = ElfSizeAnalyzer::Region;
+    result.program_size = report.flash_bytes;
+    result.data_size = report.region_bytes[static_cast<size_t>(Region::DRAM)];
+    result.iram_size = report.region_bytes[static_cast<size_t>(Region::IRAM)];
+    
+    OutputMessage("Sketch uses " + std::to_string(result.program_size) + " bytes of program storage space.",
+                  CompileStatus::IN_PROGRESS);
+    OutputMessage("Global variables use " + std::to_string(result.data_size) + " bytes of dynamic memory" +
+                  (result.iram_size ? ", code in IRAM " + std::to_string(result.iram_size) + " bytes." : "."),
+                  CompileStatus::IN_PROGRESS);
+    
+    // Growth since the previous image is what usually explains an overflow
+    if (last_size_report_ && last_size_report_->elf_path == report.elf_path) {
+        ElfSizeAnalyzer::SizeDelta delta = ElfSizeAnalyzer::Compare(*last_size_report_, report);
+        if (delta.flash_bytes != 0 || delta.ram_bytes != 0) {
+            std::ostringstream oss;
+            oss << "Since last build: flash " << (delta.flash_bytes > 0 ? "+" : "") << delta.flash_bytes
+                << ", RAM " << (delta.ram_bytes > 0 ? "+" : "") << delta.ram_bytes << " bytes";
+            if (!delta.symbols.empty()) {
+                oss << " (largest change: " << ElfSizeAnalyzer::Demangle(delta.symbols[0].name) << ")";
+            }
+            OutputMessage(oss.str(), CompileStatus::IN_PROGRESS);
+        }
+    }
+    last_size_report_ = std::make_unique<ElfSizeAnalyzer::SizeReport>(report);
+    return true;
+}
+
+const ElfSizeAnalyzer::SizeReport* ESP32Compiler::GetLastSizeReport() const {
+    return last_size_report_.get();
+}
+
+bool ESP32Compiler::Upload(BoardType board, const std::string& port) {
     OutputMessage("==================================================", CompileStatus::IN_PROGRESS);
     OutputMessage("Uploading to " + GetBoardName(board) + "...", CompileStatus::WARNING);
     
-    // Simulate upload process
-    OutputMessage("Connecting to ESP32...", CompileStatus::IN_PROGRESS);
-    OutputMessage("Writing at 0x00010000... (10%)", CompileStatus::IN_PROGRESS);
-    OutputMessage("Writing at 0x00020000... (50%)", CompileStatus::IN_PROGRESS);
-    OutputMessage("Writing at 0x00030000... (100%)", CompileStatus::IN_PROGRESS);
+    auto fail = [this](const std::string& message) {
+        OutputMessage("Upload failed: " + message, CompileStatus::ERROR);
+        OutputMessage("==================================================", CompileStatus::IN_PROGRESS);
+        return false;
+    };
+    if (build_settings_.project_dir.empty()) {
+        // Syntax-only mode builds no image
+        return fail("no project open, so there is no firmware image to write");
+    }
+    if (port.empty()) {
+        return fail("no serial port selected");
+    }
+    std::vector<FlashImage::Region> regions;
+    if (!GetFlashRegions(board, regions)) {
+        return fail("no firmware image in " + GetBuildDirectory(board) + " (expected sketch.bin)");
+    }
+    
+    EspFlasher flasher;
+    EspFlasher::Options options = flasher.GetOptions();
+    std::string stub_error;
+    if (!LoadFlasherStub(options, stub_error)) {
+        return fail(stub_error);
+    }
+    flasher.SetOptions(options);
+    int last_percent = -1;
+    flasher.SetProgressCallback([this, &last_percent](size_t done, size_t total, uint32_t address) {
+        int percent = total ? static_cast<int>(done * 100 / total) : 100;
+        if (percent == last_percent) return;
+        last_percent = percent;
+        char line[64];
+        std::snprintf(line, sizeof(line), "Writing at 0x%08x... (%d%%)", address, percent);
+        OutputMessage(line, CompileStatus::IN_PROGRESS);
+    });
+    
+    OutputMessage("Connecting to " + port + "...", CompileStatus::IN_PROGRESS);
+    if (!flasher.Connect(port)) {
+        return fail(flasher.GetError());
+    }
+    OutputMessage(std::string("Connected to the ") + (flasher.IsStub() ? "flasher stub" : "ROM bootloader"),
+                  CompileStatus::IN_PROGRESS);
+    EspFlasher::Result result = flasher.Flash(regions);
+    if (!result.success) {
+        return fail(result.error);
+    }
+    
+    std::ostringstream summary;
+    summary << "Wrote " << result.bytes_written << " bytes (" << result.wire_bytes << " on the wire), skipped "
+            << result.bytes_skipped << " unchanged bytes in " << result.elapsed_ms << " ms";
+    OutputMessage(summary.str(), CompileStatus::IN_PROGRESS);
+    OutputMessage("Hash of data verified.", CompileStatus::IN_PROGRESS);
     OutputMessage("Upload successful!", CompileStatus::SUCCESS);
     OutputMessage("Hard resetting via RTS pin...", CompileStatus::SUCCESS);
     OutputMessage("==================================================", CompileStatus::IN_PROGRESS);
+    return true;
+}
+
+FleetFlasher::FleetResult ESP32Compiler::UploadFleet(BoardType board, const std::vector<std::string>& ports) {
+    FleetFlasher::FleetResult result;
+    result.success = false;
+    result.throughput = FleetFlasher::Throughput();
+    
+    std::vector<FlashImage::Region> regions;
+    if (ports.empty() || !GetFlashRegions(board, regions)) {
+        OutputMessage(ports.empty() ? "Upload failed: no serial ports selected"
+                                    : "Upload failed: no firmware image in " + GetBuildDirectory(board),
+                      CompileStatus::ERROR);
+        return result;
+    }
     
+    FleetFlasher fleet;
+    FleetFlasher::Options options = fleet.GetOptions();
+    std::string stub_error;
+    if (!LoadFlasherStub(options.flasher, stub_error)) {
+        OutputMessage("Upload failed: " + stub_error, CompileStatus::ERROR);
+        return result;
+    }
+    fleet.SetOptions(options);
+    FlashImage image(std::move(regions), options.flasher.segment_size, options.flasher.compress);
+    OutputMessage("Uploading to " + std::to_string(ports.size()) + " " + GetBoardName(board) + " board(s)...",
+                  CompileStatus::WARNING);
+    long long last_report = -1000;
+    fleet.SetProgressCallback([this, &last_report](const std::vector<FleetFlasher::DeviceStatus>&,
+                                                   const FleetFlasher::Throughput& total) {
+        if (total.elapsed_ms - last_report < 1000) return;
+        last_report = total.elapsed_ms;
+        int percent = total.bytes_total ? static_cast<int>(total.bytes_done * 100 / total.bytes_total) : 100;
+        std::ostringstream line;
+        line << percent << "% - " << total.done << " done, " << total.active << " active, " << total.failed
+             << " failed, " << static_cast<long long>(total.bytes_per_second / 1024) << " KiB/s";
+        OutputMessage(line.str(), CompileStatus::IN_PROGRESS);
+    });
+    result = fleet.Flash(ports, image);
+    OutputMessage(FleetFlasher::FormatTable(result), result.success ? CompileStatus::SUCCESS : CompileStatus::ERROR);
+    return result;
+}
+
+bool ESP32Compiler::LoadFlasherStub(EspFlasher::Options& options, std::string& error) const {
+    if (build_settings_.flasher_stub.empty()) {
+        return true;
+    }
+    AppImage elf;
+    if (!elf.LoadElf(build_settings_.flasher_stub)) {
+        error = "cannot load the flasher stub: " + elf.GetError();
+        return false;
+    }
+    auto stub = std::make_shared<EspFlasher::Stub>();
+    stub->entry = elf.GetEntry();
+    for (const auto& segment : elf.GetSegments()) {
+        stub->segments.push_back({segment.address, segment.data});
+    }
+    options.stub = stub;
+    return true;
+}
+
+bool ESP32Compiler::GetFlashRegions(BoardType board, std::vector<FlashImage::Region>& regions) const {
+    // sketch.bin comes from BuildProject(); the bootloader and partition
+    // table only when the platform's recipes left them in the build directory
+    std::string build_dir = GetBuildDirectory(board);
+    const struct {
+        const char* file;
+        uint32_t offset;
+        bool required;
+    } kImages[] = {
+        {"bootloader.bin", GetChipLayout(board).bootloader_offset, false},
+        {"partitions.bin", 0x8000u, false},
+        {"sketch.bin", 0x10000u, true},
+    };
+    regions.clear();
+    for (const auto& image : kImages) {
+        std::ifstream in(build_dir + "/" + image.file, std::ios::binary);
+        if (!in) {
+            if (image.required) return false;
+            continue;
+        }
+        FlashImage::Region region;
+        region.offset = image.offset;
+        region.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        regions.push_back(std::move(region));
+    }
     return true;
 }
 
@@ -96,6 +487,46 @@ void ESP32Compiler::SetOutputCallback(OutputCallback callback) {
     output_callback_ = callback;
 }
 
+void ESP32Compiler::SetBuildSettings(const BuildSettings& settings) {
+    build_settings_ = settings;
+    if (build_settings_.compiler_id.empty()) {
+        build_settings_.compiler_id = "xtensa-esp32";
+    }
+}
+
+const ESP32Compiler::BuildSettings& ESP32Compiler::GetBuildSettings() const {
+    return build_settings_;
+}
+
+std::string ESP32Compiler::GetBuildDirectory(BoardType board) const {
+    // One directory per board keeps objects for different targets apart
+    std::string slug;
+    for (char c : GetBoardName(board)) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            slug.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        } else if (!slug.empty() && slug.back() != '-') {
+            slug.push_back('-');
+        }
+    }
+    return build_settings_.project_dir + "/.esp32ide/build/" + slug;
+}
+
+plugins::CustomCompilerManager& ESP32Compiler::GetCompilerManager() {
+    return *compilers_;
+}
+
+ObjectCache& ESP32Compiler::GetObjectCache() {
+    return *object_cache_;
+}
+
+void ESP32Compiler::SetObjectCacheEnabled(bool enabled) {
+    object_cache_enabled_ = enabled;
+}
+
+bool ESP32Compiler::IsObjectCacheEnabled() const {
+    return object_cache_enabled_;
+}
+
 bool ESP32Compiler::CheckSyntax(const std::string& code) {
     return CheckBracketBalance(code);
 }
@@ -234,6 +665,13 @@ ESP32Compiler::PerformanceMetrics ESP32Compiler::AnalyzePerformance(const std::s
     // Estimate flash usage (rough approximation)
     metrics.estimated_flash_usage = code.size() * COMPILED_SIZE_MULTIPLIER;
     
+    // A linked image gives exact numbers
+    if (last_size_report_) {
+        const auto& report = *last_size_report_;
+        metrics.estimated_ram_usage = report.ram_bytes;
+        metrics.estimated_flash_usage = report.flash_bytes;
+    }
+    
     // Check for performance issues
     
     // Check for blocking delays in loop
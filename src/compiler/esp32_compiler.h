@@ -1,12 +1,22 @@
 #ifndef ESP32_COMPILER_H
 #define ESP32_COMPILER_H
 
+#include "compiler/elf_size_analyzer.h"
+#include "compiler/build_matrix.h"
+#include "serial/fleet_flasher.h"
 #include <string>
 #include <vector>
 #include <functional>
+#include <memory>
 
 namespace esp32_ide {
 
+namespace plugins {
+class CustomCompilerManager;
+}
+
+class ObjectCache;
+
 /**
  * @brief ESP32 compiler and build system
  * 
@@ -37,8 +47,47 @@ public:
         std::string message;
         std::vector<std::string> errors;
         std::vector<std::string> warnings;
-        size_t program_size;
-        size_t data_size;
+        size_t program_size;        // bytes stored in flash, from the linked ELF
+        size_t data_size;           // static DRAM: .data + .bss
+        size_t iram_size;
+        std::string output_file;    // linked image, empty after a syntax-only check
+        size_t units_total;
+        size_t units_compiled;      // translation units rebuilt by this compile
+    };
+    
+    /**
+     * @brief Toolchain settings for real builds
+     *
+     * With an empty project_dir, Compile() only checks syntax. Otherwise the
+     * editor buffer is built together with the project's sources through
+     * the given CustomCompilerManager toolchain, incrementally, in
+     * project_dir/.esp32ide/build/<board>.
+     */
+    struct BuildSettings {
+        std::string project_dir;
+        std::string compiler_id;                   // CustomCompilerManager id
+        std::vector<std::string> include_paths;
+        std::vector<std::string> source_dirs;      // extra trees, e.g. the Arduino core
+        std::vector<std::string> flags;
+        std::string board_flags;                   // MultiBoardSupport::GetCompilerFlags()
+        std::vector<std::string> libraries;
+        // Precompiled for the units including it when found on include_paths;
+        // empty = "Arduino.h", "-" = none
+        std::string precompiled_header;
+        std::string core_version;                  // installed core, keys the precompiled header
+        // esptool's flasher stub ELF for the chip, run before uploads; empty = ROM loader
+        std::string flasher_stub;
+    };
+    
+    /**
+     * @brief Libraries one build of the sketch uses
+     *
+     * Resolved from the sketch's includes for each build (see LibraryIndex),
+     * so a library whose #include was removed drops out of the next build.
+     */
+    struct LibraryInputs {
+        std::vector<std::string> include_paths;
+        std::vector<std::string> sources;          // LibraryIndex::Library::sources
     };
     
     using OutputCallback = std::function<void(const std::string&, CompileStatus)>;
@@ -47,8 +96,36 @@ public:
     ~ESP32Compiler();
     
     // Compilation
-    CompileResult Compile(const std::string& code, BoardType board);
-    bool Upload(BoardType board);
+    CompileResult Compile(const std::string& code, BoardType board,
+                          const LibraryInputs& libraries = LibraryInputs());
+    /**
+     * @brief Writes the built image to the board over its serial port
+     *
+     * Flashes sketch.bin, the app image Compile() makes from the linked
+     * ELF, plus bootloader.bin and partitions.bin when the platform put
+     * them in the board's build directory, with EspFlasher. Without a
+     * project_dir there is no image and it fails.
+     */
+    bool Upload(BoardType board, const std::string& port = "");
+    
+    /**
+     * @brief Writes the built image to several boards of one type at once
+     *
+     * The image is read and compressed once for all ports (see FleetFlasher);
+     * a progress line per second and the result table go to the output
+     * callback. Boards that fail do not stop the others.
+     */
+    FleetFlasher::FleetResult UploadFleet(BoardType board, const std::vector<std::string>& ports);
+    
+    /**
+     * @brief Builds the sketch and project for several boards at once
+     *
+     * Uses the BuildSettings of Compile() except board_flags, which come from
+     * each target (see BuildMatrix::MakeTarget). Boards build side by side in
+     * project_dir/.esp32ide/build/matrix/<board_id>; the result table is
+     * also sent to the output callback.
+     */
+    BuildMatrix::MatrixResult CompileMatrix(const std::string& code, const std::vector<BuildMatrix::Target>& targets);
     
     // Board selection
     void SetBoard(BoardType board);
@@ -58,6 +135,17 @@ public:
     // Output callback
     void SetOutputCallback(OutputCallback callback);
     
+    // Build configuration
+    void SetBuildSettings(const BuildSettings& settings);
+    const BuildSettings& GetBuildSettings() const;
+    std::string GetBuildDirectory(BoardType board) const;
+    plugins::CustomCompilerManager& GetCompilerManager();
+    
+    // Objects are shared across projects through a per-user cache
+    ObjectCache& GetObjectCache();
+    void SetObjectCacheEnabled(bool enabled);
+    bool IsObjectCacheEnabled() const;
+    
     // Syntax checking
     bool CheckSyntax(const std::string& code);
     std::vector<std::string> GetSyntaxErrors(const std::string& code);
@@ -74,10 +162,30 @@ public:
     
     PerformanceMetrics AnalyzePerformance(const std::string& code);
     
+    // Memory usage of the last successfully linked image; nullptr before one exists
+    const ElfSizeAnalyzer::SizeReport* GetLastSizeReport() const;
+    // Every relinked image is also appended to SizeHistory::GetDefaultDirectory(project_dir)
+    
 private:
     BoardType current_board_;
     OutputCallback output_callback_;
+    BuildSettings build_settings_;
+    std::unique_ptr<plugins::CustomCompilerManager> compilers_;
+    std::unique_ptr<BuildEngine> build_engine_;
+    std::unique_ptr<ObjectCache> object_cache_;
+    bool object_cache_enabled_;
+    std::unique_ptr<ElfSizeAnalyzer::SizeReport> last_size_report_;
     
+    // Config shared by single-board and matrix builds; writes the sketch
+    bool MakeBuildConfig(const std::string& code, const std::string& build_dir, const LibraryInputs& libraries,
+                         BuildEngine::BuildConfig& config);
+    CompileResult BuildProject(const std::string& code, BoardType board, const LibraryInputs& libraries,
+                               CompileResult result);
+    bool ReportSize(const std::string& image, const std::string& map_file, CompileResult& result);
+    // BuildSettings::flasher_stub for EspFlasher::Options::stub
+    bool LoadFlasherStub(EspFlasher::Options& options, std::string& error) const;
+    // The .bin images in the build directory at their flash offsets
+    bool GetFlashRegions(BoardType board, std::vector<FlashImage::Region>& regions) const;
     void OutputMessage(const std::string& message, CompileStatus status);
     bool CheckBracketBalance(const std::string& code);
     bool CheckRequiredFunctions(const std::string& code);
@@ -0,0 +1,530 @@
+#include "compiler/library_index.h"
+#include "compiler/build_graph.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unordered_set>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// On-disk layout of a saved index (native byte order)
+//   [Header][libraries]
+const char kIndexMagic[4] = {'E', '3', 'L', 'I'};
+const uint32_t kIndexVersion = 2;
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t library_count;
+};
+
+template <typename T>
+void AppendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendString(std::string& out, const std::string& value) {
+    AppendRaw(out, static_cast<uint32_t>(value.size()));
+    out.append(value);
+}
+
+void AppendList(std::string& out, const std::vector<std::string>& values) {
+    AppendRaw(out, static_cast<uint32_t>(values.size()));
+    for (const auto& value : values) {
+        AppendString(out, value);
+    }
+}
+
+template <typename T>
+bool ReadRaw(const unsigned char*& cursor, const unsigned char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+bool ReadString(const unsigned char*& cursor, const unsigned char* end, std::string& value) {
+    uint32_t length = 0;
+    if (!ReadRaw(cursor, end, length) || static_cast<size_t>(end - cursor) < length) {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(cursor), length);
+    cursor += length;
+    return true;
+}
+
+bool ReadList(const unsigned char*& cursor, const unsigned char* end, std::vector<std::string>& values) {
+    uint32_t count = 0;
+    if (!ReadRaw(cursor, end, count)) {
+        return false;
+    }
+    values.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string value;
+        if (!ReadString(cursor, end, value)) {
+            return false;
+        }
+        values.push_back(std::move(value));
+    }
+    return true;
+}
+
+std::string Trim(const std::string& value) {
+    size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) return "";
+    size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+std::vector<std::string> SplitList(const std::string& value) {
+    std::vector<std::string> result;
+    std::istringstream in(value);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        item = Trim(item);
+        if (!item.empty()) {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+std::string ToLower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return value;
+}
+
+bool IsHeader(const fs::path& path) {
+    std::string ext = path.extension().string();
+    return ext == ".h" || ext == ".hpp" || ext == ".hh";
+}
+
+bool IsScanned(const fs::path& path) {
+    std::string ext = path.extension().string();
+    return IsHeader(path) || ext == ".c" || ext == ".cpp" || ext == ".cc" || ext == ".cxx" || ext == ".S";
+}
+
+int64_t GetMtime(const fs::path& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+void ScanIncludes(const fs::path& file, std::unordered_set<std::string>& seen, std::vector<std::string>& includes) {
+    utils::MappedFile mapped;
+    if (!mapped.Open(file.string()) || !mapped.Data()) {
+        return;
+    }
+    auto directives = IncludeScanner::Scan(reinterpret_cast<const char*>(mapped.Data()), mapped.Size());
+    for (const auto& directive : directives) {
+        if (seen.insert(directive.name).second) {
+            includes.push_back(directive.name);
+        }
+    }
+}
+
+// 2 = lists the architecture, 1 = any architecture, 0 = incompatible
+int ArchitectureRank(const LibraryIndex::Library& library, const std::string& architecture) {
+    if (library.architectures.empty()) return 1;
+    if (architecture.empty()) return 1;
+    for (const auto& arch : library.architectures) {
+        if (arch == architecture) return 2;
+    }
+    return 0;
+}
+
+// 3 = folder named like the header, 2 = starts with it, 1 = contains it
+int NameRank(const LibraryIndex::Library& library, const std::string& stem) {
+    int best = 0;
+    for (const std::string* name : {&library.folder, &library.name}) {
+        std::string lower = ToLower(*name);
+        if (lower == stem) return 3;
+        if (lower.compare(0, stem.size(), stem) == 0) best = std::max(best, 2);
+        else if (lower.find(stem) != std::string::npos) best = std::max(best, 1);
+    }
+    return best;
+}
+
+} // namespace
+
+LibraryIndex::LibraryIndex() : dirty_(false) {
+}
+
+void LibraryIndex::AddSearchRoot(const std::string& path, Location location) {
+    roots_.push_back({path, location});
+}
+
+void LibraryIndex::ClearSearchRoots() {
+    roots_.clear();
+}
+
+std::string LibraryIndex::GetArchitecture(const std::string& fqbn) {
+    size_t first = fqbn.find(':');
+    if (first == std::string::npos) return "";
+    size_t second = fqbn.find(':', first + 1);
+    return fqbn.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1);
+}
+
+int64_t LibraryIndex::GetStamp(const std::string& path) {
+    // Every file ReadLibrary may look at, by name and mtime: a directory's
+    // mtime misses edits to existing files and anything in nested folders.
+    // Summed so the stamp does not depend on the directory walk order.
+    fs::path root(path);
+    std::hash<std::string> hash;
+    uint64_t stamp = static_cast<uint64_t>(GetMtime(root / "library.properties"));
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(root, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (it->is_directory(ec)) {
+            // Examples and extras are never compiled into a sketch
+            if ((!name.empty() && name[0] == '.') ||
+                (it.depth() == 0 && (name == "examples" || name == "extras"))) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!IsScanned(it->path())) continue;
+        uint64_t entry = hash(it->path().lexically_relative(root).generic_string());
+        entry ^= static_cast<uint64_t>(GetMtime(it->path())) * 0x9E3779B97F4A7C15ULL;
+        stamp += entry * 0xBF58476D1CE4E5B9ULL + (entry >> 31);
+    }
+    return static_cast<int64_t>(stamp);
+}
+
+bool LibraryIndex::ReadLibrary(const std::string& path, Location location, int64_t stamp, Library& library) {
+    fs::path root(path);
+    std::error_code ec;
+    library.folder = root.filename().string();
+    library.name = library.folder;
+    library.path = path;
+    library.version.clear();
+    library.architectures.clear();
+    library.headers.clear();
+    library.default_includes.clear();
+    library.includes.clear();
+    library.sources.clear();
+    library.location = location;
+    library.stamp = stamp;
+
+    bool has_properties = false;
+    std::ifstream properties(root / "library.properties");
+    if (properties.is_open()) {
+        has_properties = true;
+        std::string line;
+        while (std::getline(properties, line)) {
+            size_t equals = line.find('=');
+            if (equals == std::string::npos || line[0] == '#') continue;
+            std::string key = Trim(line.substr(0, equals));
+            std::string value = Trim(line.substr(equals + 1));
+            if (key == "name" && !value.empty()) {
+                library.name = value;
+            } else if (key == "version") {
+                library.version = value;
+            } else if (key == "architectures") {
+                library.architectures = SplitList(value);
+                if (std::find(library.architectures.begin(), library.architectures.end(), "*") !=
+                    library.architectures.end()) {
+                    library.architectures.clear();
+                }
+            } else if (key == "includes") {
+                library.default_includes = SplitList(value);
+            }
+        }
+    }
+
+    // 1.5 layout: headers and sources under src/, searched recursively;
+    // legacy layout: the root plus its utility/ folder
+    bool recursive = has_properties && fs::is_directory(root / "src", ec);
+    fs::path include_dir = recursive ? root / "src" : root;
+    library.include_dir = include_dir.string();
+
+    std::vector<fs::path> scanned;
+    for (fs::directory_iterator it(include_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        if (IsHeader(it->path())) {
+            library.headers.push_back(it->path().filename().string());
+        }
+        if (IsScanned(it->path())) {
+            scanned.push_back(it->path());
+        }
+    }
+    if (library.headers.empty()) {
+        return false;
+    }
+    std::sort(library.headers.begin(), library.headers.end());
+
+    fs::path nested = recursive ? include_dir : root / "utility";
+    if (fs::is_directory(nested, ec)) {
+        for (fs::recursive_directory_iterator it(nested, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it.depth() == 0 && recursive) continue;
+            if (it->is_regular_file(ec) && IsScanned(it->path())) {
+                scanned.push_back(it->path());
+            }
+        }
+    }
+    std::sort(scanned.begin(), scanned.end());
+    for (const auto& file : scanned) {
+        if (!IsHeader(file)) {
+            library.sources.push_back(file.string());
+        }
+    }
+
+    // Includes of the library's own headers are not dependencies
+    std::unordered_set<std::string> seen(library.headers.begin(), library.headers.end());
+    for (const auto& file : scanned) {
+        ScanIncludes(file, seen, library.includes);
+    }
+
+    if (library.default_includes.empty()) {
+        library.default_includes = library.headers;
+    }
+    return true;
+}
+
+size_t LibraryIndex::Update() {
+    std::unordered_map<std::string, size_t> known;
+    for (size_t i = 0; i < libraries_.size(); ++i) {
+        known[libraries_[i].path] = i;
+    }
+
+    std::vector<Library> updated;
+    std::unordered_set<std::string> visited;
+    size_t changes = 0;
+    size_t revisited = 0;
+    for (const auto& root : roots_) {
+        std::error_code ec;
+        std::vector<fs::path> folders;
+        for (fs::directory_iterator it(root.path, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string folder = it->path().filename().string();
+            if (folder.empty() || folder[0] == '.' || !it->is_directory(ec)) continue;
+            folders.push_back(it->path());
+        }
+        std::sort(folders.begin(), folders.end());
+
+        for (const auto& folder : folders) {
+            std::string path = folder.string();
+            if (!visited.insert(path).second) continue;
+            int64_t stamp = GetStamp(path);
+            auto found = known.find(path);
+            if (found != known.end()) {
+                revisited++;
+                if (libraries_[found->second].stamp == stamp && libraries_[found->second].location == root.location) {
+                    updated.push_back(std::move(libraries_[found->second]));
+                    continue;
+                }
+            }
+            Library library;
+            if (ReadLibrary(path, root.location, stamp, library)) {
+                updated.push_back(std::move(library));
+                changes++;
+            } else if (found != known.end()) {
+                changes++;
+            }
+        }
+    }
+    // Libraries that disappeared, or whose root is no longer searched
+    changes += libraries_.size() - revisited;
+
+    libraries_ = std::move(updated);
+    if (changes) {
+        dirty_ = true;
+    }
+    RebuildHeaderMap();
+    return changes;
+}
+
+void LibraryIndex::RebuildHeaderMap() {
+    by_header_.clear();
+    for (size_t i = 0; i < libraries_.size(); ++i) {
+        for (const auto& header : libraries_[i].headers) {
+            by_header_[header].push_back(i);
+        }
+    }
+}
+
+const LibraryIndex::Library* LibraryIndex::FindLibrary(const std::string& name) const {
+    const Library* by_name = nullptr;
+    for (const auto& library : libraries_) {
+        if (library.folder == name) return &library;
+        if (!by_name && library.name == name) by_name = &library;
+    }
+    return by_name;
+}
+
+std::vector<const LibraryIndex::Library*> LibraryIndex::GetCandidates(const std::string& header) const {
+    std::vector<const Library*> result;
+    auto it = by_header_.find(header);
+    if (it != by_header_.end()) {
+        for (size_t index : it->second) {
+            result.push_back(&libraries_[index]);
+        }
+    }
+    return result;
+}
+
+const LibraryIndex::Library* LibraryIndex::Resolve(const std::string& header, const std::string& architecture) const {
+    auto it = by_header_.find(header);
+    if (it == by_header_.end()) {
+        return nullptr;
+    }
+    std::string stem = ToLower(fs::path(header).stem().string());
+    const Library* best = nullptr;
+    int best_arch = 0;
+    int best_name = 0;
+    for (size_t index : it->second) {
+        const Library& library = libraries_[index];
+        int arch = ArchitectureRank(library, architecture);
+        if (arch == 0) continue;
+        int name = NameRank(library, stem);
+        bool better = !best;
+        if (!better && arch != best_arch) better = arch > best_arch;
+        else if (!better && name != best_name) better = name > best_name;
+        else if (!better && library.location != best->location) better = library.location > best->location;
+        else if (!better) better = library.folder < best->folder;
+        if (better) {
+            best = &library;
+            best_arch = arch;
+            best_name = name;
+        }
+    }
+    return best;
+}
+
+LibraryIndex::Resolution LibraryIndex::ResolveIncludes(const std::vector<std::string>& headers,
+                                                       const std::string& architecture) const {
+    Resolution resolution;
+    std::unordered_set<std::string> seen;
+    std::unordered_set<const Library*> added;
+    // The sketch's own includes are queued first, so a header it names is
+    // reported unresolved even when a library also includes it
+    std::deque<std::pair<std::string, bool>> pending;
+    for (const auto& header : headers) {
+        pending.emplace_back(header, true);
+    }
+    while (!pending.empty()) {
+        std::string header = std::move(pending.front().first);
+        bool from_sketch = pending.front().second;
+        pending.pop_front();
+        if (!seen.insert(header).second) continue;
+
+        const Library* library = Resolve(header, architecture);
+        if (!library) {
+            if (from_sketch) resolution.unresolved.push_back(header);
+            continue;
+        }
+        if (added.insert(library).second) {
+            resolution.libraries.push_back(library);
+            for (const auto& include : library->includes) {
+                pending.emplace_back(include, false);
+            }
+        }
+    }
+    return resolution;
+}
+
+LibraryIndex::Resolution LibraryIndex::ResolveSource(const std::string& content, const std::string& architecture) const {
+    std::vector<std::string> headers;
+    for (const auto& directive : IncludeScanner::Scan(content)) {
+        headers.push_back(directive.name);
+    }
+    return ResolveIncludes(headers, architecture);
+}
+
+bool LibraryIndex::Save(const std::string& path) {
+    std::string body;
+    for (const auto& library : libraries_) {
+        AppendString(body, library.name);
+        AppendString(body, library.folder);
+        AppendString(body, library.path);
+        AppendString(body, library.include_dir);
+        AppendString(body, library.version);
+        AppendList(body, library.architectures);
+        AppendList(body, library.headers);
+        AppendList(body, library.default_includes);
+        AppendList(body, library.includes);
+        AppendList(body, library.sources);
+        AppendRaw(body, static_cast<uint8_t>(library.location));
+        AppendRaw(body, library.stamp);
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.library_count = static_cast<uint32_t>(libraries_.size());
+
+    std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(body.data(), static_cast<std::streamsize>(body.size()));
+        if (!out.good()) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool LibraryIndex::Load(const std::string& path) {
+    libraries_.clear();
+    by_header_.clear();
+    dirty_ = false;
+
+    utils::MappedFile file;
+    if (!file.Open(path)) {
+        return false;
+    }
+
+    const unsigned char* cursor = file.Data();
+    const unsigned char* end = cursor + file.Size();
+
+    IndexHeader header;
+    if (!cursor || !ReadRaw(cursor, end, header) ||
+        std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) != 0 ||
+        header.version != kIndexVersion) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.library_count; ++i) {
+        Library library;
+        uint8_t location = 0;
+        if (!ReadString(cursor, end, library.name) || !ReadString(cursor, end, library.folder) ||
+            !ReadString(cursor, end, library.path) || !ReadString(cursor, end, library.include_dir) ||
+            !ReadString(cursor, end, library.version) || !ReadList(cursor, end, library.architectures) ||
+            !ReadList(cursor, end, library.headers) || !ReadList(cursor, end, library.default_includes) ||
+            !ReadList(cursor, end, library.includes) || !ReadList(cursor, end, library.sources) ||
+            !ReadRaw(cursor, end, location) ||
+            !ReadRaw(cursor, end, library.stamp) || location > static_cast<uint8_t>(Location::PROJECT)) {
+            libraries_.clear();
+            return false;
+        }
+        library.location = static_cast<Location>(location);
+        libraries_.push_back(std::move(library));
+    }
+    RebuildHeaderMap();
+    return true;
+}
+
+} // namespace esp32_ide
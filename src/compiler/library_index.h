@@ -0,0 +1,112 @@
+#ifndef LIBRARY_INDEX_H
+#define LIBRARY_INDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Persistent header -> library index over Arduino library folders
+ *
+ * Each search root is a folder of libraries ("libraries/" in the
+ * sketchbook, a core or the IDE). A library is read from its
+ * library.properties (name, version, architectures, includes) and its
+ * include directory: src/ for the 1.5 layout, the library root for the
+ * legacy one. Its sources are what Arduino compiles: everything under
+ * src/, or the root's own files plus utility/, never examples/ or test/. The index records the headers each library exposes and the
+ * includes its own files make, so a sketch's libraries, and theirs, are
+ * found by following includes through the index instead of probing every
+ * library on every build.
+ *
+ * Update() re-reads only libraries where a source file or
+ * library.properties was added, removed or modified since the index was
+ * saved. When several libraries
+ * provide a header the one used is, in order:
+ *   1. compatible with the architecture; libraries listing it explicitly
+ *      win over "*" (incompatible ones are never picked)
+ *   2. named like the header: folder "Servo" for Servo.h, then a folder
+ *      starting with the header name ("Servo-master"), then containing it
+ *   3. from the higher-priority location (project, user, platform, builtin)
+ *   4. the name first in alphabetical order, so the choice is stable
+ */
+class LibraryIndex {
+public:
+    enum class Location {
+        BUILTIN,    // bundled with the IDE
+        PLATFORM,   // bundled with a board core
+        USER,       // sketchbook libraries
+        PROJECT     // libraries/ inside the project
+    };
+
+    struct Library {
+        std::string name;                        // library.properties name, else the folder name
+        std::string folder;                      // folder name
+        std::string path;
+        std::string include_dir;                 // added to the include path
+        std::string version;
+        std::vector<std::string> architectures;  // empty = any
+        std::vector<std::string> headers;        // includable headers, by file name
+        std::vector<std::string> default_includes;  // "includes" property, else every header
+        std::vector<std::string> includes;       // headers its own files include
+        std::vector<std::string> sources;        // translation units built with a sketch using it
+        Location location;
+        int64_t stamp;                           // file names and mtimes when read
+    };
+
+    struct Resolution {
+        std::vector<const Library*> libraries;   // in discovery order, each once
+        std::vector<std::string> unresolved;     // core, system and project headers
+    };
+
+    LibraryIndex();
+
+    void AddSearchRoot(const std::string& path, Location location);
+    void ClearSearchRoots();
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path);
+
+    /**
+     * @brief Brings the index up to date with the search roots
+     * @return Number of libraries (re)read or dropped
+     */
+    size_t Update();
+
+    const Library* FindLibrary(const std::string& name) const;
+    // Library providing header for the architecture ("esp32", "avr", ...); empty matches any
+    const Library* Resolve(const std::string& header, const std::string& architecture) const;
+    std::vector<const Library*> GetCandidates(const std::string& header) const;
+
+    // Follows includes from the sketch through the libraries they pull in
+    Resolution ResolveIncludes(const std::vector<std::string>& headers, const std::string& architecture) const;
+    Resolution ResolveSource(const std::string& content, const std::string& architecture) const;
+
+    size_t GetLibraryCount() const { return libraries_.size(); }
+    const std::vector<Library>& GetLibraries() const { return libraries_; }
+    bool IsDirty() const { return dirty_; }
+
+    // "esp32" from "esp32:esp32:esp32"
+    static std::string GetArchitecture(const std::string& fqbn);
+
+private:
+    struct SearchRoot {
+        std::string path;
+        Location location;
+    };
+
+    std::vector<SearchRoot> roots_;
+    std::vector<Library> libraries_;
+    std::unordered_map<std::string, std::vector<size_t>> by_header_;
+    bool dirty_;
+
+    void RebuildHeaderMap();
+    static bool ReadLibrary(const std::string& path, Location location, int64_t stamp, Library& library);
+    static int64_t GetStamp(const std::string& path);
+};
+
+} // namespace esp32_ide
+
+#endif // LIBRARY_INDEX_H
@@ -0,0 +1,314 @@
+#include "compiler/object_cache.h"
+#include "utils/blob_store.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint64_t kKeySeedHigh = 0x3c6ef372fe94f82bULL;
+
+// Bumped whenever the key derivation changes
+const char kKeyVersion[] = "esp32ide-objcache-2";
+
+std::string Hex64(uint64_t value) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        out[i] = digits[value & 0xF];
+        value >>= 4;
+    }
+    return out;
+}
+
+bool IsPreprocessorFlag(const std::string& flag) {
+    return flag.compare(0, 2, "-I") == 0 || flag.compare(0, 2, "-D") == 0 ||
+           flag.compare(0, 2, "-U") == 0;
+}
+
+std::string ResolveExecutable(const std::string& name) {
+    if (name.find('/') != std::string::npos) return name;
+    const char* path = std::getenv("PATH");
+    if (!path) return name;
+
+    std::istringstream dirs(path);
+    std::string dir;
+    std::error_code ec;
+    while (std::getline(dirs, dir, ':')) {
+        fs::path candidate = fs::path(dir.empty() ? "." : dir) / name;
+        if (fs::is_regular_file(candidate, ec)) return candidate.string();
+    }
+    return name;
+}
+
+bool ReadFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    std::ostringstream buffer;
+    buffer << in.rdbuf();
+    out = buffer.str();
+    return true;
+}
+
+// Publishes a file atomically so concurrent readers never see a partial entry
+bool WriteAtomically(const std::string& path, const std::string& source_path, const std::string* content) {
+    static std::atomic<uint64_t> counter(0);
+    std::string tmp_path = path + ".tmp" +
+        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "_" +
+        std::to_string(counter++);
+    std::error_code ec;
+    if (content) {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return false;
+        out << *content;
+        if (!out.good()) {
+            out.close();
+            fs::remove(tmp_path, ec);
+            return false;
+        }
+    } else if (!fs::copy_file(source_path, tmp_path, fs::copy_options::overwrite_existing, ec)) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    fs::rename(tmp_path, path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ObjectCache::ObjectCache(const std::string& directory, uint64_t max_bytes)
+    : directory_(directory), max_bytes_(max_bytes), size_known_(false),
+      total_bytes_(0), entry_count_(0), hits_(0), misses_(0), stores_(0), evictions_(0) {
+}
+
+std::string ObjectCache::GetDefaultDirectory() {
+    if (const char* dir = std::getenv("ESP32_IDE_CACHE_DIR")) {
+        if (*dir) return dir;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        if (*xdg) return (fs::path(xdg) / "esp32-ide" / "objects").string();
+    }
+    if (const char* home = std::getenv("HOME")) {
+        if (*home) return (fs::path(home) / ".cache" / "esp32-ide" / "objects").string();
+    }
+    std::error_code ec;
+    return (fs::temp_directory_path(ec) / "esp32-ide-objects").string();
+}
+
+uint64_t ObjectCache::GetCompilerIdentity(const std::string& compiler_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = compiler_identities_.find(compiler_path);
+        if (it != compiler_identities_.end()) return it->second;
+    }
+
+    // A toolchain upgrade replaces the binary, which changes size or mtime
+    std::string resolved = ResolveExecutable(compiler_path);
+    std::string identity = resolved;
+    std::error_code ec;
+    fs::path canonical = fs::canonical(resolved, ec);
+    if (!ec) {
+        identity = canonical.string();
+        uint64_t size = fs::file_size(canonical, ec);
+        identity += "|" + std::to_string(ec ? 0 : size);
+        auto mtime = fs::last_write_time(canonical, ec);
+        identity += "|" + std::to_string(ec ? 0 : mtime.time_since_epoch().count());
+    }
+    uint64_t hash = utils::BlobStore::HashContent(identity.data(), identity.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    compiler_identities_[compiler_path] = hash;
+    return hash;
+}
+
+std::string ObjectCache::ComputeKey(const std::string& preprocessed,
+                                    const std::string& compiler_path,
+                                    const std::vector<std::string>& flags,
+                                    const std::string& board_flags) {
+    std::string header = kKeyVersion;
+    header.push_back('\0');
+    uint64_t compiler = GetCompilerIdentity(compiler_path);
+    header.append(reinterpret_cast<const char*>(&compiler), sizeof(compiler));
+    for (size_t i = 0; i < flags.size(); ++i) {
+        // A forced include's operand may be a path in the build directory
+        // (the precompiled header stub); its text is keyed already
+        if (flags[i] == "-include") {
+            ++i;
+            continue;
+        }
+        // Only reports on a .gch; whether one was used is keyed by the caller
+        if (IsPreprocessorFlag(flags[i]) || flags[i] == "-Winvalid-pch") continue;
+        header += flags[i];
+        header.push_back('\0');
+    }
+    header.push_back('\0');
+    header += board_flags;
+
+    uint64_t text_low = utils::BlobStore::HashContent(preprocessed.data(), preprocessed.size());
+    uint64_t text_high = utils::BlobStore::HashContent(preprocessed.data(), preprocessed.size(), kKeySeedHigh);
+    header.append(reinterpret_cast<const char*>(&text_low), sizeof(text_low));
+    header.append(reinterpret_cast<const char*>(&text_high), sizeof(text_high));
+
+    return Hex64(utils::BlobStore::HashContent(header.data(), header.size())) +
+           Hex64(utils::BlobStore::HashContent(header.data(), header.size(), kKeySeedHigh));
+}
+
+std::string ObjectCache::GetEntryPath(const std::string& key, const char* extension) const {
+    // Two-level fan-out keeps directories small
+    return (fs::path(directory_) / key.substr(0, 2) / (key.substr(2) + extension)).string();
+}
+
+bool ObjectCache::Fetch(const std::string& key, const std::string& object_path, std::string& output) {
+    std::string entry = GetEntryPath(key, ".o");
+    std::error_code ec;
+    output.clear();
+
+    // Copy rather than hard-link: the compiler rewrites objects in place
+    if (key.size() < 3 || !fs::copy_file(entry, object_path, fs::copy_options::overwrite_existing, ec)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        misses_++;
+        return false;
+    }
+    ReadFile(GetEntryPath(key, ".log"), output);
+
+    // Refresh the entry for LRU eviction
+    fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    hits_++;
+    return true;
+}
+
+bool ObjectCache::Store(const std::string& key, const std::string& object_path, const std::string& output) {
+    if (key.size() < 3) return false;
+    std::string entry = GetEntryPath(key, ".o");
+    std::error_code ec;
+    fs::create_directories(fs::path(entry).parent_path(), ec);
+    if (ec) return false;
+
+    if (!output.empty() && !WriteAtomically(GetEntryPath(key, ".log"), std::string(), &output)) {
+        return false;
+    }
+    // The object is published last; Fetch keys off its presence
+    if (!WriteAtomically(entry, object_path, nullptr)) {
+        return false;
+    }
+    uint64_t size = fs::file_size(entry, ec);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stores_++;
+    if (!size_known_) {
+        ScanSizeLocked();
+    } else {
+        total_bytes_ += (ec ? 0 : size) + output.size();
+        entry_count_++;
+    }
+    if (total_bytes_ > max_bytes_) {
+        EvictLocked();
+    }
+    return true;
+}
+
+void ObjectCache::ScanSizeLocked() {
+    total_bytes_ = 0;
+    entry_count_ = 0;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(directory_, ec);
+    fs::recursive_directory_iterator end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec)) continue;
+        total_bytes_ += it->file_size(ec);
+        if (it->path().extension() == ".o") entry_count_++;
+    }
+    size_known_ = true;
+}
+
+void ObjectCache::EvictLocked() {
+    struct Entry {
+        fs::file_time_type mtime;
+        fs::path path;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(directory_, ec);
+    fs::recursive_directory_iterator end;
+    for (; !ec && it != end; it.increment(ec)) {
+        if (!it->is_regular_file(ec) || it->path().extension() != ".o") continue;
+        Entry entry;
+        entry.path = it->path();
+        entry.mtime = it->last_write_time(ec);
+        entry.size = it->file_size(ec);
+        fs::path log = entry.path;
+        log.replace_extension(".log");
+        std::error_code log_ec;
+        uint64_t log_size = fs::file_size(log, log_ec);
+        if (!log_ec) entry.size += log_size;
+        entries.push_back(std::move(entry));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+
+    // Trim to 90% so eviction does not run on every store near the limit
+    uint64_t total = 0;
+    for (const auto& entry : entries) total += entry.size;
+    uint64_t target = max_bytes_ / 10 * 9;
+    size_t remaining = entries.size();
+    for (const auto& entry : entries) {
+        if (total <= target) break;
+        fs::path log = entry.path;
+        log.replace_extension(".log");
+        fs::remove(entry.path, ec);
+        fs::remove(log, ec);
+        total -= entry.size;
+        remaining--;
+        evictions_++;
+    }
+    total_bytes_ = total;
+    entry_count_ = remaining;
+}
+
+bool ObjectCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code ec;
+    fs::remove_all(directory_, ec);
+    total_bytes_ = 0;
+    entry_count_ = 0;
+    size_known_ = true;
+    return !ec;
+}
+
+void ObjectCache::SetMaxSize(uint64_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    if (!size_known_) ScanSizeLocked();
+    if (total_bytes_ > max_bytes_) EvictLocked();
+}
+
+ObjectCache::Stats ObjectCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!size_known_) ScanSizeLocked();
+    Stats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.stores = stores_;
+    stats.evictions = evictions_;
+    stats.entry_count = entry_count_;
+    stats.total_bytes = total_bytes_;
+    return stats;
+}
+
+} // namespace esp32_ide
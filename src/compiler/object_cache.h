@@ -0,0 +1,94 @@
+#ifndef OBJECT_CACHE_H
+#define OBJECT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Local, size-bounded cache of compiled objects
+ *
+ * Works like ccache in preprocessor mode: an object is keyed by the hash
+ * of the preprocessed translation unit, the compiler's identity (resolved
+ * path, size and mtime of the binary), the flags that survive
+ * preprocessing and the board's compiler flags. Because paths to the
+ * sketch and build directory are not part of the key, an unchanged core
+ * compiled for one sketch is reused by every other sketch on the machine.
+ *
+ * Entries are files under the cache directory; compiler output is stored
+ * alongside so warnings are replayed on a hit. A hit refreshes the
+ * entry's mtime and the oldest entries are evicted once the directory
+ * exceeds its size limit. Writes go through a temporary file and a
+ * rename, so several IDE processes can share one cache. Thread-safe.
+ */
+class ObjectCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t stores;
+        uint64_t evictions;
+        uint64_t entry_count;
+        uint64_t total_bytes;
+    };
+
+    static const uint64_t kDefaultMaxBytes = 2ULL * 1024 * 1024 * 1024;
+
+    explicit ObjectCache(const std::string& directory = GetDefaultDirectory(),
+                         uint64_t max_bytes = kDefaultMaxBytes);
+
+    /**
+     * @brief Cache key for one compile
+     *
+     * @param flags Compile flags; -I/-D/-U and -include <file> are ignored
+     *              since their effect is already in the preprocessed text,
+     *              and so is -Winvalid-pch
+     * @return 32 hex digits
+     */
+    std::string ComputeKey(const std::string& preprocessed,
+                           const std::string& compiler_path,
+                           const std::vector<std::string>& flags,
+                           const std::string& board_flags);
+
+    // Copies a cached object to object_path; output receives the stored log
+    bool Fetch(const std::string& key, const std::string& object_path, std::string& output);
+    bool Store(const std::string& key, const std::string& object_path, const std::string& output);
+
+    bool Clear();
+    void SetMaxSize(uint64_t max_bytes);
+    uint64_t GetMaxSize() const { return max_bytes_; }
+    const std::string& GetDirectory() const { return directory_; }
+    Stats GetStats();
+
+    // Resolved path, size and mtime of the compiler binary, hashed
+    uint64_t GetCompilerIdentity(const std::string& compiler_path);
+
+    // $ESP32_IDE_CACHE_DIR, then $XDG_CACHE_HOME/esp32-ide/objects, then ~/.cache
+    static std::string GetDefaultDirectory();
+
+private:
+    std::string directory_;
+    uint64_t max_bytes_;
+
+    std::mutex mutex_;
+    std::map<std::string, uint64_t> compiler_identities_;
+    bool size_known_;
+    uint64_t total_bytes_;
+    uint64_t entry_count_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t stores_;
+    uint64_t evictions_;
+
+    std::string GetEntryPath(const std::string& key, const char* extension) const;
+    void ScanSizeLocked();
+    void EvictLocked();
+};
+
+} // namespace esp32_ide
+
+#endif // OBJECT_CACHE_H
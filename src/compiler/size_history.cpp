@@ -0,0 +1,587 @@
+#include "compiler/size_history.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kIndexMagic[4] = {'E', '3', 'S', 'I'};
+const char kDictionaryMagic[4] = {'E', '3', 'S', 'D'};
+const char kColumnsMagic[4] = {'E', '3', 'S', 'C'};
+const uint32_t kHistoryVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t reserved;
+};
+
+const size_t kRevisionLength = 40;
+
+void AppendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool ReadVarint(const unsigned char*& cursor, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+        unsigned char byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+template <typename T>
+void AppendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool HasHeader(const utils::MappedFile& file, const char* magic) {
+    FileHeader header;
+    if (file.Size() < sizeof(header)) return false;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    return std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == kHistoryVersion;
+}
+
+// Creates an empty file with its header, or checks the existing one
+bool PrepareFile(const std::string& path, const char* magic) {
+    std::error_code ec;
+    if (fs::exists(path, ec) && fs::file_size(path, ec) > 0) {
+        utils::MappedFile file;
+        return file.Open(path) && HasHeader(file, magic);
+    }
+    FileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = kHistoryVersion;
+    header.reserved = 0;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out.good();
+}
+
+bool AppendToFile(const std::string& path, const std::string& data) {
+    if (data.empty()) return true;
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return out.good();
+}
+
+// Drops whatever an interrupted Record() left past the committed data
+bool TrimFile(const std::string& path, uint64_t size) {
+    std::error_code ec;
+    if (fs::file_size(path, ec) == size) return true;
+    fs::resize_file(path, size, ec);
+    return !ec;
+}
+
+std::string ReadFirstLine(const fs::path& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+    return line;
+}
+
+bool IsCommitHash(const std::string& text) {
+    if (text.size() != kRevisionLength) return false;
+    return std::all_of(text.begin(), text.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+bool IsNumber(const std::string& text) {
+    return !text.empty() && text.size() < 10 &&
+           std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+// Locates the id, size and region columns of a build's segment: two 32-bit
+// column lengths, then the columns; false unless every length fits the file
+bool SplitSegment(const utils::MappedFile& file, uint64_t offset, uint64_t bytes, uint64_t symbol_count,
+                  const unsigned char*& ids, const unsigned char*& ids_end, const unsigned char*& sizes_end) {
+    if (bytes < 2 * sizeof(uint32_t) || offset > file.Size() || bytes > file.Size() - offset) {
+        return false;
+    }
+    const unsigned char* segment = file.Data() + offset;
+    uint32_t ids_bytes;
+    uint32_t sizes_bytes;
+    std::memcpy(&ids_bytes, segment, sizeof(ids_bytes));
+    std::memcpy(&sizes_bytes, segment + sizeof(ids_bytes), sizeof(sizes_bytes));
+    if (2 * sizeof(uint32_t) + static_cast<uint64_t>(ids_bytes) + sizes_bytes + symbol_count != bytes) {
+        return false;
+    }
+    ids = segment + 2 * sizeof(uint32_t);
+    ids_end = ids + ids_bytes;
+    sizes_end = ids_end + sizes_bytes;
+    return true;
+}
+
+} // namespace
+
+struct SizeHistory::IndexRow {
+    int64_t timestamp;
+    uint64_t segment_offset;
+    uint32_t segment_bytes;
+    uint32_t symbol_count;
+    uint32_t board_id;          // position in symbols.dict
+    uint32_t reserved;
+    uint64_t flash_bytes;
+    uint64_t ram_bytes;
+    uint64_t region_bytes[ElfSizeAnalyzer::kRegionCount];
+    char revision[kRevisionLength];
+};
+
+SizeHistory::SizeHistory(const std::string& directory)
+    : directory_(directory), names_bytes_(0) {
+}
+
+std::string SizeHistory::GetDefaultDirectory(const std::string& project_dir) {
+    return (fs::path(project_dir.empty() ? "." : project_dir) / ".esp32ide" / "size_history").string();
+}
+
+std::string SizeHistory::ReadGitRevision(const std::string& project_dir) {
+    std::error_code ec;
+    fs::path dir = fs::absolute(project_dir.empty() ? "." : project_dir, ec);
+    fs::path git_dir;
+    for (; !dir.empty(); dir = dir.parent_path()) {
+        fs::path candidate = dir / ".git";
+        if (fs::is_directory(candidate, ec)) {
+            git_dir = candidate;
+            break;
+        }
+        // Worktrees and submodules: "gitdir: <path>"
+        if (fs::is_regular_file(candidate, ec)) {
+            std::string line = ReadFirstLine(candidate);
+            if (line.compare(0, 8, "gitdir: ") == 0) {
+                git_dir = fs::path(line.substr(8));
+                if (git_dir.is_relative()) git_dir = dir / git_dir;
+            }
+            break;
+        }
+        if (dir == dir.parent_path()) break;
+    }
+    if (git_dir.empty()) return "";
+
+    std::string head = ReadFirstLine(git_dir / "HEAD");
+    if (head.compare(0, 5, "ref: ") != 0) {
+        return IsCommitHash(head) ? head : "";
+    }
+    std::string ref = head.substr(5);
+    std::string hash = ReadFirstLine(git_dir / ref);
+    if (IsCommitHash(hash)) return hash;
+
+    // Refs moved into packed-refs by git gc, possibly in the common dir
+    fs::path common = git_dir;
+    std::string common_dir = ReadFirstLine(git_dir / "commondir");
+    if (!common_dir.empty()) common = fs::path(common_dir).is_relative() ? git_dir / common_dir : fs::path(common_dir);
+    hash = ReadFirstLine(common / ref);
+    if (IsCommitHash(hash)) return hash;
+    std::ifstream packed(common / "packed-refs");
+    std::string line;
+    while (std::getline(packed, line)) {
+        if (line.size() == kRevisionLength + 1 + ref.size() &&
+            line.compare(kRevisionLength + 1, std::string::npos, ref) == 0) {
+            return line.substr(0, kRevisionLength);
+        }
+    }
+    return "";
+}
+
+std::string SizeHistory::GetIndexPath() const {
+    return directory_ + "/builds.idx";
+}
+
+std::string SizeHistory::GetDictionaryPath() const {
+    return directory_ + "/symbols.dict";
+}
+
+std::string SizeHistory::GetColumnsPath() const {
+    return directory_ + "/sizes.col";
+}
+
+bool SizeHistory::Fail(const std::string& message) const {
+    error_ = message;
+    return false;
+}
+
+bool SizeHistory::LoadNames() const {
+    utils::MappedFile file;
+    if (!file.Open(GetDictionaryPath())) {
+        names_.clear();
+        names_bytes_ = 0;
+        return true;
+    }
+    if (!HasHeader(file, kDictionaryMagic)) {
+        return Fail("Not a size history dictionary: " + GetDictionaryPath());
+    }
+    // Append-only, so only the tail past what was parsed last time is new
+    if (names_bytes_ < sizeof(FileHeader) || names_bytes_ > file.Size()) {
+        names_.clear();
+        names_bytes_ = sizeof(FileHeader);
+    }
+    const unsigned char* cursor = file.Data() + names_bytes_;
+    const unsigned char* end = file.Data() + file.Size();
+    while (static_cast<size_t>(end - cursor) >= sizeof(uint32_t)) {
+        uint32_t length;
+        std::memcpy(&length, cursor, sizeof(length));
+        if (static_cast<size_t>(end - cursor) - sizeof(length) < length) break;
+        names_.emplace_back(reinterpret_cast<const char*>(cursor + sizeof(length)), length);
+        cursor += sizeof(length) + length;
+    }
+    names_bytes_ = static_cast<uint64_t>(cursor - file.Data());
+    return true;
+}
+
+uint32_t SizeHistory::InternName(const std::string& name, std::string& appended) {
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(name);
+    name_ids_.emplace(name, id);
+    AppendRaw(appended, static_cast<uint32_t>(name.size()));
+    appended += name;
+    return id;
+}
+
+bool SizeHistory::Record(const ElfSizeAnalyzer::SizeReport& report, const std::string& board,
+                         const std::string& revision, int64_t timestamp) {
+    std::error_code ec;
+    fs::create_directories(directory_, ec);
+    if (!PrepareFile(GetIndexPath(), kIndexMagic) || !PrepareFile(GetDictionaryPath(), kDictionaryMagic) ||
+        !PrepareFile(GetColumnsPath(), kColumnsMagic)) {
+        return Fail("Cannot open size history in " + directory_);
+    }
+    if (!LoadNames()) return false;
+    if (name_ids_.size() > names_.size()) name_ids_.clear();
+    for (size_t i = name_ids_.size(); i < names_.size(); ++i) {
+        name_ids_.emplace(names_[i], static_cast<uint32_t>(i));
+    }
+
+    // Everything past the last committed row is from an interrupted write
+    size_t count = GetBuildCount();
+    uint64_t columns_end = sizeof(FileHeader);
+    IndexRow last;
+    if (count > 0 && ReadRow(static_cast<uint32_t>(count - 1), last)) {
+        columns_end = last.segment_offset + last.segment_bytes;
+    }
+    if (!TrimFile(GetIndexPath(), sizeof(FileHeader) + count * sizeof(IndexRow)) ||
+        !TrimFile(GetDictionaryPath(), names_bytes_) || !TrimFile(GetColumnsPath(), columns_end)) {
+        return Fail("Cannot repair size history in " + directory_);
+    }
+
+    std::string new_names;
+    IndexRow row;
+    std::memset(&row, 0, sizeof(row));
+    row.timestamp = timestamp ? timestamp : static_cast<int64_t>(std::time(nullptr));
+    row.board_id = InternName(board, new_names);
+    row.flash_bytes = report.flash_bytes;
+    row.ram_bytes = report.ram_bytes;
+    std::copy(report.region_bytes, report.region_bytes + ElfSizeAnalyzer::kRegionCount, row.region_bytes);
+    std::memcpy(row.revision, revision.data(), std::min(revision.size(), kRevisionLength));
+
+    struct Entry {
+        uint32_t id;
+        uint64_t size;
+        uint8_t region;
+    };
+    std::vector<Entry> entries;
+    std::unordered_map<uint32_t, size_t> positions;
+    entries.reserve(report.symbols.size());
+    for (const auto& symbol : report.symbols) {
+        uint32_t id = InternName(symbol.name, new_names);
+        auto inserted = positions.emplace(id, entries.size());
+        if (inserted.second) {
+            entries.push_back({id, symbol.size, static_cast<uint8_t>(symbol.region)});
+        } else {
+            entries[inserted.first->second].size += symbol.size;
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.id < b.id; });
+
+    std::string ids;
+    std::string sizes;
+    uint32_t previous = 0;
+    for (const auto& entry : entries) {
+        AppendVarint(ids, entry.id - previous);
+        AppendVarint(sizes, entry.size);
+        previous = entry.id;
+    }
+    std::string segment;
+    AppendRaw(segment, static_cast<uint32_t>(ids.size()));
+    AppendRaw(segment, static_cast<uint32_t>(sizes.size()));
+    segment += ids;
+    segment += sizes;
+    for (const auto& entry : entries) segment += static_cast<char>(entry.region);
+
+    row.segment_offset = columns_end;
+    row.segment_bytes = static_cast<uint32_t>(segment.size());
+    row.symbol_count = static_cast<uint32_t>(entries.size());
+
+    std::string row_bytes;
+    AppendRaw(row_bytes, row);
+    if (!AppendToFile(GetDictionaryPath(), new_names) || !AppendToFile(GetColumnsPath(), segment) ||
+        !AppendToFile(GetIndexPath(), row_bytes)) {
+        // Reloaded from disk next time
+        names_.clear();
+        name_ids_.clear();
+        names_bytes_ = 0;
+        return Fail("Cannot write size history in " + directory_);
+    }
+    names_bytes_ += new_names.size();
+    return true;
+}
+
+size_t SizeHistory::GetBuildCount() const {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(GetIndexPath(), ec);
+    if (ec || size < sizeof(FileHeader)) return 0;
+    return static_cast<size_t>((size - sizeof(FileHeader)) / sizeof(IndexRow));
+}
+
+bool SizeHistory::ReadRow(uint32_t id, IndexRow& row) const {
+    std::ifstream in(GetIndexPath(), std::ios::binary);
+    FileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) != 0 || header.version != kHistoryVersion) {
+        return Fail("No size history in " + directory_);
+    }
+    in.seekg(static_cast<std::streamoff>(sizeof(FileHeader) + static_cast<uint64_t>(id) * sizeof(IndexRow)));
+    if (!in.read(reinterpret_cast<char*>(&row), sizeof(row))) {
+        return Fail("No build " + std::to_string(id));
+    }
+    return true;
+}
+
+SizeHistory::BuildRecord SizeHistory::ToRecord(uint32_t id, const IndexRow& row) const {
+    BuildRecord record;
+    record.id = id;
+    record.timestamp = row.timestamp;
+    record.board = row.board_id < names_.size() ? names_[row.board_id] : "";
+    record.revision.assign(row.revision, std::find(row.revision, row.revision + kRevisionLength, '\0'));
+    std::copy(row.region_bytes, row.region_bytes + ElfSizeAnalyzer::kRegionCount, record.region_bytes);
+    record.flash_bytes = row.flash_bytes;
+    record.ram_bytes = row.ram_bytes;
+    record.symbol_count = row.symbol_count;
+    return record;
+}
+
+bool SizeHistory::GetBuild(uint32_t id, BuildRecord& record) const {
+    IndexRow row;
+    if (!ReadRow(id, row) || !LoadNames()) return false;
+    record = ToRecord(id, row);
+    return true;
+}
+
+std::vector<SizeHistory::BuildRecord> SizeHistory::GetBuilds(size_t first, size_t count) const {
+    std::vector<BuildRecord> records;
+    utils::MappedFile file;
+    if (!file.Open(GetIndexPath()) || !HasHeader(file, kIndexMagic) || !LoadNames()) {
+        return records;
+    }
+    size_t total = (file.Size() - sizeof(FileHeader)) / sizeof(IndexRow);
+    size_t last = first < total ? first + std::min(count, total - first) : first;
+    for (size_t id = first; id < last; ++id) {
+        IndexRow row;
+        std::memcpy(&row, file.Data() + sizeof(FileHeader) + id * sizeof(IndexRow), sizeof(row));
+        records.push_back(ToRecord(static_cast<uint32_t>(id), row));
+    }
+    return records;
+}
+
+bool SizeHistory::ResolveBuild(const std::string& reference, uint32_t& id) const {
+    size_t count = GetBuildCount();
+    if (count == 0) return Fail("No builds recorded in " + directory_);
+
+    if (IsNumber(reference)) {
+        uint32_t value = static_cast<uint32_t>(std::stoul(reference));
+        if (value >= count) return Fail("No build " + reference + " (" + std::to_string(count) + " recorded)");
+        id = value;
+        return true;
+    }
+    if (reference.compare(0, 6, "latest") == 0) {
+        size_t back = 0;
+        if (reference.size() > 6) {
+            if (reference[6] != '~' || !IsNumber(reference.substr(7))) return Fail("Bad build reference: " + reference);
+            back = std::stoul(reference.substr(7));
+        }
+        if (back >= count) return Fail("Only " + std::to_string(count) + " build(s) recorded");
+        id = static_cast<uint32_t>(count - 1 - back);
+        return true;
+    }
+
+    // Revision prefix, newest build first
+    if (reference.size() < 4 || reference.size() > kRevisionLength) {
+        return Fail("Bad build reference: " + reference);
+    }
+    utils::MappedFile file;
+    if (!file.Open(GetIndexPath()) || !HasHeader(file, kIndexMagic)) return Fail("No size history in " + directory_);
+    count = (file.Size() - sizeof(FileHeader)) / sizeof(IndexRow);
+    for (size_t i = count; i-- > 0;) {
+        const unsigned char* row = file.Data() + sizeof(FileHeader) + i * sizeof(IndexRow);
+        if (std::memcmp(row + offsetof(IndexRow, revision), reference.data(), reference.size()) == 0) {
+            id = static_cast<uint32_t>(i);
+            return true;
+        }
+    }
+    return Fail("No build of revision " + reference);
+}
+
+bool SizeHistory::ReadSegment(const IndexRow& row, std::vector<uint32_t>& ids, std::vector<uint64_t>& sizes,
+                              std::vector<uint8_t>& regions) const {
+    utils::MappedFile file;
+    if (!file.Open(GetColumnsPath()) || !HasHeader(file, kColumnsMagic)) {
+        return Fail("Size history columns are missing or truncated");
+    }
+    const unsigned char* cursor;
+    const unsigned char* ids_end;
+    const unsigned char* sizes_end;
+    if (!SplitSegment(file, row.segment_offset, row.segment_bytes, row.symbol_count, cursor, ids_end, sizes_end)) {
+        return Fail("Corrupt size history segment");
+    }
+
+    ids.resize(row.symbol_count);
+    sizes.resize(row.symbol_count);
+    regions.assign(sizes_end, sizes_end + row.symbol_count);
+    uint64_t id = 0;
+    const unsigned char* size_cursor = ids_end;
+    for (uint32_t i = 0; i < row.symbol_count; ++i) {
+        uint64_t step;
+        if (!ReadVarint(cursor, ids_end, step) || !ReadVarint(size_cursor, sizes_end, sizes[i])) {
+            return Fail("Corrupt size history segment");
+        }
+        id += step;
+        ids[i] = static_cast<uint32_t>(id);
+    }
+    return true;
+}
+
+bool SizeHistory::GetSymbols(uint32_t id, std::vector<SymbolSize>& symbols) const {
+    IndexRow row;
+    std::vector<uint32_t> ids;
+    std::vector<uint64_t> sizes;
+    std::vector<uint8_t> regions;
+    if (!ReadRow(id, row) || !ReadSegment(row, ids, sizes, regions) || !LoadNames()) return false;
+
+    symbols.clear();
+    symbols.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (ids[i] >= names_.size()) return Fail("Size history dictionary is truncated");
+        uint8_t region = std::min<uint8_t>(regions[i], static_cast<uint8_t>(ElfSizeAnalyzer::Region::OTHER));
+        symbols.push_back({names_[ids[i]], sizes[i], static_cast<ElfSizeAnalyzer::Region>(region)});
+    }
+    std::sort(symbols.begin(), symbols.end(), [](const SymbolSize& a, const SymbolSize& b) {
+        return a.size != b.size ? a.size > b.size : a.name < b.name;
+    });
+    return true;
+}
+
+bool SizeHistory::ToReport(uint32_t id, ElfSizeAnalyzer::SizeReport& report) const {
+    BuildRecord record;
+    std::vector<SymbolSize> symbols;
+    if (!GetBuild(id, record) || !GetSymbols(id, symbols)) return false;
+    report = ElfSizeAnalyzer::SizeReport();
+    report.machine = 0;
+    std::copy(record.region_bytes, record.region_bytes + ElfSizeAnalyzer::kRegionCount, report.region_bytes);
+    report.flash_bytes = record.flash_bytes;
+    report.ram_bytes = record.ram_bytes;
+    report.symbols.reserve(symbols.size());
+    for (const auto& symbol : symbols) {
+        bool is_code = symbol.region == ElfSizeAnalyzer::Region::IRAM ||
+                       symbol.region == ElfSizeAnalyzer::Region::FLASH_CODE;
+        report.symbols.push_back({symbol.name, 0, symbol.size, symbol.region, is_code});
+    }
+    return true;
+}
+
+bool SizeHistory::Diff(uint32_t before, uint32_t after, ElfSizeAnalyzer::SizeDelta& delta) const {
+    ElfSizeAnalyzer::SizeReport old_report;
+    ElfSizeAnalyzer::SizeReport new_report;
+    if (!ToReport(before, old_report) || !ToReport(after, new_report)) return false;
+    delta = ElfSizeAnalyzer::Compare(old_report, new_report);
+    return true;
+}
+
+std::vector<ElfSizeAnalyzer::SizeChange> SizeHistory::GetTopGrowers(uint32_t before, uint32_t after,
+                                                                    size_t count) const {
+    std::vector<ElfSizeAnalyzer::SizeChange> growers;
+    ElfSizeAnalyzer::SizeDelta delta;
+    if (!Diff(before, after, delta)) return growers;
+    for (const auto& change : delta.symbols) {
+        if (change.delta > 0) growers.push_back(change);
+    }
+    std::stable_sort(growers.begin(), growers.end(),
+                     [](const ElfSizeAnalyzer::SizeChange& a, const ElfSizeAnalyzer::SizeChange& b) {
+                         return a.delta > b.delta;
+                     });
+    if (growers.size() > count) growers.resize(count);
+    return growers;
+}
+
+std::vector<SizeHistory::SymbolPoint> SizeHistory::GetSymbolHistory(const std::string& name, size_t first,
+                                                                    size_t count) const {
+    std::vector<SymbolPoint> points;
+    if (!LoadNames()) return points;
+    auto it = std::find(names_.begin(), names_.end(), name);
+    if (it == names_.end()) return points;
+    uint64_t target = static_cast<uint64_t>(it - names_.begin());
+
+    utils::MappedFile index;
+    utils::MappedFile columns;
+    if (!index.Open(GetIndexPath()) || !HasHeader(index, kIndexMagic) || !columns.Open(GetColumnsPath()) ||
+        !HasHeader(columns, kColumnsMagic)) {
+        return points;
+    }
+    size_t total = (index.Size() - sizeof(FileHeader)) / sizeof(IndexRow);
+    size_t last = first < total ? first + std::min(count, total - first) : first;
+    for (size_t id = first; id < last; ++id) {
+        IndexRow row;
+        std::memcpy(&row, index.Data() + sizeof(FileHeader) + id * sizeof(IndexRow), sizeof(row));
+        SymbolPoint point = {static_cast<uint32_t>(id), 0};
+        const unsigned char* cursor;
+        const unsigned char* ids_end;
+        const unsigned char* sizes_end;
+        if (!SplitSegment(columns, row.segment_offset, row.segment_bytes, row.symbol_count, cursor, ids_end,
+                          sizes_end)) {
+            points.push_back(point);
+            continue;
+        }
+
+        // Ids are sorted: scan only up to the target, then skip as many sizes
+        uint64_t current = 0;
+        uint64_t step;
+        size_t position = 0;
+        bool found = false;
+        while (cursor < ids_end && ReadVarint(cursor, ids_end, step)) {
+            current += step;
+            if (current >= target) {
+                found = current == target;
+                break;
+            }
+            ++position;
+        }
+        if (found) {
+            const unsigned char* size_cursor = ids_end;
+            for (size_t i = 0; i <= position; ++i) {
+                if (!ReadVarint(size_cursor, sizes_end, point.size)) {
+                    point.size = 0;
+                    break;
+                }
+            }
+        }
+        points.push_back(point);
+    }
+    return points;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,124 @@
+#ifndef SIZE_HISTORY_H
+#define SIZE_HISTORY_H
+
+#include "compiler/elf_size_analyzer.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace esp32_ide {
+
+/**
+ * @brief Append-only record of firmware sizes, one entry per build
+ *
+ * Lives in project_dir/.esp32ide/size_history as three files:
+ *   builds.idx    fixed-size rows: time, board, revision, region totals and
+ *                 where the build's symbols are stored
+ *   symbols.dict  every symbol name seen, in order of first appearance;
+ *                 builds refer to names by their position here
+ *   sizes.col     per build, three columns: symbol ids (sorted,
+ *                 delta-varint), sizes (varint) and regions (one byte each)
+ *
+ * Totals come straight from the index, and a build's symbols are decoded
+ * only when that build is asked for, so a history of thousands of builds
+ * is queried through a memory map without being read in. Following one
+ * symbol across builds stops decoding each id column at the symbol's id.
+ *
+ * A build is committed by its index row, written last; a crash before
+ * that leaves unreferenced bytes that the next Record() trims.
+ */
+class SizeHistory {
+public:
+    struct BuildRecord {
+        uint32_t id;
+        int64_t timestamp;              // seconds since the epoch
+        std::string board;
+        std::string revision;           // git commit, empty outside a repository
+        uint64_t region_bytes[ElfSizeAnalyzer::kRegionCount];
+        uint64_t flash_bytes;
+        uint64_t ram_bytes;
+        uint32_t symbol_count;
+    };
+
+    struct SymbolSize {
+        std::string name;
+        uint64_t size;
+        ElfSizeAnalyzer::Region region;
+    };
+
+    // Size of one symbol in one build; size 0 when the build lacks it
+    struct SymbolPoint {
+        uint32_t build_id;
+        uint64_t size;
+    };
+
+    explicit SizeHistory(const std::string& directory);
+
+    static std::string GetDefaultDirectory(const std::string& project_dir);
+    // Commit checked out in project_dir, read from .git without running git
+    static std::string ReadGitRevision(const std::string& project_dir);
+
+    /**
+     * @brief Appends one build
+     *
+     * Symbols with the same name are summed.
+     * @param timestamp 0 for now
+     */
+    bool Record(const ElfSizeAnalyzer::SizeReport& report, const std::string& board,
+                const std::string& revision, int64_t timestamp = 0);
+
+    size_t GetBuildCount() const;
+    bool GetBuild(uint32_t id, BuildRecord& record) const;
+    // Rows [first, first + count), clipped to the history
+    std::vector<BuildRecord> GetBuilds(size_t first, size_t count) const;
+
+    /**
+     * @brief Resolves a build reference
+     *
+     * Accepts a build id, "latest", "latest~N" (N builds before the
+     * latest) or a revision prefix, which matches the newest build of that
+     * revision.
+     */
+    bool ResolveBuild(const std::string& reference, uint32_t& id) const;
+
+    // Symbols of one build, largest first
+    bool GetSymbols(uint32_t id, std::vector<SymbolSize>& symbols) const;
+
+    // Region totals and symbol changes between two builds
+    bool Diff(uint32_t before, uint32_t after, ElfSizeAnalyzer::SizeDelta& delta) const;
+    // Symbols that grew the most, added ones included
+    std::vector<ElfSizeAnalyzer::SizeChange> GetTopGrowers(uint32_t before, uint32_t after, size_t count) const;
+
+    std::vector<SymbolPoint> GetSymbolHistory(const std::string& name, size_t first, size_t count) const;
+
+    const std::string& GetDirectory() const { return directory_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    struct IndexRow;
+
+    std::string directory_;
+    mutable std::string error_;
+    mutable std::vector<std::string> names_;    // symbols.dict, loaded on demand
+    mutable uint64_t names_bytes_;              // dictionary bytes parsed so far
+    std::unordered_map<std::string, uint32_t> name_ids_;
+
+    std::string GetIndexPath() const;
+    std::string GetDictionaryPath() const;
+    std::string GetColumnsPath() const;
+
+    bool LoadNames() const;
+    bool Fail(const std::string& message) const;
+    uint32_t InternName(const std::string& name, std::string& appended);
+    bool ReadRow(uint32_t id, IndexRow& row) const;
+    bool ReadSegment(const IndexRow& row, std::vector<uint32_t>& ids, std::vector<uint64_t>& sizes,
+                     std::vector<uint8_t>& regions) const;
+    BuildRecord ToRecord(uint32_t id, const IndexRow& row) const;
+    bool ToReport(uint32_t id, ElfSizeAnalyzer::SizeReport& report) const;
+};
+
+} // namespace esp32_ide
+
+#endif // SIZE_HISTORY_H
@@ -115,8 +115,8 @@ bool TextEditor::HasSelection() const {
 
 void TextEditor::Undo() {
     if (CanUndo()) {
-        redo_stack_.push_back(current_state_);
-        current_state_ = undo_stack_.back();
+        redo_stack_.push_back(StoreState());
+        RestoreState(undo_stack_.back());
         undo_stack_.pop_back();
         NotifyChange();
     }
@@ -124,8 +124,8 @@ void TextEditor::Undo() {
 
 void TextEditor::Redo() {
     if (CanRedo()) {
-        undo_stack_.push_back(current_state_);
-        current_state_ = redo_stack_.back();
+        undo_stack_.push_back(StoreState());
+        RestoreState(redo_stack_.back());
         redo_stack_.pop_back();
         NotifyChange();
     }
@@ -167,15 +167,31 @@ bool TextEditor::ReplaceText(const std::string& search, const std::string& repla
 }
 
 void TextEditor::SaveState() {
-    undo_stack_.push_back(current_state_);
+    undo_stack_.push_back(StoreState());
     redo_stack_.clear();
     
     // Limit undo stack size
     if (undo_stack_.size() > MAX_UNDO_STACK_SIZE) {
-        undo_stack_.erase(undo_stack_.begin());
+        undo_stack_.pop_front();
     }
 }
 
+TextEditor::StoredState TextEditor::StoreState() const {
+    StoredState state;
+    state.content = utils::BlobRef(current_state_.content);
+    state.cursor_position = current_state_.cursor_position;
+    state.selection_start = current_state_.selection_start;
+    state.selection_end = current_state_.selection_end;
+    return state;
+}
+
+void TextEditor::RestoreState(const StoredState& state) {
+    state.content.Get(current_state_.content);
+    current_state_.cursor_position = state.cursor_position;
+    current_state_.selection_start = state.selection_start;
+    current_state_.selection_end = state.selection_end;
+}
+
 void TextEditor::NotifyChange() {
     if (change_callback_) {
         change_callback_();
@@ -271,11 +287,19 @@ std::vector<TextEditor::CompletionItem> TextEditor::GetCompletionsAtCursor() con
 int TextEditor::CreateTab(const std::string& filename) {
     EditorTab tab;
     tab.filename = filename;
-    tab.content = "";
     tab.cursor_position = 0;
     tab.is_modified = false;
     tab.group_id = -1;
     
+    // The first tab adopts the current buffer; later tabs start empty
+    if (active_tab_id_ >= 0) {
+        HibernateActiveTab();
+        current_state_.content.clear();
+        current_state_.cursor_position = 0;
+        current_state_.selection_start = 0;
+        current_state_.selection_end = 0;
+    }
+    
     int tab_id = next_tab_id_++;
     tabs_.push_back(tab);
     active_tab_id_ = tab_id;
@@ -298,13 +322,14 @@ bool TextEditor::CloseTab(int tab_id) {
     
     // Don't actually remove to preserve indices, just mark as closed
     tabs_[tab_id].filename = "";
+    tabs_[tab_id].content.Reset();
     
     // Switch to another tab if this was active
     if (active_tab_id_ == tab_id) {
         active_tab_id_ = -1;
         for (size_t i = 0; i < tabs_.size(); ++i) {
             if (!tabs_[i].filename.empty()) {
-                active_tab_id_ = static_cast<int>(i);
+                SwitchToTab(static_cast<int>(i));
                 break;
             }
         }
@@ -322,15 +347,44 @@ bool TextEditor::SwitchToTab(int tab_id) {
         return false; // Tab is closed
     }
     
+    if (tab_id == active_tab_id_) {
+        return true;
+    }
+    
+    HibernateActiveTab();
     active_tab_id_ = tab_id;
     
-    // Update current state from tab
-    current_state_.content = tabs_[tab_id].content;
-    current_state_.cursor_position = tabs_[tab_id].cursor_position;
+    // Wake the tab: its text moves back out of the blob store
+    tabs_[tab_id].content.Get(current_state_.content);
+    tabs_[tab_id].content.Reset();
+    current_state_.cursor_position = std::min(tabs_[tab_id].cursor_position, current_state_.content.length());
+    current_state_.selection_start = 0;
+    current_state_.selection_end = 0;
     
     return true;
 }
 
+void TextEditor::HibernateActiveTab() {
+    if (active_tab_id_ < 0 || active_tab_id_ >= static_cast<int>(tabs_.size()) ||
+        tabs_[active_tab_id_].filename.empty()) {
+        return;
+    }
+    
+    EditorTab& tab = tabs_[active_tab_id_];
+    tab.content.Assign(current_state_.content);
+    tab.cursor_position = current_state_.cursor_position;
+}
+
+std::string TextEditor::GetTabContent(int tab_id) const {
+    if (tab_id < 0 || tab_id >= static_cast<int>(tabs_.size())) {
+        return "";
+    }
+    if (tab_id == active_tab_id_) {
+        return current_state_.content;
+    }
+    return tabs_[tab_id].content.Get();
+}
+
 TextEditor::EditorTab* TextEditor::GetTab(int tab_id) {
     if (tab_id < 0 || tab_id >= static_cast<int>(tabs_.size())) {
         return nullptr;
@@ -3,8 +3,11 @@
 
 #include <string>
 #include <vector>
+#include <deque>
 #include <functional>
 
+#include "utils/blob_store.h"
+
 namespace esp32_ide {
 
 /**
@@ -79,7 +82,7 @@ public:
     
     struct EditorTab {
         std::string filename;
-        std::string content;
+        utils::BlobRef content;     // hibernated content while the tab is inactive
         size_t cursor_position;
         bool is_modified;
         int group_id;
@@ -99,6 +102,7 @@ public:
     EditorTab* GetTab(int tab_id);
     const EditorTab* GetTab(int tab_id) const;
     std::vector<EditorTab> GetAllTabs() const;
+    std::string GetTabContent(int tab_id) const;
     
     // Tab groups
     int CreateTabGroup();
@@ -123,9 +127,17 @@ private:
         size_t selection_end;
     };
     
+    // Undo/redo snapshots keep their text in the shared blob store
+    struct StoredState {
+        utils::BlobRef content;
+        size_t cursor_position;
+        size_t selection_start;
+        size_t selection_end;
+    };
+    
     EditorState current_state_;
-    std::vector<EditorState> undo_stack_;
-    std::vector<EditorState> redo_stack_;
+    std::deque<StoredState> undo_stack_;
+    std::deque<StoredState> redo_stack_;
     ChangeCallback change_callback_;
     std::vector<size_t> breakpoints_;
     
@@ -138,6 +150,9 @@ private:
     SplitOrientation split_orientation_;
     
     void SaveState();
+    StoredState StoreState() const;
+    void RestoreState(const StoredState& state);
+    void HibernateActiveTab();
     void NotifyChange();
 };
 
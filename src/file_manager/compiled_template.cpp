@@ -0,0 +1,126 @@
+#include "file_manager/compiled_template.h"
+
+namespace esp32_ide {
+
+CompiledTemplate::CompiledTemplate()
+    : literal_size_(0), variable_count_(0) {
+}
+
+CompiledTemplate::CompiledTemplate(const std::string& text, const std::string& open,
+                                   const std::string& close)
+    : literal_size_(0), variable_count_(0) {
+    Compile(text, open, close);
+}
+
+void CompiledTemplate::Compile(const std::string& text, const std::string& open,
+                               const std::string& close) {
+    text_ = text;
+    segments_.clear();
+    literal_size_ = 0;
+    variable_count_ = 0;
+
+    auto add_literal = [this](size_t offset, size_t length) {
+        if (length == 0) return;
+        literal_size_ += length;
+        // Merge with a preceding literal (e.g. after a malformed placeholder)
+        if (!segments_.empty() && !segments_.back().is_variable &&
+            segments_.back().offset + segments_.back().length == offset) {
+            segments_.back().length += length;
+            return;
+        }
+        segments_.push_back({false, offset, length, std::string()});
+    };
+
+    size_t pos = 0;
+    while (pos < text_.size()) {
+        size_t start = open.empty() ? std::string::npos : text_.find(open, pos);
+        if (start == std::string::npos) break;
+
+        size_t name_begin = start + open.size();
+        size_t end = text_.find(close, name_begin);
+        if (end == std::string::npos) break;
+
+        std::string name = text_.substr(name_begin, end - name_begin);
+        if (name.empty() || name.find_first_of("\r\n") != std::string::npos ||
+            name.find(open) != std::string::npos) {
+            // Not a placeholder; keep the opening delimiter as text and move on
+            add_literal(pos, name_begin - pos);
+            pos = name_begin;
+            continue;
+        }
+
+        add_literal(pos, start - pos);
+        segments_.push_back({true, start, end + close.size() - start, std::move(name)});
+        variable_count_++;
+        pos = end + close.size();
+    }
+    add_literal(pos, text_.size() - pos);
+}
+
+std::vector<std::string> CompiledTemplate::GetVariableNames() const {
+    std::vector<std::string> names;
+    for (const auto& segment : segments_) {
+        if (segment.is_variable) {
+            names.push_back(segment.name);
+        }
+    }
+    return names;
+}
+
+const std::string* CompiledTemplate::Lookup(const Segment& segment, const Variables& overrides,
+                                            const Variables* defaults) const {
+    auto it = overrides.find(segment.name);
+    if (it != overrides.end()) return &it->second;
+    if (defaults) {
+        it = defaults->find(segment.name);
+        if (it != defaults->end()) return &it->second;
+    }
+    return nullptr;
+}
+
+size_t CompiledTemplate::GetRenderedSize(const Variables& overrides, const Variables* defaults) const {
+    size_t size = literal_size_;
+    if (variable_count_ == 0) return size;
+
+    for (const auto& segment : segments_) {
+        if (!segment.is_variable) continue;
+        const std::string* value = Lookup(segment, overrides, defaults);
+        size += value ? value->size() : segment.length;
+    }
+    return size;
+}
+
+void CompiledTemplate::RenderTo(std::string& out, const Variables& overrides,
+                                const Variables* defaults) const {
+    // Resolve every placeholder once so sizing and copying share the lookups
+    thread_local std::vector<const std::string*> values;
+    values.clear();
+    size_t size = literal_size_;
+    for (const auto& segment : segments_) {
+        if (!segment.is_variable) continue;
+        const std::string* value = Lookup(segment, overrides, defaults);
+        values.push_back(value);
+        size += value ? value->size() : segment.length;
+    }
+    out.reserve(out.size() + size);
+
+    size_t next_value = 0;
+    for (const auto& segment : segments_) {
+        if (segment.is_variable) {
+            const std::string* value = values[next_value++];
+            if (value) {
+                out.append(*value);
+                continue;
+            }
+        }
+        out.append(text_, segment.offset, segment.length);
+    }
+}
+
+std::string CompiledTemplate::Render(const Variables& variables) const {
+    std::string out;
+    RenderTo(out, variables);
+    return out;
+}
+
+} // namespace esp32_ide
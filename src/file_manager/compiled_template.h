@@ -0,0 +1,61 @@
+#ifndef COMPILED_TEMPLATE_H
+#define COMPILED_TEMPLATE_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace esp32_ide {
+
+/**
+ * @brief Template text pre-split into literal and variable segments
+ *
+ * Parsing happens once, when the template is registered. Rendering then
+ * walks the segment list a single time, appending into a buffer that is
+ * reserved up front from the literal length plus the variable values, so
+ * each render costs one allocation regardless of how many placeholders
+ * the template contains.
+ *
+ * Placeholders without a value are rendered verbatim (e.g. "${BOARD}"),
+ * matching the old find/replace behaviour. Substituted values are never
+ * re-scanned for placeholders.
+ */
+class CompiledTemplate {
+public:
+    using Variables = std::map<std::string, std::string>;
+
+    CompiledTemplate();
+    CompiledTemplate(const std::string& text, const std::string& open, const std::string& close);
+
+    // Compilation
+    void Compile(const std::string& text, const std::string& open, const std::string& close);
+    bool HasVariables() const { return variable_count_ > 0; }
+    size_t GetSegmentCount() const { return segments_.size(); }
+    std::vector<std::string> GetVariableNames() const;
+
+    // Rendering; values in `overrides` take precedence over `defaults`
+    std::string Render(const Variables& variables) const;
+    void RenderTo(std::string& out, const Variables& overrides,
+                  const Variables* defaults = nullptr) const;
+    size_t GetRenderedSize(const Variables& overrides, const Variables* defaults = nullptr) const;
+
+private:
+    struct Segment {
+        bool is_variable;
+        size_t offset;       // into text_: literal text, or the whole placeholder
+        size_t length;
+        std::string name;    // variable name (variables only)
+    };
+
+    std::string text_;
+    std::vector<Segment> segments_;
+    size_t literal_size_;
+    size_t variable_count_;
+
+    const std::string* Lookup(const Segment& segment, const Variables& overrides,
+                              const Variables* defaults) const;
+};
+
+} // namespace esp32_ide
+
+#endif // COMPILED_TEMPLATE_H
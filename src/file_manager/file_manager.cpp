@@ -23,8 +23,9 @@ bool FileManager::CreateFile(const std::string& name, const std::string& initial
     info.path = name;
     info.is_modified = false;
     info.is_open = false;
+    HibernateContent(info);
     
-    files_[name] = info;
+    files_[name] = std::move(info);
     return true;
 }
 
@@ -33,7 +34,11 @@ bool FileManager::OpenFile(const std::string& name) {
         return false;
     }
     
-    files_[name].is_open = true;
+    FileInfo& info = files_[name];
+    if (!info.is_open) {
+        WakeContent(info);
+        info.is_open = true;
+    }
     SetCurrentFile(name);
     return true;
 }
@@ -49,7 +54,7 @@ bool FileManager::SaveFile(const std::string& name) {
         return false;
     }
     
-    file << files_[name].content;
+    file << ReadContent(files_[name]);
     file.close();
     
     files_[name].is_modified = false;
@@ -79,7 +84,11 @@ bool FileManager::CloseFile(const std::string& name) {
         return false;
     }
     
-    files_[name].is_open = false;
+    FileInfo& info = files_[name];
+    if (info.is_open) {
+        HibernateContent(info);
+        info.is_open = false;
+    }
     if (current_file_ == name) {
         current_file_ = "";
     }
@@ -103,7 +112,12 @@ bool FileManager::SetFileContent(const std::string& name, const std::string& con
         return false;
     }
     
-    files_[name].content = content;
+    FileInfo& info = files_[name];
+    if (info.is_open) {
+        info.content = content;
+    } else {
+        info.stored_content.Assign(content);
+    }
     MarkAsModified(name);
     return true;
 }
@@ -111,7 +125,7 @@ bool FileManager::SetFileContent(const std::string& name, const std::string& con
 std::string FileManager::GetFileContent(const std::string& name) const {
     auto it = files_.find(name);
     if (it != files_.end()) {
-        return it->second.content;
+        return ReadContent(it->second);
     }
     return "";
 }
@@ -139,7 +153,11 @@ std::vector<std::string> FileManager::GetFileList() const {
 FileManager::FileInfo FileManager::GetFileInfo(const std::string& name) const {
     auto it = files_.find(name);
     if (it != files_.end()) {
-        return it->second;
+        FileInfo info = it->second;
+        if (!info.is_open) {
+            info.content = ReadContent(it->second);
+        }
+        return info;
     }
     return FileInfo();
 }
@@ -192,7 +210,7 @@ bool FileManager::SaveProject(const std::string& project_path) {
                 continue;
             }
             
-            file << pair.second.content;
+            file << ReadContent(pair.second);
             file.close();
             
             pair.second.is_modified = false;
@@ -239,6 +257,20 @@ void FileManager::MarkAsModified(const std::string& name, bool modified) {
     }
 }
 
+std::string FileManager::ReadContent(const FileInfo& info) {
+    return info.is_open ? info.content : info.stored_content.Get();
+}
+
+void FileManager::HibernateContent(FileInfo& info) {
+    info.stored_content.Assign(info.content);
+    std::string().swap(info.content);
+}
+
+void FileManager::WakeContent(FileInfo& info) {
+    info.stored_content.Get(info.content);
+    info.stored_content.Reset();
+}
+
 // Custom code templates implementation
 void FileManager::InitializeDefaultTemplates() {
     // Basic Arduino template
@@ -478,12 +510,14 @@ void FileManager::AddTemplate(const std::string& name, const std::string& code,
     tmpl.description = description;
     tmpl.tags = tags;
     templates_[name] = tmpl;
+    compiled_templates_[name].Compile(code, "{{", "}}");
 }
 
 bool FileManager::DeleteTemplate(const std::string& name) {
     auto it = templates_.find(name);
     if (it != templates_.end()) {
         templates_.erase(it);
+        compiled_templates_.erase(name);
         return true;
     }
     return false;
@@ -522,23 +556,12 @@ bool FileManager::TemplateExists(const std::string& name) const {
 
 std::string FileManager::ApplyTemplate(const std::string& template_name, 
                                       const std::map<std::string, std::string>& variables) {
-    if (!TemplateExists(template_name)) {
+    auto it = compiled_templates_.find(template_name);
+    if (it == compiled_templates_.end()) {
         return "";
     }
     
-    std::string code = templates_[template_name].code;
-    
-    // Replace variables in the template
-    for (const auto& var : variables) {
-        std::string placeholder = "{{" + var.first + "}}";
-        size_t pos = 0;
-        while ((pos = code.find(placeholder, pos)) != std::string::npos) {
-            code.replace(pos, placeholder.length(), var.second);
-            pos += var.second.length();
-        }
-    }
-    
-    return code;
+    return it->second.Render(variables);
 }
 
 // File tree operations
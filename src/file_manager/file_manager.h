@@ -6,6 +6,9 @@
 #include <vector>
 #include <memory>
 
+#include "file_manager/compiled_template.h"
+#include "utils/blob_store.h"
+
 namespace esp32_ide {
 
 /**
@@ -21,6 +24,7 @@ public:
         std::string path;
         bool is_modified;
         bool is_open;
+        utils::BlobRef stored_content;  // content of closed files, kept in the shared blob store
     };
     
     FileManager();
@@ -99,9 +103,13 @@ private:
     std::string current_file_;
     std::string project_path_;
     std::map<std::string, CodeTemplate> templates_;
+    std::map<std::string, CompiledTemplate> compiled_templates_;
     std::unique_ptr<FileTreeNode> file_tree_root_;
     
     void MarkAsModified(const std::string& name, bool modified = true);
+    static std::string ReadContent(const FileInfo& info);
+    static void HibernateContent(FileInfo& info);
+    static void WakeContent(FileInfo& info);
     void InitializeDefaultTemplates();
     void InitializeFileTree();
     void RebuildFileTree();
@@ -3,9 +3,23 @@
 #include <sstream>
 #include <algorithm>
 #include <set>
+#include <thread>
+#include <atomic>
+#include <filesystem>
 
 namespace esp32_ide {
 
+namespace {
+
+const char* const kVariableOpen = "${";
+const char* const kVariableClose = "}";
+
+std::shared_ptr<const CompiledTemplate> CompileTemplateText(const std::string& text) {
+    return std::make_shared<const CompiledTemplate>(text, kVariableOpen, kVariableClose);
+}
+
+} // namespace
+
 // ProjectTemplate implementation
 
 ProjectTemplate::ProjectTemplate(const std::string& id, const std::string& name)
@@ -17,6 +31,8 @@ void ProjectTemplate::AddFile(const std::string& path, const std::string& conten
     file.path = path;
     file.content = content;
     file.is_directory = false;
+    file.compiled_path = CompileTemplateText(path);
+    file.compiled_content = CompileTemplateText(content);
     files_.push_back(file);
 }
 
@@ -24,6 +40,7 @@ void ProjectTemplate::AddDirectory(const std::string& path) {
     TemplateFile dir;
     dir.path = path;
     dir.is_directory = true;
+    dir.compiled_path = CompileTemplateText(path);
     files_.push_back(dir);
 }
 
@@ -32,18 +49,8 @@ void ProjectTemplate::SetVariable(const std::string& name, const std::string& va
 }
 
 std::string ProjectTemplate::ProcessContent(const std::string& content) const {
-    std::string result = content;
-    
-    for (const auto& var : variables_) {
-        std::string placeholder = "${" + var.first + "}";
-        size_t pos = 0;
-        while ((pos = result.find(placeholder, pos)) != std::string::npos) {
-            result.replace(pos, placeholder.length(), var.second);
-            pos += var.second.length();
-        }
-    }
-    
-    return result;
+    CompiledTemplate compiled(content, kVariableOpen, kVariableClose);
+    return compiled.Render(variables_);
 }
 
 void ProjectTemplate::ApplyVariables(const std::map<std::string, std::string>& user_vars) {
@@ -52,9 +59,30 @@ void ProjectTemplate::ApplyVariables(const std::map<std::string, std::string>& u
     }
 }
 
+std::string ProjectTemplate::RenderPath(const TemplateFile& file,
+                                        const std::map<std::string, std::string>& user_vars) const {
+    if (!file.compiled_path) {
+        return CompiledTemplate(file.path, kVariableOpen, kVariableClose).Render(variables_);
+    }
+    std::string path;
+    file.compiled_path->RenderTo(path, user_vars, &variables_);
+    return path;
+}
+
+void ProjectTemplate::RenderContent(const TemplateFile& file,
+                                    const std::map<std::string, std::string>& user_vars,
+                                    std::string& out) const {
+    if (!file.compiled_content) {
+        CompiledTemplate(file.content, kVariableOpen, kVariableClose).RenderTo(out, user_vars, &variables_);
+        return;
+    }
+    file.compiled_content->RenderTo(out, user_vars, &variables_);
+}
+
 // ProjectTemplateManager implementation
 
-ProjectTemplateManager::ProjectTemplateManager() {
+ProjectTemplateManager::ProjectTemplateManager()
+    : writer_threads_(0) {
 }
 
 bool ProjectTemplateManager::Initialize() {
@@ -136,7 +164,13 @@ std::vector<std::string> ProjectTemplateManager::GetTags() const {
 }
 
 bool ProjectTemplateManager::CreateProject(const CreateProjectOptions& options) {
-    return CreateProjectFromTemplate(options.template_id, options.project_path, options.variables);
+    if (options.project_name.empty() || options.variables.count("PROJECT_NAME")) {
+        return CreateProjectFromTemplate(options.template_id, options.project_path, options.variables);
+    }
+
+    std::map<std::string, std::string> variables = options.variables;
+    variables["PROJECT_NAME"] = options.project_name;
+    return CreateProjectFromTemplate(options.template_id, options.project_path, variables);
 }
 
 bool ProjectTemplateManager::CreateProjectFromTemplate(const std::string& template_id, const std::string& project_path,
@@ -144,16 +178,28 @@ bool ProjectTemplateManager::CreateProjectFromTemplate(const std::string& templa
     ProjectTemplate* tmpl = GetTemplate(template_id);
     if (!tmpl) return false;
 
-    // Apply user variables
-    ProjectTemplate temp_copy = *tmpl;
-    temp_copy.ApplyVariables(variables);
+    // Resolve file paths first so every directory exists before the writers start
+    std::vector<PendingFile> pending;
+    std::set<std::string> directories;
+    for (const auto& file : tmpl->GetFiles()) {
+        std::string path = tmpl->RenderPath(file, variables);
+        if (file.is_directory) {
+            directories.insert(path);
+            continue;
+        }
 
-    // Create directory structure and files
-    if (!CreateDirectoryStructure(project_path, temp_copy.GetFiles())) {
+        size_t last_slash = path.find_last_of("/\\");
+        if (last_slash != std::string::npos) {
+            directories.insert(path.substr(0, last_slash));
+        }
+        pending.push_back({std::move(path), &file});
+    }
+
+    if (!CreateDirectoryStructure(project_path, {directories.begin(), directories.end()})) {
         return false;
     }
 
-    if (!WriteTemplateFiles(project_path, temp_copy.GetFiles())) {
+    if (!WriteTemplateFiles(project_path, *tmpl, pending, variables)) {
         return false;
     }
 
@@ -413,66 +459,59 @@ void loop() {
     return tmpl;
 }
 
-bool ProjectTemplateManager::CreateDirectoryStructure(const std::string& base_path, 
-                                                      const std::vector<TemplateFile>& files) {
-    // Extract unique directory paths from files
-    std::set<std::string> directories;
-    for (const auto& file : files) {
-        size_t last_slash = file.path.find_last_of("/\\");
-        if (last_slash != std::string::npos) {
-            std::string dir = file.path.substr(0, last_slash);
-            directories.insert(dir);
-        }
-    }
-    
-    // Create each directory
-    // Note: In a cross-platform implementation, would use std::filesystem (C++17)
-    // or platform-specific APIs. For now, using basic approach.
+bool ProjectTemplateManager::CreateDirectoryStructure(const std::string& base_path,
+                                                      const std::vector<std::string>& directories) {
+    std::error_code ec;
+    std::filesystem::create_directories(base_path, ec);
+    if (ec) return false;
+
     for (const auto& dir : directories) {
-        std::string full_path = base_path + "/" + dir;
-        
-        // Try to create directory by creating a test file
-        // This is a workaround for systems without filesystem support
-        std::ofstream test(full_path + "/.gitkeep");
-        if (test.is_open()) {
-            test.close();
-        }
+        std::filesystem::create_directories(base_path + "/" + dir, ec);
+        if (ec) return false;
     }
-    
+
     return true;
 }
 
-bool ProjectTemplateManager::WriteTemplateFiles(const std::string& base_path, 
-                                               const std::vector<TemplateFile>& files) {
-    bool all_written = true;
-    
-    for (const auto& file : files) {
-        std::string full_path = base_path + "/" + file.path;
-        
-        // Create directory for file if needed
-        size_t last_slash = file.path.find_last_of("/\\");
-        if (last_slash != std::string::npos) {
-            std::string dir = file.path.substr(0, last_slash);
-            std::string dir_path = base_path + "/" + dir;
-            
-            // Ensure directory exists
-            std::ofstream dir_test(dir_path + "/.gitkeep");
-            if (dir_test.is_open()) {
-                dir_test.close();
+bool ProjectTemplateManager::WriteTemplateFiles(const std::string& base_path, const ProjectTemplate& tmpl,
+                                               const std::vector<PendingFile>& files,
+                                               const std::map<std::string, std::string>& variables) {
+    std::atomic<size_t> next_file(0);
+    std::atomic<bool> all_written(true);
+
+    // Each writer renders into its own reusable buffer and writes it out in one call
+    auto writer = [&]() {
+        std::string buffer;
+        for (size_t i = next_file++; i < files.size(); i = next_file++) {
+            buffer.clear();
+            tmpl.RenderContent(*files[i].file, variables, buffer);
+
+            std::ofstream out_file(base_path + "/" + files[i].path, std::ios::binary | std::ios::trunc);
+            if (!out_file.is_open() || !out_file.write(buffer.data(), buffer.size())) {
+                all_written = false;
             }
         }
-        
-        // Write file content
-        std::ofstream out_file(full_path);
-        if (!out_file.is_open()) {
-            all_written = false;
-            continue;
-        }
-        
-        out_file << file.content;
-        out_file.close();
+    };
+
+    size_t thread_count = writer_threads_ ? writer_threads_ : std::thread::hardware_concurrency();
+    thread_count = std::min(std::max<size_t>(thread_count, 1), files.size());
+
+    // Small templates are not worth a thread spawn
+    if (thread_count <= 1) {
+        writer();
+        return all_written;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(writer);
     }
-    
+    writer();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
     return all_written;
 }
 
@@ -7,6 +7,8 @@
 #include <memory>
 #include <functional>
 
+#include "file_manager/compiled_template.h"
+
 namespace esp32_ide {
 
 /**
@@ -16,6 +18,10 @@ struct TemplateFile {
     std::string path;           // Relative path within project
     std::string content;        // File content (may contain variables like ${PROJECT_NAME})
     bool is_directory;          // True if this is a directory
+
+    // Segment lists compiled once when the file is added to its template
+    std::shared_ptr<const CompiledTemplate> compiled_path;
+    std::shared_ptr<const CompiledTemplate> compiled_content;
 };
 
 /**
@@ -52,6 +58,12 @@ public:
     std::string ProcessContent(const std::string& content) const;
     void ApplyVariables(const std::map<std::string, std::string>& user_vars);
 
+    // Single-pass rendering of a compiled file; user_vars override template variables
+    std::string RenderPath(const TemplateFile& file,
+                           const std::map<std::string, std::string>& user_vars = {}) const;
+    void RenderContent(const TemplateFile& file, const std::map<std::string, std::string>& user_vars,
+                       std::string& out) const;
+
 private:
     std::string id_;
     std::string name_;
@@ -102,6 +114,10 @@ public:
     bool CreateProjectFromTemplate(const std::string& template_id, const std::string& project_path,
                                    const std::map<std::string, std::string>& variables);
 
+    // Files are rendered and written by up to this many threads (0 = hardware concurrency)
+    void SetWriterThreadCount(size_t count) { writer_threads_ = count; }
+    size_t GetWriterThreadCount() const { return writer_threads_; }
+
     // Callbacks
     using ProjectCreatedCallback = std::function<void(const std::string& path)>;
     void SetProjectCreatedCallback(ProjectCreatedCallback callback) { project_created_callback_ = callback; }
@@ -112,6 +128,12 @@ public:
 private:
     std::map<std::string, std::unique_ptr<ProjectTemplate>> templates_;
     ProjectCreatedCallback project_created_callback_;
+    size_t writer_threads_;
+
+    struct PendingFile {
+        std::string path;               // rendered, relative to the project
+        const TemplateFile* file;
+    };
 
     // Built-in template creators
     std::unique_ptr<ProjectTemplate> CreateBasicSketchTemplate();
@@ -124,8 +146,10 @@ private:
     std::unique_ptr<ProjectTemplate> CreateDisplayProjectTemplate();
 
     // Helper methods
-    bool CreateDirectoryStructure(const std::string& base_path, const std::vector<TemplateFile>& files);
-    bool WriteTemplateFiles(const std::string& base_path, const std::vector<TemplateFile>& files);
+    bool CreateDirectoryStructure(const std::string& base_path, const std::vector<std::string>& directories);
+    bool WriteTemplateFiles(const std::string& base_path, const ProjectTemplate& tmpl,
+                            const std::vector<PendingFile>& files,
+                            const std::map<std::string, std::string>& variables);
     void NotifyProjectCreated(const std::string& path);
 };
 
@@ -4,6 +4,9 @@
 #include "file_manager/file_manager.h"
 #include "compiler/esp32_compiler.h"
 #include "serial/serial_monitor.h"
+#include "search/parallel_grep.h"
+#include "visualization/serial_plotter.h"
+#include "renderer/pure_c_renderer.h"
 
 #include <iostream>
 #include <algorithm>
@@ -80,6 +83,9 @@ bool EnhancedGuiWindow::Initialize(int width, int height) {
     
     device_preview_ = std::make_unique<DeviceLibraryPreview>();
     
+    plotter_ = std::make_unique<visualization::SerialPlotter>();
+    plot_renderer_ = std::make_unique<renderer::PureCRenderer>();
+    
     // Setup terminal command callback
     terminal_->SetCommandCallback([this](const std::string& cmd) {
         return HandleTerminalCommand(cmd);
@@ -196,6 +202,13 @@ void EnhancedGuiWindow::SetupPanels() {
     preview_panel->SetMinSize(250, 200);
     panel_layout_->AddPanel(std::move(preview_panel));
     
+    // Create serial plotter panel (right, below preview; shown on demand)
+    auto plotter_panel = std::make_unique<SerialPlotterPanel>("plotter");
+    plotter_panel->SetDock(PanelDock::RIGHT);
+    plotter_panel->SetMinSize(250, 200);
+    plotter_panel->SetState(PanelState::HIDDEN);
+    panel_layout_->AddPanel(std::move(plotter_panel));
+    
     // Create console panel (bottom)
     auto console_panel = std::make_unique<ConsolePanel>("console");
     console_panel->SetDock(PanelDock::BOTTOM);
@@ -228,6 +241,29 @@ void EnhancedGuiWindow::SetCompiler(ESP32Compiler* compiler) {
 
 void EnhancedGuiWindow::SetSerialMonitor(SerialMonitor* serial_monitor) {
     serial_monitor_ = serial_monitor;
+    if (!serial_monitor_) {
+        return;
+    }
+    // Device output reaches the console in frame-paced batches, and the
+    // plotter while its panel is open
+    serial_monitor_->SetBatchCallback([this](const SerialMonitor::SerialMessage* messages, size_t count) {
+        Panel* plotter_panel = panel_layout_->GetPanel("plotter");
+        bool plotting = plotter_ && plotter_panel && plotter_panel->IsVisible();
+        for (size_t i = 0; i < count; ++i) {
+            if (plotting && messages[i].type == SerialMonitor::MessageType::NORMAL) {
+                plotter_->AddLine(messages[i].content);
+            }
+            const char* type = "output";
+            switch (messages[i].type) {
+                case SerialMonitor::MessageType::ERROR:   type = "error"; break;
+                case SerialMonitor::MessageType::WARNING: type = "warning"; break;
+                case SerialMonitor::MessageType::SUCCESS: type = "success"; break;
+                case SerialMonitor::MessageType::INFO:    type = "info"; break;
+                default: break;
+            }
+            AddConsoleMessage(messages[i].content, type);
+        }
+    });
 }
 
 void EnhancedGuiWindow::SetSyntaxHighlighter(SyntaxHighlighter* highlighter) {
@@ -268,6 +304,14 @@ void EnhancedGuiWindow::Run() {
 
 void EnhancedGuiWindow::ProcessEvents() {
     // Platform-specific event processing would go here
+    
+    // Drain find-in-files hits on the UI thread
+    PollFindInFilesResults();
+    
+    // Serial input, and a batch that falls due after the device went quiet
+    if (serial_monitor_) {
+        serial_monitor_->ProcessIncoming();
+    }
 }
 
 void EnhancedGuiWindow::Render() {
@@ -278,7 +322,7 @@ void EnhancedGuiWindow::Render() {
     std::cout << "\n=== Frame Render ===\n";
     
     // Show visible panels with gradient backgrounds
-    for (const auto* panel : panel_layout_->GetAllPanels()) {
+    for (auto* panel : panel_layout_->GetAllPanels()) {
         if (panel->IsVisible()) {
             Rectangle bounds = panel->GetBounds();
             
@@ -293,6 +337,10 @@ void EnhancedGuiWindow::Render() {
             // Draw panel title
             DrawText(bounds.x + 5, bounds.y + 5, panel->GetTitle(), Colors::TEXT);
             
+            if (auto* plotter_panel = dynamic_cast<SerialPlotterPanel*>(panel)) {
+                RenderSerialPlotter(plotter_panel);
+            }
+            
             std::cout << panel->GetTitle() << " [" << bounds.x << "," << bounds.y 
                      << " " << bounds.width << "x" << bounds.height << "]\n";
         }
@@ -301,6 +349,7 @@ void EnhancedGuiWindow::Render() {
 
 void EnhancedGuiWindow::Shutdown() {
     running_ = false;
+    CancelFindInFiles();
     ShutdownPlatform();
 }
 
@@ -425,6 +474,36 @@ void EnhancedGuiWindow::DownloadDeviceConfiguration() {
     AddConsoleMessage("Device configuration downloaded successfully", "success");
 }
 
+void EnhancedGuiWindow::ShowSerialPlotter() {
+    if (!panel_layout_->GetPanel("plotter")->IsVisible()) {
+        // Like reopening the Arduino plotter: start from an empty chart
+        plotter_->Clear();
+    }
+    ShowPanel("plotter");
+}
+
+void EnhancedGuiWindow::RenderSerialPlotter(SerialPlotterPanel* panel) {
+    // The chart fills the panel below its title
+    Rectangle bounds = panel->GetBounds();
+    int width = bounds.width - 2;
+    int height = bounds.height - 22;
+    if (width <= 0 || height <= 1) {
+        return;
+    }
+    if (plot_renderer_->GetWidth() != width || plot_renderer_->GetHeight() != height) {
+        plot_renderer_->Initialize(width, height);
+    }
+    plot_renderer_->Clear(renderer::Color(30, 30, 30));
+    plotter_->RenderLatest(*plot_renderer_, 0, 0, width, height, panel->GetSpan());
+    DrawImage(bounds.x + 1, bounds.y + 21, width, height, plot_renderer_->GetFramebuffer());
+    
+    std::vector<std::string> legend;
+    for (size_t i = 0; i < plotter_->GetSeriesCount(); ++i) {
+        legend.push_back(plotter_->GetSeriesName(static_cast<int>(i)));
+    }
+    panel->SetLegend(legend);
+}
+
 void EnhancedGuiWindow::ShowTerminal() {
     ShowPanel("terminal");
 }
@@ -439,6 +518,55 @@ void EnhancedGuiWindow::ClearTerminal() {
     UpdateTerminalPanel();
 }
 
+void EnhancedGuiWindow::FindInFiles(const std::string& pattern, const std::string& path) {
+    if (!grep_) {
+        grep_ = std::make_unique<search::ParallelGrep>();
+    }
+    
+    std::string root = path;
+    if (root.empty()) {
+        root = terminal_->GetWorkingDirectory().empty() ? "." : terminal_->GetWorkingDirectory();
+    }
+    
+    // Starting a new query cancels the previous one
+    search::SearchOptions options;
+    if (!grep_->Start({root}, pattern, options)) {
+        terminal_->WriteError(grep_->GetError());
+        return;
+    }
+    terminal_->WriteLine("Searching for '" + pattern + "' in " + root + "...");
+}
+
+void EnhancedGuiWindow::CancelFindInFiles() {
+    if (grep_) {
+        grep_->Cancel();
+        grep_->Wait();
+    }
+}
+
+void EnhancedGuiWindow::PollFindInFilesResults() {
+    if (!grep_) {
+        return;
+    }
+    
+    // Bound the work done per frame so a flood of hits cannot stall the UI
+    auto hits = grep_->PollHits(256);
+    for (const auto& hit : hits) {
+        terminal_->WriteLine(hit.path + ":" + std::to_string(hit.line) + ": " + hit.line_text);
+    }
+    
+    if (!grep_->IsRunning() && hits.empty() && grep_->GetGeneration() != 0) {
+        auto stats = grep_->GetStats();
+        terminal_->WriteSuccess(std::to_string(stats.hits) + " matches in " +
+                                std::to_string(stats.files_scanned) + " files");
+        grep_.reset();
+    }
+    
+    if (!hits.empty()) {
+        UpdateTerminalPanel();
+    }
+}
+
 void EnhancedGuiWindow::UpdateDeviceLibraryPanel() {
     auto* panel = dynamic_cast<DeviceLibraryPanel*>(panel_layout_->GetPanel("devices"));
     if (panel) {
@@ -511,7 +639,20 @@ std::string EnhancedGuiWindow::HandleTerminalCommand(const std::string& command)
         return "Upload started";
     }
     
-    return "Command not recognized. Try: devices, instances, compile, upload";
+    if (command == "plotter") {
+        ShowSerialPlotter();
+        return "Serial plotter opened";
+    }
+    
+    if (command.compare(0, 5, "grep ") == 0) {
+        std::istringstream iss(command.substr(5));
+        std::string pattern, path;
+        iss >> pattern >> path;
+        FindInFiles(pattern, path);
+        return "";
+    }
+    
+    return "Command not recognized. Try: devices, instances, compile, upload, plotter, grep <pattern> [path]";
 }
 
 void EnhancedGuiWindow::UpdateFileBrowserPanel() {
@@ -539,7 +680,7 @@ void EnhancedGuiWindow::AddConsoleMessage(const std::string& message, const std:
         if (type == "error") prefix = "[ERROR] ";
         else if (type == "success") prefix = "[OK] ";
         else if (type == "warning") prefix = "[WARN] ";
-        else prefix = "[INFO] ";
+        else if (type != "output") prefix = "[INFO] ";
         
         panel->AddLine(prefix + message);
     }
@@ -689,6 +830,48 @@ void EnhancedGuiWindow::DrawLine(int x1, int y1, int x2, int y2, uint32_t color)
 #endif
 }
 
+void EnhancedGuiWindow::DrawImage(int x, int y, int width, int height, const uint32_t* pixels) {
+    if (!window_handle_) return;
+    if (width <= 0 || height <= 0) return;
+    
+    auto* platform_data = static_cast<PlatformWindowData*>(window_handle_);
+    
+    // Both platforms take 0x00RRGGBB words
+    image_pixels_.resize(static_cast<size_t>(width) * height);
+    for (size_t i = 0; i < image_pixels_.size(); ++i) {
+        uint32_t rgba = pixels[i];
+        image_pixels_[i] = ((rgba & 0xFF) << 16) | (rgba & 0xFF00) | ((rgba >> 16) & 0xFF);
+    }
+    
+#ifdef _WIN32
+    if (platform_data->hdc) {
+        BITMAPINFO info = {};
+        info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+        info.bmiHeader.biWidth = width;
+        info.bmiHeader.biHeight = -height;  // top-down
+        info.bmiHeader.biPlanes = 1;
+        info.bmiHeader.biBitCount = 32;
+        info.bmiHeader.biCompression = BI_RGB;
+        SetDIBitsToDevice(platform_data->hdc, x, y, width, height, 0, 0, 0, height,
+                          image_pixels_.data(), &info, DIB_RGB_COLORS);
+    }
+#elif defined(__linux__) && !defined(X11_NOT_AVAILABLE)
+    if (platform_data->display && platform_data->gc) {
+        int screen = DefaultScreen(platform_data->display);
+        XImage* image = XCreateImage(platform_data->display, DefaultVisual(platform_data->display, screen),
+                                     DefaultDepth(platform_data->display, screen), ZPixmap, 0,
+                                     reinterpret_cast<char*>(image_pixels_.data()), width, height, 32, 0);
+        if (image) {
+            XPutImage(platform_data->display, platform_data->window, platform_data->gc, image,
+                      0, 0, x, y, width, height);
+            // The pixels belong to image_pixels_, not to the image
+            image->data = nullptr;
+            XDestroyImage(image);
+        }
+    }
+#endif
+}
+
 void EnhancedGuiWindow::DrawText(int x, int y, const std::string& text, uint32_t color) {
     if (!window_handle_) return;
     
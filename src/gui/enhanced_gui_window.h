@@ -18,6 +18,18 @@ class ESP32Compiler;
 class SerialMonitor;
 class SyntaxHighlighter;
 
+namespace search {
+class ParallelGrep;
+}
+
+namespace visualization {
+class SerialPlotter;
+}
+
+namespace renderer {
+class PureCRenderer;
+}
+
 namespace gui {
 
 /**
@@ -64,6 +76,13 @@ public:
     void ShowTerminal();
     void ExecuteTerminalCommand(const std::string& command);
     void ClearTerminal();
+    
+    // Find in files (streamed into the terminal panel)
+    void FindInFiles(const std::string& pattern, const std::string& path = "");
+    void CancelFindInFiles();
+    
+    // Serial plotter panel, fed from the serial monitor while shown
+    void ShowSerialPlotter();
 
 private:
     // Platform-specific window handle
@@ -81,6 +100,10 @@ private:
     std::unique_ptr<DeviceLibrary> device_library_;
     std::unique_ptr<IntegratedTerminal> terminal_;
     std::unique_ptr<DeviceLibraryPreview> device_preview_;
+    std::unique_ptr<search::ParallelGrep> grep_;
+    std::unique_ptr<visualization::SerialPlotter> plotter_;
+    std::unique_ptr<renderer::PureCRenderer> plot_renderer_;
+    std::vector<uint32_t> image_pixels_;    // DrawImage() scratch
     
     // Window state
     int width_;
@@ -112,6 +135,7 @@ private:
     void RenderPanels();
     void RenderPanel(Panel* panel);
     void RenderStatusBar();
+    void RenderSerialPlotter(SerialPlotterPanel* panel);
     
     // Drawing primitives
     void DrawText(int x, int y, const std::string& text, uint32_t color = 0xFFFFFF);
@@ -119,6 +143,8 @@ private:
     void DrawGradientRect(int x, int y, int width, int height, uint32_t color1, uint32_t color2, bool vertical = true);
     void DrawButton(int x, int y, int width, int height, const std::string& label);
     void DrawLine(int x1, int y1, int x2, int y2, uint32_t color = 0x808080);
+    // Pixels as renderer::Color::ToRGBA() packs them
+    void DrawImage(int x, int y, int width, int height, const uint32_t* pixels);
     void ClearWindow(uint32_t color = 0x1E1E1E);
     
     // Helper functions for gradients
@@ -140,6 +166,9 @@ private:
     void UpdateTerminalPanel();
     std::string HandleTerminalCommand(const std::string& command);
     
+    // Find in files
+    void PollFindInFilesResults();
+    
     // File browser actions
     void UpdateFileBrowserPanel();
     void OnFileSelected(const std::string& filename);
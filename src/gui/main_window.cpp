@@ -60,8 +60,9 @@ int MainWindow::Run() {
     is_running_ = true;
     Show();
     
-    // In a real GUI application, this would be an event loop
-    // For demonstration, we'll just show the interface structure
+    // In a real GUI application, this would be an event loop calling
+    // ProcessFrame() every frame; for demonstration, we run one frame
+    ProcessFrame();
     
     return 0;
 }
@@ -70,6 +71,11 @@ void MainWindow::Close() {
     is_running_ = false;
 }
 
+void MainWindow::ProcessFrame() {
+    // Also delivers the last batch once the device goes quiet
+    serial_monitor_->ProcessIncoming();
+}
+
 void MainWindow::OnNewFile() {
     std::string filename = "new_sketch.ino";
     if (file_manager_->CreateFile(filename)) {
@@ -336,23 +342,25 @@ void MainWindow::SetupCallbacks() {
         UpdateConsole(message, status);
     });
     
-    // Setup serial monitor callback
-    serial_monitor_->SetMessageCallback([this](const SerialMonitor::SerialMessage& msg) {
-        ConsoleWidget::MessageType type = ConsoleWidget::MessageType::NORMAL;
-        switch (msg.type) {
-            case SerialMonitor::MessageType::ERROR:
-                type = ConsoleWidget::MessageType::ERROR;
-                break;
-            case SerialMonitor::MessageType::SUCCESS:
-                type = ConsoleWidget::MessageType::SUCCESS;
-                break;
-            case SerialMonitor::MessageType::WARNING:
-                type = ConsoleWidget::MessageType::WARNING;
-                break;
-            default:
-                type = ConsoleWidget::MessageType::NORMAL;
+    // Setup serial monitor callback; output arrives in frame-paced batches
+    serial_monitor_->SetBatchCallback([this](const SerialMonitor::SerialMessage* messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            ConsoleWidget::MessageType type = ConsoleWidget::MessageType::NORMAL;
+            switch (messages[i].type) {
+                case SerialMonitor::MessageType::ERROR:
+                    type = ConsoleWidget::MessageType::ERROR;
+                    break;
+                case SerialMonitor::MessageType::SUCCESS:
+                    type = ConsoleWidget::MessageType::SUCCESS;
+                    break;
+                case SerialMonitor::MessageType::WARNING:
+                    type = ConsoleWidget::MessageType::WARNING;
+                    break;
+                default:
+                    type = ConsoleWidget::MessageType::NORMAL;
+            }
+            console_->AddMessage(messages[i].content, type);
         }
-        console_->AddMessage(msg.content, type);
     });
     
     // Setup VM emulator callbacks
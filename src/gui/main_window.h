@@ -33,6 +33,11 @@ public:
     void Hide();
     int Run();
     void Close();
+    // Per-frame work of the event loop: serial input and due console batches
+    void ProcessFrame();
+    
+    SerialMonitor* GetSerialMonitor() { return serial_monitor_.get(); }
+    const ConsoleWidget* GetConsole() const { return console_.get(); }
     
     // UI Actions
     void OnNewFile();
@@ -633,5 +633,19 @@ std::string PreviewPanel::GetContent() const {
     return preview_content_;
 }
 
+// SerialPlotterPanel implementation
+SerialPlotterPanel::SerialPlotterPanel(const std::string& id)
+    : Panel(id, "Serial Plotter"), span_(500) {
+}
+
+std::string SerialPlotterPanel::GetContent() const {
+    std::ostringstream oss;
+    oss << "Series:\n";
+    for (const auto& series : series_) {
+        oss << "  " << series << "\n";
+    }
+    return oss.str();
+}
+
 } // namespace gui
 } // namespace esp32_ide
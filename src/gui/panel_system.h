@@ -6,6 +6,7 @@
 #include <memory>
 #include <map>
 #include <functional>
+#include <cstdint>
 
 namespace esp32_ide {
 namespace gui {
@@ -282,6 +283,23 @@ private:
     std::string preview_content_;
 };
 
+// Serial plotter panel; the window draws the plot into its bounds
+class SerialPlotterPanel : public Panel {
+public:
+    SerialPlotterPanel(const std::string& id);
+    ~SerialPlotterPanel() override = default;
+    
+    // Samples across the panel's width, following the newest
+    void SetSpan(uint64_t span) { span_ = span; }
+    uint64_t GetSpan() const { return span_; }
+    void SetLegend(const std::vector<std::string>& series) { series_ = series; }
+    std::string GetContent() const override;
+    
+private:
+    uint64_t span_;
+    std::vector<std::string> series_;
+};
+
 } // namespace gui
 } // namespace esp32_ide
 
@@ -214,7 +214,11 @@ std::vector<std::string> MultiBoardSupport::GetSupportedFeatures() const {
 }
 
 std::string MultiBoardSupport::GetBoardDefine() const {
-    const BoardConfig* board = GetSelectedBoard();
+    return GetBoardDefine(selected_board_id_);
+}
+
+std::string MultiBoardSupport::GetBoardDefine(const std::string& board_id) const {
+    const BoardConfig* board = GetBoardById(board_id);
     if (!board) return "";
     
     switch (board->family) {
@@ -227,7 +231,11 @@ std::string MultiBoardSupport::GetBoardDefine() const {
 }
 
 std::string MultiBoardSupport::GetCompilerFlags() const {
-    const BoardConfig* board = GetSelectedBoard();
+    return GetCompilerFlags(selected_board_id_);
+}
+
+std::string MultiBoardSupport::GetCompilerFlags(const std::string& board_id) const {
+    const BoardConfig* board = GetBoardById(board_id);
     if (!board) return "";
     
     std::ostringstream flags;
@@ -252,7 +260,11 @@ std::string MultiBoardSupport::GetCompilerFlags() const {
 }
 
 std::string MultiBoardSupport::GetLinkerFlags() const {
-    const BoardConfig* board = GetSelectedBoard();
+    return GetLinkerFlags(selected_board_id_);
+}
+
+std::string MultiBoardSupport::GetLinkerFlags(const std::string& board_id) const {
+    const BoardConfig* board = GetBoardById(board_id);
     if (!board) return "";
     
     std::ostringstream flags;
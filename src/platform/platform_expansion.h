@@ -70,11 +70,16 @@ public:
     bool HasFeature(const std::string& feature) const;
     std::vector<std::string> GetSupportedFeatures() const;
     
-    // Code generation helpers
+    // Code generation helpers (selected board)
     std::string GetBoardDefine() const;
     std::string GetCompilerFlags() const;
     std::string GetLinkerFlags() const;
     
+    // Same for any registered board, e.g. for matrix builds
+    std::string GetBoardDefine(const std::string& board_id) const;
+    std::string GetCompilerFlags(const std::string& board_id) const;
+    std::string GetLinkerFlags(const std::string& board_id) const;
+    
 private:
     std::map<std::string, BoardConfig> boards_;
     std::string selected_board_id_;
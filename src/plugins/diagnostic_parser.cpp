@@ -0,0 +1,301 @@
+#include "plugins/diagnostic_parser.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp32_ide {
+namespace plugins {
+
+namespace {
+
+// Diagnostic headers put the severity right after the location; anything
+// further into a line is message text, however long the line gets
+const size_t kHeaderSearchLimit = 4096;
+
+const char* const kSeverities[] = {
+    "fatal error", "error", "warning", "note", "remark",
+    // cppcheck
+    "style", "performance", "portability", "information"
+};
+
+bool StartsWith(const char* begin, const char* end, const char* prefix) {
+    size_t length = std::strlen(prefix);
+    return static_cast<size_t>(end - begin) >= length && std::memcmp(begin, prefix, length) == 0;
+}
+
+bool IsDigits(const char* begin, const char* end) {
+    if (begin == end) return false;
+    for (const char* p = begin; p < end; ++p) {
+        if (*p < '0' || *p > '9') return false;
+    }
+    return true;
+}
+
+int ToInt(const char* begin, const char* end) {
+    int value = 0;
+    for (const char* p = begin; p < end && value < 100000000; ++p) {
+        value = value * 10 + (*p - '0');
+    }
+    return value;
+}
+
+const char* FindLast(const char* begin, const char* end, char c) {
+    for (const char* p = end; p > begin; --p) {
+        if (p[-1] == c) return p - 1;
+    }
+    return nullptr;
+}
+
+// Splits "file[:line[:column]]"
+bool ParseLocation(const char* begin, const char* end, AnalysisResult& result) {
+    int numbers[2] = {0, 0};
+    int count = 0;
+    const char* file_end = end;
+    while (count < 2) {
+        const char* colon = FindLast(begin, file_end, ':');
+        if (!colon || !IsDigits(colon + 1, file_end)) break;
+        numbers[count++] = ToInt(colon + 1, file_end);
+        file_end = colon;
+    }
+    if (file_end == begin) return false;
+    result.file_path.assign(begin, file_end);
+    result.line_number = count == 2 ? numbers[1] : (count == 1 ? numbers[0] : 0);
+    result.column_number = count == 2 ? numbers[0] : 0;
+    return true;
+}
+
+// Moves a trailing " [-Wflag]" / " [check-name]" into rule_id
+void SplitRuleId(AnalysisResult& result) {
+    std::string& message = result.message;
+    if (message.size() < 4 || message.back() != ']') return;
+    size_t open = message.rfind(" [");
+    if (open == std::string::npos || open + 3 > message.size()) return;
+    for (size_t i = open + 2; i + 1 < message.size(); ++i) {
+        if (message[i] == ' ' || message[i] == '[') return;
+    }
+    result.rule_id = message.substr(open + 2, message.size() - open - 3);
+    message.erase(open);
+}
+
+const char* TrimLeft(const char* begin, const char* end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) ++begin;
+    return begin;
+}
+
+AnalysisResult MakeResult() {
+    AnalysisResult result;
+    result.line_number = 0;
+    result.column_number = 0;
+    return result;
+}
+
+} // namespace
+
+DiagnosticParser::DiagnosticParser(DiagnosticCallback callback)
+    : callback_(std::move(callback)), has_pending_(false), in_include_chain_(false), emitted_(0) {
+}
+
+std::string DiagnosticParser::NormalizeSeverity(const std::string& severity) {
+    if (severity == "error" || severity == "fatal error") return "error";
+    if (severity == "warning") return "warning";
+    if (severity == "style" || severity == "performance" || severity == "portability") return "hint";
+    return "info";
+}
+
+void DiagnosticParser::Feed(const char* data, size_t size) {
+    const char* end = data + size;
+    const char* line = data;
+
+    if (!partial_.empty()) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', size));
+        if (!newline) {
+            partial_.append(data, size);
+            return;
+        }
+        partial_.append(line, newline);
+        ParseLine(partial_.data(), partial_.data() + partial_.size());
+        partial_.clear();
+        line = newline + 1;
+    }
+
+    // Whole lines are parsed straight out of the caller's buffer
+    while (line < end) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!newline) {
+            partial_.assign(line, end);
+            return;
+        }
+        ParseLine(line, newline);
+        line = newline + 1;
+    }
+}
+
+void DiagnosticParser::Finish() {
+    if (!partial_.empty()) {
+        std::string last;
+        last.swap(partial_);
+        ParseLine(last.data(), last.data() + last.size());
+    }
+    Flush();
+    include_chain_.clear();
+    context_.clear();
+    in_include_chain_ = false;
+}
+
+void DiagnosticParser::Reset() {
+    partial_.clear();
+    include_chain_.clear();
+    context_.clear();
+    has_pending_ = false;
+    in_include_chain_ = false;
+    emitted_ = 0;
+}
+
+void DiagnosticParser::Flush() {
+    if (!has_pending_) return;
+    has_pending_ = false;
+    emitted_++;
+    if (callback_) callback_(pending_);
+}
+
+void DiagnosticParser::ParseLine(const char* begin, const char* end) {
+    if (end > begin && end[-1] == '\r') --end;
+    if (begin == end) return;
+
+    // "In file included from a.h:3,\n                 from main.cpp:1:"
+    static const char kIncludedFrom[] = "In file included from ";
+    if (StartsWith(begin, end, kIncludedFrom)) {
+        include_chain_.clear();
+        in_include_chain_ = true;
+        begin += sizeof(kIncludedFrom) - 1;
+        if (end > begin && (end[-1] == ',' || end[-1] == ':')) --end;
+        include_chain_.emplace_back(begin, end);
+        return;
+    }
+    if (*begin == ' ' || *begin == '\t') {
+        const char* text = TrimLeft(begin, end);
+        if (in_include_chain_ && StartsWith(text, end, "from ")) {
+            text += 5;
+            if (end > text && (end[-1] == ',' || end[-1] == ':')) --end;
+            include_chain_.emplace_back(text, end);
+        }
+        // Otherwise a source excerpt, caret or fix-it line
+        return;
+    }
+    in_include_chain_ = false;
+
+    // cppcheck: "[file:line]: (severity) message"
+    if (*begin == '[') {
+        const char* close = static_cast<const char*>(std::memchr(begin, ']', end - begin));
+        if (close && StartsWith(close, end, "]: (")) {
+            const char* severity = close + 4;
+            const char* severity_end = static_cast<const char*>(std::memchr(severity, ')', end - severity));
+            AnalysisResult result = MakeResult();
+            if (severity_end && ParseLocation(begin + 1, close, result)) {
+                Flush();
+                result.severity = NormalizeSeverity(std::string(severity, severity_end));
+                result.message.assign(TrimLeft(severity_end + 1, end), end);
+                SplitRuleId(result);
+                result.include_chain.swap(include_chain_);
+                result.context.swap(context_);
+                pending_ = std::move(result);
+                has_pending_ = true;
+                return;
+            }
+        }
+    }
+
+    const char* limit = begin + std::min(static_cast<size_t>(end - begin), kHeaderSearchLimit);
+    for (const char* colon = begin; colon < limit; ++colon) {
+        colon = static_cast<const char*>(std::memchr(colon, ':', limit - colon));
+        if (!colon) break;
+        if (colon + 1 >= end || colon[1] != ' ' || colon == begin) continue;
+        const char* rest = colon + 2;
+
+        // "file:line:col: severity: message"
+        for (const char* severity : kSeverities) {
+            size_t length = std::strlen(severity);
+            if (!StartsWith(rest, end, severity) || rest + length >= end || rest[length] != ':') {
+                continue;
+            }
+            AnalysisResult result = MakeResult();
+            if (!ParseLocation(begin, colon, result)) break;
+            result.severity = NormalizeSeverity(severity);
+            result.message.assign(TrimLeft(rest + length + 1, end), end);
+            SplitRuleId(result);
+
+            bool is_note = std::strcmp(severity, "note") == 0;
+            if (is_note && has_pending_) {
+                // Attached to the diagnostic it explains
+                std::string note(begin, colon);
+                note += ": " + result.message;
+                pending_.notes.push_back(std::move(note));
+                include_chain_.clear();
+                return;
+            }
+            Flush();
+            result.include_chain.swap(include_chain_);
+            result.context.swap(context_);
+            pending_ = std::move(result);
+            has_pending_ = true;
+            return;
+        }
+
+        // "file: In function 'int main()':", "ld: x.o: in function `main':"
+        if (end[-1] == ':' && (StartsWith(rest, end, "In ") || StartsWith(rest, end, "At ") ||
+                               StartsWith(rest, end, "in function "))) {
+            Flush();
+            context_.emplace_back(begin, end - 1);
+            return;
+        }
+
+        // "file:(.text+0x9): undefined reference to `foo'"
+        if (StartsWith(rest, end, "undefined reference to ") || StartsWith(rest, end, "multiple definition of ")) {
+            const char* section = begin;
+            while (section + 1 < colon && !(section[0] == ':' && section[1] == '(')) ++section;
+            AnalysisResult result = MakeResult();
+            result.file_path.assign(begin, section + 1 < colon ? section : colon);
+            result.severity = "error";
+            result.message.assign(rest, end);
+            Flush();
+            result.include_chain.swap(include_chain_);
+            result.context.swap(context_);
+            pending_ = std::move(result);
+            has_pending_ = true;
+            return;
+        }
+
+        // "file:line:col:   required from here"
+        if ((rest < end && *rest == ' ') || StartsWith(rest, end, "required ")) {
+            AnalysisResult location = MakeResult();
+            if (ParseLocation(begin, colon, location) && location.line_number > 0) {
+                std::string line(begin, colon);
+                line += ": ";
+                line.append(TrimLeft(rest, end), end);
+                if (has_pending_ && context_.empty()) {
+                    pending_.notes.push_back(std::move(line));
+                } else {
+                    context_.push_back(std::move(line));
+                }
+                return;
+            }
+        }
+    }
+
+    // Anything else ("compilation terminated.", make output, ...) closes the group
+    Flush();
+    include_chain_.clear();
+    context_.clear();
+}
+
+std::vector<AnalysisResult> DiagnosticParser::ParseAll(const std::string& output) {
+    std::vector<AnalysisResult> results;
+    DiagnosticParser parser([&results](const AnalysisResult& result) {
+        results.push_back(result);
+    });
+    parser.Feed(output);
+    parser.Finish();
+    return results;
+}
+
+} // namespace plugins
+} // namespace esp32_ide
@@ -0,0 +1,69 @@
+#ifndef DIAGNOSTIC_PARSER_H
+#define DIAGNOSTIC_PARSER_H
+
+#include "plugins/plugin_system.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace plugins {
+
+/**
+ * @brief Incremental parser for GCC/Clang-style diagnostics
+ *
+ * Output is fed in whatever chunks the tool writes it; lines are
+ * assembled internally and each one is classified by hand in a single
+ * pass, so multi-megabyte template dumps cost time linear in their size.
+ *
+ * Related lines are grouped into one AnalysisResult:
+ *   - "In file included from" chains become include_chain
+ *   - "In function ..." / "In instantiation of ..." and "required from"
+ *     lines before a diagnostic become its context
+ *   - notes (and "required from" lines) after it become its notes
+ * A diagnostic is emitted as soon as its group is known to be complete:
+ * when the next error or warning starts, at the first unrelated line, or
+ * at Finish(). Source excerpts and caret lines are skipped.
+ *
+ * Also understands cppcheck's "[file:line]: (severity) message" form and
+ * linker "undefined reference" lines.
+ */
+class DiagnosticParser {
+public:
+    using DiagnosticCallback = std::function<void(const AnalysisResult&)>;
+
+    explicit DiagnosticParser(DiagnosticCallback callback);
+
+    void Feed(const char* data, size_t size);
+    void Feed(const std::string& chunk) { Feed(chunk.data(), chunk.size()); }
+    // Ends the stream: parses a trailing partial line and emits what is pending
+    void Finish();
+    void Reset();
+
+    size_t GetDiagnosticCount() const { return emitted_; }
+
+    // Parses a complete buffer in one go
+    static std::vector<AnalysisResult> ParseAll(const std::string& output);
+
+    // "fatal error" -> "error", "note" -> "info", "style" -> "hint", ...
+    static std::string NormalizeSeverity(const std::string& severity);
+
+private:
+    DiagnosticCallback callback_;
+    std::string partial_;                       // incomplete last line
+    std::vector<std::string> include_chain_;    // waiting for its diagnostic
+    std::vector<std::string> context_;          // waiting for its diagnostic
+    AnalysisResult pending_;                    // diagnostic still collecting notes
+    bool has_pending_;
+    bool in_include_chain_;
+    size_t emitted_;
+
+    void ParseLine(const char* begin, const char* end);
+    void Flush();
+};
+
+} // namespace plugins
+} // namespace esp32_ide
+
+#endif // DIAGNOSTIC_PARSER_H
@@ -1,8 +1,20 @@
 #include "plugins/plugin_system.h"
+#include "plugins/diagnostic_parser.h"
 #include <sstream>
 #include <algorithm>
 #include <fstream>
-#include <regex>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <cerrno>
+#include <cstring>
+
+extern char** environ;
+#endif
 
 namespace esp32_ide {
 namespace plugins {
@@ -500,6 +512,8 @@ CustomCompilerManager::CustomCompilerManager() {
     xtensa.linker_path = "xtensa-esp32-elf-gcc";
     xtensa.default_flags = {"-mlongcalls", "-mtext-section-literals"};
     xtensa.output_extension = ".o";
+    xtensa.error_pattern = gcc.error_pattern;
+    xtensa.warning_pattern = gcc.warning_pattern;
     RegisterCompiler(xtensa);
     
     CompilerConfig armgcc;
@@ -509,6 +523,8 @@ CustomCompilerManager::CustomCompilerManager() {
     armgcc.linker_path = "arm-none-eabi-gcc";
     armgcc.default_flags = {"-mthumb", "-mcpu=cortex-m3"};
     armgcc.output_extension = ".o";
+    armgcc.error_pattern = gcc.error_pattern;
+    armgcc.warning_pattern = gcc.warning_pattern;
     RegisterCompiler(armgcc);
 }
 
@@ -520,127 +536,260 @@ void CustomCompilerManager::UnregisterCompiler(const std::string& compiler_id) {
     compilers_.erase(compiler_id);
 }
 
+namespace {
+
+// Diagnostics go to stderr; they are parsed while the tool is still running
+ToolExecutionResult RunWithDiagnostics(const std::vector<std::string>& argv,
+                                       const CustomCompilerManager::DiagnosticCallback& on_diagnostic) {
+    if (!on_diagnostic) {
+        return CustomCompilerManager::RunProcess(argv);
+    }
+    DiagnosticParser parser(on_diagnostic);
+    ToolExecutionResult result = CustomCompilerManager::RunProcess(
+        argv, [&parser](const char* data, size_t size, bool is_stderr) {
+            if (is_stderr) parser.Feed(data, size);
+        });
+    parser.Finish();
+    return result;
+}
+
+} // namespace
+
 ToolExecutionResult CustomCompilerManager::Compile(
     const std::string& compiler_id,
     const std::string& source_file,
     const std::string& output_file,
+    const std::vector<std::string>& extra_flags,
+    const DiagnosticCallback& on_diagnostic) {
+    
+    std::vector<std::string> argv = GetCompileCommand(compiler_id, source_file, output_file, extra_flags);
+    if (argv.empty()) {
+        ToolExecutionResult result;
+        result.exit_code = -1;
+        result.execution_time_ms = 0;
+        result.timed_out = false;
+        result.error_message = "Compiler not found: " + compiler_id;
+        return result;
+    }
+    return RunWithDiagnostics(argv, on_diagnostic);
+}
+
+ToolExecutionResult CustomCompilerManager::Link(
+    const std::string& compiler_id,
+    const std::vector<std::string>& object_files,
+    const std::string& output_file,
+    const std::vector<std::string>& libraries,
+    const std::vector<std::string>& extra_flags,
+    const DiagnosticCallback& on_diagnostic) {
+    
+    std::vector<std::string> argv = GetLinkCommand(compiler_id, object_files, output_file, libraries, extra_flags);
+    if (argv.empty()) {
+        ToolExecutionResult result;
+        result.exit_code = -1;
+        result.execution_time_ms = 0;
+        result.timed_out = false;
+        result.error_message = "Compiler not found: " + compiler_id;
+        return result;
+    }
+    return RunWithDiagnostics(argv, on_diagnostic);
+}
+
+ToolExecutionResult CustomCompilerManager::Preprocess(
+    const std::string& compiler_id,
+    const std::string& source_file,
     const std::vector<std::string>& extra_flags) {
     
-    ToolExecutionResult result;
-    result.exit_code = -1;
-    
-    auto it = compilers_.find(compiler_id);
-    if (it == compilers_.end()) {
+    std::vector<std::string> argv = GetCompileCommand(compiler_id, source_file, "-", extra_flags);
+    if (argv.empty()) {
+        ToolExecutionResult result;
+        result.exit_code = -1;
+        result.execution_time_ms = 0;
+        result.timed_out = false;
         result.error_message = "Compiler not found: " + compiler_id;
         return result;
     }
+    // Same flags as the compile, with -c swapped for -E and output on stdout
+    argv[1] = "-E";
+    return RunProcess(argv);
+}
+
+std::vector<std::string> CustomCompilerManager::GetCompileCommand(
+    const std::string& compiler_id,
+    const std::string& source_file,
+    const std::string& output_file,
+    const std::vector<std::string>& extra_flags) const {
     
-    const auto& config = it->second;
-    
-    // Build command
-    std::ostringstream cmd;
-    cmd << config.compiler_path << " -c ";
-    
-    for (const auto& flag : config.default_flags) {
-        cmd << flag << " ";
-    }
+    std::vector<std::string> argv;
+    auto it = compilers_.find(compiler_id);
+    if (it == compilers_.end()) return argv;
     
-    for (const auto& flag : extra_flags) {
-        cmd << flag << " ";
-    }
+    const auto& config = it->second;
+    argv.push_back(config.compiler_path);
+    argv.push_back("-c");
+    argv.insert(argv.end(), config.default_flags.begin(), config.default_flags.end());
+    argv.insert(argv.end(), extra_flags.begin(), extra_flags.end());
     
     for (const auto& inc : config.include_paths) {
-        cmd << "-I" << inc << " ";
+        argv.push_back("-I" + inc);
     }
     
     for (const auto& def : config.defines) {
-        cmd << "-D" << def.first << "=" << def.second << " ";
+        argv.push_back("-D" + def.first + "=" + def.second);
     }
     
-    cmd << "-o " << output_file << " " << source_file;
-    
-    // Simulated compilation
-    result.exit_code = 0;
-    result.stdout_output = "Compiling " + source_file + " -> " + output_file;
-    result.execution_time_ms = 500;
-    
-    return result;
+    argv.push_back("-o");
+    argv.push_back(output_file);
+    argv.push_back(source_file);
+    return argv;
 }
 
-ToolExecutionResult CustomCompilerManager::Link(
+std::vector<std::string> CustomCompilerManager::GetLinkCommand(
     const std::string& compiler_id,
     const std::vector<std::string>& object_files,
     const std::string& output_file,
-    const std::vector<std::string>& libraries) {
+    const std::vector<std::string>& libraries,
+    const std::vector<std::string>& extra_flags) const {
+    
+    std::vector<std::string> argv;
+    auto it = compilers_.find(compiler_id);
+    if (it == compilers_.end()) return argv;
     
+    const auto& config = it->second;
+    argv.push_back(config.linker_path.empty() ? config.compiler_path : config.linker_path);
+    argv.insert(argv.end(), extra_flags.begin(), extra_flags.end());
+    argv.insert(argv.end(), object_files.begin(), object_files.end());
+    
+    for (const auto& lib_path : config.library_paths) {
+        argv.push_back("-L" + lib_path);
+    }
+    
+    for (const auto& lib : libraries) {
+        argv.push_back("-l" + lib);
+    }
+    
+    argv.push_back("-o");
+    argv.push_back(output_file);
+    return argv;
+}
+
+ToolExecutionResult CustomCompilerManager::RunProcess(const std::vector<std::string>& argv,
+                                                      const OutputChunkCallback& on_output) {
     ToolExecutionResult result;
     result.exit_code = -1;
+    result.execution_time_ms = 0;
+    result.timed_out = false;
     
-    auto it = compilers_.find(compiler_id);
-    if (it == compilers_.end()) {
-        result.error_message = "Compiler not found: " + compiler_id;
+    if (argv.empty()) {
+        result.error_message = "Empty command";
         return result;
     }
     
-    const auto& config = it->second;
+#ifdef _WIN32
+    (void)on_output;
+    result.error_message = "Process execution is not supported on this platform";
+    return result;
+#else
+    auto start = std::chrono::steady_clock::now();
+    
+    // Close-on-exec from the start: builds run several of these at once, and
+    // a tool spawned by another thread must not inherit this job's write
+    // ends, or this job sees no EOF until that tool exits too. dup2 in the
+    // child clears the flag on its stdout and stderr.
+    int out_pipe[2];
+    int err_pipe[2];
+    if (pipe2(out_pipe, O_CLOEXEC) != 0) {
+        result.error_message = std::strerror(errno);
+        return result;
+    }
+    if (pipe2(err_pipe, O_CLOEXEC) != 0) {
+        result.error_message = std::strerror(errno);
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        return result;
+    }
     
-    // Build command
-    std::ostringstream cmd;
-    cmd << config.linker_path << " ";
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, err_pipe[1], STDERR_FILENO);
     
-    for (const auto& obj : object_files) {
-        cmd << obj << " ";
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
     }
+    args.push_back(nullptr);
     
-    for (const auto& lib_path : config.library_paths) {
-        cmd << "-L" << lib_path << " ";
-    }
+    // posix_spawn avoids copying the parent's page tables, which matters when
+    // the IDE launches hundreds of compiler processes per build
+    pid_t pid = 0;
+    int spawn_error = posix_spawnp(&pid, args[0], &actions, nullptr, args.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(out_pipe[1]);
+    close(err_pipe[1]);
     
-    for (const auto& lib : libraries) {
-        cmd << "-l" << lib << " ";
+    if (spawn_error != 0) {
+        close(out_pipe[0]);
+        close(err_pipe[0]);
+        result.error_message = "Failed to run " + argv[0] + ": " + std::strerror(spawn_error);
+        return result;
     }
     
-    cmd << "-o " << output_file;
+    // Drain both pipes together so a chatty compiler cannot block on a full one
+    struct pollfd fds[2] = {{out_pipe[0], POLLIN, 0}, {err_pipe[0], POLLIN, 0}};
+    std::string* sinks[2] = {&result.stdout_output, &result.stderr_output};
+    int open_fds = 2;
+    char buffer[4096];
+    while (open_fds > 0) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < 2; ++i) {
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+            ssize_t n = read(fds[i].fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                sinks[i]->append(buffer, static_cast<size_t>(n));
+                if (on_output) on_output(buffer, static_cast<size_t>(n), i == 1);
+            } else if (n == 0 || errno != EINTR) {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+                --open_fds;
+            }
+        }
+    }
+    for (auto& entry : fds) {
+        if (entry.fd >= 0) close(entry.fd);
+    }
     
-    // Simulated linking
-    result.exit_code = 0;
-    result.stdout_output = "Linking " + std::to_string(object_files.size()) + 
-                           " objects -> " + output_file;
-    result.execution_time_ms = 200;
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    if (WIFEXITED(status)) {
+        result.exit_code = WEXITSTATUS(status);
+        if (result.exit_code == 127 && result.stderr_output.empty()) {
+            result.error_message = "Command not found: " + argv[0];
+        }
+    } else if (WIFSIGNALED(status)) {
+        result.exit_code = 128 + WTERMSIG(status);
+        result.error_message = argv[0] + " terminated by signal " + std::to_string(WTERMSIG(status));
+    }
     
+    result.execution_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
     return result;
+#endif
 }
 
 std::vector<AnalysisResult> CustomCompilerManager::ParseCompilerOutput(
     const std::string& compiler_id,
     const std::string& output) {
     
-    std::vector<AnalysisResult> results;
-    
-    auto it = compilers_.find(compiler_id);
-    if (it == compilers_.end()) return results;
-    
-    const auto& config = it->second;
-    if (config.error_pattern.empty()) return results;
-    
-    std::regex pattern(config.error_pattern);
-    std::smatch match;
-    std::string::const_iterator searchStart(output.cbegin());
-    
-    while (std::regex_search(searchStart, output.cend(), match, pattern)) {
-        AnalysisResult result;
-        if (match.size() >= 5) {
-            result.file_path = match[1];
-            result.line_number = std::stoi(match[2]);
-            result.column_number = std::stoi(match[3]);
-            result.severity = match[4];
-            result.message = match[5];
-        }
-        results.push_back(result);
-        searchStart = match.suffix().first;
+    if (compilers_.find(compiler_id) == compilers_.end()) {
+        return std::vector<AnalysisResult>();
     }
-    
-    return results;
+    return DiagnosticParser::ParseAll(output);
 }
 
 CompilerConfig CustomCompilerManager::GetCompilerConfig(
@@ -901,28 +1050,9 @@ std::string AnalysisToolRunner::GenerateReport(
 }
 
 std::vector<AnalysisResult> AnalysisToolRunner::ParseAnalyzerOutput(
-    const std::string& output,
-    const std::string& pattern) {
-    
-    std::vector<AnalysisResult> results;
-    
-    std::regex regex(pattern);
-    std::smatch match;
-    std::string::const_iterator searchStart(output.cbegin());
-    
-    while (std::regex_search(searchStart, output.cend(), match, regex)) {
-        AnalysisResult result;
-        if (match.size() >= 4) {
-            result.file_path = match[1];
-            result.line_number = std::stoi(match[2]);
-            result.severity = match[3];
-            result.message = match[4];
-        }
-        results.push_back(result);
-        searchStart = match.suffix().first;
-    }
+    const std::string& output) {
     
-    return results;
+    return DiagnosticParser::ParseAll(output);
 }
 
 // ============================================================================
@@ -269,8 +269,8 @@ struct CompilerConfig {
     std::vector<std::string> library_paths;
     std::map<std::string, std::string> defines;
     std::string output_extension;
-    std::string error_pattern;  // Regex for parsing errors
-    std::string warning_pattern;  // Regex for parsing warnings
+    std::string error_pattern;  // Informational; output is parsed as GCC/Clang diagnostics
+    std::string warning_pattern;
 };
 
 /**
@@ -284,6 +284,9 @@ struct AnalysisResult {
     std::string message;
     std::string rule_id;
     std::string suggestion;
+    std::vector<std::string> include_chain;  // "In file included from", innermost first
+    std::vector<std::string> context;        // "In function ...", "required from ..." lines before it
+    std::vector<std::string> notes;          // notes after it, "file:line:col: text"
 };
 
 /**
@@ -345,17 +348,45 @@ public:
     void RegisterCompiler(const CompilerConfig& config);
     void UnregisterCompiler(const std::string& compiler_id);
     
-    // Compilation
+    // Called for each diagnostic as soon as the tool has finished printing it
+    using DiagnosticCallback = std::function<void(const AnalysisResult&)>;
+    // Raw output as it is read from the process
+    using OutputChunkCallback = std::function<void(const char* data, size_t size, bool is_stderr)>;
+    
+    // Compilation (runs the configured toolchain and waits for it)
     ToolExecutionResult Compile(const std::string& compiler_id,
                                  const std::string& source_file,
                                  const std::string& output_file,
-                                 const std::vector<std::string>& extra_flags = {});
+                                 const std::vector<std::string>& extra_flags = {},
+                                 const DiagnosticCallback& on_diagnostic = nullptr);
     ToolExecutionResult Link(const std::string& compiler_id,
                               const std::vector<std::string>& object_files,
                               const std::string& output_file,
-                              const std::vector<std::string>& libraries = {});
-    
-    // Error parsing
+                              const std::vector<std::string>& libraries = {},
+                              const std::vector<std::string>& extra_flags = {},
+                              const DiagnosticCallback& on_diagnostic = nullptr);
+    
+    // Runs only the preprocessor; the expanded source is in stdout_output
+    ToolExecutionResult Preprocess(const std::string& compiler_id,
+                                    const std::string& source_file,
+                                    const std::vector<std::string>& extra_flags = {});
+    
+    // Command lines as argument vectors; empty if the compiler is unknown
+    std::vector<std::string> GetCompileCommand(const std::string& compiler_id,
+                                               const std::string& source_file,
+                                               const std::string& output_file,
+                                               const std::vector<std::string>& extra_flags = {}) const;
+    std::vector<std::string> GetLinkCommand(const std::string& compiler_id,
+                                            const std::vector<std::string>& object_files,
+                                            const std::string& output_file,
+                                            const std::vector<std::string>& libraries = {},
+                                            const std::vector<std::string>& extra_flags = {}) const;
+    
+    // Runs a program without a shell, capturing stdout and stderr
+    static ToolExecutionResult RunProcess(const std::vector<std::string>& argv,
+                                          const OutputChunkCallback& on_output = nullptr);
+    
+    // Error parsing (GCC/Clang format, see DiagnosticParser)
     std::vector<AnalysisResult> ParseCompilerOutput(const std::string& compiler_id,
                                                       const std::string& output);
     
@@ -406,13 +437,13 @@ public:
 private:
     struct AnalyzerConfig {
         std::string command;
-        std::string output_pattern;
+        std::string output_pattern;  // Informational; see ParseAnalyzerOutput
     };
     
     std::map<std::string, AnalyzerConfig> analyzers_;
     
-    std::vector<AnalysisResult> ParseAnalyzerOutput(const std::string& output,
-                                                      const std::string& pattern);
+    // Analyzers are expected to print GCC-style or cppcheck "[file:line]" lines
+    std::vector<AnalysisResult> ParseAnalyzerOutput(const std::string& output);
 };
 
 // ============================================================================
@@ -401,6 +401,17 @@ void PureCRenderer::DrawLine2D(int x1, int y1, int x2, int y2, const Color& colo
     }
 }
 
+void PureCRenderer::DrawVerticalLine(int x, int y1, int y2, const Color& color) {
+    if (x < 0 || x >= width_) return;
+    if (y1 > y2) std::swap(y1, y2);
+    y1 = std::max(y1, 0);
+    y2 = std::min(y2, height_ - 1);
+    uint32_t rgba = color.ToRGBA();
+    for (int y = y1; y <= y2; y++) {
+        framebuffer_[y * width_ + x] = rgba;
+    }
+}
+
 bool PureCRenderer::DepthTest(int x, int y, float depth) {
     if (x < 0 || x >= width_ || y < 0 || y >= height_) return false;
     
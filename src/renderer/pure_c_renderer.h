@@ -91,6 +91,11 @@ public:
     void DrawCube(const Vector3D& center, float size, const Color& color);
     void DrawSphere(const Vector3D& center, float radius, const Color& color);
 
+    // 2D rendering primitives (screen coordinates, clipped to the framebuffer)
+    void DrawPixel(int x, int y, const Color& color);
+    void DrawLine2D(int x1, int y1, int x2, int y2, const Color& color);
+    void DrawVerticalLine(int x, int y1, int y2, const Color& color);
+
     // 5D extended rendering (for advanced visualization)
     void DrawLine5D(const Vector5D& start, const Vector5D& end, const Color& color);
     void DrawHypercube(const Vector5D& center, float size, const Color& color);
@@ -135,8 +140,6 @@ private:
     // Helper functions
     Vector3D Project3D(const Vector3D& point);
     Vector3D Project5DTo3D(const Vector5D& point);
-    void DrawPixel(int x, int y, const Color& color);
-    void DrawLine2D(int x1, int y1, int x2, int y2, const Color& color);
     bool DepthTest(int x, int y, float depth);
 };
 
@@ -0,0 +1,492 @@
+#include "search/parallel_grep.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace esp32_ide {
+namespace search {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bound on queued paths so the walker cannot run arbitrarily far ahead
+const size_t kMaxQueuedFiles = 4096;
+
+inline bool EqualFolded(const char* text, const char* needle, size_t length) {
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) !=
+            static_cast<unsigned char>(needle[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool EqualAt(const char* text, const std::string& needle, bool case_sensitive) {
+    if (case_sensitive) {
+        return std::memcmp(text, needle.data(), needle.size()) == 0;
+    }
+    return EqualFolded(text, needle.data(), needle.size());
+}
+
+std::string FoldCase(const std::string& text) {
+    std::string result = text;
+    for (auto& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+} // namespace
+
+ParallelGrep::ParallelGrep()
+    : thread_count_(0),
+      max_file_size_(16 * 1024 * 1024),
+      generation_(0),
+      cancelled_(false),
+      limit_reached_(false),
+      stopping_(false),
+      active_workers_(0),
+      walk_done_(true),
+      files_scanned_(0),
+      files_skipped_(0),
+      hit_count_(0),
+      elapsed_ms_(0.0),
+      first_hit_ms_(-1.0),
+      finished_(true) {
+}
+
+ParallelGrep::~ParallelGrep() {
+    Cancel();
+    Wait();
+}
+
+bool ParallelGrep::Start(const std::vector<std::string>& paths, const std::string& query,
+                         const SearchOptions& options, HitCallback callback) {
+    // A new query supersedes whatever is still running
+    Cancel();
+    Wait();
+
+    auto matcher = std::make_unique<ContentMatcher>(query, options);
+    if (!matcher->IsValid()) {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        error_ = matcher->GetError();
+        return false;
+    }
+
+    query_ = query;
+    options_ = options;
+    callback_ = callback;
+
+    std::string literal;
+    for (const auto& candidate : matcher->GetRequiredLiterals()) {
+        if (candidate.size() > literal.size()) {
+            literal = candidate;
+        }
+    }
+    prefilter_ = options_.case_sensitive ? literal : FoldCase(literal);
+    matcher_ = std::move(matcher);
+
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        error_.clear();
+        pending_hits_.clear();
+        elapsed_ms_ = 0.0;
+        first_hit_ms_ = -1.0;
+        finished_ = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        work_queue_.clear();
+        walk_done_ = false;
+    }
+
+    files_scanned_ = 0;
+    files_skipped_ = 0;
+    hit_count_ = 0;
+    cancelled_ = false;
+    limit_reached_ = false;
+    stopping_ = false;
+    ++generation_;
+    start_time_ = std::chrono::steady_clock::now();
+
+    size_t workers = thread_count_;
+    if (workers == 0) {
+        workers = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    active_workers_ = workers;
+    walker_ = std::thread(&ParallelGrep::WalkPaths, this, paths);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&ParallelGrep::WorkerLoop, this);
+    }
+    return true;
+}
+
+void ParallelGrep::Cancel() {
+    cancelled_ = true;
+    Stop();
+}
+
+void ParallelGrep::Stop() {
+    {
+        // Under the lock, so a worker between its predicate check and its wait sees it
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        stopping_ = true;
+    }
+    queue_cv_.notify_all();
+}
+
+void ParallelGrep::Wait() {
+    if (walker_.joinable()) {
+        walker_.join();
+    }
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+bool ParallelGrep::IsRunning() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    return !finished_;
+}
+
+std::vector<SearchHit> ParallelGrep::PollHits(size_t max_hits) {
+    std::vector<SearchHit> hits;
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    while (!pending_hits_.empty() && hits.size() < max_hits) {
+        hits.push_back(std::move(pending_hits_.front()));
+        pending_hits_.pop_front();
+    }
+    return hits;
+}
+
+ParallelGrep::Stats ParallelGrep::GetStats() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    Stats stats;
+    stats.files_scanned = files_scanned_;
+    stats.files_skipped = files_skipped_;
+    stats.hits = std::min(hit_count_.load(), options_.max_results);
+    stats.cancelled = cancelled_;
+    stats.limit_reached = limit_reached_;
+    stats.finished = finished_;
+    stats.elapsed_ms = finished_ ? elapsed_ms_ : ElapsedMs();
+    stats.first_hit_ms = first_hit_ms_;
+    return stats;
+}
+
+std::string ParallelGrep::GetError() const {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    return error_;
+}
+
+double ParallelGrep::ElapsedMs() const {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time_).count();
+}
+
+// ----------------------------------------------------------------------------
+// Walker
+// ----------------------------------------------------------------------------
+
+bool ParallelGrep::PushWork(std::string path) {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    queue_cv_.wait(lock, [this]() {
+        return stopping_ || work_queue_.size() < kMaxQueuedFiles;
+    });
+    if (stopping_) {
+        return false;
+    }
+    work_queue_.push_back(std::move(path));
+    lock.unlock();
+    queue_cv_.notify_one();
+    return true;
+}
+
+void ParallelGrep::WalkPaths(std::vector<std::string> paths) {
+    for (const auto& root : paths) {
+        if (stopping_) {
+            break;
+        }
+
+        std::error_code ec;
+        if (fs::is_regular_file(root, ec)) {
+            if (!PushWork(root)) {
+                break;
+            }
+            continue;
+        }
+
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            continue;
+        }
+        for (; it != fs::recursive_directory_iterator() && !stopping_; it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+            std::string name = it->path().filename().string();
+            if (it->is_directory(ec)) {
+                if (!name.empty() && name[0] == '.') {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (it->is_regular_file(ec) && !PushWork(it->path().string())) {
+                break;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        walk_done_ = true;
+    }
+    queue_cv_.notify_all();
+}
+
+// ----------------------------------------------------------------------------
+// Workers
+// ----------------------------------------------------------------------------
+
+void ParallelGrep::WorkerLoop() {
+    std::string buffer;
+    std::vector<SearchHit> hits;
+
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            queue_cv_.wait(lock, [this]() {
+                return stopping_ || walk_done_ || !work_queue_.empty();
+            });
+            if (stopping_ || work_queue_.empty()) {
+                break;
+            }
+            path = std::move(work_queue_.front());
+            work_queue_.pop_front();
+        }
+        queue_cv_.notify_all();
+
+        ScanFile(path, buffer, hits);
+        if (!hits.empty()) {
+            EmitHits(hits);
+        }
+    }
+
+    if (--active_workers_ == 0) {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        elapsed_ms_ = ElapsedMs();
+        finished_ = true;
+    }
+}
+
+void ParallelGrep::ScanFile(const std::string& path, std::string& buffer, std::vector<SearchHit>& hits) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return;
+    }
+    std::streamoff size = file.tellg();
+    if (size < 0 || static_cast<size_t>(size) > max_file_size_) {
+        ++files_skipped_;
+        return;
+    }
+    buffer.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(&buffer[0], size);
+    buffer.resize(static_cast<size_t>(file.gcount()));
+    ++files_scanned_;
+
+    if (TrigramIndex::LooksBinary(buffer)) {
+        ++files_skipped_;
+        return;
+    }
+
+    // Reject the whole file before any per-line work
+    if (!prefilter_.empty() &&
+        FindLiteral(buffer.data(), buffer.data() + buffer.size(), prefilter_,
+                    options_.case_sensitive) == buffer.data() + buffer.size()) {
+        ++files_skipped_;
+        return;
+    }
+
+    if (options_.regex) {
+        matcher_->Match(path, buffer, hits, options_.max_results);
+    } else {
+        ScanLiteral(path, buffer, hits);
+    }
+}
+
+void ParallelGrep::ScanLiteral(const std::string& path, const std::string& content,
+                               std::vector<SearchHit>& hits) {
+    // Jump from match to match and count newlines only in between, rather
+    // than testing every line
+    const char* data = content.data();
+    const char* end = data + content.size();
+    const char* cursor = data;
+    const char* counted = data;
+    size_t line = 1;
+
+    while (cursor < end && hits.size() < options_.max_results && !stopping_) {
+        const char* match = FindLiteral(cursor, end, prefilter_, options_.case_sensitive);
+        if (match == end) {
+            break;
+        }
+
+        line += static_cast<size_t>(std::count(counted, match, '\n'));
+        const char* line_start = match;
+        while (line_start > data && *(line_start - 1) != '\n') {
+            --line_start;
+        }
+        const char* line_end = static_cast<const char*>(
+            std::memchr(match, '\n', static_cast<size_t>(end - match)));
+        if (!line_end) {
+            line_end = end;
+        }
+        const char* text_end = line_end;
+        if (text_end > line_start && *(text_end - 1) == '\r') {
+            --text_end;
+        }
+
+        hits.push_back({path, line, static_cast<size_t>(match - line_start) + 1,
+                        std::string(line_start, text_end)});
+
+        if (line_end == end) {
+            break;
+        }
+        cursor = line_end + 1;
+        counted = cursor;
+        ++line;
+    }
+}
+
+void ParallelGrep::EmitHits(std::vector<SearchHit>& hits) {
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        for (auto& hit : hits) {
+            if (stopping_) {
+                break;
+            }
+            if (hit_count_ >= options_.max_results) {
+                // More hits than asked for: the search is done, not cancelled
+                limit_reached_ = true;
+                Stop();
+                break;
+            }
+            if (hit_count_++ == 0) {
+                first_hit_ms_ = ElapsedMs();
+            }
+            pending_hits_.push_back(std::move(hit));
+        }
+    }
+    hits.clear();
+    if (callback_) {
+        DeliverHits();
+    }
+}
+
+void ParallelGrep::DeliverHits() {
+    // One worker at a time takes the queued hits and calls back with the
+    // result lock released; the rest return to scanning. After letting go
+    // it looks again, since a hit queued meanwhile found the lock taken.
+    while (callback_mutex_.try_lock()) {
+        std::deque<SearchHit> batch;
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(result_mutex_);
+                batch.swap(pending_hits_);
+            }
+            if (batch.empty()) {
+                break;
+            }
+            for (const auto& hit : batch) {
+                if (cancelled_) {
+                    break;
+                }
+                callback_(hit);
+            }
+            batch.clear();
+        }
+        callback_mutex_.unlock();
+
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        if (pending_hits_.empty()) {
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// SIMD literal search
+// ----------------------------------------------------------------------------
+
+const char* ParallelGrep::FindLiteral(const char* begin, const char* end,
+                                      const std::string& needle, bool case_sensitive) {
+    const size_t length = needle.size();
+    if (length == 0) {
+        return begin;
+    }
+    if (static_cast<size_t>(end - begin) < length) {
+        return end;
+    }
+
+    const char* last_start = end - length;   // last position a match can begin
+    const char* p = begin;
+
+#if defined(__SSE2__)
+    // Compare the first and last needle bytes against 16 candidate positions
+    // at once and only verify positions where both agree.
+    const char first = needle[0];
+    const char last = needle[length - 1];
+    const char first_alt = case_sensitive ? first
+        : static_cast<char>(std::toupper(static_cast<unsigned char>(first)));
+    const char last_alt = case_sensitive ? last
+        : static_cast<char>(std::toupper(static_cast<unsigned char>(last)));
+
+    const __m128i first_lo = _mm_set1_epi8(first);
+    const __m128i first_hi = _mm_set1_epi8(first_alt);
+    const __m128i last_lo = _mm_set1_epi8(last);
+    const __m128i last_hi = _mm_set1_epi8(last_alt);
+
+    while (p + 16 <= last_start + 1) {
+        __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + length - 1));
+        __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_lo),
+                                        _mm_cmpeq_epi8(block_first, first_hi));
+        __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_lo),
+                                       _mm_cmpeq_epi8(block_last, last_hi));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last)));
+
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (EqualAt(p + bit, needle, case_sensitive)) {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+#endif
+
+    // Scalar tail (and the whole search on targets without SSE2)
+    for (; p <= last_start; ++p) {
+        if (EqualAt(p, needle, case_sensitive)) {
+            return p;
+        }
+    }
+    return end;
+}
+
+} // namespace search
+} // namespace esp32_ide
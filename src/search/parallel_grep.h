@@ -0,0 +1,137 @@
+#ifndef PARALLEL_GREP_H
+#define PARALLEL_GREP_H
+
+#include "search/project_search.h"
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace esp32_ide {
+namespace search {
+
+/**
+ * @brief Unindexed, streaming find-in-files
+ *
+ * Intended for one-off paths and freshly cloned trees where building a
+ * TrigramIndex is not worth it. A walker thread streams file paths into a
+ * work queue while worker threads read each file, reject it with a SIMD
+ * literal prefilter and only then run the full matcher.
+ *
+ * Hits are streamed as soon as they are found, either through a callback
+ * (invoked from worker threads, serialized so output never interleaves) or
+ * queued for the consumer to drain with PollHits() on its own thread. The
+ * callback runs outside the result lock: one worker hands out the queued
+ * hits while the others keep scanning, so a slow consumer holds up only
+ * the worker delivering to it.
+ *
+ * Starting a new search cancels the one in flight. Do not call Start() or
+ * Wait() from inside the hit callback.
+ */
+class ParallelGrep {
+public:
+    using HitCallback = std::function<void(const SearchHit& hit)>;
+
+    struct Stats {
+        size_t files_scanned;
+        size_t files_skipped;     // rejected by the prefilter or binary
+        size_t hits;
+        bool cancelled;           // by Cancel() or a newer Start()
+        bool limit_reached;       // stopped early at options.max_results
+        bool finished;
+        double elapsed_ms;
+        double first_hit_ms;      // negative until the first hit arrives
+    };
+
+    ParallelGrep();
+    ~ParallelGrep();
+
+    ParallelGrep(const ParallelGrep&) = delete;
+    ParallelGrep& operator=(const ParallelGrep&) = delete;
+
+    // Search control
+    bool Start(const std::vector<std::string>& paths, const std::string& query,
+               const SearchOptions& options = SearchOptions(), HitCallback callback = nullptr);
+    void Cancel();
+    void Wait();
+    bool IsRunning() const;
+
+    // Consumer-side draining when no callback is set
+    std::vector<SearchHit> PollHits(size_t max_hits = SIZE_MAX);
+
+    // Status
+    Stats GetStats() const;
+    std::string GetError() const;
+    uint64_t GetGeneration() const { return generation_.load(); }
+
+    // Configuration
+    void SetThreadCount(size_t count) { thread_count_ = count; }
+    size_t GetThreadCount() const { return thread_count_; }
+    void SetMaxFileSize(size_t bytes) { max_file_size_ = bytes; }
+
+    // Literal search with a SIMD first/last byte filter. For case-insensitive
+    // search the needle must already be lower-case.
+    static const char* FindLiteral(const char* begin, const char* end,
+                                   const std::string& needle, bool case_sensitive);
+
+private:
+    // Search parameters for the current generation
+    std::string query_;
+    std::string prefilter_;
+    SearchOptions options_;
+    std::unique_ptr<ContentMatcher> matcher_;
+    HitCallback callback_;
+    std::string error_;
+    size_t thread_count_;
+    size_t max_file_size_;
+
+    // Threads
+    std::thread walker_;
+    std::vector<std::thread> workers_;
+    std::atomic<uint64_t> generation_;
+    std::atomic<bool> cancelled_;
+    std::atomic<bool> limit_reached_;
+    std::atomic<bool> stopping_;          // either of the above; ends the walk and the scans
+    std::atomic<size_t> active_workers_;
+
+    // Work queue
+    mutable std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::string> work_queue_;
+    bool walk_done_;
+
+    // Results
+    mutable std::mutex result_mutex_;
+    std::mutex callback_mutex_;           // held by the worker handing hits to the callback
+    std::deque<SearchHit> pending_hits_;
+    std::atomic<size_t> files_scanned_;
+    std::atomic<size_t> files_skipped_;
+    std::atomic<size_t> hit_count_;
+    std::chrono::steady_clock::time_point start_time_;
+    double elapsed_ms_;
+    double first_hit_ms_;
+    bool finished_;
+
+    void WalkPaths(std::vector<std::string> paths);
+    void WorkerLoop();
+    void ScanFile(const std::string& path, std::string& buffer, std::vector<SearchHit>& hits);
+    void ScanLiteral(const std::string& path, const std::string& content, std::vector<SearchHit>& hits);
+    void EmitHits(std::vector<SearchHit>& hits);
+    void DeliverHits();
+    void Stop();
+    bool PushWork(std::string path);
+    double ElapsedMs() const;
+};
+
+} // namespace search
+} // namespace esp32_ide
+
+#endif // PARALLEL_GREP_H
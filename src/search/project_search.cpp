@@ -0,0 +1,933 @@
+#include "search/project_search.h"
+#include "file_manager/file_manager.h"
+#include "file_manager/file_tree.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <regex>
+#include <sstream>
+
+namespace esp32_ide {
+namespace search {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// On-disk layout of a saved index (native byte order)
+//   [Header][documents][trigram table][posting lists]
+// Posting lists are delta + varint encoded document ids.
+const char kIndexMagic[4] = {'E', '3', 'T', 'I'};
+const uint32_t kIndexVersion = 1;
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t doc_count;
+    uint32_t trigram_count;
+    uint64_t docs_offset;
+    uint64_t docs_size;
+    uint64_t trigrams_offset;
+    uint64_t postings_offset;
+    uint64_t postings_size;
+};
+
+struct TrigramEntry {
+    uint32_t trigram;
+    uint32_t count;
+    uint64_t postings_offset;
+};
+
+inline unsigned char FoldByte(unsigned char c) {
+    return static_cast<unsigned char>(std::tolower(c));
+}
+
+std::string FoldCase(const std::string& text) {
+    std::string result = text;
+    for (auto& c : result) {
+        c = static_cast<char>(FoldByte(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+void AppendVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+template <typename T>
+void AppendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadRaw(const unsigned char*& cursor, const unsigned char* end, T& value) {
+    if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(&value, cursor, sizeof(T));
+    cursor += sizeof(T);
+    return true;
+}
+
+std::vector<uint32_t> Intersect(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+} // namespace
+
+// ============================================================================
+// ContentMatcher
+// ============================================================================
+
+struct ContentMatcher::CompiledRegex {
+    std::regex pattern;
+};
+
+ContentMatcher::ContentMatcher(const std::string& query, const SearchOptions& options)
+    : query_(query), options_(options), valid_(!query.empty()) {
+    if (!valid_) {
+        error_ = "Empty query";
+        return;
+    }
+
+    if (options_.regex) {
+        literals_ = TrigramIndex::ExtractRegexLiterals(query);
+        try {
+            auto flags = std::regex::ECMAScript | std::regex::optimize;
+            if (!options_.case_sensitive) {
+                flags |= std::regex::icase;
+            }
+            regex_ = std::make_unique<CompiledRegex>();
+            regex_->pattern = std::regex(query, flags);
+        } catch (const std::regex_error& e) {
+            valid_ = false;
+            error_ = std::string("Invalid regular expression: ") + e.what();
+            regex_.reset();
+        }
+    } else {
+        literals_.push_back(query);
+    }
+
+    for (const auto& literal : literals_) {
+        if (literal.size() > longest_literal_.size()) {
+            longest_literal_ = literal;
+        }
+    }
+    longest_literal_ = FoldCase(longest_literal_);
+    folded_query_ = FoldCase(query_);
+}
+
+ContentMatcher::~ContentMatcher() = default;
+
+bool ContentMatcher::MatchLine(const char* begin, const char* end, size_t& column) const {
+    if (!options_.regex) {
+        const char* found;
+        if (options_.case_sensitive) {
+            found = std::search(begin, end, query_.begin(), query_.end());
+        } else {
+            found = std::search(begin, end, folded_query_.begin(), folded_query_.end(),
+                                [](char a, char b) {
+                                    return FoldByte(static_cast<unsigned char>(a)) ==
+                                           static_cast<unsigned char>(b);
+                                });
+        }
+        if (found == end) {
+            return false;
+        }
+        column = static_cast<size_t>(found - begin) + 1;
+        return true;
+    }
+
+    // Cheap literal prefilter before running the regex engine
+    if (!longest_literal_.empty()) {
+        auto found = std::search(begin, end, longest_literal_.begin(), longest_literal_.end(),
+                                 [](char a, char b) {
+                                     return FoldByte(static_cast<unsigned char>(a)) ==
+                                            static_cast<unsigned char>(b);
+                                 });
+        if (found == end) {
+            return false;
+        }
+    }
+
+    std::cmatch match;
+    if (!std::regex_search(begin, end, match, regex_->pattern)) {
+        return false;
+    }
+    column = static_cast<size_t>(match.position(0)) + 1;
+    return true;
+}
+
+size_t ContentMatcher::Match(const std::string& path, const std::string& content,
+                             std::vector<SearchHit>& hits, size_t max_hits) const {
+    if (!valid_ || max_hits == 0) {
+        return 0;
+    }
+
+    size_t added = 0;
+    size_t line_number = 1;
+    const char* data = content.data();
+    const char* end = data + content.size();
+    const char* line_start = data;
+
+    while (line_start <= end && added < max_hits) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(line_start, '\n', static_cast<size_t>(end - line_start)));
+        if (!line_end) {
+            line_end = end;
+        }
+
+        size_t column = 0;
+        if (MatchLine(line_start, line_end, column)) {
+            const char* text_end = line_end;
+            if (text_end > line_start && *(text_end - 1) == '\r') {
+                --text_end;
+            }
+            hits.push_back({path, line_number, column, std::string(line_start, text_end)});
+            ++added;
+        }
+
+        if (line_end == end) {
+            break;
+        }
+        line_start = line_end + 1;
+        ++line_number;
+    }
+    return added;
+}
+
+// ============================================================================
+// TrigramIndex
+// ============================================================================
+
+TrigramIndex::TrigramIndex()
+    : base_doc_count_(0),
+      live_doc_count_(0),
+      max_file_size_(16 * 1024 * 1024),
+      base_trigrams_(nullptr),
+      base_trigram_count_(0),
+      base_postings_(nullptr),
+      base_postings_size_(0) {
+}
+
+TrigramIndex::~TrigramIndex() = default;
+
+void TrigramIndex::Clear() {
+    docs_.clear();
+    path_to_id_.clear();
+    memory_content_.clear();
+    delta_postings_.clear();
+    base_doc_count_ = 0;
+    live_doc_count_ = 0;
+    base_file_.Close();
+    base_trigrams_ = nullptr;
+    base_trigram_count_ = 0;
+    base_postings_ = nullptr;
+    base_postings_size_ = 0;
+}
+
+void TrigramIndex::AddOrUpdateDocument(const std::string& path, const std::string& content) {
+    auto it = path_to_id_.find(path);
+    if (it != path_to_id_.end()) {
+        const Document& doc = docs_[it->second];
+        if (doc.in_memory && doc.hash == HashContent(content)) {
+            return;
+        }
+        TombstoneDocument(it->second);
+    }
+    AddDocumentInternal(path, content, 0, true);
+}
+
+bool TrigramIndex::RemoveDocument(const std::string& path) {
+    auto it = path_to_id_.find(path);
+    if (it == path_to_id_.end()) {
+        return false;
+    }
+    TombstoneDocument(it->second);
+    return true;
+}
+
+bool TrigramIndex::HasDocument(const std::string& path) const {
+    return path_to_id_.find(path) != path_to_id_.end();
+}
+
+size_t TrigramIndex::GetDocumentCount() const {
+    return live_doc_count_;
+}
+
+std::vector<std::string> TrigramIndex::GetDocumentPaths() const {
+    std::vector<std::string> paths;
+    paths.reserve(live_doc_count_);
+    for (const auto& doc : docs_) {
+        if (!doc.deleted) {
+            paths.push_back(doc.path);
+        }
+    }
+    return paths;
+}
+
+uint32_t TrigramIndex::AddDocumentInternal(const std::string& path, const std::string& content,
+                                           long long mtime, bool in_memory) {
+    uint32_t id = static_cast<uint32_t>(docs_.size());
+    docs_.push_back({path, content.size(), mtime, HashContent(content), in_memory, false});
+    path_to_id_[path] = id;
+    ++live_doc_count_;
+
+    for (uint32_t trigram : ExtractTrigrams(content)) {
+        delta_postings_[trigram].push_back(id);
+    }
+
+    if (in_memory) {
+        memory_content_[id] = content;
+    }
+    return id;
+}
+
+void TrigramIndex::TombstoneDocument(uint32_t id) {
+    Document& doc = docs_[id];
+    if (doc.deleted) {
+        return;
+    }
+    doc.deleted = true;
+    --live_doc_count_;
+    memory_content_.erase(id);
+    auto it = path_to_id_.find(doc.path);
+    if (it != path_to_id_.end() && it->second == id) {
+        path_to_id_.erase(it);
+    }
+}
+
+size_t TrigramIndex::IndexFileManager(const FileManager& file_manager) {
+    size_t changed = 0;
+    std::vector<std::string> names = file_manager.GetFileList();
+
+    for (const auto& name : names) {
+        std::string content = file_manager.GetFileContent(name);
+        auto it = path_to_id_.find(name);
+        if (it != path_to_id_.end() && docs_[it->second].hash == HashContent(content)) {
+            continue;
+        }
+        AddOrUpdateDocument(name, content);
+        ++changed;
+    }
+
+    // Drop buffers that were closed in the file manager
+    std::sort(names.begin(), names.end());
+    for (uint32_t id = 0; id < docs_.size(); ++id) {
+        const Document& doc = docs_[id];
+        if (doc.in_memory && !doc.deleted &&
+            !std::binary_search(names.begin(), names.end(), doc.path)) {
+            TombstoneDocument(id);
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+size_t TrigramIndex::IndexFileTree(const FileTree& tree, const std::string& base_path) {
+    size_t changed = 0;
+    std::string root_name = tree.GetRoot() ? tree.GetRoot()->GetName() : "";
+
+    for (const auto& tree_path : tree.GetAllFilePaths()) {
+        std::string disk_path = tree_path;
+        if (!base_path.empty() && tree_path.compare(0, root_name.size(), root_name) == 0) {
+            disk_path = base_path + tree_path.substr(root_name.size());
+        }
+        changed += IndexDiskFile(disk_path);
+    }
+    return changed;
+}
+
+size_t TrigramIndex::IndexDirectory(const std::string& root, const std::vector<std::string>& extensions) {
+    size_t changed = 0;
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    if (ec) {
+        return 0;
+    }
+
+    for (; it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        const fs::path& entry_path = it->path();
+        std::string name = entry_path.filename().string();
+
+        if (it->is_directory(ec)) {
+            // Skip VCS metadata, build output and other hidden folders
+            if (!name.empty() && name[0] == '.') {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        if (!extensions.empty()) {
+            std::string ext = entry_path.extension().string();
+            if (std::find(extensions.begin(), extensions.end(), ext) == extensions.end()) {
+                continue;
+            }
+        }
+        changed += IndexDiskFile(entry_path.string());
+    }
+    return changed;
+}
+
+size_t TrigramIndex::IndexDiskFile(const std::string& path) {
+    uint64_t size = 0;
+    long long mtime = 0;
+    if (!GetFileStat(path, mtime, size)) {
+        return RemoveDocument(path) ? 1 : 0;
+    }
+
+    auto it = path_to_id_.find(path);
+    if (it != path_to_id_.end()) {
+        Document& doc = docs_[it->second];
+        if (!doc.in_memory && doc.mtime == mtime && doc.size == size) {
+            return 0;
+        }
+    }
+
+    std::string content;
+    if (size > max_file_size_ || !ReadDiskFile(path, content) || LooksBinary(content)) {
+        return RemoveDocument(path) ? 1 : 0;
+    }
+
+    if (it != path_to_id_.end()) {
+        Document& doc = docs_[it->second];
+        if (!doc.in_memory && doc.hash == HashContent(content)) {
+            // Touched but unchanged
+            doc.mtime = mtime;
+            doc.size = size;
+            return 0;
+        }
+        TombstoneDocument(it->second);
+    }
+
+    AddDocumentInternal(path, content, mtime, false);
+    return 1;
+}
+
+size_t TrigramIndex::Refresh() {
+    std::vector<std::string> disk_paths;
+    for (const auto& doc : docs_) {
+        if (!doc.deleted && !doc.in_memory) {
+            disk_paths.push_back(doc.path);
+        }
+    }
+
+    size_t changed = 0;
+    for (const auto& path : disk_paths) {
+        changed += IndexDiskFile(path);
+    }
+    return changed;
+}
+
+// ----------------------------------------------------------------------------
+// Persistence
+// ----------------------------------------------------------------------------
+
+bool TrigramIndex::Save(const std::string& index_path) {
+    // Renumber live disk documents densely
+    std::vector<uint32_t> remap(docs_.size(), UINT32_MAX);
+    std::vector<uint32_t> live_ids;
+    for (uint32_t id = 0; id < docs_.size(); ++id) {
+        if (!docs_[id].deleted && !docs_[id].in_memory) {
+            remap[id] = static_cast<uint32_t>(live_ids.size());
+            live_ids.push_back(id);
+        }
+    }
+
+    // Merge base and delta posting lists. Base ids are always lower than
+    // delta ids, so appending keeps every list sorted.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> merged;
+    auto append_remapped = [&](uint32_t trigram, const std::vector<uint32_t>& ids) {
+        for (uint32_t id : ids) {
+            if (id < remap.size() && remap[id] != UINT32_MAX) {
+                merged[trigram].push_back(remap[id]);
+            }
+        }
+    };
+
+    for (uint32_t i = 0; i < base_trigram_count_; ++i) {
+        TrigramEntry entry;
+        std::memcpy(&entry, base_trigrams_ + i * sizeof(TrigramEntry), sizeof(entry));
+        append_remapped(entry.trigram, GetBasePostings(entry.trigram));
+    }
+    for (const auto& pair : delta_postings_) {
+        append_remapped(pair.first, pair.second);
+    }
+
+    std::vector<uint32_t> trigrams;
+    trigrams.reserve(merged.size());
+    for (const auto& pair : merged) {
+        if (!pair.second.empty()) {
+            trigrams.push_back(pair.first);
+        }
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+
+    std::string docs_blob;
+    for (uint32_t id : live_ids) {
+        const Document& doc = docs_[id];
+        AppendRaw(docs_blob, static_cast<uint32_t>(doc.path.size()));
+        docs_blob.append(doc.path);
+        AppendRaw(docs_blob, doc.size);
+        AppendRaw(docs_blob, static_cast<int64_t>(doc.mtime));
+        AppendRaw(docs_blob, doc.hash);
+    }
+
+    std::string table_blob;
+    std::string postings_blob;
+    table_blob.reserve(trigrams.size() * sizeof(TrigramEntry));
+    for (uint32_t trigram : trigrams) {
+        const auto& ids = merged[trigram];
+        TrigramEntry entry{trigram, static_cast<uint32_t>(ids.size()), postings_blob.size()};
+        AppendRaw(table_blob, entry);
+        uint32_t previous = 0;
+        for (uint32_t id : ids) {
+            AppendVarint(postings_blob, id - previous);
+            previous = id;
+        }
+    }
+
+    IndexHeader header;
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.doc_count = static_cast<uint32_t>(live_ids.size());
+    header.trigram_count = static_cast<uint32_t>(trigrams.size());
+    header.docs_offset = sizeof(IndexHeader);
+    header.docs_size = docs_blob.size();
+    header.trigrams_offset = header.docs_offset + header.docs_size;
+    header.postings_offset = header.trigrams_offset + table_blob.size();
+    header.postings_size = postings_blob.size();
+
+    std::string tmp_path = index_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(docs_blob.data(), static_cast<std::streamsize>(docs_blob.size()));
+        out.write(table_blob.data(), static_cast<std::streamsize>(table_blob.size()));
+        out.write(postings_blob.data(), static_cast<std::streamsize>(postings_blob.size()));
+        if (!out.good()) {
+            return false;
+        }
+    }
+
+    // Keep unsaved buffers across the reload of the compacted base
+    std::vector<std::pair<std::string, std::string>> buffers;
+    for (const auto& pair : memory_content_) {
+        buffers.emplace_back(docs_[pair.first].path, pair.second);
+    }
+
+    std::error_code ec;
+    fs::rename(tmp_path, index_path, ec);
+    if (ec) {
+        return false;
+    }
+
+    if (!Load(index_path)) {
+        return false;
+    }
+    for (const auto& buffer : buffers) {
+        AddOrUpdateDocument(buffer.first, buffer.second);
+    }
+    return true;
+}
+
+bool TrigramIndex::Load(const std::string& index_path) {
+    Clear();
+
+    if (!base_file_.Open(index_path)) {
+        return false;
+    }
+
+    const unsigned char* data = base_file_.Data();
+    const unsigned char* end = data + base_file_.Size();
+    const unsigned char* cursor = data;
+
+    IndexHeader header;
+    if (!ReadRaw(cursor, end, header) ||
+        std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) != 0 ||
+        header.version != kIndexVersion ||
+        header.docs_offset + header.docs_size > base_file_.Size() ||
+        header.postings_offset + header.postings_size > base_file_.Size() ||
+        header.trigrams_offset + static_cast<uint64_t>(header.trigram_count) * sizeof(TrigramEntry) >
+            header.postings_offset) {
+        Clear();
+        return false;
+    }
+
+    cursor = data + header.docs_offset;
+    const unsigned char* docs_end = cursor + header.docs_size;
+    docs_.reserve(header.doc_count);
+    for (uint32_t i = 0; i < header.doc_count; ++i) {
+        uint32_t path_len = 0;
+        if (!ReadRaw(cursor, docs_end, path_len) ||
+            static_cast<size_t>(docs_end - cursor) < path_len) {
+            Clear();
+            return false;
+        }
+        Document doc;
+        doc.path.assign(reinterpret_cast<const char*>(cursor), path_len);
+        cursor += path_len;
+        int64_t mtime = 0;
+        if (!ReadRaw(cursor, docs_end, doc.size) || !ReadRaw(cursor, docs_end, mtime) ||
+            !ReadRaw(cursor, docs_end, doc.hash)) {
+            Clear();
+            return false;
+        }
+        doc.mtime = mtime;
+        doc.in_memory = false;
+        doc.deleted = false;
+        path_to_id_[doc.path] = static_cast<uint32_t>(docs_.size());
+        docs_.push_back(std::move(doc));
+    }
+
+    base_doc_count_ = header.doc_count;
+    live_doc_count_ = header.doc_count;
+    base_trigrams_ = data + header.trigrams_offset;
+    base_trigram_count_ = header.trigram_count;
+    base_postings_ = data + header.postings_offset;
+    base_postings_size_ = header.postings_size;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Queries
+// ----------------------------------------------------------------------------
+
+std::vector<uint32_t> TrigramIndex::GetBasePostings(uint32_t trigram) const {
+    std::vector<uint32_t> ids;
+    if (!base_trigrams_ || base_trigram_count_ == 0) {
+        return ids;
+    }
+
+    // Binary search the fixed-size trigram table directly in the mapping
+    uint32_t lo = 0;
+    uint32_t hi = base_trigram_count_;
+    TrigramEntry entry;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        std::memcpy(&entry, base_trigrams_ + static_cast<size_t>(mid) * sizeof(TrigramEntry),
+                    sizeof(entry));
+        if (entry.trigram < trigram) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == base_trigram_count_) {
+        return ids;
+    }
+    std::memcpy(&entry, base_trigrams_ + static_cast<size_t>(lo) * sizeof(TrigramEntry),
+                sizeof(entry));
+    if (entry.trigram != trigram || entry.postings_offset >= base_postings_size_) {
+        return ids;
+    }
+
+    const unsigned char* cursor = base_postings_ + entry.postings_offset;
+    const unsigned char* end = base_postings_ + base_postings_size_;
+    ids.reserve(entry.count);
+    uint32_t previous = 0;
+    for (uint32_t i = 0; i < entry.count && cursor < end; ++i) {
+        uint32_t value = 0;
+        int shift = 0;
+        while (cursor < end) {
+            unsigned char byte = *cursor++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+            shift += 7;
+        }
+        previous += value;
+        ids.push_back(previous);
+    }
+    return ids;
+}
+
+std::vector<uint32_t> TrigramIndex::GetPostings(uint32_t trigram) const {
+    std::vector<uint32_t> ids = GetBasePostings(trigram);
+    auto it = delta_postings_.find(trigram);
+    if (it != delta_postings_.end()) {
+        ids.insert(ids.end(), it->second.begin(), it->second.end());
+    }
+    return ids;
+}
+
+std::vector<uint32_t> TrigramIndex::CandidateIds(const std::vector<std::string>& literals) const {
+    std::vector<uint32_t> candidates;
+    bool constrained = false;
+
+    for (const auto& literal : literals) {
+        if (literal.size() < 3) {
+            continue;
+        }
+        for (uint32_t trigram : ExtractTrigrams(literal)) {
+            std::vector<uint32_t> postings = GetPostings(trigram);
+            candidates = constrained ? Intersect(candidates, postings) : std::move(postings);
+            constrained = true;
+            if (candidates.empty()) {
+                return candidates;
+            }
+        }
+    }
+
+    if (!constrained) {
+        candidates.reserve(docs_.size());
+        for (uint32_t id = 0; id < docs_.size(); ++id) {
+            candidates.push_back(id);
+        }
+    }
+
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [this](uint32_t id) { return docs_[id].deleted; }),
+                     candidates.end());
+    return candidates;
+}
+
+std::vector<std::string> TrigramIndex::GetCandidates(const std::string& query,
+                                                     const SearchOptions& options) const {
+    std::vector<std::string> literals = options.regex ? ExtractRegexLiterals(query)
+                                                      : std::vector<std::string>{query};
+    std::vector<std::string> paths;
+    for (uint32_t id : CandidateIds(literals)) {
+        paths.push_back(docs_[id].path);
+    }
+    return paths;
+}
+
+std::vector<SearchHit> TrigramIndex::Search(const std::string& query,
+                                            const SearchOptions& options) const {
+    std::vector<SearchHit> hits;
+    ContentMatcher matcher(query, options);
+    if (!matcher.IsValid()) {
+        return hits;
+    }
+
+    std::string content;
+    for (uint32_t id : CandidateIds(matcher.GetRequiredLiterals())) {
+        if (hits.size() >= options.max_results) {
+            break;
+        }
+        if (!ReadDocument(id, content)) {
+            continue;
+        }
+        matcher.Match(docs_[id].path, content, hits, options.max_results - hits.size());
+    }
+    return hits;
+}
+
+bool TrigramIndex::ReadDocument(uint32_t id, std::string& content) const {
+    const Document& doc = docs_[id];
+    if (doc.in_memory) {
+        auto it = memory_content_.find(id);
+        if (it == memory_content_.end()) {
+            return false;
+        }
+        content = it->second;
+        return true;
+    }
+    if (content_provider_) {
+        return content_provider_(doc.path, content);
+    }
+    return ReadDiskFile(doc.path, content);
+}
+
+// ----------------------------------------------------------------------------
+// Helpers
+// ----------------------------------------------------------------------------
+
+std::vector<uint32_t> TrigramIndex::ExtractTrigrams(const std::string& text) {
+    std::vector<uint32_t> trigrams;
+    if (text.size() < 3) {
+        return trigrams;
+    }
+
+    // Deduplicate with a bitmap over the whole 24-bit trigram space instead
+    // of sorting; only the bits that were set get cleared again.
+    static thread_local std::vector<uint64_t> seen((1u << 24) / 64, 0);
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    uint32_t window = (static_cast<uint32_t>(FoldByte(bytes[0])) << 8) | FoldByte(bytes[1]);
+    for (size_t i = 2; i < text.size(); ++i) {
+        window = ((window << 8) | FoldByte(bytes[i])) & 0xFFFFFF;
+        uint64_t bit = 1ULL << (window & 63);
+        uint64_t& word = seen[window >> 6];
+        if (!(word & bit)) {
+            word |= bit;
+            trigrams.push_back(window);
+        }
+    }
+
+    for (uint32_t trigram : trigrams) {
+        seen[trigram >> 6] = 0;
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    return trigrams;
+}
+
+std::vector<std::string> TrigramIndex::ExtractRegexLiterals(const std::string& pattern) {
+    // Collects literal runs that every match must contain. Anything inside a
+    // group, a character class, or under an optional quantifier is ignored;
+    // a top-level alternation means nothing is required.
+    std::vector<std::string> literals;
+    std::string current;
+    int depth = 0;
+    bool in_class = false;
+
+    auto flush = [&]() {
+        if (!current.empty()) {
+            literals.push_back(current);
+            current.clear();
+        }
+    };
+
+    auto append_literal = [&](char c, size_t next) {
+        if (depth > 0) {
+            return;
+        }
+        char q = next < pattern.size() ? pattern[next] : '\0';
+        if (q == '?' || q == '*' || q == '{') {
+            flush();
+            return;
+        }
+        current.push_back(c);
+        if (q == '+') {
+            flush();
+        }
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+
+        if (in_class) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == ']') {
+                in_class = false;
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '\\':
+                if (i + 1 < pattern.size()) {
+                    char escaped = pattern[++i];
+                    if (std::isalnum(static_cast<unsigned char>(escaped))) {
+                        flush();  // \d, \w, \b, \n ...
+                        // The digits of \x41, \u00e9 and \0101, and the letter of \cM, are not literals
+                        size_t operand = escaped == 'x' ? 2 : escaped == 'u' ? 4 : escaped == '0' ? 3 : 0;
+                        while (operand > 0 && i + 1 < pattern.size() &&
+                               std::isxdigit(static_cast<unsigned char>(pattern[i + 1]))) {
+                            ++i;
+                            --operand;
+                        }
+                        if (escaped == 'c' && i + 1 < pattern.size()) {
+                            ++i;
+                        }
+                    } else {
+                        append_literal(escaped, i + 1);
+                    }
+                }
+                break;
+            case '[':
+                flush();
+                in_class = true;
+                break;
+            case '(':
+                flush();
+                ++depth;
+                break;
+            case ')':
+                flush();
+                if (depth > 0) {
+                    --depth;
+                }
+                break;
+            case '|':
+                if (depth == 0) {
+                    return {};
+                }
+                break;
+            case '{':
+                flush();
+                while (i < pattern.size() && pattern[i] != '}') {
+                    ++i;
+                }
+                break;
+            case '.':
+            case '^':
+            case '$':
+            case '*':
+            case '+':
+            case '?':
+            case '}':
+                flush();
+                break;
+            default:
+                append_literal(c, i + 1);
+                break;
+        }
+    }
+    flush();
+    return literals;
+}
+
+uint64_t TrigramIndex::HashContent(const std::string& content) {
+    // FNV-1a 64-bit
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : content) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool TrigramIndex::LooksBinary(const std::string& content) {
+    size_t probe = std::min<size_t>(content.size(), 8192);
+    return std::memchr(content.data(), '\0', probe) != nullptr;
+}
+
+bool TrigramIndex::GetFileStat(const std::string& path, long long& mtime, uint64_t& size) {
+    std::error_code ec;
+    auto status = fs::status(path, ec);
+    if (ec || !fs::is_regular_file(status)) {
+        return false;
+    }
+    auto time = fs::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    size = fs::file_size(path, ec);
+    mtime = static_cast<long long>(time.time_since_epoch().count());
+    return !ec;
+}
+
+bool TrigramIndex::ReadDiskFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+} // namespace search
+} // namespace esp32_ide
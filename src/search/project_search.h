@@ -0,0 +1,181 @@
+#ifndef PROJECT_SEARCH_H
+#define PROJECT_SEARCH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+#include "utils/mapped_file.h"
+
+namespace esp32_ide {
+
+class FileManager;
+class FileTree;
+
+namespace search {
+
+// ============================================================================
+// Project-wide search (trigram index, codesearch/Zoekt style)
+// ============================================================================
+
+/**
+ * @brief A single match returned by a project search
+ */
+struct SearchHit {
+    std::string path;
+    size_t line;          // 1-based
+    size_t column;        // 1-based
+    std::string line_text;
+};
+
+/**
+ * @brief Query options shared by indexed and unindexed search
+ */
+struct SearchOptions {
+    bool regex;
+    bool case_sensitive;
+    size_t max_results;
+
+    SearchOptions() : regex(false), case_sensitive(true), max_results(1000) {}
+};
+
+/**
+ * @brief Compiled query used to verify candidate file contents
+ *
+ * Reports at most one hit per line, at the column of the first match.
+ */
+class ContentMatcher {
+public:
+    ContentMatcher(const std::string& query, const SearchOptions& options);
+    ~ContentMatcher();
+
+    bool IsValid() const { return valid_; }
+    const std::string& GetError() const { return error_; }
+    const std::vector<std::string>& GetRequiredLiterals() const { return literals_; }
+
+    // Returns the number of hits appended (bounded by max_hits)
+    size_t Match(const std::string& path, const std::string& content,
+                 std::vector<SearchHit>& hits, size_t max_hits) const;
+
+private:
+    struct CompiledRegex;
+
+    std::string query_;
+    std::string folded_query_;
+    SearchOptions options_;
+    std::vector<std::string> literals_;
+    std::string longest_literal_;
+    std::unique_ptr<CompiledRegex> regex_;
+    bool valid_;
+    std::string error_;
+
+    bool MatchLine(const char* begin, const char* end, size_t& column) const;
+};
+
+/**
+ * @brief Trigram index over project and library sources
+ *
+ * Every document is broken into case-folded byte trigrams and each trigram
+ * maps to a sorted posting list of document ids. A query is reduced to the
+ * trigrams it must contain, the posting lists are intersected, and only the
+ * surviving candidate files are read and verified.
+ *
+ * The index lives in two layers:
+ * - a persistent base layer saved to disk and memory-mapped on Load()
+ * - an in-memory delta layer holding documents added or changed since then
+ *
+ * Updating a document tombstones its base entry and re-adds it to the delta,
+ * so changes are cheap. Save() compacts both layers into a new base file.
+ * Unsaved editor buffers (indexed from FileManager) are kept in the delta
+ * only and never written to disk.
+ */
+class TrigramIndex {
+public:
+    using ContentProvider = std::function<bool(const std::string& path, std::string& content)>;
+
+    TrigramIndex();
+    ~TrigramIndex();
+
+    // Document management (incremental)
+    void AddOrUpdateDocument(const std::string& path, const std::string& content);
+    bool RemoveDocument(const std::string& path);
+    bool HasDocument(const std::string& path) const;
+    size_t GetDocumentCount() const;
+    std::vector<std::string> GetDocumentPaths() const;
+
+    // Sources; each returns the number of documents (re)indexed
+    size_t IndexFileManager(const FileManager& file_manager);
+    size_t IndexFileTree(const FileTree& tree, const std::string& base_path = "");
+    size_t IndexDirectory(const std::string& root, const std::vector<std::string>& extensions = {});
+    size_t IndexDiskFile(const std::string& path);
+    size_t Refresh();
+
+    // Persistence
+    bool Save(const std::string& index_path);
+    bool Load(const std::string& index_path);
+    bool IsMapped() const { return base_file_.IsOpen(); }
+    void Clear();
+
+    // Queries
+    std::vector<std::string> GetCandidates(const std::string& query,
+                                           const SearchOptions& options = SearchOptions()) const;
+    std::vector<SearchHit> Search(const std::string& query,
+                                  const SearchOptions& options = SearchOptions()) const;
+
+    // Override how disk documents are read back for verification
+    void SetContentProvider(ContentProvider provider) { content_provider_ = provider; }
+
+    // Limits
+    void SetMaxFileSize(size_t bytes) { max_file_size_ = bytes; }
+    size_t GetMaxFileSize() const { return max_file_size_; }
+
+    // Query helpers (exposed for the unindexed grep engine and tests)
+    static std::vector<uint32_t> ExtractTrigrams(const std::string& text);
+    static std::vector<std::string> ExtractRegexLiterals(const std::string& pattern);
+    static uint64_t HashContent(const std::string& content);
+    static bool LooksBinary(const std::string& content);
+
+private:
+    struct Document {
+        std::string path;
+        uint64_t size;
+        long long mtime;
+        uint64_t hash;
+        bool in_memory;
+        bool deleted;
+    };
+
+    std::vector<Document> docs_;
+    std::unordered_map<std::string, uint32_t> path_to_id_;
+    std::unordered_map<uint32_t, std::string> memory_content_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> delta_postings_;
+    uint32_t base_doc_count_;
+    size_t live_doc_count_;
+    size_t max_file_size_;
+    ContentProvider content_provider_;
+
+    // Memory-mapped base layer
+    utils::MappedFile base_file_;
+    const unsigned char* base_trigrams_;
+    uint32_t base_trigram_count_;
+    const unsigned char* base_postings_;
+    size_t base_postings_size_;
+
+    uint32_t AddDocumentInternal(const std::string& path, const std::string& content,
+                                 long long mtime, bool in_memory);
+    void TombstoneDocument(uint32_t id);
+    std::vector<uint32_t> GetPostings(uint32_t trigram) const;
+    std::vector<uint32_t> GetBasePostings(uint32_t trigram) const;
+    std::vector<uint32_t> CandidateIds(const std::vector<std::string>& literals) const;
+    bool ReadDocument(uint32_t id, std::string& content) const;
+    static bool GetFileStat(const std::string& path, long long& mtime, uint64_t& size);
+    static bool ReadDiskFile(const std::string& path, std::string& content);
+};
+
+} // namespace search
+} // namespace esp32_ide
+
+#endif // PROJECT_SEARCH_H
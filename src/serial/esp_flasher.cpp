@@ -0,0 +1,673 @@
+#include "serial/esp_flasher.h"
+#include "utils/deflate.h"
+#include "utils/md5.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace esp32_ide {
+
+namespace {
+
+const unsigned char kSlipEnd = 0xC0;
+const unsigned char kSlipEscape = 0xDB;
+const unsigned char kSlipEscapedEnd = 0xDC;
+const unsigned char kSlipEscapedEscape = 0xDD;
+
+const size_t kRomBlockSize = 0x400;
+const size_t kStubBlockSize = 0x4000;
+const size_t kRamBlockSize = 0x1800;
+const uint32_t kSectorSize = 0x1000;
+
+// Read with READ_REG to tell the chip; later chips have no magic value
+const uint32_t kChipDetectMagicReg = 0x40001000;
+const uint32_t kEsp8266Magic = 0xfff0c101;
+const uint32_t kEsp32Magic = 0x00f01d83;
+
+void Put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint32_t Get32(const std::string& data, size_t at) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[at + i])) << (8 * i);
+    }
+    return value;
+}
+
+std::string Hex32(uint32_t value) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "0x%08x", value);
+    return buffer;
+}
+
+bool HexToBytes(const std::string& hex, std::string& bytes) {
+    auto nibble = [](char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    bytes.clear();
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        int high = nibble(hex[i]);
+        int low = nibble(hex[i + 1]);
+        if (high < 0 || low < 0) return false;
+        bytes.push_back(static_cast<char>((high << 4) | low));
+    }
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// FlashImage
+// ============================================================================
+
+FlashImage::FlashImage(std::vector<Region> regions, size_t segment_size, bool compress)
+    : regions_(std::move(regions)), compress_(compress), total_bytes_(0), ready_(0) {
+    if (segment_size == 0) segment_size = SIZE_MAX;
+    for (size_t r = 0; r < regions_.size(); ++r) {
+        const std::string& data = regions_[r].data;
+        region_md5_.push_back(utils::Md5::Digest(data.data(), data.size()));
+        for (size_t start = 0; start < data.size(); start += std::min(segment_size, data.size() - start)) {
+            Segment segment;
+            segment.offset = regions_[r].offset + static_cast<uint32_t>(start);
+            segment.region = r;
+            segment.start = start;
+            segment.size = std::min(segment_size, data.size() - start);
+            segment.md5 = utils::Md5::Digest(data.data() + start, segment.size);
+            segments_.push_back(std::move(segment));
+        }
+        total_bytes_ += data.size();
+    }
+    compressed_.resize(segments_.size());
+
+    if (!compress_) {
+        ready_ = segments_.size();
+        return;
+    }
+    compressor_ = std::thread([this]() {
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            std::string stream;
+            utils::Deflate::Compress(GetData(segments_[i]), segments_[i].size, stream);
+            std::lock_guard<std::mutex> lock(mutex_);
+            compressed_[i] = std::move(stream);
+            ready_++;
+            ready_cv_.notify_all();
+        }
+    });
+}
+
+FlashImage::~FlashImage() {
+    if (compressor_.joinable()) {
+        compressor_.join();
+    }
+}
+
+const char* FlashImage::GetData(const Segment& segment) const {
+    return regions_[segment.region].data.data() + segment.start;
+}
+
+const std::string& FlashImage::GetCompressed(size_t index) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_cv_.wait(lock, [this, index]() { return ready_ > index; });
+    return compressed_[index];
+}
+
+size_t FlashImage::GetCompressedBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < segments_.size(); ++i) {
+        bytes += compress_ ? GetCompressed(i).size() : segments_[i].size;
+    }
+    return bytes;
+}
+
+// ============================================================================
+// EspFlasher
+// ============================================================================
+
+EspFlasher::EspFlasher()
+    : options_(GetDefaultOptions()), cancelled_(false), connected_(false), stub_(false), status_bytes_(0),
+      chip_magic_(0), wire_bytes_(0) {
+}
+
+EspFlasher::~EspFlasher() {
+    Disconnect();
+}
+
+EspFlasher::Options EspFlasher::GetDefaultOptions() {
+    Options options;
+    options.baud_rate = 115200;
+    options.flash_baud_rate = 921600;
+    options.block_size = 0;             // 1 KiB for the ROM, 16 KiB for the stub
+    options.window = 2;
+    options.segment_size = 64 * 1024;
+    options.flash_size = 4 * 1024 * 1024;
+    options.compress = true;
+    options.skip_unchanged = true;
+    options.verify = true;
+    options.reset_into_bootloader = true;
+    options.reboot = true;
+    options.timeout_ms = 3000;
+    options.stub = nullptr;
+    return options;
+}
+
+bool EspFlasher::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+void EspFlasher::SlipEncode(const std::string& packet, std::string& out) {
+    out.push_back(static_cast<char>(kSlipEnd));
+    for (char c : packet) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (byte == kSlipEnd) {
+            out.push_back(static_cast<char>(kSlipEscape));
+            out.push_back(static_cast<char>(kSlipEscapedEnd));
+        } else if (byte == kSlipEscape) {
+            out.push_back(static_cast<char>(kSlipEscape));
+            out.push_back(static_cast<char>(kSlipEscapedEscape));
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back(static_cast<char>(kSlipEnd));
+}
+
+void EspFlasher::EnterPhase(Phase phase) {
+    if (phase_callback_) {
+        phase_callback_(phase);
+    }
+}
+
+uint32_t EspFlasher::Checksum(const char* data, size_t size) {
+    uint8_t checksum = 0xEF;
+    for (size_t i = 0; i < size; ++i) {
+        checksum ^= static_cast<uint8_t>(data[i]);
+    }
+    return checksum;
+}
+
+int EspFlasher::ScaledTimeout(size_t bytes, int ms_per_mb) const {
+    long long scaled = static_cast<long long>(bytes) * ms_per_mb / (1024 * 1024);
+    return static_cast<int>(std::max<long long>(options_.timeout_ms, scaled));
+}
+
+bool EspFlasher::Send(uint8_t command, const std::string& data, uint32_t checksum) {
+    if (cancelled_) {
+        return Fail("Cancelled");
+    }
+    std::string packet;
+    packet.reserve(8 + data.size());
+    packet.push_back(0x00);
+    packet.push_back(static_cast<char>(command));
+    packet.push_back(static_cast<char>(data.size() & 0xFF));
+    packet.push_back(static_cast<char>((data.size() >> 8) & 0xFF));
+    Put32(packet, checksum);
+    packet += data;
+
+    std::string frame;
+    frame.reserve(packet.size() + packet.size() / 32 + 2);
+    SlipEncode(packet, frame);
+    wire_bytes_ += frame.size();
+    if (!port_.Write(frame)) {
+        return Fail(port_.GetError());
+    }
+    return true;
+}
+
+bool EspFlasher::ReadFrame(std::string& frame, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        size_t start = rx_.find(static_cast<char>(kSlipEnd));
+        if (start == std::string::npos) {
+            // Boot messages and other noise between frames
+            rx_.clear();
+        } else {
+            rx_.erase(0, start);
+            size_t end = rx_.find(static_cast<char>(kSlipEnd), 1);
+            if (end != std::string::npos) {
+                frame.clear();
+                for (size_t i = 1; i < end; ++i) {
+                    unsigned char byte = static_cast<unsigned char>(rx_[i]);
+                    if (byte == kSlipEscape && i + 1 < end) {
+                        unsigned char next = static_cast<unsigned char>(rx_[++i]);
+                        byte = next == kSlipEscapedEnd ? kSlipEnd : next == kSlipEscapedEscape ? kSlipEscape : next;
+                    }
+                    frame.push_back(static_cast<char>(byte));
+                }
+                // The closing delimiter may also open the next frame
+                rx_.erase(0, end);
+                if (!frame.empty()) return true;
+                continue;
+            }
+        }
+
+        if (cancelled_) {
+            return Fail("Cancelled");
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return false;
+        char buffer[4096];
+        // Short waits so Cancel() is noticed
+        long count = port_.Read(buffer, sizeof(buffer), static_cast<int>(std::min<long long>(remaining, 100)));
+        if (count < 0) {
+            return Fail(port_.GetError());
+        }
+        rx_.append(buffer, static_cast<size_t>(count));
+    }
+}
+
+bool EspFlasher::Receive(uint8_t command, int timeout_ms, Response& response) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        std::string frame;
+        error_.clear();
+        if (remaining <= 0 || !ReadFrame(frame, static_cast<int>(remaining))) {
+            return Fail(error_.empty() ? "Timed out waiting for reply to command " + Hex32(command) : error_);
+        }
+        // Replies to earlier commands (the ROM answers SYNC several times)
+        if (frame.size() < 8 || static_cast<unsigned char>(frame[0]) != 0x01 ||
+            static_cast<unsigned char>(frame[1]) != command) {
+            continue;
+        }
+        size_t length = static_cast<unsigned char>(frame[2]) | (static_cast<unsigned char>(frame[3]) << 8);
+        if (frame.size() < 8 + length) {
+            return Fail("Truncated reply to command " + Hex32(command));
+        }
+        std::string payload = frame.substr(8, length);
+        // Only tells how to parse replies: the ESP8266 ROM answers like the stub
+        if (status_bytes_ == 0) {
+            status_bytes_ = payload.size() == 2 ? 2 : 4;
+        }
+        if (payload.size() < status_bytes_) {
+            return Fail("Reply to command " + Hex32(command) + " has no status");
+        }
+        size_t status_at = payload.size() - status_bytes_;
+        if (payload[status_at] != 0) {
+            return Fail("Command " + Hex32(command) + " failed with error " +
+                        Hex32(static_cast<unsigned char>(payload[status_at + 1])));
+        }
+        response.value = Get32(frame, 4);
+        response.data = payload.substr(0, status_at);
+        return true;
+    }
+}
+
+bool EspFlasher::Execute(uint8_t command, const std::string& data, int timeout_ms, Response& response,
+                         uint32_t checksum) {
+    return Send(command, data, checksum) && Receive(command, timeout_ms, response);
+}
+
+void EspFlasher::ResetIntoBootloader() {
+    // EN low, then IO0 low while EN is released; a pty has no modem lines
+    if (!port_.SetControlLines(false, true)) {
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    port_.SetControlLines(true, false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    port_.SetControlLines(false, false);
+}
+
+bool EspFlasher::Sync() {
+    std::string payload = {0x07, 0x07, 0x12, 0x20};
+    payload.append(32, 0x55);
+    for (int attempt = 0; attempt < 10; ++attempt) {
+        Response response;
+        status_bytes_ = 0;
+        if (Send(SYNC, payload) && Receive(SYNC, 100, response)) {
+            // Drop the remaining SYNC replies before the next command
+            std::string frame;
+            while (ReadFrame(frame, 50)) {
+            }
+            error_.clear();
+            return true;
+        }
+        if (!port_.IsOpen() || cancelled_) break;
+    }
+    return Fail("Failed to connect: no reply from the bootloader on " + port_.GetPath());
+}
+
+bool EspFlasher::RunStub(const Stub& stub) {
+    Response response;
+    for (const auto& segment : stub.segments) {
+        size_t blocks = (segment.data.size() + kRamBlockSize - 1) / kRamBlockSize;
+        std::string begin;
+        Put32(begin, static_cast<uint32_t>(segment.data.size()));
+        Put32(begin, static_cast<uint32_t>(blocks));
+        Put32(begin, static_cast<uint32_t>(kRamBlockSize));
+        Put32(begin, segment.address);
+        if (!Execute(MEM_BEGIN, begin, options_.timeout_ms, response)) {
+            return false;
+        }
+        std::string body;
+        for (size_t block = 0; block < blocks; ++block) {
+            size_t offset = block * kRamBlockSize;
+            size_t length = std::min(kRamBlockSize, segment.data.size() - offset);
+            body.clear();
+            Put32(body, static_cast<uint32_t>(length));
+            Put32(body, static_cast<uint32_t>(block));
+            Put32(body, 0);
+            Put32(body, 0);
+            body.append(segment.data, offset, length);
+            if (!Execute(MEM_DATA, body, options_.timeout_ms, response, Checksum(body.data() + 16, length))) {
+                return false;
+            }
+        }
+    }
+    std::string end;
+    Put32(end, 0);                              // run it
+    Put32(end, stub.entry);
+    if (!Execute(MEM_END, end, options_.timeout_ms, response)) {
+        return false;
+    }
+
+    // The stub announces itself with a bare "OHAI" frame
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.timeout_ms);
+    std::string frame;
+    for (;;) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        error_.clear();
+        if (remaining <= 0 || !ReadFrame(frame, static_cast<int>(remaining))) {
+            return Fail(error_.empty() ? "The flasher stub did not start" : error_);
+        }
+        if (frame == "OHAI") {
+            stub_ = true;
+            status_bytes_ = 2;
+            return true;
+        }
+    }
+}
+
+bool EspFlasher::Connect(const std::string& port) {
+    Disconnect();
+    wire_bytes_ = 0;
+    rx_.clear();
+    EnterPhase(Phase::CONNECTING);
+    if (!port_.Open(port, options_.baud_rate)) {
+        return Fail(port_.GetError());
+    }
+    if (options_.reset_into_bootloader) {
+        ResetIntoBootloader();
+    }
+    if (!Sync()) {
+        port_.Close();
+        return false;
+    }
+
+    Response response;
+    // Chips after the ESP32 take an extra word in FLASH_*BEGIN; a loader
+    // that cannot read the register is taken for an ESP32
+    std::string reg;
+    Put32(reg, kChipDetectMagicReg);
+    chip_magic_ = kEsp32Magic;
+    if (Execute(READ_REG, reg, options_.timeout_ms, response)) {
+        chip_magic_ = response.value;
+    } else if (!port_.IsOpen() || cancelled_) {
+        port_.Close();
+        return false;
+    }
+    error_.clear();
+    if (options_.stub && !RunStub(*options_.stub)) {
+        port_.Close();
+        return false;
+    }
+
+    // The ROM takes the SPI config plus a legacy flag, the stub only the config
+    std::string attach(IsStub() ? 4 : 8, '\0');
+    std::string params;
+    Put32(params, 0);                           // flash id
+    Put32(params, options_.flash_size);
+    Put32(params, 64 * 1024);                   // block
+    Put32(params, 4 * 1024);                    // sector
+    Put32(params, 256);                         // page
+    Put32(params, 0xFFFF);                      // status mask
+    if (!Execute(SPI_ATTACH, attach, options_.timeout_ms, response) ||
+        !Execute(SPI_SET_PARAMS, params, options_.timeout_ms, response)) {
+        port_.Close();
+        return false;
+    }
+
+    if (options_.flash_baud_rate > 0 && options_.flash_baud_rate != options_.baud_rate) {
+        std::string rates;
+        Put32(rates, static_cast<uint32_t>(options_.flash_baud_rate));
+        Put32(rates, IsStub() ? static_cast<uint32_t>(options_.baud_rate) : 0);
+        if (!Execute(CHANGE_BAUDRATE, rates, options_.timeout_ms, response) ||
+            !port_.SetBaudRate(options_.flash_baud_rate)) {
+            if (error_.empty()) error_ = port_.GetError();
+            port_.Close();
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        port_.FlushInput();
+        rx_.clear();
+    }
+    connected_ = true;
+    return true;
+}
+
+void EspFlasher::Disconnect() {
+    port_.Close();
+    connected_ = false;
+    stub_ = false;
+}
+
+bool EspFlasher::ReadFlashMd5(uint32_t offset, uint32_t size, std::string& md5) {
+    std::string request;
+    Put32(request, offset);
+    Put32(request, size);
+    Put32(request, 0);
+    Put32(request, 0);
+    Response response;
+    if (!Execute(SPI_FLASH_MD5, request, ScaledTimeout(size, 8000), response)) {
+        return false;
+    }
+    // The ROM answers in hex, the stub in raw bytes
+    if (response.data.size() == 32) {
+        return HexToBytes(response.data, md5) || Fail("Malformed MD5 reply");
+    }
+    if (response.data.size() == 16) {
+        md5 = response.data;
+        return true;
+    }
+    return Fail("Malformed MD5 reply");
+}
+
+bool EspFlasher::WriteSegment(const FlashImage& image, size_t index, size_t done, size_t total) {
+    const FlashImage::Segment& segment = image.GetSegments()[index];
+    bool compressed = image.IsCompressed();
+    const char* data = image.GetData(segment);
+    size_t size = segment.size;
+    if (compressed) {
+        // Blocks until the compressor thread reaches this segment
+        const std::string& stream = image.GetCompressed(index);
+        data = stream.data();
+        size = stream.size();
+    }
+    size_t block_size = options_.block_size ? options_.block_size : (IsStub() ? kStubBlockSize : kRomBlockSize);
+    size_t blocks = (size + block_size - 1) / block_size;
+
+    // The stub takes the image size and erases as it writes; the ROM erases
+    // the size given up front, in whole sectors
+    uint32_t erase_size = static_cast<uint32_t>(segment.size);
+    if (!IsStub()) {
+        erase_size = (erase_size + kSectorSize - 1) / kSectorSize * kSectorSize;
+    }
+    std::string begin;
+    Put32(begin, erase_size);
+    Put32(begin, static_cast<uint32_t>(blocks));
+    Put32(begin, static_cast<uint32_t>(block_size));
+    Put32(begin, segment.offset);
+    if (!IsStub() && chip_magic_ != kEsp32Magic && chip_magic_ != kEsp8266Magic) {
+        Put32(begin, 0);                        // ESP32-S2 and later ROMs: not encrypted
+    }
+    Response response;
+    if (!Execute(compressed ? FLASH_DEFL_BEGIN : FLASH_BEGIN, begin, ScaledTimeout(segment.size, 30000), response)) {
+        return false;
+    }
+
+    uint8_t command = compressed ? FLASH_DEFL_DATA : FLASH_DATA;
+    // Only the stub buffers a block while it writes the previous one
+    size_t window = IsStub() ? std::max<size_t>(options_.window, 1) : 1;
+    int block_timeout = ScaledTimeout(segment.size / std::max<size_t>(blocks, 1) * window, 40000);
+    size_t sent = 0;
+    size_t acked = 0;
+    std::string body;
+    while (acked < blocks) {
+        while (sent < blocks && sent - acked < window) {
+            size_t offset = sent * block_size;
+            size_t length = std::min(block_size, size - offset);
+            // Plain writes are whole blocks, padded with erased flash
+            size_t padded = compressed ? length : block_size;
+            body.clear();
+            Put32(body, static_cast<uint32_t>(padded));
+            Put32(body, static_cast<uint32_t>(sent));
+            Put32(body, 0);
+            Put32(body, 0);
+            body.append(data + offset, length);
+            body.append(padded - length, static_cast<char>(0xFF));
+            if (!Send(command, body, Checksum(body.data() + 16, padded))) {
+                return false;
+            }
+            sent++;
+        }
+        if (!Receive(command, block_timeout, response)) {
+            return false;
+        }
+        acked++;
+        if (progress_callback_) {
+            progress_callback_(done + segment.size * acked / blocks, total, segment.offset);
+        }
+    }
+    return true;
+}
+
+EspFlasher::Result EspFlasher::Flash(const std::vector<FlashImage::Region>& regions) {
+    FlashImage image(regions, options_.segment_size, options_.compress);
+    return Flash(image);
+}
+
+EspFlasher::Result EspFlasher::Flash(const FlashImage& image) {
+    auto start = std::chrono::steady_clock::now();
+    Result result;
+    result.success = false;
+    result.bytes_total = image.GetTotalBytes();
+    result.bytes_written = 0;
+    result.bytes_skipped = 0;
+    result.wire_bytes = 0;
+    result.segments_written = 0;
+    result.segments_skipped = 0;
+    result.elapsed_ms = 0;
+    size_t wire_start = wire_bytes_;
+
+    auto finish = [&](bool success) {
+        result.success = success;
+        if (!success) result.error = error_;
+        result.wire_bytes = wire_bytes_ - wire_start;
+        result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return result;
+    };
+    if (!connected_) {
+        Fail("Not connected");
+        return finish(false);
+    }
+
+    const auto& segments = image.GetSegments();
+    const auto& regions = image.GetRegions();
+    std::vector<bool> needed(segments.size(), true);
+    if (options_.skip_unchanged) {
+        EnterPhase(Phase::COMPARING);
+        // One MD5 per region settles the common case of nothing changed;
+        // otherwise segments are compared one by one
+        for (size_t r = 0; r < regions.size(); ++r) {
+            std::string md5;
+            if (regions[r].data.empty()) continue;
+            if (!ReadFlashMd5(regions[r].offset, static_cast<uint32_t>(regions[r].data.size()), md5)) {
+                return finish(false);
+            }
+            bool region_same = md5 == image.GetRegionMd5(r);
+            for (size_t i = 0; i < segments.size(); ++i) {
+                if (segments[i].region != r) continue;
+                if (region_same) {
+                    needed[i] = false;
+                    continue;
+                }
+                if (!ReadFlashMd5(segments[i].offset, static_cast<uint32_t>(segments[i].size), md5)) {
+                    return finish(false);
+                }
+                needed[i] = md5 != segments[i].md5;
+            }
+        }
+    }
+
+    size_t done = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (!needed[i]) {
+            result.segments_skipped++;
+            result.bytes_skipped += segments[i].size;
+            done += segments[i].size;
+        }
+    }
+    if (progress_callback_ && done > 0) {
+        progress_callback_(done, result.bytes_total, 0);
+    }
+
+    EnterPhase(Phase::WRITING);
+    std::vector<bool> region_written(regions.size(), false);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (!needed[i]) continue;
+        if (!WriteSegment(image, i, done, result.bytes_total)) {
+            return finish(false);
+        }
+        done += segments[i].size;
+        result.segments_written++;
+        result.bytes_written += segments[i].size;
+        region_written[segments[i].region] = true;
+    }
+
+    if (options_.verify) {
+        EnterPhase(Phase::VERIFYING);
+        for (size_t r = 0; r < regions.size(); ++r) {
+            if (!region_written[r]) continue;
+            std::string md5;
+            if (!ReadFlashMd5(regions[r].offset, static_cast<uint32_t>(regions[r].data.size()), md5)) {
+                return finish(false);
+            }
+            if (md5 != image.GetRegionMd5(r)) {
+                Fail("Verification failed at " + Hex32(regions[r].offset) + ": flash MD5 " +
+                     utils::Md5::ToHex(md5) + ", expected " + utils::Md5::ToHex(image.GetRegionMd5(r)));
+                return finish(false);
+            }
+        }
+    }
+
+    if (options_.reboot) {
+        EnterPhase(Phase::RESETTING);
+        // Leaving the loader resets the chip; the reply may never come
+        std::string reboot;
+        Put32(reboot, 0);
+        Response response;
+        if (Send(image.IsCompressed() ? FLASH_DEFL_END : FLASH_END, reboot)) {
+            Receive(image.IsCompressed() ? FLASH_DEFL_END : FLASH_END, 200, response);
+        }
+        if (port_.SetControlLines(false, true)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            port_.SetControlLines(false, false);
+        }
+        error_.clear();
+    }
+    return finish(true);
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,235 @@
+#ifndef ESP_FLASHER_H
+#define ESP_FLASHER_H
+
+#include "serial/serial_port.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Firmware to flash, split into segments and compressed once
+ *
+ * Regions (bootloader, partition table, app) are cut into segments of
+ * segment_size bytes, each with its MD5 so unchanged flash can be skipped
+ * segment by segment. Each segment is deflated into its own zlib stream
+ * on a background thread, in flash order, so the first segments can be
+ * sent while later ones are still being compressed. The image is
+ * immutable once built: flashers for several devices share one instance
+ * and send the same compressed bytes without copying them.
+ */
+class FlashImage {
+public:
+    struct Region {
+        uint32_t offset;
+        std::string data;
+    };
+
+    struct Segment {
+        uint32_t offset;        // flash address
+        size_t region;
+        size_t start;           // within the region's data
+        size_t size;
+        std::string md5;        // 16 raw bytes
+    };
+
+    FlashImage(std::vector<Region> regions, size_t segment_size, bool compress);
+    ~FlashImage();
+
+    FlashImage(const FlashImage&) = delete;
+    FlashImage& operator=(const FlashImage&) = delete;
+
+    const std::vector<Region>& GetRegions() const { return regions_; }
+    const std::vector<Segment>& GetSegments() const { return segments_; }
+    const std::string& GetRegionMd5(size_t region) const { return region_md5_[region]; }
+    const char* GetData(const Segment& segment) const;
+
+    bool IsCompressed() const { return compress_; }
+    // Waits until segment `index` is compressed; empty when not compressing
+    const std::string& GetCompressed(size_t index) const;
+    size_t GetTotalBytes() const { return total_bytes_; }
+    // Waits for every segment
+    size_t GetCompressedBytes() const;
+
+private:
+    std::vector<Region> regions_;
+    std::vector<Segment> segments_;
+    std::vector<std::string> region_md5_;
+    std::vector<std::string> compressed_;
+    bool compress_;
+    size_t total_bytes_;
+    size_t ready_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable ready_cv_;
+    std::thread compressor_;
+};
+
+/**
+ * @brief Flashes ESP32 chips over the ROM bootloader's serial protocol
+ *
+ * Speaks the esptool protocol natively: SLIP-framed commands, deflated
+ * FLASH_DEFL_* writes (plain FLASH_* when compression is off) and
+ * SPI_FLASH_MD5 checks. Before writing, the device's MD5 of each region,
+ * then of each changed region's segments, is compared with the image, so
+ * a re-flash only sends segments that differ. With the flasher stub, data
+ * blocks are pipelined: up to `window` blocks are sent before the first
+ * acknowledgement is awaited, so the device inflates and writes one block
+ * while the next is on the wire. Every written region is verified by MD5
+ * at the end.
+ *
+ * Talks to the ROM loader unless Options::stub is given: the esptool
+ * flasher stub is then written to RAM with MEM_BEGIN/MEM_DATA/MEM_END on
+ * connect and run, and IsStub() reports that it announced itself. Only the
+ * stub buffers data blocks, so pipelining and 16 KiB blocks are stub-only;
+ * the ROM gets one block at a time, sector-rounded erase sizes and, from
+ * the ESP32-S2 on, the extra "encrypted" word in FLASH_BEGIN and
+ * FLASH_DEFL_BEGIN.
+ */
+class EspFlasher {
+public:
+    // Flasher stub program, e.g. from esptool's stub ELF for the chip
+    struct Stub {
+        struct Segment {
+            uint32_t address;           // in RAM
+            std::string data;
+        };
+        std::vector<Segment> segments;
+        uint32_t entry;
+    };
+
+    struct Options {
+        int baud_rate;                  // for connecting
+        int flash_baud_rate;            // switched to after sync; 0 = stay
+        size_t block_size;              // bytes per FLASH_DATA / FLASH_DEFL_DATA
+        size_t window;                  // data blocks in flight; the ROM always gets 1
+        size_t segment_size;            // unit of change detection
+        uint32_t flash_size;            // for SPI_SET_PARAMS
+        bool compress;
+        bool skip_unchanged;
+        bool verify;
+        bool reset_into_bootloader;     // DTR/RTS sequence before syncing
+        bool reboot;                    // run the new firmware when done
+        int timeout_ms;                 // per command, scaled up for erases
+        std::shared_ptr<const Stub> stub;   // run on connect; null = ROM loader only
+    };
+
+    struct Result {
+        bool success;
+        std::string error;
+        size_t bytes_total;             // image bytes
+        size_t bytes_written;           // image bytes in written segments
+        size_t bytes_skipped;           // already on the device
+        size_t wire_bytes;              // sent over the port, framing included
+        size_t segments_written;
+        size_t segments_skipped;
+        long long elapsed_ms;
+    };
+
+    enum class Phase {
+        CONNECTING,
+        COMPARING,              // reading MD5s to find unchanged segments
+        WRITING,
+        VERIFYING,
+        RESETTING
+    };
+
+    // Image bytes done (written or skipped) out of the total
+    using ProgressCallback = std::function<void(size_t done, size_t total, uint32_t address)>;
+    using PhaseCallback = std::function<void(Phase phase)>;
+
+    EspFlasher();
+    ~EspFlasher();
+
+    static Options GetDefaultOptions();
+    void SetOptions(const Options& options) { options_ = options; }
+    const Options& GetOptions() const { return options_; }
+    void SetProgressCallback(ProgressCallback callback) { progress_callback_ = callback; }
+    void SetPhaseCallback(PhaseCallback callback) { phase_callback_ = callback; }
+
+    // Fails the running and every later command within ~100 ms; thread-safe
+    void Cancel() { cancelled_ = true; }
+    bool IsCancelled() const { return cancelled_; }
+
+    // Opens the port, resets the chip into its bootloader and syncs
+    bool Connect(const std::string& port);
+    void Disconnect();
+    bool IsConnected() const { return connected_; }
+    // True once the stub from Options::stub runs; the ROM loader otherwise
+    bool IsStub() const { return stub_; }
+    // CHIP_DETECT_MAGIC register read on connect; 0x00f01d83 on an ESP32
+    uint32_t GetChipMagic() const { return chip_magic_; }
+
+    Result Flash(const FlashImage& image);
+    Result Flash(const std::vector<FlashImage::Region>& regions);
+
+    // MD5 of flash contents as computed by the device, 16 raw bytes
+    bool ReadFlashMd5(uint32_t offset, uint32_t size, std::string& md5);
+
+    size_t GetWireBytes() const { return wire_bytes_; }
+    const std::string& GetError() const { return error_; }
+
+    // ESP32 bootloader commands
+    enum Command : uint8_t {
+        FLASH_BEGIN = 0x02,
+        FLASH_DATA = 0x03,
+        FLASH_END = 0x04,
+        MEM_BEGIN = 0x05,
+        MEM_END = 0x06,
+        MEM_DATA = 0x07,
+        SYNC = 0x08,
+        READ_REG = 0x0A,
+        SPI_SET_PARAMS = 0x0B,
+        SPI_ATTACH = 0x0D,
+        CHANGE_BAUDRATE = 0x0F,
+        FLASH_DEFL_BEGIN = 0x10,
+        FLASH_DEFL_DATA = 0x11,
+        FLASH_DEFL_END = 0x12,
+        SPI_FLASH_MD5 = 0x13
+    };
+
+    static void SlipEncode(const std::string& packet, std::string& out);
+    // Seed 0xEF, XOR of every byte: the checksum data commands carry
+    static uint32_t Checksum(const char* data, size_t size);
+
+private:
+    struct Response {
+        uint32_t value;
+        std::string data;       // status bytes removed
+    };
+
+    SerialPort port_;
+    Options options_;
+    ProgressCallback progress_callback_;
+    PhaseCallback phase_callback_;
+    std::atomic<bool> cancelled_;
+    bool connected_;
+    bool stub_;
+    size_t status_bytes_;       // 2 for the stub and the ESP8266 ROM, 4 for later ROMs
+    uint32_t chip_magic_;
+    std::string rx_;            // bytes read but not yet framed
+    size_t wire_bytes_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+    void EnterPhase(Phase phase);
+    bool Send(uint8_t command, const std::string& data, uint32_t checksum = 0);
+    bool Receive(uint8_t command, int timeout_ms, Response& response);
+    bool Execute(uint8_t command, const std::string& data, int timeout_ms, Response& response, uint32_t checksum = 0);
+    bool ReadFrame(std::string& frame, int timeout_ms);
+    bool Sync();
+    bool RunStub(const Stub& stub);
+    void ResetIntoBootloader();
+    bool WriteSegment(const FlashImage& image, size_t index, size_t done, size_t total);
+    int ScaledTimeout(size_t bytes, int ms_per_mb) const;
+};
+
+} // namespace esp32_ide
+
+#endif // ESP_FLASHER_H
@@ -0,0 +1,253 @@
+#include "serial/fleet_flasher.h"
+#include "utils/string_utils.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace esp32_ide {
+
+namespace {
+
+long long MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool IsFinished(FleetFlasher::State state) {
+    return state == FleetFlasher::State::DONE || state == FleetFlasher::State::FAILED;
+}
+
+} // namespace
+
+FleetFlasher::FleetFlasher() : options_(GetDefaultOptions()), cancelled_(false) {
+}
+
+FleetFlasher::Options FleetFlasher::GetDefaultOptions() {
+    Options options;
+    options.flasher = EspFlasher::GetDefaultOptions();
+    options.retries = 1;
+    options.device_timeout_ms = 0;
+    options.report_interval_ms = 250;
+    return options;
+}
+
+std::string FleetFlasher::GetStateName(State state) {
+    switch (state) {
+        case State::QUEUED:     return "queued";
+        case State::CONNECTING: return "connecting";
+        case State::COMPARING:  return "comparing";
+        case State::WRITING:    return "writing";
+        case State::VERIFYING:  return "verifying";
+        case State::DONE:       return "done";
+        case State::FAILED:     return "FAILED";
+        default:                return "unknown";
+    }
+}
+
+void FleetFlasher::Cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    for (auto& worker : workers_) {
+        if (worker.flasher) worker.flasher->Cancel();
+    }
+}
+
+void FleetFlasher::RunWorker(size_t index, const FlashImage& image) {
+    auto start = std::chrono::steady_clock::now();
+    auto update = [this, index](const std::function<void(DeviceStatus&)>& change) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        change(workers_[index].status);
+    };
+
+    bool done = false;
+    std::string error;
+    for (size_t attempt = 0; attempt <= options_.retries && !done; ++attempt) {
+        EspFlasher flasher;
+        flasher.SetOptions(options_.flasher);
+        flasher.SetPhaseCallback([&](EspFlasher::Phase phase) {
+            State state = State::CONNECTING;
+            switch (phase) {
+                case EspFlasher::Phase::CONNECTING: state = State::CONNECTING; break;
+                case EspFlasher::Phase::COMPARING:  state = State::COMPARING; break;
+                case EspFlasher::Phase::WRITING:    state = State::WRITING; break;
+                // Resetting is the tail of verification as far as the line is concerned
+                case EspFlasher::Phase::VERIFYING:
+                case EspFlasher::Phase::RESETTING:  state = State::VERIFYING; break;
+            }
+            update([&](DeviceStatus& status) { status.state = state; });
+        });
+        flasher.SetProgressCallback([&](size_t bytes_done, size_t, uint32_t) {
+            size_t wire_bytes = flasher.GetWireBytes();
+            update([&](DeviceStatus& status) {
+                status.bytes_done = bytes_done;
+                status.wire_bytes = wire_bytes;
+            });
+        });
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Worker& worker = workers_[index];
+            if (cancelled_ || worker.timed_out) break;
+            worker.flasher = &flasher;
+            worker.status.attempts = attempt + 1;
+            worker.status.bytes_done = 0;
+        }
+
+        if (!flasher.Connect(workers_[index].status.port)) {
+            error = flasher.GetError();
+        } else {
+            EspFlasher::Result result = flasher.Flash(image);
+            done = result.success;
+            error = result.error;
+            update([&](DeviceStatus& status) {
+                status.bytes_written = result.bytes_written;
+                status.wire_bytes = result.wire_bytes;
+                if (done) status.bytes_done = status.bytes_total;
+            });
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers_[index].flasher = nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Worker& worker = workers_[index];
+    worker.status.state = done ? State::DONE : State::FAILED;
+    worker.status.elapsed_ms = MillisecondsSince(start);
+    if (!done) {
+        if (worker.timed_out) {
+            error = "Timed out after " + utils::StringUtils::FormatSeconds(options_.device_timeout_ms);
+        } else if (cancelled_ && error.empty()) {
+            error = "Cancelled";
+        }
+        worker.status.error = error;
+    }
+}
+
+FleetFlasher::Throughput FleetFlasher::Summarize(long long elapsed_ms) const {
+    Throughput total;
+    total.bytes_done = 0;
+    total.bytes_total = 0;
+    total.bytes_written = 0;
+    total.wire_bytes = 0;
+    total.active = 0;
+    total.done = 0;
+    total.failed = 0;
+    total.elapsed_ms = elapsed_ms;
+    for (const auto& worker : workers_) {
+        const DeviceStatus& status = worker.status;
+        total.bytes_done += status.bytes_done;
+        total.bytes_total += status.bytes_total;
+        total.bytes_written += status.bytes_written;
+        total.wire_bytes += status.wire_bytes;
+        if (status.state == State::DONE) {
+            total.done++;
+        } else if (status.state == State::FAILED) {
+            total.failed++;
+        } else if (status.state != State::QUEUED) {
+            total.active++;
+        }
+    }
+    // Skipped segments count towards progress but cost no time on the
+    // wire, so they would inflate a rate taken from bytes_done
+    total.bytes_per_second = elapsed_ms > 0 ? total.wire_bytes * 1000.0 / elapsed_ms : 0.0;
+    return total;
+}
+
+FleetFlasher::FleetResult FleetFlasher::Flash(const std::vector<std::string>& ports, const FlashImage& image) {
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = false;
+        workers_.clear();
+        for (const auto& port : ports) {
+            Worker worker;
+            worker.status.port = port;
+            worker.status.state = State::QUEUED;
+            worker.status.attempts = 0;
+            worker.status.bytes_done = 0;
+            worker.status.bytes_total = image.GetTotalBytes();
+            worker.status.bytes_written = 0;
+            worker.status.wire_bytes = 0;
+            worker.status.elapsed_ms = 0;
+            worker.flasher = nullptr;
+            worker.timed_out = false;
+            workers_.push_back(std::move(worker));
+        }
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < ports.size(); ++i) {
+        threads.emplace_back([this, i, &image]() { RunWorker(i, image); });
+    }
+
+    // Watch the boards: time out stragglers and report, until all are finished
+    int interval = std::max(options_.report_interval_ms, 10);
+    for (;;) {
+        std::vector<DeviceStatus> snapshot;
+        Throughput total;
+        bool finished = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            long long elapsed = MillisecondsSince(start);
+            for (auto& worker : workers_) {
+                if (IsFinished(worker.status.state)) continue;
+                finished = false;
+                worker.status.elapsed_ms = elapsed;
+                if (options_.device_timeout_ms > 0 && elapsed > options_.device_timeout_ms && !worker.timed_out) {
+                    worker.timed_out = true;
+                    if (worker.flasher) worker.flasher->Cancel();
+                }
+            }
+            total = Summarize(elapsed);
+            if (progress_callback_) {
+                for (const auto& worker : workers_) snapshot.push_back(worker.status);
+            }
+        }
+        if (progress_callback_) {
+            progress_callback_(snapshot, total);
+        }
+        if (finished) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    FleetResult result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.throughput = Summarize(MillisecondsSince(start));
+    result.success = result.throughput.failed == 0;
+    for (const auto& worker : workers_) {
+        result.devices.push_back(worker.status);
+    }
+    return result;
+}
+
+std::string FleetFlasher::FormatTable(const FleetResult& result) {
+    std::vector<std::string> headers = {"Port", "Result", "Written", "Skipped", "Wire", "Tries", "Time"};
+    std::vector<std::vector<std::string>> rows;
+    for (const auto& device : result.devices) {
+        bool ok = device.state == State::DONE;
+        rows.push_back({
+            device.port,
+            ok ? "ok" : GetStateName(device.state) + (device.error.empty() ? "" : ": " + device.error),
+            std::to_string(device.bytes_written),
+            ok ? std::to_string(device.bytes_total - device.bytes_written) : "-",
+            std::to_string(device.wire_bytes),
+            std::to_string(device.attempts),
+            utils::StringUtils::FormatSeconds(device.elapsed_ms)
+        });
+    }
+
+    std::ostringstream oss;
+    oss << utils::StringUtils::FormatTable(headers, rows);
+    const Throughput& total = result.throughput;
+    oss << total.done << " of " << result.devices.size() << " board(s) flashed in "
+        << utils::StringUtils::FormatSeconds(total.elapsed_ms) << "; " << std::fixed << std::setprecision(1)
+        << total.bytes_per_second / 1024.0 << " KiB/s aggregate, "
+        << total.bytes_written << " byte(s) written, " << total.wire_bytes << " byte(s) on the wire\n";
+    return oss.str();
+}
+
+} // namespace esp32_ide
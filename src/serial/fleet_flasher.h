@@ -0,0 +1,111 @@
+#ifndef FLEET_FLASHER_H
+#define FLEET_FLASHER_H
+
+#include "serial/esp_flasher.h"
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <atomic>
+
+namespace esp32_ide {
+
+/**
+ * @brief Flashes one image to many boards at once
+ *
+ * Every port gets its own worker thread and EspFlasher, moving through
+ * QUEUED, CONNECTING, COMPARING, WRITING, VERIFYING to DONE or FAILED on
+ * its own. All workers read the same FlashImage, so the firmware is
+ * compressed once and its segments are sent from one buffer. A board that
+ * fails is retried up to `retries` times without holding up the others;
+ * one that is still busy after device_timeout_ms is cancelled. The calling
+ * thread reports per-device and aggregate progress while it waits.
+ */
+class FleetFlasher {
+public:
+    enum class State {
+        QUEUED,
+        CONNECTING,
+        COMPARING,
+        WRITING,
+        VERIFYING,
+        DONE,
+        FAILED
+    };
+
+    struct Options {
+        EspFlasher::Options flasher;
+        size_t retries;                 // further attempts after a failure
+        int device_timeout_ms;          // per board, all attempts; 0 = none
+        int report_interval_ms;
+    };
+
+    struct DeviceStatus {
+        std::string port;
+        State state;
+        size_t attempts;
+        size_t bytes_done;              // written or skipped, of bytes_total
+        size_t bytes_total;
+        size_t bytes_written;
+        size_t wire_bytes;
+        long long elapsed_ms;
+        std::string error;              // last failure
+    };
+
+    struct Throughput {
+        size_t bytes_done;              // summed over every board
+        size_t bytes_total;
+        size_t bytes_written;           // of finished attempts; skipped segments excluded
+        size_t wire_bytes;
+        double bytes_per_second;        // sent over the ports, all boards together
+        size_t active;
+        size_t done;
+        size_t failed;
+        long long elapsed_ms;
+    };
+
+    struct FleetResult {
+        bool success;                   // every board flashed
+        std::vector<DeviceStatus> devices;  // in port order
+        Throughput throughput;
+    };
+
+    // Called from the thread running Flash()
+    using ProgressCallback = std::function<void(const std::vector<DeviceStatus>& devices, const Throughput& total)>;
+
+    FleetFlasher();
+
+    static Options GetDefaultOptions();
+    void SetOptions(const Options& options) { options_ = options; }
+    const Options& GetOptions() const { return options_; }
+    void SetProgressCallback(ProgressCallback callback) { progress_callback_ = callback; }
+
+    // Blocks until every board is done or has failed
+    FleetResult Flash(const std::vector<std::string>& ports, const FlashImage& image);
+    // Stops the boards still in progress; callable from any thread
+    void Cancel();
+
+    static std::string GetStateName(State state);
+    // Port | Result | Written | Skipped | Wire | Tries | Time, then the totals
+    static std::string FormatTable(const FleetResult& result);
+
+private:
+    struct Worker {
+        DeviceStatus status;
+        EspFlasher* flasher;            // while an attempt runs
+        bool timed_out;
+    };
+
+    Options options_;
+    ProgressCallback progress_callback_;
+    std::atomic<bool> cancelled_;
+    std::mutex mutex_;
+    std::vector<Worker> workers_;
+
+    void RunWorker(size_t index, const FlashImage& image);
+    Throughput Summarize(long long elapsed_ms) const;
+};
+
+} // namespace esp32_ide
+
+#endif // FLEET_FLASHER_H
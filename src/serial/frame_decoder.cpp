@@ -0,0 +1,248 @@
+#include "serial/frame_decoder.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp32_ide {
+
+namespace {
+
+const uint8_t kSlipEnd = 0xC0;
+const uint8_t kSlipEscape = 0xDB;
+const uint8_t kSlipEscapedEnd = 0xDC;
+const uint8_t kSlipEscapedEscape = 0xDD;
+
+} // namespace
+
+// ============================================================================
+// FrameDecoder
+// ============================================================================
+
+FrameDecoder::FrameDecoder(size_t max_frame) : max_frame_(max_frame), frames_(0), dropped_(0) {
+    frame_.reserve(max_frame_);
+}
+
+std::unique_ptr<FrameDecoder> FrameDecoder::Create(Framing framing, size_t max_frame) {
+    switch (framing) {
+        case Framing::COBS:
+            return std::unique_ptr<FrameDecoder>(new CobsFrameDecoder(max_frame));
+        case Framing::SLIP:
+            return std::unique_ptr<FrameDecoder>(new SlipFrameDecoder(max_frame));
+        case Framing::LENGTH_PREFIXED:
+            return std::unique_ptr<FrameDecoder>(new LengthPrefixedFrameDecoder(max_frame));
+    }
+    return nullptr;
+}
+
+bool FrameDecoder::ParseFraming(const std::string& name, Framing& framing) {
+    if (name == "cobs") {
+        framing = Framing::COBS;
+    } else if (name == "slip") {
+        framing = Framing::SLIP;
+    } else if (name == "length") {
+        framing = Framing::LENGTH_PREFIXED;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void FrameDecoder::Reset() {
+    frame_.clear();
+}
+
+FrameDecoder::Statistics FrameDecoder::GetStatistics() const {
+    Statistics statistics;
+    statistics.frames = frames_;
+    statistics.dropped = dropped_;
+    return statistics;
+}
+
+// ============================================================================
+// COBS
+// ============================================================================
+
+CobsFrameDecoder::CobsFrameDecoder(size_t max_frame)
+    : FrameDecoder(max_frame), remaining_(0), zero_pending_(false), started_(false), discarding_(false) {
+}
+
+void CobsFrameDecoder::Reset() {
+    FrameDecoder::Reset();
+    remaining_ = 0;
+    zero_pending_ = false;
+    started_ = false;
+    discarding_ = false;
+}
+
+size_t CobsFrameDecoder::Feed(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    size_t emitted = 0;
+    size_t i = 0;
+    while (i < size) {
+        if (data[i] == 0) {
+            if (discarding_) {
+                // Counted when it started
+            } else if (started_ && remaining_ == 0) {
+                if (!frame_.empty()) {
+                    callback(frame_.data(), frame_.size());
+                    frames_++;
+                    emitted++;
+                }
+            } else if (started_) {
+                dropped_++;         // cut short
+            }
+            Reset();
+            i++;
+            continue;
+        }
+        if (discarding_) {
+            const void* zero = std::memchr(data + i, 0, size - i);
+            i = zero ? static_cast<size_t>(static_cast<const uint8_t*>(zero) - data) : size;
+            continue;
+        }
+
+        if (remaining_ == 0) {
+            // Code byte: how far the next zero is, 0xFF meaning no zero
+            if (zero_pending_) frame_.push_back(0);
+            remaining_ = data[i] - 1u;
+            zero_pending_ = data[i] != 0xFF;
+            started_ = true;
+            i++;
+        } else {
+            size_t run = std::min(remaining_, size - i);
+            const void* zero = std::memchr(data + i, 0, run);
+            if (zero) run = static_cast<size_t>(static_cast<const uint8_t*>(zero) - (data + i));
+            frame_.insert(frame_.end(), data + i, data + i + run);
+            remaining_ -= run;
+            i += run;
+        }
+        if (frame_.size() > max_frame_) {
+            dropped_++;
+            frame_.clear();
+            discarding_ = true;
+        }
+    }
+    return emitted;
+}
+
+// ============================================================================
+// SLIP
+// ============================================================================
+
+SlipFrameDecoder::SlipFrameDecoder(size_t max_frame)
+    : FrameDecoder(max_frame), escaped_(false), discarding_(false) {
+}
+
+void SlipFrameDecoder::Reset() {
+    FrameDecoder::Reset();
+    escaped_ = false;
+    discarding_ = false;
+}
+
+size_t SlipFrameDecoder::Feed(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    size_t emitted = 0;
+    size_t i = 0;
+    while (i < size) {
+        uint8_t byte = data[i];
+        if (byte == kSlipEnd) {
+            if (escaped_) {
+                dropped_++;
+            } else if (!discarding_ && !frame_.empty()) {
+                callback(frame_.data(), frame_.size());
+                frames_++;
+                emitted++;
+            }
+            Reset();
+            i++;
+            continue;
+        }
+        if (discarding_) {
+            i++;
+            continue;
+        }
+
+        if (escaped_) {
+            escaped_ = false;
+            if (byte == kSlipEscapedEnd) {
+                frame_.push_back(kSlipEnd);
+            } else if (byte == kSlipEscapedEscape) {
+                frame_.push_back(kSlipEscape);
+            } else {
+                dropped_++;
+                frame_.clear();
+                discarding_ = true;
+            }
+            i++;
+        } else if (byte == kSlipEscape) {
+            escaped_ = true;
+            i++;
+        } else {
+            size_t end = i + 1;
+            while (end < size && data[end] != kSlipEnd && data[end] != kSlipEscape) end++;
+            frame_.insert(frame_.end(), data + i, data + end);
+            i = end;
+        }
+        if (frame_.size() > max_frame_) {
+            dropped_++;
+            frame_.clear();
+            discarding_ = true;
+        }
+    }
+    return emitted;
+}
+
+// ============================================================================
+// Length-prefixed
+// ============================================================================
+
+LengthPrefixedFrameDecoder::LengthPrefixedFrameDecoder(size_t max_frame, size_t prefix_size)
+    : FrameDecoder(max_frame), prefix_size_(prefix_size == 1 || prefix_size == 4 ? prefix_size : 2),
+      prefix_{0, 0, 0, 0}, prefix_read_(0), length_(0) {
+}
+
+void LengthPrefixedFrameDecoder::Reset() {
+    FrameDecoder::Reset();
+    prefix_read_ = 0;
+    length_ = 0;
+}
+
+size_t LengthPrefixedFrameDecoder::Feed(const uint8_t* data, size_t size, const FrameCallback& callback) {
+    size_t emitted = 0;
+    size_t i = 0;
+    while (i < size) {
+        if (prefix_read_ < prefix_size_) {
+            prefix_[prefix_read_++] = data[i++];
+            if (prefix_read_ < prefix_size_) continue;
+            length_ = 0;
+            for (size_t b = prefix_size_; b-- > 0;) {
+                length_ = (length_ << 8) | prefix_[b];
+            }
+            // Not a plausible length: slide one byte on to find the real one
+            if (length_ == 0 || length_ > max_frame_) {
+                dropped_++;
+                std::memmove(prefix_, prefix_ + 1, prefix_size_ - 1);
+                prefix_read_--;
+            }
+            continue;
+        }
+
+        size_t run = std::min(length_ - frame_.size(), size - i);
+        if (frame_.empty() && run == length_) {
+            // Whole payload in this piece: no need to copy it
+            callback(data + i, length_);
+        } else {
+            frame_.insert(frame_.end(), data + i, data + i + run);
+            if (frame_.size() < length_) {
+                i += run;
+                continue;
+            }
+            callback(frame_.data(), frame_.size());
+            frame_.clear();
+        }
+        i += run;
+        frames_++;
+        emitted++;
+        prefix_read_ = 0;
+    }
+    return emitted;
+}
+
+} // namespace esp32_ide
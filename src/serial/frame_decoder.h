@@ -0,0 +1,107 @@
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Splits a binary serial stream into frames
+ *
+ * Feed() takes the stream in whatever pieces it arrives and calls back
+ * once per complete frame; partial frames are kept for the next call.
+ * Corrupt and oversized frames are dropped and counted, and decoding
+ * picks up again at the next frame boundary, so a device can be attached
+ * mid-stream. Frame contents are only valid during the callback.
+ *
+ * The framing is chosen with Create(); all three are common on
+ * microcontrollers:
+ * - COBS: frames end in 0x00, which the encoding keeps out of the payload
+ * - SLIP: frames end in 0xC0, with 0xDB escapes (RFC 1055)
+ * - LENGTH_PREFIXED: a little-endian length, then that many bytes
+ */
+class FrameDecoder {
+public:
+    enum class Framing {
+        COBS,
+        SLIP,
+        LENGTH_PREFIXED
+    };
+
+    struct Statistics {
+        uint64_t frames;
+        uint64_t dropped;           // corrupt, truncated or longer than max_frame
+    };
+
+    using FrameCallback = std::function<void(const uint8_t* frame, size_t size)>;
+
+    virtual ~FrameDecoder() = default;
+
+    static std::unique_ptr<FrameDecoder> Create(Framing framing, size_t max_frame = 4096);
+    // "cobs", "slip" or "length"
+    static bool ParseFraming(const std::string& name, Framing& framing);
+
+    // Returns the number of frames passed to the callback
+    virtual size_t Feed(const uint8_t* data, size_t size, const FrameCallback& callback) = 0;
+    // Forgets any partial frame
+    virtual void Reset();
+
+    Statistics GetStatistics() const;
+
+protected:
+    explicit FrameDecoder(size_t max_frame);
+
+    size_t max_frame_;
+    std::vector<uint8_t> frame_;    // being assembled; capacity is kept between frames
+    uint64_t frames_;
+    uint64_t dropped_;
+};
+
+class CobsFrameDecoder : public FrameDecoder {
+public:
+    explicit CobsFrameDecoder(size_t max_frame);
+
+    size_t Feed(const uint8_t* data, size_t size, const FrameCallback& callback) override;
+    void Reset() override;
+
+private:
+    size_t remaining_;              // data bytes left in the current block
+    bool zero_pending_;             // the block ends in an implicit zero
+    bool started_;
+    bool discarding_;               // until the next delimiter
+};
+
+class SlipFrameDecoder : public FrameDecoder {
+public:
+    explicit SlipFrameDecoder(size_t max_frame);
+
+    size_t Feed(const uint8_t* data, size_t size, const FrameCallback& callback) override;
+    void Reset() override;
+
+private:
+    bool escaped_;
+    bool discarding_;
+};
+
+class LengthPrefixedFrameDecoder : public FrameDecoder {
+public:
+    // prefix_size is 1, 2 or 4 bytes
+    LengthPrefixedFrameDecoder(size_t max_frame, size_t prefix_size = 2);
+
+    size_t Feed(const uint8_t* data, size_t size, const FrameCallback& callback) override;
+    void Reset() override;
+
+private:
+    size_t prefix_size_;
+    uint8_t prefix_[4];
+    size_t prefix_read_;
+    size_t length_;                 // of the payload being read
+};
+
+} // namespace esp32_ide
+
+#endif // FRAME_DECODER_H
@@ -0,0 +1,469 @@
+#include "serial/multi_port_monitor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace esp32_ide {
+
+namespace {
+
+// Longer lines are passed on in pieces rather than buffered without bound
+const size_t kMaxLineLength = 4096;
+
+// Bytes read from one port per wake-up, so a flood on one line cannot
+// starve the others
+const size_t kMaxReadPerWake = 64 * 1024;
+
+const size_t kStampRingCapacity = 64 * 1024;
+
+const uint64_t kWakeId = UINT64_MAX;
+
+} // namespace
+
+MultiPortMonitor::Port::Port(size_t ring_capacity, const SerialLogStore::Options& log_options)
+    : connected(false), ring(ring_capacity), stamps(kStampRingCapacity), produced(0), listening(false),
+      paused(false), bytes_read(0), full_waits(0), failed(false), consumed(0), stamp{0, 0}, has_stamp(false),
+      last_timestamp(0), log(new SerialLogStore(log_options)) {
+}
+
+MultiPortMonitor::MultiPortMonitor() : MultiPortMonitor(GetDefaultOptions()) {
+}
+
+MultiPortMonitor::MultiPortMonitor(const Options& options)
+    : options_(options), start_(std::chrono::steady_clock::now()), start_time_(std::chrono::system_clock::now()),
+      wake_{-1, -1}, epoll_fd_(-1), stopping_(false) {
+}
+
+MultiPortMonitor::~MultiPortMonitor() {
+    Stop();
+}
+
+MultiPortMonitor::Options MultiPortMonitor::GetDefaultOptions() {
+    Options options;
+    options.ring_capacity = 1024 * 1024;
+    options.log = SerialLogStore::GetDefaultOptions();
+    return options;
+}
+
+long long MultiPortMonitor::Now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+}
+
+// ============================================================================
+// Ports
+// ============================================================================
+
+int MultiPortMonitor::AddPort(const std::string& path, int baud_rate) {
+    SerialLogStore::Options log_options = options_.log;
+    if (!log_options.spill_path.empty()) {
+        log_options.spill_path += "." + std::to_string(ports_.size());
+    }
+    std::unique_ptr<Port> port(new Port(options_.ring_capacity, log_options));
+    port->path = path;
+    if (!port->serial.Open(path, baud_rate)) {
+        error_ = port->serial.GetError();
+        return -1;
+    }
+    port->connected = true;
+
+    Stop();
+    ports_.push_back(std::move(port));
+    if (!Start()) {
+        error_ = "Cannot start monitoring " + path;
+        ports_.back()->serial.Close();
+        ports_.pop_back();
+        Start();
+        return -1;
+    }
+    return static_cast<int>(ports_.size() - 1);
+}
+
+void MultiPortMonitor::ClosePort(int port) {
+    Port& target = *ports_[port];
+    if (!target.connected) {
+        return;
+    }
+    Stop();
+    Drain(target);
+    target.serial.Close();
+    target.connected = false;
+    Start();
+}
+
+bool MultiPortMonitor::SendData(int port, const std::string& data) {
+    Port& target = *ports_[port];
+    if (!target.connected) {
+        return false;
+    }
+    if (!target.serial.Write(data)) {
+        error_ = target.serial.GetError();
+        return false;
+    }
+    return true;
+}
+
+MultiPortMonitor::PortStatistics MultiPortMonitor::GetPortStatistics(int port) const {
+    const Port& target = *ports_[port];
+    PortStatistics statistics;
+    statistics.bytes_read = target.bytes_read.load(std::memory_order_relaxed);
+    statistics.messages = target.log->GetEndIndex();
+    statistics.full_waits = target.full_waits.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+// ============================================================================
+// Event loop
+// ============================================================================
+
+void MultiPortMonitor::CloseDescriptors() {
+#ifndef _WIN32
+    for (int& fd : wake_) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+#endif
+    epoll_fd_ = -1;
+}
+
+bool MultiPortMonitor::Start() {
+#ifdef _WIN32
+    return false;
+#else
+    bool any = false;
+    for (const std::unique_ptr<Port>& port : ports_) {
+        port->listening = port->connected && !port->failed.load(std::memory_order_relaxed);
+        port->paused = false;
+        any |= port->listening;
+    }
+    if (!any) {
+        return true;
+    }
+    stopping_ = false;
+    if (::pipe(wake_) != 0) {
+        return false;
+    }
+    ::fcntl(wake_[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(wake_[1], F_SETFD, FD_CLOEXEC);
+#ifdef __linux__
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event wake_event = {};
+    wake_event.events = EPOLLIN;
+    wake_event.data.u64 = kWakeId;
+    bool ok = epoll_fd_ >= 0 && ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_[0], &wake_event) == 0;
+    for (size_t i = 0; i < ports_.size() && ok; ++i) {
+        if (!ports_[i]->listening) continue;
+        struct epoll_event port_event = {};
+        port_event.events = EPOLLIN;
+        port_event.data.u64 = i;
+        ok = ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, ports_[i]->serial.GetDescriptor(), &port_event) == 0;
+    }
+    if (!ok) {
+        CloseDescriptors();
+        return false;
+    }
+#endif
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+#endif
+}
+
+void MultiPortMonitor::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_ = true;
+#ifndef _WIN32
+    char byte = 0;
+    ssize_t ignored = ::write(wake_[1], &byte, 1);
+    (void)ignored;
+#endif
+    thread_.join();
+    CloseDescriptors();
+}
+
+bool MultiPortMonitor::ReadPort(Port& port, bool hangup) {
+#ifdef _WIN32
+    (void)port;
+    (void)hangup;
+    return false;
+#else
+    for (size_t budget = kMaxReadPerWake;;) {
+        size_t span;
+        char* out = port.ring.WriteSpan(span);
+        if (span == 0) {
+            port.full_waits.fetch_add(1, std::memory_order_relaxed);
+            port.paused = true;
+            return true;
+        }
+        ssize_t count = ::read(port.serial.GetDescriptor(), out, std::min(span, budget));
+        if (count > 0) {
+            // The stamp goes first: the consumer never sees bytes without it
+            port.produced += static_cast<uint64_t>(count);
+            if (port.stamps.Capacity() - port.stamps.Size() >= sizeof(Stamp)) {
+                Stamp stamp = {port.produced, Now()};
+                port.stamps.Write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+            }
+            port.ring.Commit(static_cast<size_t>(count));
+            port.bytes_read.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+            budget -= static_cast<size_t>(count);
+            if (budget == 0) return true;
+            continue;
+        }
+        if (count < 0 && errno == EINTR) continue;
+        // Raw ttys return 0 rather than EAGAIN when empty; only a hang-up ends it
+        if (count == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+            if (!hangup) return true;
+            port.error = "Device disconnected";
+            return false;
+        }
+        port.error = std::string("Read failed: ") + std::strerror(errno);
+        return false;
+    }
+#endif
+}
+
+void MultiPortMonitor::Run() {
+#ifndef _WIN32
+    struct Ready {
+        size_t port;
+        bool hangup;
+    };
+    std::vector<Ready> ready;
+#ifdef __linux__
+    std::vector<struct epoll_event> events(ports_.size() + 1);
+    auto listen = [this](size_t i, int operation) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        ::epoll_ctl(epoll_fd_, operation, ports_[i]->serial.GetDescriptor(), &event);
+    };
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<size_t> polled;
+#endif
+
+    for (;;) {
+        // Paused ports come back once their consumer has made room
+        bool paused = false;
+        for (size_t i = 0; i < ports_.size(); ++i) {
+            Port& port = *ports_[i];
+            if (port.paused && port.ring.Size() <= port.ring.Capacity() / 2) {
+                port.paused = false;
+#ifdef __linux__
+                listen(i, EPOLL_CTL_ADD);
+#endif
+            }
+            paused |= port.paused;
+        }
+        int timeout = paused ? 1 : -1;
+
+        ready.clear();
+        bool stop = false;
+#ifdef __linux__
+        int count = ::epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), timeout);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.u64 == kWakeId) {
+                stop = true;
+            } else {
+                ready.push_back({static_cast<size_t>(events[i].data.u64),
+                                 (events[i].events & (EPOLLHUP | EPOLLERR)) != 0});
+            }
+        }
+#else
+        fds.assign(1, {wake_[0], POLLIN, 0});
+        polled.clear();
+        for (size_t i = 0; i < ports_.size(); ++i) {
+            if (!ports_[i]->listening || ports_[i]->paused) continue;
+            fds.push_back({ports_[i]->serial.GetDescriptor(), POLLIN, 0});
+            polled.push_back(i);
+        }
+        int count = ::poll(fds.data(), static_cast<nfds_t>(fds.size()), timeout);
+        stop = count > 0 && fds[0].revents != 0;
+        for (size_t i = 1; count > 0 && i < fds.size(); ++i) {
+            if (fds[i].revents) ready.push_back({polled[i - 1], (fds[i].revents & (POLLHUP | POLLERR)) != 0});
+        }
+#endif
+        if (stop || stopping_) {
+            return;
+        }
+        if (count < 0 && errno != EINTR) {
+            std::string error = std::string("Wait failed: ") + std::strerror(errno);
+            for (const std::unique_ptr<Port>& port : ports_) {
+                if (!port->listening) continue;
+                port->error = error;
+                port->failed.store(true, std::memory_order_release);
+            }
+            return;
+        }
+
+        for (const Ready& entry : ready) {
+            Port& port = *ports_[entry.port];
+            bool ok = ReadPort(port, entry.hangup);
+            if (ok && !port.paused) {
+                continue;
+            }
+#ifdef __linux__
+            listen(entry.port, EPOLL_CTL_DEL);
+#endif
+            if (!ok) {
+                port.listening = false;
+                port.failed.store(true, std::memory_order_release);
+            }
+        }
+    }
+#endif
+}
+
+// ============================================================================
+// Lines
+// ============================================================================
+
+size_t MultiPortMonitor::ProcessIncoming() {
+    size_t lines = 0;
+    for (const std::unique_ptr<Port>& pointer : ports_) {
+        Port& port = *pointer;
+        if (!port.connected) {
+            continue;
+        }
+        // Checked before draining: whatever arrived before the failure is kept
+        bool failed = port.failed.load(std::memory_order_acquire);
+        if (!failed) {
+            lines += SplitLines(port);
+            continue;
+        }
+        lines += Drain(port);
+        long long timestamp = StampFor(port, port.consumed);
+        port.log->Append("Connection lost on " + port.path + ": " + port.error,
+                         static_cast<uint8_t>(MessageType::ERROR), std::max(timestamp, port.last_timestamp));
+        port.serial.Close();
+        port.connected = false;
+    }
+    return lines;
+}
+
+size_t MultiPortMonitor::SplitLines(Port& port) {
+    size_t lines = 0;
+    size_t size;
+    const char* span;
+    while ((span = port.ring.ReadSpan(size)), size > 0) {
+        const char* end = span + size;
+        const char* start = span;
+        for (const char* newline; (newline = std::find(start, end, '\n')) != end; start = newline + 1) {
+            port.partial_line.append(start, newline);
+            AddLine(port, port.partial_line, StampFor(port, port.consumed + (newline - span) + 1));
+            port.partial_line.clear();
+            lines++;
+        }
+        port.partial_line.append(start, end);
+        while (port.partial_line.size() >= kMaxLineLength) {
+            std::string piece = port.partial_line.substr(0, kMaxLineLength);
+            AddLine(port, piece, StampFor(port, port.consumed + size));
+            port.partial_line.erase(0, kMaxLineLength);
+            lines++;
+        }
+        port.ring.Consume(size);
+        port.consumed += size;
+    }
+    return lines;
+}
+
+size_t MultiPortMonitor::Drain(Port& port) {
+    size_t lines = SplitLines(port);
+    if (!port.partial_line.empty()) {
+        AddLine(port, port.partial_line, StampFor(port, port.consumed));
+        port.partial_line.clear();
+        lines++;
+    }
+    return lines;
+}
+
+long long MultiPortMonitor::StampFor(Port& port, uint64_t end) {
+    // Stamps arrive in order; the first one covering `end` is the read that
+    // brought its last byte
+    while (!port.has_stamp || port.stamp.end < end) {
+        if (port.stamps.Size() < sizeof(Stamp)) {
+            // Its stamp was dropped for lack of room
+            port.has_stamp = false;
+            return Now();
+        }
+        port.stamps.Read(reinterpret_cast<char*>(&port.stamp), sizeof(Stamp));
+        port.has_stamp = true;
+    }
+    return port.stamp.timestamp;
+}
+
+void MultiPortMonitor::AddLine(Port& port, std::string& line, long long timestamp) {
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    // Each port's log stays in order even if a fallback stamp ran ahead
+    port.last_timestamp = std::max(port.last_timestamp, timestamp);
+    port.log->Append(line, static_cast<uint8_t>(SerialMonitor::ClassifyLine(line)), port.last_timestamp);
+}
+
+// ============================================================================
+// Merged view
+// ============================================================================
+
+MultiPortMonitor::MergedCursor MultiPortMonitor::GetMergedCursor() const {
+    return GetMergedCursor(std::vector<uint64_t>());
+}
+
+MultiPortMonitor::MergedCursor MultiPortMonitor::GetMergedCursor(const std::vector<uint64_t>& first) const {
+    MergedCursor cursor;
+    cursor.heads_.resize(ports_.size());
+    cursor.heap_.reserve(ports_.size());
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        uint64_t oldest = ports_[i]->log->GetFirstIndex();
+        cursor.cursors_.push_back(ports_[i]->log->GetCursor(i < first.size() ? std::max(first[i], oldest) : oldest));
+    }
+    for (size_t i = 0; i < ports_.size(); ++i) {
+        cursor.Load(static_cast<int>(i));
+    }
+    return cursor;
+}
+
+bool MultiPortMonitor::MergedCursor::Later(int a, int b) const {
+    long long ta = heads_[a].message.timestamp;
+    long long tb = heads_[b].message.timestamp;
+    return ta != tb ? ta > tb : a > b;
+}
+
+void MultiPortMonitor::MergedCursor::Load(int port) {
+    Entry& head = heads_[port];
+    if (!cursors_[port].Next(head.message)) {
+        return;
+    }
+    head.port = port;
+    head.index = cursors_[port].GetIndex() - 1;
+    heap_.push_back(port);
+    std::push_heap(heap_.begin(), heap_.end(), [this](int a, int b) { return Later(a, b); });
+}
+
+bool MultiPortMonitor::MergedCursor::Next(Entry& entry) {
+    // Moving a port's cursor invalidates the entry handed out from it
+    if (advance_ >= 0) {
+        Load(advance_);
+        advance_ = -1;
+    }
+    if (heap_.empty()) {
+        return false;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), [this](int a, int b) { return Later(a, b); });
+    advance_ = heap_.back();
+    heap_.pop_back();
+    entry = heads_[advance_];
+    return true;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,190 @@
+#ifndef MULTI_PORT_MONITOR_H
+#define MULTI_PORT_MONITOR_H
+
+#include "serial/serial_port.h"
+#include "serial/serial_monitor.h"
+#include "serial/serial_log_store.h"
+#include "utils/spsc_ring.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Monitors many serial ports at once, e.g. a rack of test boards
+ *
+ * One thread waits on every port with a single epoll set (poll elsewhere)
+ * and read(2)s each into its own SpscRing, as SerialReader does for one
+ * port. Each read is stamped from a clock shared by all ports, so lines
+ * from different boards can be put in the order they arrived in. A port
+ * whose consumer falls behind is left out of the wait until its ring has
+ * room again, throttling that line without holding up the others.
+ *
+ * The owning thread calls ProcessIncoming(), e.g. once per UI frame, to
+ * split every port's bytes into lines, stamped with the read that
+ * completed them, in a SerialLogStore per port. A MergedCursor walks all
+ * the logs at once in timestamp order, handing out views into the stores
+ * rather than copies.
+ *
+ * @note Thread Safety: apart from the loop thread, which only touches the
+ * rings, the class belongs to the thread that owns it.
+ */
+class MultiPortMonitor {
+public:
+    using MessageType = SerialMonitor::MessageType;
+    using Message = SerialLogStore::Message;
+
+    struct Options {
+        size_t ring_capacity;               // per port, between the loop and ProcessIncoming()
+        SerialLogStore::Options log;        // per port; a spill path gets ".<port>" appended
+    };
+
+    struct PortStatistics {
+        uint64_t bytes_read;
+        uint64_t messages;
+        uint64_t full_waits;                // times the port was paused for a full ring
+    };
+
+    // One message of the merged view
+    struct Entry {
+        int port;
+        uint64_t index;                     // in the port's log
+        Message message;
+    };
+
+    /**
+     * @brief Walks the logs of all ports in timestamp order
+     *
+     * A k-way merge over one log cursor per port; ties go to the lower port.
+     * An entry's content stays valid until the next call to Next() or
+     * ProcessIncoming(). Ports that have run out are not revisited; take a
+     * new cursor to follow new messages.
+     */
+    class MergedCursor {
+    public:
+        bool Next(Entry& entry);
+
+    private:
+        friend class MultiPortMonitor;
+        MergedCursor() : advance_(-1) {}
+
+        std::vector<SerialLogStore::Cursor> cursors_;
+        std::vector<Entry> heads_;          // next message per port
+        std::vector<int> heap_;             // ports with a head, earliest on top
+        int advance_;                       // port whose head was handed out last
+
+        void Load(int port);
+        // Heap order: later timestamps, then higher ports, sink
+        bool Later(int a, int b) const;
+    };
+
+    MultiPortMonitor();
+    explicit MultiPortMonitor(const Options& options);
+    ~MultiPortMonitor();
+
+    MultiPortMonitor(const MultiPortMonitor&) = delete;
+    MultiPortMonitor& operator=(const MultiPortMonitor&) = delete;
+
+    static Options GetDefaultOptions();
+
+    /**
+     * @brief Opens a port and starts monitoring it
+     *
+     * The loop is restarted to take the port in; the other ports' data
+     * waits in the driver meanwhile.
+     * @return The port's id, or -1 (see GetError())
+     */
+    int AddPort(const std::string& path, int baud_rate);
+    // Closes the device after logging what it already sent; its log stays readable
+    void ClosePort(int port);
+    size_t GetPortCount() const { return ports_.size(); }
+    const std::string& GetPortPath(int port) const { return ports_[port]->path; }
+    bool IsPortConnected(int port) const { return ports_[port]->connected; }
+    bool SendData(int port, const std::string& data);
+
+    /**
+     * @brief Turns every port's received bytes into messages
+     *
+     * Lines are split and classified as SerialMonitor does. A port whose
+     * device vanished gets a final "Connection lost" error and is closed.
+     * @return Number of lines added over all ports
+     */
+    size_t ProcessIncoming();
+
+    const SerialLogStore& GetLog(int port) const { return *ports_[port]->log; }
+    PortStatistics GetPortStatistics(int port) const;
+    // From each port's oldest retained message
+    MergedCursor GetMergedCursor() const;
+    // From message first[port] of each port on, or its oldest retained one;
+    // ports past the end of `first` start at their oldest
+    MergedCursor GetMergedCursor(const std::vector<uint64_t>& first) const;
+
+    // The shared clock: nanoseconds since the monitor was created
+    long long Now() const;
+    // Wall-clock time of timestamp 0
+    std::chrono::system_clock::time_point GetStartTime() const { return start_time_; }
+
+    const std::string& GetError() const { return error_; }
+
+private:
+    struct Stamp {
+        uint64_t end;                       // bytes read on the port so far
+        long long timestamp;
+    };
+
+    struct Port {
+        Port(size_t ring_capacity, const SerialLogStore::Options& log_options);
+
+        std::string path;
+        SerialPort serial;
+        bool connected;
+        // Loop side
+        utils::SpscRing ring;
+        utils::SpscRing stamps;             // a Stamp per read, ahead of its bytes
+        uint64_t produced;
+        bool listening;                     // in the loop's wait set, unless paused
+        bool paused;
+        std::atomic<uint64_t> bytes_read;
+        std::atomic<uint64_t> full_waits;
+        std::atomic<bool> failed;
+        std::string error;                  // valid once failed
+        // Owner side
+        uint64_t consumed;
+        Stamp stamp;                        // the earliest stamp not yet passed
+        bool has_stamp;
+        long long last_timestamp;
+        std::string partial_line;
+        std::unique_ptr<SerialLogStore> log;
+    };
+
+    Options options_;
+    std::vector<std::unique_ptr<Port>> ports_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::system_clock::time_point start_time_;
+    std::thread thread_;
+    int wake_[2];                           // pipe that interrupts the wait on Stop()
+    int epoll_fd_;
+    std::atomic<bool> stopping_;
+    std::string error_;
+
+    bool Start();
+    void Stop();
+    void Run();
+    void CloseDescriptors();
+    // Reads what the port has into its ring; false when it failed
+    bool ReadPort(Port& port, bool hangup);
+    size_t SplitLines(Port& port);
+    // Logs what is left in the port's ring and line buffer, once the loop is done with it
+    size_t Drain(Port& port);
+    long long StampFor(Port& port, uint64_t end);
+    void AddLine(Port& port, std::string& line, long long timestamp);
+};
+
+} // namespace esp32_ide
+
+#endif // MULTI_PORT_MONITOR_H
@@ -0,0 +1,265 @@
+#include "serial/panic_symbolizer.h"
+#include "compiler/elf_size_analyzer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kIndexMagic[4] = {'E', '3', 'S', 'Y'};
+const uint32_t kIndexVersion = 1;
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t elf_size;                  // the ELF indexed, to notice a rebuild
+    int64_t elf_time;
+    uint64_t count;
+    uint64_t names_size;
+};
+
+template <typename T>
+void AppendRaw(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool IsHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Parses the 0x... number at `at`; `end` is left just past its digits
+bool ParseHex(const std::string& text, size_t at, size_t& end, uint64_t& value) {
+    end = at + 2;
+    value = 0;
+    while (end < text.size() && end - at < 18 && IsHexDigit(text[end])) {
+        char c = text[end++];
+        value = (value << 4) | static_cast<uint64_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    return end > at + 2;
+}
+
+std::string FormatAddress(uint64_t address) {
+    char text[24];
+    std::snprintf(text, sizeof(text), "0x%08llx", static_cast<unsigned long long>(address));
+    return text;
+}
+
+} // namespace
+
+struct PanicSymbolizer::Row {
+    uint64_t address;
+    uint32_t size;
+    uint32_t name;                      // offset into the names
+};
+
+PanicSymbolizer::PanicSymbolizer() : rows_(nullptr), names_(nullptr), names_size_(0), count_(0) {
+}
+
+bool PanicSymbolizer::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+void PanicSymbolizer::Close() {
+    file_.Close();
+    memory_.clear();
+    rows_ = nullptr;
+    names_ = nullptr;
+    names_size_ = 0;
+    count_ = 0;
+}
+
+bool PanicSymbolizer::Load(const std::string& elf_path, const std::string& index_path) {
+    Close();
+    error_.clear();
+    index_path_ = index_path.empty() ? elf_path + ".symbols" : index_path;
+
+    std::error_code ec;
+    uint64_t elf_size = fs::file_size(elf_path, ec);
+    if (ec) {
+        return Fail("Cannot open " + elf_path);
+    }
+    int64_t elf_time = static_cast<int64_t>(fs::last_write_time(elf_path, ec).time_since_epoch().count());
+
+    if (file_.Open(index_path_) && Attach(file_.Data(), file_.Size(), elf_size, elf_time)) {
+        return true;
+    }
+    file_.Close();
+
+    std::string index;
+    if (!Build(elf_path, elf_size, elf_time, index)) {
+        return false;
+    }
+    {
+        std::ofstream out(index_path_, std::ios::binary | std::ios::trunc);
+        out.write(index.data(), static_cast<std::streamsize>(index.size()));
+        if (!out.good()) {
+            out.close();
+            fs::remove(index_path_, ec);
+        }
+    }
+    if (file_.Open(index_path_) && Attach(file_.Data(), file_.Size(), elf_size, elf_time)) {
+        return true;
+    }
+    file_.Close();
+    index_path_.clear();
+    memory_ = std::move(index);
+    if (!Attach(reinterpret_cast<const unsigned char*>(memory_.data()), memory_.size(), elf_size, elf_time)) {
+        return Fail(elf_path + " has no function symbols");
+    }
+    return true;
+}
+
+bool PanicSymbolizer::Build(const std::string& elf_path, uint64_t elf_size, int64_t elf_time, std::string& index) {
+    ElfSizeAnalyzer analyzer;
+    if (!analyzer.Analyze(elf_path)) {
+        return Fail(analyzer.GetError());
+    }
+    std::vector<const ElfSizeAnalyzer::Symbol*> functions;
+    for (const ElfSizeAnalyzer::Symbol& symbol : analyzer.GetReport().symbols) {
+        if (symbol.is_code) functions.push_back(&symbol);
+    }
+    if (functions.empty()) {
+        return Fail(elf_path + " has no function symbols");
+    }
+    // By address; of aliases at one address, the largest
+    std::sort(functions.begin(), functions.end(), [](const ElfSizeAnalyzer::Symbol* a, const ElfSizeAnalyzer::Symbol* b) {
+        return a->address != b->address ? a->address < b->address : a->size > b->size;
+    });
+    functions.erase(std::unique(functions.begin(), functions.end(),
+                                [](const ElfSizeAnalyzer::Symbol* a, const ElfSizeAnalyzer::Symbol* b) {
+                                    return a->address == b->address;
+                                }),
+                    functions.end());
+
+    std::string rows;
+    std::string names;
+    for (const ElfSizeAnalyzer::Symbol* symbol : functions) {
+        Row row;
+        row.address = symbol->address;
+        row.size = static_cast<uint32_t>(std::min<uint64_t>(symbol->size, UINT32_MAX));
+        row.name = static_cast<uint32_t>(names.size());
+        AppendRaw(rows, row);
+        names += ElfSizeAnalyzer::Demangle(symbol->name);
+        names += '\0';
+    }
+    IndexHeader header;
+    std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+    header.version = kIndexVersion;
+    header.elf_size = elf_size;
+    header.elf_time = elf_time;
+    header.count = functions.size();
+    header.names_size = names.size();
+    index.clear();
+    AppendRaw(index, header);
+    index += rows;
+    index += names;
+    return true;
+}
+
+bool PanicSymbolizer::Attach(const unsigned char* data, size_t size, uint64_t elf_size, int64_t elf_time) {
+    IndexHeader header;
+    if (size < sizeof(header)) return false;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) != 0 || header.version != kIndexVersion ||
+        header.elf_size != elf_size || header.elf_time != elf_time || header.count == 0 ||
+        header.count > (size - sizeof(header)) / sizeof(Row) ||
+        header.names_size != size - sizeof(header) - header.count * sizeof(Row) || header.names_size == 0) {
+        return false;
+    }
+    // Lookup() reads names as C strings; the last one must end inside the table
+    const char* names = reinterpret_cast<const char*>(data + sizeof(header) + header.count * sizeof(Row));
+    if (names[header.names_size - 1] != '\0') {
+        return false;
+    }
+    rows_ = data + sizeof(header);
+    names_ = names;
+    names_size_ = static_cast<size_t>(header.names_size);
+    count_ = static_cast<size_t>(header.count);
+    return true;
+}
+
+PanicSymbolizer::Row PanicSymbolizer::GetRow(size_t i) const {
+    Row row;
+    std::memcpy(&row, rows_ + i * sizeof(Row), sizeof(row));
+    return row;
+}
+
+bool PanicSymbolizer::Lookup(uint64_t address, std::string_view& function, uint64_t& offset) const {
+    // Last function starting at or before the address
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (GetRow(mid).address <= address) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return false;
+    }
+    Row row = GetRow(lo - 1);
+    if (address - row.address >= std::max<uint64_t>(row.size, 1) || row.name >= names_size_) {
+        return false;
+    }
+    function = std::string_view(names_ + row.name);
+    offset = address - row.address;
+    return true;
+}
+
+std::vector<std::string> PanicSymbolizer::Symbolize(const std::string& line) const {
+    std::vector<std::string> frames;
+    if (count_ == 0 || line.find("0x") == std::string::npos) {
+        return frames;
+    }
+    auto describe = [this](uint64_t address, std::string& out) {
+        std::string_view function;
+        uint64_t offset;
+        if (!Lookup(address, function, offset)) return false;
+        out += function;
+        if (offset > 0) out += "+" + std::to_string(offset);
+        return true;
+    };
+
+    // Backtrace: 0x400d1234:0x3ffb1230 0x400d5678:0x3ffb1250 |<-CORRUPTED
+    size_t backtrace = line.find("Backtrace:");
+    if (backtrace != std::string::npos) {
+        size_t at = line.find("0x", backtrace);
+        while (at != std::string::npos) {
+            size_t end;
+            uint64_t pc;
+            if (ParseHex(line, at, end, pc)) {
+                std::string frame = "  #" + std::to_string(frames.size()) + " " + FormatAddress(pc) + " in ";
+                if (!describe(pc, frame)) frame += "??";
+                frames.push_back(std::move(frame));
+            }
+            // Skip the stack pointer paired with it
+            if (end < line.size() && line[end] == ':') end = line.find(' ', end);
+            at = end == std::string::npos ? end : line.find("0x", end);
+        }
+        return frames;
+    }
+
+    // Register dumps and abort(): only addresses inside the firmware
+    if (line.find(": 0x") == std::string::npos && line.find("PC 0x") == std::string::npos) {
+        return frames;
+    }
+    size_t end = 0;
+    for (size_t at = line.find("0x"); at != std::string::npos; at = line.find("0x", end)) {
+        uint64_t address;
+        ParseHex(line, at, end, address);
+        std::string frame = "  " + FormatAddress(address) + ": ";
+        if (describe(address, frame)) frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+} // namespace esp32_ide
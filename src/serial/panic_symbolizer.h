@@ -0,0 +1,81 @@
+#ifndef PANIC_SYMBOLIZER_H
+#define PANIC_SYMBOLIZER_H
+
+#include "utils/mapped_file.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Turns the code addresses of ESP32 crash output into function names
+ *
+ * Load() builds an index of the firmware's functions once, from the ELF
+ * symbol table via ElfSizeAnalyzer: rows of start address, size and name
+ * offset sorted by address, followed by the demangled names. It is saved
+ * next to the ELF (or where asked) and memory-mapped; later loads of an
+ * unchanged ELF map it straight away. A lookup is a binary search over the
+ * mapped rows, so a whole backtrace takes microseconds instead of an
+ * addr2line process per address.
+ *
+ * Only the symbol table is indexed; file and line need DWARF .debug_line,
+ * which this does not read, so frames show function+offset.
+ */
+class PanicSymbolizer {
+public:
+    PanicSymbolizer();
+
+    PanicSymbolizer(const PanicSymbolizer&) = delete;
+    PanicSymbolizer& operator=(const PanicSymbolizer&) = delete;
+
+    /**
+     * @brief Maps the index for an ELF, building it first if needed
+     *
+     * The index is rebuilt when the ELF's size or modification time no
+     * longer match. Defaults to <elf>.symbols; if it cannot be written the
+     * index is kept in memory instead.
+     */
+    bool Load(const std::string& elf_path, const std::string& index_path = "");
+    void Close();
+    bool IsLoaded() const { return count_ > 0; }
+    size_t GetFunctionCount() const { return count_; }
+    const std::string& GetIndexPath() const { return index_path_; }
+    const std::string& GetError() const { return error_; }
+
+    // The function containing the address and how far into it; false if none
+    bool Lookup(uint64_t address, std::string_view& function, uint64_t& offset) const;
+
+    /**
+     * @brief Lines to show under a line of crash output
+     *
+     * "Backtrace: 0xPC:0xSP ..." gives one line per frame, "??" for
+     * addresses outside the firmware. Register dumps ("PC      : 0x...",
+     * "MEPC    : 0x...") and "abort() was called at PC 0x..." give a line
+     * per address that falls in a function. Any other line gives nothing,
+     * after a check cheap enough to run on every line.
+     */
+    std::vector<std::string> Symbolize(const std::string& line) const;
+
+private:
+    struct Row;
+
+    utils::MappedFile file_;
+    std::string memory_;                // the index, when it could not be saved
+    const unsigned char* rows_;
+    const char* names_;
+    size_t names_size_;
+    size_t count_;
+    std::string index_path_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+    bool Build(const std::string& elf_path, uint64_t elf_size, int64_t elf_time, std::string& index);
+    bool Attach(const unsigned char* data, size_t size, uint64_t elf_size, int64_t elf_time);
+    Row GetRow(size_t i) const;
+};
+
+} // namespace esp32_ide
+
+#endif // PANIC_SYMBOLIZER_H
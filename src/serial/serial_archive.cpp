@@ -0,0 +1,476 @@
+#include "serial/serial_archive.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace esp32_ide {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kDataMagic[4] = {'E', '3', 'A', 'D'};
+const char kIndexMagic[4] = {'E', '3', 'A', 'I'};
+const uint32_t kArchiveVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t reserved;
+};
+
+// Filters get ~10 bits per word (about 1% false positives with 4 probes),
+// within these bounds
+const size_t kMinFilterBytes = 64;
+const size_t kMaxFilterBytes = 8192;
+const int kFilterProbes = 4;
+
+void AppendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool ReadVarint(const unsigned char*& cursor, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+        unsigned char byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+uint64_t ZigZag(long long value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+long long UnZigZag(uint64_t value) {
+    return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+bool HasHeader(const utils::MappedFile& file, const char* magic) {
+    FileHeader header;
+    if (file.Size() < sizeof(header)) return false;
+    std::memcpy(&header, file.Data(), sizeof(header));
+    return std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.version == kArchiveVersion;
+}
+
+// Creates an empty file with its header, or checks the existing one
+bool PrepareFile(const std::string& path, const char* magic) {
+    std::error_code ec;
+    if (fs::exists(path, ec) && fs::file_size(path, ec) > 0) {
+        utils::MappedFile file;
+        return file.Open(path) && HasHeader(file, magic);
+    }
+    FileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = kArchiveVersion;
+    header.reserved = 0;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out.good();
+}
+
+bool IsWordChar(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+}
+
+uint64_t HashWord(const char* word, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(word[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Calls add(hash) for every word of the text
+template <typename Add>
+void ForEachWord(const char* text, size_t size, Add&& add) {
+    size_t i = 0;
+    while (i < size) {
+        while (i < size && !IsWordChar(static_cast<unsigned char>(text[i]))) i++;
+        size_t start = i;
+        while (i < size && IsWordChar(static_cast<unsigned char>(text[i]))) i++;
+        if (i > start) add(HashWord(text + start, i - start));
+    }
+}
+
+// Probe positions by double hashing; `bits` is a power of two
+template <typename Probe>
+void ForEachProbe(uint64_t hash, uint64_t bits, Probe&& probe) {
+    uint64_t step = (hash >> 32) | 1;
+    for (int i = 0; i < kFilterProbes; ++i) {
+        probe((hash + i * step) & (bits - 1));
+    }
+}
+
+// Whether `text` occurs in `content` with a word boundary on each side
+bool ContainsWords(std::string_view content, std::string_view text) {
+    for (size_t at = content.find(text); at != std::string_view::npos; at = content.find(text, at + 1)) {
+        size_t end = at + text.size();
+        bool starts = at == 0 || !IsWordChar(static_cast<unsigned char>(content[at - 1])) ||
+                      !IsWordChar(static_cast<unsigned char>(text.front()));
+        bool ends = end == content.size() || !IsWordChar(static_cast<unsigned char>(content[end])) ||
+                    !IsWordChar(static_cast<unsigned char>(text.back()));
+        if (starts && ends) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+// One per committed block, in the index file after its header
+struct SerialArchiveReader::IndexRow {
+    uint64_t first_message;
+    uint64_t offset;                    // of the block in the data file
+    int64_t first_timestamp;
+    int64_t max_timestamp;              // running maximum up to and including this block
+    uint32_t bytes;                     // records, followed by the filter
+    uint32_t count;
+    uint32_t filter_bytes;
+    uint32_t reserved;
+};
+
+// ============================================================================
+// SerialArchiveWriter
+// ============================================================================
+
+SerialArchiveWriter::SerialArchiveWriter()
+    : options_(GetDefaultOptions()), data_size_(0), message_count_(0), max_timestamp_(0), pending_count_(0),
+      first_timestamp_(0), last_timestamp_(0) {
+}
+
+SerialArchiveWriter::~SerialArchiveWriter() {
+    Close();
+}
+
+SerialArchiveWriter::Options SerialArchiveWriter::GetDefaultOptions() {
+    Options options;
+    options.block_size = 64 * 1024;
+    options.max_block_age_ms = 5000;
+    return options;
+}
+
+bool SerialArchiveWriter::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool SerialArchiveWriter::Open(const std::string& path, const Options& options) {
+    Close();
+    path_ = path;
+    options_ = options;
+    error_.clear();
+    std::string index_path = path + ".idx";
+    if (!PrepareFile(path, kDataMagic) || !PrepareFile(index_path, kIndexMagic)) {
+        return Fail("Not a serial capture: " + path);
+    }
+
+    // Continue after the last committed block, dropping anything past it
+    std::error_code ec;
+    uint64_t rows = (fs::file_size(index_path, ec) - sizeof(FileHeader)) / sizeof(SerialArchiveReader::IndexRow);
+    data_size_ = sizeof(FileHeader);
+    message_count_ = 0;
+    max_timestamp_ = 0;
+    if (rows > 0) {
+        SerialArchiveReader::IndexRow last;
+        std::ifstream in(index_path, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(sizeof(FileHeader) + (rows - 1) * sizeof(SerialArchiveReader::IndexRow)));
+        in.read(reinterpret_cast<char*>(&last), sizeof(last));
+        if (!in) return Fail("Cannot read " + index_path);
+        data_size_ = last.offset + last.bytes + last.filter_bytes;
+        message_count_ = last.first_message + last.count;
+        max_timestamp_ = last.max_timestamp;
+    }
+    if (fs::file_size(path, ec) < data_size_) {
+        return Fail("Capture data is shorter than its index: " + path);
+    }
+    fs::resize_file(index_path, sizeof(FileHeader) + rows * sizeof(SerialArchiveReader::IndexRow), ec);
+    if (!ec) fs::resize_file(path, data_size_, ec);
+    if (ec) return Fail("Cannot trim " + path + ": " + ec.message());
+
+    data_.open(path, std::ios::binary | std::ios::app);
+    index_.open(index_path, std::ios::binary | std::ios::app);
+    if (!data_ || !index_) {
+        data_.close();
+        index_.close();
+        return Fail("Cannot open " + path + " for writing");
+    }
+    block_.clear();
+    word_hashes_.clear();
+    pending_count_ = 0;
+    return true;
+}
+
+void SerialArchiveWriter::Close() {
+    if (!IsOpen()) {
+        return;
+    }
+    Flush();
+    data_.close();
+    index_.close();
+}
+
+bool SerialArchiveWriter::Append(const char* data, size_t size, uint8_t type, long long timestamp) {
+    if (!IsOpen()) {
+        return Fail("Capture is not open");
+    }
+    if (pending_count_ == 0) {
+        first_timestamp_ = timestamp;
+        last_timestamp_ = timestamp;
+        block_started_ = std::chrono::steady_clock::now();
+    }
+    AppendVarint(block_, ZigZag(timestamp - last_timestamp_));
+    block_ += static_cast<char>(type);
+    AppendVarint(block_, size);
+    block_.append(data, size);
+    ForEachWord(data, size, [this](uint64_t hash) { word_hashes_.push_back(hash); });
+    last_timestamp_ = timestamp;
+    max_timestamp_ = pending_count_ == 0 && message_count_ == 0 ? timestamp : std::max(max_timestamp_, timestamp);
+    pending_count_++;
+    return block_.size() < options_.block_size || Flush();
+}
+
+bool SerialArchiveWriter::Flush() {
+    if (!IsOpen() || pending_count_ == 0) {
+        return IsOpen();
+    }
+    size_t filter_bytes = kMinFilterBytes;
+    while (filter_bytes < kMaxFilterBytes && filter_bytes * 8 < word_hashes_.size() * 10) {
+        filter_bytes *= 2;
+    }
+    std::string filter(filter_bytes, '\0');
+    for (uint64_t hash : word_hashes_) {
+        ForEachProbe(hash, filter_bytes * 8, [&](uint64_t bit) { filter[bit >> 3] |= static_cast<char>(1 << (bit & 7)); });
+    }
+
+    SerialArchiveReader::IndexRow row;
+    row.first_message = message_count_;
+    row.offset = data_size_;
+    row.first_timestamp = first_timestamp_;
+    row.max_timestamp = max_timestamp_;
+    row.bytes = static_cast<uint32_t>(block_.size());
+    row.count = pending_count_;
+    row.filter_bytes = static_cast<uint32_t>(filter_bytes);
+    row.reserved = 0;
+
+    // The block must be on disk before the row that commits it
+    data_.write(block_.data(), static_cast<std::streamsize>(block_.size()));
+    data_.write(filter.data(), static_cast<std::streamsize>(filter.size()));
+    data_.flush();
+    if (!data_) {
+        return Fail("Cannot write to " + path_);
+    }
+    index_.write(reinterpret_cast<const char*>(&row), sizeof(row));
+    index_.flush();
+    if (!index_) {
+        return Fail("Cannot write to " + path_ + ".idx");
+    }
+    data_size_ += block_.size() + filter.size();
+    message_count_ += pending_count_;
+    block_.clear();
+    word_hashes_.clear();
+    pending_count_ = 0;
+    return true;
+}
+
+bool SerialArchiveWriter::FlushIfDue() {
+    if (pending_count_ == 0 ||
+        std::chrono::steady_clock::now() - block_started_ < std::chrono::milliseconds(options_.max_block_age_ms)) {
+        return true;
+    }
+    return Flush();
+}
+
+// ============================================================================
+// SerialArchiveReader
+// ============================================================================
+
+SerialArchiveReader::SerialArchiveReader() : block_count_(0), message_count_(0), search_statistics_() {
+}
+
+bool SerialArchiveReader::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool SerialArchiveReader::Open(const std::string& path) {
+    Close();
+    path_ = path;
+    error_.clear();
+    if (!data_.Open(path) || !HasHeader(data_, kDataMagic) || !index_.Open(path + ".idx") ||
+        !HasHeader(index_, kIndexMagic)) {
+        Close();
+        return Fail("Not a serial capture: " + path);
+    }
+    // Rows committed after the data was mapped point past it
+    size_t rows = (index_.Size() - sizeof(FileHeader)) / sizeof(IndexRow);
+    while (rows > 0 && !IsInBounds(GetRow(rows - 1), data_.Size())) {
+        rows--;
+    }
+    // Anything else out of place is damage that lookups would trust
+    uint64_t messages = 0;
+    for (size_t block = 0; block < rows; ++block) {
+        IndexRow row = GetRow(block);
+        if (!IsInBounds(row, data_.Size()) || row.first_message != messages || row.filter_bytes == 0 ||
+            (row.filter_bytes & (row.filter_bytes - 1)) != 0) {
+            Close();
+            return Fail("Damaged serial capture: " + path + " (block " + std::to_string(block) + ")");
+        }
+        messages += row.count;
+    }
+    block_count_ = rows;
+    message_count_ = messages;
+    return true;
+}
+
+bool SerialArchiveReader::Refresh() {
+    std::string path = path_;
+    return Open(path);
+}
+
+void SerialArchiveReader::Close() {
+    data_.Close();
+    index_.Close();
+    block_count_ = 0;
+    message_count_ = 0;
+}
+
+SerialArchiveReader::IndexRow SerialArchiveReader::GetRow(size_t block) const {
+    IndexRow row;
+    std::memcpy(&row, index_.Data() + sizeof(FileHeader) + block * sizeof(IndexRow), sizeof(row));
+    return row;
+}
+
+bool SerialArchiveReader::IsInBounds(const IndexRow& row, uint64_t size) {
+    return row.offset >= sizeof(FileHeader) && row.offset <= size &&
+           static_cast<uint64_t>(row.bytes) + row.filter_bytes <= size - row.offset;
+}
+
+long long SerialArchiveReader::GetFirstTimestamp() const {
+    return block_count_ > 0 ? GetRow(0).first_timestamp : 0;
+}
+
+long long SerialArchiveReader::GetLastTimestamp() const {
+    return block_count_ > 0 ? GetRow(block_count_ - 1).max_timestamp : 0;
+}
+
+size_t SerialArchiveReader::FindBlock(uint64_t message) const {
+    // Last block starting at or before the message
+    size_t lo = 0;
+    size_t hi = block_count_;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (GetRow(mid).first_message <= message) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+template <typename Callback>
+void SerialArchiveReader::DecodeBlock(const IndexRow& row, uint64_t skip, Callback&& callback) const {
+    const unsigned char* cursor = data_.Data() + row.offset;
+    const unsigned char* end = cursor + row.bytes;
+    long long timestamp = row.first_timestamp;
+    for (uint64_t i = 0; i < row.count; ++i) {
+        uint64_t delta;
+        uint64_t size;
+        if (!ReadVarint(cursor, end, delta) || cursor >= end) return;
+        uint8_t type = *cursor++;
+        if (!ReadVarint(cursor, end, size) || size > static_cast<uint64_t>(end - cursor)) return;
+        timestamp += UnZigZag(delta);
+        if (i >= skip) {
+            Message message;
+            message.content = std::string_view(reinterpret_cast<const char*>(cursor), static_cast<size_t>(size));
+            message.type = type;
+            message.timestamp = timestamp;
+            if (!callback(row.first_message + i, message)) return;
+        }
+        cursor += size;
+    }
+}
+
+uint64_t SerialArchiveReader::Seek(long long timestamp) const {
+    // First block whose running maximum reaches the timestamp: the message
+    // is in it, since every block before stays below
+    size_t lo = 0;
+    size_t hi = block_count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (GetRow(mid).max_timestamp < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == block_count_) {
+        return message_count_;
+    }
+    IndexRow row = GetRow(lo);
+    uint64_t found = row.first_message + row.count;
+    DecodeBlock(row, 0, [&](uint64_t index, const Message& message) {
+        if (message.timestamp < timestamp) return true;
+        found = index;
+        return false;
+    });
+    return found;
+}
+
+size_t SerialArchiveReader::Read(uint64_t first, size_t count, const Visitor& visitor) const {
+    size_t visited = 0;
+    for (size_t block = FindBlock(first); block < block_count_ && visited < count; ++block) {
+        IndexRow row = GetRow(block);
+        uint64_t skip = first > row.first_message ? first - row.first_message : 0;
+        DecodeBlock(row, skip, [&](uint64_t index, const Message& message) {
+            visitor(index, message);
+            return ++visited < count;
+        });
+    }
+    return visited;
+}
+
+size_t SerialArchiveReader::Search(const std::string& text, uint64_t first, size_t limit, const Visitor& visitor) {
+    search_statistics_ = SearchStatistics();
+    if (text.empty() || limit == 0) {
+        return 0;
+    }
+    std::vector<uint64_t> words;
+    ForEachWord(text.data(), text.size(), [&](uint64_t hash) { words.push_back(hash); });
+
+    size_t matches = 0;
+    for (size_t block = FindBlock(first); block < block_count_ && matches < limit; ++block) {
+        IndexRow row = GetRow(block);
+        search_statistics_.blocks++;
+        const unsigned char* filter = data_.Data() + row.offset + row.bytes;
+        uint64_t bits = static_cast<uint64_t>(row.filter_bytes) * 8;
+        bool candidate = true;
+        for (size_t i = 0; i < words.size() && candidate; ++i) {
+            ForEachProbe(words[i], bits, [&](uint64_t bit) {
+                if (!(filter[bit >> 3] & (1 << (bit & 7)))) candidate = false;
+            });
+        }
+        if (!candidate) {
+            continue;
+        }
+        search_statistics_.blocks_read++;
+        uint64_t skip = first > row.first_message ? first - row.first_message : 0;
+        DecodeBlock(row, skip, [&](uint64_t index, const Message& message) {
+            if (ContainsWords(message.content, text)) {
+                visitor(index, message);
+                matches++;
+            }
+            return matches < limit;
+        });
+    }
+    search_statistics_.matches = matches;
+    return matches;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,170 @@
+#ifndef SERIAL_ARCHIVE_H
+#define SERIAL_ARCHIVE_H
+
+#include "serial/serial_log_store.h"
+#include "utils/mapped_file.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief On-disk capture of serial messages, for sessions of any length
+ *
+ * A capture is two append-only files:
+ *   <path>      messages in blocks of ~64 KiB, each record a varint
+ *               timestamp delta, a type byte, a varint length and the
+ *               text; every block is followed by its bloom filter over the
+ *               words it contains
+ *   <path>.idx  one fixed-size row per block: first message, timestamps,
+ *               where the block and its filter are
+ *
+ * The index is the sparse timestamp index: it holds a running maximum of
+ * the timestamps, so seeking to a time is a binary search over rows and a
+ * scan of one block. A search consults each block's filter and reads only
+ * blocks that may contain every word of the query.
+ *
+ * A block is committed by its index row, written after the block itself;
+ * a crash leaves at most an unreferenced tail that the next writer trims.
+ * Timestamps are whatever the caller uses; SerialMonitor's are
+ * system_clock ticks.
+ */
+class SerialArchiveWriter {
+public:
+    struct Options {
+        size_t block_size;
+        // FlushIfDue() writes a partial block once its first message is this old
+        int max_block_age_ms;
+    };
+
+    SerialArchiveWriter();
+    ~SerialArchiveWriter();
+
+    SerialArchiveWriter(const SerialArchiveWriter&) = delete;
+    SerialArchiveWriter& operator=(const SerialArchiveWriter&) = delete;
+
+    static Options GetDefaultOptions();
+
+    // Creates the capture, or continues an existing one
+    bool Open(const std::string& path, const Options& options = GetDefaultOptions());
+    // Flushes and closes
+    void Close();
+    bool IsOpen() const { return data_.is_open(); }
+
+    bool Append(const char* data, size_t size, uint8_t type, long long timestamp);
+    bool Append(const std::string& content, uint8_t type, long long timestamp) {
+        return Append(content.data(), content.size(), type, timestamp);
+    }
+    // Commits the block in progress, making it visible to readers
+    bool Flush();
+    bool FlushIfDue();
+
+    uint64_t GetMessageCount() const { return message_count_ + pending_count_; }
+    const std::string& GetPath() const { return path_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    std::string path_;
+    Options options_;
+    std::ofstream data_;
+    std::ofstream index_;
+    uint64_t data_size_;
+    uint64_t message_count_;            // committed
+    long long max_timestamp_;           // running maximum, committed blocks included
+    std::string block_;                 // records of the block in progress
+    std::vector<uint64_t> word_hashes_; // its words, for the filter
+    uint32_t pending_count_;
+    long long first_timestamp_;
+    long long last_timestamp_;
+    std::chrono::steady_clock::time_point block_started_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+};
+
+/**
+ * @brief Memory-mapped view of a capture written by SerialArchiveWriter
+ *
+ * Messages are numbered from 0 like SerialLogStore's, and their contents
+ * are views into the mapping, valid until Refresh() or Close(). Sees the
+ * blocks committed when it was opened; Refresh() picks up newer ones.
+ */
+class SerialArchiveReader {
+public:
+    using Message = SerialLogStore::Message;
+    using Visitor = SerialLogStore::Visitor;
+
+    struct SearchStatistics {
+        uint64_t blocks;                // in the searched range
+        uint64_t blocks_read;           // passed the filter and were scanned
+        uint64_t matches;
+    };
+
+    SerialArchiveReader();
+
+    bool Open(const std::string& path);
+    bool Refresh();
+    void Close();
+    bool IsOpen() const { return data_.IsOpen(); }
+
+    uint64_t GetMessageCount() const { return message_count_; }
+    size_t GetBlockCount() const { return block_count_; }
+    // 0 when empty
+    long long GetFirstTimestamp() const;
+    long long GetLastTimestamp() const;
+
+    /**
+     * @brief Index of the first message stamped at or after `timestamp`
+     *
+     * O(log blocks) plus one block. Returns GetMessageCount() when every
+     * message is older.
+     */
+    uint64_t Seek(long long timestamp) const;
+    uint64_t Seek(std::chrono::system_clock::time_point time) const {
+        return Seek(static_cast<long long>(time.time_since_epoch().count()));
+    }
+
+    // Visits up to `count` messages from `first` on; returns how many
+    size_t Read(uint64_t first, size_t count, const Visitor& visitor) const;
+
+    /**
+     * @brief Finds messages containing `text` as whole words, like grep -w
+     *
+     * Visits up to `limit` matches from message `first` on, in order.
+     * Blocks whose filter rules out any word of the query are skipped
+     * without being touched.
+     * @return Number of matches visited
+     */
+    size_t Search(const std::string& text, uint64_t first, size_t limit, const Visitor& visitor);
+    SearchStatistics GetSearchStatistics() const { return search_statistics_; }
+
+    const std::string& GetError() const { return error_; }
+
+private:
+    friend class SerialArchiveWriter;
+    struct IndexRow;
+
+    std::string path_;
+    utils::MappedFile data_;
+    utils::MappedFile index_;
+    size_t block_count_;
+    uint64_t message_count_;
+    SearchStatistics search_statistics_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+    IndexRow GetRow(size_t block) const;
+    // Whether the row's block and filter lie within a data file of `size` bytes
+    static bool IsInBounds(const IndexRow& row, uint64_t size);
+    size_t FindBlock(uint64_t message) const;
+    // Calls visitor for messages [skip, row.count) of a block until it returns false
+    template <typename Callback>
+    void DecodeBlock(const IndexRow& row, uint64_t skip, Callback&& callback) const;
+};
+
+} // namespace esp32_ide
+
+#endif // SERIAL_ARCHIVE_H
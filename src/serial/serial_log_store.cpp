@@ -0,0 +1,289 @@
+#include "serial/serial_log_store.h"
+#include "utils/lz_codec.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace esp32_ide {
+
+namespace {
+
+// Type byte, and up to 10 bytes for each varint
+const size_t kMaxRecordOverhead = 21;
+
+size_t VarintSize(uint64_t value) {
+    size_t size = 1;
+    for (; value >= 0x80; value >>= 7) size++;
+    return size;
+}
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool GetVarint(const std::string& data, size_t& offset, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && offset < data.size(); shift += 7) {
+        unsigned char byte = static_cast<unsigned char>(data[offset++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Timestamps may step back (clock adjustments), so deltas are signed
+uint64_t ZigZag(long long value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+long long UnZigZag(uint64_t value) {
+    return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+}
+
+bool DecodeRecord(const std::string& data, size_t& offset, long long& timestamp, SerialLogStore::Message& message) {
+    uint64_t delta;
+    uint64_t length;
+    if (!GetVarint(data, offset, delta) || offset >= data.size()) return false;
+    message.type = static_cast<uint8_t>(data[offset++]);
+    if (!GetVarint(data, offset, length) || length > data.size() - offset) return false;
+    timestamp += UnZigZag(delta);
+    message.timestamp = timestamp;
+    message.content = std::string_view(data.data() + offset, static_cast<size_t>(length));
+    offset += static_cast<size_t>(length);
+    return true;
+}
+
+} // namespace
+
+// ============================================================================
+// Cursor
+// ============================================================================
+
+SerialLogStore::Cursor::Cursor(const SerialLogStore* store, uint64_t index)
+    : store_(store), index_(index), chunk_first_(UINT64_MAX), offset_(0), timestamp_(0), buffered_(false) {
+}
+
+bool SerialLogStore::Cursor::Next(Message& message) {
+    if (index_ < store_->first_index_) {
+        index_ = store_->first_index_;
+        chunk_first_ = UINT64_MAX;
+    }
+    const Chunk* chunk = store_->FindChunk(index_);
+    if (!chunk) {
+        return false;
+    }
+
+    uint64_t skip = 0;
+    if (chunk->first_index != chunk_first_) {
+        chunk_first_ = chunk->first_index;
+        offset_ = 0;
+        timestamp_ = chunk->first_timestamp;
+        skip = index_ - chunk->first_index;
+        buffered_ = false;
+    }
+    // Spilled since the last call: same bytes, now read from disk
+    if (chunk->spilled && !buffered_) {
+        if (!store_->LoadChunk(*chunk, buffer_)) {
+            chunk_first_ = UINT64_MAX;
+            return false;
+        }
+        buffered_ = true;
+    }
+    const std::string& data = buffered_ ? buffer_ : chunk->data;
+    for (; skip > 0; --skip) {
+        if (!DecodeRecord(data, offset_, timestamp_, message)) return false;
+    }
+    if (!DecodeRecord(data, offset_, timestamp_, message)) {
+        return false;
+    }
+    index_++;
+    return true;
+}
+
+// ============================================================================
+// SerialLogStore
+// ============================================================================
+
+SerialLogStore::SerialLogStore(const Options& options)
+    : options_(options), first_index_(0), end_index_(0), dropped_(0), content_bytes_(0), memory_bytes_(0),
+      spilled_chunks_(0), spill_size_(0) {
+    if (options_.chunk_size < 256) options_.chunk_size = 256;
+    OpenSpillFile();
+}
+
+SerialLogStore::~SerialLogStore() {
+    if (spill_.is_open()) {
+        spill_.close();
+        std::remove(options_.spill_path.c_str());
+    }
+}
+
+SerialLogStore::Options SerialLogStore::GetDefaultOptions() {
+    Options options;
+    options.memory_limit = 32 * 1024 * 1024;
+    options.chunk_size = 64 * 1024;
+    return options;
+}
+
+void SerialLogStore::OpenSpillFile() {
+    spill_size_ = 0;
+    if (options_.spill_path.empty()) {
+        return;
+    }
+    spill_.open(options_.spill_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!spill_.is_open()) {
+        error_ = "Cannot create spill file " + options_.spill_path;
+    }
+}
+
+uint64_t SerialLogStore::Append(const char* data, size_t size, uint8_t type, long long timestamp) {
+    bool fits = false;
+    if (!chunks_.empty()) {
+        const Chunk& last = chunks_.back();
+        size_t record = VarintSize(ZigZag(timestamp - last.last_timestamp)) + 1 + VarintSize(size) + size;
+        fits = last.data.size() + record <= last.data.capacity();
+    }
+    if (!fits) {
+        Chunk chunk;
+        chunk.first_index = end_index_;
+        chunk.count = 0;
+        chunk.first_timestamp = timestamp;
+        chunk.last_timestamp = timestamp;
+        chunk.content_bytes = 0;
+        // Oversized messages get a chunk of their own
+        chunk.data.reserve(std::max(options_.chunk_size, size + kMaxRecordOverhead));
+        chunk.spilled = false;
+        chunk.file_offset = 0;
+        chunk.stored_size = 0;
+        chunk.raw_size = 0;
+        memory_bytes_ += chunk.data.capacity();
+        chunks_.push_back(std::move(chunk));
+    }
+
+    Chunk& chunk = chunks_.back();
+    PutVarint(chunk.data, ZigZag(timestamp - chunk.last_timestamp));
+    chunk.data.push_back(static_cast<char>(type));
+    PutVarint(chunk.data, size);
+    chunk.data.append(data, size);
+    chunk.last_timestamp = timestamp;
+    chunk.count++;
+    chunk.content_bytes += size;
+    content_bytes_ += size;
+
+    if (memory_bytes_ > options_.memory_limit) {
+        Evict();
+    }
+    return end_index_++;
+}
+
+void SerialLogStore::Clear() {
+    chunks_.clear();
+    first_index_ = end_index_;
+    content_bytes_ = 0;
+    memory_bytes_ = 0;
+    spilled_chunks_ = 0;
+    if (spill_.is_open()) {
+        spill_.close();
+        OpenSpillFile();
+    }
+}
+
+void SerialLogStore::DropFront() {
+    Chunk& chunk = chunks_.front();
+    if (chunk.spilled) {
+        spilled_chunks_--;
+    } else {
+        memory_bytes_ -= chunk.data.capacity();
+    }
+    dropped_ += chunk.count;
+    content_bytes_ -= chunk.content_bytes;
+    first_index_ = chunk.first_index + chunk.count;
+    chunks_.pop_front();
+}
+
+void SerialLogStore::Evict() {
+    // The chunk being appended to always stays in RAM
+    while (memory_bytes_ > options_.memory_limit && chunks_.size() - spilled_chunks_ > 1) {
+        Chunk& chunk = chunks_[spilled_chunks_];
+        size_t bytes = chunk.data.capacity();
+        if (spill_.is_open() && Spill(chunk)) {
+            spilled_chunks_++;
+            memory_bytes_ -= bytes;
+            continue;
+        }
+        // No spill file, or it failed and what it held is gone with it
+        while (spilled_chunks_ > 0) {
+            DropFront();
+        }
+        DropFront();
+    }
+}
+
+bool SerialLogStore::Spill(Chunk& chunk) {
+    std::string stored = utils::LzCodec::Compress(chunk.data);
+    spill_.seekp(static_cast<std::streamoff>(spill_size_));
+    spill_.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+    if (!spill_) {
+        error_ = "Cannot write spill file " + options_.spill_path;
+        spill_.close();
+        return false;
+    }
+    chunk.file_offset = spill_size_;
+    chunk.stored_size = static_cast<uint32_t>(stored.size());
+    chunk.raw_size = static_cast<uint32_t>(chunk.data.size());
+    chunk.spilled = true;
+    std::string().swap(chunk.data);
+    spill_size_ += stored.size();
+    return true;
+}
+
+bool SerialLogStore::LoadChunk(const Chunk& chunk, std::string& out) const {
+    if (!spill_.is_open()) {
+        return false;
+    }
+    std::string stored(chunk.stored_size, '\0');
+    spill_.seekg(static_cast<std::streamoff>(chunk.file_offset));
+    spill_.read(&stored[0], static_cast<std::streamsize>(stored.size()));
+    if (!spill_) {
+        spill_.clear();
+        return false;
+    }
+    return utils::LzCodec::Decompress(stored, chunk.raw_size, out);
+}
+
+const SerialLogStore::Chunk* SerialLogStore::FindChunk(uint64_t index) const {
+    if (index < first_index_ || index >= end_index_) {
+        return nullptr;
+    }
+    auto it = std::upper_bound(chunks_.begin(), chunks_.end(), index,
+                               [](uint64_t value, const Chunk& chunk) { return value < chunk.first_index; });
+    return &*(it - 1);
+}
+
+size_t SerialLogStore::Read(uint64_t first, size_t count, const Visitor& visitor) const {
+    Cursor cursor = GetCursor(first);
+    Message message;
+    size_t visited = 0;
+    while (visited < count && cursor.Next(message)) {
+        visitor(cursor.GetIndex() - 1, message);
+        visited++;
+    }
+    return visited;
+}
+
+SerialLogStore::Statistics SerialLogStore::GetStatistics() const {
+    Statistics statistics;
+    statistics.messages = Size();
+    statistics.dropped = dropped_;
+    statistics.chunks = chunks_.size();
+    statistics.memory_bytes = memory_bytes_;
+    statistics.spilled_chunks = spilled_chunks_;
+    statistics.spilled_bytes = spill_size_;
+    statistics.content_bytes = content_bytes_;
+    return statistics;
+}
+
+} // namespace esp32_ide
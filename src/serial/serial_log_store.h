@@ -0,0 +1,136 @@
+#ifndef SERIAL_LOG_STORE_H
+#define SERIAL_LOG_STORE_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Bounded, append-only store for serial monitor messages
+ *
+ * Messages are packed back to back into chunk arenas (64 KiB by default)
+ * as a varint timestamp delta, a type byte, a varint length and the text,
+ * so each costs a few bytes on top of its content. Messages are numbered
+ * from 0 in arrival order. Once the chunks in RAM exceed memory_limit,
+ * the oldest are LZ-compressed and appended to the spill file, or dropped
+ * when there is none; GetFirstIndex() tells what is still available.
+ *
+ * Readers walk a Cursor or ask for a range instead of copying the log.
+ * Message contents are views that stay valid until the cursor moves on or
+ * the store changes. Not thread-safe, like SerialMonitor.
+ */
+class SerialLogStore {
+public:
+    struct Options {
+        size_t memory_limit;            // bytes of chunks kept in RAM
+        size_t chunk_size;
+        std::string spill_path;         // empty = drop what does not fit
+    };
+
+    struct Message {
+        std::string_view content;
+        uint8_t type;
+        long long timestamp;
+    };
+
+    struct Statistics {
+        uint64_t messages;              // still available
+        uint64_t dropped;               // evicted without a spill file
+        size_t chunks;
+        size_t memory_bytes;
+        size_t spilled_chunks;
+        uint64_t spilled_bytes;         // compressed, on disk
+        uint64_t content_bytes;         // message text, all available messages
+    };
+
+    class Cursor {
+    public:
+        // False at the end of the log; a cursor positioned past dropped
+        // messages moves up to the oldest available one
+        bool Next(Message& message);
+        uint64_t GetIndex() const { return index_; }
+
+    private:
+        friend class SerialLogStore;
+        Cursor(const SerialLogStore* store, uint64_t index);
+
+        const SerialLogStore* store_;
+        uint64_t index_;
+        uint64_t chunk_first_;          // chunk the position below refers to
+        size_t offset_;
+        long long timestamp_;
+        std::string buffer_;            // a spilled chunk, decompressed
+        bool buffered_;
+    };
+
+    using Visitor = std::function<void(uint64_t index, const Message& message)>;
+
+    explicit SerialLogStore(const Options& options);
+    ~SerialLogStore();
+
+    SerialLogStore(const SerialLogStore&) = delete;
+    SerialLogStore& operator=(const SerialLogStore&) = delete;
+
+    static Options GetDefaultOptions();
+
+    // Returns the message's index
+    uint64_t Append(const char* data, size_t size, uint8_t type, long long timestamp);
+    uint64_t Append(const std::string& content, uint8_t type, long long timestamp) {
+        return Append(content.data(), content.size(), type, timestamp);
+    }
+    void Clear();
+
+    uint64_t GetFirstIndex() const { return first_index_; }
+    uint64_t GetEndIndex() const { return end_index_; }
+    uint64_t Size() const { return end_index_ - first_index_; }
+
+    Cursor GetCursor(uint64_t index) const { return Cursor(this, index); }
+    // Visits up to `count` messages from `first` on; returns how many
+    size_t Read(uint64_t first, size_t count, const Visitor& visitor) const;
+
+    Statistics GetStatistics() const;
+    // Set when the spill file failed; the store then drops instead
+    const std::string& GetError() const { return error_; }
+
+private:
+    struct Chunk {
+        uint64_t first_index;
+        uint32_t count;
+        long long first_timestamp;      // the base for the first delta
+        long long last_timestamp;
+        uint64_t content_bytes;
+        std::string data;               // records; empty once spilled
+        bool spilled;
+        uint64_t file_offset;
+        uint32_t stored_size;
+        uint32_t raw_size;
+    };
+
+    Options options_;
+    std::deque<Chunk> chunks_;
+    uint64_t first_index_;
+    uint64_t end_index_;
+    uint64_t dropped_;
+    uint64_t content_bytes_;
+    size_t memory_bytes_;
+    size_t spilled_chunks_;             // the oldest chunks, on disk
+    mutable std::fstream spill_;
+    uint64_t spill_size_;
+    std::string error_;
+
+    void Evict();
+    bool Spill(Chunk& chunk);
+    void DropFront();
+    void OpenSpillFile();
+    const Chunk* FindChunk(uint64_t index) const;
+    bool LoadChunk(const Chunk& chunk, std::string& out) const;
+};
+
+} // namespace esp32_ide
+
+#endif // SERIAL_LOG_STORE_H
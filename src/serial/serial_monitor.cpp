@@ -1,11 +1,50 @@
 #include "serial/serial_monitor.h"
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
 
 namespace esp32_ide {
 
+namespace {
+
+// Longer lines are passed on in pieces rather than buffered without bound
+const size_t kMaxLineLength = 4096;
+
+const size_t kRealtimeMemoryLimit = 4 * 1024 * 1024;
+const size_t kMaxMemoryHistory = 1024;
+
+// Replayed bytes handled per ProcessIncoming() call at full speed
+const size_t kMaxReplayBytes = 4 * 1024 * 1024;
+
+const int kDefaultBatchRate = 60;
+const size_t kDefaultMaxBatch = 4096;
+
+SerialLogStore::Options RealtimeLogOptions() {
+    SerialLogStore::Options options = SerialLogStore::GetDefaultOptions();
+    options.memory_limit = kRealtimeMemoryLimit;
+    return options;
+}
+
+long long SystemNow() {
+    return std::chrono::system_clock::now().time_since_epoch().count();
+}
+
+SerialMonitor::SerialMessage ToSerialMessage(const SerialLogStore::Message& message) {
+    SerialMonitor::SerialMessage result;
+    result.content.assign(message.content.data(), message.content.size());
+    result.type = static_cast<SerialMonitor::MessageType>(message.type);
+    result.timestamp = message.timestamp;
+    return result;
+}
+
+} // namespace
+
 SerialMonitor::SerialMonitor() 
-    : connected_(false), current_port_(""), baud_rate_(115200), 
-      realtime_reading_(false), memory_profiling_(false) {}
+    : connected_(false), current_port_(""), baud_rate_(115200), buffer_size_(4 * 1024 * 1024),
+      messages_(new SerialLogStore(SerialLogStore::GetDefaultOptions())),
+      batch_count_(0), max_batch_(kDefaultMaxBatch), delivering_(false),
+      batch_interval_(std::chrono::nanoseconds(std::chrono::seconds(1)) / kDefaultBatchRate), last_batch_(),
+      realtime_reading_(false), realtime_data_(RealtimeLogOptions()), memory_profiling_(false) {}
 
 SerialMonitor::~SerialMonitor() {
     Disconnect();
@@ -16,11 +55,21 @@ bool SerialMonitor::Connect(const std::string& port, int baud_rate) {
         Disconnect();
     }
     
+    if (!port_.Open(port, baud_rate)) {
+        AddMessage("Failed to connect: " + port_.GetError(), MessageType::ERROR);
+        return false;
+    }
+    reader_.reset(new SerialReader(buffer_size_));
+    if (!reader_->Start(port_.GetDescriptor())) {
+        port_.Close();
+        reader_.reset();
+        AddMessage("Failed to connect: cannot start reading " + port, MessageType::ERROR);
+        return false;
+    }
+    
     current_port_ = port;
     baud_rate_ = baud_rate;
-    
-    // In a real implementation, this would open the serial port
-    // For now, simulate connection
+    partial_line_.clear();
     connected_ = true;
     
     AddMessage("Connected to " + port + " at " + std::to_string(baud_rate) + " baud", 
@@ -34,11 +83,15 @@ bool SerialMonitor::Disconnect() {
         return false;
     }
     
-    // In a real implementation, this would close the serial port
+    reader_->Stop();
+    port_.Close();
     connected_ = false;
     
     AddMessage("Disconnected from " + current_port_, MessageType::INFO);
     current_port_ = "";
+    if (archive_) {
+        archive_->Flush();
+    }
     
     return true;
 }
@@ -52,45 +105,365 @@ bool SerialMonitor::SendData(const std::string& data) {
         return false;
     }
     
-    // In a real implementation, this would send data to the serial port
+    if (!port_.Write(data)) {
+        AddMessage("Send failed: " + port_.GetError(), MessageType::ERROR);
+        return false;
+    }
     AddMessage("Sent: " + data, MessageType::INFO);
     return true;
 }
 
 std::string SerialMonitor::ReceiveData() {
-    if (!connected_) {
-        return "";
+    std::string data;
+    if (!reader_) {
+        return data;
     }
     
-    // In a real implementation, this would read from the serial port
-    return "";
+    size_t size;
+    const char* span;
+    while ((span = reader_->Peek(size)), size > 0) {
+        data.append(span, size);
+        reader_->Consume(size);
+    }
+    return data;
 }
 
-void SerialMonitor::AddMessage(const std::string& content, MessageType type) {
-    SerialMessage msg;
-    msg.content = content;
-    msg.type = type;
-    msg.timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+size_t SerialMonitor::ProcessIncoming() {
+    size_t count = replay_ ? ProcessReplay() : 0;
+    if (!reader_) {
+        FlushIfDue();
+        return count;
+    }
+    
+    // Checked before draining: whatever arrived before the failure is kept
+    bool failed = reader_->HasFailed();
+    count += DrainReader();
     
-    messages_.push_back(msg);
-    NotifyMessage(msg);
+    if (failed && connected_) {
+        if (!partial_line_.empty()) {
+            HandleLine(std::move(partial_line_), SystemNow());
+            partial_line_.clear();
+            count++;
+        }
+        AddMessage("Connection lost on " + current_port_ + ": " + reader_->GetError(), MessageType::ERROR);
+        reader_->Stop();
+        port_.Close();
+        connected_ = false;
+        realtime_reading_ = false;
+    }
+    FlushIfDue();
+    return count;
+}
+
+size_t SerialMonitor::DrainReader() {
+    size_t count = 0;
+    size_t size;
+    const char* span;
+    if (session_) {
+        // A read at a time, so the recording keeps the reads' boundaries and times
+        long long read_time;
+        while ((span = reader_->PeekRead(size, read_time)), size > 0) {
+            if (session_ && !session_->Record(span, size, read_time)) {
+                std::string error = session_->GetError();
+                session_.reset();
+                AddMessage("Session recording stopped: " + error, MessageType::ERROR);
+            }
+            count += ProcessBytes(span, size, SystemNow());
+            reader_->Consume(size);
+        }
+    } else {
+        while ((span = reader_->Peek(size)), size > 0) {
+            count += ProcessBytes(span, size, SystemNow());
+            reader_->Consume(size);
+        }
+    }
+    DeliverTelemetry();
+    return count;
+}
+
+size_t SerialMonitor::ProcessReplay() {
+    size_t count = 0;
+    size_t budget = kMaxReplayBytes;
+    long long timestamp = SystemNow();
+    SerialSessionReplay::Chunk chunk;
+    while (budget > 0 && replay_->Next(chunk)) {
+        count += ProcessBytes(chunk.data, chunk.size, chunk.timestamp);
+        budget -= std::min(budget, chunk.size);
+        timestamp = chunk.timestamp;
+    }
+    DeliverTelemetry();
+    if (replay_->AtEnd()) {
+        // The recording ended: nothing more will complete the last line
+        if (!partial_line_.empty()) {
+            HandleLine(std::move(partial_line_), timestamp);
+            partial_line_.clear();
+            count++;
+        }
+        replay_.reset();
+        AddMessage("Replay of " + replay_path_ + " finished", MessageType::INFO);
+    }
+    return count;
+}
+
+size_t SerialMonitor::ProcessBytes(const char* data, size_t size, long long timestamp) {
+    if (telemetry_) {
+        return telemetry_->Feed(data, size);
+    }
+    size_t lines = 0;
+    const char* end = data + size;
+    const char* start = data;
+    for (const char* newline; (newline = std::find(start, end, '\n')) != end; start = newline + 1) {
+        partial_line_.append(start, newline);
+        HandleLine(std::move(partial_line_), timestamp);
+        partial_line_.clear();
+        lines++;
+    }
+    partial_line_.append(start, end);
+    while (partial_line_.size() >= kMaxLineLength) {
+        HandleLine(partial_line_.substr(0, kMaxLineLength), timestamp);
+        partial_line_.erase(0, kMaxLineLength);
+        lines++;
+    }
+    return lines;
+}
+
+void SerialMonitor::DeliverTelemetry() {
+    if (!telemetry_) {
+        return;
+    }
+    if (telemetry_->GetRowCount() > 0 && telemetry_callback_) {
+        telemetry_callback_(*telemetry_);
+    }
+    telemetry_->ClearColumns();
+}
+
+void SerialMonitor::HandleLine(std::string line, long long timestamp) {
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    MessageType type = ClassifyLine(line);
+    if (realtime_reading_) {
+        realtime_data_.Append(line, static_cast<uint8_t>(type), timestamp);
+    }
+    AppendMessage(line, type, timestamp);
+    if (symbolizer_) {
+        for (const std::string& frame : symbolizer_->Symbolize(line)) {
+            AppendMessage(frame, MessageType::ERROR, timestamp);
+        }
+    }
+}
+
+SerialMonitor::MessageType SerialMonitor::ClassifyLine(const std::string& line) {
+    // ESP-IDF log lines: "E (1234) tag: message"
+    if (line.size() > 2 && line[1] == ' ' && line[2] == '(') {
+        if (line[0] == 'E') return MessageType::ERROR;
+        if (line[0] == 'W') return MessageType::WARNING;
+    }
+    if (line.compare(0, 15, "Guru Meditation") == 0 || line.compare(0, 10, "Backtrace:") == 0) {
+        return MessageType::ERROR;
+    }
+    return MessageType::NORMAL;
+}
+
+void SerialMonitor::SetTelemetryDecoder(std::unique_ptr<TelemetryDecoder> decoder, TelemetryCallback callback) {
+    telemetry_ = std::move(decoder);
+    telemetry_callback_ = callback;
+    partial_line_.clear();
+}
+
+void SerialMonitor::SetBufferSize(size_t bytes) {
+    buffer_size_ = bytes;
+}
+
+SerialReader::Statistics SerialMonitor::GetReaderStatistics() const {
+    if (!reader_) {
+        return SerialReader::Statistics{0, 0};
+    }
+    return reader_->GetStatistics();
+}
+
+void SerialMonitor::AddMessage(const std::string& content, MessageType type) {
+    AppendMessage(content, type, SystemNow());
+}
+
+void SerialMonitor::AppendMessage(const std::string& content, MessageType type, long long timestamp) {
+    messages_->Append(content, static_cast<uint8_t>(type), timestamp);
+    if (archive_ && !archive_->Append(content, static_cast<uint8_t>(type), timestamp)) {
+        std::string error = archive_->GetError();
+        archive_.reset();
+        AddMessage("Recording stopped: " + error, MessageType::ERROR);
+    }
+    NotifyMessage(content, type, timestamp);
+}
+
+bool SerialMonitor::StartRecording(const std::string& path) {
+    StopRecording();
+    std::unique_ptr<SerialArchiveWriter> archive(new SerialArchiveWriter());
+    if (!archive->Open(path)) {
+        AddMessage("Cannot record to " + path + ": " + archive->GetError(), MessageType::ERROR);
+        return false;
+    }
+    archive_ = std::move(archive);
+    AddMessage("Recording to " + path, MessageType::INFO);
+    return true;
+}
+
+bool SerialMonitor::StartSessionRecording(const std::string& path) {
+    StopSessionRecording();
+    std::unique_ptr<SerialSessionWriter> session(new SerialSessionWriter());
+    if (!session->Open(path)) {
+        AddMessage("Cannot record session to " + path + ": " + session->GetError(), MessageType::ERROR);
+        return false;
+    }
+    session_ = std::move(session);
+    AddMessage("Recording session to " + path, MessageType::INFO);
+    return true;
+}
+
+void SerialMonitor::StopSessionRecording() {
+    if (!session_) {
+        return;
+    }
+    std::string path = session_->GetPath();
+    session_.reset();
+    AddMessage("Stopped recording session to " + path, MessageType::INFO);
+}
+
+bool SerialMonitor::StartReplay(const std::string& path, double speed) {
+    Disconnect();
+    StopReplay();
+    std::unique_ptr<SerialSessionReplay> replay(new SerialSessionReplay());
+    if (!replay->Open(path)) {
+        AddMessage("Cannot replay " + path + ": " + replay->GetError(), MessageType::ERROR);
+        return false;
+    }
+    replay->Start(speed);
+    replay_ = std::move(replay);
+    replay_path_ = path;
+    partial_line_.clear();
+    AddMessage("Replaying " + path + (speed > 0 ? " at " + std::to_string(speed) + "x" : " at full speed"),
+               MessageType::INFO);
+    return true;
+}
+
+void SerialMonitor::StopReplay() {
+    if (!replay_) {
+        return;
+    }
+    replay_.reset();
+    partial_line_.clear();
+    AddMessage("Stopped replay of " + replay_path_, MessageType::INFO);
+}
+
+bool SerialMonitor::LoadFirmwareSymbols(const std::string& elf_path) {
+    std::unique_ptr<PanicSymbolizer> symbolizer(new PanicSymbolizer());
+    if (!symbolizer->Load(elf_path)) {
+        AddMessage("Cannot load symbols from " + elf_path + ": " + symbolizer->GetError(), MessageType::ERROR);
+        return false;
+    }
+    AddMessage("Loaded " + std::to_string(symbolizer->GetFunctionCount()) + " functions from " + elf_path,
+               MessageType::INFO);
+    symbolizer_ = std::move(symbolizer);
+    return true;
+}
+
+void SerialMonitor::ClearFirmwareSymbols() {
+    symbolizer_.reset();
+}
+
+void SerialMonitor::StopRecording() {
+    if (!archive_) {
+        return;
+    }
+    std::string path = archive_->GetPath();
+    AddMessage("Stopped recording to " + path, MessageType::INFO);
+    archive_.reset();
 }
 
 std::vector<SerialMonitor::SerialMessage> SerialMonitor::GetMessages() const {
-    return messages_;
+    return GetMessages(messages_->GetFirstIndex(), static_cast<size_t>(messages_->Size()));
+}
+
+std::vector<SerialMonitor::SerialMessage> SerialMonitor::GetMessages(uint64_t first, size_t count) const {
+    std::vector<SerialMessage> messages;
+    messages.reserve(static_cast<size_t>(std::min<uint64_t>(count, messages_->Size())));
+    messages_->Read(first, count, [&messages](uint64_t, const SerialLogStore::Message& message) {
+        messages.push_back(ToSerialMessage(message));
+    });
+    return messages;
+}
+
+SerialLogStore::Cursor SerialMonitor::GetMessageCursor(uint64_t first) const {
+    return messages_->GetCursor(first);
+}
+
+uint64_t SerialMonitor::GetFirstMessageIndex() const {
+    return messages_->GetFirstIndex();
+}
+
+uint64_t SerialMonitor::GetMessageEndIndex() const {
+    return messages_->GetEndIndex();
+}
+
+size_t SerialMonitor::GetMessageCount() const {
+    return static_cast<size_t>(messages_->Size());
 }
 
 void SerialMonitor::ClearMessages() {
-    messages_.clear();
+    messages_->Clear();
+}
+
+void SerialMonitor::SetLogOptions(const SerialLogStore::Options& options) {
+    messages_.reset(new SerialLogStore(options));
+}
+
+SerialLogStore::Statistics SerialMonitor::GetLogStatistics() const {
+    return messages_->GetStatistics();
 }
 
 void SerialMonitor::SetMessageCallback(MessageCallback callback) {
     message_callback_ = callback;
 }
 
+void SerialMonitor::SetBatchCallback(BatchCallback callback) {
+    batch_callback_ = callback;
+    batch_count_ = 0;
+}
+
+void SerialMonitor::SetBatchLimits(int max_rate_hz, size_t max_batch) {
+    if (max_rate_hz > 0) {
+        batch_interval_ = std::chrono::nanoseconds(std::chrono::seconds(1)) / max_rate_hz;
+    } else {
+        batch_interval_ = std::chrono::steady_clock::duration::zero();
+    }
+    max_batch_ = std::max<size_t>(max_batch, 1);
+}
+
+size_t SerialMonitor::FlushMessages() {
+    if (batch_count_ == 0 || delivering_) {
+        return 0;
+    }
+    size_t count = batch_count_;
+    batch_count_ = 0;
+    last_batch_ = std::chrono::steady_clock::now();
+    // Messages the callback itself adds start the next batch
+    batch_.swap(delivered_);
+    delivering_ = true;
+    batch_callback_(delivered_.data(), count);
+    delivering_ = false;
+    return count;
+}
+
+void SerialMonitor::FlushIfDue() {
+    if (archive_) {
+        archive_->FlushIfDue();
+    }
+    if (batch_count_ > 0 && std::chrono::steady_clock::now() - last_batch_ >= batch_interval_) {
+        FlushMessages();
+    }
+}
+
 std::vector<std::string> SerialMonitor::GetAvailablePorts() {
-    // In a real implementation, this would scan for available serial ports
-    // For simulation, return common port names
     std::vector<std::string> ports;
     
 #ifdef _WIN32
@@ -98,9 +471,20 @@ std::vector<std::string> SerialMonitor::GetAvailablePorts() {
     ports.push_back("COM3");
     ports.push_back("COM4");
 #else
-    ports.push_back("/dev/ttyUSB0");
-    ports.push_back("/dev/ttyUSB1");
-    ports.push_back("/dev/ttyACM0");
+    // USB-UART bridges (CP210x, CH34x, FTDI) and native USB CDC
+    static const char* kPrefixes[] = {"ttyUSB", "ttyACM", "cu.usbserial", "cu.usbmodem", "cu.SLAB_USBtoUART",
+                                      "cu.wchusbserial"};
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/dev", error)) {
+        std::string name = entry.path().filename().string();
+        for (const char* prefix : kPrefixes) {
+            if (name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0) {
+                ports.push_back(entry.path().string());
+                break;
+            }
+        }
+    }
+    std::sort(ports.begin(), ports.end());
 #endif
     
     return ports;
@@ -121,11 +505,8 @@ void SerialMonitor::StartRealtimeReading() {
     }
     
     realtime_reading_ = true;
-    realtime_data_.clear();
+    realtime_data_.Clear();
     AddMessage("Started realtime data reading", MessageType::SUCCESS);
-    
-    // Simulate initial data
-    SimulateDataReading();
 }
 
 void SerialMonitor::StopRealtimeReading() {
@@ -138,36 +519,43 @@ bool SerialMonitor::IsRealtimeReading() const {
 }
 
 std::vector<std::string> SerialMonitor::GetRealtimeData() const {
-    return realtime_data_;
+    std::vector<std::string> data;
+    data.reserve(static_cast<size_t>(realtime_data_.Size()));
+    realtime_data_.Read(realtime_data_.GetFirstIndex(), static_cast<size_t>(realtime_data_.Size()),
+                        [&data](uint64_t, const SerialLogStore::Message& message) {
+        data.emplace_back(message.content);
+    });
+    return data;
 }
 
 void SerialMonitor::ClearRealtimeData() {
-    realtime_data_.clear();
+    realtime_data_.Clear();
 }
 
-void SerialMonitor::SimulateDataReading() {
-    // Simulate receiving data from device
-    // In a real implementation, this would read from the actual serial port
-    if (!realtime_reading_) {
+void SerialMonitor::NotifyMessage(const std::string& content, MessageType type, long long timestamp) {
+    if (message_callback_) {
+        SerialMessage message;
+        message.content = content;
+        message.type = type;
+        message.timestamp = timestamp;
+        message_callback_(message);
+    }
+    if (!batch_callback_) {
         return;
     }
     
-    // Simulate various types of ESP32 data
-    realtime_data_.push_back("[0.000] ESP32 Boot");
-    realtime_data_.push_back("[0.100] WiFi: Connecting...");
-    realtime_data_.push_back("[0.500] WiFi: Connected");
-    realtime_data_.push_back("[1.000] IP Address: 192.168.1.100");
-    realtime_data_.push_back("[2.000] Temperature: 25.3°C");
-    realtime_data_.push_back("[2.500] Humidity: 60.2%");
-    realtime_data_.push_back("[3.000] GPIO2: HIGH");
-    realtime_data_.push_back("[3.500] Sensor Reading: 1023");
-    realtime_data_.push_back("[4.000] Free Heap: 280000 bytes");
-    realtime_data_.push_back("[4.500] Loop iteration: 100");
-}
-
-void SerialMonitor::NotifyMessage(const SerialMessage& message) {
-    if (message_callback_) {
-        message_callback_(message);
+    if (batch_count_ == batch_.size()) {
+        batch_.emplace_back();
+    }
+    // Assigning into a used slot keeps its string's capacity
+    SerialMessage& slot = batch_[batch_count_++];
+    slot.content.assign(content);
+    slot.type = type;
+    slot.timestamp = timestamp;
+    if (batch_count_ >= max_batch_) {
+        FlushMessages();
+    } else {
+        FlushIfDue();
     }
 }
 
@@ -218,7 +606,7 @@ bool SerialMonitor::IsMemoryProfiling() const {
 }
 
 std::vector<SerialMonitor::MemoryProfile> SerialMonitor::GetMemoryHistory() const {
-    return memory_history_;
+    return std::vector<MemoryProfile>(memory_history_.begin(), memory_history_.end());
 }
 
 void SerialMonitor::SimulateMemoryProfiling() {
@@ -246,6 +634,9 @@ void SerialMonitor::SimulateMemoryProfiling() {
         }
         
         memory_history_.push_back(profile);
+        if (memory_history_.size() > kMaxMemoryHistory) {
+            memory_history_.pop_front();
+        }
     }
 }
 
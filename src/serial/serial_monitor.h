@@ -1,24 +1,48 @@
 #ifndef SERIAL_MONITOR_H
 #define SERIAL_MONITOR_H
 
+#include "serial/serial_port.h"
+#include "serial/serial_reader.h"
+#include "serial/serial_log_store.h"
+#include "serial/serial_archive.h"
+#include "serial/serial_session.h"
+#include "serial/telemetry_decoder.h"
+#include "serial/panic_symbolizer.h"
 #include <string>
 #include <vector>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <chrono>
 
 namespace esp32_ide {
 
 /**
  * @brief Serial monitor for ESP32 communication
  * 
- * Handles serial communication with ESP32 devices
+ * Handles serial communication with ESP32 devices. Connect() opens the
+ * port (any baud rate the driver accepts, 2-3 Mbaud included) and starts
+ * a SerialReader thread that moves incoming bytes into a lock-free ring.
+ * The owning thread calls ProcessIncoming(), e.g. once per UI frame, to
+ * drain the ring and turn complete lines into messages.
  * 
- * @note Thread Safety: This class is NOT thread-safe. If multi-threaded
- * serial reading is implemented in the future, proper synchronization
- * (mutexes) must be added to protect shared data members, especially:
- * - messages_
- * - realtime_data_
- * - memory_history_
- * - connected_ flag
+ * Listeners either get every message as it is added (SetMessageCallback)
+ * or coalesced batches paced to the UI's frame rate (SetBatchCallback),
+ * which keeps a chatty device from costing a redraw per line.
+ * 
+ * Firmware streaming binary frames instead of text switches the monitor
+ * to a TelemetryDecoder, which turns the stream into numeric columns.
+ * 
+ * Messages and realtime data live in SerialLogStores, bounded in RAM and
+ * optionally spilling to disk (SetLogOptions); read them through a cursor
+ * or by range rather than copying the whole log. StartRecording() also
+ * appends every message to a capture file for sessions longer than the
+ * store keeps; open it with SerialArchiveReader. StartSessionRecording()
+ * keeps the raw input instead, for StartReplay() to play back.
+ * 
+ * @note Thread Safety: apart from the reader thread, which only touches
+ * the ring, the class is NOT thread-safe; messages_, realtime_data_ and
+ * the rest belong to the thread that owns the monitor.
  */
 class SerialMonitor {
 public:
@@ -37,6 +61,10 @@ public:
     };
     
     using MessageCallback = std::function<void(const SerialMessage&)>;
+    // Consecutive messages, oldest first; valid for the duration of the call
+    using BatchCallback = std::function<void(const SerialMessage* messages, size_t count)>;
+    // Takes the decoder's columns; they are cleared once it returns
+    using TelemetryCallback = std::function<void(const TelemetryDecoder& decoder)>;
     
     SerialMonitor();
     ~SerialMonitor();
@@ -48,15 +76,119 @@ public:
     
     // Communication
     bool SendData(const std::string& data);
+    // Raw bytes received since the last call, bypassing line handling
     std::string ReceiveData();
+    /**
+     * @brief Turns received bytes into messages
+     * 
+     * Drains the reader's ring without locking, splits it into lines (a
+     * trailing partial line waits for the rest) and adds each as a
+     * message, ESP-IDF "E (...)" and "W (...)" lines as errors and
+     * warnings. Notices a vanished device and disconnects.
+     * @return Number of lines added, or records decoded in telemetry mode
+     */
+    size_t ProcessIncoming();
+    // ESP-IDF "E (...)" lines are errors, "W (...)" warnings, the rest NORMAL
+    static MessageType ClassifyLine(const std::string& line);
+    
+    /**
+     * @brief Treats incoming data as binary telemetry instead of text
+     * 
+     * ProcessIncoming() then feeds the received bytes to the decoder
+     * straight from the ring and hands the decoded columns to the
+     * callback. Pass nullptr to go back to lines.
+     */
+    void SetTelemetryDecoder(std::unique_ptr<TelemetryDecoder> decoder, TelemetryCallback callback);
+    const TelemetryDecoder* GetTelemetryDecoder() const { return telemetry_.get(); }
+    
+    // Ring between the reader thread and ProcessIncoming(); used from the next Connect()
+    void SetBufferSize(size_t bytes);
+    SerialReader::Statistics GetReaderStatistics() const;
     
     // Message handling
     void AddMessage(const std::string& content, MessageType type = MessageType::NORMAL);
+    // Copies every retained message; prefer a cursor or a range for long logs
     std::vector<SerialMessage> GetMessages() const;
+    std::vector<SerialMessage> GetMessages(uint64_t first, size_t count) const;
+    // Message types are stored as MessageType values
+    SerialLogStore::Cursor GetMessageCursor(uint64_t first) const;
+    // Indices run on across evictions and ClearMessages()
+    uint64_t GetFirstMessageIndex() const;
+    uint64_t GetMessageEndIndex() const;
+    size_t GetMessageCount() const;
     void ClearMessages();
     
+    // Replaces the message log, which starts out empty
+    void SetLogOptions(const SerialLogStore::Options& options);
+    SerialLogStore::Statistics GetLogStatistics() const;
+    
+    /**
+     * @brief Records every message added from now on to a capture file
+     * 
+     * Continues an existing capture. Blocks are committed as they fill,
+     * after a few seconds at most, and on Disconnect(), so a reader sees
+     * the session while it is being recorded.
+     */
+    bool StartRecording(const std::string& path);
+    void StopRecording();
+    bool IsRecording() const { return archive_ != nullptr; }
+    
+    /**
+     * @brief Records the raw bytes read from the port, with the time of each read
+     * 
+     * Unlike StartRecording() this keeps the input rather than the
+     * messages made of it, for StartReplay() to feed through the monitor
+     * again: repeatable input for tests and benchmarks, or a field report
+     * reproduced without the hardware.
+     */
+    bool StartSessionRecording(const std::string& path);
+    void StopSessionRecording();
+    bool IsSessionRecording() const { return session_ != nullptr; }
+    
+    /**
+     * @brief Plays a recorded session back in place of a device
+     * 
+     * Disconnects, then ProcessIncoming() hands the recorded reads to line
+     * splitting or telemetry decoding exactly as they arrived: at their
+     * recorded pace times `speed`, or as fast as possible with speed 0
+     * (up to 4 MiB per call). Messages carry their recorded timestamps, so
+     * a replay is deterministic. Ends by itself after the last read.
+     */
+    bool StartReplay(const std::string& path, double speed = 1.0);
+    void StopReplay();
+    bool IsReplaying() const { return replay_ != nullptr; }
+    
+    /**
+     * @brief Symbolizes crash output against the firmware that is running
+     * 
+     * Once loaded, a "Backtrace:" line, a register dump line or an
+     * "abort() was called at PC" line is followed in the log by the
+     * functions its addresses fall in, with the line's timestamp. The
+     * index is built on the first load of an ELF and reused after that;
+     * see PanicSymbolizer.
+     */
+    bool LoadFirmwareSymbols(const std::string& elf_path);
+    void ClearFirmwareSymbols();
+    bool HasFirmwareSymbols() const { return symbolizer_ != nullptr; }
+    
     // Callbacks
+    // Called synchronously for every message
     void SetMessageCallback(MessageCallback callback);
+    /**
+     * @brief Delivers messages in batches rather than one by one
+     * 
+     * Messages are collected and handed over as one span at most
+     * max_rate_hz times a second, or as soon as max_batch are waiting.
+     * Delivery always happens on the thread that owns the monitor, from
+     * AddMessage() or ProcessIncoming(); call the latter once per frame so
+     * a batch whose interval has passed goes out even when the line is
+     * quiet. Replacing the callback drops undelivered messages.
+     */
+    void SetBatchCallback(BatchCallback callback);
+    // 60 Hz and 4096 messages by default; a rate of 0 delivers every message at once
+    void SetBatchLimits(int max_rate_hz, size_t max_batch);
+    // Delivers whatever is pending now; returns how many messages
+    size_t FlushMessages();
     
     // Port management
     static std::vector<std::string> GetAvailablePorts();
@@ -103,16 +235,42 @@ private:
     bool connected_;
     std::string current_port_;
     int baud_rate_;
-    std::vector<SerialMessage> messages_;
+    SerialPort port_;
+    std::unique_ptr<SerialReader> reader_;
+    size_t buffer_size_;
+    std::string partial_line_;
+    std::unique_ptr<TelemetryDecoder> telemetry_;
+    TelemetryCallback telemetry_callback_;
+    std::unique_ptr<SerialLogStore> messages_;
+    std::unique_ptr<SerialArchiveWriter> archive_;
+    std::unique_ptr<SerialSessionWriter> session_;
+    std::unique_ptr<SerialSessionReplay> replay_;
+    std::string replay_path_;
+    std::unique_ptr<PanicSymbolizer> symbolizer_;
     MessageCallback message_callback_;
+    BatchCallback batch_callback_;
+    std::vector<SerialMessage> batch_;          // slots are reused batch after batch
+    std::vector<SerialMessage> delivered_;      // the batch being handed over
+    size_t batch_count_;
+    size_t max_batch_;
+    bool delivering_;
+    std::chrono::steady_clock::duration batch_interval_;
+    std::chrono::steady_clock::time_point last_batch_;
     bool realtime_reading_;
-    std::vector<std::string> realtime_data_;
+    SerialLogStore realtime_data_;
     bool memory_profiling_;
-    std::vector<MemoryProfile> memory_history_;
+    std::deque<MemoryProfile> memory_history_;
     std::vector<WatchVariable> watch_variables_;
     
-    void NotifyMessage(const SerialMessage& message);
-    void SimulateDataReading();
+    void NotifyMessage(const std::string& content, MessageType type, long long timestamp);
+    void FlushIfDue();
+    void AppendMessage(const std::string& content, MessageType type, long long timestamp);
+    size_t DrainReader();
+    size_t ProcessReplay();
+    // Lines completed or records decoded
+    size_t ProcessBytes(const char* data, size_t size, long long timestamp);
+    void DeliverTelemetry();
+    void HandleLine(std::string line, long long timestamp);
     void SimulateMemoryProfiling();
 };
 
@@ -0,0 +1,288 @@
+#include "serial/serial_port.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#ifdef __APPLE__
+#include <IOKit/serial/ioss.h>
+#endif
+
+namespace esp32_ide {
+
+namespace {
+
+#ifndef _WIN32
+
+bool ToSpeed(int baud_rate, speed_t& speed) {
+    static const struct {
+        int rate;
+        speed_t speed;
+    } kRates[] = {
+        {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+#ifdef B460800
+        {460800, B460800},
+#endif
+#ifdef B500000
+        {500000, B500000},
+#endif
+#ifdef B921600
+        {921600, B921600},
+#endif
+#ifdef B1000000
+        {1000000, B1000000},
+#endif
+#ifdef B1500000
+        {1500000, B1500000},
+#endif
+#ifdef B2000000
+        {2000000, B2000000},
+#endif
+#ifdef B3000000
+        {3000000, B3000000},
+#endif
+#ifdef B4000000
+        {4000000, B4000000},
+#endif
+    };
+    for (const auto& entry : kRates) {
+        if (entry.rate == baud_rate) {
+            speed = entry.speed;
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(__linux__) && defined(TCGETS2) && !defined(__powerpc__) && !defined(__alpha__)
+#define ESP32IDE_TERMIOS2 1
+
+// <asm/termbits.h> clashes with <termios.h>, so its termios2 is mirrored here
+struct Termios2 {
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+const tcflag_t kCbaud = 0010017;
+const tcflag_t kBother = 0010000;
+const unsigned long kGetTermios2 = _IOR('T', 0x2A, Termios2);
+const unsigned long kSetTermios2 = _IOW('T', 0x2B, Termios2);
+#endif
+
+// Rates without a B* constant, e.g. 250000 or 1843200
+bool SetCustomSpeed(int fd, int baud_rate) {
+#if defined(ESP32IDE_TERMIOS2)
+    Termios2 tty;
+    if (::ioctl(fd, kGetTermios2, &tty) != 0) return false;
+    tty.c_cflag = (tty.c_cflag & ~kCbaud) | kBother;
+    tty.c_cflag &= ~(kCbaud << 16);             // input speed follows c_ispeed
+    tty.c_cflag |= kBother << 16;
+    tty.c_ispeed = static_cast<speed_t>(baud_rate);
+    tty.c_ospeed = static_cast<speed_t>(baud_rate);
+    if (::ioctl(fd, kSetTermios2, &tty) != 0) return false;
+    // Drivers round to what their divisor can do; reject what is far off
+    if (::ioctl(fd, kGetTermios2, &tty) != 0) return false;
+    long error = static_cast<long>(tty.c_ospeed) - baud_rate;
+    if ((error < 0 ? -error : error) * 50 > baud_rate) {
+        errno = ERANGE;
+        return false;
+    }
+    return true;
+#elif defined(__APPLE__) && defined(IOSSIOSPEED)
+    speed_t speed = static_cast<speed_t>(baud_rate);
+    return ::ioctl(fd, IOSSIOSPEED, &speed) == 0;
+#else
+    (void)fd; (void)baud_rate;
+    errno = EINVAL;
+    return false;
+#endif
+}
+
+#endif
+
+} // namespace
+
+SerialPort::SerialPort() : fd_(-1), baud_rate_(0) {
+}
+
+SerialPort::~SerialPort() {
+    Close();
+}
+
+bool SerialPort::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool SerialPort::Open(const std::string& path, int baud_rate) {
+    Close();
+    path_ = path;
+#ifdef _WIN32
+    (void)baud_rate;
+    return Fail("Serial ports are not supported on this platform");
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        return Fail("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    struct termios tty;
+    if (::tcgetattr(fd_, &tty) != 0) {
+        std::string message = "Not a serial port: " + path;
+        Close();
+        return Fail(message);
+    }
+    ::cfmakeraw(&tty);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(CSTOPB | PARENB);
+#ifdef CRTSCTS
+    tty.c_cflag &= ~CRTSCTS;
+#endif
+    tty.c_cc[VMIN] = 0;
+    tty.c_cc[VTIME] = 0;
+    if (::tcsetattr(fd_, TCSANOW, &tty) != 0) {
+        std::string message = "Cannot configure " + path + ": " + std::strerror(errno);
+        Close();
+        return Fail(message);
+    }
+    if (!SetBaudRate(baud_rate)) {
+        std::string message = error_;
+        Close();
+        return Fail(message);
+    }
+    FlushInput();
+    return true;
+#endif
+}
+
+void SerialPort::Close() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+    fd_ = -1;
+    baud_rate_ = 0;
+}
+
+bool SerialPort::SetBaudRate(int baud_rate) {
+#ifdef _WIN32
+    (void)baud_rate;
+    return Fail("Serial ports are not supported on this platform");
+#else
+    if (fd_ < 0) return Fail("Port not open");
+    if (baud_rate <= 0) {
+        return Fail("Unsupported baud rate: " + std::to_string(baud_rate));
+    }
+    speed_t speed;
+    if (!ToSpeed(baud_rate, speed)) {
+        if (!SetCustomSpeed(fd_, baud_rate)) {
+            return Fail("Unsupported baud rate: " + std::to_string(baud_rate) + " (" + std::strerror(errno) + ")");
+        }
+        baud_rate_ = baud_rate;
+        return true;
+    }
+    struct termios tty;
+    if (::tcgetattr(fd_, &tty) != 0 || ::cfsetispeed(&tty, speed) != 0 || ::cfsetospeed(&tty, speed) != 0 ||
+        ::tcsetattr(fd_, TCSANOW, &tty) != 0) {
+        return Fail("Cannot set baud rate " + std::to_string(baud_rate) + ": " + std::strerror(errno));
+    }
+    baud_rate_ = baud_rate;
+    return true;
+#endif
+}
+
+bool SerialPort::Write(const char* data, size_t size) {
+#ifdef _WIN32
+    (void)data; (void)size;
+    return Fail("Serial ports are not supported on this platform");
+#else
+    while (size > 0) {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // The driver's buffer is full; wait for it to drain
+                struct pollfd pfd = {fd_, POLLOUT, 0};
+                if (::poll(&pfd, 1, 1000) <= 0) {
+                    return Fail("Write timed out on " + path_);
+                }
+                continue;
+            }
+            return Fail("Write failed on " + path_ + ": " + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+#endif
+}
+
+long SerialPort::Read(char* buffer, size_t size, int timeout_ms) {
+#ifdef _WIN32
+    (void)buffer; (void)size; (void)timeout_ms;
+    return -1;
+#else
+    if (fd_ < 0) return -1;
+    struct pollfd pfd = {fd_, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&pfd, 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    if (ready < 0) {
+        Fail("Read failed on " + path_ + ": " + std::strerror(errno));
+        return -1;
+    }
+    if (ready == 0) return 0;
+    ssize_t count = ::read(fd_, buffer, size);
+    if (count < 0) {
+        if (errno == EAGAIN || errno == EINTR) return 0;
+        Fail("Read failed on " + path_ + ": " + std::strerror(errno));
+        return -1;
+    }
+    if (count == 0 && (pfd.revents & POLLHUP)) {
+        Fail("Device disconnected: " + path_);
+        return -1;
+    }
+    return static_cast<long>(count);
+#endif
+}
+
+void SerialPort::FlushInput() {
+#ifndef _WIN32
+    if (fd_ >= 0) {
+        ::tcflush(fd_, TCIFLUSH);
+    }
+#endif
+}
+
+bool SerialPort::SetControlLines(bool dtr, bool rts) {
+#ifdef _WIN32
+    (void)dtr; (void)rts;
+    return false;
+#else
+    if (fd_ < 0) return false;
+    int lines = 0;
+    if (::ioctl(fd_, TIOCMGET, &lines) != 0) {
+        return false;
+    }
+    lines = dtr ? (lines | TIOCM_DTR) : (lines & ~TIOCM_DTR);
+    lines = rts ? (lines | TIOCM_RTS) : (lines & ~TIOCM_RTS);
+    return ::ioctl(fd_, TIOCMSET, &lines) == 0;
+#endif
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,64 @@
+#ifndef SERIAL_PORT_H
+#define SERIAL_PORT_H
+
+#include <string>
+#include <cstddef>
+
+namespace esp32_ide {
+
+/**
+ * @brief Raw serial port (POSIX termios)
+ *
+ * 8N1, no flow control, no line discipline: bytes go through untouched,
+ * which binary protocols like the ESP bootloader's need. Reads wait up to
+ * a timeout and return whatever arrived. Works on USB-UART adapters and
+ * on the slave side of a pty, where the modem-line calls quietly fail.
+ * Not available on Windows.
+ */
+class SerialPort {
+public:
+    SerialPort();
+    ~SerialPort();
+
+    SerialPort(const SerialPort&) = delete;
+    SerialPort& operator=(const SerialPort&) = delete;
+
+    bool Open(const std::string& path, int baud_rate);
+    void Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    // Standard rates use B* constants; others (250000, 1843200, ...) go
+    // through termios2 on Linux and IOSSIOSPEED on macOS
+    bool SetBaudRate(int baud_rate);
+    int GetBaudRate() const { return baud_rate_; }
+
+    bool Write(const char* data, size_t size);
+    bool Write(const std::string& data) { return Write(data.data(), data.size()); }
+
+    /**
+     * @brief Reads what arrives within timeout_ms
+     * @return Bytes read (0 on timeout), -1 on error
+     */
+    long Read(char* buffer, size_t size, int timeout_ms);
+    // Discards unread input
+    void FlushInput();
+
+    // DTR and RTS drive EN and IO0 on ESP dev boards
+    bool SetControlLines(bool dtr, bool rts);
+
+    int GetDescriptor() const { return fd_; }
+    const std::string& GetPath() const { return path_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    int fd_;
+    int baud_rate_;
+    std::string path_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+};
+
+} // namespace esp32_ide
+
+#endif // SERIAL_PORT_H
@@ -0,0 +1,202 @@
+#include "serial/serial_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace esp32_ide {
+
+namespace {
+
+enum class Wake {
+    READABLE,
+    HANGUP,
+    STOP,
+    ERROR
+};
+
+const size_t kStampRingCapacity = 64 * 1024;
+
+long long SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+SerialReader::SerialReader(size_t ring_capacity)
+    : ring_(ring_capacity), stamps_(kStampRingCapacity), produced_(0), consumed_(0), stamp_{0, 0},
+      has_stamp_(false), fd_(-1), wake_{-1, -1}, epoll_fd_(-1), stopping_(false), failed_(false),
+      bytes_read_(0), full_waits_(0) {
+}
+
+SerialReader::~SerialReader() {
+    Stop();
+}
+
+void SerialReader::Fail(const std::string& message) {
+    error_ = message;
+    failed_.store(true, std::memory_order_release);
+}
+
+void SerialReader::CloseDescriptors() {
+#ifndef _WIN32
+    for (int& fd : wake_) {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+#endif
+    epoll_fd_ = -1;
+}
+
+bool SerialReader::Start(int fd) {
+    Stop();
+#ifdef _WIN32
+    (void)fd;
+    return false;
+#else
+    fd_ = fd;
+    stopping_ = false;
+    failed_ = false;
+    error_.clear();
+    if (::pipe(wake_) != 0) {
+        return false;
+    }
+    ::fcntl(wake_[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(wake_[1], F_SETFD, FD_CLOEXEC);
+#ifdef __linux__
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event port_event = {};
+    port_event.events = EPOLLIN;
+    port_event.data.fd = fd_;
+    struct epoll_event wake_event = {};
+    wake_event.events = EPOLLIN;
+    wake_event.data.fd = wake_[0];
+    if (epoll_fd_ < 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &port_event) != 0 ||
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_[0], &wake_event) != 0) {
+        CloseDescriptors();
+        return false;
+    }
+#endif
+    thread_ = std::thread([this]() { Run(); });
+    return true;
+#endif
+}
+
+void SerialReader::Stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stopping_ = true;
+#ifndef _WIN32
+    char byte = 0;
+    ssize_t ignored = ::write(wake_[1], &byte, 1);
+    (void)ignored;
+#endif
+    thread_.join();
+    CloseDescriptors();
+}
+
+SerialReader::Statistics SerialReader::GetStatistics() const {
+    Statistics statistics;
+    statistics.bytes_read = bytes_read_.load(std::memory_order_relaxed);
+    statistics.full_waits = full_waits_.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+const char* SerialReader::PeekRead(size_t& size, long long& timestamp) {
+    const char* span = ring_.ReadSpan(size);
+    if (size == 0) {
+        return span;
+    }
+    while (!has_stamp_ || stamp_.end <= consumed_) {
+        if (stamps_.Size() < sizeof(Stamp)) {
+            has_stamp_ = false;
+            timestamp = SteadyNow();
+            return span;
+        }
+        stamps_.Read(reinterpret_cast<char*>(&stamp_), sizeof(Stamp));
+        has_stamp_ = true;
+    }
+    size = static_cast<size_t>(std::min<uint64_t>(size, stamp_.end - consumed_));
+    timestamp = stamp_.timestamp;
+    return span;
+}
+
+void SerialReader::Run() {
+#ifndef _WIN32
+    auto wait = [this]() {
+#ifdef __linux__
+        struct epoll_event events[2];
+        int count = ::epoll_wait(epoll_fd_, events, 2, -1);
+        if (count < 0) return errno == EINTR ? Wake::READABLE : Wake::ERROR;
+        Wake wake = Wake::READABLE;
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd == wake_[0]) return Wake::STOP;
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) wake = Wake::HANGUP;
+        }
+        return wake;
+#else
+        struct pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) return errno == EINTR ? Wake::READABLE : Wake::ERROR;
+        if (fds[1].revents) return Wake::STOP;
+        if (fds[0].revents & (POLLHUP | POLLERR)) return Wake::HANGUP;
+        return Wake::READABLE;
+#endif
+    };
+
+    for (;;) {
+        Wake wake = wait();
+        if (wake == Wake::STOP) return;
+        if (wake == Wake::ERROR) {
+            Fail(std::string("Wait failed: ") + std::strerror(errno));
+            return;
+        }
+
+        // Drain what the driver has, straight into the ring. Raw ttys
+        // return 0 rather than EAGAIN when empty; only a hang-up ends it
+        for (;;) {
+            size_t span;
+            char* out = ring_.WriteSpan(span);
+            if (span == 0) {
+                full_waits_.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                if (stopping_) return;
+                continue;
+            }
+            ssize_t count = ::read(fd_, out, span);
+            if (count > 0) {
+                // The stamp goes first: the consumer never sees bytes without it
+                produced_ += static_cast<uint64_t>(count);
+                if (stamps_.Capacity() - stamps_.Size() >= sizeof(Stamp)) {
+                    Stamp stamp = {produced_, SteadyNow()};
+                    stamps_.Write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+                }
+                ring_.Commit(static_cast<size_t>(count));
+                bytes_read_.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+                continue;
+            }
+            if (count < 0 && errno == EINTR) continue;
+            if (count == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (wake != Wake::HANGUP) break;
+                Fail("Device disconnected");
+                return;
+            }
+            Fail(std::string("Read failed: ") + std::strerror(errno));
+            return;
+        }
+    }
+#endif
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,100 @@
+#ifndef SERIAL_READER_H
+#define SERIAL_READER_H
+
+#include "utils/spsc_ring.h"
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Background reader feeding a serial port into a lock-free ring
+ *
+ * A dedicated thread waits on the port with epoll (poll elsewhere) and
+ * read(2)s straight into the free span of an SpscRing, so bytes are copied
+ * once, from the kernel into the ring. The consumer, typically the UI
+ * thread, drains the ring without taking any lock. When the consumer
+ * falls behind and the ring fills up, the reader waits for space and
+ * leaves further input in the driver, which throttles the line rather
+ * than dropping data.
+ *
+ * Every read is also stamped with the steady_clock time it returned, for
+ * consumers that need to know when bytes arrived (see PeekRead()).
+ *
+ * The descriptor stays owned by the caller and must be non-blocking and
+ * outlive Stop().
+ */
+class SerialReader {
+public:
+    struct Statistics {
+        uint64_t bytes_read;
+        uint64_t full_waits;        // times the reader had to wait for the consumer
+    };
+
+    explicit SerialReader(size_t ring_capacity);
+    ~SerialReader();
+
+    SerialReader(const SerialReader&) = delete;
+    SerialReader& operator=(const SerialReader&) = delete;
+
+    bool Start(int fd);
+    void Stop();
+    bool IsRunning() const { return thread_.joinable(); }
+
+    // Consumer side: one thread, no locks
+    size_t Read(char* out, size_t size) {
+        size_t read = ring_.Read(out, size);
+        consumed_ += read;
+        return read;
+    }
+    const char* Peek(size_t& size) { return ring_.ReadSpan(size); }
+    // Like Peek(), but ends with the bytes of one read(2); `timestamp` gets
+    // its steady_clock time in nanoseconds. Reads whose stamp was dropped
+    // for lack of room count as part of the next one
+    const char* PeekRead(size_t& size, long long& timestamp);
+    void Consume(size_t size) {
+        ring_.Consume(size);
+        consumed_ += size;
+    }
+    size_t Available() const { return ring_.Size(); }
+
+    // The device went away (hang-up, EOF or I/O error) and reading stopped;
+    // bytes already in the ring can still be drained
+    bool HasFailed() const { return failed_.load(std::memory_order_acquire); }
+    // Valid once HasFailed()
+    const std::string& GetError() const { return error_; }
+
+    Statistics GetStatistics() const;
+
+private:
+    struct Stamp {
+        uint64_t end;               // bytes read so far
+        long long timestamp;
+    };
+
+    utils::SpscRing ring_;
+    utils::SpscRing stamps_;        // a Stamp per read, ahead of its bytes
+    uint64_t produced_;
+    uint64_t consumed_;
+    Stamp stamp_;                   // consumer side: the earliest stamp not yet passed
+    bool has_stamp_;
+    std::thread thread_;
+    int fd_;
+    int wake_[2];                   // pipe that interrupts the wait on Stop()
+    int epoll_fd_;
+    std::atomic<bool> stopping_;
+    std::atomic<bool> failed_;
+    std::atomic<uint64_t> bytes_read_;
+    std::atomic<uint64_t> full_waits_;
+    std::string error_;
+
+    void Run();
+    void Fail(const std::string& message);
+    void CloseDescriptors();
+};
+
+} // namespace esp32_ide
+
+#endif // SERIAL_READER_H
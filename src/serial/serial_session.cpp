@@ -0,0 +1,195 @@
+#include "serial/serial_session.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp32_ide {
+
+namespace {
+
+const char kSessionMagic[4] = {'E', '3', 'S', 'R'};
+const uint32_t kSessionVersion = 1;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t start_time;             // system_clock ticks
+    int64_t start_steady;           // steady_clock nanoseconds, the base of the first delta
+};
+
+void AppendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool ReadVarint(const unsigned char*& cursor, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+        unsigned char byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+// ============================================================================
+// SerialSessionWriter
+// ============================================================================
+
+SerialSessionWriter::SerialSessionWriter() : last_timestamp_(0), bytes_(0) {
+}
+
+SerialSessionWriter::~SerialSessionWriter() {
+    Close();
+}
+
+long long SerialSessionWriter::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool SerialSessionWriter::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool SerialSessionWriter::Open(const std::string& path) {
+    Close();
+    path_ = path;
+    error_.clear();
+    bytes_ = 0;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        return Fail("Cannot create " + path);
+    }
+    FileHeader header;
+    std::memcpy(header.magic, kSessionMagic, sizeof(header.magic));
+    header.version = kSessionVersion;
+    header.start_time = std::chrono::system_clock::now().time_since_epoch().count();
+    header.start_steady = Now();
+    last_timestamp_ = header.start_steady;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out_.good() || Fail("Cannot write to " + path);
+}
+
+void SerialSessionWriter::Close() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+}
+
+bool SerialSessionWriter::Record(const char* data, size_t size, long long timestamp) {
+    if (!IsOpen()) {
+        return Fail("Session recording is not open");
+    }
+    // Stamps taken after the fact on the consumer side may lag a little
+    long long delta = std::max(0LL, timestamp - last_timestamp_);
+    last_timestamp_ += delta;
+    record_.clear();
+    AppendVarint(record_, static_cast<uint64_t>(delta));
+    AppendVarint(record_, size);
+    out_.write(record_.data(), static_cast<std::streamsize>(record_.size()));
+    out_.write(data, static_cast<std::streamsize>(size));
+    if (!out_) {
+        return Fail("Cannot write to " + path_);
+    }
+    bytes_ += size;
+    return true;
+}
+
+// ============================================================================
+// SerialSessionReplay
+// ============================================================================
+
+SerialSessionReplay::SerialSessionReplay()
+    : start_time_(0), position_(0), offset_(0), first_offset_(0), speed_(1.0) {
+}
+
+bool SerialSessionReplay::Fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool SerialSessionReplay::Open(const std::string& path) {
+    Close();
+    error_.clear();
+    FileHeader header;
+    if (!file_.Open(path) || file_.Size() < sizeof(header)) {
+        file_.Close();
+        return Fail("Cannot read session " + path);
+    }
+    std::memcpy(&header, file_.Data(), sizeof(header));
+    if (std::memcmp(header.magic, kSessionMagic, sizeof(header.magic)) != 0 || header.version != kSessionVersion) {
+        file_.Close();
+        return Fail("Not a serial session: " + path);
+    }
+    start_time_ = header.start_time;
+    Start(1.0);
+    return true;
+}
+
+void SerialSessionReplay::Close() {
+    file_.Close();
+    position_ = 0;
+    offset_ = 0;
+}
+
+void SerialSessionReplay::Start(double speed) {
+    speed_ = std::max(0.0, speed);
+    position_ = sizeof(FileHeader);
+    offset_ = 0;
+    // The clock starts with the first read, not with the idle time before it
+    Chunk first;
+    size_t next;
+    first_offset_ = Peek(first, next) ? first.offset : 0;
+    started_ = std::chrono::steady_clock::now();
+}
+
+bool SerialSessionReplay::Peek(Chunk& chunk, size_t& next) const {
+    if (!file_.IsOpen()) {
+        return false;
+    }
+    const unsigned char* cursor = file_.Data() + position_;
+    const unsigned char* end = file_.Data() + file_.Size();
+    uint64_t delta;
+    uint64_t size;
+    if (!ReadVarint(cursor, end, delta) || !ReadVarint(cursor, end, size) ||
+        size > static_cast<uint64_t>(end - cursor)) {
+        return false;
+    }
+    chunk.data = reinterpret_cast<const char*>(cursor);
+    chunk.size = static_cast<size_t>(size);
+    chunk.offset = offset_ + static_cast<long long>(delta);
+    chunk.timestamp = start_time_ + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                        std::chrono::nanoseconds(chunk.offset)).count();
+    next = static_cast<size_t>(cursor - file_.Data()) + chunk.size;
+    return true;
+}
+
+bool SerialSessionReplay::Next(Chunk& chunk) {
+    size_t next;
+    if (!Peek(chunk, next)) {
+        return false;
+    }
+    if (speed_ > 0) {
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - started_).count();
+        if (static_cast<double>(chunk.offset - first_offset_) > elapsed * speed_) {
+            return false;
+        }
+    }
+    position_ = next;
+    offset_ = chunk.offset;
+    return true;
+}
+
+bool SerialSessionReplay::AtEnd() const {
+    Chunk chunk;
+    size_t next;
+    return !Peek(chunk, next);
+}
+
+} // namespace esp32_ide
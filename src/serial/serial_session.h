@@ -0,0 +1,108 @@
+#ifndef SERIAL_SESSION_H
+#define SERIAL_SESSION_H
+
+#include "utils/mapped_file.h"
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Records the raw bytes of a serial session, read by read
+ *
+ * The file is a header (magic, version, wall-clock and steady_clock time
+ * of the start) followed by one record per read(2): a varint of the
+ * nanoseconds since the previous read, a varint length and the bytes.
+ * Keeping reads whole lets a replay hand the pipeline exactly the chunks
+ * it saw live, partial lines included. Records are self-delimiting, so a
+ * file cut short by a crash replays up to its last whole read.
+ */
+class SerialSessionWriter {
+public:
+    SerialSessionWriter();
+    ~SerialSessionWriter();
+
+    SerialSessionWriter(const SerialSessionWriter&) = delete;
+    SerialSessionWriter& operator=(const SerialSessionWriter&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return out_.is_open(); }
+
+    // `timestamp` is a steady_clock time in nanoseconds, as SerialReader stamps reads
+    bool Record(const char* data, size_t size, long long timestamp);
+
+    uint64_t GetBytesRecorded() const { return bytes_; }
+    const std::string& GetPath() const { return path_; }
+    const std::string& GetError() const { return error_; }
+
+    static long long Now();
+
+private:
+    std::string path_;
+    std::ofstream out_;
+    long long last_timestamp_;
+    uint64_t bytes_;
+    std::string record_;            // reused record buffer
+    std::string error_;
+
+    bool Fail(const std::string& message);
+};
+
+/**
+ * @brief Plays a recorded session back, read by read
+ *
+ * The file is memory-mapped and chunks are handed out in place. At speed
+ * 1 each chunk becomes due when as much time has passed since Start() as
+ * had passed in the recording since its first read, at speed N N times
+ * sooner; speed 0 hands out everything at once. Chunks keep their
+ * recorded wall-clock time, so replaying the same file always yields the
+ * same messages.
+ */
+class SerialSessionReplay {
+public:
+    struct Chunk {
+        const char* data;
+        size_t size;
+        long long offset;           // nanoseconds into the recording
+        long long timestamp;        // when it was read, in system_clock ticks
+    };
+
+    SerialSessionReplay();
+
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const { return file_.IsOpen(); }
+    const std::string& GetPath() const { return file_.GetPath(); }
+
+    // Rewinds and starts the clock; 1 replays in real time, 0 as fast as possible
+    void Start(double speed);
+    double GetSpeed() const { return speed_; }
+
+    // The next chunk, if it is due; valid while the replay is open
+    bool Next(Chunk& chunk);
+    // Every chunk was handed out
+    bool AtEnd() const;
+
+    const std::string& GetError() const { return error_; }
+
+private:
+    utils::MappedFile file_;
+    long long start_time_;          // system_clock ticks at the start of the recording
+    size_t position_;
+    long long offset_;
+    long long first_offset_;
+    double speed_;
+    std::chrono::steady_clock::time_point started_;
+    std::string error_;
+
+    bool Fail(const std::string& message);
+    // Decodes the record at position_ without consuming it
+    bool Peek(Chunk& chunk, size_t& next) const;
+};
+
+} // namespace esp32_ide
+
+#endif // SERIAL_SESSION_H
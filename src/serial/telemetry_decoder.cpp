@@ -0,0 +1,233 @@
+#include "serial/telemetry_decoder.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+namespace esp32_ide {
+
+namespace {
+
+struct TypeName {
+    const char* name;
+    FrameLayout::FieldType type;
+};
+
+const TypeName kTypeNames[] = {
+    {"i8", FrameLayout::FieldType::INT8},       {"u8", FrameLayout::FieldType::UINT8},
+    {"i16", FrameLayout::FieldType::INT16},     {"u16", FrameLayout::FieldType::UINT16},
+    {"i32", FrameLayout::FieldType::INT32},     {"u32", FrameLayout::FieldType::UINT32},
+    {"i64", FrameLayout::FieldType::INT64},     {"u64", FrameLayout::FieldType::UINT64},
+    {"f32", FrameLayout::FieldType::FLOAT32},   {"f64", FrameLayout::FieldType::FLOAT64},
+};
+
+bool IsHostBigEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 0;
+}
+
+template <typename T>
+T LoadSwapped(const uint8_t* in) {
+    uint8_t bytes[sizeof(T)];
+    std::reverse_copy(in, in + sizeof(T), bytes);
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// One field of `count` records, `stride` bytes apart
+template <typename T>
+void DecodeColumn(const uint8_t* in, size_t stride, size_t count, bool swap, double scale, double* out) {
+    if (swap) {
+        for (size_t i = 0; i < count; ++i, in += stride) {
+            out[i] = static_cast<double>(LoadSwapped<T>(in)) * scale;
+        }
+        return;
+    }
+    for (size_t i = 0; i < count; ++i, in += stride) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        out[i] = static_cast<double>(value) * scale;
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// FrameLayout
+// ============================================================================
+
+FrameLayout::FrameLayout() : record_size_(0), big_endian_(false) {
+}
+
+size_t FrameLayout::GetTypeSize(FieldType type) {
+    switch (type) {
+        case FieldType::INT8:
+        case FieldType::UINT8:
+            return 1;
+        case FieldType::INT16:
+        case FieldType::UINT16:
+            return 2;
+        case FieldType::INT32:
+        case FieldType::UINT32:
+        case FieldType::FLOAT32:
+            return 4;
+        case FieldType::INT64:
+        case FieldType::UINT64:
+        case FieldType::FLOAT64:
+            return 8;
+    }
+    return 0;
+}
+
+void FrameLayout::AddField(const std::string& name, FieldType type, double scale) {
+    Field field;
+    field.name = name;
+    field.type = type;
+    field.offset = record_size_;
+    field.scale = scale;
+    fields_.push_back(field);
+    record_size_ += GetTypeSize(type);
+}
+
+bool FrameLayout::Parse(const std::string& description) {
+    fields_.clear();
+    record_size_ = 0;
+    big_endian_ = false;
+    error_.clear();
+
+    std::string text = description;
+    std::replace(text.begin(), text.end(), ',', ' ');
+    size_t start = text.find_first_not_of(' ');
+    if (start != std::string::npos && text[start] == '>') {
+        big_endian_ = true;
+        text[start] = ' ';
+    }
+
+    std::istringstream stream(text);
+    std::string token;
+    while (stream >> token) {
+        size_t colon = token.find(':');
+        if (colon == std::string::npos || colon == 0) {
+            error_ = "Expected name:type, got '" + token + "'";
+            return false;
+        }
+        std::string type_name = token.substr(colon + 1);
+        double scale = 1.0;
+        size_t star = type_name.find('*');
+        if (star != std::string::npos) {
+            char* end = nullptr;
+            scale = std::strtod(type_name.c_str() + star + 1, &end);
+            if (end == type_name.c_str() + star + 1 || *end != '\0') {
+                error_ = "Bad scale in '" + token + "'";
+                return false;
+            }
+            type_name.erase(star);
+        }
+        const TypeName* match = nullptr;
+        for (const TypeName& candidate : kTypeNames) {
+            if (type_name == candidate.name) match = &candidate;
+        }
+        if (!match) {
+            error_ = "Unknown type '" + type_name + "'";
+            return false;
+        }
+        AddField(token.substr(0, colon), match->type, scale);
+    }
+    if (fields_.empty()) {
+        error_ = "Layout has no fields";
+        return false;
+    }
+    return true;
+}
+
+int FrameLayout::FindField(const std::string& name) const {
+    for (size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// ============================================================================
+// TelemetryDecoder
+// ============================================================================
+
+TelemetryDecoder::TelemetryDecoder(std::unique_ptr<FrameDecoder> framing, const FrameLayout& layout)
+    : framing_(std::move(framing)), layout_(layout), swap_bytes_(layout.IsBigEndian() != IsHostBigEndian()),
+      columns_(layout.GetFields().size()), rows_(0), bytes_(0), records_(0), wrong_size_(0) {
+    on_frame_ = [this](const uint8_t* frame, size_t size) { DecodeFrame(frame, size); };
+}
+
+size_t TelemetryDecoder::Feed(const char* data, size_t size) {
+    bytes_ += size;
+    uint64_t before = records_;
+    framing_->Feed(reinterpret_cast<const uint8_t*>(data), size, on_frame_);
+    return static_cast<size_t>(records_ - before);
+}
+
+void TelemetryDecoder::DecodeFrame(const uint8_t* frame, size_t size) {
+    size_t stride = layout_.GetRecordSize();
+    if (stride == 0 || size % stride != 0) {
+        wrong_size_++;
+        return;
+    }
+    size_t count = size / stride;
+    const std::vector<FrameLayout::Field>& fields = layout_.GetFields();
+    for (size_t f = 0; f < fields.size(); ++f) {
+        std::vector<double>& column = columns_[f];
+        if (column.size() < rows_ + count) {
+            column.resize(std::max(column.size() * 2, rows_ + count));
+        }
+        const FrameLayout::Field& field = fields[f];
+        const uint8_t* in = frame + field.offset;
+        double* out = column.data() + rows_;
+        switch (field.type) {
+            case FrameLayout::FieldType::INT8:
+                DecodeColumn<int8_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::UINT8:
+                DecodeColumn<uint8_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::INT16:
+                DecodeColumn<int16_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::UINT16:
+                DecodeColumn<uint16_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::INT32:
+                DecodeColumn<int32_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::UINT32:
+                DecodeColumn<uint32_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::INT64:
+                DecodeColumn<int64_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::UINT64:
+                DecodeColumn<uint64_t>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::FLOAT32:
+                DecodeColumn<float>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+            case FrameLayout::FieldType::FLOAT64:
+                DecodeColumn<double>(in, stride, count, swap_bytes_, field.scale, out);
+                break;
+        }
+    }
+    rows_ += count;
+    records_ += count;
+}
+
+TelemetryDecoder::Statistics TelemetryDecoder::GetStatistics() const {
+    FrameDecoder::Statistics framing = framing_->GetStatistics();
+    Statistics statistics;
+    statistics.bytes = bytes_;
+    statistics.frames = framing.frames;
+    statistics.records = records_;
+    statistics.bad_frames = framing.dropped + wrong_size_;
+    return statistics;
+}
+
+} // namespace esp32_ide
@@ -0,0 +1,129 @@
+#ifndef TELEMETRY_DECODER_H
+#define TELEMETRY_DECODER_H
+
+#include "serial/frame_decoder.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+namespace esp32_ide {
+
+/**
+ * @brief Layout of the packed records inside telemetry frames
+ *
+ * Fields follow each other without padding, like a
+ * __attribute__((packed)) struct on the device. Each decodes to a double,
+ * multiplied by its scale (e.g. 0.001 for a millivolt reading in volts).
+ */
+class FrameLayout {
+public:
+    enum class FieldType {
+        INT8,
+        UINT8,
+        INT16,
+        UINT16,
+        INT32,
+        UINT32,
+        INT64,
+        UINT64,
+        FLOAT32,
+        FLOAT64
+    };
+
+    struct Field {
+        std::string name;
+        FieldType type;
+        size_t offset;
+        double scale;
+    };
+
+    FrameLayout();
+
+    void AddField(const std::string& name, FieldType type, double scale = 1.0);
+    /**
+     * @brief Builds the layout from a compact description
+     *
+     * Space- or comma-separated "name:type" fields with an optional
+     * "*scale", types i8 u8 i16 u16 i32 u32 i64 u64 f32 f64, e.g.
+     * "t:u32 ax:i16*0.01 ay:i16*0.01 temp:f32". A leading ">" makes the
+     * fields big-endian. Replaces any fields added before.
+     */
+    bool Parse(const std::string& description);
+    // ESP32 and most MCUs are little-endian, the default
+    void SetBigEndian(bool big_endian) { big_endian_ = big_endian; }
+    bool IsBigEndian() const { return big_endian_; }
+
+    const std::vector<Field>& GetFields() const { return fields_; }
+    // -1 when there is no such field
+    int FindField(const std::string& name) const;
+    size_t GetRecordSize() const { return record_size_; }
+    const std::string& GetError() const { return error_; }
+
+    static size_t GetTypeSize(FieldType type);
+
+private:
+    std::vector<Field> fields_;
+    size_t record_size_;
+    bool big_endian_;
+    std::string error_;
+};
+
+/**
+ * @brief Decodes framed binary telemetry into numeric columns
+ *
+ * Feed() runs the stream through the framing and unpacks every record
+ * into one column per layout field. A frame carries one record or several
+ * back to back, which lets firmware batch samples per frame; frames whose
+ * size is not a multiple of the record size are counted and skipped.
+ *
+ * Columns are plain arrays, ready for SignalAnalyzer::AddSamples() or a
+ * plotter: the consumer takes the rows decoded so far and calls
+ * ClearColumns(), which keeps the storage, so steady-state decoding does
+ * not allocate. Decoding is column by column with the field type resolved
+ * once per frame, not per sample.
+ */
+class TelemetryDecoder {
+public:
+    struct Statistics {
+        uint64_t bytes;
+        uint64_t frames;
+        uint64_t records;
+        uint64_t bad_frames;        // dropped by the framing or of the wrong size
+    };
+
+    TelemetryDecoder(std::unique_ptr<FrameDecoder> framing, const FrameLayout& layout);
+
+    TelemetryDecoder(const TelemetryDecoder&) = delete;
+    TelemetryDecoder& operator=(const TelemetryDecoder&) = delete;
+
+    // Returns the number of records decoded
+    size_t Feed(const char* data, size_t size);
+
+    const FrameLayout& GetLayout() const { return layout_; }
+    size_t GetColumnCount() const { return columns_.size(); }
+    size_t GetRowCount() const { return rows_; }
+    // GetRowCount() values, in arrival order
+    const double* GetColumn(size_t field) const { return columns_[field].data(); }
+    // Empties the columns, keeping their storage
+    void ClearColumns() { rows_ = 0; }
+
+    Statistics GetStatistics() const;
+
+private:
+    std::unique_ptr<FrameDecoder> framing_;
+    FrameLayout layout_;
+    bool swap_bytes_;
+    std::vector<std::vector<double>> columns_;
+    size_t rows_;
+    uint64_t bytes_;
+    uint64_t records_;
+    uint64_t wrong_size_;
+    FrameDecoder::FrameCallback on_frame_;  // bound once rather than per Feed()
+
+    void DecodeFrame(const uint8_t* frame, size_t size);
+};
+
+} // namespace esp32_ide
+
+#endif // TELEMETRY_DECODER_H
@@ -0,0 +1,67 @@
+/**
+ * @file daemon_client_main.cpp
+ * @brief Thin client for the terminal-mode daemon
+ * 
+ * Forwards its command line to a daemon started with
+ * `esp32-driver-ide-terminal --daemon`. When no daemon is running the
+ * command is handed to the full terminal binary instead, so scripts can
+ * use the client unconditionally.
+ */
+
+#include "terminal/terminal_daemon.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+int main(int argc, char* argv[]) {
+    using namespace esp32_ide::daemon;
+    
+    std::string socket_path = GetDefaultSocketPath();
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (args.empty() && arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    int exit_code = 0;
+    if (!args.empty()) {
+        ForwardResult forwarded = ForwardCommand(args, exit_code, socket_path);
+        if (forwarded == ForwardResult::COMPLETED) {
+            return exit_code;
+        }
+        // The daemon may have flashed or built already; never run it twice
+        if (forwarded == ForwardResult::CONNECTION_LOST) {
+            return 1;
+        }
+    }
+    
+#ifndef _WIN32
+    // No daemon: run the command with the full binary next to this one
+    std::string program = argv[0];
+    size_t slash = program.find_last_of('/');
+    std::string terminal = slash == std::string::npos
+        ? "esp32-driver-ide-terminal"
+        : program.substr(0, slash + 1) + "esp32-driver-ide-terminal";
+    
+    std::vector<char*> exec_args;
+    exec_args.push_back(const_cast<char*>(terminal.c_str()));
+    for (auto& arg : args) {
+        exec_args.push_back(&arg[0]);
+    }
+    exec_args.push_back(nullptr);
+    execvp(exec_args[0], exec_args.data());
+#endif
+    
+    std::fprintf(stderr, "esp32-driver-ide-client: no daemon on %s and cannot start %s\n",
+                 socket_path.c_str(), "esp32-driver-ide-terminal");
+    return 127;
+}
@@ -0,0 +1,603 @@
+#include "terminal/terminal_daemon.h"
+
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace esp32_ide {
+namespace daemon {
+
+namespace {
+
+const char* const kProtocolVersion = "1";
+const uint32_t kMaxFramePayload = 64 * 1024 * 1024;
+
+#ifndef _WIN32
+
+bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool ReadAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = ::recv(fd, data, size, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+std::string FrameHeader(FrameType type, size_t size) {
+    std::string header(5, '\0');
+    header[0] = static_cast<char>(type);
+    for (int i = 0; i < 4; ++i) {
+        header[1 + i] = static_cast<char>((static_cast<uint32_t>(size) >> (8 * i)) & 0xFF);
+    }
+    return header;
+}
+
+uint32_t FramePayloadSize(const char* header) {
+    uint32_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+        size |= static_cast<uint32_t>(static_cast<unsigned char>(header[1 + i])) << (8 * i);
+    }
+    return size;
+}
+
+bool FillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Waits up to timeout_ms for the socket to become ready
+bool WaitReady(int fd, short events, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    for (;;) {
+        int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        pollfd pfd = {fd, events, 0};
+        int ready = ::poll(&pfd, 1, std::max(remaining, 0));
+        if (ready < 0 && errno == EINTR) continue;
+        return ready > 0;
+    }
+}
+
+#endif
+
+} // namespace
+
+#ifndef _WIN32
+
+/**
+ * @brief A client being served
+ *
+ * Every wait on the client is bounded by the client timeout, counted from
+ * the last byte it sent or took. Once a write fails or times out the
+ * stream may end mid-frame, so nothing more is written to it; the client
+ * then sees the connection close without an EXIT frame.
+ */
+struct ClientConnection {
+    int fd;
+    int timeout_ms;
+    bool alive;
+};
+
+namespace {
+
+bool SendAll(ClientConnection& connection, const char* data, size_t size) {
+    while (size > 0 && connection.alive) {
+        ssize_t written = ::send(connection.fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written > 0) {
+            data += written;
+            size -= static_cast<size_t>(written);
+        } else if (written < 0 && errno == EINTR) {
+            continue;
+        } else if (!(written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+                     WaitReady(connection.fd, POLLOUT, connection.timeout_ms))) {
+            connection.alive = false;
+        }
+    }
+    return connection.alive;
+}
+
+bool ReceiveAll(ClientConnection& connection, char* data, size_t size) {
+    while (size > 0 && connection.alive) {
+        ssize_t got = ::recv(connection.fd, data, size, MSG_DONTWAIT);
+        if (got > 0) {
+            data += got;
+            size -= static_cast<size_t>(got);
+        } else if (got < 0 && errno == EINTR) {
+            continue;
+        } else if (!(got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+                     WaitReady(connection.fd, POLLIN, connection.timeout_ms))) {
+            connection.alive = false;
+        }
+    }
+    return connection.alive;
+}
+
+bool SendFrame(ClientConnection& connection, FrameType type, const std::string& payload) {
+    if (payload.size() > kMaxFramePayload) return false;
+    std::string frame = FrameHeader(type, payload.size());
+    frame += payload;
+    return SendAll(connection, frame.data(), frame.size());
+}
+
+bool ReceiveFrame(ClientConnection& connection, FrameType& type, std::string& payload) {
+    char header[5];
+    if (!ReceiveAll(connection, header, sizeof(header))) return false;
+    uint32_t size = FramePayloadSize(header);
+    if (size > kMaxFramePayload) return false;
+    type = static_cast<FrameType>(header[0]);
+    payload.resize(size);
+    return size == 0 || ReceiveAll(connection, &payload[0], size);
+}
+
+/**
+ * @brief Stream buffer that forwards everything written to it as OUTPUT frames
+ */
+class SocketStreamBuf : public std::streambuf {
+public:
+    explicit SocketStreamBuf(ClientConnection& connection) : connection_(connection) {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+    ~SocketStreamBuf() override { Flush(); }
+
+protected:
+    int_type overflow(int_type ch) override {
+        Flush();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override {
+        Flush();
+        return 0;
+    }
+
+private:
+    ClientConnection& connection_;
+    char buffer_[4096];
+
+    void Flush() {
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        if (size > 0 && connection_.alive) {
+            // A client that went away just loses the rest of the output;
+            // the command still runs to completion
+            SendFrame(connection_, FrameType::OUTPUT, std::string(pbase(), size));
+        }
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+};
+
+} // namespace
+
+#endif
+
+// ============================================================================
+// Wire protocol
+// ============================================================================
+
+std::string GetDefaultSocketPath() {
+    if (const char* path = std::getenv("ESP32_IDE_DAEMON_SOCKET")) {
+        if (*path) return path;
+    }
+#ifdef _WIN32
+    return "";
+#else
+    if (const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR")) {
+        if (*runtime_dir) return std::string(runtime_dir) + "/esp32-ide.sock";
+    }
+    return "/tmp/esp32-ide-" + std::to_string(::getuid()) + ".sock";
+#endif
+}
+
+bool WriteFrame(int fd, FrameType type, const std::string& payload) {
+#ifdef _WIN32
+    (void)fd; (void)type; (void)payload;
+    return false;
+#else
+    if (payload.size() > kMaxFramePayload) return false;
+    std::string header = FrameHeader(type, payload.size());
+    // Small frames go out in a single send to keep round trips short
+    if (payload.size() <= 4096) {
+        header += payload;
+        return WriteAll(fd, header.data(), header.size());
+    }
+    return WriteAll(fd, header.data(), header.size()) && WriteAll(fd, payload.data(), payload.size());
+#endif
+}
+
+bool ReadFrame(int fd, FrameType& type, std::string& payload) {
+#ifdef _WIN32
+    (void)fd; (void)type; (void)payload;
+    return false;
+#else
+    char header[5];
+    if (!ReadAll(fd, header, sizeof(header))) return false;
+
+    uint32_t size = FramePayloadSize(header);
+    if (size > kMaxFramePayload) return false;
+
+    type = static_cast<FrameType>(header[0]);
+    payload.resize(size);
+    return size == 0 || ReadAll(fd, &payload[0], size);
+#endif
+}
+
+std::string EncodeRequest(const Request& request) {
+    // NUL-separated fields: version, cwd, color flag, then the arguments
+    std::string payload = kProtocolVersion;
+    payload += '\0';
+    payload += request.cwd;
+    payload += '\0';
+    payload += request.color ? "1" : "0";
+    for (const auto& arg : request.args) {
+        payload += '\0';
+        payload += arg;
+    }
+    return payload;
+}
+
+bool DecodeRequest(const std::string& payload, Request& request) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t end = payload.find('\0', start);
+        fields.push_back(payload.substr(start, end == std::string::npos ? std::string::npos : end - start));
+        if (end == std::string::npos) break;
+        start = end + 1;
+    }
+
+    if (fields.size() < 3 || fields[0] != kProtocolVersion) return false;
+    request.cwd = fields[1];
+    request.color = fields[2] == "1";
+    request.args.assign(fields.begin() + 3, fields.end());
+    return true;
+}
+
+// ============================================================================
+// Client
+// ============================================================================
+
+DaemonClient::DaemonClient(const std::string& socket_path)
+    : socket_path_(socket_path), delivered_(false) {
+}
+
+int DaemonClient::Connect() {
+#ifdef _WIN32
+    error_ = "Daemon mode is not supported on this platform";
+    return -1;
+#else
+    sockaddr_un addr;
+    if (!FillAddress(socket_path_, addr)) {
+        error_ = "Invalid daemon socket path: " + socket_path_;
+        return -1;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error_ = "No daemon listening on " + socket_path_;
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+#endif
+}
+
+bool DaemonClient::SendAndWait(FrameType type, const std::string& payload, int& exit_code,
+                               OutputCallback output) {
+#ifdef _WIN32
+    (void)type; (void)payload; (void)exit_code; (void)output;
+    error_ = "Daemon mode is not supported on this platform";
+    return false;
+#else
+    delivered_ = false;
+    int fd = Connect();
+    if (fd < 0) return false;
+
+    // A request that did not go out whole is dropped by the daemon unread
+    bool ok = WriteFrame(fd, type, payload);
+    if (!ok) {
+        error_ = "Cannot send the request to the daemon on " + socket_path_;
+        ::close(fd);
+        return false;
+    }
+    delivered_ = true;
+    std::string frame;
+    FrameType frame_type;
+    while (ok && (ok = ReadFrame(fd, frame_type, frame))) {
+        if (frame_type == FrameType::OUTPUT) {
+            if (output) output(frame.data(), frame.size());
+        } else if (frame_type == FrameType::EXIT && frame.size() == 4) {
+            exit_code = static_cast<int>(static_cast<uint32_t>(static_cast<unsigned char>(frame[0])) |
+                                         static_cast<uint32_t>(static_cast<unsigned char>(frame[1])) << 8 |
+                                         static_cast<uint32_t>(static_cast<unsigned char>(frame[2])) << 16 |
+                                         static_cast<uint32_t>(static_cast<unsigned char>(frame[3])) << 24);
+            break;
+        } else {
+            ok = false;
+        }
+    }
+
+    ::close(fd);
+    if (!ok) {
+        error_ = "Daemon closed the connection unexpectedly";
+    }
+    return ok;
+#endif
+}
+
+bool DaemonClient::Execute(const Request& request, int& exit_code, OutputCallback output) {
+    return SendAndWait(FrameType::REQUEST, EncodeRequest(request), exit_code, output);
+}
+
+bool DaemonClient::Ping() {
+    int exit_code = -1;
+    return SendAndWait(FrameType::PING, "", exit_code, nullptr) && exit_code == 0;
+}
+
+bool DaemonClient::IsListening() {
+    int fd = Connect();
+    if (fd < 0) return false;
+#ifndef _WIN32
+    ::close(fd);
+#endif
+    return true;
+}
+
+bool DaemonClient::Shutdown() {
+    int exit_code = -1;
+    return SendAndWait(FrameType::SHUTDOWN, "", exit_code, nullptr) && exit_code == 0;
+}
+
+ForwardResult ForwardCommand(const std::vector<std::string>& args, int& exit_code,
+                             const std::string& socket_path) {
+#ifdef _WIN32
+    (void)args; (void)exit_code; (void)socket_path;
+    return ForwardResult::NO_DAEMON;
+#else
+    Request request;
+    char cwd[4096];
+    request.cwd = ::getcwd(cwd, sizeof(cwd)) ? cwd : "";
+    const char* term = std::getenv("TERM");
+    request.color = ((term && std::string(term) != "dumb") || std::getenv("COLORTERM")) &&
+                    ::isatty(STDOUT_FILENO);
+    request.args = args;
+
+    DaemonClient client(socket_path);
+    int code = 0;
+    bool ok = client.Execute(request, code, [](const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(STDOUT_FILENO, data, size);
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return;
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    });
+    if (ok) {
+        exit_code = code;
+        return ForwardResult::COMPLETED;
+    }
+    if (!client.WasDelivered()) {
+        return ForwardResult::NO_DAEMON;
+    }
+    std::fprintf(stderr, "%s before the command finished; it may have run in part\n", client.GetError().c_str());
+    return ForwardResult::CONNECTION_LOST;
+#endif
+}
+
+// ============================================================================
+// Server
+// ============================================================================
+
+DaemonServer::DaemonServer(const std::string& socket_path, Handler handler)
+    : socket_path_(socket_path),
+      handler_(handler),
+      listen_fd_(-1),
+      client_timeout_ms_(5000),
+      stop_requested_(false),
+      requests_served_(0) {
+}
+
+DaemonServer::~DaemonServer() {
+#ifndef _WIN32
+    if (listen_fd_ >= 0) {
+        ::close(listen_fd_);
+        ::unlink(socket_path_.c_str());
+    }
+#endif
+}
+
+bool DaemonServer::Start() {
+#ifdef _WIN32
+    error_ = "Daemon mode is not supported on this platform";
+    return false;
+#else
+    sockaddr_un addr;
+    if (!FillAddress(socket_path_, addr)) {
+        error_ = "Invalid daemon socket path: " + socket_path_;
+        return false;
+    }
+
+    // Refuse to steal the socket from a live daemon, but clean up a stale one
+    DaemonClient probe(socket_path_);
+    if (probe.IsListening()) {
+        error_ = "A daemon is already listening on " + socket_path_;
+        return false;
+    }
+    ::unlink(socket_path_.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    // Only the owning user may talk to the daemon
+    mode_t old_mask = ::umask(0077);
+    int bound = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+
+    if (bound != 0 || ::listen(fd, 64) != 0) {
+        error_ = "Cannot listen on " + socket_path_ + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd_ = fd;
+    return true;
+#endif
+}
+
+int DaemonServer::Run() {
+#ifdef _WIN32
+    return 1;
+#else
+    if (listen_fd_ < 0 && !Start()) {
+        return 1;
+    }
+
+    while (!stop_requested_) {
+        pollfd pfd = {listen_fd_, POLLIN, 0};
+        int ready = ::poll(&pfd, 1, 200);
+        if (ready < 0 && errno != EINTR) {
+            error_ = std::string("poll: ") + std::strerror(errno);
+            return 1;
+        }
+        if (ready <= 0) continue;
+
+        int client = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) continue;
+        ClientConnection connection = {client, client_timeout_ms_, true};
+        HandleConnection(connection);
+        ::close(client);
+    }
+
+    ::close(listen_fd_);
+    ::unlink(socket_path_.c_str());
+    listen_fd_ = -1;
+    return 0;
+#endif
+}
+
+void DaemonServer::HandleConnection(ClientConnection& connection) {
+#ifdef _WIN32
+    (void)connection;
+#else
+    FrameType type;
+    std::string payload;
+    if (!ReceiveFrame(connection, type, payload)) return;
+
+    int exit_code = 0;
+    switch (type) {
+        case FrameType::PING:
+            break;
+        case FrameType::SHUTDOWN:
+            stop_requested_ = true;
+            break;
+        case FrameType::REQUEST: {
+            Request request;
+            if (!DecodeRequest(payload, request)) {
+                SendFrame(connection, FrameType::OUTPUT, "Daemon protocol version mismatch; restart the daemon\n");
+                exit_code = 2;
+                break;
+            }
+            exit_code = ExecuteRequest(connection, request);
+            requests_served_++;
+            break;
+        }
+        default:
+            return;
+    }
+
+    std::string code(4, '\0');
+    for (int i = 0; i < 4; ++i) {
+        code[i] = static_cast<char>((static_cast<uint32_t>(exit_code) >> (8 * i)) & 0xFF);
+    }
+    // After a failed write the client could not tell this frame from output
+    if (connection.alive) {
+        SendFrame(connection, FrameType::EXIT, code);
+    }
+#endif
+}
+
+int DaemonServer::ExecuteRequest(ClientConnection& connection, const Request& request) {
+#ifdef _WIN32
+    (void)connection; (void)request;
+    return 1;
+#else
+    // Run in the client's working directory so relative paths resolve as if
+    // the command had been started locally
+    char previous_cwd[4096];
+    bool have_previous = ::getcwd(previous_cwd, sizeof(previous_cwd)) != nullptr;
+    if (!request.cwd.empty() && ::chdir(request.cwd.c_str()) != 0) {
+        SendFrame(connection, FrameType::OUTPUT, "Cannot enter directory " + request.cwd + "\n");
+        return 1;
+    }
+
+    SocketStreamBuf output(connection);
+    std::istringstream no_input;
+    std::streambuf* old_out = std::cout.rdbuf(&output);
+    std::streambuf* old_err = std::cerr.rdbuf(&output);
+    std::streambuf* old_in = std::cin.rdbuf(no_input.rdbuf());
+
+    int exit_code = 1;
+    try {
+        exit_code = handler_ ? handler_(request) : 1;
+    } catch (const std::exception& e) {
+        std::cout << "Command failed: " << e.what() << std::endl;
+    }
+
+    std::cout.flush();
+    std::cout.rdbuf(old_out);
+    std::cerr.rdbuf(old_err);
+    std::cin.rdbuf(old_in);
+    std::cin.clear();
+
+    if (have_previous && ::chdir(previous_cwd) != 0) {
+        error_ = "Cannot restore daemon working directory";
+    }
+    return exit_code;
+#endif
+}
+
+} // namespace daemon
+} // namespace esp32_ide
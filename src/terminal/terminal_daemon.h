@@ -0,0 +1,163 @@
+#ifndef ESP32_IDE_TERMINAL_DAEMON_H
+#define ESP32_IDE_TERMINAL_DAEMON_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+namespace esp32_ide {
+namespace daemon {
+
+// ============================================================================
+// Wire protocol
+// ============================================================================
+
+/**
+ * @brief Frame types exchanged over the daemon socket
+ *
+ * Every frame is a type byte, a 4-byte little-endian payload length and the
+ * payload. A client sends one REQUEST (or PING/SHUTDOWN) per connection;
+ * the daemon answers with any number of OUTPUT frames and a final EXIT
+ * frame carrying the command's exit code.
+ */
+enum class FrameType : char {
+    REQUEST = 'R',
+    OUTPUT = 'O',
+    EXIT = 'X',
+    PING = 'P',
+    SHUTDOWN = 'S'
+};
+
+/**
+ * @brief One forwarded command invocation
+ */
+struct Request {
+    std::string cwd;                  // client working directory
+    bool color;                       // client stdout is a color terminal
+    std::vector<std::string> args;    // command line, without the program name
+};
+
+std::string GetDefaultSocketPath();
+bool WriteFrame(int fd, FrameType type, const std::string& payload);
+bool ReadFrame(int fd, FrameType& type, std::string& payload);
+std::string EncodeRequest(const Request& request);
+bool DecodeRequest(const std::string& payload, Request& request);
+
+// ============================================================================
+// Client
+// ============================================================================
+
+/**
+ * @brief Thin client forwarding commands to a running daemon
+ *
+ * Kept free of any IDE subsystem so the client binary starts in well under
+ * a millisecond.
+ */
+class DaemonClient {
+public:
+    using OutputCallback = std::function<void(const char* data, size_t size)>;
+
+    explicit DaemonClient(const std::string& socket_path = GetDefaultSocketPath());
+
+    // Returns false unless the daemon answered in full; exit_code is set on success
+    bool Execute(const Request& request, int& exit_code, OutputCallback output);
+    bool Ping();
+    bool Shutdown();
+    // Connect-only probe; does not wait for a busy daemon to answer
+    bool IsListening();
+
+    // Whether the last request reached a daemon; if so a failed Execute()
+    // may have run the command, and running it again is not safe
+    bool WasDelivered() const { return delivered_; }
+
+    const std::string& GetSocketPath() const { return socket_path_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    std::string socket_path_;
+    std::string error_;
+    bool delivered_;
+
+    int Connect();
+    bool SendAndWait(FrameType type, const std::string& payload, int& exit_code, OutputCallback output);
+};
+
+enum class ForwardResult {
+    NO_DAEMON,                        // nothing was sent; run the command locally
+    COMPLETED,                        // exit_code is the command's
+    CONNECTION_LOST                   // the daemon took the command but its answer broke off
+};
+
+/**
+ * @brief Forwards a command line to the daemon, streaming its output to stdout
+ *
+ * Only NO_DAEMON lets callers fall back to running the command in-process.
+ * After CONNECTION_LOST (explained on stderr) the command may already have
+ * run, in part or in full, so it must not be run again.
+ */
+ForwardResult ForwardCommand(const std::vector<std::string>& args, int& exit_code,
+                             const std::string& socket_path = GetDefaultSocketPath());
+
+// ============================================================================
+// Server
+// ============================================================================
+
+struct ClientConnection;
+
+/**
+ * @brief Long-lived process that serves forwarded commands with warm state
+ *
+ * Requests are handled one at a time on the thread calling Run(), so the
+ * handler may use single-threaded subsystems freely. While a request runs,
+ * std::cout and std::cerr are redirected to the client connection (output
+ * is streamed, not buffered until the end), std::cin reads as empty and the
+ * process working directory is switched to the client's. Both the redirect
+ * and the working directory are process-wide, which is why clients are
+ * never served concurrently and why no other thread may print while a
+ * request runs. A client that sends or takes nothing for longer than the
+ * client timeout (5 s by default) is dropped so it cannot hold up the ones
+ * behind it; the command runs on, and the client sees the connection end
+ * without an exit code.
+ */
+class DaemonServer {
+public:
+    using Handler = std::function<int(const Request& request)>;
+
+    DaemonServer(const std::string& socket_path, Handler handler);
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    // Binds the socket; fails if another daemon is already listening on it
+    bool Start();
+    // Serves requests until Stop() or a SHUTDOWN request; returns 0 on clean exit
+    int Run();
+    void Stop() { stop_requested_ = true; }
+    // Longest wait for a client to send its request or take more output
+    void SetClientTimeout(int timeout_ms) { client_timeout_ms_ = timeout_ms; }
+
+    bool IsListening() const { return listen_fd_ >= 0; }
+    uint64_t GetRequestsServed() const { return requests_served_.load(); }
+    const std::string& GetSocketPath() const { return socket_path_; }
+    const std::string& GetError() const { return error_; }
+
+private:
+    std::string socket_path_;
+    Handler handler_;
+    int listen_fd_;
+    int client_timeout_ms_;
+    std::atomic<bool> stop_requested_;
+    std::atomic<uint64_t> requests_served_;
+    std::string error_;
+
+    void HandleConnection(ClientConnection& connection);
+    int ExecuteRequest(ClientConnection& connection, const Request& request);
+};
+
+} // namespace daemon
+} // namespace esp32_ide
+
+#endif // ESP32_IDE_TERMINAL_DAEMON_H
@@ -1,5 +1,9 @@
 #include "terminal/terminal_mode.h"
 #include "backend/backend_framework.h"
+#include "compiler/esp32_compiler.h"
+#include "compiler/build_matrix.h"
+#include "compiler/size_history.h"
+#include "platform/platform_expansion.h"
 #include "editor/text_editor.h"
 #include "file_manager/file_manager.h"
 #include "file_manager/project_templates.h"
@@ -8,6 +12,12 @@
 #include "plugins/plugin_system.h"
 #include "testing/test_framework.h"
 #include "decompiler/advanced_decompiler.h"
+#include "search/project_search.h"
+#include "search/parallel_grep.h"
+#include "terminal/terminal_daemon.h"
+#include "serial/serial_monitor.h"
+#include "serial/multi_port_monitor.h"
+#include "utils/string_utils.h"
 
 #include <iostream>
 #include <sstream>
@@ -15,7 +25,10 @@
 #include <algorithm>
 #include <cstdlib>
 #include <chrono>
+#include <ctime>
 #include <fstream>
+#include <csignal>
+#include <thread>
 
 #ifdef _WIN32
 #include <io.h>
@@ -23,6 +36,7 @@
 #define fileno _fileno
 #else
 #include <unistd.h>
+#include <poll.h>
 #endif
 
 namespace esp32_ide {
@@ -40,18 +54,46 @@ TerminalModeApp::~TerminalModeApp() {
 }
 
 int TerminalModeApp::Run(int argc, char* argv[]) {
-    // Initialize backend
-    if (!BackendFramework::GetInstance().Initialize()) {
-        PrintError("Failed to initialize backend framework");
-        return 1;
-    }
-    
     // Parse command line arguments
     std::vector<std::string> args;
     for (int i = 1; i < argc; ++i) {
         args.push_back(argv[i]);
     }
     
+    // Daemon control never touches the backend, so forwarding stays cheap
+    if (!args.empty() && args[0] == "--daemon") {
+        return RunDaemon(args);
+    }
+    if (!args.empty() && (args[0] == "--stop-daemon" || args[0] == "--daemon-status")) {
+        return RunDaemonControl(args);
+    }
+    
+    // With ESP32_IDE_DAEMON set, one-shot commands go to a running daemon
+    // first and only fall back to a local backend if none is listening
+    const char* use_daemon = std::getenv("ESP32_IDE_DAEMON");
+    if (use_daemon && *use_daemon && std::string(use_daemon) != "0" && !args.empty() &&
+        args[0] != "--interactive" && args[0] != "-i") {
+        int exit_code = 0;
+        daemon::ForwardResult forwarded = daemon::ForwardCommand(args, exit_code);
+        if (forwarded == daemon::ForwardResult::COMPLETED) {
+            return exit_code;
+        }
+        // A command the daemon already took may have run; it is not repeated here
+        if (forwarded == daemon::ForwardResult::CONNECTION_LOST) {
+            return 1;
+        }
+    }
+    
+    // Initialize backend
+    if (!BackendFramework::GetInstance().Initialize()) {
+        PrintError("Failed to initialize backend framework");
+        return 1;
+    }
+    
+    return ExecuteArguments(args);
+}
+
+int TerminalModeApp::ExecuteArguments(const std::vector<std::string>& args) {
     // Check for special flags
     if (args.empty()) {
         // No arguments - run interactive mode
@@ -97,6 +139,77 @@ int TerminalModeApp::Run(int argc, char* argv[]) {
     return cmd_it->second.handler(cmd_args);
 }
 
+int TerminalModeApp::RunDaemon(const std::vector<std::string>& args) {
+    std::string socket_path = daemon::GetDefaultSocketPath();
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--socket" && i + 1 < args.size()) {
+            socket_path = args[++i];
+        }
+    }
+    
+    // Pay for subsystem construction once; every forwarded command reuses it
+    if (!BackendFramework::GetInstance().Initialize()) {
+        PrintError("Failed to initialize backend framework");
+        return 1;
+    }
+    // Each client starts from the board and build settings the daemon started with
+    BackendFramework::GetInstance().CaptureWorkspace();
+    
+    daemon::DaemonServer server(socket_path, [this](const daemon::Request& request) {
+        // Warm subsystems are shared, but each client gets its own project and directory
+        BackendFramework::GetInstance().ResetWorkspace();
+        color_output_ = request.color;
+        if (request.args.empty() || request.args[0] == "--interactive" || request.args[0] == "-i") {
+            PrintError("Interactive mode is not available through the daemon");
+            return 1;
+        }
+        if (request.args[0] == "--daemon") {
+            PrintError("A daemon is already running");
+            return 1;
+        }
+        return ExecuteArguments(request.args);
+    });
+    
+    if (!server.Start()) {
+        PrintError(server.GetError());
+        return 1;
+    }
+    
+    PrintSuccess("Daemon listening on " + server.GetSocketPath());
+    PrintInfo("Forward commands with esp32-driver-ide-client or ESP32_IDE_DAEMON=1");
+    int result = server.Run();
+    
+    BackendFramework::GetInstance().Shutdown();
+    PrintInfo("Daemon stopped after " + std::to_string(server.GetRequestsServed()) + " request(s)");
+    return result;
+}
+
+int TerminalModeApp::RunDaemonControl(const std::vector<std::string>& args) {
+    std::string socket_path = daemon::GetDefaultSocketPath();
+    for (size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "--socket" && i + 1 < args.size()) {
+            socket_path = args[++i];
+        }
+    }
+    
+    daemon::DaemonClient client(socket_path);
+    if (args[0] == "--stop-daemon") {
+        if (!client.Shutdown()) {
+            PrintError(client.GetError());
+            return 1;
+        }
+        PrintSuccess("Daemon on " + socket_path + " stopped");
+        return 0;
+    }
+    
+    if (!client.Ping()) {
+        PrintInfo("No daemon running (" + client.GetError() + ")");
+        return 1;
+    }
+    PrintSuccess("Daemon running on " + socket_path);
+    return 0;
+}
+
 void TerminalModeApp::Quit() {
     running_ = false;
 }
@@ -285,13 +398,48 @@ void TerminalModeApp::RegisterBuiltInCommands() {
         [this](const std::vector<std::string>& args) { return HandleUpload(args); }
     });
     
+    RegisterCommand({
+        "size", "Firmware size history",
+        "size [list [N]|show [build]|diff <a> <b>|top [<a> <b>] [-n N]|symbol <name> [N]]",
+        {"sizes"},
+        [this](const std::vector<std::string>& args) { return HandleSize(args); }
+    });
+    
+    RegisterCommand({
+        "matrix", "Build the sketch for several boards",
+        "matrix <board>... [--compiler <id>] [--project <dir>]",
+        {"build-matrix"},
+        [this](const std::vector<std::string>& args) { return HandleMatrix(args); }
+    });
+    
     // Serial commands
     RegisterCommand({
-        "monitor", "Open serial monitor", "monitor [baud]",
+        "monitor", "Open serial monitor", "monitor [baud] [--record <capture>] [--session <file>]",
         {"m", "serial"},
         [this](const std::vector<std::string>& args) { return HandleMonitor(args); }
     });
     
+    RegisterCommand({
+        "multimonitor", "Monitor several serial ports, interleaved by arrival",
+        "multimonitor <port>... [--baud N]",
+        {"mmon"},
+        [this](const std::vector<std::string>& args) { return HandleMultiMonitor(args); }
+    });
+    
+    RegisterCommand({
+        "replay", "Play a recorded serial session back through the monitor",
+        "replay <file> [--speed N] [--record <capture>]",
+        {},
+        [this](const std::vector<std::string>& args) { return HandleReplay(args); }
+    });
+    
+    RegisterCommand({
+        "capture", "Browse a recorded serial capture",
+        "capture <path> [--at <seconds>] [--search <words>] [--max N]",
+        {"log"},
+        [this](const std::vector<std::string>& args) { return HandleCapture(args); }
+    });
+    
     RegisterCommand({
         "send", "Send data to serial", "send <data>",
         {},
@@ -387,6 +535,21 @@ void TerminalModeApp::RegisterBuiltInCommands() {
         [this](const std::vector<std::string>& args) { return HandleExport(args); }
     });
     
+    // Search commands
+    RegisterCommand({
+        "search", "Search project files using the trigram index",
+        "search <query> [-r|--regex] [-i] [--max N]",
+        {"find"},
+        [this](const std::vector<std::string>& args) { return HandleSearch(args); }
+    });
+    
+    RegisterCommand({
+        "grep", "Search files without an index, streaming results",
+        "grep <pattern> [path...] [-r|--regex] [-i] [-j N] [--max N]",
+        {},
+        [this](const std::vector<std::string>& args) { return HandleGrep(args); }
+    });
+    
     // Utility commands
     RegisterCommand({
         "clear", "Clear the terminal screen", "clear",
@@ -453,16 +616,20 @@ void TerminalModeApp::PrintHelp() {
     Print("Options:");
     Print("  -h, --help         Show this help message");
     Print("  -v, --version      Show version information");
-    Print("  -i, --interactive  Run in interactive mode\n");
+    Print("  -i, --interactive  Run in interactive mode");
+    Print("  --daemon [--socket PATH]  Keep a warm backend serving forwarded commands");
+    Print("  --daemon-status    Check whether a daemon is running");
+    Print("  --stop-daemon      Stop the running daemon\n");
     Print("Commands:");
     
     // Group commands by category
     std::vector<std::pair<std::string, std::vector<std::string>>> categories = {
         {"File Operations", {"new", "open", "save", "close", "list", "cat", "edit", "recent"}},
         {"Project Management", {"create", "templates", "export"}},
+        {"Search", {"search", "grep"}},
         {"Board & Port", {"board", "port", "boards", "ports"}},
-        {"Compile & Upload", {"verify", "upload"}},
-        {"Serial Communication", {"monitor", "send"}},
+        {"Compile & Upload", {"verify", "upload", "size", "matrix"}},
+        {"Serial Communication", {"monitor", "multimonitor", "send", "replay", "capture"}},
         {"Emulator", {"emulator"}},
         {"AI Assistant", {"ask", "generate", "analyze", "fix"}},
         {"Device Library", {"devices", "add-device"}},
@@ -911,26 +1078,509 @@ int TerminalModeApp::HandleCompile(const std::vector<std::string>& args) {
     return HandleVerify(args);
 }
 
-int TerminalModeApp::HandleMonitor(const std::vector<std::string>& args) {
-    int baud = 115200;
-    if (!args.empty()) {
-        baud = std::atoi(args[0].c_str());
+int TerminalModeApp::HandleMatrix(const std::vector<std::string>& args) {
+    auto& backend = BackendFramework::GetInstance();
+    ESP32Compiler* compiler = backend.GetCompiler();
+    std::string compiler_id = compiler->GetBuildSettings().compiler_id;
+    std::string project;
+    std::vector<std::string> board_ids;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--compiler" && i + 1 < args.size()) {
+            compiler_id = args[++i];
+        } else if (args[i] == "--project" && i + 1 < args.size()) {
+            project = args[++i];
+        } else {
+            board_ids.push_back(args[i]);
+        }
+    }
+    
+    platform::MultiBoardSupport boards;
+    if (board_ids.empty()) {
+        std::string known;
+        for (const auto& board : boards.GetAllBoards()) {
+            known += (known.empty() ? "" : ", ") + board.id;
+        }
+        PrintError("Usage: matrix <board>... [--compiler <id>] [--project <dir>]");
+        PrintInfo("Boards: " + known);
+        return 1;
+    }
+    
+    // Without an open project, the current directory is the project
+    if (!project.empty() || backend.GetProjectConfig().path.empty()) {
+        if (!backend.OpenProject(project.empty() ? "." : project)) {
+            PrintError("Cannot open project " + project);
+            return 1;
+        }
+    }
+    if (compiler->GetBuildSettings().project_dir.empty()) {
+        PrintError("Matrix build needs a project directory");
+        return 1;
+    }
+    
+    std::vector<BuildMatrix::Target> targets;
+    for (const auto& board_id : board_ids) {
+        BuildMatrix::Target target;
+        if (!BuildMatrix::MakeTarget(boards, board_id, compiler_id, target)) {
+            PrintError("Unknown board: " + board_id);
+            return 1;
+        }
+        targets.push_back(target);
+    }
+    
+    PrintInfo("Building for " + std::to_string(targets.size()) + " board(s)...");
+    // Diagnostics as they come; the table is printed once at the end
+    compiler->SetOutputCallback([this](const std::string& message, ESP32Compiler::CompileStatus status) {
+        if (status == ESP32Compiler::CompileStatus::ERROR && message.find('\n') == std::string::npos) {
+            PrintError(message);
+        }
+    });
+    BuildMatrix::MatrixResult result = compiler->CompileMatrix(backend.GetTextEditor()->GetText(), targets);
+    compiler->SetOutputCallback(nullptr);
+    
+    Print(BuildMatrix::FormatTable(result));
+    if (result.success) {
+        PrintSuccess("All boards built");
+        return 0;
+    }
+    PrintError("Matrix build failed");
+    return 1;
+}
+
+namespace {
+
+std::string FormatBuildTime(int64_t timestamp) {
+    std::time_t time = static_cast<std::time_t>(timestamp);
+    std::tm* local = std::localtime(&time);
+    if (!local) {
+        return std::to_string(timestamp);
+    }
+    std::ostringstream oss;
+    oss << std::put_time(local, "%Y-%m-%d %H:%M");
+    return oss.str();
+}
+
+} // namespace
+
+int TerminalModeApp::HandleSize(const std::vector<std::string>& args) {
+    using Region = ElfSizeAnalyzer::Region;
+    SizeHistory history(SizeHistory::GetDefaultDirectory(BackendFramework::GetInstance().GetProjectRoot()));
+    size_t count = history.GetBuildCount();
+    if (count == 0) {
+        PrintInfo("No builds recorded yet; sizes are recorded by every successful compile");
+        return 0;
     }
+    std::string action = args.empty() ? "list" : args[0];
     
-    BackendFramework::GetInstance().SetSerialBaudRate(baud);
+    if (action == "list") {
+        size_t limit = args.size() > 1 ? static_cast<size_t>(std::atoi(args[1].c_str())) : 20;
+        size_t first = count > limit ? count - limit : 0;
+        // One row before the window so its first entry has a delta too
+        auto builds = history.GetBuilds(first > 0 ? first - 1 : 0, limit + (first > 0 ? 1 : 0));
+        std::vector<std::vector<std::string>> rows;
+        for (size_t i = first > 0 ? 1 : 0; i < builds.size(); ++i) {
+            const auto& build = builds[i];
+            std::string delta = i > 0 ? ElfSizeAnalyzer::FormatSigned(static_cast<int64_t>(build.flash_bytes) -
+                                                                      static_cast<int64_t>(builds[i - 1].flash_bytes))
+                                      : "";
+            rows.push_back({
+                std::to_string(build.id), FormatBuildTime(build.timestamp), build.board,
+                build.revision.substr(0, 10), std::to_string(build.flash_bytes), delta,
+                std::to_string(build.region_bytes[static_cast<size_t>(Region::IRAM)]),
+                std::to_string(build.region_bytes[static_cast<size_t>(Region::DRAM)])
+            });
+        }
+        PrintTable(rows, {"Build", "Date", "Board", "Revision", "Flash", "Change", "IRAM", "DRAM"});
+        return 0;
+    }
     
-    if (BackendFramework::GetInstance().OpenSerialMonitor()) {
-        PrintSuccess("Serial monitor opened at " + std::to_string(baud) + " baud");
-        PrintInfo("Press Ctrl+C to close");
+    if (action == "show") {
+        uint32_t id = 0;
+        if (!history.ResolveBuild(args.size() > 1 ? args[1] : "latest", id)) {
+            PrintError(history.GetError());
+            return 1;
+        }
+        SizeHistory::BuildRecord build;
+        std::vector<SizeHistory::SymbolSize> symbols;
+        if (!history.GetBuild(id, build) || !history.GetSymbols(id, symbols)) {
+            PrintError(history.GetError());
+            return 1;
+        }
+        Print("Build " + std::to_string(id) + " (" + build.board + ", " + FormatBuildTime(build.timestamp) +
+              (build.revision.empty() ? "" : ", " + build.revision.substr(0, 10)) + ")");
+        Print("Flash " + std::to_string(build.flash_bytes) + " bytes, RAM " + std::to_string(build.ram_bytes) + " bytes");
+        Print("");
+        std::vector<std::vector<std::string>> rows;
+        for (size_t i = 0; i < symbols.size() && i < 20; ++i) {
+            rows.push_back({std::to_string(symbols[i].size), ElfSizeAnalyzer::GetRegionName(symbols[i].region),
+                            ElfSizeAnalyzer::Demangle(symbols[i].name)});
+        }
+        PrintTable(rows, {"Size", "Region", "Symbol"});
+        return 0;
+    }
+    
+    if (action == "diff" || action == "top") {
+        size_t limit = 10;
+        std::vector<std::string> refs;
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "-n" && i + 1 < args.size()) {
+                limit = static_cast<size_t>(std::atoi(args[++i].c_str()));
+            } else {
+                refs.push_back(args[i]);
+            }
+        }
+        if (refs.empty()) {
+            refs = {"latest~1", "latest"};
+        }
+        uint32_t before = 0;
+        uint32_t after = 0;
+        if (refs.size() != 2) {
+            PrintError("Usage: size " + action + " <build> <build>" + (action == "top" ? " [-n N]" : ""));
+            return 1;
+        }
+        if (!history.ResolveBuild(refs[0], before) || !history.ResolveBuild(refs[1], after)) {
+            PrintError(history.GetError());
+            return 1;
+        }
+        
+        if (action == "diff") {
+            ElfSizeAnalyzer::SizeDelta delta;
+            if (!history.Diff(before, after, delta)) {
+                PrintError(history.GetError());
+                return 1;
+            }
+            Print("Build " + std::to_string(before) + " -> " + std::to_string(after) + ":");
+            Print(ElfSizeAnalyzer::FormatDelta(delta, limit));
+            return 0;
+        }
         
-        // Would run interactive serial monitor loop here
+        auto growers = history.GetTopGrowers(before, after, limit);
+        if (growers.empty()) {
+            PrintInfo("Nothing grew between build " + std::to_string(before) + " and " + std::to_string(after));
+            return 0;
+        }
+        std::vector<std::vector<std::string>> rows;
+        for (const auto& change : growers) {
+            rows.push_back({ElfSizeAnalyzer::FormatSigned(change.delta), std::to_string(change.before),
+                            std::to_string(change.after), ElfSizeAnalyzer::Demangle(change.name)});
+        }
+        PrintTable(rows, {"Growth", "Before", "After", "Symbol"});
+        return 0;
+    }
+    
+    if (action == "symbol") {
+        if (args.size() < 2) {
+            PrintError("Usage: size symbol <name> [N]");
+            return 1;
+        }
+        size_t limit = args.size() > 2 ? static_cast<size_t>(std::atoi(args[2].c_str())) : 20;
+        size_t first = count > limit ? count - limit : 0;
+        auto points = history.GetSymbolHistory(args[1], first, limit);
+        if (points.empty()) {
+            PrintError("Symbol not found in size history: " + args[1]);
+            return 1;
+        }
+        std::vector<std::vector<std::string>> rows;
+        for (size_t i = 0; i < points.size(); ++i) {
+            std::string delta = i > 0 ? ElfSizeAnalyzer::FormatSigned(static_cast<int64_t>(points[i].size) -
+                                                                      static_cast<int64_t>(points[i - 1].size))
+                                      : "";
+            rows.push_back({std::to_string(points[i].build_id), std::to_string(points[i].size), delta});
+        }
+        PrintTable(rows, {"Build", "Size", "Change"});
         return 0;
     }
     
-    PrintError("Failed to open serial monitor");
+    PrintError("Unknown size command: " + action);
     return 1;
 }
 
+namespace {
+
+volatile std::sig_atomic_t g_monitor_interrupted = 0;
+
+void OnMonitorInterrupt(int) {
+    g_monitor_interrupted = 1;
+}
+
+// Device output is printed as is; only the colour tells errors and warnings apart
+const char* GetMessageColor(SerialMonitor::MessageType type) {
+    switch (type) {
+        case SerialMonitor::MessageType::ERROR:   return "red";
+        case SerialMonitor::MessageType::WARNING: return "yellow";
+        case SerialMonitor::MessageType::SUCCESS: return "green";
+        case SerialMonitor::MessageType::INFO:    return "cyan";
+        default:                                  return nullptr;
+    }
+}
+
+} // namespace
+
+void TerminalModeApp::PrintSerialLine(const std::string& line, const char* color) {
+    if (color && color_output_) {
+        std::cout << GetColorCode(color) << line << ResetColor() << std::endl;
+    } else {
+        std::cout << line << std::endl;
+    }
+}
+
+void TerminalModeApp::PrintSerialMessages(SerialMonitor* monitor, uint64_t& next) {
+    uint64_t end = monitor->GetMessageEndIndex();
+    next = std::max(next, monitor->GetFirstMessageIndex());
+    if (end > next) {
+        for (const auto& message : monitor->GetMessages(next, static_cast<size_t>(end - next))) {
+            PrintSerialLine(message.content, GetMessageColor(message.type));
+        }
+        next = end;
+    }
+}
+
+int TerminalModeApp::HandleMonitor(const std::vector<std::string>& args) {
+    int baud = 115200;
+    std::string record;
+    std::string session;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--record" && i + 1 < args.size()) {
+            record = args[++i];
+        } else if (args[i] == "--session" && i + 1 < args.size()) {
+            session = args[++i];
+        } else {
+            baud = std::atoi(args[i].c_str());
+        }
+    }
+    
+    auto& backend = BackendFramework::GetInstance();
+    backend.SetSerialBaudRate(baud);
+    
+    if (!backend.IsSerialOpen() && !backend.OpenSerialMonitor()) {
+        PrintError("Failed to open serial monitor");
+        return 1;
+    }
+    SerialMonitor* monitor = backend.GetSerialMonitor();
+    uint64_t next = monitor->GetMessageEndIndex();
+    if ((!record.empty() && !monitor->StartRecording(record)) ||
+        (!session.empty() && !monitor->StartSessionRecording(session))) {
+        // The monitor's own message says what could not be opened
+        PrintSerialMessages(monitor, next);
+        monitor->StopRecording();
+        backend.CloseSerialMonitor();
+        return 1;
+    }
+    next = monitor->GetMessageEndIndex();
+    PrintSuccess("Serial monitor opened at " + std::to_string(baud) + " baud");
+    if (monitor->IsRecording()) {
+        PrintInfo("Recording to " + record + "; browse it with: capture " + record);
+    }
+    if (monitor->IsSessionRecording()) {
+        PrintInfo("Recording the session to " + session + "; play it back with: replay " + session);
+    }
+    PrintInfo("Lines typed are sent to the device; Ctrl+C or Ctrl+D to close");
+    
+    g_monitor_interrupted = 0;
+    auto previous = std::signal(SIGINT, OnMonitorInterrupt);
+    std::string input;
+    bool input_open = true;
+    while (!g_monitor_interrupted && monitor->IsConnected()) {
+        monitor->ProcessIncoming();
+        PrintSerialMessages(monitor, next);
+        
+#ifndef _WIN32
+        // Typed lines, without blocking the reads
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        if (!input_open || poll(&pfd, 1, 10) <= 0) {
+            if (!input_open) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        char buffer[256];
+        ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (n <= 0) {
+            // Ctrl+D, or input from a file that ran out
+            if (isatty(STDIN_FILENO)) break;
+            input_open = false;
+            continue;
+        }
+        input.append(buffer, static_cast<size_t>(n));
+        size_t newline;
+        while ((newline = input.find('\n')) != std::string::npos) {
+            monitor->SendData(input.substr(0, newline + 1));
+            input.erase(0, newline + 1);
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+    }
+    std::signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+    
+    bool lost = !monitor->IsConnected();
+    monitor->StopRecording();
+    monitor->StopSessionRecording();
+    backend.CloseSerialMonitor();
+    if (lost) {
+        PrintError("Serial connection lost");
+        return 1;
+    }
+    PrintInfo("Serial monitor closed");
+    return 0;
+}
+
+int TerminalModeApp::HandleMultiMonitor(const std::vector<std::string>& args) {
+    int baud = 115200;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--baud" && i + 1 < args.size()) {
+            baud = std::atoi(args[++i].c_str());
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+    if (paths.empty()) {
+        PrintError("Usage: multimonitor <port>... [--baud N]");
+        return 1;
+    }
+    
+    MultiPortMonitor monitor;
+    std::vector<std::string> labels;
+    for (const auto& path : paths) {
+        if (monitor.AddPort(path, baud) < 0) {
+            PrintError("Cannot monitor " + path + ": " + monitor.GetError());
+            return 1;
+        }
+        labels.push_back("[" + std::to_string(labels.size()) + " " + path.substr(path.find_last_of('/') + 1) + "] ");
+    }
+    PrintSuccess("Monitoring " + std::to_string(paths.size()) + " port(s) at " + std::to_string(baud) + " baud");
+    PrintInfo("Lines are prefixed with their port; Ctrl+C to close");
+    
+    g_monitor_interrupted = 0;
+    auto previous = std::signal(SIGINT, OnMonitorInterrupt);
+    std::vector<uint64_t> next(paths.size(), 0);
+    bool connected = true;
+    while (!g_monitor_interrupted && connected) {
+        monitor.ProcessIncoming();
+        MultiPortMonitor::MergedCursor cursor = monitor.GetMergedCursor(next);
+        MultiPortMonitor::Entry entry;
+        while (cursor.Next(entry)) {
+            PrintSerialLine(labels[entry.port] + std::string(entry.message.content),
+                            GetMessageColor(static_cast<SerialMonitor::MessageType>(entry.message.type)));
+            next[entry.port] = entry.index + 1;
+        }
+        connected = false;
+        for (size_t port = 0; port < paths.size(); ++port) {
+            connected |= monitor.IsPortConnected(static_cast<int>(port));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+    
+    if (!connected) {
+        PrintError("Every port disconnected");
+        return 1;
+    }
+    PrintInfo("Multi-port monitor closed");
+    return 0;
+}
+
+int TerminalModeApp::HandleReplay(const std::vector<std::string>& args) {
+    std::string path;
+    std::string record;
+    double speed = 1.0;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--speed" && i + 1 < args.size()) {
+            speed = std::max(0.0, std::atof(args[++i].c_str()));
+        } else if (args[i] == "--record" && i + 1 < args.size()) {
+            record = args[++i];
+        } else {
+            path = args[i];
+        }
+    }
+    if (path.empty()) {
+        PrintError("Usage: replay <file> [--speed N] [--record <capture>]");
+        return 1;
+    }
+    
+    auto& backend = BackendFramework::GetInstance();
+    SerialMonitor* monitor = backend.GetSerialMonitor();
+    uint64_t next = monitor->GetMessageEndIndex();
+    // The replay stands in for the device, so it takes over the monitor
+    bool started = monitor->StartReplay(path, speed) && (record.empty() || monitor->StartRecording(record));
+    if (!started) {
+        monitor->StopReplay();
+        PrintSerialMessages(monitor, next);
+        return 1;
+    }
+    
+    g_monitor_interrupted = 0;
+    auto previous = std::signal(SIGINT, OnMonitorInterrupt);
+    while (!g_monitor_interrupted && monitor->IsReplaying()) {
+        monitor->ProcessIncoming();
+        PrintSerialMessages(monitor, next);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::signal(SIGINT, previous == SIG_ERR ? SIG_DFL : previous);
+    monitor->StopReplay();
+    monitor->StopRecording();
+    PrintSerialMessages(monitor, next);
+    return 0;
+}
+
+int TerminalModeApp::HandleCapture(const std::vector<std::string>& args) {
+    std::string path;
+    std::string words;
+    double at = -1;
+    size_t max = 50;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--at" && i + 1 < args.size()) {
+            at = std::atof(args[++i].c_str());
+        } else if (args[i] == "--search" && i + 1 < args.size()) {
+            words = args[++i];
+        } else if (args[i] == "--max" && i + 1 < args.size()) {
+            max = static_cast<size_t>(std::max(1, std::atoi(args[++i].c_str())));
+        } else {
+            path = args[i];
+        }
+    }
+    if (path.empty()) {
+        PrintError("Usage: capture <path> [--at <seconds>] [--search <words>] [--max N]");
+        return 1;
+    }
+    
+    SerialArchiveReader reader;
+    if (!reader.Open(path)) {
+        PrintError(reader.GetError());
+        return 1;
+    }
+    // Timestamps are system_clock ticks; shown as offsets into the capture
+    long long start = reader.GetFirstTimestamp();
+    auto offset_ms = [start](long long timestamp) {
+        return static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::duration(timestamp - start)).count());
+    };
+    PrintInfo(std::to_string(reader.GetMessageCount()) + " message(s) in " + std::to_string(reader.GetBlockCount()) +
+              " block(s), spanning " + utils::StringUtils::FormatSeconds(offset_ms(reader.GetLastTimestamp())));
+    
+    uint64_t first = 0;
+    if (at >= 0) {
+        auto ticks = std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(at));
+        first = reader.Seek(start + static_cast<long long>(ticks.count()));
+    }
+    auto print = [&](uint64_t index, const SerialArchiveReader::Message& message) {
+        std::ostringstream line;
+        line << "#" << index << " [+" << utils::StringUtils::FormatSeconds(offset_ms(message.timestamp)) << "] "
+             << message.content;
+        PrintSerialLine(line.str(), GetMessageColor(static_cast<SerialMonitor::MessageType>(message.type)));
+    };
+    
+    if (!words.empty()) {
+        size_t matches = reader.Search(words, first, max, print);
+        SerialArchiveReader::SearchStatistics stats = reader.GetSearchStatistics();
+        PrintInfo(std::to_string(matches) + " match(es); " + std::to_string(stats.blocks_read) + " of " +
+                  std::to_string(stats.blocks) + " block(s) read");
+        return 0;
+    }
+    if (reader.Read(first, max, print) == 0) {
+        PrintInfo("No messages from there on");
+    }
+    return 0;
+}
+
 int TerminalModeApp::HandleSend(const std::vector<std::string>& args) {
     if (args.empty()) {
         PrintError("Usage: send <data>");
@@ -1405,6 +2055,119 @@ int TerminalModeApp::HandlePlugins(const std::vector<std::string>& args) {
     return 1;
 }
 
+// Search commands
+
+int TerminalModeApp::HandleSearch(const std::vector<std::string>& args) {
+    search::SearchOptions options;
+    std::string query;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "-r" || args[i] == "--regex") {
+            options.regex = true;
+        } else if (args[i] == "-i") {
+            options.case_sensitive = false;
+        } else if (args[i] == "--max" && i + 1 < args.size()) {
+            options.max_results = static_cast<size_t>(std::atoi(args[++i].c_str()));
+        } else {
+            if (!query.empty()) query += " ";
+            query += args[i];
+        }
+    }
+    
+    if (query.empty()) {
+        PrintError("Usage: search <query> [-r|--regex] [-i] [--max N]");
+        return 1;
+    }
+    
+    search::ContentMatcher matcher(query, options);
+    if (!matcher.IsValid()) {
+        PrintError(matcher.GetError());
+        return 1;
+    }
+    
+    auto& framework = BackendFramework::GetInstance();
+    auto* index = framework.GetSearchIndex();
+    if (!index) return 1;
+    
+    auto start = std::chrono::steady_clock::now();
+    framework.UpdateSearchIndex();
+    auto hits = index->Search(query, options);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    for (const auto& hit : hits) {
+        Print(hit.path + ":" + std::to_string(hit.line) + ":" +
+              std::to_string(hit.column) + ": " + hit.line_text);
+    }
+    
+    Print("");
+    PrintInfo(std::to_string(hits.size()) + " matches in " +
+              std::to_string(index->GetDocumentCount()) + " indexed files (" +
+              std::to_string(elapsed) + " ms)");
+    return 0;
+}
+
+int TerminalModeApp::HandleGrep(const std::vector<std::string>& args) {
+    search::SearchOptions options;
+    options.max_results = 10000;
+    size_t threads = 0;
+    std::string pattern;
+    std::vector<std::string> paths;
+    
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "-r" || args[i] == "--regex") {
+            options.regex = true;
+        } else if (args[i] == "-i") {
+            options.case_sensitive = false;
+        } else if (args[i] == "-j" && i + 1 < args.size()) {
+            threads = static_cast<size_t>(std::atoi(args[++i].c_str()));
+        } else if (args[i] == "--max" && i + 1 < args.size()) {
+            options.max_results = static_cast<size_t>(std::atoi(args[++i].c_str()));
+        } else if (pattern.empty()) {
+            pattern = args[i];
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+    
+    if (pattern.empty()) {
+        PrintError("Usage: grep <pattern> [path...] [-r|--regex] [-i] [-j N] [--max N]");
+        return 1;
+    }
+    if (paths.empty()) {
+        paths.push_back(BackendFramework::GetInstance().GetProjectRoot());
+    }
+    
+    // Hits are printed from worker threads as they arrive; the grep
+    // engine serializes the callback so lines never interleave
+    search::ParallelGrep grep;
+    grep.SetThreadCount(threads);
+    bool started = grep.Start(paths, pattern, options, [this](const search::SearchHit& hit) {
+        Print(hit.path + ":" + std::to_string(hit.line) + ":" +
+              std::to_string(hit.column) + ": " + hit.line_text);
+    });
+    if (!started) {
+        PrintError(grep.GetError());
+        return 1;
+    }
+    grep.Wait();
+    
+    auto stats = grep.GetStats();
+    std::ostringstream summary;
+    summary << stats.hits << " matches, " << stats.files_scanned << " files scanned ("
+            << stats.files_skipped << " skipped) in " << std::fixed << std::setprecision(1)
+            << stats.elapsed_ms << " ms";
+    if (stats.first_hit_ms >= 0) {
+        summary << ", first hit after " << stats.first_hit_ms << " ms";
+    }
+    if (stats.limit_reached) {
+        summary << "; stopped at the limit of " << options.max_results;
+    }
+    Print("");
+    PrintInfo(summary.str());
+    return stats.hits > 0 ? 0 : 1;
+}
+
 // Test commands
 
 int TerminalModeApp::HandleTest(const std::vector<std::string>& args) {
@@ -5,9 +5,12 @@
 #include <vector>
 #include <map>
 #include <functional>
+#include <cstdint>
 
 namespace esp32_ide {
 
+class SerialMonitor;
+
 /**
  * @brief Terminal-based mode for the ESP32 Driver IDE
  * 
@@ -32,8 +35,13 @@ public:
     
     // Application lifecycle
     int Run(int argc, char* argv[]);
+    int ExecuteArguments(const std::vector<std::string>& args);
     void Quit();
     
+    // Daemon mode (warm backend serving forwarded commands)
+    int RunDaemon(const std::vector<std::string>& args);
+    int RunDaemonControl(const std::vector<std::string>& args);
+    
     // Interactive mode
     int RunInteractive();
     void ProcessCommand(const std::string& input);
@@ -54,8 +62,13 @@ public:
     void PrintError(const std::string& message);
     void PrintWarning(const std::string& message);
     void PrintInfo(const std::string& message);
+    // A line of device output, coloured when color is set and colours are on
+    void PrintSerialLine(const std::string& line, const char* color);
+    // Prints the monitor's messages from `next` on and moves it past them
+    void PrintSerialMessages(SerialMonitor* monitor, uint64_t& next);
     void PrintTable(const std::vector<std::vector<std::string>>& rows, 
                    const std::vector<std::string>& headers);
+    void SetColorOutput(bool enabled) { color_output_ = enabled; }
     
     // Progress display
     void ShowProgress(const std::string& message, float progress);
@@ -99,10 +112,15 @@ private:
     int HandleVerify(const std::vector<std::string>& args);
     int HandleUpload(const std::vector<std::string>& args);
     int HandleCompile(const std::vector<std::string>& args);
+    int HandleSize(const std::vector<std::string>& args);
+    int HandleMatrix(const std::vector<std::string>& args);
     
     // Serial commands
     int HandleMonitor(const std::vector<std::string>& args);
     int HandleSend(const std::vector<std::string>& args);
+    int HandleMultiMonitor(const std::vector<std::string>& args);
+    int HandleReplay(const std::vector<std::string>& args);
+    int HandleCapture(const std::vector<std::string>& args);
     
     // Emulator commands
     int HandleEmulator(const std::vector<std::string>& args);
@@ -128,6 +146,10 @@ private:
     int HandleRecent(const std::vector<std::string>& args);
     int HandleExport(const std::vector<std::string>& args);
     
+    // Search commands
+    int HandleSearch(const std::vector<std::string>& args);
+    int HandleGrep(const std::vector<std::string>& args);
+    
     // Utility commands
     int HandleClear(const std::vector<std::string>& args);
     int HandleHistory(const std::vector<std::string>& args);
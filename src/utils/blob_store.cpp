@@ -0,0 +1,206 @@
+#include "utils/blob_store.h"
+#include "utils/lz_codec.h"
+#include <cstring>
+
+namespace esp32_ide {
+namespace utils {
+
+namespace {
+
+inline uint64_t Rotl(uint64_t value, int bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t Mix(uint64_t k) {
+    k *= 0x87c37b91114253d5ULL;
+    k = Rotl(k, 31);
+    return k * 0x4cf5ad432745937fULL;
+}
+
+inline uint64_t Finalize(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+const uint64_t kCheckSeed = 0x6a09e667f3bcc909ULL;
+
+} // namespace
+
+BlobStore& BlobStore::GetInstance() {
+    static BlobStore instance;
+    return instance;
+}
+
+BlobStore::BlobStore()
+    : compression_threshold_(64), stored_bytes_(0), unique_bytes_(0), dedup_hits_(0) {
+}
+
+uint64_t BlobStore::HashContent(const char* data, size_t size, uint64_t seed) {
+    uint64_t h = seed ^ (size * 0x9E3779B97F4A7C15ULL);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t k;
+        std::memcpy(&k, data + i, sizeof(k));
+        h ^= Mix(k);
+        h = Rotl(h, 27) * 5 + 0x52dce729;
+    }
+    if (i < size) {
+        uint64_t k = 0;
+        std::memcpy(&k, data + i, size - i);
+        h ^= Mix(k);
+    }
+    return Finalize(h);
+}
+
+BlobHandle BlobStore::FindSlot(uint64_t hash, uint64_t check, size_t size, bool& exists) const {
+    BlobHandle handle = hash ? hash : 1;
+    for (;;) {
+        auto it = blobs_.find(handle);
+        if (it == blobs_.end()) {
+            exists = false;
+            return handle;
+        }
+        if (it->second.check == check && it->second.size == size) {
+            exists = true;
+            return handle;
+        }
+        // Genuine 64-bit collision: probe the next handle (0 stays reserved)
+        if (++handle == 0) handle = 1;
+    }
+}
+
+BlobHandle BlobStore::Put(const std::string& data) {
+    return Put(data.data(), data.size());
+}
+
+BlobHandle BlobStore::Put(const char* data, size_t size) {
+    if (size == 0) return 0;
+
+    uint64_t hash = HashContent(data, size);
+    uint64_t check = HashContent(data, size, kCheckSeed);
+    bool exists = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        BlobHandle handle = FindSlot(hash, check, size, exists);
+        if (exists) {
+            blobs_[handle].refs++;
+            dedup_hits_++;
+            return handle;
+        }
+    }
+
+    // Compress outside the lock; keep the raw bytes if compression does not pay
+    Blob blob;
+    blob.check = check;
+    blob.size = size;
+    blob.refs = 1;
+    blob.compressed = false;
+    if (size >= compression_threshold_) {
+        LzCodec::Compress(data, size, blob.stored);
+        blob.compressed = blob.stored.size() < size;
+    }
+    if (!blob.compressed) {
+        blob.stored.assign(data, size);
+    }
+    blob.stored.shrink_to_fit();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    BlobHandle handle = FindSlot(hash, check, size, exists);
+    if (exists) {
+        // Another thread stored the same content meanwhile
+        blobs_[handle].refs++;
+        dedup_hits_++;
+        return handle;
+    }
+    stored_bytes_ += blob.stored.size();
+    unique_bytes_ += size;
+    blobs_.emplace(handle, std::move(blob));
+    return handle;
+}
+
+void BlobStore::AddRef(BlobHandle handle) {
+    if (handle == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(handle);
+    if (it != blobs_.end()) {
+        it->second.refs++;
+    }
+}
+
+void BlobStore::Release(BlobHandle handle) {
+    if (handle == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(handle);
+    if (it == blobs_.end()) return;
+
+    if (--it->second.refs == 0) {
+        stored_bytes_ -= it->second.stored.size();
+        unique_bytes_ -= it->second.size;
+        blobs_.erase(it);
+    }
+}
+
+bool BlobStore::Get(BlobHandle handle, std::string& out) const {
+    out.clear();
+    if (handle == 0) return true;
+
+    // Decoding runs at memory speed, so it is done in place under the lock
+    // rather than copying the compressed bytes out first
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(handle);
+    if (it == blobs_.end()) return false;
+    if (!it->second.compressed) {
+        out = it->second.stored;
+        return true;
+    }
+    return LzCodec::Decompress(it->second.stored, it->second.size, out);
+}
+
+std::string BlobStore::Get(BlobHandle handle) const {
+    std::string out;
+    Get(handle, out);
+    return out;
+}
+
+bool BlobStore::Contains(BlobHandle handle) const {
+    if (handle == 0) return true;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return blobs_.find(handle) != blobs_.end();
+}
+
+size_t BlobStore::GetSize(BlobHandle handle) const {
+    if (handle == 0) return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(handle);
+    return it != blobs_.end() ? it->second.size : 0;
+}
+
+uint32_t BlobStore::GetRefCount(BlobHandle handle) const {
+    if (handle == 0) return 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = blobs_.find(handle);
+    return it != blobs_.end() ? it->second.refs : 0;
+}
+
+BlobStore::Stats BlobStore::GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.blob_count = blobs_.size();
+    stats.reference_count = 0;
+    stats.logical_bytes = 0;
+    for (const auto& pair : blobs_) {
+        stats.reference_count += pair.second.refs;
+        stats.logical_bytes += pair.second.size * pair.second.refs;
+    }
+    stats.unique_bytes = unique_bytes_;
+    stats.stored_bytes = stored_bytes_;
+    stats.dedup_hits = dedup_hits_;
+    return stats;
+}
+
+} // namespace utils
+} // namespace esp32_ide
@@ -0,0 +1,138 @@
+#ifndef BLOB_STORE_H
+#define BLOB_STORE_H
+
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Opaque 8-byte reference to a stored blob (0 is the empty blob)
+ */
+using BlobHandle = uint64_t;
+
+/**
+ * @brief Shared content-addressed store for file snapshots
+ *
+ * Blobs are keyed by a 64-bit content hash, so identical contents (the
+ * same file in an undo stack, a hibernated tab and a review change) are
+ * kept once. Blobs above a small threshold are compressed with LzCodec and
+ * reference-counted; the last Release() frees the storage.
+ *
+ * A second, independently seeded hash guards against handle collisions:
+ * a colliding blob is given the next free handle instead of being merged.
+ * All methods are thread-safe. Most callers should hold blobs through
+ * BlobRef rather than managing references by hand.
+ */
+class BlobStore {
+public:
+    struct Stats {
+        size_t blob_count;          // unique blobs held
+        size_t reference_count;     // sum of all references
+        uint64_t logical_bytes;     // bytes the references would take as plain copies
+        uint64_t unique_bytes;      // uncompressed size of the unique blobs
+        uint64_t stored_bytes;      // bytes actually held after compression
+        uint64_t dedup_hits;        // Put() calls satisfied by an existing blob
+    };
+
+    static BlobStore& GetInstance();
+
+    BlobStore();
+    ~BlobStore() = default;
+
+    BlobStore(const BlobStore&) = delete;
+    BlobStore& operator=(const BlobStore&) = delete;
+
+    // Storing returns a handle holding one reference
+    BlobHandle Put(const std::string& data);
+    BlobHandle Put(const char* data, size_t size);
+    void AddRef(BlobHandle handle);
+    void Release(BlobHandle handle);
+
+    // Reading
+    bool Get(BlobHandle handle, std::string& out) const;
+    std::string Get(BlobHandle handle) const;
+    bool Contains(BlobHandle handle) const;
+    size_t GetSize(BlobHandle handle) const;
+    uint32_t GetRefCount(BlobHandle handle) const;
+
+    // Statistics and tuning
+    Stats GetStats() const;
+    void SetCompressionThreshold(size_t bytes) { compression_threshold_ = bytes; }
+
+    static uint64_t HashContent(const char* data, size_t size, uint64_t seed = 0);
+
+private:
+    struct Blob {
+        std::string stored;
+        uint64_t check;       // second hash, detects handle collisions
+        uint64_t size;
+        uint32_t refs;
+        bool compressed;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<BlobHandle, Blob> blobs_;
+    size_t compression_threshold_;
+    uint64_t stored_bytes_;
+    uint64_t unique_bytes_;
+    uint64_t dedup_hits_;
+
+    // Returns the handle holding this content, or the first free slot for it
+    BlobHandle FindSlot(uint64_t hash, uint64_t check, size_t size, bool& exists) const;
+};
+
+/**
+ * @brief RAII, copyable handle into the shared BlobStore
+ *
+ * Exactly 8 bytes; copies share the blob and add a reference.
+ */
+class BlobRef {
+public:
+    BlobRef() : handle_(0) {}
+    explicit BlobRef(const std::string& data) : handle_(BlobStore::GetInstance().Put(data)) {}
+    BlobRef(const BlobRef& other) : handle_(other.handle_) { BlobStore::GetInstance().AddRef(handle_); }
+    BlobRef(BlobRef&& other) noexcept : handle_(other.handle_) { other.handle_ = 0; }
+    ~BlobRef() { BlobStore::GetInstance().Release(handle_); }
+
+    BlobRef& operator=(const BlobRef& other) {
+        if (handle_ != other.handle_) {
+            BlobStore::GetInstance().AddRef(other.handle_);
+            BlobStore::GetInstance().Release(handle_);
+            handle_ = other.handle_;
+        }
+        return *this;
+    }
+
+    BlobRef& operator=(BlobRef&& other) noexcept {
+        if (this != &other) {
+            BlobStore::GetInstance().Release(handle_);
+            handle_ = other.handle_;
+            other.handle_ = 0;
+        }
+        return *this;
+    }
+
+    void Assign(const std::string& data) { *this = BlobRef(data); }
+    void Reset() { *this = BlobRef(); }
+
+    std::string Get() const { return BlobStore::GetInstance().Get(handle_); }
+    bool Get(std::string& out) const { return BlobStore::GetInstance().Get(handle_, out); }
+    size_t Size() const { return BlobStore::GetInstance().GetSize(handle_); }
+    bool Empty() const { return handle_ == 0; }
+    BlobHandle GetHandle() const { return handle_; }
+
+    bool operator==(const BlobRef& other) const { return handle_ == other.handle_; }
+    bool operator!=(const BlobRef& other) const { return handle_ != other.handle_; }
+
+private:
+    BlobHandle handle_;
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // BLOB_STORE_H
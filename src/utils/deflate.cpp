@@ -0,0 +1,675 @@
+#include "utils/deflate.h"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+namespace esp32_ide {
+namespace utils {
+
+namespace {
+
+constexpr size_t kWindowSize = 32768;
+constexpr size_t kMinMatch = 3;
+constexpr size_t kMaxMatch = 258;
+constexpr int kHashBits = 15;
+constexpr int kMaxChain = 64;
+constexpr size_t kNiceMatch = 128;
+// Matches at least this long are taken without looking one byte ahead
+constexpr size_t kLazyLimit = 32;
+constexpr size_t kSymbolsPerBlock = 16384;
+
+constexpr int kLitLenCodes = 286;
+constexpr int kDistCodes = 30;
+constexpr int kCodeLengthCodes = 19;
+constexpr int kMaxBits = 15;
+
+const uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                  31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t kDistBase[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+const uint8_t kCodeLengthOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// ============================================================================
+// Encoder
+// ============================================================================
+
+class BitWriter {
+public:
+    explicit BitWriter(std::string& out) : out_(out), bits_(0), count_(0) {}
+
+    void Put(uint32_t value, int bits) {
+        bits_ |= static_cast<uint64_t>(value) << count_;
+        count_ += bits;
+        while (count_ >= 8) {
+            out_.push_back(static_cast<char>(bits_ & 0xFF));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void Align() {
+        if (count_ > 0) {
+            out_.push_back(static_cast<char>(bits_ & 0xFF));
+            bits_ = 0;
+            count_ = 0;
+        }
+    }
+
+private:
+    std::string& out_;
+    uint64_t bits_;
+    int count_;
+};
+
+// dist == 0: literal `value`; otherwise a match of length `value`
+struct Symbol {
+    uint16_t value;
+    uint16_t dist;
+};
+
+int LengthCode(size_t length) {
+    return static_cast<int>(std::upper_bound(kLengthBase, kLengthBase + 29, length) - kLengthBase) - 1;
+}
+
+int DistCode(size_t dist) {
+    return static_cast<int>(std::upper_bound(kDistBase, kDistBase + 30, dist) - kDistBase) - 1;
+}
+
+// Huffman code lengths no longer than `limit`; flattening the frequencies
+// until the tree fits costs a little ratio and never happens on real data
+void BuildLengths(const uint32_t* freq, int count, int limit, uint8_t* lengths) {
+    std::vector<uint32_t> weights(freq, freq + count);
+    for (;;) {
+        std::fill(lengths, lengths + count, 0);
+        using Node = std::pair<uint64_t, int>;
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+        std::vector<int> parent;
+        for (int i = 0; i < count; ++i) {
+            if (weights[i] > 0) queue.push({weights[i], i});
+        }
+        parent.assign(count, -1);
+        if (queue.size() == 1) {
+            lengths[queue.top().second] = 1;
+            return;
+        }
+        while (queue.size() > 1) {
+            Node a = queue.top();
+            queue.pop();
+            Node b = queue.top();
+            queue.pop();
+            int node = static_cast<int>(parent.size());
+            parent.push_back(-1);
+            parent[a.second] = node;
+            parent[b.second] = node;
+            queue.push({a.first + b.first, node});
+        }
+        int longest = 0;
+        for (int i = 0; i < count; ++i) {
+            if (weights[i] == 0) continue;
+            int depth = 0;
+            for (int node = i; parent[node] >= 0; node = parent[node]) depth++;
+            lengths[i] = static_cast<uint8_t>(depth);
+            longest = std::max(longest, depth);
+        }
+        if (longest <= limit) return;
+        for (auto& weight : weights) {
+            if (weight > 0) weight = std::max<uint32_t>(1, weight >> 1);
+        }
+    }
+}
+
+// Canonical codes, bit-reversed for LSB-first output
+void BuildCodes(const uint8_t* lengths, int count, uint16_t* codes) {
+    uint16_t length_count[kMaxBits + 1] = {0};
+    for (int i = 0; i < count; ++i) length_count[lengths[i]]++;
+    length_count[0] = 0;
+    uint16_t next[kMaxBits + 1] = {0};
+    uint16_t code = 0;
+    for (int bits = 1; bits <= kMaxBits; ++bits) {
+        code = static_cast<uint16_t>((code + length_count[bits - 1]) << 1);
+        next[bits] = code;
+    }
+    for (int i = 0; i < count; ++i) {
+        int length = lengths[i];
+        if (length == 0) continue;
+        uint16_t value = next[length]++;
+        uint16_t reversed = 0;
+        for (int bit = 0; bit < length; ++bit) {
+            reversed = static_cast<uint16_t>((reversed << 1) | ((value >> bit) & 1));
+        }
+        codes[i] = reversed;
+    }
+}
+
+// Every tree gets two used symbols so its code is complete
+void EnsureTwoSymbols(uint32_t* freq, int count) {
+    int used = 0;
+    for (int i = 0; i < count; ++i) {
+        if (freq[i] > 0) used++;
+    }
+    for (int i = 0; used < 2 && i < count; ++i) {
+        if (freq[i] == 0) {
+            freq[i] = 1;
+            used++;
+        }
+    }
+}
+
+struct CodeLengthToken {
+    uint8_t symbol;
+    uint8_t extra;
+};
+
+// Run-length codes the concatenated literal/length and distance lengths
+std::vector<CodeLengthToken> EncodeLengths(const std::vector<uint8_t>& lengths) {
+    std::vector<CodeLengthToken> tokens;
+    size_t i = 0;
+    while (i < lengths.size()) {
+        uint8_t value = lengths[i];
+        size_t run = 1;
+        while (i + run < lengths.size() && lengths[i + run] == value) run++;
+        if (value == 0 && run >= 3) {
+            size_t take = std::min<size_t>(run, 138);
+            if (take >= 11) tokens.push_back({18, static_cast<uint8_t>(take - 11)});
+            else tokens.push_back({17, static_cast<uint8_t>(take - 3)});
+            i += take;
+        } else if (value != 0 && run >= 4) {
+            size_t take = std::min<size_t>(run - 1, 6);
+            tokens.push_back({value, 0});
+            tokens.push_back({16, static_cast<uint8_t>(take - 3)});
+            i += take + 1;
+        } else {
+            tokens.push_back({value, 0});
+            i++;
+        }
+    }
+    return tokens;
+}
+
+class Encoder {
+public:
+    Encoder(const unsigned char* data, size_t size, std::string& out)
+        : data_(data), size_(size), writer_(out), head_(size_t(1) << kHashBits, -1), prev_(kWindowSize, -1) {}
+
+    void Run() {
+        std::vector<Symbol> symbols;
+        symbols.reserve(kSymbolsPerBlock);
+        size_t block_start = 0;
+        size_t pos = 0;
+        while (pos < size_) {
+            size_t length = 0;
+            size_t dist = 0;
+            FindMatch(pos, length, dist);
+            Insert(pos);
+            if (length >= kMinMatch && length < kLazyLimit && pos + 1 < size_) {
+                size_t next_length = 0;
+                size_t next_dist = 0;
+                FindMatch(pos + 1, next_length, next_dist);
+                if (next_length > length) {
+                    length = 0;
+                }
+            }
+            if (length >= kMinMatch) {
+                symbols.push_back({static_cast<uint16_t>(length), static_cast<uint16_t>(dist)});
+                for (size_t k = 1; k < length; ++k) Insert(pos + k);
+                pos += length;
+            } else {
+                symbols.push_back({data_[pos], 0});
+                pos++;
+            }
+            if (symbols.size() >= kSymbolsPerBlock) {
+                WriteBlock(symbols, block_start, pos, pos == size_);
+                symbols.clear();
+                block_start = pos;
+            }
+        }
+        if (!symbols.empty() || size_ == 0) {
+            WriteBlock(symbols, block_start, pos, true);
+        }
+        writer_.Align();
+    }
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+    BitWriter writer_;
+    std::vector<int32_t> head_;
+    std::vector<int32_t> prev_;
+
+    uint32_t Hash(size_t pos) const {
+        uint32_t value = data_[pos] | (data_[pos + 1] << 8) | (data_[pos + 2] << 16);
+        return (value * 2654435761u) >> (32 - kHashBits);
+    }
+
+    void Insert(size_t pos) {
+        if (pos + kMinMatch > size_) return;
+        uint32_t hash = Hash(pos);
+        prev_[pos & (kWindowSize - 1)] = head_[hash];
+        head_[hash] = static_cast<int32_t>(pos);
+    }
+
+    void FindMatch(size_t pos, size_t& best_length, size_t& best_dist) const {
+        best_length = 0;
+        best_dist = 0;
+        if (pos + kMinMatch > size_) return;
+        size_t limit = std::min(kMaxMatch, size_ - pos);
+        int32_t candidate = head_[Hash(pos)];
+        for (int chain = 0; candidate >= 0 && chain < kMaxChain; ++chain) {
+            size_t from = static_cast<size_t>(candidate);
+            if (from >= pos || pos - from > kWindowSize) break;
+            if (data_[from + best_length] == data_[pos + best_length]) {
+                size_t length = 0;
+                while (length < limit && data_[from + length] == data_[pos + length]) length++;
+                if (length > best_length) {
+                    best_length = length;
+                    best_dist = pos - from;
+                    if (length >= kNiceMatch || length == limit) break;
+                }
+            }
+            int32_t next = prev_[from & (kWindowSize - 1)];
+            if (next >= candidate) break;
+            candidate = next;
+        }
+        if (best_length < kMinMatch) best_length = 0;
+    }
+
+    void WriteBlock(const std::vector<Symbol>& symbols, size_t start, size_t end, bool final) {
+        uint32_t litlen_freq[kLitLenCodes] = {0};
+        uint32_t dist_freq[kDistCodes] = {0};
+        for (const auto& symbol : symbols) {
+            if (symbol.dist == 0) {
+                litlen_freq[symbol.value]++;
+            } else {
+                litlen_freq[257 + LengthCode(symbol.value)]++;
+                dist_freq[DistCode(symbol.dist)]++;
+            }
+        }
+        litlen_freq[256] = 1;
+
+        // Fixed code cost
+        uint64_t fixed_bits = 3;
+        uint64_t extra_bits = 0;
+        for (int i = 0; i < kLitLenCodes; ++i) {
+            int length = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+            fixed_bits += static_cast<uint64_t>(litlen_freq[i]) * length;
+            if (i >= 257) extra_bits += static_cast<uint64_t>(litlen_freq[i]) * kLengthExtra[i - 257];
+        }
+        for (int i = 0; i < kDistCodes; ++i) {
+            fixed_bits += static_cast<uint64_t>(dist_freq[i]) * 5;
+            extra_bits += static_cast<uint64_t>(dist_freq[i]) * kDistExtra[i];
+        }
+        fixed_bits += extra_bits;
+
+        // Dynamic code cost
+        EnsureTwoSymbols(litlen_freq, kLitLenCodes);
+        EnsureTwoSymbols(dist_freq, kDistCodes);
+        uint8_t litlen_lengths[kLitLenCodes];
+        uint8_t dist_lengths[kDistCodes];
+        BuildLengths(litlen_freq, kLitLenCodes, kMaxBits, litlen_lengths);
+        BuildLengths(dist_freq, kDistCodes, kMaxBits, dist_lengths);
+        int hlit = kLitLenCodes;
+        while (hlit > 257 && litlen_lengths[hlit - 1] == 0) hlit--;
+        int hdist = kDistCodes;
+        while (hdist > 1 && dist_lengths[hdist - 1] == 0) hdist--;
+        std::vector<uint8_t> all_lengths(litlen_lengths, litlen_lengths + hlit);
+        all_lengths.insert(all_lengths.end(), dist_lengths, dist_lengths + hdist);
+        std::vector<CodeLengthToken> tokens = EncodeLengths(all_lengths);
+        uint32_t cl_freq[kCodeLengthCodes] = {0};
+        for (const auto& token : tokens) cl_freq[token.symbol]++;
+        EnsureTwoSymbols(cl_freq, kCodeLengthCodes);
+        uint8_t cl_lengths[kCodeLengthCodes];
+        BuildLengths(cl_freq, kCodeLengthCodes, 7, cl_lengths);
+        int hclen = kCodeLengthCodes;
+        while (hclen > 4 && cl_lengths[kCodeLengthOrder[hclen - 1]] == 0) hclen--;
+
+        uint64_t dynamic_bits = 3 + 5 + 5 + 4 + 3 * static_cast<uint64_t>(hclen) + extra_bits;
+        for (const auto& token : tokens) {
+            dynamic_bits += cl_lengths[token.symbol];
+            dynamic_bits += token.symbol == 16 ? 2 : token.symbol == 17 ? 3 : token.symbol == 18 ? 7 : 0;
+        }
+        for (int i = 0; i < kLitLenCodes; ++i) dynamic_bits += static_cast<uint64_t>(litlen_freq[i]) * litlen_lengths[i];
+        for (int i = 0; i < kDistCodes; ++i) dynamic_bits += static_cast<uint64_t>(dist_freq[i]) * dist_lengths[i];
+
+        size_t raw = end - start;
+        uint64_t stored_bits = (raw / 65535 + 1) * (3 + 7 + 32) + raw * 8;
+        if (stored_bits < fixed_bits && stored_bits < dynamic_bits) {
+            WriteStored(start, end, final);
+            return;
+        }
+
+        uint16_t litlen_codes[kLitLenCodes] = {0};
+        uint16_t dist_codes[kDistCodes] = {0};
+        if (fixed_bits <= dynamic_bits) {
+            writer_.Put(final ? 1 : 0, 1);
+            writer_.Put(1, 2);
+            for (int i = 0; i < kLitLenCodes; ++i) {
+                litlen_lengths[i] = static_cast<uint8_t>(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+            }
+            std::fill(dist_lengths, dist_lengths + kDistCodes, 5);
+        } else {
+            writer_.Put(final ? 1 : 0, 1);
+            writer_.Put(2, 2);
+            writer_.Put(static_cast<uint32_t>(hlit - 257), 5);
+            writer_.Put(static_cast<uint32_t>(hdist - 1), 5);
+            writer_.Put(static_cast<uint32_t>(hclen - 4), 4);
+            for (int i = 0; i < hclen; ++i) {
+                writer_.Put(cl_lengths[kCodeLengthOrder[i]], 3);
+            }
+            uint16_t cl_codes[kCodeLengthCodes] = {0};
+            BuildCodes(cl_lengths, kCodeLengthCodes, cl_codes);
+            for (const auto& token : tokens) {
+                writer_.Put(cl_codes[token.symbol], cl_lengths[token.symbol]);
+                if (token.symbol == 16) writer_.Put(token.extra, 2);
+                if (token.symbol == 17) writer_.Put(token.extra, 3);
+                if (token.symbol == 18) writer_.Put(token.extra, 7);
+            }
+        }
+        BuildCodes(litlen_lengths, kLitLenCodes, litlen_codes);
+        BuildCodes(dist_lengths, kDistCodes, dist_codes);
+
+        for (const auto& symbol : symbols) {
+            if (symbol.dist == 0) {
+                writer_.Put(litlen_codes[symbol.value], litlen_lengths[symbol.value]);
+                continue;
+            }
+            int length_code = LengthCode(symbol.value);
+            writer_.Put(litlen_codes[257 + length_code], litlen_lengths[257 + length_code]);
+            writer_.Put(symbol.value - kLengthBase[length_code], kLengthExtra[length_code]);
+            int dist_code = DistCode(symbol.dist);
+            writer_.Put(dist_codes[dist_code], dist_lengths[dist_code]);
+            writer_.Put(symbol.dist - kDistBase[dist_code], kDistExtra[dist_code]);
+        }
+        writer_.Put(litlen_codes[256], litlen_lengths[256]);
+    }
+
+    void WriteStored(size_t start, size_t end, bool final) {
+        do {
+            size_t length = std::min<size_t>(end - start, 65535);
+            bool last = final && start + length == end;
+            writer_.Put(last ? 1 : 0, 1);
+            writer_.Put(0, 2);
+            writer_.Align();
+            writer_.Put(static_cast<uint32_t>(length), 16);
+            writer_.Put(static_cast<uint32_t>(~length & 0xFFFF), 16);
+            for (size_t i = 0; i < length; ++i) {
+                writer_.Put(data_[start + i], 8);
+            }
+            start += length;
+        } while (start < end);
+    }
+};
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+struct Huffman {
+    uint16_t count[kMaxBits + 1];
+    uint16_t symbol[288];
+};
+
+// False when the lengths over-subscribe the code; incomplete codes are allowed
+bool BuildHuffman(Huffman& huffman, const uint8_t* lengths, int count) {
+    std::memset(huffman.count, 0, sizeof(huffman.count));
+    for (int i = 0; i < count; ++i) huffman.count[lengths[i]]++;
+    int left = 1;
+    for (int bits = 1; bits <= kMaxBits; ++bits) {
+        left <<= 1;
+        left -= huffman.count[bits];
+        if (left < 0) return false;
+    }
+    uint16_t offsets[kMaxBits + 1];
+    offsets[1] = 0;
+    for (int bits = 1; bits < kMaxBits; ++bits) {
+        offsets[bits + 1] = static_cast<uint16_t>(offsets[bits] + huffman.count[bits]);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (lengths[i] != 0) huffman.symbol[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+    }
+    return true;
+}
+
+class Decoder {
+public:
+    Decoder(const unsigned char* data, size_t size, std::string& out)
+        : data_(data), size_(size), pos_(0), bits_(0), count_(0), out_(out), start_(out.size()) {}
+
+    bool Run() {
+        if (size_ < 6) return false;
+        unsigned cmf = data_[0];
+        unsigned flg = data_[1];
+        if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+            return false;
+        }
+        pos_ = 2;
+        bool last = false;
+        while (!last) {
+            uint32_t header = 0;
+            if (!Bits(3, header)) return false;
+            last = header & 1;
+            switch (header >> 1) {
+                case 0: if (!Stored()) return false; break;
+                case 1: if (!Fixed()) return false; break;
+                case 2: if (!Dynamic()) return false; break;
+                default: return false;
+            }
+        }
+        // Adler-32 follows on the next byte boundary
+        count_ = 0;
+        bits_ = 0;
+        if (size_ - pos_ < 4) return false;
+        uint32_t expected = (static_cast<uint32_t>(data_[pos_]) << 24) | (data_[pos_ + 1] << 16) |
+                            (data_[pos_ + 2] << 8) | data_[pos_ + 3];
+        return expected == Deflate::Adler32(out_.data() + start_, out_.size() - start_);
+    }
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+    size_t pos_;
+    uint32_t bits_;
+    int count_;
+    std::string& out_;
+    size_t start_;
+
+    bool Bits(int needed, uint32_t& value) {
+        while (count_ < needed) {
+            if (pos_ >= size_) return false;
+            bits_ |= static_cast<uint32_t>(data_[pos_++]) << count_;
+            count_ += 8;
+        }
+        value = bits_ & ((1u << needed) - 1);
+        bits_ = needed == 32 ? 0 : bits_ >> needed;
+        count_ -= needed;
+        return true;
+    }
+
+    bool Decode(const Huffman& huffman, int& symbol) {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length <= kMaxBits; ++length) {
+            uint32_t bit = 0;
+            if (!Bits(1, bit)) return false;
+            code |= static_cast<int>(bit);
+            int count = huffman.count[length];
+            if (code - count < first) {
+                symbol = huffman.symbol[index + (code - first)];
+                return true;
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+        return false;
+    }
+
+    bool Stored() {
+        bits_ = 0;
+        count_ = 0;
+        if (size_ - pos_ < 4) return false;
+        unsigned length = data_[pos_] | (data_[pos_ + 1] << 8);
+        unsigned complement = data_[pos_ + 2] | (data_[pos_ + 3] << 8);
+        pos_ += 4;
+        if (length != (~complement & 0xFFFF) || size_ - pos_ < length) return false;
+        out_.append(reinterpret_cast<const char*>(data_ + pos_), length);
+        pos_ += length;
+        return true;
+    }
+
+    bool Codes(const Huffman& litlen, const Huffman& dist) {
+        for (;;) {
+            int symbol = 0;
+            if (!Decode(litlen, symbol)) return false;
+            if (symbol < 256) {
+                out_.push_back(static_cast<char>(symbol));
+                continue;
+            }
+            if (symbol == 256) return true;
+            symbol -= 257;
+            if (symbol >= 29) return false;
+            uint32_t extra = 0;
+            if (!Bits(kLengthExtra[symbol], extra)) return false;
+            size_t length = kLengthBase[symbol] + extra;
+            int dist_symbol = 0;
+            if (!Decode(dist, dist_symbol) || dist_symbol >= 30) return false;
+            if (!Bits(kDistExtra[dist_symbol], extra)) return false;
+            size_t distance = kDistBase[dist_symbol] + extra;
+            if (distance > out_.size() - start_) return false;
+            size_t from = out_.size() - distance;
+            for (size_t i = 0; i < length; ++i) {
+                out_.push_back(out_[from + i]);
+            }
+        }
+    }
+
+    bool Fixed() {
+        static Huffman litlen;
+        static Huffman dist;
+        static bool built = [] {
+            uint8_t lengths[288];
+            for (int i = 0; i < 288; ++i) lengths[i] = static_cast<uint8_t>(i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8);
+            BuildHuffman(litlen, lengths, 288);
+            std::fill(lengths, lengths + 30, 5);
+            BuildHuffman(dist, lengths, 30);
+            return true;
+        }();
+        (void)built;
+        return Codes(litlen, dist);
+    }
+
+    bool Dynamic() {
+        uint32_t hlit = 0, hdist = 0, hclen = 0;
+        if (!Bits(5, hlit) || !Bits(5, hdist) || !Bits(4, hclen)) return false;
+        hlit += 257;
+        hdist += 1;
+        hclen += 4;
+        if (hlit > 286 || hdist > 30) return false;
+
+        uint8_t lengths[320] = {0};
+        for (uint32_t i = 0; i < hclen; ++i) {
+            uint32_t length = 0;
+            if (!Bits(3, length)) return false;
+            lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(length);
+        }
+        Huffman code_lengths;
+        if (!BuildHuffman(code_lengths, lengths, kCodeLengthCodes)) return false;
+
+        std::memset(lengths, 0, sizeof(lengths));
+        uint32_t index = 0;
+        while (index < hlit + hdist) {
+            int symbol = 0;
+            if (!Decode(code_lengths, symbol)) return false;
+            if (symbol < 16) {
+                lengths[index++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            uint8_t value = 0;
+            uint32_t repeat = 0;
+            if (symbol == 16) {
+                if (index == 0 || !Bits(2, repeat)) return false;
+                value = lengths[index - 1];
+                repeat += 3;
+            } else if (symbol == 17) {
+                if (!Bits(3, repeat)) return false;
+                repeat += 3;
+            } else {
+                if (!Bits(7, repeat)) return false;
+                repeat += 11;
+            }
+            if (index + repeat > hlit + hdist) return false;
+            while (repeat--) lengths[index++] = value;
+        }
+        if (lengths[256] == 0) return false;
+
+        Huffman litlen;
+        Huffman dist;
+        if (!BuildHuffman(litlen, lengths, static_cast<int>(hlit)) ||
+            !BuildHuffman(dist, lengths + hlit, static_cast<int>(hdist))) {
+            return false;
+        }
+        return Codes(litlen, dist);
+    }
+};
+
+} // namespace
+
+void Deflate::Compress(const char* data, size_t size, std::string& out) {
+    // CMF: deflate, 32 KiB window; FLG: default level, no dictionary
+    out.push_back(static_cast<char>(0x78));
+    out.push_back(static_cast<char>(0x9C));
+    Encoder encoder(reinterpret_cast<const unsigned char*>(data), size, out);
+    encoder.Run();
+    uint32_t adler = Adler32(data, size);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((adler >> shift) & 0xFF));
+    }
+}
+
+std::string Deflate::Compress(const std::string& data) {
+    std::string out;
+    Compress(data.data(), data.size(), out);
+    return out;
+}
+
+bool Deflate::Decompress(const char* data, size_t size, std::string& out) {
+    size_t original = out.size();
+    Decoder decoder(reinterpret_cast<const unsigned char*>(data), size, out);
+    if (!decoder.Run()) {
+        out.resize(original);
+        return false;
+    }
+    return true;
+}
+
+bool Deflate::Decompress(const std::string& data, std::string& out) {
+    return Decompress(data.data(), data.size(), out);
+}
+
+uint32_t Deflate::Adler32(const char* data, size_t size, uint32_t adler) {
+    const uint32_t kModulus = 65521;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    while (size > 0) {
+        // 5552 bytes is the most that cannot overflow b before the modulus
+        size_t chunk = std::min<size_t>(size, 5552);
+        size -= chunk;
+        while (chunk--) {
+            a += *bytes++;
+            b += a;
+        }
+        a %= kModulus;
+        b %= kModulus;
+    }
+    return (b << 16) | a;
+}
+
+} // namespace utils
+} // namespace esp32_ide
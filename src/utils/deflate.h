@@ -0,0 +1,39 @@
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief zlib-format deflate codec (RFC 1950/1951)
+ *
+ * The ESP bootloaders inflate flash data themselves, so unlike LzCodec
+ * this has to produce the standard format. The encoder does LZ77 over a
+ * 32 KiB window with hash chains and one step of lazy matching, then
+ * writes each run of symbols as a dynamic, fixed or stored block,
+ * whichever is smallest. Ratios land close to zlib's default level.
+ *
+ * The decoder accepts any valid zlib stream and checks the Adler-32
+ * trailer; it exists for tests and tooling, devices do their own.
+ */
+class Deflate {
+public:
+    // Appends a complete zlib stream to `out`
+    static void Compress(const char* data, size_t size, std::string& out);
+    static std::string Compress(const std::string& data);
+
+    // Appends the decoded bytes to `out`; false on corrupt input
+    static bool Decompress(const char* data, size_t size, std::string& out);
+    static bool Decompress(const std::string& data, std::string& out);
+
+    static uint32_t Adler32(const char* data, size_t size, uint32_t adler = 1);
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // DEFLATE_H
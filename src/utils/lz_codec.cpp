@@ -0,0 +1,177 @@
+#include "utils/lz_codec.h"
+#include <cstring>
+#include <cstdint>
+#include <vector>
+
+namespace esp32_ide {
+namespace utils {
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 13;
+// The last bytes are always emitted as literals, which keeps the match
+// search free of end-of-buffer checks on the 4-byte reads.
+constexpr size_t kLastLiterals = 5;
+
+inline uint32_t Read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t HashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+inline void WriteLength(std::string& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+inline void EmitSequence(std::string& out, const unsigned char* literals, size_t literal_length,
+                         size_t offset, size_t match_length) {
+    size_t match_code = match_length >= kMinMatch ? match_length - kMinMatch : 0;
+    unsigned char token = static_cast<unsigned char>(
+        ((literal_length < 15 ? literal_length : 15) << 4) | (match_code < 15 ? match_code : 15));
+    out.push_back(static_cast<char>(token));
+    if (literal_length >= 15) WriteLength(out, literal_length - 15);
+    out.append(reinterpret_cast<const char*>(literals), literal_length);
+
+    if (match_length == 0) return;  // final, literal-only sequence
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15) WriteLength(out, match_code - 15);
+}
+
+inline bool ReadLength(const unsigned char*& ip, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (ip >= end) return false;
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+void LzCodec::Compress(const char* data, size_t size, std::string& out) {
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(data);
+    out.reserve(out.size() + MaxCompressedSize(size));
+
+    size_t anchor = 0;
+    if (size > kMinMatch + kLastLiterals) {
+        thread_local std::vector<uint32_t> table;
+        table.assign(size_t(1) << kHashBits, 0);
+
+        const size_t match_limit = size - kLastLiterals;
+        size_t pos = 1;
+        size_t misses = 0;
+        table[HashSequence(Read32(src))] = 0;
+
+        while (pos + kMinMatch <= match_limit) {
+            uint32_t sequence = Read32(src + pos);
+            uint32_t& slot = table[HashSequence(sequence)];
+            size_t candidate = slot;
+            slot = static_cast<uint32_t>(pos);
+
+            if (candidate >= pos || pos - candidate > kMaxOffset || Read32(src + candidate) != sequence) {
+                // Skip faster through incompressible data
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            // Extend backwards into pending literals, then forwards
+            while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+                --pos;
+                --candidate;
+            }
+            size_t length = kMinMatch;
+            while (pos + length < match_limit && src[pos + length] == src[candidate + length]) {
+                ++length;
+            }
+
+            EmitSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+            pos += length;
+            anchor = pos;
+
+            // Seed the table with a position inside the match for the next search
+            table[HashSequence(Read32(src + pos - 2))] = static_cast<uint32_t>(pos - 2);
+        }
+    }
+
+    EmitSequence(out, src + anchor, size - anchor, 0, 0);
+}
+
+std::string LzCodec::Compress(const std::string& data) {
+    std::string out;
+    Compress(data.data(), data.size(), out);
+    return out;
+}
+
+bool LzCodec::Decompress(const char* data, size_t compressed_size, char* out, size_t size) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* const ip_end = ip + compressed_size;
+    unsigned char* op = reinterpret_cast<unsigned char*>(out);
+    unsigned char* const op_start = op;
+    unsigned char* const op_end = op + size;
+
+    while (ip < ip_end) {
+        unsigned char token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !ReadLength(ip, ip_end, literal_length)) return false;
+        if (literal_length > static_cast<size_t>(ip_end - ip) ||
+            literal_length > static_cast<size_t>(op_end - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip == ip_end) break;  // final sequence
+
+        if (ip_end - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        size_t match_length = token & 0x0F;
+        if (match_length == 15 && !ReadLength(ip, ip_end, match_length)) return false;
+        match_length += kMinMatch;
+
+        if (offset == 0 || offset > static_cast<size_t>(op - op_start) ||
+            match_length > static_cast<size_t>(op_end - op)) {
+            return false;
+        }
+
+        const unsigned char* match = op - offset;
+        if (offset >= match_length) {
+            std::memcpy(op, match, match_length);
+            op += match_length;
+        } else {
+            // Overlapping copy replicates the last `offset` bytes
+            for (size_t i = 0; i < match_length; ++i) {
+                *op++ = *match++;
+            }
+        }
+    }
+
+    return op == op_end;
+}
+
+bool LzCodec::Decompress(const std::string& data, size_t size, std::string& out) {
+    out.resize(size);
+    if (!Decompress(data.data(), data.size(), &out[0], size)) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace utils
+} // namespace esp32_ide
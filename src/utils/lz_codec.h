@@ -0,0 +1,37 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <string>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Small, fast LZ77 block codec (LZ4-style byte-aligned sequences)
+ *
+ * Tuned for speed over ratio: a single-probe hash table and no entropy
+ * stage, so source text compresses roughly 2-4x at several hundred MB/s.
+ * Blocks carry no header; callers store the decompressed size themselves.
+ *
+ * Sequence layout: token (literal length << 4 | match length - 4), extra
+ * literal length bytes, literals, 2-byte little-endian offset, extra match
+ * length bytes. The final sequence holds literals only.
+ */
+class LzCodec {
+public:
+    // Appends the compressed block to `out`
+    static void Compress(const char* data, size_t size, std::string& out);
+    static std::string Compress(const std::string& data);
+
+    // Decodes exactly `size` bytes into `out`; false on corrupt input
+    static bool Decompress(const char* data, size_t compressed_size, char* out, size_t size);
+    static bool Decompress(const std::string& data, size_t size, std::string& out);
+
+    static size_t MaxCompressedSize(size_t size) { return size + size / 255 + 16; }
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // LZ_CODEC_H
@@ -0,0 +1,110 @@
+#include "utils/mapped_file.h"
+#include <fstream>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace esp32_ide {
+namespace utils {
+
+MappedFile::MappedFile()
+    : data_(nullptr), size_(0), is_open_(false), is_mapped_(false) {
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(nullptr), size_(0), is_open_(false), is_mapped_(false) {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        data_ = other.data_;
+        size_ = other.size_;
+        is_open_ = other.is_open_;
+        is_mapped_ = other.is_mapped_;
+        path_ = std::move(other.path_);
+        fallback_buffer_ = std::move(other.fallback_buffer_);
+        if (!is_mapped_ && !fallback_buffer_.empty()) {
+            data_ = fallback_buffer_.data();
+        }
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.is_open_ = false;
+        other.is_mapped_ = false;
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<const unsigned char*>(addr);
+        is_mapped_ = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    size_ = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    fallback_buffer_.resize(size_);
+    if (size_ > 0) {
+        file.read(reinterpret_cast<char*>(fallback_buffer_.data()), size_);
+        data_ = fallback_buffer_.data();
+    }
+#endif
+
+    path_ = path;
+    is_open_ = true;
+    return true;
+}
+
+void MappedFile::Close() {
+#ifndef _WIN32
+    if (is_mapped_ && data_) {
+        ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    is_open_ = false;
+    is_mapped_ = false;
+    path_.clear();
+    fallback_buffer_.clear();
+}
+
+} // namespace utils
+} // namespace esp32_ide
@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Read-only memory-mapped view of a file
+ *
+ * Uses mmap on POSIX systems. On platforms without mmap support the
+ * file is read into an owned buffer so callers see the same interface.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    bool IsOpen() const { return is_open_; }
+    const unsigned char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    const std::string& GetPath() const { return path_; }
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+    bool is_open_;
+    bool is_mapped_;
+    std::string path_;
+    std::vector<unsigned char> fallback_buffer_;
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,140 @@
+#include "utils/md5.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp32_ide {
+namespace utils {
+
+namespace {
+
+const uint32_t kSines[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+const int kShifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+inline uint32_t RotateLeft(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+} // namespace
+
+Md5::Md5() {
+    Reset();
+}
+
+void Md5::Reset() {
+    state_[0] = 0x67452301;
+    state_[1] = 0xefcdab89;
+    state_[2] = 0x98badcfe;
+    state_[3] = 0x10325476;
+    length_ = 0;
+    buffered_ = 0;
+}
+
+void Md5::Transform(const unsigned char* block) {
+    uint32_t words[16];
+    for (int i = 0; i < 16; ++i) {
+        words[i] = static_cast<uint32_t>(block[i * 4]) | (static_cast<uint32_t>(block[i * 4 + 1]) << 8) |
+                   (static_cast<uint32_t>(block[i * 4 + 2]) << 16) | (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+    }
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t f;
+        int g;
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            g = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            g = (5 * i + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            g = (3 * i + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            g = (7 * i) % 16;
+        }
+        uint32_t next = d;
+        d = c;
+        c = b;
+        b = b + RotateLeft(a + f + kSines[i] + words[g], kShifts[i]);
+        a = next;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+}
+
+void Md5::Update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    length_ += size;
+    if (buffered_ > 0) {
+        size_t take = std::min(size, sizeof(buffer_) - buffered_);
+        std::memcpy(buffer_ + buffered_, bytes, take);
+        buffered_ += take;
+        bytes += take;
+        size -= take;
+        if (buffered_ < sizeof(buffer_)) return;
+        Transform(buffer_);
+        buffered_ = 0;
+    }
+    while (size >= 64) {
+        Transform(bytes);
+        bytes += 64;
+        size -= 64;
+    }
+    std::memcpy(buffer_, bytes, size);
+    buffered_ = size;
+}
+
+std::string Md5::Finish() {
+    uint64_t bits = length_ * 8;
+    unsigned char padding[72] = {0x80};
+    size_t pad = (buffered_ < 56 ? 56 : 120) - buffered_;
+    Update(padding, pad);
+    unsigned char length[8];
+    for (int i = 0; i < 8; ++i) {
+        length[i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+    Update(length, sizeof(length));
+
+    std::string digest(16, '\0');
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            digest[i * 4 + j] = static_cast<char>((state_[i] >> (8 * j)) & 0xFF);
+        }
+    }
+    return digest;
+}
+
+std::string Md5::Digest(const void* data, size_t size) {
+    Md5 md5;
+    md5.Update(data, size);
+    return md5.Finish();
+}
+
+std::string Md5::ToHex(const std::string& digest) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (unsigned char c : digest) {
+        hex.push_back(digits[c >> 4]);
+        hex.push_back(digits[c & 0xF]);
+    }
+    return hex;
+}
+
+} // namespace utils
+} // namespace esp32_ide
@@ -0,0 +1,41 @@
+#ifndef MD5_H
+#define MD5_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Incremental MD5 (RFC 1321)
+ *
+ * Only for matching what devices report, e.g. the ESP bootloader's flash
+ * checksums; not for anything security related.
+ */
+class Md5 {
+public:
+    Md5();
+
+    void Update(const void* data, size_t size);
+    // 16 raw bytes; the object must be reset before reuse
+    std::string Finish();
+    void Reset();
+
+    static std::string Digest(const void* data, size_t size);
+    static std::string ToHex(const std::string& digest);
+
+private:
+    uint32_t state_[4];
+    uint64_t length_;
+    unsigned char buffer_[64];
+    size_t buffered_;
+
+    void Transform(const unsigned char* block);
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // MD5_H
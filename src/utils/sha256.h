@@ -0,0 +1,40 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Incremental SHA-256 (FIPS 180-4)
+ *
+ * For the digest ESP app images carry after their checksum, which the
+ * second-stage bootloader checks before booting the app.
+ */
+class Sha256 {
+public:
+    Sha256();
+
+    void Update(const void* data, size_t size);
+    // 32 raw bytes; the object must be reset before reuse
+    std::string Finish();
+    void Reset();
+
+    static std::string Digest(const void* data, size_t size);
+
+private:
+    uint32_t state_[8];
+    uint64_t length_;
+    unsigned char buffer_[64];
+    size_t buffered_;
+
+    void Transform(const unsigned char* block);
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // SHA256_H
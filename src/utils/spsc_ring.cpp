@@ -0,0 +1,78 @@
+#include "utils/spsc_ring.h"
+#include <algorithm>
+#include <cstring>
+
+namespace esp32_ide {
+namespace utils {
+
+SpscRing::SpscRing(size_t capacity) : head_(0), cached_tail_(0), tail_(0), cached_head_(0) {
+    size_t rounded = 64;
+    while (rounded < capacity) rounded <<= 1;
+    buffer_.reset(new char[rounded]);
+    mask_ = rounded - 1;
+}
+
+size_t SpscRing::Size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+}
+
+char* SpscRing::WriteSpan(size_t& size) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ == Capacity()) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+    }
+    size_t free = Capacity() - (head - cached_tail_);
+    size_t offset = head & mask_;
+    size = std::min(free, Capacity() - offset);
+    return buffer_.get() + offset;
+}
+
+void SpscRing::Commit(size_t size) {
+    head_.store(head_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t SpscRing::Write(const char* data, size_t size) {
+    size_t written = 0;
+    // At most two spans: up to the wrap point, then from the start
+    for (int pass = 0; pass < 2 && written < size; ++pass) {
+        size_t span;
+        char* out = WriteSpan(span);
+        span = std::min(span, size - written);
+        if (span == 0) break;
+        std::memcpy(out, data + written, span);
+        Commit(span);
+        written += span;
+    }
+    return written;
+}
+
+const char* SpscRing::ReadSpan(size_t& size) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (cached_head_ == tail) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+    }
+    size_t offset = tail & mask_;
+    size = std::min(cached_head_ - tail, Capacity() - offset);
+    return buffer_.get() + offset;
+}
+
+void SpscRing::Consume(size_t size) {
+    tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+}
+
+size_t SpscRing::Read(char* out, size_t size) {
+    size_t read = 0;
+    for (int pass = 0; pass < 2 && read < size; ++pass) {
+        size_t span;
+        const char* in = ReadSpan(span);
+        span = std::min(span, size - read);
+        if (span == 0) break;
+        std::memcpy(out + read, in, span);
+        Consume(span);
+        read += span;
+    }
+    return read;
+}
+
+} // namespace utils
+} // namespace esp32_ide
@@ -0,0 +1,61 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace esp32_ide {
+namespace utils {
+
+/**
+ * @brief Lock-free single-producer, single-consumer byte ring
+ *
+ * One thread writes, one thread reads; neither ever blocks or takes a lock.
+ * The capacity is rounded up to a power of two and the head and tail
+ * counters run freely, so full and empty need no spare slot. Each side
+ * caches the other's counter and only reloads it when it seems to have
+ * run out, keeping cache-line traffic between the cores low.
+ *
+ * Besides copying Write()/Read(), each side can work in place: the
+ * producer read(2)s straight into WriteSpan() and Commit()s, the consumer
+ * parses ReadSpan() and Consume()s.
+ */
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity);
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t Capacity() const { return mask_ + 1; }
+    // Approximate from either side; exact from the other one when it is idle
+    size_t Size() const;
+
+    // Producer side. Returns the bytes taken, fewer when the ring fills up
+    size_t Write(const char* data, size_t size);
+    // Contiguous free space (up to the wrap point); its length goes to `size`
+    char* WriteSpan(size_t& size);
+    void Commit(size_t size);
+
+    // Consumer side. Returns the bytes copied out
+    size_t Read(char* out, size_t size);
+    // Contiguous readable bytes (up to the wrap point)
+    const char* ReadSpan(size_t& size);
+    void Consume(size_t size);
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    size_t mask_;
+
+    // Producer and consumer state on separate cache lines
+    alignas(64) std::atomic<size_t> head_;      // written by the producer
+    size_t cached_tail_;
+    alignas(64) std::atomic<size_t> tail_;      // written by the consumer
+    size_t cached_head_;
+};
+
+} // namespace utils
+} // namespace esp32_ide
+
+#endif // SPSC_RING_H
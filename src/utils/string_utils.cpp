@@ -1,6 +1,7 @@
 #include "utils/string_utils.h"
 #include <algorithm>
 #include <cctype>
+#include <iomanip>
 #include <sstream>
 
 namespace esp32_ide {
@@ -100,5 +101,37 @@ std::string StringUtils::ReplaceAll(const std::string& str, const std::string& f
     return result;
 }
 
+std::string StringUtils::FormatTable(const std::vector<std::string>& headers,
+                                     const std::vector<std::vector<std::string>>& rows) {
+    std::vector<size_t> widths(headers.size());
+    for (size_t i = 0; i < headers.size(); ++i) {
+        widths[i] = headers[i].size();
+        for (const auto& row : rows) {
+            if (i < row.size()) widths[i] = std::max(widths[i], row[i].size());
+        }
+    }
+    std::ostringstream oss;
+    auto print_row = [&](const std::vector<std::string>& row) {
+        for (size_t i = 0; i < row.size() && i < widths.size(); ++i) {
+            oss << std::left << std::setw(static_cast<int>(widths[i] + 2)) << row[i];
+        }
+        oss << "\n";
+    };
+    print_row(headers);
+    size_t total_width = 0;
+    for (size_t width : widths) total_width += width + 2;
+    oss << std::string(total_width, '-') << "\n";
+    for (const auto& row : rows) {
+        print_row(row);
+    }
+    return oss.str();
+}
+
+std::string StringUtils::FormatSeconds(long long milliseconds) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << milliseconds / 1000.0 << "s";
+    return oss.str();
+}
+
 } // namespace utils
 } // namespace esp32_ide
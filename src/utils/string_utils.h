@@ -33,6 +33,13 @@ public:
     // String replacement
     static std::string Replace(const std::string& str, const std::string& from, const std::string& to);
     static std::string ReplaceAll(const std::string& str, const std::string& from, const std::string& to);
+    
+    // Report formatting
+    // Left-aligned columns under a header row and a rule, one line per row
+    static std::string FormatTable(const std::vector<std::string>& headers,
+                                   const std::vector<std::vector<std::string>>& rows);
+    // "12.3s"
+    static std::string FormatSeconds(long long milliseconds);
 };
 
 } // namespace utils
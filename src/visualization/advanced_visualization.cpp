@@ -74,6 +74,25 @@ void SignalAnalyzer::AddSample(int channel_id, const SignalSample& sample) {
     }
 }
 
+void SignalAnalyzer::AddSamples(int channel_id, const double* timestamps_us, const double* values, size_t count) {
+    if (!capturing_) return;
+    
+    auto it = samples_.find(channel_id);
+    if (it == samples_.end()) return;
+    
+    std::vector<SignalSample>& samples = it->second;
+    auto cb_it = callbacks_.find(channel_id);
+    bool notify = cb_it != callbacks_.end() && cb_it->second;
+    for (size_t i = 0; i < count; ++i) {
+        SignalSample sample;
+        sample.timestamp_us = timestamps_us[i];
+        sample.value = values[i];
+        sample.is_digital_high = values[i] > trigger_level_;
+        samples.push_back(sample);
+        if (notify) cb_it->second(sample);
+    }
+}
+
 std::vector<SignalSample> SignalAnalyzer::GetSamples(int channel_id, 
                                                        double start_time, 
                                                        double end_time) const {
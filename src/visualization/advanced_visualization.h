@@ -100,6 +100,8 @@ public:
     void StopCapture();
     bool IsCapturing() const { return capturing_; }
     void AddSample(int channel_id, const SignalSample& sample);
+    /** @brief Appends parallel arrays, e.g. decoded telemetry columns; values above the trigger level count as high */
+    void AddSamples(int channel_id, const double* timestamps_us, const double* values, size_t count);
     std::vector<SignalSample> GetSamples(int channel_id, double start_time, double end_time) const;
     void ClearSamples(int channel_id);
     
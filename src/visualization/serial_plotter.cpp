@@ -0,0 +1,363 @@
+#include "visualization/serial_plotter.h"
+#include "serial/telemetry_decoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace esp32_ide {
+namespace visualization {
+
+namespace {
+
+const renderer::Color kPalette[] = {
+    renderer::Color(31, 119, 180),  renderer::Color(255, 127, 14), renderer::Color(44, 160, 44),
+    renderer::Color(214, 39, 40),   renderer::Color(148, 103, 189), renderer::Color(140, 86, 75),
+    renderer::Color(227, 119, 194), renderer::Color(127, 127, 127), renderer::Color(188, 189, 34),
+    renderer::Color(23, 190, 207),
+};
+
+uint64_t RoundUpPowerOfTwo(size_t value) {
+    uint64_t rounded = 1;
+    while (rounded < value) rounded <<= 1;
+    return rounded;
+}
+
+// Ring entries allocated on a series' first sample, per level
+const size_t kInitialEntries = 256;
+
+bool IsSeparator(char c) {
+    return c == ' ' || c == ',' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+SerialPlotter::SerialPlotter() : SerialPlotter(GetDefaultOptions()) {
+}
+
+SerialPlotter::SerialPlotter(const Options& options) : options_(options) {
+    options_.decimation = std::max<size_t>(options_.decimation, 2);
+    // Every level must hold a few entries of the next, so that a range
+    // evicted from one is always still covered by the next
+    options_.capacity = std::max(options_.capacity, 4 * options_.decimation);
+    options_.level_capacity = std::max(options_.level_capacity, 4 * options_.decimation);
+    spans_.push_back(1);
+    for (size_t level = 0; level < options_.levels; ++level) {
+        spans_.push_back(spans_.back() * options_.decimation);
+    }
+}
+
+SerialPlotter::Options SerialPlotter::GetDefaultOptions() {
+    Options options;
+    options.capacity = 1 << 20;
+    options.decimation = 8;
+    options.levels = 4;
+    options.level_capacity = 1 << 17;
+    options.max_series = 16;
+    return options;
+}
+
+int SerialPlotter::AddSeries(const std::string& name) {
+    int existing = FindSeries(name);
+    if (existing >= 0) {
+        return existing;
+    }
+    if (series_.size() >= options_.max_series) {
+        return -1;
+    }
+    Series series;
+    series.name = name;
+    series.color = kPalette[series_.size() % (sizeof(kPalette) / sizeof(kPalette[0]))];
+    series.levels.resize(spans_.size());
+    for (size_t i = 0; i < series.levels.size(); ++i) {
+        Level& level = series.levels[i];
+        level.mask = RoundUpPowerOfTwo(i == 0 ? options_.capacity : options_.level_capacity) - 1;
+        level.count = 0;
+        level.pending = 0;
+        level.pending_min = 0;
+        level.pending_max = 0;
+    }
+    series_.push_back(std::move(series));
+    return static_cast<int>(series_.size() - 1);
+}
+
+int SerialPlotter::FindSeries(const std::string& name) const {
+    for (size_t i = 0; i < series_.size(); ++i) {
+        if (series_[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void SerialPlotter::Clear() {
+    series_.clear();
+    positional_.clear();
+}
+
+// ============================================================================
+// Input
+// ============================================================================
+
+size_t SerialPlotter::AddLine(const std::string& line) {
+    size_t added = 0;
+    size_t position = 0;
+    const char* p = line.c_str();
+    const char* end = p + line.size();
+    while (p < end) {
+        while (p < end && IsSeparator(*p)) p++;
+        const char* token = p;
+        while (p < end && !IsSeparator(*p)) p++;
+        if (token == p) break;
+
+        const char* colon = std::find(token, p, ':');
+        const char* number = colon == p ? token : colon + 1;
+        char* parsed = nullptr;
+        double value = std::strtod(number, &parsed);
+        if (number == p || parsed != p) {
+            continue;
+        }
+
+        int series;
+        if (colon == p) {
+            if (position == positional_.size()) {
+                int added_series = AddSeries("value " + std::to_string(position + 1));
+                if (added_series < 0) continue;
+                positional_.push_back(added_series);
+            }
+            series = positional_[position++];
+        } else {
+            series = -1;
+            size_t length = static_cast<size_t>(colon - token);
+            for (size_t i = 0; i < series_.size() && series < 0; ++i) {
+                if (series_[i].name.compare(0, std::string::npos, token, length) == 0) series = static_cast<int>(i);
+            }
+            if (series < 0) series = AddSeries(std::string(token, length));
+            if (series < 0) continue;
+        }
+        Append(series_[series], static_cast<float>(value));
+        added++;
+    }
+    return added;
+}
+
+size_t SerialPlotter::AddColumns(const TelemetryDecoder& decoder) {
+    const std::vector<FrameLayout::Field>& fields = decoder.GetLayout().GetFields();
+    size_t added = 0;
+    for (size_t field = 0; field < fields.size(); ++field) {
+        int series = AddSeries(fields[field].name);
+        if (series < 0) continue;
+        AddSamples(series, decoder.GetColumn(field), decoder.GetRowCount());
+        added += decoder.GetRowCount();
+    }
+    return added;
+}
+
+void SerialPlotter::AddSample(int series, double value) {
+    Append(series_[series], static_cast<float>(value));
+}
+
+void SerialPlotter::AddSamples(int series, const double* values, size_t count) {
+    Series& target = series_[series];
+    for (size_t i = 0; i < count; ++i) {
+        Append(target, static_cast<float>(values[i]));
+    }
+}
+
+void SerialPlotter::Append(Series& series, float value) {
+    Level& samples = series.levels[0];
+    if ((samples.count & samples.mask) >= samples.min.size()) {
+        Grow(samples, false);
+    }
+    samples.min[samples.count & samples.mask] = value;
+    samples.count++;
+
+    // Carry the summary up while entries complete, decimation^-k of the time
+    float min = value;
+    float max = value;
+    for (size_t i = 1; i < series.levels.size(); ++i) {
+        Level& level = series.levels[i];
+        if (level.pending == 0) {
+            level.pending_min = min;
+            level.pending_max = max;
+        } else {
+            level.pending_min = std::min(level.pending_min, min);
+            level.pending_max = std::max(level.pending_max, max);
+        }
+        if (++level.pending < options_.decimation) {
+            break;
+        }
+        min = level.pending_min;
+        max = level.pending_max;
+        if ((level.count & level.mask) >= level.min.size()) {
+            Grow(level, true);
+        }
+        level.min[level.count & level.mask] = min;
+        level.max[level.count & level.mask] = max;
+        level.count++;
+        level.pending = 0;
+    }
+}
+
+void SerialPlotter::Grow(Level& level, bool summary) {
+    // Only reached before the ring first wraps, while slots are still
+    // written in order, so doubling keeps every written entry in place
+    size_t size = std::min<size_t>(level.mask + 1, std::max(kInitialEntries, level.min.size() * 2));
+    level.min.resize(size);
+    if (summary) level.max.resize(size);
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+uint64_t SerialPlotter::GetSampleCount(int series) const {
+    return series_[series].levels[0].count;
+}
+
+uint64_t SerialPlotter::GetEndIndex() const {
+    uint64_t end = 0;
+    for (const Series& series : series_) {
+        end = std::max(end, series.levels[0].count);
+    }
+    return end;
+}
+
+uint64_t SerialPlotter::GetFirstIndex(int series) const {
+    const std::vector<Level>& levels = series_[series].levels;
+    uint64_t first = levels[0].count;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        uint64_t capacity = levels[i].mask + 1;
+        uint64_t oldest = levels[i].count > capacity ? levels[i].count - capacity : 0;
+        first = std::min(first, oldest * spans_[i]);
+    }
+    return first;
+}
+
+void SerialPlotter::Scan(const Series& series, size_t level, uint64_t lo, uint64_t hi, float& min,
+                         float& max) const {
+    if (lo >= hi) {
+        return;
+    }
+    const Level& entries = series.levels[level];
+    uint64_t span = spans_[level];
+    uint64_t capacity = entries.mask + 1;
+    uint64_t oldest = entries.count > capacity ? entries.count - capacity : 0;
+    uint64_t first = lo / span;
+    uint64_t end = std::min((hi + span - 1) / span, entries.count);
+
+    // Evicted here: the coarser level still has it
+    if (first < oldest) {
+        if (level + 1 < series.levels.size()) {
+            Scan(series, level + 1, lo, std::min(hi, oldest * span), min, max);
+        }
+        first = oldest;
+    }
+    const std::vector<float>& maxs = level == 0 ? entries.min : entries.max;
+    for (uint64_t i = first; i < end; ++i) {
+        min = std::min(min, entries.min[i & entries.mask]);
+        max = std::max(max, maxs[i & entries.mask]);
+    }
+    // Not summarised here yet: the finer level has it
+    if (level > 0 && end * span < hi) {
+        Scan(series, level - 1, std::max(lo, end * span), hi, min, max);
+    }
+}
+
+void SerialPlotter::GetEnvelope(int series, uint64_t first, uint64_t end, size_t columns, float* mins,
+                                float* maxs) const {
+    if (columns == 0) {
+        return;
+    }
+    const Series& target = series_[series];
+    uint64_t width = end > first ? end - first : 0;
+    // The coarsest level whose entries are no wider than a column
+    size_t level = 0;
+    while (level + 1 < spans_.size() && spans_[level + 1] * columns <= width) {
+        level++;
+    }
+    for (size_t column = 0; column < columns; ++column) {
+        uint64_t lo = first + width * column / columns;
+        uint64_t hi = std::max(first + width * (column + 1) / columns, lo + 1);
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+        Scan(target, level, lo, hi, min, max);
+        if (min > max) {
+            min = max = std::numeric_limits<float>::quiet_NaN();
+        }
+        mins[column] = min;
+        maxs[column] = max;
+    }
+}
+
+// ============================================================================
+// Rendering
+// ============================================================================
+
+void SerialPlotter::Render(renderer::PureCRenderer& renderer, int x, int y, int width, int height, uint64_t first,
+                           uint64_t end) const {
+    if (width <= 0 || height <= 1 || end <= first || series_.empty()) {
+        return;
+    }
+    size_t columns = static_cast<size_t>(width);
+    mins_.resize(series_.size() * columns);
+    maxs_.resize(series_.size() * columns);
+    float low = std::numeric_limits<float>::infinity();
+    float high = -std::numeric_limits<float>::infinity();
+    for (size_t s = 0; s < series_.size(); ++s) {
+        float* mins = &mins_[s * columns];
+        float* maxs = &maxs_[s * columns];
+        GetEnvelope(static_cast<int>(s), first, end, columns, mins, maxs);
+        for (size_t c = 0; c < columns; ++c) {
+            if (std::isnan(mins[c]) || std::isinf(mins[c]) || std::isinf(maxs[c])) continue;
+            low = std::min(low, mins[c]);
+            high = std::max(high, maxs[c]);
+        }
+    }
+    if (low > high) {
+        return;
+    }
+    if (high - low < 1e-6f) {
+        low -= 1;
+        high += 1;
+    }
+    float scale = (height - 1) / (high - low);
+    auto to_row = [&](float value) {
+        float clamped = std::min(std::max(value, low), high);
+        return y + (height - 1) - static_cast<int>(std::lround((clamped - low) * scale));
+    };
+
+    if (low < 0 && high > 0) {
+        renderer.DrawLine2D(x, to_row(0), x + width - 1, to_row(0), renderer::Color(64, 64, 64));
+    }
+    for (size_t s = 0; s < series_.size(); ++s) {
+        const float* mins = &mins_[s * columns];
+        const float* maxs = &maxs_[s * columns];
+        bool previous = false;
+        int previous_top = 0;
+        int previous_bottom = 0;
+        for (size_t c = 0; c < columns; ++c) {
+            if (std::isnan(mins[c])) {
+                previous = false;
+                continue;
+            }
+            int top = to_row(maxs[c]);
+            int bottom = to_row(mins[c]);
+            // Join the previous column so steep edges stay connected
+            int drawn_top = previous ? std::min(top, previous_bottom) : top;
+            int drawn_bottom = previous ? std::max(bottom, previous_top) : bottom;
+            renderer.DrawVerticalLine(x + static_cast<int>(c), drawn_top, drawn_bottom, series_[s].color);
+            previous = true;
+            previous_top = top;
+            previous_bottom = bottom;
+        }
+        renderer.DrawText(x + 4, y + 4 + static_cast<int>(s) * 10, series_[s].name, series_[s].color);
+    }
+}
+
+void SerialPlotter::RenderLatest(renderer::PureCRenderer& renderer, int x, int y, int width, int height,
+                                 uint64_t span) const {
+    uint64_t end = GetEndIndex();
+    Render(renderer, x, y, width, height, end > span ? end - span : 0, end);
+}
+
+} // namespace visualization
+} // namespace esp32_ide
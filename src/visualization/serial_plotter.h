@@ -0,0 +1,139 @@
+#ifndef SERIAL_PLOTTER_H
+#define SERIAL_PLOTTER_H
+
+#include "renderer/pure_c_renderer.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace esp32_ide {
+
+class TelemetryDecoder;
+
+namespace visualization {
+
+/**
+ * @brief Plotting engine behind Tools > Serial Plotter
+ *
+ * Takes numbers from serial lines in the Arduino plotter format
+ * ("1.5 2.0", "temp:21.5,hum:40") or from decoded binary telemetry, one
+ * series per value position, label or field. A series' x axis is its
+ * sample number.
+ *
+ * Each series keeps its samples in a ring and, above it, a pyramid of
+ * min/max levels, each entry summarising `decimation` entries of the level
+ * below. A view of any width is drawn from the level whose entries are
+ * just finer than a pixel, so rendering costs about decimation reads per
+ * pixel column whether it spans a second or a day, and spikes stay
+ * visible at every zoom. Coarser levels keep proportionally more
+ * history: with the defaults, samples for the last ~17 minutes at 1 kHz,
+ * then ever coarser summaries going back days, in at most 8 MiB per
+ * series. Rings grow as samples arrive, so a series that has seen a
+ * hundred values costs a few KiB. Appending is amortised O(1), so 10+
+ * series at 1 kHz cost the same after hours as at the start.
+ *
+ * Like the Arduino plotter, it stops taking new series at a limit, so a
+ * stream of ever-changing labels cannot exhaust memory; values for
+ * series past it are dropped.
+ *
+ * Not thread-safe; feed and render it from the thread that owns it, e.g.
+ * from SerialMonitor's batch callback.
+ */
+class SerialPlotter {
+public:
+    struct Options {
+        size_t capacity;            // samples kept per series
+        size_t decimation;          // entries summarised by one entry of the next level
+        size_t levels;              // min/max levels above the samples
+        size_t level_capacity;      // entries kept per level
+        size_t max_series;          // series beyond this are ignored
+    };
+
+    SerialPlotter();
+    explicit SerialPlotter(const Options& options);
+
+    static Options GetDefaultOptions();
+
+    // Returns the series' id, creating it on first use; -1 when full
+    int AddSeries(const std::string& name);
+    // -1 when there is no such series
+    int FindSeries(const std::string& name) const;
+    size_t GetSeriesCount() const { return series_.size(); }
+    const std::string& GetSeriesName(int series) const { return series_[series].name; }
+    renderer::Color GetSeriesColor(int series) const { return series_[series].color; }
+    void Clear();
+
+    /**
+     * @brief Adds one line of plotter output
+     *
+     * Values are separated by spaces, commas or tabs. "label:value" goes
+     * to the series of that name, a bare value to "value 1", "value 2"...
+     * by position. Words that are not numbers are skipped, and so are
+     * values for new series once max_series is reached.
+     * @return Number of values added
+     */
+    size_t AddLine(const std::string& line);
+    // One series per layout field, named after it; returns values added
+    size_t AddColumns(const TelemetryDecoder& decoder);
+    void AddSample(int series, double value);
+    void AddSamples(int series, const double* values, size_t count);
+
+    // Samples ever added to the series, i.e. the end of its x axis
+    uint64_t GetSampleCount(int series) const;
+    // The longest series' end, the right edge of a live view
+    uint64_t GetEndIndex() const;
+    // Oldest sample still covered, if only by the coarsest level
+    uint64_t GetFirstIndex(int series) const;
+
+    /**
+     * @brief Min and max of each of `columns` equal slices of [first, end)
+     *
+     * Summaries at slice edges may reach a few samples past them. Slices
+     * no longer covered by any level come out as NaN.
+     */
+    void GetEnvelope(int series, uint64_t first, uint64_t end, size_t columns, float* mins, float* maxs) const;
+
+    /**
+     * @brief Draws samples [first, end) of every series into a rectangle
+     *
+     * The y axis fits the visible range. Each pixel column is drawn as a
+     * vertical span from its min to its max, joined to its neighbours.
+     */
+    void Render(renderer::PureCRenderer& renderer, int x, int y, int width, int height, uint64_t first,
+                uint64_t end) const;
+    // The last `span` samples, following new data
+    void RenderLatest(renderer::PureCRenderer& renderer, int x, int y, int width, int height, uint64_t span) const;
+
+private:
+    struct Level {
+        std::vector<float> min;     // on the sample level, the samples themselves
+        std::vector<float> max;     // empty on the sample level
+        uint64_t mask;              // capacity - 1; the vectors grow up to it
+        uint64_t count;             // entries ever written
+        float pending_min;          // the entry being summarised
+        float pending_max;
+        size_t pending;
+    };
+
+    struct Series {
+        std::string name;
+        renderer::Color color;
+        std::vector<Level> levels;
+    };
+
+    Options options_;
+    std::vector<uint64_t> spans_;           // samples per entry, per level
+    std::vector<Series> series_;
+    std::vector<int> positional_;           // "value N" series by position
+    mutable std::vector<float> mins_;       // Render() scratch
+    mutable std::vector<float> maxs_;
+
+    void Append(Series& series, float value);
+    static void Grow(Level& level, bool summary);
+    void Scan(const Series& series, size_t level, uint64_t lo, uint64_t hi, float& min, float& max) const;
+};
+
+} // namespace visualization
+} // namespace esp32_ide
+
+#endif // SERIAL_PLOTTER_H
@@ -1,8 +1,15 @@
 #include <iostream>
 #include <cassert>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
 #include "editor/text_editor.h"
 #include "editor/syntax_highlighter.h"
 #include "file_manager/file_manager.h"
+#include "file_manager/project_templates.h"
+#include "file_manager/compiled_template.h"
+#include "utils/lz_codec.h"
+#include "utils/blob_store.h"
 
 using namespace esp32_ide;
 
@@ -39,6 +46,169 @@ void test_file_manager() {
     std::cout << "  ✓ FileManager tests passed" << std::endl;
 }
 
+void test_compiled_template() {
+    std::cout << "Testing CompiledTemplate..." << std::endl;
+    
+    CompiledTemplate tmpl("#define LED ${PIN}\n// ${NAME} on ${PIN}${", "${", "}");
+    assert(tmpl.HasVariables());
+    assert(tmpl.GetVariableNames().size() == 3);
+    
+    std::string out = tmpl.Render({{"PIN", "2"}, {"NAME", "${PIN}"}});
+    assert(out == "#define LED 2\n// ${PIN} on 2${");  // values are not re-scanned
+    
+    // Unset variables are left in place; overrides win over defaults
+    assert(tmpl.Render({{"PIN", "4"}}) == "#define LED 4\n// ${NAME} on 4${");
+    std::map<std::string, std::string> defaults = {{"PIN", "13"}, {"NAME", "blink"}};
+    out.clear();
+    tmpl.RenderTo(out, {{"PIN", "5"}}, &defaults);
+    assert(out == "#define LED 5\n// blink on 5${");
+    assert(tmpl.GetRenderedSize({{"PIN", "5"}}, &defaults) == out.size());
+    
+    FileManager fm;
+    fm.AddTemplate("wifi", "ssid={{ssid}} pass={{password}} {{ssid}}");
+    assert(fm.ApplyTemplate("wifi", {{"ssid", "lab"}}) == "ssid=lab pass={{password}} lab");
+    assert(fm.ApplyTemplate("missing").empty());
+    
+    std::cout << "  ✓ CompiledTemplate tests passed" << std::endl;
+}
+
+void test_project_creation() {
+    std::cout << "Testing ProjectTemplateManager..." << std::endl;
+    
+    auto dir = std::filesystem::temp_directory_path() / "esp32ide_project_templates";
+    std::filesystem::remove_all(dir);
+    
+    ProjectTemplateManager mgr;
+    mgr.Initialize();
+    mgr.SetWriterThreadCount(4);
+    
+    auto tmpl = std::make_unique<ProjectTemplate>("multi_file", "Multi-file project");
+    tmpl->SetVariable("LED_PIN", "2");
+    tmpl->AddDirectory("data");
+    for (int i = 0; i < 16; ++i) {
+        tmpl->AddFile("src/${PROJECT_NAME}_" + std::to_string(i) + ".cpp",
+                      "// ${PROJECT_NAME} part " + std::to_string(i) + "\nint pin = ${LED_PIN};\n");
+    }
+    mgr.RegisterTemplate(std::move(tmpl));
+    
+    ProjectTemplateManager::CreateProjectOptions options;
+    options.project_name = "Customer42";
+    options.project_path = dir.string();
+    options.template_id = "multi_file";
+    options.variables = {{"LED_PIN", "5"}};
+    options.create_git_repo = false;
+    options.open_after_create = false;
+    assert(mgr.CreateProject(options));
+    
+    assert(std::filesystem::is_directory(dir / "data"));
+    for (int i = 0; i < 16; ++i) {
+        std::ifstream in(dir / "src" / ("Customer42_" + std::to_string(i) + ".cpp"));
+        std::stringstream content;
+        content << in.rdbuf();
+        assert(content.str() == "// Customer42 part " + std::to_string(i) + "\nint pin = 5;\n");
+    }
+    
+    // Built-in templates render their file names too
+    assert(mgr.CreateProjectFromTemplate("basic_sketch", dir.string(), {{"PROJECT_NAME", "Blink"}}));
+    assert(std::filesystem::exists(dir / "Blink.ino"));
+    
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ProjectTemplateManager tests passed" << std::endl;
+}
+
+void test_blob_store() {
+    std::cout << "Testing BlobStore..." << std::endl;
+    
+    using namespace esp32_ide::utils;
+    
+    // Codec round trips, including overlapping matches and incompressible data
+    std::string source;
+    for (int i = 0; i < 500; ++i) {
+        source += "digitalWrite(LED_PIN, " + std::string(i % 2 ? "HIGH" : "LOW") + ");\n";
+    }
+    std::string noise;
+    unsigned int seed = 12345;
+    for (int i = 0; i < 5000; ++i) {
+        seed = seed * 1103515245 + 12345;
+        noise.push_back(static_cast<char>(seed >> 16));
+    }
+    for (const std::string& input : {std::string(), std::string("abc"), std::string(1000, 'x'), source, noise}) {
+        std::string compressed = LzCodec::Compress(input);
+        std::string decoded;
+        assert(LzCodec::Decompress(compressed, input.size(), decoded));
+        assert(decoded == input);
+    }
+    assert(LzCodec::Compress(source).size() * 4 < source.size());
+    std::string truncated = LzCodec::Compress(source).substr(0, 40);
+    std::string decoded;
+    assert(!LzCodec::Decompress(truncated, source.size(), decoded));
+    
+    // Identical contents share one blob; the last reference frees it
+    assert(sizeof(BlobRef) == 8);
+    BlobStore& store = BlobStore::GetInstance();
+    BlobStore::Stats before = store.GetStats();
+    BlobHandle handle;
+    {
+        BlobRef first(source);
+        BlobRef second(source);
+        BlobRef copy = first;
+        handle = first.GetHandle();
+        assert(first == second);
+        assert(store.GetRefCount(handle) == 3);
+        assert(second.Get() == source);
+        assert(copy.Size() == source.size());
+        
+        BlobStore::Stats stats = store.GetStats();
+        assert(stats.blob_count == before.blob_count + 1);
+        assert(stats.stored_bytes - before.stored_bytes < source.size() / 4);
+    }
+    assert(!store.Contains(handle));
+    assert(BlobRef().Empty() && BlobRef(std::string()).Empty());
+    
+    std::cout << "  ✓ BlobStore tests passed" << std::endl;
+}
+
+void test_snapshot_storage() {
+    std::cout << "Testing blob-backed snapshots..." << std::endl;
+    
+    // Undo history
+    TextEditor editor;
+    editor.SetText("void setup() {}");
+    editor.InsertText("\nvoid loop() {}", 15);
+    editor.Undo();
+    assert(editor.GetText() == "void setup() {}");
+    editor.Redo();
+    assert(editor.GetText() == "void setup() {}\nvoid loop() {}");
+    
+    // Tab hibernation
+    int first = editor.CreateTab("first.ino");
+    int second = editor.CreateTab("second.ino");
+    assert(editor.GetText().empty());
+    editor.SetText("second tab");
+    assert(editor.SwitchToTab(first));
+    assert(editor.GetText() == "void setup() {}\nvoid loop() {}");
+    assert(editor.GetTabContent(second) == "second tab");
+    assert(!editor.GetTab(second)->content.Empty());
+    assert(editor.CloseTab(first));
+    assert(editor.GetActiveTabId() == second);
+    assert(editor.GetText() == "second tab");
+    
+    // Closed files
+    FileManager fm;
+    fm.CreateFile("sensor.ino", "int value = analogRead(34);");
+    assert(fm.GetFileContent("sensor.ino") == "int value = analogRead(34);");
+    assert(fm.OpenFile("sensor.ino"));
+    fm.SetFileContent("sensor.ino", "int value = 0;");
+    assert(fm.CloseFile("sensor.ino"));
+    assert(fm.GetFileInfo("sensor.ino").content == "int value = 0;");
+    assert(!fm.GetFileInfo("sensor.ino").stored_content.Empty());
+    fm.SetFileContent("sensor.ino", "int value = 1;");
+    assert(fm.OpenFile("sensor.ino"));
+    assert(fm.GetFileContent("sensor.ino") == "int value = 1;");
+    
+    std::cout << "  ✓ Blob-backed snapshot tests passed" << std::endl;
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "ESP32 Driver IDE - Basic Tests" << std::endl;
@@ -49,6 +219,10 @@ int main() {
         test_text_editor();
         test_syntax_highlighter();
         test_file_manager();
+        test_compiled_template();
+        test_project_creation();
+        test_blob_store();
+        test_snapshot_storage();
         
         std::cout << std::endl;
         std::cout << "========================================" << std::endl;
@@ -0,0 +1,1811 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <map>
+
+#include "compiler/app_image.h"
+#include "compiler/build_graph.h"
+#include "compiler/build_scheduler.h"
+#include "compiler/esp32_compiler.h"
+#include "compiler/object_cache.h"
+#include "compiler/elf_size_analyzer.h"
+#include "compiler/size_history.h"
+#include "compiler/build_matrix.h"
+#include "compiler/library_index.h"
+#include "platform/platform_expansion.h"
+#include "plugins/plugin_system.h"
+#include "plugins/diagnostic_parser.h"
+
+using namespace esp32_ide;
+using namespace esp32_ide::plugins;
+
+// ============================================================================
+// Helper assertion functions
+// ============================================================================
+
+void assert_true(bool condition, const std::string& message = "") {
+    if (!condition) {
+        throw std::runtime_error("Assertion failed: " + message);
+    }
+}
+
+void assert_equal(size_t expected, size_t actual, const std::string& message = "") {
+    if (expected != actual) {
+        throw std::runtime_error("Assertion failed: expected " + std::to_string(expected) +
+                                " but got " + std::to_string(actual) + ". " + message);
+    }
+}
+
+std::string make_temp_dir(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() / ("esp32ide_" + name);
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+void write_file(const std::string& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+// Moves the mtime forward so coarse filesystem clocks still see a change
+void bump_mtime(const std::string& path) {
+    auto time = std::filesystem::last_write_time(path);
+    std::filesystem::last_write_time(path, time + std::chrono::seconds(2));
+}
+
+// Host g++ standing in for the cross toolchain
+CompilerConfig host_compiler() {
+    CompilerConfig config;
+    config.id = "host";
+    config.name = "Host G++";
+    config.compiler_path = "g++";
+    config.linker_path = "g++";
+    config.default_flags = {"-O0"};
+    config.output_extension = ".o";
+    config.error_pattern = R"((.+):(\d+):(\d+): (error|warning): (.+))";
+    return config;
+}
+
+// ============================================================================
+// Include Scanner Tests
+// ============================================================================
+
+void test_include_scanner() {
+    std::string source =
+        "#include \"config.h\"\n"
+        "  #  include <Arduino.h>\n"
+        "// #include \"commented.h\"\n"
+        "/* #include \"block.h\"\n"
+        "   #include \"still_block.h\" */\n"
+        "/* lead */ #include \"after_comment.h\"\n"
+        "const char* s = \"#include \\\"in_string.h\\\"\";\n"
+        "#define X 1 // #include \"trailing.h\"\n"
+        "#include_next <next.h>\n"
+        "#include MACRO_HEADER\n";
+
+    auto includes = IncludeScanner::Scan(source);
+    assert_equal(4, includes.size(), "Only real directives should be found");
+    assert_true(includes[0].name == "config.h" && !includes[0].system, "Quoted include");
+    assert_true(includes[1].name == "Arduino.h" && includes[1].system, "Angle include with spacing");
+    assert_true(includes[2].name == "after_comment.h", "Directive after a leading comment");
+    assert_true(includes[3].name == "next.h", "include_next");
+
+    std::cout << "  ✓ Include scanner tests passed" << std::endl;
+}
+
+// ============================================================================
+// Build Graph Tests
+// ============================================================================
+
+void test_graph_signatures() {
+    std::string dir = make_temp_dir("graph");
+    write_file(dir + "/main.cpp", "#include \"a.h\"\nint main() { return A; }\n");
+    write_file(dir + "/a.h", "#include \"b.h\"\n#define A B\n");
+    write_file(dir + "/b.h", "#define B 0\n");
+
+    BuildGraph graph;
+    std::vector<std::string> command = {"g++", "-c"};
+    graph.BeginPass();
+    std::vector<std::string> deps;
+    uint64_t first = graph.ComputeSignature(dir + "/main.cpp", command, &deps);
+    assert_true(first != 0, "Signature for an existing source");
+    assert_equal(3, deps.size(), "Transitive includes are dependencies");
+
+    // Same content with a new mtime keeps the signature
+    write_file(dir + "/b.h", "#define B 0\n");
+    bump_mtime(dir + "/b.h");
+    graph.BeginPass();
+    assert_true(graph.ComputeSignature(dir + "/main.cpp", command) == first, "Touch does not change inputs");
+    assert_equal(1, graph.GetFilesRehashed(), "Only the touched file is re-read");
+
+    // A change two levels down does
+    write_file(dir + "/b.h", "#define B 1\n");
+    bump_mtime(dir + "/b.h");
+    graph.BeginPass();
+    uint64_t second = graph.ComputeSignature(dir + "/main.cpp", command);
+    assert_true(second != first, "Nested header edit changes the signature");
+
+    // Flags are inputs too
+    graph.BeginPass();
+    assert_true(graph.ComputeSignature(dir + "/main.cpp", {"g++", "-c", "-O2"}) != second,
+                "Flag change changes the signature");
+
+    // Round-trip through disk
+    graph.SetTargetSignature("main.o", second);
+    assert_true(graph.Save(dir + "/graph.bin"), "Graph saves");
+    BuildGraph loaded;
+    assert_true(loaded.Load(dir + "/graph.bin"), "Graph loads");
+    assert_true(loaded.GetTargetSignature("main.o") == second, "Target signatures persist");
+    assert_equal(graph.GetFileCount(), loaded.GetFileCount(), "File nodes persist");
+    loaded.BeginPass();
+    assert_true(loaded.ComputeSignature(dir + "/main.cpp", command) == second, "Loaded graph agrees");
+    assert_equal(0, loaded.GetFilesRehashed(), "Loaded graph trusts unchanged files");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Build graph signature tests passed" << std::endl;
+}
+
+// ============================================================================
+// Compiler Manager Tests
+// ============================================================================
+
+void test_run_process() {
+    auto ok = CustomCompilerManager::RunProcess({"sh", "-c", "echo out; echo err >&2; exit 3"});
+    assert_equal(3, static_cast<size_t>(ok.exit_code), "Exit code is reported");
+    assert_true(ok.stdout_output == "out\n", "Stdout is captured");
+    assert_true(ok.stderr_output == "err\n", "Stderr is captured separately");
+
+    auto missing = CustomCompilerManager::RunProcess({"esp32ide-no-such-tool"});
+    assert_true(missing.exit_code != 0, "Missing program fails");
+    assert_true(!missing.error_message.empty(), "Missing program is explained");
+
+    // Long jobs started while short ones run must not hold their pipes open
+    std::atomic<int> sleeping(8);
+    std::vector<std::thread> slow;
+    for (int i = 0; i < 8; ++i) {
+        slow.emplace_back([&sleeping, i]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20 + 10 * i));
+            CustomCompilerManager::RunProcess({"sleep", "2"});
+            --sleeping;
+        });
+    }
+    long long slowest_ms = 0;
+    int fast_runs = 0;
+    while (sleeping > 0) {
+        auto start = std::chrono::steady_clock::now();
+        assert_equal(0, static_cast<size_t>(CustomCompilerManager::RunProcess({"true"}).exit_code), "true succeeds");
+        slowest_ms = std::max<long long>(slowest_ms, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                         std::chrono::steady_clock::now() - start).count());
+        fast_runs++;
+    }
+    for (auto& thread : slow) {
+        thread.join();
+    }
+    assert_true(fast_runs > 1 && slowest_ms < 1000,
+                "A fast job waited " + std::to_string(slowest_ms) + " ms for an unrelated one");
+
+    std::cout << "  ✓ Process runner tests passed" << std::endl;
+}
+
+// ============================================================================
+// Build Scheduler Tests
+// ============================================================================
+
+void test_scheduler_dag_and_priority() {
+    BuildScheduler scheduler(1);
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const std::string& name) {
+        return [&, name](std::string&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+            return true;
+        };
+    };
+
+    auto small = scheduler.AddJob("small", record("small"), {}, 1);
+    auto large = scheduler.AddJob("large", record("large"), {}, 50);
+    auto middle = scheduler.AddJob("middle", record("middle"), {small}, 10);
+    auto link = scheduler.AddJob("link", record("link"), {large, middle}, 5);
+
+    assert_true(scheduler.Run(), "All jobs succeed");
+    assert_equal(4, order.size(), "Every job ran");
+    assert_true(order.front() == "large", "Longest chain starts first");
+    assert_true(order.back() == "link", "Link waits for its inputs");
+    assert_true(std::find(order.begin(), order.end(), "small") <
+                std::find(order.begin(), order.end(), "middle"), "Dependencies run first");
+    assert_equal(55, scheduler.GetPriority(large), "Priority is the critical path length");
+    assert_equal(16, scheduler.GetPriority(small), "Priority includes downstream cost");
+    assert_true(scheduler.GetJobState(link) == BuildScheduler::JobState::SUCCEEDED, "Link state");
+
+    std::cout << "  ✓ Scheduler DAG and priority tests passed" << std::endl;
+}
+
+void test_scheduler_failure() {
+    BuildScheduler scheduler(4);
+    auto bad = scheduler.AddJob("bad", [](std::string& output) { output = "bad.c:1:1: error: oops\n"; return false; });
+    auto good = scheduler.AddJob("good", [](std::string&) { return true; });
+    auto after_bad = scheduler.AddJob("after_bad", [](std::string&) { return true; }, {bad});
+    auto link = scheduler.AddJob("link", [](std::string&) { return true; }, {after_bad, good});
+
+    std::vector<std::string> errors;
+    scheduler.SetOutputCallback([&](const std::string& line, bool is_error) {
+        if (is_error) errors.push_back(line);
+    });
+
+    assert_true(!scheduler.Run(), "Failure is reported");
+    assert_true(scheduler.GetJobState(bad) == BuildScheduler::JobState::FAILED, "Failed job");
+    assert_true(scheduler.GetJobState(good) == BuildScheduler::JobState::SUCCEEDED, "Independent job still runs");
+    assert_true(scheduler.GetJobState(after_bad) == BuildScheduler::JobState::SKIPPED, "Dependent is skipped");
+    assert_true(scheduler.GetJobState(link) == BuildScheduler::JobState::SKIPPED, "Skips cascade");
+    assert_equal(2, scheduler.GetStats().jobs_skipped, "Skip count");
+    assert_equal(1, errors.size(), "Failed job output is flagged");
+
+    std::cout << "  ✓ Scheduler failure tests passed" << std::endl;
+}
+
+void test_scheduler_parallelism_and_memory() {
+    // Independent jobs overlap
+    BuildScheduler parallel(8);
+    for (int i = 0; i < 8; ++i) {
+        parallel.AddJob("sleep", [](std::string&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return true;
+        });
+    }
+    assert_true(parallel.Run(), "Parallel jobs succeed");
+    assert_true(parallel.GetStats().peak_parallelism > 1, "Jobs run concurrently");
+    assert_true(parallel.GetStats().elapsed_ms < 300, "Parallel run is faster than serial");
+
+    // The memory budget caps concurrency
+    BuildScheduler capped(8);
+    capped.SetMemoryBudget(250);
+    std::atomic<int> running(0);
+    std::atomic<int> peak(0);
+    for (int i = 0; i < 8; ++i) {
+        capped.AddJob("compile", [&](std::string&) {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            --running;
+            return true;
+        }, {}, 1, 100);
+    }
+    // A single job larger than the budget must still run
+    capped.AddJob("huge", [](std::string&) { return true; }, {}, 1, 1000);
+    assert_true(capped.Run(), "Memory-capped jobs succeed");
+    assert_true(peak.load() <= 2, "At most two 100 MB jobs fit in 250 MB");
+
+    std::cout << "  ✓ Scheduler parallelism and memory tests passed" << std::endl;
+}
+
+void test_scheduler_output_not_interleaved() {
+    BuildScheduler scheduler(8);
+    for (int job = 0; job < 16; ++job) {
+        scheduler.AddJob("job", [job](std::string& output) {
+            for (int line = 0; line < 40; ++line) {
+                output += "job-" + std::to_string(job) + " line-" + std::to_string(line) + "\n";
+            }
+            return true;
+        });
+    }
+
+    std::vector<std::string> lines;
+    scheduler.SetOutputCallback([&](const std::string& line, bool) { lines.push_back(line); });
+    assert_true(scheduler.Run(), "Output jobs succeed");
+    assert_equal(16 * 40, lines.size(), "Every line delivered once");
+
+    // Each job's lines arrive as one contiguous, ordered block
+    for (size_t i = 0; i < lines.size(); i += 40) {
+        std::string prefix = lines[i].substr(0, lines[i].find(' '));
+        for (size_t j = 0; j < 40; ++j) {
+            assert_true(lines[i + j] == prefix + " line-" + std::to_string(j), "Block is contiguous: " + lines[i + j]);
+        }
+    }
+
+    std::cout << "  ✓ Scheduler output tests passed" << std::endl;
+}
+
+// ============================================================================
+// Build Engine Tests
+// ============================================================================
+
+void test_incremental_build() {
+    std::string dir = make_temp_dir("build_project");
+    std::string build_dir = dir + "/.esp32ide/build/host";
+    write_file(dir + "/config.h", "#define LED_PIN 2\n");
+    write_file(dir + "/util.h", "int blink(int pin);\n");
+    write_file(dir + "/util.cpp", "#include \"util.h\"\nint blink(int pin) { return pin; }\n");
+    write_file(dir + "/main.cpp",
+               "#include \"config.h\"\n#include \"util.h\"\nint main() { return blink(LED_PIN) - 2; }\n");
+
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+
+    BuildEngine::BuildConfig config;
+    config.build_dir = build_dir;
+    config.compiler_id = "host";
+    config.source_dirs = {dir};
+    config.output_name = "app";
+    config.jobs = 4;
+    config.memory_budget_mb = 0;
+
+    {
+        BuildEngine engine(compilers);
+        engine.SetConfig(config);
+        assert_equal(2, engine.CollectSources().size(), "Build directory is not scanned");
+
+        auto result = engine.Build();
+        assert_true(result.success, "Clean build succeeds: " + result.log + result.error_message);
+        assert_equal(2, result.units_compiled, "Everything compiles the first time");
+        assert_true(result.linked, "First build links");
+        assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Linked program runs");
+
+        result = engine.Build();
+        assert_true(result.success, "No-op build succeeds");
+        assert_equal(0, result.units_compiled, "No-op build compiles nothing");
+        assert_true(!result.linked, "No-op build does not relink");
+
+        // Editing a header rebuilds only its includers
+        write_file(dir + "/config.h", "#define LED_PIN 2 // onboard LED\n");
+        bump_mtime(dir + "/config.h");
+        result = engine.Build();
+        assert_equal(1, result.units_compiled, "Only main.cpp includes config.h");
+        assert_true(result.linked, "Changed object relinks");
+    }
+
+    // A new engine resumes from the saved graph
+    {
+        BuildEngine engine(compilers);
+        engine.SetConfig(config);
+        auto result = engine.Build();
+        assert_true(result.success, "Resumed build succeeds");
+        assert_equal(0, result.units_compiled, "Persistent graph avoids recompiles");
+
+        // A compile error is reported and retried until fixed
+        write_file(dir + "/util.cpp", "#include \"util.h\"\nint blink(int pin) { return pin }\n");
+        bump_mtime(dir + "/util.cpp");
+        size_t live_errors = 0;
+        engine.SetDiagnosticCallback([&](const AnalysisResult& diagnostic) {
+            if (diagnostic.severity == "error") live_errors++;
+        });
+        result = engine.Build();
+        engine.SetDiagnosticCallback(nullptr);
+        assert_true(!result.success, "Syntax error fails the build");
+        assert_equal(1, result.units_failed, "One unit failed");
+        assert_true(live_errors > 0, "Diagnostics are reported while building");
+        assert_true(!result.diagnostics.empty(), "Errors are parsed");
+        assert_true(result.diagnostics[0].severity == "error", "Diagnostic severity");
+        assert_true(result.diagnostics[0].line_number == 2, "Diagnostic line");
+
+        result = engine.Build();
+        assert_equal(1, result.units_failed, "Failed unit is retried");
+
+        write_file(dir + "/util.cpp", "#include \"util.h\"\nint blink(int pin) { return pin; }\n");
+        bump_mtime(dir + "/util.cpp");
+        result = engine.Build();
+        assert_true(result.success, "Fixed build succeeds");
+        assert_equal(1, result.units_compiled, "Only the fixed unit compiles");
+
+        // Flag changes rebuild everything
+        config.flags = {"-DEXTRA=1"};
+        engine.SetConfig(config);
+        result = engine.Build();
+        assert_equal(2, result.units_compiled, "Flags are part of the signature");
+
+        assert_true(engine.Clean(), "Clean succeeds");
+        assert_true(!std::filesystem::exists(engine.GetGraphPath()), "Clean removes the graph");
+    }
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Incremental build tests passed" << std::endl;
+}
+
+void test_parallel_build() {
+    std::string dir = make_temp_dir("parallel_project");
+    std::string main_source = "int main() { return 0";
+    for (int i = 0; i < 12; ++i) {
+        std::string name = "unit" + std::to_string(i);
+        write_file(dir + "/" + name + ".cpp", "int " + name + "() { return " + std::to_string(i) + "; }\n");
+        main_source += " + 0 * unit" + std::to_string(i) + "()";
+    }
+    std::string declarations;
+    for (int i = 0; i < 12; ++i) declarations += "int unit" + std::to_string(i) + "();\n";
+    write_file(dir + "/main.cpp", declarations + main_source + "; }\n");
+
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+
+    BuildEngine::BuildConfig config;
+    config.build_dir = dir + "/.esp32ide/build/host";
+    config.compiler_id = "host";
+    config.source_dirs = {dir};
+    config.output_name = "app";
+    config.jobs = 4;
+    config.memory_budget_mb = 0;
+
+    BuildEngine engine(compilers);
+    engine.SetConfig(config);
+    size_t compiling_lines = 0;
+    engine.SetOutputCallback([&](const std::string& message, bool) {
+        if (message.rfind("Compiling ", 0) == 0) compiling_lines++;
+    });
+
+    auto result = engine.Build();
+    assert_true(result.success, "Parallel build succeeds: " + result.log);
+    assert_equal(13, result.units_compiled, "All units compile");
+    assert_equal(13, compiling_lines, "One progress line per unit");
+    assert_true(result.peak_parallelism > 1, "Units compile in parallel");
+    assert_true(engine.GetGraph().GetTargetDuration(engine.GetObjectPath(dir + "/main.cpp")) > 0,
+                "Compile durations are recorded for scheduling");
+    assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Linked program runs");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Parallel build tests passed" << std::endl;
+}
+
+void test_compiler_project_build() {
+    std::string dir = make_temp_dir("sketch_project");
+    write_file(dir + "/helpers.h", "int twice(int v);\n");
+    write_file(dir + "/helpers.cpp", "#include \"helpers.h\"\nint twice(int v) { return v * 2; }\n");
+
+    ESP32Compiler compiler;
+    compiler.GetCompilerManager().RegisterCompiler(host_compiler());
+
+    ESP32Compiler::BuildSettings settings;
+    settings.project_dir = dir;
+    settings.compiler_id = "host";
+    compiler.SetBuildSettings(settings);
+
+    std::string sketch =
+        "#include \"helpers.h\"\n"
+        "void setup() {}\n"
+        "void loop() {}\n"
+        "int main() { setup(); loop(); return twice(0); }\n";
+
+    auto result = compiler.Compile(sketch, ESP32Compiler::BoardType::ESP32_S3);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Sketch builds");
+    assert_equal(2, result.units_compiled, "Sketch and helper compile");
+    assert_true(std::filesystem::exists(result.output_file), "Image is produced");
+    assert_true(result.output_file.find("esp32-s3") != std::string::npos, "Per-board build directory");
+
+    result = compiler.Compile(sketch, ESP32Compiler::BoardType::ESP32_S3);
+    assert_equal(0, result.units_compiled, "Unchanged sketch is up to date");
+
+    // A one-line edit to the buffer recompiles just the sketch
+    auto start = std::chrono::steady_clock::now();
+    result = compiler.Compile(sketch + "int unused_value = 1;\n", ESP32Compiler::BoardType::ESP32_S3);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert_equal(1, result.units_compiled, "Only the sketch recompiles");
+    assert_true(elapsed < std::chrono::seconds(10), "Incremental rebuild is fast");
+
+    result = compiler.Compile("void setup() {}\nvoid loop() { undefined_call(); }\n",
+                              ESP32Compiler::BoardType::ESP32_S3);
+    assert_true(result.status == ESP32Compiler::CompileStatus::ERROR, "Compiler errors fail the build");
+    assert_true(!result.errors.empty() && result.errors[0].find("undefined_call") != std::string::npos,
+                "Compiler errors are surfaced");
+
+    // Without a project only the syntax is checked
+    ESP32Compiler syntax_only;
+    result = syntax_only.Compile(sketch, ESP32Compiler::BoardType::ESP32);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Syntax-only check passes");
+    assert_true(result.output_file.empty(), "Syntax-only check produces no image");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ESP32Compiler project build tests passed" << std::endl;
+}
+
+void test_precompiled_header() {
+    std::string dir = make_temp_dir("build_pch");
+    std::string core = dir + "/core";
+    std::string build_dir = dir + "/build";
+    std::filesystem::create_directories(core);
+    std::filesystem::create_directories(dir + "/src");
+    write_file(core + "/Arduino.h",
+               "#ifndef Arduino_h\n#define Arduino_h\n#include <string>\n#include <vector>\n"
+               "#define CORE_ID 7\ninline int core_id() { return CORE_ID; }\n#endif\n");
+    write_file(dir + "/src/a.cpp", "#include <Arduino.h>\nint a() { return core_id(); }\n");
+    write_file(dir + "/src/b.cpp", "#include <Arduino.h>\nint b() { return BOARD_ID; }\n");
+    write_file(dir + "/src/c.cpp", "int c() { return 1; }\n");
+    write_file(dir + "/src/main.cpp",
+               "int a();\nint b();\nint c();\nint main() { return a() + b() + c() == 7 + BOARD_ID + 1 ? 0 : 1; }\n");
+
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+
+    BuildEngine::BuildConfig config;
+    config.build_dir = build_dir;
+    config.compiler_id = "host";
+    config.source_dirs = {dir + "/src"};
+    config.include_paths = {core};
+    config.board_flags = "-DBOARD_ID=1";
+    config.output_name = "app";
+    config.precompiled_header = "Arduino.h";
+    config.core_version = "2.0.14";
+    config.jobs = 4;
+    config.memory_budget_mb = 0;
+
+    auto pch_keys = [&]() {
+        size_t count = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(build_dir + "/pch")) {
+            (void)entry;
+            count++;
+        }
+        return count;
+    };
+
+    BuildEngine engine(compilers);
+    engine.SetConfig(config);
+    auto result = engine.Build();
+    assert_true(result.success, "PCH build succeeds: " + result.log + result.error_message);
+    assert_true(result.pch_built, "Header precompiled on the first build");
+    assert_equal(2, result.pch_units, "Only units including Arduino.h use it");
+    assert_true(result.diagnostics.empty(), "The .gch is valid for the units: " + result.log);
+    assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Linked program runs");
+
+    // Editing a unit reuses the .gch
+    write_file(dir + "/src/a.cpp", "#include <Arduino.h>\nint a() { return core_id() + 0; }\n");
+    bump_mtime(dir + "/src/a.cpp");
+    result = engine.Build();
+    assert_true(result.success && !result.pch_built, "Unit edit reuses the precompiled header");
+    assert_equal(1, result.units_compiled, "Only the edited unit recompiles");
+
+    // Core version, board flags and the header itself each make a new key
+    config.core_version = "2.0.15";
+    engine.SetConfig(config);
+    result = engine.Build();
+    assert_true(result.success && result.pch_built, "New core version rebuilds the header");
+    assert_equal(2, result.units_compiled, "Its includers recompile");
+    assert_equal(1, pch_keys(), "Stale keys removed");
+
+    config.board_flags = "-DBOARD_ID=2";
+    engine.SetConfig(config);
+    result = engine.Build();
+    assert_true(result.success && result.pch_built, "Board flags rebuild the header");
+    assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Built for the new board");
+
+    write_file(core + "/Arduino.h",
+               "#ifndef Arduino_h\n#define Arduino_h\n#include <string>\n"
+               "#define CORE_ID 7\ninline int core_id() { return CORE_ID; }\n#endif\n");
+    bump_mtime(core + "/Arduino.h");
+    result = engine.Build();
+    assert_true(result.success && result.pch_built, "Header edit rebuilds it");
+    assert_true(result.diagnostics.empty(), "Rebuilt .gch valid");
+
+    result = engine.Build();
+    assert_true(result.success && !result.pch_built && result.units_compiled == 0, "No-op build");
+
+    // The stub lives in each build directory; objects are still shared
+    ObjectCache cache(dir + "/cache");
+    BuildEngine::BuildConfig shared = config;
+    shared.build_dir = dir + "/shared_a";
+    BuildEngine first(compilers);
+    first.SetObjectCache(&cache);
+    first.SetConfig(shared);
+    result = first.Build();
+    assert_true(result.success && result.pch_units == 2, "Cached PCH build succeeds: " + result.log);
+    assert_equal(4, result.cache_misses, "Cold cache misses");
+    shared.build_dir = dir + "/shared_b";
+    BuildEngine second(compilers);
+    second.SetObjectCache(&cache);
+    second.SetConfig(shared);
+    result = second.Build();
+    assert_true(result.success && result.pch_units == 2, "Second build dir uses its own .gch");
+    assert_equal(4, result.cache_hits, "PCH units hit across build directories");
+
+    // Without a GCC-style toolchain the units include the header as text
+    CompilerConfig other = host_compiler();
+    other.id = "other";
+    other.compiler_path = "c++";
+    compilers.RegisterCompiler(other);
+    config.compiler_id = "other";
+    engine.SetConfig(config);
+    result = engine.Build();
+    assert_true(result.success && result.pch_units == 0, "No precompiled header for other compilers");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Precompiled header tests passed" << std::endl;
+}
+
+// ============================================================================
+// Object Cache Tests
+// ============================================================================
+
+void test_object_cache_keys() {
+    ObjectCache cache(make_temp_dir("cache_keys"));
+    std::string text = "int main() { return 0; }\n";
+    std::vector<std::string> flags = {"-O2", "-Iinclude", "-DLED=2"};
+
+    std::string key = cache.ComputeKey(text, "g++", flags, "-mlongcalls");
+    assert_equal(32, key.size(), "Keys are 128-bit hex");
+    assert_true(key == cache.ComputeKey(text, "g++", flags, "-mlongcalls"), "Keys are stable");
+    assert_true(key == cache.ComputeKey(text, "g++", {"-O2", "-Iother", "-DLED=3"}, "-mlongcalls"),
+                "Preprocessor flags are already in the text");
+    assert_true(key == cache.ComputeKey(text, "g++", {"-include", "/b/pch/1/Arduino.h", "-Winvalid-pch", "-O2"},
+                                        "-mlongcalls"),
+                "Forced includes are already in the text");
+    assert_true(key != cache.ComputeKey(text + " ", "g++", flags, "-mlongcalls"), "Text is keyed");
+    assert_true(key != cache.ComputeKey(text, "g++", {"-O0"}, "-mlongcalls"), "Flags are keyed");
+    assert_true(key != cache.ComputeKey(text, "g++", flags, "-march=rv32imc"), "Board is keyed");
+    assert_true(key != cache.ComputeKey(text, "gcc", flags, "-mlongcalls"), "Compiler is keyed");
+
+    std::filesystem::remove_all(cache.GetDirectory());
+    std::cout << "  ✓ Object cache key tests passed" << std::endl;
+}
+
+void test_object_cache_store_and_evict() {
+    std::string dir = make_temp_dir("cache_store");
+    ObjectCache cache(dir + "/cache", 1024 * 1024);
+    std::string output;
+
+    write_file(dir + "/a.o", std::string(4000, 'a'));
+    assert_true(!cache.Fetch("00aa", dir + "/out.o", output), "Empty cache misses");
+    assert_true(cache.Store("00aa", dir + "/a.o", "a.cpp:1:1: warning: unused\n"), "Store succeeds");
+    assert_true(cache.Fetch("00aa", dir + "/out.o", output), "Stored entry hits");
+    assert_equal(4000, static_cast<size_t>(std::filesystem::file_size(dir + "/out.o")), "Object is restored");
+    assert_true(output.find("warning: unused") != std::string::npos, "Warnings are replayed");
+
+    auto stats = cache.GetStats();
+    assert_equal(1, stats.hits, "Hit counted");
+    assert_equal(1, stats.misses, "Miss counted");
+    assert_equal(1, stats.entry_count, "One entry");
+
+    // Least recently used entries go first once the limit is exceeded
+    cache.Store("00bb", dir + "/a.o", "");
+    cache.Store("00cc", dir + "/a.o", "");
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(dir + "/cache/00/aa.o", now - std::chrono::hours(1));
+    std::filesystem::last_write_time(dir + "/cache/00/bb.o", now - std::chrono::hours(3));
+    std::filesystem::last_write_time(dir + "/cache/00/cc.o", now - std::chrono::hours(2));
+    cache.SetMaxSize(9000);
+    assert_true(!std::filesystem::exists(dir + "/cache/00/bb.o"), "Oldest entry evicted");
+    assert_true(std::filesystem::exists(dir + "/cache/00/aa.o"), "Recently used entry kept");
+    assert_true(cache.GetStats().total_bytes <= 9000, "Cache fits its limit");
+    assert_true(cache.GetStats().evictions >= 1, "Evictions counted");
+
+    assert_true(cache.Clear(), "Clear succeeds");
+    assert_true(!cache.Fetch("00aa", dir + "/out.o", output), "Cleared cache misses");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Object cache store/evict tests passed" << std::endl;
+}
+
+void test_object_cache_build() {
+    std::string dir = make_temp_dir("cache_project");
+    std::string core = dir + "/core";
+    std::filesystem::create_directories(core);
+    for (int i = 0; i < 6; ++i) {
+        std::string name = "core" + std::to_string(i);
+        write_file(core + "/" + name + ".cpp", "int " + name + "() { return " + std::to_string(i) + "; }\n");
+    }
+    write_file(core + "/main.cpp", "int main() { return 0; }\n");
+
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+    ObjectCache cache(dir + "/cache");
+
+    BuildEngine::BuildConfig config;
+    config.build_dir = dir + "/build_a";
+    config.compiler_id = "host";
+    config.source_dirs = {core};
+    config.board_flags = "-DBOARD_A";
+    config.output_name = "app";
+    config.jobs = 2;
+    config.memory_budget_mb = 0;
+
+    BuildEngine first(compilers);
+    first.SetObjectCache(&cache);
+    first.SetConfig(config);
+    auto result = first.Build();
+    assert_true(result.success, "Cold build succeeds: " + result.log);
+    assert_equal(0, result.cache_hits, "Cold cache has nothing");
+    assert_equal(7, result.cache_misses, "Every unit misses");
+
+    // A clean build elsewhere of the same core comes straight from the cache
+    config.build_dir = dir + "/build_b";
+    BuildEngine second(compilers);
+    second.SetObjectCache(&cache);
+    second.SetConfig(config);
+    auto start = std::chrono::steady_clock::now();
+    result = second.Build();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert_true(result.success, "Cached build succeeds: " + result.log);
+    assert_equal(7, result.cache_hits, "Every unit hits");
+    assert_equal(7, result.units_compiled, "Hits still produce the objects");
+    assert_true(elapsed < std::chrono::seconds(5), "Cached build is fast");
+    assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Linked program runs");
+
+    // Different board flags produce different objects
+    config.build_dir = dir + "/build_c";
+    config.board_flags = "-O1";
+    BuildEngine third(compilers);
+    third.SetObjectCache(&cache);
+    third.SetConfig(config);
+    result = third.Build();
+    assert_true(result.success, "Other board builds");
+    assert_equal(7, result.cache_misses, "Board flags are part of the key");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Object cache build tests passed" << std::endl;
+}
+
+// ============================================================================
+// Diagnostic Parser Tests
+// ============================================================================
+
+const char* kGccOutput =
+    "In file included from src/config.h:3,\n"
+    "                 from main.cpp:1:\n"
+    "src/pins.h: In function 'void setup()':\n"
+    "src/pins.h:12:5: error: 'pinMod' was not declared in this scope; did you mean 'pinMode'?\n"
+    "   12 |     pinMod(2, OUTPUT);\n"
+    "      |     ^~~~~~\n"
+    "      |     pinMode\n"
+    "In file included from main.cpp:1:\n"
+    "src/arduino.h:40:6: note: 'pinMode' declared here\n"
+    "   40 | void pinMode(int pin, int mode);\n"
+    "      |      ^~~~~~~\n"
+    "main.cpp: In function 'int main()':\n"
+    "main.cpp:7:9: warning: unused variable 'x' [-Wunused-variable]\n"
+    "    7 |     int x = 0;\n"
+    "      |         ^\n"
+    "main.cpp: In instantiation of 'void show(T) [with T = int]':\n"
+    "main.cpp:20:9:   required from here\n"
+    "main.cpp:15:5: error: no match for 'operator<<'\n"
+    "compilation terminated.\n"
+    "C:\\esp\\core\\wiring.c:88: warning: implicit declaration\n"
+    "collect2: error: ld returned 1 exit status\n";
+
+void test_diagnostic_parser_grouping() {
+    auto results = DiagnosticParser::ParseAll(kGccOutput);
+    assert_equal(5, results.size(), "Notes and context lines are grouped");
+
+    const AnalysisResult& first = results[0];
+    assert_true(first.severity == "error", "Error severity");
+    assert_true(first.file_path == "src/pins.h", "Error file");
+    assert_equal(12, static_cast<size_t>(first.line_number), "Error line");
+    assert_equal(5, static_cast<size_t>(first.column_number), "Error column");
+    assert_true(first.message.find("'pinMod' was not declared") == 0, "Error message");
+    assert_equal(2, first.include_chain.size(), "Include chain");
+    assert_true(first.include_chain[0] == "src/config.h:3" && first.include_chain[1] == "main.cpp:1",
+                "Include chain order");
+    assert_equal(1, first.context.size(), "Function context");
+    assert_equal(1, first.notes.size(), "Note attached to its error");
+    assert_true(first.notes[0] == "src/arduino.h:40:6: 'pinMode' declared here", "Note text");
+
+    assert_true(results[1].severity == "warning", "Warning severity");
+    assert_true(results[1].rule_id == "-Wunused-variable", "Warning flag becomes the rule id");
+    assert_true(results[1].message == "unused variable 'x'", "Flag stripped from message");
+    assert_true(results[1].include_chain.empty(), "Include chain not reused");
+
+    assert_equal(2, results[2].context.size(), "Instantiation context and required-from line");
+    assert_true(results[2].context[1] == "main.cpp:20:9: required from here", "Required-from location");
+
+    assert_true(results[3].file_path == "C:\\esp\\core\\wiring.c", "Drive letters survive");
+    assert_equal(88, static_cast<size_t>(results[3].line_number), "Line without column");
+    assert_equal(0, static_cast<size_t>(results[3].column_number), "Missing column is 0");
+
+    assert_true(results[4].file_path == "collect2" && results[4].line_number == 0, "Driver errors");
+
+    // Chunk boundaries and CRLF line endings do not change the result
+    std::string crlf;
+    for (const char* p = kGccOutput; *p; ++p) {
+        if (*p == '\n') crlf += '\r';
+        crlf += *p;
+    }
+    std::vector<AnalysisResult> chunked;
+    DiagnosticParser parser([&](const AnalysisResult& result) { chunked.push_back(result); });
+    for (size_t i = 0; i < crlf.size(); i += 7) {
+        parser.Feed(crlf.data() + i, std::min<size_t>(7, crlf.size() - i));
+    }
+    parser.Finish();
+    assert_equal(results.size(), chunked.size(), "Chunked parse finds the same diagnostics");
+    for (size_t i = 0; i < results.size(); ++i) {
+        assert_true(results[i].message == chunked[i].message && results[i].notes == chunked[i].notes,
+                    "Chunked parse matches diagnostic " + std::to_string(i));
+    }
+
+    // Other tools
+    results = DiagnosticParser::ParseAll(
+        "[src/main.cpp:14]: (style) Variable 'i' is assigned a value that is never used. [unreadVariable]\n"
+        "main.o: in function `loop':\n"
+        "main.cpp:(.text.loop+0x9): undefined reference to `blink(int)'\n"
+        "lib.cpp:3:1: warning: use nullptr [modernize-use-nullptr]\n");
+    assert_equal(3, results.size(), "cppcheck, linker and clang-tidy lines");
+    assert_true(results[0].severity == "hint" && results[0].rule_id == "unreadVariable", "cppcheck format");
+    assert_equal(14, static_cast<size_t>(results[0].line_number), "cppcheck line");
+    assert_true(results[1].severity == "error" && results[1].file_path == "main.cpp", "Linker errors");
+    assert_true(results[1].message == "undefined reference to `blink(int)'", "Linker message");
+    assert_true(results[2].rule_id == "modernize-use-nullptr", "clang-tidy check name");
+
+    std::cout << "  ✓ Diagnostic grouping tests passed" << std::endl;
+}
+
+void test_diagnostic_parser_streaming() {
+    std::vector<AnalysisResult> emitted;
+    DiagnosticParser parser([&](const AnalysisResult& result) { emitted.push_back(result); });
+
+    parser.Feed("a.cpp:1:1: error: first\n  1 | x\n    | ^\n");
+    assert_equal(0, emitted.size(), "Held back while notes may follow");
+    parser.Feed("a.cpp:2:1: note: because\na.cpp:3:1: err");
+    assert_equal(0, emitted.size(), "Partial header is not a new diagnostic");
+    parser.Feed("or: second\n");
+    assert_equal(1, emitted.size(), "Emitted once the next error starts");
+    assert_equal(1, emitted[0].notes.size(), "Note went to the first error");
+    parser.Feed("make: *** [all] Error 1\n");
+    assert_equal(2, emitted.size(), "Unrelated output closes the group");
+    parser.Finish();
+    assert_equal(2, parser.GetDiagnosticCount(), "Count");
+
+    // Template dumps produce enormous lines; parsing stays linear
+    std::string huge = "main.cpp:9:3: error: no matching function for call to 'f(";
+    while (huge.size() < 4 * 1024 * 1024) huge += "std::vector<std::map<int, std::string: :> > >, ";
+    huge += ")'\n";
+    std::string dump;
+    for (int i = 0; i < 4; ++i) {
+        dump += huge;
+        dump += "main.cpp:3:6: note: candidate: 'template<class T> void f(T)' " + huge.substr(0, 1 << 20) + "\n";
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto results = DiagnosticParser::ParseAll(dump);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert_equal(4, results.size(), "Huge diagnostics parsed");
+    assert_equal(1, results[3].notes.size(), "Huge notes grouped");
+    assert_true(elapsed < std::chrono::seconds(2), "Parsing megabytes of template errors is fast");
+
+    // Live diagnostics from a real compile
+    std::string dir = make_temp_dir("diagnostics");
+    write_file(dir + "/bad.cpp", "int f() { return missing; }\nint g() { return also_missing; }\n");
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+    std::vector<AnalysisResult> live;
+    auto compile = compilers.Compile("host", dir + "/bad.cpp", dir + "/bad.o", {},
+                                     [&](const AnalysisResult& result) { live.push_back(result); });
+    assert_true(compile.exit_code != 0, "Broken unit fails");
+    assert_equal(2, live.size(), "Both errors reported while compiling");
+    assert_equal(2, static_cast<size_t>(live[1].line_number), "Second error line");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Diagnostic streaming tests passed" << std::endl;
+}
+
+// ============================================================================
+// ELF Size Analyzer Tests
+// ============================================================================
+
+struct TestSection {
+    std::string name;
+    uint32_t type;      // 1 = PROGBITS, 8 = NOBITS
+    uint32_t flags;     // 1 = W, 2 = A, 4 = X
+    uint32_t address;
+    uint32_t size;
+};
+
+struct TestSymbol {
+    std::string name;
+    uint32_t value;
+    uint32_t size;
+    uint8_t type;       // 1 = OBJECT, 2 = FUNC
+    uint16_t section;   // 1-based index into the sections
+};
+
+void put16(std::string& out, uint16_t value) {
+    out += static_cast<char>(value & 0xff);
+    out += static_cast<char>(value >> 8);
+}
+
+void put32(std::string& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xffff));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// Minimal little-endian ELF32 for an Xtensa target
+std::string make_elf32(const std::vector<TestSection>& sections, const std::vector<TestSymbol>& symbols) {
+    std::string body;
+    std::vector<uint32_t> offsets;
+    for (const auto& section : sections) {
+        offsets.push_back(52 + static_cast<uint32_t>(body.size()));
+        if (section.type != 8) body.append(section.size, '\0');
+    }
+
+    std::string strtab(1, '\0');
+    std::string symtab(16, '\0');
+    for (const auto& symbol : symbols) {
+        put32(symtab, static_cast<uint32_t>(strtab.size()));
+        strtab += symbol.name + '\0';
+        put32(symtab, symbol.value);
+        put32(symtab, symbol.size);
+        symtab += static_cast<char>(0x10 | symbol.type);   // global binding
+        symtab += '\0';
+        put16(symtab, symbol.section);
+    }
+    std::string shstrtab(1, '\0');
+    std::vector<uint32_t> names;
+    for (const auto& section : sections) {
+        names.push_back(static_cast<uint32_t>(shstrtab.size()));
+        shstrtab += section.name + '\0';
+    }
+    uint32_t symtab_name = static_cast<uint32_t>(shstrtab.size());
+    shstrtab += std::string(".symtab") + '\0';
+    uint32_t strtab_name = static_cast<uint32_t>(shstrtab.size());
+    shstrtab += std::string(".strtab") + '\0';
+    uint32_t shstrtab_name = static_cast<uint32_t>(shstrtab.size());
+    shstrtab += std::string(".shstrtab") + '\0';
+
+    uint32_t symtab_offset = 52 + static_cast<uint32_t>(body.size());
+    body += symtab;
+    uint32_t strtab_offset = 52 + static_cast<uint32_t>(body.size());
+    body += strtab;
+    uint32_t shstrtab_offset = 52 + static_cast<uint32_t>(body.size());
+    body += shstrtab;
+    uint32_t header_offset = 52 + static_cast<uint32_t>(body.size());
+    uint16_t count = static_cast<uint16_t>(sections.size() + 4);
+
+    std::string elf("\x7f" "ELF", 4);
+    elf += '\x01';                      // ELFCLASS32
+    elf += '\x01';                      // little endian
+    elf += '\x01';
+    elf.append(9, '\0');
+    put16(elf, 2);                      // ET_EXEC
+    put16(elf, 94);                     // EM_XTENSA
+    put32(elf, 1);
+    put32(elf, 0x40080000);
+    put32(elf, 0);
+    put32(elf, header_offset);
+    put32(elf, 0);
+    put16(elf, 52);
+    put16(elf, 0);
+    put16(elf, 0);
+    put16(elf, 40);
+    put16(elf, count);
+    put16(elf, static_cast<uint16_t>(count - 1));
+    elf += body;
+
+    auto header = [&](uint32_t name, uint32_t type, uint32_t flags, uint32_t address, uint32_t offset,
+                      uint32_t size, uint32_t link, uint32_t entry_size) {
+        put32(elf, name);
+        put32(elf, type);
+        put32(elf, flags);
+        put32(elf, address);
+        put32(elf, offset);
+        put32(elf, size);
+        put32(elf, link);
+        put32(elf, 0);
+        put32(elf, 4);
+        put32(elf, entry_size);
+    };
+    header(0, 0, 0, 0, 0, 0, 0, 0);
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const auto& section = sections[i];
+        header(names[i], section.type, section.flags, section.address, offsets[i], section.size, 0, 0);
+    }
+    header(symtab_name, 2, 0, 0, symtab_offset, static_cast<uint32_t>(symtab.size()),
+           static_cast<uint32_t>(sections.size() + 2), 16);
+    header(strtab_name, 3, 0, 0, strtab_offset, static_cast<uint32_t>(strtab.size()), 0, 0);
+    header(shstrtab_name, 3, 0, 0, shstrtab_offset, static_cast<uint32_t>(shstrtab.size()), 0, 0);
+    return elf;
+}
+
+std::vector<TestSection> esp32_sections(uint32_t iram_size) {
+    return {
+        {".iram0.vectors", 1, 6, 0x40080000, 0x400},
+        {".iram0.text", 1, 6, 0x40080400, iram_size},
+        {".dram0.data", 1, 3, 0x3ffb0000, 0x200},
+        {".dram0.bss", 8, 3, 0x3ffb0200, 0x1000},
+        {".flash.rodata", 1, 2, 0x3f400020, 0x800},
+        {".flash.text", 1, 6, 0x400d0020, 0x4000},
+        {".rtc.text", 1, 6, 0x400c0000, 0x40},
+        {".debug_info", 1, 0, 0, 0x100},
+    };
+}
+
+void test_elf_size_analyzer() {
+    std::string dir = make_temp_dir("elf_size");
+    std::vector<TestSymbol> symbols = {
+        {"_Z9isr_blinkv", 0x40080400, 0x120, 2, 2},
+        {"wifi_buffer", 0x3ffb0200, 0x800, 1, 4},
+        {"boot_count", 0x3ffb0000, 4, 1, 3},
+        {"loop", 0x400d0020, 0x300, 2, 6},
+        {"lookup_table", 0x3f400020, 0x400, 1, 5},
+        {"label_without_size", 0x400d0400, 0, 2, 6},
+    };
+    write_file(dir + "/before.elf", make_elf32(esp32_sections(0x200), symbols));
+
+    ElfSizeAnalyzer analyzer;
+    assert_true(analyzer.Analyze(dir + "/before.elf"), "ELF32 parses: " + analyzer.GetError());
+    const auto& report = analyzer.GetReport();
+    using Region = ElfSizeAnalyzer::Region;
+    auto region = [&](const ElfSizeAnalyzer::SizeReport& r, Region which) {
+        return static_cast<size_t>(r.region_bytes[static_cast<size_t>(which)]);
+    };
+    assert_equal(94, report.machine, "Xtensa machine");
+    assert_equal(7, report.sections.size(), "Only allocated sections");
+    assert_equal(0x600, region(report, Region::IRAM), "IRAM vectors + text");
+    assert_equal(0x1200, region(report, Region::DRAM), "DRAM data + bss");
+    assert_equal(0x4000, region(report, Region::FLASH_CODE), "Flash code");
+    assert_equal(0x800, region(report, Region::FLASH_DATA), "Flash rodata");
+    assert_equal(0x40, region(report, Region::RTC), "RTC");
+    assert_equal(0x600 + 0x200 + 0x800 + 0x4000 + 0x40, static_cast<size_t>(report.flash_bytes),
+                 ".bss is not stored in the image");
+    assert_equal(0x600 + 0x1200 + 0x40, static_cast<size_t>(report.ram_bytes), "RAM total");
+
+    assert_equal(5, report.symbols.size(), "Sized symbols only");
+    assert_true(report.symbols[0].name == "wifi_buffer", "Largest symbol first");
+    assert_true(report.symbols[0].region == Region::DRAM && !report.symbols[0].is_code, "Symbol region");
+    auto iram = analyzer.GetLargestSymbols(10, Region::IRAM);
+    assert_equal(1, iram.size(), "IRAM symbols");
+    assert_true(iram[0].is_code && ElfSizeAnalyzer::Demangle(iram[0].name) == "isr_blink()", "Demangled");
+
+    // Per-object sizes from the linker map
+    write_file(dir + "/firmware.map",
+               "Discarded input sections\n\n"
+               " .text.unused   0x00000000       0x80 build/obj/main.cpp.o\n\n"
+               "Linker script and memory map\n\n"
+               ".iram0.text     0x40080400      0x200\n"
+               " .iram1.1       0x40080400      0x120 build/obj/main.cpp.o\n"
+               "                0x40080400                isr_blink()\n"
+               " *fill*         0x40080520        0x4 \n"
+               " .iram1.2       0x40080524       0xdc libcore.a(wiring.c.o)\n"
+               ".flash.text     0x400d0020     0x4000\n"
+               " .text.a_very_long_function_name_that_wraps\n"
+               "                0x400d0020      0x300 build/obj/main.cpp.o\n"
+               " .dram0.bss     0x3ffb0200      0x800 libcore.a(wifi.c.o)\n"
+               " .debug_info    0x00000000      0x100 build/obj/main.cpp.o\n");
+    assert_true(analyzer.LoadMapFile(dir + "/firmware.map"), "Map file parses: " + analyzer.GetError());
+    const auto& objects = analyzer.GetReport().objects;
+    assert_equal(3, objects.size(), "Objects from the memory map only");
+    assert_true(objects[0].path == "libcore.a(wifi.c.o)" && objects[0].total == 0x800, "Largest object");
+    assert_true(objects[1].path == "build/obj/main.cpp.o", "Wrapped section names");
+    assert_equal(0x120 + 0x300, static_cast<size_t>(objects[1].total), "Discarded sections not counted");
+    assert_equal(0x120, static_cast<size_t>(objects[1].region_bytes[static_cast<size_t>(Region::IRAM)]),
+                 "Object IRAM share");
+
+    // Deltas between two builds
+    symbols[0].size = 0x1a0;
+    symbols.push_back({"new_isr", 0x400805a0, 0x60, 2, 2});
+    write_file(dir + "/after.elf", make_elf32(esp32_sections(0x300), symbols));
+    ElfSizeAnalyzer after;
+    assert_true(after.Analyze(dir + "/after.elf"), "Second ELF parses");
+    auto delta = ElfSizeAnalyzer::Compare(report, after.GetReport());
+    assert_true(delta.region_bytes[static_cast<size_t>(Region::IRAM)] == 0x100, "IRAM growth");
+    assert_true(delta.region_bytes[static_cast<size_t>(Region::DRAM)] == 0, "DRAM unchanged");
+    assert_true(delta.flash_bytes == 0x100, "Image growth");
+    assert_equal(1, delta.sections.size(), "One section changed");
+    assert_equal(2, delta.symbols.size(), "Changed and added symbols");
+    assert_true(delta.symbols[0].name == "_Z9isr_blinkv" && delta.symbols[0].delta == 0x80, "Largest change first");
+    assert_true(delta.symbols[1].name == "new_isr" && delta.symbols[1].before == 0, "Added symbol");
+    assert_true(ElfSizeAnalyzer::FormatDelta(delta).find("isr_blink()") != std::string::npos, "Delta report");
+    assert_true(ElfSizeAnalyzer::FormatReport(report).find(".iram0.text") != std::string::npos, "Report");
+
+    // Rejects what it cannot read
+    write_file(dir + "/junk.elf", "not an elf at all, just some text padding it out");
+    assert_true(!analyzer.Analyze(dir + "/junk.elf"), "Non-ELF rejected");
+    assert_true(!analyzer.Analyze(dir + "/missing.elf"), "Missing file rejected");
+
+    // 100k symbols
+    std::vector<TestSymbol> many;
+    many.reserve(100000);
+    for (uint32_t i = 0; i < 100000; ++i) {
+        many.push_back({"_ZN7modules8function" + std::to_string(i) + "Ev", 0x400d0020 + i * 4, 4 + i % 64, 2, 6});
+    }
+    std::vector<TestSection> big = esp32_sections(0x200);
+    big[5].size = 0x80000;
+    write_file(dir + "/big.elf", make_elf32(big, many));
+    auto start = std::chrono::steady_clock::now();
+    assert_true(analyzer.Analyze(dir + "/big.elf"), "Large ELF parses");
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert_equal(100000, analyzer.GetReport().symbols.size(), "All symbols read");
+    assert_true(elapsed < std::chrono::seconds(1), "100k symbols analyzed quickly");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ELF size analyzer tests passed" << std::endl;
+}
+
+void test_size_history() {
+    std::string dir = make_temp_dir("size_history");
+    using Region = ElfSizeAnalyzer::Region;
+    auto make_report = [](uint64_t loop_size, bool with_buffer) {
+        ElfSizeAnalyzer::SizeReport report = ElfSizeAnalyzer::SizeReport();
+        report.symbols.push_back({"loop", 0x400d0020, loop_size, Region::FLASH_CODE, true});
+        report.symbols.push_back({"_Z9isr_blinkv", 0x40080400, 0x120, Region::IRAM, true});
+        if (with_buffer) report.symbols.push_back({"wifi_buffer", 0x3ffb0200, 0x800, Region::DRAM, false});
+        // Same-named statics from two objects are summed
+        report.symbols.push_back({"counter", 0x3ffb0000, 4, Region::DRAM, false});
+        report.symbols.push_back({"counter", 0x3ffb0004, 4, Region::DRAM, false});
+        for (const auto& symbol : report.symbols) {
+            report.region_bytes[static_cast<size_t>(symbol.region)] += symbol.size;
+        }
+        report.flash_bytes = loop_size + 0x120;
+        report.ram_bytes = report.region_bytes[static_cast<size_t>(Region::IRAM)] +
+                           report.region_bytes[static_cast<size_t>(Region::DRAM)];
+        return report;
+    };
+
+    std::string revision_a(40, 'a');
+    std::string revision_b = "b1c2" + std::string(36, '0');
+    {
+        SizeHistory history(dir);
+        assert_equal(0, history.GetBuildCount(), "Empty history");
+        uint32_t id = 0;
+        assert_true(!history.ResolveBuild("latest", id), "Nothing to resolve");
+        assert_true(history.Record(make_report(0x300, false), "ESP32", revision_a, 1000), history.GetError());
+        assert_true(history.Record(make_report(0x340, true), "ESP32", revision_b, 2000), "Second build");
+    }
+
+    // A fresh instance reads the same history and keeps appending
+    SizeHistory history(dir);
+    assert_true(history.Record(make_report(0x320, true), "ESP32-S3", "", 3000), "Third build");
+    assert_equal(3, history.GetBuildCount(), "Three builds");
+    SizeHistory::BuildRecord build;
+    assert_true(history.GetBuild(1, build), "Build readable");
+    assert_true(build.revision == revision_b && build.board == "ESP32" && build.timestamp == 2000, "Build row");
+    assert_equal(0x340 + 0x120, static_cast<size_t>(build.flash_bytes), "Flash total");
+    assert_equal(4, build.symbol_count, "Duplicate names summed");
+
+    uint32_t id = 0;
+    assert_true(history.ResolveBuild("latest", id) && id == 2, "latest");
+    assert_true(history.ResolveBuild("latest~2", id) && id == 0, "latest~N");
+    assert_true(history.ResolveBuild("1", id) && id == 1, "Build id");
+    assert_true(history.ResolveBuild("b1c2", id) && id == 1, "Revision prefix");
+    assert_true(!history.ResolveBuild("7", id) && !history.ResolveBuild("latest~3", id), "Out of range");
+    assert_true(!history.ResolveBuild("ffff", id), "Unknown revision");
+
+    std::vector<SizeHistory::SymbolSize> symbols;
+    assert_true(history.GetSymbols(0, symbols), "Symbols readable");
+    assert_equal(3, symbols.size(), "Symbols of the first build");
+    assert_true(symbols[0].name == "loop" && symbols[0].size == 0x300 && symbols[0].region == Region::FLASH_CODE,
+                "Largest first, region kept");
+    assert_true(symbols[2].name == "counter" && symbols[2].size == 8, "Summed symbol");
+
+    ElfSizeAnalyzer::SizeDelta delta;
+    assert_true(history.Diff(0, 1, delta), "Diff");
+    assert_true(delta.flash_bytes == 0x40 && delta.region_bytes[static_cast<size_t>(Region::DRAM)] == 0x800,
+                "Region deltas");
+    assert_equal(2, delta.symbols.size(), "Changed symbols");
+    auto growers = history.GetTopGrowers(0, 2, 10);
+    assert_equal(2, growers.size(), "Only growth listed");
+    assert_true(growers[0].name == "wifi_buffer" && growers[0].before == 0, "Added symbol grows most");
+    assert_true(growers[1].name == "loop" && growers[1].delta == 0x20, "Then the grown function");
+
+    auto points = history.GetSymbolHistory("loop", 0, 10);
+    assert_equal(3, points.size(), "One point per build");
+    assert_true(points[0].size == 0x300 && points[1].size == 0x340 && points[2].size == 0x320, "Symbol history");
+    auto missing = history.GetSymbolHistory("wifi_buffer", 0, 1);
+    assert_true(missing.size() == 1 && missing[0].size == 0, "Absent symbol reads as zero");
+
+    // An interrupted write leaves tails that are ignored, then trimmed
+    {
+        std::ofstream index(dir + "/builds.idx", std::ios::binary | std::ios::app);
+        index << "partial row";
+        std::ofstream columns(dir + "/sizes.col", std::ios::binary | std::ios::app);
+        columns << "orphaned segment";
+        std::ofstream names(dir + "/symbols.dict", std::ios::binary | std::ios::app);
+        names << "\x40\x00\x00\x00half";
+    }
+    assert_equal(3, history.GetBuildCount(), "Partial row not counted");
+    assert_true(history.Record(make_report(0x310, true), "ESP32", "", 4000), "Record after a crash");
+    assert_true(history.GetSymbols(3, symbols) && symbols.size() == 4, "New build intact");
+    assert_true(history.GetSymbolHistory("loop", 3, 1)[0].size == 0x310, "Columns appended after trimming");
+
+    // Column lengths that run past the segment are rejected, not followed
+    {
+        std::fstream columns(dir + "/sizes.col", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t ids_bytes = 0xFFFFFFF0u;
+        columns.seekp(16);
+        columns.write(reinterpret_cast<const char*>(&ids_bytes), sizeof(ids_bytes));
+    }
+    assert_true(!history.GetSymbols(0, symbols), "Corrupt segment rejected");
+    assert_true(history.GetSymbolHistory("loop", 0, 1)[0].size == 0, "Corrupt segment reads as absent");
+    std::filesystem::resize_file(dir + "/sizes.col", 16);
+    assert_true(!history.GetSymbols(3, symbols), "Truncated columns rejected");
+    assert_true(history.GetSymbolHistory("loop", 3, 1)[0].size == 0, "Truncated columns read as absent");
+
+    // Thousands of builds are queried without reading them all
+    std::string big_dir = make_temp_dir("size_history_big");
+    SizeHistory big(big_dir);
+    ElfSizeAnalyzer::SizeReport report = ElfSizeAnalyzer::SizeReport();
+    for (int i = 0; i < 300; ++i) {
+        report.symbols.push_back({"function_" + std::to_string(i), 0, 100, Region::FLASH_CODE, true});
+    }
+    for (int build_index = 0; build_index < 2000; ++build_index) {
+        report.symbols[build_index % 300].size += 4;
+        report.flash_bytes += 4;
+        assert_true(big.Record(report, "ESP32", "", 1000 + build_index), "Bulk record");
+    }
+    auto start = std::chrono::steady_clock::now();
+    assert_equal(2000, big.GetBuildCount(), "All builds recorded");
+    assert_equal(2000, big.GetBuilds(0, 5000).size(), "Index scan");
+    assert_true(big.ResolveBuild("latest~1999", id) && id == 0, "Oldest build");
+    auto top = big.GetTopGrowers(0, 1999, 3);
+    assert_true(top.size() == 3 && top[0].delta == 28, "Top growers across the history");
+    auto trend = big.GetSymbolHistory("function_299", 0, 2000);
+    assert_true(trend.size() == 2000 && trend.back().size == 100 + 4 * 6, "Symbol across every build");
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    assert_true(elapsed < std::chrono::seconds(1), "History queries are fast");
+
+    std::filesystem::remove_all(dir);
+    std::filesystem::remove_all(big_dir);
+    std::cout << "  ✓ Size history tests passed" << std::endl;
+}
+
+void test_compiler_size_report() {
+    std::string dir = make_temp_dir("size_project");
+    write_file(dir + "/table.cpp", "extern const int table[256] = {1};\nint counter[64];\n");
+
+    ESP32Compiler compiler;
+    compiler.GetCompilerManager().RegisterCompiler(host_compiler());
+    ESP32Compiler::BuildSettings settings;
+    settings.project_dir = dir;
+    settings.compiler_id = "host";
+    compiler.SetBuildSettings(settings);
+    assert_true(compiler.GetLastSizeReport() == nullptr, "No report before a build");
+
+    std::string sketch = "void setup() {}\nvoid loop() {}\nint main() { setup(); loop(); return 0; }\n";
+    auto result = compiler.Compile(sketch, ESP32Compiler::BoardType::ESP32);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Sketch builds");
+    const auto* report = compiler.GetLastSizeReport();
+    assert_true(report != nullptr, "Size report after a build");
+    assert_equal(static_cast<size_t>(report->flash_bytes), result.program_size, "program_size from the ELF");
+    assert_true(result.program_size > 1024, "Image has a real size");
+    assert_true(result.data_size >= 64 * sizeof(int), "Globals counted in data_size");
+    assert_true(!report->objects.empty(), "Objects attributed through the map file");
+
+    auto metrics = compiler.AnalyzePerformance(sketch);
+    assert_equal(static_cast<size_t>(report->flash_bytes), metrics.estimated_flash_usage,
+                 "Flash usage is measured, not estimated");
+
+    // Relinked images go into the project's size history
+    SizeHistory history(SizeHistory::GetDefaultDirectory(dir));
+    assert_equal(1, history.GetBuildCount(), "Build recorded");
+    compiler.Compile(sketch, ESP32Compiler::BoardType::ESP32);
+    assert_equal(1, history.GetBuildCount(), "Unchanged image not recorded again");
+    compiler.Compile(sketch + "int extra[32];\n", ESP32Compiler::BoardType::ESP32);
+    assert_equal(2, history.GetBuildCount(), "Relinked image recorded");
+    SizeHistory::BuildRecord build;
+    assert_true(history.GetBuild(1, build) && build.board == compiler.GetBoardName(ESP32Compiler::BoardType::ESP32),
+                "Board recorded");
+    auto growers = history.GetTopGrowers(0, 1, 5);
+    assert_true(!growers.empty() && growers[0].name == "extra" && growers[0].delta == 32 * sizeof(int),
+                "Growth traced to the new symbol");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ESP32Compiler size report tests passed" << std::endl;
+}
+
+// ============================================================================
+// App Image Tests
+// ============================================================================
+
+uint32_t get32(const std::string& data, size_t at) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(data[at + i])) << (8 * i);
+    }
+    return value;
+}
+
+// Minimal little-endian ELF32 with one PT_LOAD per segment
+std::string make_elf32_segments(const std::vector<AppImage::Segment>& segments, uint32_t entry) {
+    std::string elf("\x7f" "ELF", 4);
+    elf += '\x01';                      // ELFCLASS32
+    elf += '\x01';                      // little endian
+    elf += '\x01';
+    elf.append(9, '\0');
+    put16(elf, 2);                      // ET_EXEC
+    put16(elf, 94);                     // EM_XTENSA
+    put32(elf, 1);
+    put32(elf, entry);
+    put32(elf, 52);                     // program headers right after this one
+    put32(elf, 0);
+    put32(elf, 0);
+    put16(elf, 52);
+    put16(elf, 32);
+    put16(elf, static_cast<uint16_t>(segments.size()));
+    put16(elf, 40);
+    put16(elf, 0);
+    put16(elf, 0);
+    uint32_t offset = 52 + 32 * static_cast<uint32_t>(segments.size());
+    for (const auto& segment : segments) {
+        uint32_t size = static_cast<uint32_t>(segment.data.size());
+        put32(elf, 1);                  // PT_LOAD
+        put32(elf, offset);
+        put32(elf, segment.address);
+        put32(elf, segment.address);
+        put32(elf, size);
+        put32(elf, size + 0x100);       // some .bss that stays out of the image
+        put32(elf, 7);
+        put32(elf, 4);
+        offset += size;
+    }
+    for (const auto& segment : segments) {
+        elf += segment.data;
+    }
+    return elf;
+}
+
+std::string pattern(size_t size, unsigned seed) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<char>((i * 7 + seed) % 251 + 1);
+    }
+    return data;
+}
+
+void test_app_image() {
+    std::string dir = make_temp_dir("app_image");
+    const AppImage::Chip esp32 = {0, 0x400D0000, 0x40400000, 0x3F400000, 0x3F800000};
+    std::vector<AppImage::Segment> segments = {
+        {0x40080000, pattern(0x400, 1)},        // IRAM
+        {0x40080400, pattern(0x1802, 2)},       // touches the one before
+        {0x3ffb0000, pattern(0x200, 3)},        // DRAM
+        {0x3f400020, pattern(0x800, 4)},        // DROM
+        {0x400d0020, pattern(0x4000, 5)},       // IROM
+    };
+    write_file(dir + "/app.elf", make_elf32_segments(segments, 0x40080404));
+
+    AppImage app;
+    assert_true(app.LoadElf(dir + "/app.elf"), "ELF loads: " + app.GetError());
+    assert_equal(5, app.GetSegments().size(), "One segment per PT_LOAD with contents");
+    assert_equal(0x40080404, app.GetEntry(), "Entry point");
+    assert_true(app.GetSegments()[0].address == 0x3f400020, "Sorted by address");
+    assert_true(app.Write(esp32, dir + "/app.bin"), "Image written: " + app.GetError());
+
+    std::ifstream in(dir + "/app.bin", std::ios::binary);
+    std::string image((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    assert_true(static_cast<unsigned char>(image[0]) == 0xE9, "Image magic");
+    assert_equal(0x40080404, get32(image, 4), "Entry in the header");
+    assert_equal(0, static_cast<unsigned char>(image[12]) | (static_cast<unsigned char>(image[13]) << 8),
+                 "ESP32 chip id");
+
+    // Every loaded byte is in the image, flash segments at their page offsets
+    std::map<uint32_t, char> memory;
+    size_t position = 24;
+    uint8_t checksum = 0xEF;
+    for (int i = 0; i < image[1]; ++i) {
+        uint32_t address = get32(image, position);
+        uint32_t length = get32(image, position + 4);
+        position += 8;
+        assert_equal(0, length % 4, "Segments are whole words");
+        if ((address >= 0x400D0000 && address < 0x40400000) || (address >= 0x3F400000 && address < 0x3F800000)) {
+            assert_equal(address % 0x10000, position % 0x10000, "Flash segment mapped in place");
+        }
+        for (uint32_t j = 0; j < length; ++j) {
+            checksum ^= static_cast<uint8_t>(image[position + j]);
+            if (address != 0) memory[address + j] = image[position + j];
+        }
+        position += length;
+    }
+    for (const auto& segment : segments) {
+        for (size_t j = 0; j < segment.data.size(); ++j) {
+            auto found = memory.find(segment.address + static_cast<uint32_t>(j));
+            assert_true(found != memory.end() && found->second == segment.data[j],
+                        "Byte " + std::to_string(j) + " of the segment at " + std::to_string(segment.address));
+        }
+    }
+    assert_true(image.size() - 33 >= position && image.size() - 33 < position + 16, "Padding before the checksum");
+    assert_equal(15, (image.size() - 33) % 16, "Checksum ends a 16-byte block");
+    assert_equal(checksum, static_cast<unsigned char>(image[image.size() - 33]), "Seeded XOR checksum");
+
+    // The MMU cannot map two segments into one page
+    segments.push_back({0x400d8000, pattern(0x100, 6)});
+    write_file(dir + "/clash.elf", make_elf32_segments(segments, 0x40080404));
+    std::string unused;
+    assert_true(app.LoadElf(dir + "/clash.elf"), "ELF loads");
+    assert_true(!app.Build(esp32, unused) && app.GetError().find("share") != std::string::npos,
+                "Overlapping flash pages are refused: " + app.GetError());
+    write_file(dir + "/text.elf", "not an ELF");
+    assert_true(!app.LoadElf(dir + "/text.elf"), "Non-ELF input fails");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ App image tests passed" << std::endl;
+}
+
+// ============================================================================
+// Build Matrix Tests
+// ============================================================================
+
+void test_board_targets() {
+    platform::MultiBoardSupport boards;
+    assert_true(boards.SelectBoard("esp32"), "Default board");
+    assert_true(boards.GetCompilerFlags("nano") != boards.GetCompilerFlags(), "Flags for any board");
+    assert_true(boards.GetCompilerFlags("esp32") == boards.GetCompilerFlags(), "Selected board unchanged");
+    assert_true(boards.GetLinkerFlags("no_such_board").empty(), "Unknown board has no flags");
+
+    BuildMatrix::Target target;
+    assert_true(BuildMatrix::MakeTarget(boards, "esp8266", "xtensa-lx106", target), "Registered board");
+    assert_true(target.compiler_id == "xtensa-lx106" && target.name == "ESP8266 Generic", "Target identity");
+    assert_true(target.board_flags.find("-DESP8266") != std::string::npos &&
+                target.board_flags.find("-DF_CPU=80000000L") != std::string::npos, "Board define and flags");
+    assert_true(std::find(target.link_flags.begin(), target.link_flags.end(), "-Wl,--gc-sections") !=
+                target.link_flags.end(), "Linker flags split");
+    assert_true(!BuildMatrix::MakeTarget(boards, "no_such_board", "host", target), "Unknown board rejected");
+
+    std::cout << "  ✓ Board target tests passed" << std::endl;
+}
+
+void test_build_matrix() {
+    std::string dir = make_temp_dir("build_matrix");
+    write_file(dir + "/board.h",
+               "#ifdef BREAK_BOARD\n#error unsupported board\n#endif\n"
+               "#define BOARD_SCALE (BOARD_ID * 2)\n");
+    write_file(dir + "/driver.cpp", "#include \"board.h\"\nint driver_scale() { return BOARD_SCALE; }\n");
+    write_file(dir + "/util.cpp", "int util_value() { return 3; }\n");
+    write_file(dir + "/main.cpp",
+               "#include \"board.h\"\nint driver_scale();\nint util_value();\n"
+               "int main() { return driver_scale() + util_value() == BOARD_SCALE + 3 ? 0 : 1; }\n");
+
+    CustomCompilerManager compilers;
+    compilers.RegisterCompiler(host_compiler());
+
+    BuildEngine::BuildConfig config;
+    config.build_dir = dir + "/.esp32ide/matrix";
+    config.compiler_id = "host";
+    config.source_dirs = {dir};
+    config.include_paths = {dir};
+    config.output_name = "app";
+    config.jobs = 4;
+    config.memory_budget_mb = 0;
+
+    std::vector<BuildMatrix::Target> targets;
+    for (int i = 1; i <= 4; ++i) {
+        BuildMatrix::Target target;
+        target.board_id = "board" + std::to_string(i);
+        target.name = "Board " + std::to_string(i);
+        target.compiler_id = "host";
+        target.board_flags = "-DBOARD_ID=" + std::to_string(i);
+        targets.push_back(target);
+    }
+    targets[2].board_flags += " -DBREAK_BOARD";
+
+    std::mutex output_mutex;
+    std::vector<std::string> lines;
+    BuildMatrix matrix(compilers);
+    matrix.SetBaseConfig(config);
+    matrix.SetMaxConcurrentBoards(4);
+    matrix.SetOutputCallback([&](const std::string& line, bool) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        lines.push_back(line);
+    });
+
+    auto result = matrix.Build(targets);
+    assert_true(!result.success, "A broken board fails the matrix");
+    assert_equal(4, result.boards.size(), "One result per board");
+    assert_equal(3, result.shared_sources, "Sources collected once");
+    assert_true(result.shared_files >= 4, "Headers scanned once");
+    assert_true(result.peak_boards >= 2, "Boards build concurrently");
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const auto& board = result.boards[i];
+        assert_true(board.target.board_id == targets[i].board_id, "Results in target order");
+        if (i == 2) {
+            assert_true(!board.build.success && board.errors > 0, "Broken board reports its error");
+            continue;
+        }
+        assert_true(board.build.success, "Other boards still build: " + board.build.log);
+        assert_equal(3, board.build.units_compiled, "Every unit per board");
+        assert_true(board.flash_bytes > 0, "Image measured");
+        assert_equal(0, static_cast<size_t>(std::system(board.build.output_file.c_str())),
+                     "Board-specific program runs");
+    }
+    assert_true(std::filesystem::exists(matrix.GetBoardDirectory("board1") + "/app") &&
+                std::filesystem::exists(matrix.GetBoardDirectory("board4") + "/app"), "Separate build directories");
+    bool prefixed = std::any_of(lines.begin(), lines.end(), [](const std::string& line) {
+        return line.compare(0, 9, "[board3] ") == 0;
+    });
+    assert_true(prefixed, "Output tagged with the board");
+
+    std::string table = BuildMatrix::FormatTable(result);
+    assert_true(table.find("Board 1") != std::string::npos && table.find("FAILED") != std::string::npos,
+                "Table lists every board");
+    assert_true(table.find("3 of 4 board(s) built") != std::string::npos, "Table summary");
+
+    // Each board stays incremental on its own
+    targets[2].board_flags = "-DBOARD_ID=3";
+    result = matrix.Build(targets);
+    assert_true(result.success, "Fixed board builds");
+    assert_equal(0, result.boards[0].build.units_compiled, "Unchanged board compiles nothing");
+    assert_equal(3, result.boards[2].build.units_compiled, "Fixed board compiles");
+
+    write_file(dir + "/board.h", "#define BOARD_SCALE (BOARD_ID * 3)\n");
+    bump_mtime(dir + "/board.h");
+    result = matrix.Build(targets);
+    assert_true(result.success, "Header change builds");
+    for (const auto& board : result.boards) {
+        assert_equal(2, board.build.units_compiled, "Only includers of the header rebuild");
+    }
+
+    // An engine handed a scan neither walks the tree nor re-reads files
+    BuildGraph files;
+    files.SetIncludePaths(config.include_paths);
+    files.BeginPass();
+    BuildEngine::SharedScan scan;
+    scan.sources = {dir + "/main.cpp"};
+    scan.files = &files;
+    files.ComputeSignature(scan.sources[0], {});
+    BuildEngine engine(compilers);
+    config.build_dir = dir + "/.esp32ide/shared_scan";
+    engine.SetConfig(config);
+    engine.SetSharedScan(&scan);
+    auto single = engine.Build();
+    assert_true(!single.success && single.units_total == 1, "Source list taken from the scan");
+    assert_equal(0, engine.GetGraph().GetFilesRehashed(), "File nodes taken from the scan");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Build matrix tests passed" << std::endl;
+}
+
+void test_compiler_matrix() {
+    std::string dir = make_temp_dir("compiler_matrix");
+    write_file(dir + "/helper.cpp", "int helper() { return BOARD_ID; }\n");
+
+    ESP32Compiler compiler;
+    compiler.GetCompilerManager().RegisterCompiler(host_compiler());
+    ESP32Compiler::BuildSettings settings;
+    settings.project_dir = dir;
+    settings.compiler_id = "host";
+    settings.board_flags = "-DBOARD_ID=99";
+    compiler.SetBuildSettings(settings);
+
+    std::vector<BuildMatrix::Target> targets(2);
+    targets[0] = {"a", "Board A", "host", "-DBOARD_ID=1", {}};
+    targets[1] = {"b", "Board B", "host", "-DBOARD_ID=2", {}};
+    std::string table;
+    compiler.SetOutputCallback([&](const std::string& message, ESP32Compiler::CompileStatus) {
+        if (message.find("board(s) built") != std::string::npos) table = message;
+    });
+    std::string sketch = "int helper();\nint main() { return helper() == BOARD_ID ? 0 : 1; }\n";
+    auto result = compiler.CompileMatrix(sketch, targets);
+    assert_true(result.success, "Sketch builds for every board");
+    assert_equal(2, result.shared_sources, "Sketch and project source");
+    for (const auto& board : result.boards) {
+        assert_equal(0, static_cast<size_t>(std::system(board.build.output_file.c_str())),
+                     "Built with the target's flags, not the selected board's");
+    }
+    assert_true(table.find("Board B") != std::string::npos, "Table sent to the output");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ESP32Compiler matrix tests passed" << std::endl;
+}
+
+// ============================================================================
+// Library Index Tests
+// ============================================================================
+
+// Library folder with a library.properties (empty properties = legacy layout)
+void make_library(const std::string& root, const std::string& folder, const std::string& properties,
+                  const std::vector<std::pair<std::string, std::string>>& files) {
+    std::string dir = root + "/" + folder;
+    std::filesystem::create_directories(dir);
+    if (!properties.empty()) {
+        write_file(dir + "/library.properties", properties);
+    }
+    for (const auto& file : files) {
+        std::filesystem::create_directories(std::filesystem::path(dir + "/" + file.first).parent_path());
+        write_file(dir + "/" + file.first, file.second);
+    }
+}
+
+void test_library_index() {
+    std::string dir = make_temp_dir("library_index");
+    std::string builtin = dir + "/builtin";
+    std::string platform = dir + "/platform";
+    std::string user = dir + "/user";
+    std::filesystem::create_directories(builtin);
+    std::filesystem::create_directories(platform);
+    std::filesystem::create_directories(user);
+
+    // Servo.h: generic builtin, esp32-only platform copy, avr-only user copy
+    make_library(builtin, "Servo", "name=Servo\narchitectures=*\n", {{"src/Servo.h", ""}});
+    make_library(platform, "ESP32Servo", "name=ESP32Servo\narchitectures=esp32\n", {{"src/Servo.h", ""}});
+    make_library(user, "Servo", "name=Servo\narchitectures=avr\n", {{"src/Servo.h", ""}});
+    // Sensor.h: name match beats location
+    make_library(user, "AcmeSensorPack", "name=Acme\n", {{"src/Sensor.h", ""}});
+    make_library(builtin, "Sensor", "name=Sensor\n", {{"src/Sensor.h", ""}});
+    // Display.h pulls in Wire.h from its sources; Wire is a legacy layout library
+    make_library(user, "Display", "name=Display\nversion=1.2.0\nincludes=Display.h,Fonts.h\n",
+                 {{"src/Display.h", "#include \"Fonts.h\"\n"}, {"src/Fonts.h", ""},
+                  {"src/impl/bus.cpp", "#include <Wire.h>\n#include <Arduino.h>\n"}});
+    make_library(platform, "Wire", "", {{"Wire.h", ""}, {"Wire.cpp", ""}, {"utility/twi.c", "#include <SPI.h>\n"},
+                                        {"examples/Scan/Scan.cpp", ""}, {"test/wire_test.cpp", ""}});
+    make_library(platform, "SPI", "name=SPI\narchitectures=esp32\n", {{"src/SPI.h", ""}});
+    // Not a library: no headers
+    std::filesystem::create_directories(user + "/examples");
+
+    LibraryIndex index;
+    index.AddSearchRoot(user, LibraryIndex::Location::USER);
+    index.AddSearchRoot(platform, LibraryIndex::Location::PLATFORM);
+    index.AddSearchRoot(builtin, LibraryIndex::Location::BUILTIN);
+    assert_equal(8, index.Update(), "Every library read");
+    assert_equal(8, index.GetLibraryCount(), "Folders without headers skipped");
+    assert_equal(3, index.GetCandidates("Servo.h").size(), "Three libraries provide Servo.h");
+
+    assert_true(LibraryIndex::GetArchitecture("esp32:esp32:esp32s3") == "esp32", "Architecture from FQBN");
+    assert_true(index.Resolve("Servo.h", "esp32")->folder == "ESP32Servo", "Explicit architecture wins");
+    assert_true(index.Resolve("Servo.h", "avr")->path == user + "/Servo", "Compatible user library");
+    assert_true(index.Resolve("Servo.h", "rp2040")->path == builtin + "/Servo", "Generic library for others");
+    assert_true(index.Resolve("Sensor.h", "esp32")->folder == "Sensor", "Exact name beats location");
+    assert_true(index.Resolve("SPI.h", "avr") == nullptr, "Incompatible library never picked");
+
+    const LibraryIndex::Library* display = index.FindLibrary("Display");
+    assert_true(display && display->version == "1.2.0", "Properties read");
+    assert_true(display->include_dir == user + "/Display/src", "1.5 layout uses src/");
+    assert_equal(2, display->default_includes.size(), "includes= property");
+    assert_equal(2, display->includes.size(), "Own headers are not dependencies");
+    const LibraryIndex::Library* wire = index.FindLibrary("Wire");
+    assert_true(wire && wire->include_dir == platform + "/Wire", "Legacy layout uses the root");
+    assert_true(wire->default_includes.size() == 1 && wire->default_includes[0] == "Wire.h", "Every header by default");
+    assert_true(wire->sources.size() == 2 && wire->sources[0] == platform + "/Wire/Wire.cpp" &&
+                wire->sources[1] == platform + "/Wire/utility/twi.c",
+                "Legacy sources are the root and utility/, not examples/ or test/");
+    assert_true(display->sources.size() == 1 && display->sources[0] == user + "/Display/src/impl/bus.cpp",
+                "1.5 sources are everything under src/");
+
+    // One pass follows Display -> Wire -> SPI; core headers stay unresolved
+    auto resolution = index.ResolveSource("#include <Display.h>\n#include <Servo.h>\n#include <Arduino.h>\n", "esp32");
+    assert_equal(4, resolution.libraries.size(), "Sketch libraries and theirs");
+    assert_true(resolution.libraries[0]->folder == "Display" && resolution.libraries[1]->folder == "ESP32Servo" &&
+                resolution.libraries[2]->folder == "Wire" && resolution.libraries[3]->folder == "SPI",
+                "Discovery order");
+    assert_true(resolution.unresolved.size() == 1 && resolution.unresolved[0] == "Arduino.h",
+                "Only the sketch's own misses reported");
+
+    // Persisted index: nothing re-read until a library changes
+    std::string index_path = dir + "/libraries.idx";
+    assert_true(index.IsDirty() && index.Save(index_path), "Index saved");
+    LibraryIndex reloaded;
+    reloaded.AddSearchRoot(user, LibraryIndex::Location::USER);
+    reloaded.AddSearchRoot(platform, LibraryIndex::Location::PLATFORM);
+    reloaded.AddSearchRoot(builtin, LibraryIndex::Location::BUILTIN);
+    assert_true(reloaded.Load(index_path), "Index loaded");
+    assert_equal(8, reloaded.GetLibraryCount(), "Libraries restored");
+    assert_true(reloaded.Resolve("Servo.h", "esp32")->folder == "ESP32Servo", "Lookups work after load");
+    assert_equal(2, reloaded.FindLibrary("Wire")->sources.size(), "Sources restored");
+    assert_equal(0, reloaded.Update(), "Unchanged libraries not re-read");
+    assert_true(!reloaded.IsDirty(), "Nothing to save");
+
+    write_file(platform + "/SPI/library.properties", "name=SPI\narchitectures=esp32,avr\n");
+    bump_mtime(platform + "/SPI/library.properties");
+    std::filesystem::remove_all(builtin + "/Sensor");
+    assert_equal(2, reloaded.Update(), "Changed and removed libraries only");
+    assert_true(reloaded.Resolve("SPI.h", "avr") != nullptr, "Changed properties picked up");
+    assert_true(reloaded.Resolve("Sensor.h", "esp32")->folder == "AcmeSensorPack", "Removed library dropped");
+
+    // An edit deep in src/ leaves every directory mtime alone
+    write_file(user + "/Display/src/impl/bus.cpp", "#include <Wire.h>\n#include <Arduino.h>\n#include <Servo.h>\n");
+    bump_mtime(user + "/Display/src/impl/bus.cpp");
+    assert_equal(1, reloaded.Update(), "Nested source edit re-reads its library");
+    assert_equal(3, reloaded.FindLibrary("Display")->includes.size(), "New include picked up");
+    assert_equal(0, reloaded.Update(), "Stamp stable across walks");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Library index tests passed" << std::endl;
+}
+
+void test_compiler_library_sources() {
+    std::string dir = make_temp_dir("library_sources");
+    std::string project = dir + "/project";
+    std::filesystem::create_directories(project);
+    // A legacy library whose example and test each define main()
+    make_library(dir + "/libraries", "Blink", "",
+                 {{"Blink.h", "int blink_count();\n"},
+                  {"Blink.cpp", "#include \"Blink.h\"\n#include \"utility/pins.h\"\nint blink_count() { return kPins; }\n"},
+                  {"utility/pins.h", "const int kPins = 0;\n"},
+                  {"examples/Demo/Demo.cpp", "int main() { return 1; }\n"},
+                  {"test/blink_test.cpp", "int main() { return 2; }\n"}});
+    LibraryIndex index;
+    index.AddSearchRoot(dir + "/libraries", LibraryIndex::Location::USER);
+    index.Update();
+    const LibraryIndex::Library* blink = index.FindLibrary("Blink");
+    assert_true(blink != nullptr, "Library indexed");
+
+    ESP32Compiler compiler;
+    compiler.GetCompilerManager().RegisterCompiler(host_compiler());
+    ESP32Compiler::BuildSettings settings;
+    settings.project_dir = project;
+    settings.compiler_id = "host";
+    compiler.SetBuildSettings(settings);
+
+    ESP32Compiler::LibraryInputs libraries;
+    libraries.include_paths.push_back(blink->include_dir);
+    libraries.sources = blink->sources;
+    std::string sketch =
+        "#include <Blink.h>\n"
+        "void setup() {}\n"
+        "void loop() {}\n"
+        "int main() { setup(); loop(); return blink_count(); }\n";
+    auto result = compiler.Compile(sketch, ESP32Compiler::BoardType::ESP32, libraries);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Sketch links with the library only once");
+    assert_equal(2, result.units_total, "Sketch and Blink.cpp, not the example or test");
+    assert_equal(0, static_cast<size_t>(std::system(result.output_file.c_str())), "Linked program runs");
+
+    // The next build without the library does not carry it along
+    result = compiler.Compile("void setup() {}\nvoid loop() {}\nint main() { return 0; }\n",
+                              ESP32Compiler::BoardType::ESP32);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Sketch builds alone");
+    assert_equal(1, result.units_total, "Dropped library is not built");
+    assert_true(compiler.GetBuildSettings().include_paths.empty() && compiler.GetBuildSettings().source_dirs.empty(),
+                "Build settings are left as configured");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ ESP32Compiler library source tests passed" << std::endl;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "ESP32 Driver IDE - Build Engine Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    // Keep ESP32Compiler's shared cache out of the user's home directory
+    std::string cache_dir = make_temp_dir("object_cache");
+    setenv("ESP32_IDE_CACHE_DIR", cache_dir.c_str(), 1);
+
+    try {
+        std::cout << "Dependency Graph Tests:" << std::endl;
+        test_include_scanner();
+        test_graph_signatures();
+
+        std::cout << "\nScheduler Tests:" << std::endl;
+        test_scheduler_dag_and_priority();
+        test_scheduler_failure();
+        test_scheduler_parallelism_and_memory();
+        test_scheduler_output_not_interleaved();
+
+        std::cout << "\nToolchain Tests:" << std::endl;
+        test_run_process();
+        test_incremental_build();
+        test_parallel_build();
+        test_compiler_project_build();
+        test_precompiled_header();
+
+        std::cout << "\nDiagnostic Parser Tests:" << std::endl;
+        test_diagnostic_parser_grouping();
+        test_diagnostic_parser_streaming();
+
+        std::cout << "\nSize Analyzer Tests:" << std::endl;
+        test_elf_size_analyzer();
+        test_size_history();
+        test_compiler_size_report();
+
+        std::cout << "\nApp Image Tests:" << std::endl;
+        test_app_image();
+
+        std::cout << "\nBuild Matrix Tests:" << std::endl;
+        test_board_targets();
+        test_build_matrix();
+        test_compiler_matrix();
+
+        std::cout << "\nLibrary Index Tests:" << std::endl;
+        test_library_index();
+        test_compiler_library_sources();
+
+        std::cout << "\nObject Cache Tests:" << std::endl;
+        test_object_cache_keys();
+        test_object_cache_store_and_evict();
+        test_object_cache_build();
+
+        std::cout << std::endl;
+        std::cout << "========================================" << std::endl;
+        std::cout << "✓ ALL BUILD ENGINE TESTS PASSED!" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ TEST FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,298 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <filesystem>
+
+#include "terminal/terminal_daemon.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+
+using namespace esp32_ide::daemon;
+
+// ============================================================================
+// Helper assertion functions
+// ============================================================================
+
+void assert_true(bool condition, const std::string& message = "") {
+    if (!condition) {
+        throw std::runtime_error("Assertion failed: " + message);
+    }
+}
+
+void assert_equal(long long expected, long long actual, const std::string& message = "") {
+    if (expected != actual) {
+        throw std::runtime_error("Assertion failed: expected " + std::to_string(expected) +
+                                " but got " + std::to_string(actual) + ". " + message);
+    }
+}
+
+std::string make_socket_path(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / ("esp32ide_" + name + ".sock");
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+int connect_raw(const std::string& socket_path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ============================================================================
+// Protocol Tests
+// ============================================================================
+
+void test_request_encoding() {
+    Request request;
+    request.cwd = "/work/project";
+    request.color = true;
+    request.args = {"verify", "main.ino", ""};
+
+    Request decoded;
+    assert_true(DecodeRequest(EncodeRequest(request), decoded), "Request should decode");
+    assert_true(decoded.cwd == request.cwd, "Working directory should round trip");
+    assert_true(decoded.color, "Color flag should round trip");
+    assert_equal(3, decoded.args.size(), "Empty arguments should be preserved");
+    assert_true(decoded.args[1] == "main.ino", "Arguments should round trip");
+
+    assert_true(!DecodeRequest(std::string("9\0/\0" "0", 5), decoded), "Unknown versions are rejected");
+
+    std::cout << "  ✓ Request encoding tests passed" << std::endl;
+}
+
+// ============================================================================
+// Server Tests
+// ============================================================================
+
+void test_daemon_round_trip() {
+    std::string socket_path = make_socket_path("daemon");
+    std::string work_dir = std::filesystem::temp_directory_path().string();
+
+    int initializations = 1;  // stands in for warm backend state
+    int handled = 0;
+    std::string seen_cwd;
+    DaemonServer server(socket_path, [&](const Request& request) {
+        handled++;
+        seen_cwd = std::filesystem::current_path().string();
+        std::cout << "args=" << request.args.size() << " warm=" << initializations << std::endl;
+        std::cerr << "to stderr" << std::endl;
+        std::string big(20000, 'x');
+        std::cout << big;
+        std::string input;
+        std::getline(std::cin, input);
+        return request.args.empty() ? 3 : std::stoi(request.args[0]);
+    });
+    assert_true(server.Start(), "Server should start: " + server.GetError());
+
+    DaemonServer duplicate(socket_path, nullptr);
+    assert_true(!duplicate.Start(), "A second daemon must not steal the socket");
+
+    std::thread serve([&server]() { server.Run(); });
+
+    DaemonClient client(socket_path);
+    assert_true(client.Ping(), "Ping should reach the daemon");
+
+    for (int i = 0; i < 3; ++i) {
+        Request request;
+        request.cwd = work_dir;
+        request.color = false;
+        request.args = {std::to_string(i + 5), "extra"};
+
+        std::string output;
+        int exit_code = -1;
+        assert_true(client.Execute(request, exit_code, [&output](const char* data, size_t size) {
+            output.append(data, size);
+        }), "Execute should succeed: " + client.GetError());
+        assert_equal(i + 5, exit_code, "Exit code should be forwarded");
+        assert_true(output.find("args=2 warm=1\n") == 0, "Output should be streamed back");
+        assert_true(output.find("to stderr") != std::string::npos, "stderr should be forwarded");
+        assert_equal(std::string("args=2 warm=1\nto stderr\n").size() + 20000, output.size(),
+                     "Large output should arrive intact");
+    }
+    assert_equal(3, handled, "Every request reaches the same warm handler");
+    assert_true(std::filesystem::equivalent(seen_cwd, work_dir), "Handler runs in the client's directory");
+
+    assert_true(client.Shutdown(), "Shutdown should be acknowledged");
+    serve.join();
+    assert_equal(3, server.GetRequestsServed());
+    assert_true(!std::filesystem::exists(socket_path), "Socket should be removed on exit");
+
+    int exit_code = -1;
+    assert_true(!client.Execute(Request{"", false, {"1"}}, exit_code, nullptr),
+                "Execute should fail without a daemon");
+    assert_true(!client.GetError().empty(), "Failure should be explained");
+
+    std::cout << "  ✓ Daemon round trip tests passed" << std::endl;
+}
+
+void test_daemon_latency() {
+    std::string socket_path = make_socket_path("daemon_latency");
+    DaemonServer server(socket_path, [](const Request&) {
+        std::cout << "ok" << std::endl;
+        return 0;
+    });
+    assert_true(server.Start(), "Server should start");
+    std::thread serve([&server]() { server.Run(); });
+
+    DaemonClient client(socket_path);
+    const int iterations = 200;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        int exit_code = -1;
+        client.Execute(Request{"", false, {"status"}}, exit_code, nullptr);
+    }
+    double per_command_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count() / iterations;
+
+    server.Stop();
+    serve.join();
+
+    assert_true(per_command_ms < 5.0, "Round trip took " + std::to_string(per_command_ms) + " ms");
+    std::cout << "  ✓ Daemon latency tests passed (" << per_command_ms << " ms/command)" << std::endl;
+}
+
+void test_daemon_stalled_client() {
+    std::string socket_path = make_socket_path("daemon_stalled");
+    DaemonServer server(socket_path, [](const Request&) { return 0; });
+    server.SetClientTimeout(100);
+    assert_true(server.Start(), "Server should start");
+    std::thread serve([&server]() { server.Run(); });
+
+    // Connects and then sends only half a frame header
+    int stalled = connect_raw(socket_path);
+    assert_true(stalled >= 0, "Connect");
+    assert_true(::send(stalled, "R\x10", 2, 0) == 2, "Partial header");
+
+    DaemonClient client(socket_path);
+    auto start = std::chrono::steady_clock::now();
+    assert_true(client.Ping(), "The next client is served after the stalled one times out");
+    double waited_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    assert_true(waited_ms < 2000, "Waited " + std::to_string(waited_ms) + " ms");
+
+    ::close(stalled);
+    server.Stop();
+    serve.join();
+    std::cout << "  ✓ Stalled client tests passed" << std::endl;
+}
+
+void test_daemon_slow_reader() {
+    std::string socket_path = make_socket_path("daemon_slow");
+    int finished = 0;
+    DaemonServer server(socket_path, [&finished](const Request&) {
+        std::string chunk(64 * 1024, 'y');
+        for (int i = 0; i < 64; ++i) {
+            std::cout << chunk;
+        }
+        finished++;
+        return 7;
+    });
+    server.SetClientTimeout(100);
+    assert_true(server.Start(), "Server should start");
+    std::thread serve([&server]() { server.Run(); });
+
+    // Sends a request and takes none of its 4 MB of output
+    int slow = connect_raw(socket_path);
+    assert_true(slow >= 0, "Connect");
+    assert_true(WriteFrame(slow, FrameType::REQUEST, EncodeRequest(Request{"", false, {"dump"}})), "Request");
+
+    DaemonClient client(socket_path);
+    assert_true(client.Ping(), "The next client is served after the slow one times out");
+    assert_equal(1, finished, "The command runs to completion without its reader");
+
+    // What did arrive is whole OUTPUT frames, possibly cut off, and never an exit code
+    FrameType type;
+    std::string payload;
+    size_t frames = 0;
+    while (ReadFrame(slow, type, payload)) {
+        assert_true(type == FrameType::OUTPUT, "Only output precedes the cut");
+        assert_true(payload.find_first_not_of('y') == std::string::npos, "Output frames stay intact");
+        frames++;
+    }
+    assert_true(frames > 0 && frames < 1024, "Output stops at the timeout");
+
+    ::close(slow);
+    server.Stop();
+    serve.join();
+    std::cout << "  ✓ Slow reader tests passed" << std::endl;
+}
+
+void test_forward_connection_lost() {
+    std::string socket_path = make_socket_path("daemon_lost");
+    int exit_code = -1;
+    assert_true(ForwardCommand({"status"}, exit_code, socket_path) == ForwardResult::NO_DAEMON,
+                "Nothing listening means the command can run locally");
+
+    // A daemon that takes the request and dies while answering
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    assert_true(::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+                ::listen(listener, 1) == 0, "Listen");
+    bool received = false;
+    std::thread crashing([listener, &received]() {
+        int fd = ::accept(listener, nullptr, nullptr);
+        FrameType type;
+        std::string payload;
+        received = ReadFrame(fd, type, payload) && type == FrameType::REQUEST;
+        WriteFrame(fd, FrameType::OUTPUT, "");
+        ::close(fd);
+    });
+
+    exit_code = -1;
+    assert_true(ForwardCommand({"upload"}, exit_code, socket_path) == ForwardResult::CONNECTION_LOST,
+                "A command the daemon took must not be rerun locally");
+    crashing.join();
+    assert_true(received, "The request reached the daemon");
+    assert_equal(-1, exit_code, "No exit code arrived");
+
+    ::close(listener);
+    std::filesystem::remove(socket_path);
+    std::cout << "  ✓ Lost connection tests passed" << std::endl;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "ESP32 Driver IDE - Daemon Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        std::cout << "Protocol Tests:" << std::endl;
+        test_request_encoding();
+
+        std::cout << "\nServer Tests:" << std::endl;
+        test_daemon_round_trip();
+        test_daemon_latency();
+        test_daemon_stalled_client();
+        test_daemon_slow_reader();
+        test_forward_connection_lost();
+
+        std::cout << std::endl;
+        std::cout << "========================================" << std::endl;
+        std::cout << "✓ ALL DAEMON TESTS PASSED!" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ TEST FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+}
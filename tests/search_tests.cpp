@@ -0,0 +1,313 @@
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+#include "search/project_search.h"
+#include "search/parallel_grep.h"
+#include "file_manager/file_manager.h"
+
+using namespace esp32_ide;
+using namespace esp32_ide::search;
+
+// ============================================================================
+// Helper assertion functions
+// ============================================================================
+
+void assert_true(bool condition, const std::string& message = "") {
+    if (!condition) {
+        throw std::runtime_error("Assertion failed: " + message);
+    }
+}
+
+void assert_equal(size_t expected, size_t actual, const std::string& message = "") {
+    if (expected != actual) {
+        throw std::runtime_error("Assertion failed: expected " + std::to_string(expected) +
+                                " but got " + std::to_string(actual) + ". " + message);
+    }
+}
+
+std::string make_temp_dir(const std::string& name) {
+    auto dir = std::filesystem::temp_directory_path() / ("esp32ide_" + name);
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir.string();
+}
+
+void write_file(const std::string& path, const std::string& content) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << content;
+}
+
+bool contains(const std::vector<std::string>& items, const std::string& item) {
+    return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+// ============================================================================
+// Trigram Index Tests
+// ============================================================================
+
+void test_trigram_extraction() {
+    auto trigrams = TrigramIndex::ExtractTrigrams("abcab");
+    // abc, bca, cab
+    assert_equal(3, trigrams.size(), "Should extract unique trigrams");
+    assert_true(TrigramIndex::ExtractTrigrams("ab").empty(), "Short text has no trigrams");
+    assert_true(TrigramIndex::ExtractTrigrams("ABC") == TrigramIndex::ExtractTrigrams("abc"),
+                "Trigrams should be case-folded");
+
+    auto literals = TrigramIndex::ExtractRegexLiterals("digitalWrite\\(LED_[A-Z]+, HIGH\\)");
+    assert_true(contains(literals, "digitalWrite(LED_"), "Should extract leading literal");
+    assert_true(contains(literals, ", HIGH)"), "Should extract trailing literal");
+
+    literals = TrigramIndex::ExtractRegexLiterals("Serial\\.printl?n");
+    assert_true(contains(literals, "Serial.print"), "Optional char should end the literal");
+
+    assert_true(TrigramIndex::ExtractRegexLiterals("setup|loop").empty(),
+                "Top-level alternation requires no literal");
+
+    literals = TrigramIndex::ExtractRegexLiterals("\\x41BCD\\u00e9FGH\\cMIJK");
+    assert_true(contains(literals, "BCD") && contains(literals, "FGH") && contains(literals, "IJK"),
+                "Escape operands should end the literal");
+    assert_true(!contains(literals, "41BCD") && !contains(literals, "00e9FGH") && !contains(literals, "MIJK"),
+                "Escape operands are not literals");
+
+    std::cout << "  ✓ Trigram extraction tests passed" << std::endl;
+}
+
+void test_in_memory_search() {
+    TrigramIndex index;
+    index.AddOrUpdateDocument("a.ino", "void setup() {\n  pinMode(2, OUTPUT);\n}\n");
+    index.AddOrUpdateDocument("b.ino", "void loop() {\n  digitalWrite(2, HIGH);\n}\n");
+    assert_equal(2, index.GetDocumentCount());
+
+    auto candidates = index.GetCandidates("digitalWrite");
+    assert_equal(1, candidates.size(), "Only one file should be a candidate");
+    assert_true(candidates[0] == "b.ino", "Candidate should be b.ino");
+
+    auto hits = index.Search("digitalWrite");
+    assert_equal(1, hits.size());
+    assert_equal(2, hits[0].line, "Hit should be on line 2");
+    assert_equal(3, hits[0].column, "Hit should be at column 3");
+
+    SearchOptions insensitive;
+    insensitive.case_sensitive = false;
+    assert_equal(1, index.Search("PINMODE", insensitive).size(), "Case-insensitive search");
+    assert_equal(0, index.Search("PINMODE").size(), "Case-sensitive search");
+
+    SearchOptions regex;
+    regex.regex = true;
+    hits = index.Search("void (setup|loop)\\(\\)", regex);
+    assert_equal(2, hits.size(), "Regex should match both files");
+
+    // Incremental update replaces the old document
+    index.AddOrUpdateDocument("b.ino", "void loop() {}\n");
+    assert_equal(0, index.Search("digitalWrite").size(), "Updated document should not match");
+    assert_true(index.RemoveDocument("a.ino"), "Should remove document");
+    assert_equal(0, index.Search("pinMode").size(), "Removed document should not match");
+    assert_equal(1, index.GetDocumentCount());
+
+    std::cout << "  ✓ In-memory search tests passed" << std::endl;
+}
+
+void test_file_manager_indexing() {
+    FileManager fm;
+    fm.CreateFile("main.ino", "#include <WiFi.h>\nvoid setup() { WiFi.begin(); }\n");
+
+    TrigramIndex index;
+    assert_equal(1, index.IndexFileManager(fm), "Should index file manager buffers");
+    assert_equal(0, index.IndexFileManager(fm), "Unchanged buffers should be skipped");
+    assert_equal(1, index.Search("WiFi.begin").size());
+
+    fm.DeleteFile("main.ino");
+    index.IndexFileManager(fm);
+    assert_equal(0, index.GetDocumentCount(), "Closed buffers should be dropped");
+
+    std::cout << "  ✓ FileManager indexing tests passed" << std::endl;
+}
+
+void test_persistent_index() {
+    std::string dir = make_temp_dir("search_index");
+    write_file(dir + "/sensor.cpp", "int readSensor() {\n  return analogRead(34);\n}\n");
+    write_file(dir + "/main.ino", "void loop() {\n  readSensor();\n}\n");
+    write_file(dir + "/image.bin", std::string("\0\1\2readSensor", 13));
+
+    std::string index_path = dir + "/project.idx";
+    {
+        TrigramIndex index;
+        assert_equal(2, index.IndexDirectory(dir), "Binary files should be skipped");
+        assert_true(index.Save(index_path), "Should save index");
+        assert_true(index.IsMapped(), "Saved index should be memory-mapped");
+        assert_equal(2, index.Search("readSensor").size());
+    }
+
+    TrigramIndex index;
+    assert_true(index.Load(index_path), "Should load index");
+    assert_true(index.IsMapped(), "Loaded index should be memory-mapped");
+    assert_equal(2, index.GetDocumentCount());
+    assert_equal(0, index.IndexDirectory(dir), "Unchanged files should not be re-read");
+    assert_equal(1, index.GetCandidates("analogRead").size());
+
+    // Change one file on disk and refresh incrementally
+    write_file(dir + "/sensor.cpp", "int readSensor() {\n  return digitalRead(4);\n}\n");
+    std::filesystem::last_write_time(dir + "/sensor.cpp",
+        std::filesystem::last_write_time(dir + "/sensor.cpp") + std::chrono::seconds(2));
+    assert_equal(1, index.Refresh(), "Changed file should be reindexed");
+    assert_equal(0, index.Search("analogRead").size(), "Stale content should not match");
+    assert_equal(1, index.Search("digitalRead").size(), "New content should match");
+
+    // Deleted files drop out of the index
+    std::filesystem::remove(dir + "/main.ino");
+    index.Refresh();
+    assert_equal(1, index.GetDocumentCount());
+
+    // Compacting keeps the delta
+    assert_true(index.Save(index_path), "Should compact index");
+    TrigramIndex reloaded;
+    assert_true(reloaded.Load(index_path), "Should reload compacted index");
+    assert_equal(1, reloaded.Search("digitalRead").size());
+    assert_equal(1, reloaded.GetDocumentCount());
+
+    // A document table claiming to run past the end of the file is rejected
+    {
+        std::fstream file(index_path, std::ios::in | std::ios::out | std::ios::binary);
+        uint64_t docs_size = 1ULL << 40;
+        file.seekp(24);
+        file.write(reinterpret_cast<const char*>(&docs_size), sizeof(docs_size));
+    }
+    TrigramIndex corrupt;
+    assert_true(!corrupt.Load(index_path), "Out-of-bounds document table should not load");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Persistent index tests passed" << std::endl;
+}
+
+// ============================================================================
+// Parallel Grep Tests
+// ============================================================================
+
+void test_simd_literal_search() {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "line " + std::to_string(i) + " pinMode(LED, OUTPUT);\n";
+    }
+    text += "the final Serial.println is here";
+
+    for (const std::string needle : {"Serial.println", "line 1", "x", "here", "OUTPUT);", "missing!"}) {
+        auto it = std::search(text.begin(), text.end(), needle.begin(), needle.end());
+        const char* expected = text.data() + (it - text.begin());
+        const char* found = ParallelGrep::FindLiteral(text.data(), text.data() + text.size(), needle, true);
+        assert_true(found == expected, "SIMD search should agree with std::search for " + needle);
+    }
+
+    const char* found = ParallelGrep::FindLiteral(text.data(), text.data() + text.size(),
+                                                  "serial.println", false);
+    assert_true(found != text.data() + text.size(), "Case-insensitive search should match");
+
+    std::cout << "  ✓ SIMD literal search tests passed" << std::endl;
+}
+
+void test_parallel_grep_streaming() {
+    std::string dir = make_temp_dir("parallel_grep");
+    std::filesystem::create_directories(dir + "/lib/sub");
+    std::filesystem::create_directories(dir + "/.git");
+    for (int i = 0; i < 50; ++i) {
+        write_file(dir + "/lib/sub/file" + std::to_string(i) + ".cpp",
+                   "// file " + std::to_string(i) + "\nvoid f() {\n" +
+                   (i % 10 == 0 ? "  WiFi.begin(ssid);\n" : "  delay(1);\n") + "}\n");
+    }
+    write_file(dir + "/.git/config", "WiFi.begin");
+
+    std::vector<SearchHit> streamed;
+    ParallelGrep grep;
+    grep.SetThreadCount(4);
+    assert_true(grep.Start({dir}, "WiFi.begin", SearchOptions(),
+                           [&streamed](const SearchHit& hit) { streamed.push_back(hit); }),
+                "Grep should start");
+    grep.Wait();
+
+    auto stats = grep.GetStats();
+    assert_true(stats.finished, "Grep should finish");
+    assert_true(!stats.cancelled && !stats.limit_reached, "A complete search is neither cancelled nor cut short");
+    assert_equal(5, streamed.size(), "Hidden directories should be skipped");
+    assert_equal(3, streamed[0].line, "Hit should be on line 3");
+    assert_equal(3, streamed[0].column, "Hit should be at column 3");
+    assert_equal(50, stats.files_scanned);
+    assert_equal(45, stats.files_skipped, "Prefilter should reject non-matching files");
+
+    // Regex through the polling interface
+    SearchOptions regex;
+    regex.regex = true;
+    assert_true(grep.Start({dir}, "delay\\([0-9]+\\)", regex), "Regex grep should start");
+    grep.Wait();
+    assert_equal(45, grep.PollHits().size(), "Regex hits should be queued for polling");
+
+    // Result limit stops the search early
+    SearchOptions limited;
+    limited.max_results = 2;
+    grep.Start({dir}, "void f", limited);
+    grep.Wait();
+    assert_equal(2, grep.PollHits().size(), "Result limit should be honoured");
+    stats = grep.GetStats();
+    assert_true(stats.limit_reached, "Stopping at the limit should be reported");
+    assert_true(!stats.cancelled, "Stopping at the limit is not a cancellation");
+
+    // The callback runs without the result lock, so it may ask for stats
+    std::vector<size_t> seen;
+    grep.Start({dir}, "void f", limited, [&grep, &seen](const SearchHit&) {
+        seen.push_back(grep.GetStats().hits);
+    });
+    grep.Wait();
+    assert_equal(2, seen.size(), "Result limit should apply to the callback");
+    assert_true(seen[0] >= 1 && seen[1] == 2, "Stats should be readable from the callback");
+
+    // Invalid regex is reported, not thrown
+    assert_true(!grep.Start({dir}, "delay(", regex), "Invalid regex should not start");
+    assert_true(!grep.GetError().empty(), "Invalid regex should set an error");
+
+    // A new query cancels the one in flight
+    uint64_t generation = grep.GetGeneration();
+    grep.Start({dir}, "void", SearchOptions());
+    grep.Start({dir}, "delay", SearchOptions());
+    grep.Wait();
+    assert_true(grep.GetGeneration() == generation + 2, "Each start is a new generation");
+    assert_equal(45, grep.PollHits().size(), "Only the latest query should report hits");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Parallel grep streaming tests passed" << std::endl;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "ESP32 Driver IDE - Search Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        std::cout << "Trigram Index Tests:" << std::endl;
+        test_trigram_extraction();
+        test_in_memory_search();
+        test_file_manager_indexing();
+        test_persistent_index();
+
+        std::cout << "\nParallel Grep Tests:" << std::endl;
+        test_simd_literal_search();
+        test_parallel_grep_streaming();
+
+        std::cout << std::endl;
+        std::cout << "========================================" << std::endl;
+        std::cout << "✓ ALL SEARCH TESTS PASSED!" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ TEST FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,1934 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <cstring>
+#include <iterator>
+
+#include "compiler/elf_size_analyzer.h"
+#include "compiler/esp32_compiler.h"
+#include "plugins/plugin_system.h"
+#include "serial/esp_flasher.h"
+#include "serial/fleet_flasher.h"
+#include "serial/multi_port_monitor.h"
+#include "serial/panic_symbolizer.h"
+#include "serial/serial_monitor.h"
+#include "serial/telemetry_decoder.h"
+#include "utils/deflate.h"
+#include "utils/md5.h"
+#include "utils/sha256.h"
+#include "utils/spsc_ring.h"
+#include "visualization/advanced_visualization.h"
+#include "visualization/serial_plotter.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace esp32_ide;
+
+// ============================================================================
+// Helper assertion functions
+// ============================================================================
+
+void assert_true(bool condition, const std::string& message = "") {
+    if (!condition) {
+        throw std::runtime_error("Assertion failed: " + message);
+    }
+}
+
+void assert_equal(long long expected, long long actual, const std::string& message = "") {
+    if (expected != actual) {
+        throw std::runtime_error("Assertion failed: expected " + std::to_string(expected) +
+                                " but got " + std::to_string(actual) + ". " + message);
+    }
+}
+
+// Text-like firmware: compresses well, but not trivially
+std::string make_firmware(size_t size, unsigned seed) {
+    static const char* kWords[] = {"setup", "loop", "digitalWrite", "Serial", "WiFi", "0x3ff44004", "delay", "\n"};
+    std::string data;
+    unsigned state = seed;
+    while (data.size() < size) {
+        state = state * 1103515245 + 12345;
+        data += kWords[(state >> 16) % 8];
+        data.push_back(static_cast<char>((state >> 8) & 0xFF));
+    }
+    data.resize(size);
+    return data;
+}
+
+// ============================================================================
+// Simulated ESP32 ROM bootloader on the master side of a pty
+// ============================================================================
+
+class SimulatedBootloader {
+public:
+    SimulatedBootloader() : flash(4 * 1024 * 1024, static_cast<char>(0xFF)), corrupt_writes(false),
+                            data_packets(0), reply_delay_ms(0), chip_magic(0x00f01d83), begin_words(0),
+                            begin_size(0), status_bytes(4), early_blocks(0), stub_entry(0), stub_running(false),
+                            running_(true), pending_offset_(0), pending_size_(0), pending_blocks_(0),
+                            plain_offset_(0) {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        grantpt(master_);
+        unlockpt(master_);
+        path_ = ptsname(master_);
+        thread_ = std::thread([this]() { Run(); });
+    }
+
+    ~SimulatedBootloader() {
+        running_ = false;
+        thread_.join();
+        close(master_);
+    }
+
+    const std::string& GetPath() const { return path_; }
+
+    std::string flash;
+    std::atomic<bool> corrupt_writes;
+    std::atomic<int> data_packets;
+    std::atomic<int> reply_delay_ms;    // per data block, for a slow board
+    std::atomic<uint32_t> chip_magic;   // answer to READ_REG; an ESP32 by default
+    std::atomic<size_t> begin_words;    // of the last FLASH_BEGIN/FLASH_DEFL_BEGIN
+    std::atomic<uint32_t> begin_size;   // the erase size it asked for
+    std::atomic<size_t> status_bytes;   // of ROM replies: 4, or 2 like the ESP8266
+    std::atomic<int> early_blocks;      // data blocks sent before the previous one was acknowledged
+    // What MEM_BEGIN/MEM_DATA loaded, and the entry MEM_END ran
+    std::vector<std::pair<uint32_t, std::string>> ram;
+    uint32_t stub_entry;
+    std::atomic<bool> stub_running;     // replies then have the stub's 2-byte status
+
+private:
+    int master_;
+    std::string path_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+    std::string rx_;
+    std::string pending_;
+    uint32_t pending_offset_;
+    uint32_t pending_size_;
+    uint32_t pending_blocks_;
+    uint32_t plain_offset_;
+
+    static uint32_t Get32(const std::string& data, size_t at) {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(static_cast<unsigned char>(data[at + i])) << (8 * i);
+        }
+        return value;
+    }
+
+    void Reply(uint8_t command, const std::string& payload, uint32_t value = 0) {
+        std::string packet = {0x01, static_cast<char>(command)};
+        std::string body = payload + std::string(stub_running ? 2 : status_bytes.load(), '\0');    // success
+        packet.push_back(static_cast<char>(body.size() & 0xFF));
+        packet.push_back(static_cast<char>(body.size() >> 8));
+        for (int i = 0; i < 4; ++i) {
+            packet.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+        packet += body;
+        SendFrame(packet);
+    }
+
+    void SendFrame(const std::string& packet) {
+        std::string frame;
+        EspFlasher::SlipEncode(packet, frame);
+        for (size_t done = 0; done < frame.size();) {
+            ssize_t n = write(master_, frame.data() + done, frame.size() - done);
+            if (n > 0) done += static_cast<size_t>(n);
+        }
+    }
+
+    void Write(uint32_t offset, const std::string& data) {
+        flash.replace(offset, data.size(), data);
+        if (corrupt_writes && !data.empty()) {
+            flash[offset] = static_cast<char>(~flash[offset]);
+        }
+    }
+
+    void Handle(const std::string& packet) {
+        if (packet.size() < 8 || packet[0] != 0x00) return;
+        uint8_t command = static_cast<uint8_t>(packet[1]);
+        std::string data = packet.substr(8);
+        switch (command) {
+            case EspFlasher::SYNC:
+                for (int i = 0; i < 8; ++i) Reply(command, "");
+                break;
+            case EspFlasher::READ_REG:
+                Reply(command, "", Get32(data, 0) == 0x40001000 ? chip_magic.load() : 0);
+                break;
+            case EspFlasher::FLASH_DEFL_BEGIN:
+                begin_words = data.size() / 4;
+                begin_size = Get32(data, 0);
+                pending_.clear();
+                pending_size_ = Get32(data, 0);
+                pending_blocks_ = Get32(data, 4);
+                pending_offset_ = Get32(data, 12);
+                Reply(command, "");
+                break;
+            case EspFlasher::FLASH_DEFL_DATA:
+                data_packets++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(reply_delay_ms));
+                if (reply_delay_ms > 0) {
+                    struct pollfd pfd = {master_, POLLIN, 0};
+                    if (!rx_.empty() || poll(&pfd, 1, 0) > 0) early_blocks++;
+                }
+                pending_ += data.substr(16, Get32(data, 0));
+                if (Get32(data, 4) + 1 == pending_blocks_) {
+                    std::string inflated;
+                    utils::Deflate::Decompress(pending_, inflated);
+                    // The ROM erases what it was asked to, then writes what inflates
+                    if (inflated.size() > pending_size_) return;    // no reply: the flasher times out
+                    Write(pending_offset_, inflated);
+                }
+                Reply(command, "");
+                break;
+            case EspFlasher::FLASH_BEGIN:
+                begin_words = data.size() / 4;
+                begin_size = Get32(data, 0);
+                plain_offset_ = Get32(data, 12);
+                Reply(command, "");
+                break;
+            case EspFlasher::FLASH_DATA:
+                data_packets++;
+                Write(plain_offset_ + Get32(data, 4) * Get32(data, 0), data.substr(16, Get32(data, 0)));
+                Reply(command, "");
+                break;
+            case EspFlasher::SPI_FLASH_MD5: {
+                std::string digest = utils::Md5::Digest(flash.data() + Get32(data, 0), Get32(data, 4));
+                Reply(command, stub_running ? digest : utils::Md5::ToHex(digest));
+                break;
+            }
+            case EspFlasher::MEM_BEGIN:
+                ram.push_back({Get32(data, 12), ""});
+                Reply(command, "");
+                break;
+            case EspFlasher::MEM_DATA:
+                if (!ram.empty()) ram.back().second += data.substr(16, Get32(data, 0));
+                Reply(command, "");
+                break;
+            case EspFlasher::MEM_END:
+                Reply(command, "");
+                if (Get32(data, 0) == 0) {
+                    stub_entry = Get32(data, 4);
+                    stub_running = true;
+                    SendFrame("OHAI");
+                }
+                break;
+            default:
+                Reply(command, "");
+                break;
+        }
+    }
+
+    void Run() {
+        char buffer[4096];
+        while (running_) {
+            struct pollfd pfd = {master_, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            ssize_t n = read(master_, buffer, sizeof(buffer));
+            if (n <= 0) {
+                // No one has the slave open yet
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                continue;
+            }
+            rx_.append(buffer, static_cast<size_t>(n));
+            size_t end;
+            while ((end = rx_.find(static_cast<char>(0xC0), 1)) != std::string::npos) {
+                if (static_cast<unsigned char>(rx_[0]) != 0xC0) {
+                    rx_.erase(0, end);
+                    continue;
+                }
+                std::string packet;
+                for (size_t i = 1; i < end; ++i) {
+                    unsigned char byte = static_cast<unsigned char>(rx_[i]);
+                    if (byte == 0xDB) {
+                        byte = static_cast<unsigned char>(rx_[++i]) == 0xDC ? 0xC0 : 0xDB;
+                    }
+                    packet.push_back(static_cast<char>(byte));
+                }
+                rx_.erase(0, end + 1);
+                Handle(packet);
+            }
+        }
+    }
+};
+
+// ============================================================================
+// Codec Tests
+// ============================================================================
+
+void test_md5_and_deflate() {
+    assert_true(utils::Md5::ToHex(utils::Md5::Digest("abc", 3)) == "900150983cd24fb0d6963f7d28e17f72",
+                "MD5 of \"abc\"");
+    assert_true(utils::Md5::ToHex(utils::Md5::Digest("", 0)) == "d41d8cd98f00b204e9800998ecf8427e",
+                "MD5 of nothing");
+    assert_true(utils::Md5::ToHex(utils::Sha256::Digest("abc", 3)) ==
+                "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "SHA-256 of \"abc\"");
+    std::string million(1000000, 'a');
+    assert_true(utils::Md5::ToHex(utils::Sha256::Digest(million.data(), million.size())) ==
+                "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", "SHA-256 of a million a's");
+
+    std::string firmware = make_firmware(200000, 7);
+    std::string compressed = utils::Deflate::Compress(firmware);
+    assert_true(compressed.size() < firmware.size() / 2, "Text-like data should compress");
+    std::string inflated;
+    assert_true(utils::Deflate::Decompress(compressed, inflated), "Stream should inflate");
+    assert_true(inflated == firmware, "Deflate should round trip");
+
+    compressed[compressed.size() / 2] ^= 0x55;
+    assert_true(!utils::Deflate::Decompress(compressed, inflated) || inflated != firmware,
+                "Corruption should not go unnoticed");
+
+    std::cout << "  ✓ MD5, SHA-256 and deflate tests passed" << std::endl;
+}
+
+void test_slip_framing() {
+    std::string frame;
+    EspFlasher::SlipEncode(std::string("\xC0\xDB\x01", 3), frame);
+    assert_true(frame == std::string("\xC0\xDB\xDC\xDB\xDD\x01\xC0", 7), "Delimiters and escapes are escaped");
+    assert_equal(0xEF ^ 0x01 ^ 0x02, EspFlasher::Checksum("\x01\x02", 2), "Checksum is seeded XOR");
+
+    std::cout << "  ✓ SLIP framing tests passed" << std::endl;
+}
+
+// ============================================================================
+// Flasher Tests
+// ============================================================================
+
+EspFlasher::Options test_options() {
+    EspFlasher::Options options = EspFlasher::GetDefaultOptions();
+    options.reset_into_bootloader = false;
+    options.timeout_ms = 2000;
+    return options;
+}
+
+void test_flash_compressed() {
+    SimulatedBootloader device;
+    std::vector<FlashImage::Region> regions = {
+        {0x1000, make_firmware(20000, 1)},
+        {0x10000, make_firmware(300000, 2)},
+    };
+    FlashImage image(regions, 64 * 1024, true);
+
+    EspFlasher flasher;
+    flasher.SetOptions(test_options());
+    size_t last_done = 0;
+    flasher.SetProgressCallback([&](size_t done, size_t total, uint32_t) {
+        assert_true(done >= last_done && done <= total, "Progress should be monotonic");
+        last_done = done;
+    });
+    assert_true(flasher.Connect(device.GetPath()), "Should sync: " + flasher.GetError());
+    assert_true(!flasher.IsStub(), "Without a stub the ROM loader flashes");
+
+    EspFlasher::Result result = flasher.Flash(image);
+    assert_true(result.success, "Flash should succeed: " + result.error);
+    assert_equal(320000, result.bytes_written, "Every byte is new");
+    assert_equal(image.GetSegments().size(), result.segments_written);
+    assert_equal(320000, last_done, "Progress should reach the total");
+    assert_true(device.flash.compare(0x1000, 20000, regions[0].data) == 0, "Bootloader written");
+    assert_true(device.flash.compare(0x10000, 300000, regions[1].data) == 0, "App written");
+    assert_true(result.wire_bytes < result.bytes_total / 2,
+                "Compressed writes should halve the traffic: " + std::to_string(result.wire_bytes));
+    assert_equal(0x00f01d83, flasher.GetChipMagic(), "Chip read on connect");
+    assert_equal(4, device.begin_words, "ESP32 ROM takes four FLASH_DEFL_BEGIN words");
+    assert_equal(0, device.begin_size % 4096, "ROM erase size in whole sectors");
+
+    std::cout << "  ✓ Compressed flash tests passed (" << result.wire_bytes << " wire bytes for "
+              << result.bytes_total << ")" << std::endl;
+}
+
+void test_flash_skips_unchanged() {
+    SimulatedBootloader device;
+    std::vector<FlashImage::Region> regions = {{0x10000, make_firmware(256 * 1024, 3)}};
+
+    EspFlasher flasher;
+    flasher.SetOptions(test_options());
+    assert_true(flasher.Connect(device.GetPath()), "Should sync: " + flasher.GetError());
+    assert_true(flasher.Flash(regions).success, "First flash");
+
+    int packets = device.data_packets;
+    EspFlasher::Result again = flasher.Flash(regions);
+    assert_true(again.success, "Re-flash should succeed: " + again.error);
+    assert_equal(0, again.segments_written, "Nothing changed");
+    assert_equal(256 * 1024, again.bytes_skipped);
+    assert_equal(packets, device.data_packets, "No data should be sent");
+
+    regions[0].data[130000] ^= 0x20;
+    EspFlasher::Result patched = flasher.Flash(regions);
+    assert_true(patched.success, "Patch flash should succeed: " + patched.error);
+    assert_equal(1, patched.segments_written, "Only the changed segment is written");
+    assert_equal(3, patched.segments_skipped);
+    assert_true(device.flash.compare(0x10000, regions[0].data.size(), regions[0].data) == 0, "Patch applied");
+
+    std::cout << "  ✓ Unchanged segment tests passed" << std::endl;
+}
+
+void test_flash_newer_chip() {
+    SimulatedBootloader device;
+    device.chip_magic = 0x9;                    // ESP32-S3
+    std::vector<FlashImage::Region> regions = {{0x10000, make_firmware(70000, 5)}};
+
+    EspFlasher flasher;
+    flasher.SetOptions(test_options());
+    assert_true(flasher.Connect(device.GetPath()), "Should sync: " + flasher.GetError());
+    assert_equal(0x9, flasher.GetChipMagic(), "ESP32-S3 told by its magic value");
+    EspFlasher::Result result = flasher.Flash(regions);
+    assert_true(result.success, "Flash should succeed: " + result.error);
+    assert_equal(5, device.begin_words, "Later ROMs take the encrypted flag too");
+    assert_equal(8192, device.begin_size, "Last segment's erase rounded up to a sector");
+    assert_true(device.flash.compare(0x10000, 70000, regions[0].data) == 0, "App written");
+
+    std::cout << "  ✓ Newer chip flash tests passed" << std::endl;
+}
+
+void test_flash_uncompressed_and_verify() {
+    SimulatedBootloader device;
+    std::vector<FlashImage::Region> regions = {{0x8000, make_firmware(5000, 4)}};
+
+    EspFlasher flasher;
+    EspFlasher::Options options = test_options();
+    options.compress = false;
+    options.flash_baud_rate = 0;
+    flasher.SetOptions(options);
+    assert_true(flasher.Connect(device.GetPath()), "Should sync: " + flasher.GetError());
+    EspFlasher::Result result = flasher.Flash(regions);
+    assert_true(result.success, "Plain flash should succeed: " + result.error);
+    assert_equal(5, device.data_packets, "1 KiB blocks for the ROM loader");
+    assert_true(device.flash.compare(0x8000, 5000, regions[0].data) == 0, "Partition table written");
+
+    device.corrupt_writes = true;
+    regions[0].data[0] ^= 1;
+    result = flasher.Flash(regions);
+    assert_true(!result.success, "A bad write should fail verification");
+    assert_true(result.error.find("Verification failed") != std::string::npos, result.error);
+
+    std::cout << "  ✓ Uncompressed flash and verify tests passed" << std::endl;
+}
+
+void test_connect_without_device() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    std::string path = ptsname(master);
+
+    EspFlasher flasher;
+    flasher.SetOptions(test_options());
+    assert_true(!flasher.Connect(path), "Nothing answers");
+    assert_true(flasher.GetError().find("Failed to connect") != std::string::npos, flasher.GetError());
+    assert_true(!flasher.IsConnected(), "Should stay disconnected");
+    assert_true(!flasher.Connect("/nonexistent/ttyUSB9"), "Missing ports fail");
+    close(master);
+
+    std::cout << "  ✓ Connection failure tests passed" << std::endl;
+}
+
+void test_flash_with_stub() {
+    SimulatedBootloader device;
+    device.reply_delay_ms = 20;
+    auto stub = std::make_shared<EspFlasher::Stub>();
+    stub->segments = {{0x4009c000, make_firmware(9000, 8)}, {0x3ffe0000, make_firmware(300, 9)}};
+    stub->entry = 0x4009c100;
+    std::vector<FlashImage::Region> regions = {{0x10000, make_firmware(140000, 10)}};
+
+    EspFlasher flasher;
+    EspFlasher::Options options = test_options();
+    options.stub = stub;
+    flasher.SetOptions(options);
+    assert_true(flasher.Connect(device.GetPath()), "Should sync and start the stub: " + flasher.GetError());
+    assert_true(flasher.IsStub(), "The stub announced itself");
+    assert_equal(2, device.ram.size(), "Both stub segments loaded");
+    assert_true(device.ram[0].first == 0x4009c000 && device.ram[0].second == stub->segments[0].data,
+                "Text segment loaded whole");
+    assert_true(device.ram[1].first == 0x3ffe0000 && device.ram[1].second == stub->segments[1].data,
+                "Data segment loaded whole");
+    assert_equal(0x4009c100, device.stub_entry, "Stub run from its entry");
+
+    EspFlasher::Result result = flasher.Flash(regions);
+    assert_true(result.success, "Stub flash should succeed: " + result.error);
+    assert_true(device.flash.compare(0x10000, regions[0].data.size(), regions[0].data) == 0, "App written");
+    assert_equal(140000 - 2 * 64 * 1024, device.begin_size, "The stub erases as it writes");
+    assert_true(device.early_blocks > 0, "Blocks are pipelined to the stub");
+
+    std::cout << "  ✓ Flasher stub tests passed" << std::endl;
+}
+
+void test_flash_esp8266_rom() {
+    SimulatedBootloader device;
+    device.status_bytes = 2;
+    device.chip_magic = 0xfff0c101;
+    device.reply_delay_ms = 20;
+    std::vector<FlashImage::Region> regions = {{0x0, make_firmware(30000, 11)}};
+
+    EspFlasher flasher;
+    flasher.SetOptions(test_options());
+    assert_true(flasher.Connect(device.GetPath()), "Should sync: " + flasher.GetError());
+    assert_true(!flasher.IsStub(), "A 2-byte status alone is not the stub");
+    EspFlasher::Result result = flasher.Flash(regions);
+    assert_true(result.success, "Flash should succeed: " + result.error);
+    assert_true(device.flash.compare(0, 30000, regions[0].data) == 0, "Image written");
+    assert_equal(4, device.begin_words, "No encrypted word for the ESP8266");
+    assert_equal(0, device.begin_size % 4096, "ROM erase size in whole sectors");
+    assert_equal(0, device.early_blocks, "The ROM gets one block at a time");
+
+    std::cout << "  ✓ ESP8266 ROM flash tests passed" << std::endl;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void test_compile_and_upload() {
+    std::string dir = (std::filesystem::temp_directory_path() / "esp32ide_upload_project").string();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string cache_dir = dir + "/cache";
+    setenv("ESP32_IDE_CACHE_DIR", cache_dir.c_str(), 1);
+
+    // Host g++ standing in for the cross toolchain
+    plugins::CompilerConfig host;
+    host.id = "host";
+    host.name = "Host G++";
+    host.compiler_path = "g++";
+    host.linker_path = "g++";
+    host.default_flags = {"-O0"};
+    host.output_extension = ".o";
+    host.error_pattern = R"((.+):(\d+):(\d+): (error|warning): (.+))";
+
+    ESP32Compiler compiler;
+    compiler.GetCompilerManager().RegisterCompiler(host);
+    ESP32Compiler::BuildSettings settings;
+    settings.project_dir = dir + "/sketch";
+    settings.compiler_id = "host";
+    compiler.SetBuildSettings(settings);
+    std::string output;
+    compiler.SetOutputCallback([&output](const std::string& message, ESP32Compiler::CompileStatus) {
+        output += message + "\n";
+    });
+
+    SimulatedBootloader device;
+    const auto board = ESP32Compiler::BoardType::ESP32_P4;
+    assert_true(!compiler.Upload(board, device.GetPath()), "Nothing to upload before a build");
+
+    std::string sketch = "void setup() {}\nvoid loop() {}\nint main() { setup(); loop(); return 0; }\n";
+    auto result = compiler.Compile(sketch, board);
+    assert_true(result.status == ESP32Compiler::CompileStatus::SUCCESS, "Sketch builds: " + output);
+    std::string build_dir = compiler.GetBuildDirectory(board);
+    std::string image = read_file(build_dir + "/sketch.bin");
+    assert_true(image.size() > 64 && static_cast<unsigned char>(image[0]) == 0xE9, "App image made on build");
+    assert_true(image[1] > 0 && image[1] <= 16, "Segments from the ELF");
+    assert_equal(18, static_cast<unsigned char>(image[12]) | (static_cast<unsigned char>(image[13]) << 8),
+                 "ESP32-P4 chip id");
+    assert_equal(0, (image.size() - 32) % 16, "Checksum ends a 16-byte block");
+    assert_true(utils::Sha256::Digest(image.data(), image.size() - 32) == image.substr(image.size() - 32),
+                "SHA-256 digest appended");
+
+    // A platform bootloader goes where the P4's ROM looks for it
+    std::string bootloader = make_firmware(20000, 12);
+    std::ofstream(build_dir + "/bootloader.bin", std::ios::binary) << bootloader;
+
+    assert_true(compiler.Upload(board, device.GetPath()), "Upload should succeed: " + output);
+    assert_true(device.flash.compare(0x10000, image.size(), image) == 0, "App image at the app partition");
+    assert_true(device.flash.compare(0x2000, bootloader.size(), bootloader) == 0, "Bootloader at 0x2000");
+
+    std::filesystem::remove_all(dir);
+    std::cout << "  ✓ Compile and upload tests passed" << std::endl;
+}
+
+// ============================================================================
+// Log Store Tests
+// ============================================================================
+
+std::string log_line(uint64_t i) {
+    return "I (" + std::to_string(i * 10) + ") sensor: temperature=" + std::to_string(20 + i % 7) + "." +
+           std::to_string(i % 10) + " humidity=" + std::to_string(40 + i % 13);
+}
+
+void test_log_store_spill() {
+    std::string spill_path = (std::filesystem::temp_directory_path() / "esp32ide_serial_spill.log").string();
+    SerialLogStore::Options options = SerialLogStore::GetDefaultOptions();
+    options.memory_limit = 256 * 1024;
+    options.chunk_size = 16 * 1024;
+    options.spill_path = spill_path;
+
+    const uint64_t count = 200000;
+    {
+        SerialLogStore store(options);
+        for (uint64_t i = 0; i < count; ++i) {
+            assert_equal(i, store.Append(log_line(i), static_cast<uint8_t>(i % 5), 1000000 + i * 37 - (i % 3)));
+        }
+        SerialLogStore::Statistics stats = store.GetStatistics();
+        assert_equal(count, stats.messages, "Nothing is lost with a spill file");
+        assert_true(stats.memory_bytes <= options.memory_limit + options.chunk_size, "RAM stays capped");
+        assert_true(stats.spilled_chunks > 0, "Old chunks spill");
+        assert_true(stats.spilled_bytes < stats.content_bytes / 2, "Spilled chunks are compressed");
+        assert_true(store.GetError().empty(), store.GetError());
+
+        SerialLogStore::Cursor cursor = store.GetCursor(0);
+        SerialLogStore::Message message;
+        bool exact = true;
+        uint64_t read = 0;
+        while (cursor.Next(message)) {
+            exact &= message.content == log_line(read) && message.type == read % 5 &&
+                     message.timestamp == static_cast<long long>(1000000 + read * 37 - (read % 3));
+            read++;
+        }
+        assert_equal(count, read, "The cursor reads spilled and resident chunks");
+        assert_true(exact, "Contents, types and timestamps round trip");
+
+        std::vector<uint64_t> indices;
+        assert_equal(3, store.Read(123456, 3, [&](uint64_t index, const SerialLogStore::Message& m) {
+            indices.push_back(index);
+            assert_true(m.content == log_line(index), "Range contents");
+        }));
+        assert_equal(123458, indices.back());
+        assert_equal(0, store.Read(count, 10, [](uint64_t, const SerialLogStore::Message&) {}), "Past the end");
+
+        store.Clear();
+        assert_equal(0, store.Size());
+        assert_equal(count, store.Append("after", 0, 1), "Indices continue after Clear");
+    }
+    assert_true(!std::filesystem::exists(spill_path), "The spill file is removed with the store");
+
+    std::cout << "  ✓ Log store spill tests passed" << std::endl;
+}
+
+void test_log_store_bounded() {
+    SerialLogStore::Options options = SerialLogStore::GetDefaultOptions();
+    options.memory_limit = 256 * 1024;
+    options.chunk_size = 8 * 1024;
+    SerialLogStore store(options);
+
+    for (uint64_t i = 0; i < 100000; ++i) {
+        store.Append(log_line(i), 0, static_cast<long long>(i));
+    }
+    SerialLogStore::Statistics stats = store.GetStatistics();
+    assert_true(stats.memory_bytes <= options.memory_limit + options.chunk_size, "RAM stays capped");
+    assert_true(store.GetFirstIndex() > 0 && stats.dropped == store.GetFirstIndex(), "Oldest messages drop");
+    assert_equal(100000, store.GetEndIndex());
+
+    // A few bytes per message beyond the text itself
+    double overhead = static_cast<double>(stats.memory_bytes - stats.content_bytes) / stats.messages;
+    assert_true(overhead < 8, "Per-message overhead: " + std::to_string(overhead));
+
+    // Cursors behind the window skip ahead; an oversized message fits on its own
+    SerialLogStore::Cursor cursor = store.GetCursor(0);
+    SerialLogStore::Message message;
+    assert_true(cursor.Next(message) && message.content == log_line(store.GetFirstIndex()), "Oldest available");
+    std::string big(20000, 'x');
+    uint64_t index = store.Append(big, 1, 0);
+    SerialLogStore::Cursor tail = store.GetCursor(index);
+    assert_true(tail.Next(message) && message.content.size() == big.size(), "Oversized message");
+    assert_true(!tail.Next(message), "End of the log");
+
+    std::cout << "  ✓ Bounded log store tests passed" << std::endl;
+}
+
+void test_archive_seek_and_search() {
+    std::string path = (std::filesystem::temp_directory_path() / "esp32ide_capture.e3a").string();
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+
+    // ~25 MB of logging, a rare error in a few places, clock stepping back once
+    const uint64_t count = 400000;
+    auto stamp = [](uint64_t i) { return static_cast<long long>(i < 200000 ? 5000 + i * 10 : i * 10 - 500); };
+    auto line = [](uint64_t i) {
+        return i % 100000 == 777 ? "E (" + std::to_string(i) + ") wifi: brownout detected" : log_line(i);
+    };
+    {
+        SerialArchiveWriter writer;
+        assert_true(writer.Open(path), writer.GetError());
+        for (uint64_t i = 0; i < count / 2; ++i) {
+            assert_true(writer.Append(line(i), static_cast<uint8_t>(i % 5), stamp(i)), writer.GetError());
+        }
+    }
+    {
+        // Continuing the capture
+        SerialArchiveWriter writer;
+        assert_true(writer.Open(path), writer.GetError());
+        assert_equal(count / 2, writer.GetMessageCount(), "Reopened at the end");
+        for (uint64_t i = count / 2; i < count; ++i) {
+            writer.Append(line(i), static_cast<uint8_t>(i % 5), stamp(i));
+        }
+        // A block cut short by a crash: data without its index row
+        assert_true(writer.Flush(), writer.GetError());
+    }
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn << "half a block";
+    }
+
+    SerialArchiveReader reader;
+    assert_true(reader.Open(path), reader.GetError());
+    assert_equal(count, reader.GetMessageCount(), "Every message committed");
+    assert_true(reader.GetBlockCount() > 300, "Many blocks");
+    assert_equal(5000, reader.GetFirstTimestamp());
+
+    bool exact = true;
+    uint64_t next = 123450;
+    assert_equal(100, reader.Read(next, 100, [&](uint64_t index, const SerialArchiveReader::Message& message) {
+        exact &= index == next && message.content == line(index) && message.type == index % 5 &&
+                 message.timestamp == stamp(index);
+        next++;
+    }));
+    assert_true(exact, "Contents, types and timestamps round trip");
+    assert_equal(0, reader.Read(count, 10, [](uint64_t, const SerialArchiveReader::Message&) {}), "Past the end");
+
+    // Seeking agrees with a linear search, across the clock step too
+    const long long targets[] = {0, 5000, 5001, 777777, 2004990, 2005000, 1999500, 3999990, 4000000};
+    for (long long target : targets) {
+        uint64_t expected = count;
+        for (uint64_t i = 0; i < count; ++i) {
+            if (stamp(i) >= target) {
+                expected = i;
+                break;
+            }
+        }
+        assert_equal(expected, reader.Seek(target), "Seek to " + std::to_string(target));
+    }
+
+    // Whole words only; filters rule out nearly every block
+    std::vector<uint64_t> found;
+    assert_equal(4, reader.Search("wifi: brownout", 0, 100, [&](uint64_t index, const SerialArchiveReader::Message&) {
+        found.push_back(index);
+    }));
+    assert_equal(777, found[0]);
+    assert_equal(300777, found[3]);
+    SerialArchiveReader::SearchStatistics stats = reader.GetSearchStatistics();
+    assert_equal(reader.GetBlockCount(), stats.blocks);
+    assert_true(stats.blocks_read < 4 + stats.blocks / 20, "Blocks read: " + std::to_string(stats.blocks_read));
+    assert_equal(0, reader.Search("brown", 0, 100, [](uint64_t, const SerialArchiveReader::Message&) {}),
+                 "Partial words do not match");
+    assert_equal(1, reader.Search("brownout", 100000, 1, [&](uint64_t index, const SerialArchiveReader::Message&) {
+        assert_equal(100777, index, "Search from a position");
+    }));
+
+    // A writer continuing after the torn tail replaces it
+    {
+        SerialArchiveWriter writer;
+        assert_true(writer.Open(path), writer.GetError());
+        writer.Append("after the crash", 0, 4000000);
+    }
+    assert_true(reader.Refresh(), reader.GetError());
+    assert_equal(count + 1, reader.GetMessageCount());
+    reader.Read(count, 1, [](uint64_t, const SerialArchiveReader::Message& message) {
+        assert_true(message.content == "after the crash", std::string(message.content));
+    });
+    size_t blocks = reader.GetBlockCount();
+    reader.Close();
+
+    // Damaged rows fail the open instead of sending lookups past the mapping
+    std::string index_path = path + ".idx";
+    std::string original;
+    {
+        std::ifstream in(index_path, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t row_size = 48;
+    size_t middle = original.size() - (blocks - blocks / 2) * row_size;
+    auto damaged = [&](size_t field, uint64_t value, size_t width) {
+        std::string index = original;
+        std::memcpy(&index[middle + field], &value, width);
+        std::ofstream(index_path, std::ios::binary | std::ios::trunc) << index;
+        SerialArchiveReader damaged_reader;
+        return !damaged_reader.Open(path) && damaged_reader.GetError().find("Damaged") != std::string::npos;
+    };
+    assert_true(damaged(8, 1ull << 40, 8), "Block past the end of the data");
+    assert_true(damaged(0, 12345, 8), "Message numbers out of sequence");
+    assert_true(damaged(40, 0, 4), "Empty filter");
+    assert_true(damaged(40, 96, 4), "Filter size not a power of two");
+    std::ofstream(index_path, std::ios::binary | std::ios::trunc) << original;
+    assert_true(reader.Open(path), reader.GetError());
+    assert_equal(count + 1, reader.GetMessageCount(), "Intact again");
+    reader.Close();
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+    std::cout << "  ✓ Capture seek and search tests passed" << std::endl;
+}
+
+void test_monitor_recording() {
+    std::string path = (std::filesystem::temp_directory_path() / "esp32ide_recording.e3a").string();
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+
+    SerialMonitor monitor;
+    assert_true(monitor.StartRecording(path), "Start recording");
+    assert_true(monitor.IsRecording(), "Recording");
+    for (int i = 0; i < 1000; ++i) {
+        monitor.AddMessage("line " + std::to_string(i), i == 500 ? SerialMonitor::MessageType::ERROR
+                                                                  : SerialMonitor::MessageType::NORMAL);
+    }
+    monitor.StopRecording();
+    monitor.AddMessage("not recorded");
+    assert_true(!monitor.IsRecording(), "Stopped");
+
+    SerialArchiveReader reader;
+    assert_true(reader.Open(path), reader.GetError());
+    std::vector<SerialMonitor::SerialMessage> messages = monitor.GetMessages();
+    // Everything from "Recording to" up to "Stopped recording"
+    assert_equal(messages.size() - 1, reader.GetMessageCount());
+    bool same = true;
+    reader.Read(0, messages.size(), [&](uint64_t index, const SerialArchiveReader::Message& message) {
+        same &= message.content == messages[index].content && message.timestamp == messages[index].timestamp &&
+                message.type == static_cast<uint8_t>(messages[index].type);
+    });
+    assert_true(same, "The capture matches the log");
+    assert_equal(1, reader.Search("line 500", 0, 10, [&](uint64_t, const SerialArchiveReader::Message& message) {
+        assert_true(message.type == static_cast<uint8_t>(SerialMonitor::MessageType::ERROR), "Type kept");
+    }));
+    assert_true(reader.Seek(messages[200].timestamp) <= 200, "Seek by monitor timestamps");
+    reader.Close();
+
+    assert_true(!monitor.StartRecording("/nonexistent/dir/capture"), "Unwritable paths fail");
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+    std::cout << "  ✓ Monitor recording tests passed" << std::endl;
+}
+
+// ============================================================================
+// Fleet Tests
+// ============================================================================
+
+void test_fleet_flash() {
+    std::vector<std::unique_ptr<SimulatedBootloader>> devices;
+    std::vector<std::string> ports;
+    for (int i = 0; i < 6; ++i) {
+        devices.push_back(std::unique_ptr<SimulatedBootloader>(new SimulatedBootloader()));
+        ports.push_back(devices.back()->GetPath());
+    }
+    // A port that does not exist and a board that never answers
+    ports.insert(ports.begin() + 2, "/nonexistent/ttyUSB9");
+    int silent = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(silent);
+    unlockpt(silent);
+    ports.push_back(ptsname(silent));
+
+    std::vector<FlashImage::Region> regions = {{0x10000, make_firmware(200000, 5)}};
+    FlashImage image(regions, 64 * 1024, true);
+
+    FleetFlasher fleet;
+    FleetFlasher::Options options = fleet.GetOptions();
+    options.flasher = test_options();
+    options.report_interval_ms = 20;
+    fleet.SetOptions(options);
+    size_t reports = 0;
+    size_t peak_active = 0;
+    fleet.SetProgressCallback([&](const std::vector<FleetFlasher::DeviceStatus>& status,
+                                  const FleetFlasher::Throughput& total) {
+        reports++;
+        peak_active = std::max(peak_active, total.active);
+        assert_equal(8, status.size(), "Every port is reported");
+        assert_true(total.bytes_done <= total.bytes_total, "Aggregate progress is bounded");
+    });
+
+    FleetFlasher::FleetResult result = fleet.Flash(ports, image);
+    close(silent);
+
+    assert_true(!result.success, "Two boards cannot be flashed");
+    assert_equal(6, result.throughput.done);
+    assert_equal(2, result.throughput.failed);
+    assert_true(result.devices[2].state == FleetFlasher::State::FAILED, "Missing port fails");
+    assert_true(result.devices[7].error.find("Failed to connect") != std::string::npos, result.devices[7].error);
+    assert_equal(2, result.devices[7].attempts, "Failed boards are retried once");
+    for (size_t i = 0; i < devices.size(); ++i) {
+        const FleetFlasher::DeviceStatus& status = result.devices[i < 2 ? i : i + 1];
+        assert_true(status.state == FleetFlasher::State::DONE, status.port + ": " + status.error);
+        assert_true(devices[i]->flash.compare(0x10000, 200000, regions[0].data) == 0, "Board flashed");
+    }
+    assert_true(peak_active > 1, "Boards should flash concurrently");
+    assert_true(reports >= 2, "Progress should be reported while waiting");
+    assert_equal(6 * 200000, result.throughput.bytes_done);
+    assert_true(result.throughput.bytes_per_second > 0, "Throughput is measured");
+    assert_true(FleetFlasher::FormatTable(result).find("6 of 8 board(s) flashed") != std::string::npos,
+                FleetFlasher::FormatTable(result));
+
+    // Boards that already have the image send only MD5 requests
+    ports.erase(ports.begin() + 2);
+    ports.pop_back();
+    fleet.SetProgressCallback(nullptr);
+    FleetFlasher::FleetResult again = fleet.Flash(ports, image);
+    assert_true(again.success, "Re-flash succeeds");
+    assert_equal(6 * 200000, again.throughput.bytes_done, "Skipped bytes count as progress");
+    assert_equal(0, again.throughput.bytes_written, "Nothing written");
+    assert_true(again.throughput.bytes_per_second * again.throughput.elapsed_ms / 1000.0 <=
+                again.throughput.wire_bytes + 1.0, "Rate counts only what was sent");
+
+    std::cout << "  ✓ Fleet flash tests passed (" << static_cast<long long>(result.throughput.bytes_per_second / 1024)
+              << " KiB/s aggregate)" << std::endl;
+}
+
+void test_fleet_slow_board() {
+    SimulatedBootloader fast_a, fast_b, slow;
+    slow.reply_delay_ms = 300;
+    std::vector<FlashImage::Region> regions = {{0x10000, make_firmware(400000, 6)}};
+    FlashImage image(regions, 64 * 1024, true);
+
+    FleetFlasher fleet;
+    FleetFlasher::Options options = fleet.GetOptions();
+    options.flasher = test_options();
+    options.device_timeout_ms = 2500;
+    options.report_interval_ms = 20;
+    fleet.SetOptions(options);
+
+    FleetFlasher::FleetResult result = fleet.Flash({slow.GetPath(), fast_a.GetPath(), fast_b.GetPath()}, image);
+    assert_true(result.devices[0].state == FleetFlasher::State::FAILED, "The slow board is cut off");
+    assert_true(result.devices[0].error.find("Timed out") != std::string::npos, result.devices[0].error);
+    assert_equal(1, result.devices[0].attempts, "A timed-out board is not retried");
+    for (size_t i = 1; i < 3; ++i) {
+        assert_true(result.devices[i].state == FleetFlasher::State::DONE, result.devices[i].error);
+        assert_true(result.devices[i].elapsed_ms < result.devices[0].elapsed_ms,
+                    "Fast boards finish without waiting for the slow one");
+    }
+    assert_true(result.throughput.elapsed_ms < 4000, "The timeout bounds the run");
+
+    std::cout << "  ✓ Slow board tests passed" << std::endl;
+}
+
+// ============================================================================
+// Ring and Monitor Tests
+// ============================================================================
+
+void test_spsc_ring() {
+    utils::SpscRing ring(1000);
+    assert_equal(1024, ring.Capacity(), "Capacity rounds up to a power of two");
+    std::string block(700, 'a');
+    assert_equal(700, ring.Write(block.data(), block.size()));
+    assert_equal(324, ring.Write(block.data(), block.size()), "Only the free space is taken");
+    char out[1024];
+    assert_equal(600, ring.Read(out, 600));
+    assert_equal(600, ring.Write(block.data(), 600), "Writes wrap around");
+    assert_equal(1024, ring.Read(out, sizeof(out)));
+    assert_equal(0, ring.Size());
+
+    // A producer and a consumer thread, odd chunk sizes on both sides
+    const size_t total = 16 * 1024 * 1024;
+    utils::SpscRing shared(4096);
+    std::thread producer([&]() {
+        char chunk[777];
+        size_t sent = 0;
+        while (sent < total) {
+            size_t size = std::min(sizeof(chunk), total - sent);
+            for (size_t i = 0; i < size; ++i) chunk[i] = static_cast<char>((sent + i) % 251);
+            size_t done = 0;
+            while (done < size) {
+                size_t written = shared.Write(chunk + done, size - done);
+                if (written == 0) std::this_thread::yield();
+                done += written;
+            }
+            sent += size;
+        }
+    });
+    size_t received = 0;
+    bool ordered = true;
+    while (received < total) {
+        size_t size;
+        const char* span = shared.ReadSpan(size);
+        size = std::min<size_t>(size, 333);
+        if (size == 0) std::this_thread::yield();
+        for (size_t i = 0; i < size; ++i) {
+            ordered &= span[i] == static_cast<char>((received + i) % 251);
+        }
+        shared.Consume(size);
+        received += size;
+    }
+    producer.join();
+    assert_true(ordered, "Every byte should arrive once, in order");
+
+    std::cout << "  ✓ SPSC ring tests passed" << std::endl;
+}
+
+void test_custom_baud_rates() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    SerialPort port;
+    assert_true(port.Open(ptsname(master), 2000000), port.GetError());
+    assert_true(port.SetBaudRate(3000000), port.GetError());
+    assert_true(port.SetBaudRate(1843200), "Rates without a B* constant: " + port.GetError());
+    assert_equal(1843200, port.GetBaudRate());
+    assert_true(port.SetBaudRate(250000), port.GetError());
+    assert_true(!port.SetBaudRate(0), "Zero is not a rate");
+    port.Close();
+    close(master);
+
+    std::cout << "  ✓ Custom baud rate tests passed" << std::endl;
+}
+
+void test_monitor_over_pty() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    std::string path = ptsname(master);
+
+    SerialMonitor monitor;
+    monitor.SetBufferSize(64 * 1024);
+    assert_true(monitor.Connect(path, 2000000), "Should open the pty");
+    assert_true(monitor.IsConnected(), "Connected");
+    assert_true(!monitor.Connect("/nonexistent/ttyUSB9", 115200), "Missing ports fail");
+    assert_true(monitor.Connect(path, 2000000), "Should reconnect");
+    size_t first = monitor.GetMessages().size();
+
+    // Verbose logging at full speed: lines split across writes, CRLF endings
+    const int lines = 40000;
+    std::thread device([&]() {
+        std::string data;
+        for (int i = 0; i < lines; ++i) {
+            data += (i == 100 ? "E (100) wifi: auth failed " : "I (10) sensor: reading ") + std::to_string(i) + "\r\n";
+        }
+        for (size_t done = 0; done < data.size();) {
+            ssize_t n = write(master, data.data() + done, std::min<size_t>(1000, data.size() - done));
+            if (n > 0) done += static_cast<size_t>(n);
+        }
+    });
+    size_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (seen < static_cast<size_t>(lines) && std::chrono::steady_clock::now() < deadline) {
+        seen += monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    device.join();
+    assert_equal(lines, seen, "Every line should arrive");
+
+    std::vector<SerialMonitor::SerialMessage> messages = monitor.GetMessages();
+    bool ordered = true;
+    for (int i = 0; i < lines; ++i) {
+        const std::string& content = messages[first + i].content;
+        std::string suffix = " " + std::to_string(i);
+        ordered &= content.size() > suffix.size() &&
+                   content.compare(content.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+    assert_true(ordered, "Lines should arrive whole and in order, without CR");
+    assert_true(messages[first + 100].type == SerialMonitor::MessageType::ERROR, "ESP-IDF errors are flagged");
+    assert_true(monitor.GetReaderStatistics().bytes_read > static_cast<uint64_t>(lines) * 20, "Bytes counted");
+
+    assert_true(monitor.SendData("ping\n"), "Send");
+    char reply[16] = {};
+    struct pollfd pfd = {master, POLLIN, 0};
+    assert_true(poll(&pfd, 1, 1000) == 1 && read(master, reply, sizeof(reply)) == 5, "Device receives it");
+    assert_true(std::string(reply) == "ping\n", reply);
+
+    // Unplugging the device ends the connection; the last partial line is kept
+    assert_true(write(master, "tail", 4) == 4, "Partial line");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close(master);
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (monitor.IsConnected() && std::chrono::steady_clock::now() < deadline) {
+        monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert_true(!monitor.IsConnected(), "Hang-up should disconnect");
+    messages = monitor.GetMessages();
+    assert_true(messages[messages.size() - 2].content == "tail", "Partial line flushed");
+    assert_true(messages.back().content.find("Connection lost") != std::string::npos, messages.back().content);
+
+    std::cout << "  ✓ Monitor over pty tests passed" << std::endl;
+}
+
+void test_monitor_batching() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    std::string path = ptsname(master);
+
+    // Frame-paced: 20k lines a second reach the listener a handful of times
+    SerialMonitor monitor;
+    std::vector<std::string> received;
+    std::vector<size_t> sizes;
+    std::vector<std::chrono::steady_clock::time_point> times;
+    monitor.SetBatchCallback([&](const SerialMonitor::SerialMessage* messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) received.push_back(messages[i].content);
+        sizes.push_back(count);
+        times.push_back(std::chrono::steady_clock::now());
+    });
+    assert_true(monitor.Connect(path, 921600), "Should open the pty");
+    assert_true(received.size() == 1, "An idle monitor delivers right away");
+
+    const int lines = 20000;
+    std::thread device([&]() {
+        std::string data;
+        for (int i = 0; i < lines; ++i) {
+            data += "I (10) sensor: reading " + std::to_string(i) + "\n";
+        }
+        for (size_t done = 0; done < data.size();) {
+            ssize_t n = write(master, data.data() + done, std::min<size_t>(1000, data.size() - done));
+            if (n > 0) done += static_cast<size_t>(n);
+        }
+    });
+    size_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (seen < static_cast<size_t>(lines) && std::chrono::steady_clock::now() < deadline) {
+        seen += monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    device.join();
+    assert_equal(lines, seen, "Every line should arrive");
+    monitor.FlushMessages();
+    assert_equal(lines + 1, received.size(), "Every message delivered once");
+    bool ordered = true;
+    for (int i = 0; i < lines; ++i) {
+        ordered &= received[i + 1] == "I (10) sensor: reading " + std::to_string(i);
+    }
+    assert_true(ordered, "Batches keep arrival order");
+    assert_true(sizes.size() < static_cast<size_t>(lines) / 10, "Lines should be coalesced");
+    bool paced = true;
+    for (size_t i = 1; i + 1 < sizes.size(); ++i) {
+        paced &= sizes[i] == 4096 || times[i] - times[i - 1] >= std::chrono::milliseconds(15);
+    }
+    assert_true(paced, "At most one batch per frame unless one fills up");
+    close(master);
+
+    // Size threshold, and immediate delivery with pacing off
+    SerialMonitor bulk;
+    sizes.clear();
+    received.clear();
+    bulk.SetBatchCallback([&](const SerialMonitor::SerialMessage*, size_t count) { sizes.push_back(count); });
+    bulk.SetBatchLimits(1, 1000);
+    for (int i = 0; i < lines; ++i) {
+        bulk.AddMessage("line " + std::to_string(i));
+    }
+    size_t delivered = 0;
+    for (size_t size : sizes) delivered += size;
+    assert_true(*std::max_element(sizes.begin(), sizes.end()) == 1000, "Full batches go out at the threshold");
+    assert_equal(lines - delivered, bulk.FlushMessages(), "Flush hands over the rest");
+    assert_equal(0, bulk.FlushMessages(), "Nothing left");
+
+    bulk.SetBatchLimits(0, 1000);
+    sizes.clear();
+    bulk.AddMessage("a");
+    bulk.AddMessage("b");
+    assert_true(sizes.size() == 2 && sizes[0] == 1 && sizes[1] == 1, "Rate 0 delivers each message");
+
+    std::cout << "  ✓ Monitor batching tests passed" << std::endl;
+}
+
+void test_session_replay() {
+    std::string path = (std::filesystem::temp_directory_path() / "esp32ide_session.e3s").string();
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+
+    // A live session, recorded: lines split across reads, one left unfinished
+    std::vector<std::string> sent;
+    for (int i = 0; i < 300; ++i) {
+        sent.push_back((i == 150 ? "E (150) spi: timeout " : "I (" + std::to_string(i) + ") adc: ") + std::to_string(i));
+    }
+    SerialMonitor live;
+    assert_true(live.Connect(ptsname(master), 115200), "Should open the pty");
+    assert_true(live.StartSessionRecording(path), "Start session recording");
+    std::string data;
+    for (const std::string& line : sent) data += line + "\r\n";
+    data += "tail";
+    for (size_t done = 0; done < data.size(); done += 700) {
+        std::string piece = data.substr(done, 700);
+        assert_true(write(master, piece.data(), piece.size()) == static_cast<ssize_t>(piece.size()), "Device write");
+        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+        live.ProcessIncoming();
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (live.GetReaderStatistics().bytes_read < data.size() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    live.ProcessIncoming();
+    live.StopSessionRecording();
+    assert_true(!live.IsSessionRecording(), "Stopped");
+    close(master);
+
+    // Replayed as fast as possible, twice: same lines, same timestamps
+    auto replay = [&](std::vector<SerialMonitor::SerialMessage>& lines) {
+        SerialMonitor monitor;
+        assert_true(monitor.StartReplay(path, 0), "Start replay");
+        while (monitor.IsReplaying()) monitor.ProcessIncoming();
+        for (const SerialMonitor::SerialMessage& message : monitor.GetMessages()) {
+            if (message.type == SerialMonitor::MessageType::NORMAL || message.type == SerialMonitor::MessageType::ERROR) {
+                lines.push_back(message);
+            }
+        }
+    };
+    std::vector<SerialMonitor::SerialMessage> first;
+    std::vector<SerialMonitor::SerialMessage> second;
+    replay(first);
+    replay(second);
+    assert_equal(sent.size() + 1, first.size(), "Every line, and the unfinished one at the end");
+    bool same = first.back().content == "tail";
+    for (size_t i = 0; i < sent.size(); ++i) {
+        same &= first[i].content == sent[i];
+    }
+    assert_true(same, "Replayed lines match what was sent");
+    assert_true(first[150].type == SerialMonitor::MessageType::ERROR, "Classified as live");
+    bool deterministic = first.size() == second.size();
+    for (size_t i = 0; deterministic && i < first.size(); ++i) {
+        deterministic = first[i].content == second[i].content && first[i].timestamp == second[i].timestamp;
+    }
+    assert_true(deterministic, "Replays are identical");
+    assert_true(first.front().timestamp < first.back().timestamp, "Recorded times are kept");
+
+    // Pacing, on a session with known gaps
+    {
+        SerialSessionWriter writer;
+        assert_true(writer.Open(path), writer.GetError());
+        long long base = SerialSessionWriter::Now();
+        writer.Record("a\n", 2, base);
+        writer.Record("b\n", 2, base + 300000000LL);
+        writer.Record("c\n", 2, base + 600000000LL);
+        assert_equal(6, writer.GetBytesRecorded());
+    }
+    {
+        // A record cut short, as by a crash
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn << '\x05' << '\x10' << "par";
+    }
+    SerialSessionReplay player;
+    assert_true(player.Open(path), player.GetError());
+    SerialSessionReplay::Chunk chunk;
+    player.Start(1.0);
+    assert_true(player.Next(chunk) && std::string(chunk.data, chunk.size) == "a\n", "The first read is due at once");
+    long long offset = chunk.offset;
+    assert_true(!player.Next(chunk), "The next one 300 ms later");
+    player.Start(100.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    std::string replayed;
+    while (player.Next(chunk)) {
+        replayed.append(chunk.data, chunk.size);
+        assert_true(chunk.offset >= offset, "Offsets grow");
+    }
+    assert_true(replayed == "a\nb\nc\n", "At 100x, all due within 15 ms: " + replayed);
+    assert_equal(offset + 600000000LL, chunk.offset, "Gaps kept to the nanosecond");
+    assert_true(player.AtEnd(), "The torn record is not replayed");
+    player.Close();
+
+    // The pipeline at full speed: replayed lines straight into the plotter
+    {
+        SerialSessionWriter writer;
+        assert_true(writer.Open(path), writer.GetError());
+        std::string chunk_data;
+        long long now = SerialSessionWriter::Now();
+        for (int i = 0; i < 100000; ++i) {
+            chunk_data += "t:" + std::to_string(i) + ",temp:" + std::to_string(20 + i % 7) + ".5\n";
+            if (chunk_data.size() >= 4000) {
+                writer.Record(chunk_data.data(), chunk_data.size(), now += 1000000);
+                chunk_data.clear();
+            }
+        }
+        writer.Record(chunk_data.data(), chunk_data.size(), now += 1000000);
+    }
+    SerialMonitor monitor;
+    visualization::SerialPlotter plotter;
+    monitor.SetBatchCallback([&](const SerialMonitor::SerialMessage* messages, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (messages[i].type == SerialMonitor::MessageType::NORMAL) plotter.AddLine(messages[i].content);
+        }
+    });
+    auto started = std::chrono::steady_clock::now();
+    assert_true(monitor.StartReplay(path, 0), "Start replay");
+    while (monitor.IsReplaying()) monitor.ProcessIncoming();
+    monitor.FlushMessages();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    assert_equal(100000, plotter.GetSampleCount(plotter.FindSeries("temp")), "Every sample plotted");
+
+    std::filesystem::remove(path);
+    std::cout << "  ✓ Session replay tests passed (" << static_cast<long long>(100000 / seconds)
+              << " lines/s through the plotter)" << std::endl;
+}
+
+void test_multi_port_monitor() {
+    const int count = 24;
+    std::vector<int> masters;
+    MultiPortMonitor monitor;
+    for (int i = 0; i < count; ++i) {
+        int master = posix_openpt(O_RDWR | O_NOCTTY);
+        grantpt(master);
+        unlockpt(master);
+        masters.push_back(master);
+        assert_equal(i, monitor.AddPort(ptsname(master), 921600), monitor.GetError());
+    }
+    assert_equal(-1, monitor.AddPort("/nonexistent/ttyUSB9", 115200), "Missing ports fail");
+    assert_equal(count, monitor.GetPortCount());
+
+    // Every board logging at once, then markers on different boards a few
+    // milliseconds apart, whose order the merged view must keep
+    const int rounds = 200;
+    const int markers = 6;
+    std::thread rack([&]() {
+        for (int round = 0; round < rounds; ++round) {
+            for (int port = 0; port < count; ++port) {
+                std::string line = "I (" + std::to_string(round) + ") board " + std::to_string(port) + "\r\n";
+                assert_true(write(masters[port], line.data(), line.size()) == static_cast<ssize_t>(line.size()));
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        for (int k = 0; k < markers; ++k) {
+            std::string line = "E (0) marker " + std::to_string(k) + "\n";
+            assert_true(write(masters[(k * 5) % count], line.data(), line.size()) == static_cast<ssize_t>(line.size()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+    const size_t expected = count * rounds + markers;
+    size_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (seen < expected && std::chrono::steady_clock::now() < deadline) {
+        seen += monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    rack.join();
+    assert_equal(expected, seen, "Every line from every board");
+
+    for (int port = 0; port < count; ++port) {
+        bool ordered = true;
+        int round = 0;
+        monitor.GetLog(port).Read(0, rounds, [&](uint64_t, const SerialLogStore::Message& message) {
+            ordered &= message.content == "I (" + std::to_string(round++) + ") board " + std::to_string(port);
+        });
+        assert_true(ordered && round == rounds, "Port " + std::to_string(port) + " lines in order, without CR");
+        assert_true(monitor.GetPortStatistics(port).bytes_read > 0, "Bytes counted");
+    }
+
+    MultiPortMonitor::MergedCursor cursor = monitor.GetMergedCursor();
+    MultiPortMonitor::Entry entry;
+    size_t merged = 0;
+    long long previous = 0;
+    bool sorted = true;
+    std::vector<int> marker_order;
+    while (cursor.Next(entry)) {
+        sorted &= entry.message.timestamp >= previous;
+        previous = entry.message.timestamp;
+        if (entry.message.type == static_cast<uint8_t>(SerialMonitor::MessageType::ERROR)) {
+            marker_order.push_back(entry.message.content.back() - '0');
+            assert_equal((marker_order.back() * 5) % count, entry.port, "Marker port");
+        }
+        merged++;
+    }
+    assert_equal(expected, merged, "The merged view covers every port");
+    assert_true(sorted, "The merged view is in timestamp order");
+    assert_equal(markers, marker_order.size());
+    for (int k = 0; k < markers; ++k) {
+        assert_equal(k, marker_order[k], "Markers keep their order across boards");
+    }
+    assert_true(previous <= monitor.Now(), "One clock for every port");
+
+    assert_true(monitor.SendData(7, "reset\n"), "Send to one board");
+    char reply[16] = {};
+    struct pollfd pfd = {masters[7], POLLIN, 0};
+    assert_true(poll(&pfd, 1, 1000) == 1 && read(masters[7], reply, sizeof(reply)) == 6, "That board receives it");
+
+    // One board unplugged; the rest carry on
+    assert_true(write(masters[3], "tail", 4) == 4, "Partial line");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    close(masters[3]);
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (monitor.IsPortConnected(3) && std::chrono::steady_clock::now() < deadline) {
+        monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    assert_true(!monitor.IsPortConnected(3), "Hang-up should disconnect the port");
+    std::vector<std::string> last;
+    const SerialLogStore& log = monitor.GetLog(3);
+    log.Read(log.GetEndIndex() - 2, 2, [&](uint64_t, const SerialLogStore::Message& message) {
+        last.push_back(std::string(message.content));
+    });
+    assert_true(last.size() == 2 && last[0] == "tail", "Partial line flushed");
+    assert_true(last[1].find("Connection lost") != std::string::npos, last[1]);
+    assert_true(write(masters[4], "still here\n", 11) == 11, "Another board");
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (monitor.ProcessIncoming() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    assert_true(monitor.IsPortConnected(4), "Other ports stay connected");
+    assert_equal(rounds + 1, monitor.GetLog(4).Size(), "And keep receiving");
+
+    // A cursor from given positions hands out only what came after them
+    std::vector<uint64_t> ends;
+    for (int port = 0; port < count; ++port) ends.push_back(monitor.GetLog(port).GetEndIndex());
+    assert_true(write(masters[1], "after ends\n", 11) == 11, "One more line");
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (monitor.ProcessIncoming() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    MultiPortMonitor::MergedCursor following = monitor.GetMergedCursor(ends);
+    assert_true(following.Next(entry) && entry.port == 1 && entry.message.content == "after ends", "New line only");
+    assert_true(!following.Next(entry), "Nothing else");
+
+    // Closing keeps what the loop already read, the unterminated tail too
+    assert_true(write(masters[0], "last words\nhalf", 15) == 15, "Unprocessed lines");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t before_close = monitor.GetLog(0).GetEndIndex();
+    monitor.ClosePort(0);
+    assert_true(!monitor.IsPortConnected(0), "Closed");
+    last.clear();
+    monitor.GetLog(0).Read(before_close, 10, [&](uint64_t, const SerialLogStore::Message& message) {
+        last.push_back(std::string(message.content));
+    });
+    assert_true(last.size() == 2 && last[0] == "last words" && last[1] == "half", "Drained on close");
+    for (int i = 0; i < count; ++i) {
+        if (i != 3) close(masters[i]);
+    }
+    std::cout << "  ✓ Multi-port monitor tests passed" << std::endl;
+}
+
+std::string hex_address(uint64_t address) {
+    char text[24];
+    std::snprintf(text, sizeof(text), "0x%08llx", static_cast<unsigned long long>(address));
+    return text;
+}
+
+void test_panic_symbolizer() {
+    // This test binary stands in for the firmware ELF
+    std::string elf = "/proc/self/exe";
+    ElfSizeAnalyzer analyzer;
+    assert_true(analyzer.Analyze(elf), analyzer.GetError());
+    uint64_t ring = 0;
+    uint64_t replay = 0;
+    for (const ElfSizeAnalyzer::Symbol& symbol : analyzer.GetReport().symbols) {
+        if (symbol.name == "_Z14test_spsc_ringv") ring = symbol.address;
+        if (symbol.name == "_Z19test_session_replayv") replay = symbol.address;
+    }
+    assert_true(ring != 0 && replay != 0, "Test functions are in the symbol table");
+
+    std::string index = (std::filesystem::temp_directory_path() / "esp32ide_firmware.symbols").string();
+    std::filesystem::remove(index);
+    PanicSymbolizer symbolizer;
+    assert_true(symbolizer.Load(elf, index), symbolizer.GetError());
+    assert_true(std::filesystem::exists(index), "Index saved");
+    assert_true(symbolizer.GetFunctionCount() > 100, "Functions indexed");
+
+    std::string_view function;
+    uint64_t offset = 0;
+    assert_true(symbolizer.Lookup(ring + 4, function, offset), "Address inside a function");
+    assert_true(function == "test_spsc_ring()", "Demangled name: " + std::string(function));
+    assert_equal(4, offset, "Offset into the function");
+    assert_true(!symbolizer.Lookup(0x10, function, offset), "Address outside every function");
+
+    std::vector<std::string> frames = symbolizer.Symbolize(
+        "Backtrace: " + hex_address(ring + 4) + ":0x3ffb0000 " + hex_address(replay) + ":0x3ffb0010 0x00000010:0x3ffb0020 |<-CORRUPTED");
+    assert_equal(3, frames.size(), "A line per frame");
+    assert_true(frames[0].find("test_spsc_ring()+4") != std::string::npos, frames[0]);
+    assert_true(frames[1].find("test_session_replay()") != std::string::npos, frames[1]);
+    assert_true(frames[2].find("??") != std::string::npos, frames[2]);
+    frames = symbolizer.Symbolize("PC      : " + hex_address(ring) + "  EXCVADDR: 0x00000000  A0      : " + hex_address(replay + 8));
+    assert_equal(2, frames.size(), "Register dump: only addresses in functions");
+    assert_true(frames[1].find("test_session_replay()+8") != std::string::npos, frames[1]);
+    assert_equal(1, symbolizer.Symbolize("abort() was called at PC " + hex_address(ring + 2) + " on core 0").size(), "abort()");
+    assert_true(symbolizer.Symbolize("I (100) app: value " + hex_address(ring)).empty(), "Ordinary lines are left alone");
+
+    // Loading the same ELF again maps the saved index instead of rebuilding it
+    auto saved = std::filesystem::last_write_time(index);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    PanicSymbolizer reloaded;
+    assert_true(reloaded.Load(elf, index), reloaded.GetError());
+    assert_true(std::filesystem::last_write_time(index) == saved, "Index reused");
+    assert_equal(symbolizer.GetFunctionCount(), reloaded.GetFunctionCount(), "Same index");
+
+    // A names table whose last name runs off its end is rebuilt, not trusted
+    std::string unterminated = index + ".unterminated";
+    std::filesystem::copy_file(index, unterminated, std::filesystem::copy_options::overwrite_existing);
+    {
+        std::fstream damaged(unterminated, std::ios::in | std::ios::out | std::ios::binary);
+        damaged.seekp(-1, std::ios::end);
+        damaged.put('x');
+    }
+    PanicSymbolizer rebuilt;
+    assert_true(rebuilt.Load(elf, unterminated), rebuilt.GetError());
+    {
+        std::ifstream repaired(unterminated, std::ios::binary);
+        repaired.seekg(-1, std::ios::end);
+        assert_true(repaired.get() == '\0', "Unterminated names rejected and rebuilt");
+    }
+    rebuilt.Close();
+    std::filesystem::remove(unterminated);
+
+    // A 16-frame backtrace well inside the 1 ms budget
+    std::string backtrace = "Backtrace:";
+    for (int i = 0; i < 16; ++i) {
+        backtrace += " " + hex_address((i % 2 ? ring : replay) + i) + ":0x3ffb" + std::to_string(1000 + i);
+    }
+    const int rounds = 2000;
+    size_t symbolized = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        symbolized += reloaded.Symbolize(backtrace).size();
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    assert_equal(16 * rounds, symbolized, "Every frame");
+    assert_true(us < 1000, "Backtrace symbolized in " + std::to_string(us) + " us");
+
+    // In-line in the monitor, fed by a replayed crash
+    std::string session = (std::filesystem::temp_directory_path() / "esp32ide_panic.e3s").string();
+    {
+        SerialSessionWriter writer;
+        assert_true(writer.Open(session), writer.GetError());
+        std::string crash = "Guru Meditation Error: Core  1 panic'ed (LoadProhibited). Exception was unhandled.\r\n"
+                            "PC      : " + hex_address(ring + 4) + "  PS      : 0x00060030\r\n\r\n"
+                            "Backtrace: " + hex_address(ring + 4) + ":0x3ffb0000 " + hex_address(replay) + ":0x3ffb0010\r\n"
+                            "Rebooting...\r\n";
+        writer.Record(crash.data(), crash.size(), SerialSessionWriter::Now());
+    }
+    SerialMonitor monitor;
+    // /proc/self/exe.symbols cannot be created, so this index stays in memory
+    assert_true(monitor.LoadFirmwareSymbols(elf), "Load firmware symbols");
+    assert_true(monitor.HasFirmwareSymbols(), "Loaded");
+    assert_true(monitor.StartReplay(session, 0), "Start replay");
+    while (monitor.IsReplaying()) monitor.ProcessIncoming();
+    std::vector<SerialMonitor::SerialMessage> messages = monitor.GetMessages();
+    auto at = std::find_if(messages.begin(), messages.end(), [](const SerialMonitor::SerialMessage& message) {
+        return message.content.compare(0, 10, "Backtrace:") == 0;
+    });
+    assert_true(at != messages.end() && messages.end() - at >= 3, "Backtrace received");
+    assert_true(at[1].content.find("test_spsc_ring()+4") != std::string::npos, at[1].content);
+    assert_true(at[2].content.find("test_session_replay()") != std::string::npos, at[2].content);
+    assert_true(at[1].type == SerialMonitor::MessageType::ERROR && at[1].timestamp == at[0].timestamp,
+                "Frames follow the backtrace, with its time");
+    assert_true(at[3].content == "Rebooting...", "Then the rest of the output");
+    bool guru = false;
+    bool pc = false;
+    for (const SerialMonitor::SerialMessage& message : messages) {
+        guru |= message.content.compare(0, 15, "Guru Meditation") == 0 && message.type == SerialMonitor::MessageType::ERROR;
+        pc |= message.content.find(hex_address(ring + 4) + ": test_spsc_ring()+4") != std::string::npos;
+    }
+    assert_true(guru, "Guru Meditation marked as an error");
+    assert_true(pc, "Register dump symbolized");
+
+    std::filesystem::remove(index);
+    std::filesystem::remove(session);
+    std::cout << "  ✓ Panic symbolizer tests passed (" << us << " us per 16-frame backtrace)" << std::endl;
+}
+
+// ============================================================================
+// Binary telemetry
+// ============================================================================
+
+std::string cobs_encode(const std::string& payload) {
+    std::string out(1, '\0');
+    size_t code_at = 0;
+    for (char byte : payload) {
+        if (byte != 0) out.push_back(byte);
+        if (byte == 0 || out.size() - code_at == 0xFF) {
+            out[code_at] = static_cast<char>(out.size() - code_at);
+            code_at = out.size();
+            out.push_back('\0');
+        }
+    }
+    out[code_at] = static_cast<char>(out.size() - code_at);
+    out.push_back('\0');
+    return out;
+}
+
+std::string length_encode(const std::string& payload) {
+    std::string out;
+    out.push_back(static_cast<char>(payload.size() & 0xFF));
+    out.push_back(static_cast<char>(payload.size() >> 8));
+    return out + payload;
+}
+
+// Packed little-endian records of "t:u32 ax:i16*0.01 temp:f32"
+std::string sensor_records(uint32_t first, size_t count) {
+    std::string out;
+    for (uint32_t t = first; t < first + count; ++t) {
+        int16_t ax = static_cast<int16_t>(static_cast<int>(t % 2000) - 1000);
+        float temp = 20.0f + static_cast<float>(t % 100) / 4;
+        out.append(reinterpret_cast<const char*>(&t), 4);
+        out.append(reinterpret_cast<const char*>(&ax), 2);
+        out.append(reinterpret_cast<const char*>(&temp), 4);
+    }
+    return out;
+}
+
+void test_frame_decoders() {
+    // Payloads full of delimiter and escape bytes, and long COBS runs
+    std::vector<std::string> payloads;
+    unsigned state = 1;
+    for (int i = 0; i < 300; ++i) {
+        std::string payload(1 + i * 7 % 700, '\0');
+        for (char& byte : payload) {
+            state = state * 1103515245 + 12345;
+            byte = static_cast<char>(i % 3 == 0 ? 0xC0 + (state >> 16) % 2 * 0x1B : (state >> 16) & 0xFF);
+        }
+        payloads.push_back(payload);
+    }
+    payloads.push_back(std::string(600, 'x'));
+
+    for (FrameDecoder::Framing framing : {FrameDecoder::Framing::COBS, FrameDecoder::Framing::SLIP,
+                                          FrameDecoder::Framing::LENGTH_PREFIXED}) {
+        // Attached mid-frame; length prefixes have no delimiter to resync on
+        std::string stream = framing == FrameDecoder::Framing::LENGTH_PREFIXED ? "" : "\x05garbage";
+        for (const std::string& payload : payloads) {
+            if (framing == FrameDecoder::Framing::COBS) stream += cobs_encode(payload);
+            if (framing == FrameDecoder::Framing::SLIP) EspFlasher::SlipEncode(payload, stream);
+            if (framing == FrameDecoder::Framing::LENGTH_PREFIXED) stream += length_encode(payload);
+        }
+        std::unique_ptr<FrameDecoder> decoder = FrameDecoder::Create(framing, 1024);
+        std::vector<std::string> frames;
+        FrameDecoder::FrameCallback collect = [&](const uint8_t* frame, size_t size) {
+            frames.emplace_back(reinterpret_cast<const char*>(frame), size);
+        };
+        // Odd piece sizes split frames, escapes and prefixes everywhere
+        size_t emitted = 0;
+        for (size_t at = 0, piece = 1; at < stream.size(); at += piece, piece = piece % 97 + 13) {
+            emitted += decoder->Feed(reinterpret_cast<const uint8_t*>(stream.data()) + at,
+                                     std::min(piece, stream.size() - at), collect);
+        }
+        assert_equal(frames.size(), emitted, "Feed counts frames");
+        // The garbage may take the first frame down with it
+        size_t lost = frames.size() < payloads.size() ? payloads.size() - frames.size() : 0;
+        assert_true(lost <= 1, "Decoding should pick up after the garbage");
+        // Compared from the end: the garbage itself may come out as a frame
+        bool same = true;
+        for (size_t i = 0; i < std::min(frames.size(), payloads.size()); ++i) {
+            same &= frames[frames.size() - 1 - i] == payloads[payloads.size() - 1 - i];
+        }
+        assert_true(same, "Frames should decode to their payloads");
+        assert_true(decoder->GetStatistics().dropped > 0 || lost == 0, "Garbage is counted");
+    }
+
+    // Corrupt and oversized frames are dropped without losing the next one
+    std::unique_ptr<FrameDecoder> slip = FrameDecoder::Create(FrameDecoder::Framing::SLIP, 16);
+    std::string stream = "\xC0" "ab\xDB\x01" "cd\xC0" + std::string(40, 'z') + "\xC0" "ok\xC0";
+    std::vector<std::string> frames;
+    slip->Feed(reinterpret_cast<const uint8_t*>(stream.data()), stream.size(), [&](const uint8_t* frame, size_t size) {
+        frames.emplace_back(reinterpret_cast<const char*>(frame), size);
+    });
+    assert_true(frames.size() == 1 && frames[0] == "ok", "Only the good frame survives");
+    assert_equal(2, slip->GetStatistics().dropped, "Bad escape and overflow");
+
+    std::cout << "  ✓ Frame decoder tests passed" << std::endl;
+}
+
+void test_telemetry_decoder() {
+    FrameLayout layout;
+    assert_true(!layout.Parse("t:u32 ax:i17"), "Unknown types are rejected");
+    assert_true(layout.Parse("t:u32, ax:i16*0.01 temp:f32"), layout.GetError());
+    assert_equal(10, layout.GetRecordSize(), "Packed");
+    assert_equal(2, layout.FindField("temp"), "Fields by name");
+
+    TelemetryDecoder decoder(FrameDecoder::Create(FrameDecoder::Framing::COBS), layout);
+    std::string stream;
+    for (uint32_t t = 0; t < 4000; t += 8) {
+        stream += cobs_encode(sensor_records(t, 8));
+    }
+    stream += cobs_encode("odd size");
+    size_t records = 0;
+    for (size_t at = 0; at < stream.size(); at += 7) {
+        records += decoder.Feed(stream.data() + at, std::min<size_t>(7, stream.size() - at));
+    }
+    assert_equal(4000, records, "Every record decoded");
+    assert_equal(4000, decoder.GetRowCount(), "Rows accumulate until cleared");
+    bool exact = true;
+    for (size_t i = 0; i < 4000; ++i) {
+        exact &= decoder.GetColumn(0)[i] == static_cast<double>(i);
+        exact &= std::abs(decoder.GetColumn(1)[i] - (static_cast<int>(i % 2000) - 1000) * 0.01) < 1e-9;
+        exact &= decoder.GetColumn(2)[i] == 20.0 + static_cast<double>(i % 100) / 4;
+    }
+    assert_true(exact, "Columns hold the scaled values");
+    assert_equal(1, decoder.GetStatistics().bad_frames, "Wrong-sized frames are counted");
+
+    // Storage is kept across ClearColumns(): no allocation once warmed up
+    const double* storage = decoder.GetColumn(0);
+    decoder.ClearColumns();
+    decoder.Feed(stream.data(), stream.size() / 2);
+    decoder.Feed(stream.data() + stream.size() / 2, stream.size() - stream.size() / 2);
+    assert_true(decoder.GetColumn(0) == storage, "Columns are reused");
+
+    FrameLayout big;
+    assert_true(big.Parse(">id:u16 v:i32"), big.GetError());
+    TelemetryDecoder big_decoder(FrameDecoder::Create(FrameDecoder::Framing::LENGTH_PREFIXED), big);
+    std::string record("\x01\x02\xFF\xFF\xFF\xFE", 6);
+    std::string framed = length_encode(record);
+    big_decoder.Feed(framed.data(), framed.size());
+    assert_true(big_decoder.GetColumn(0)[0] == 0x0102 && big_decoder.GetColumn(1)[0] == -2, "Big-endian fields");
+
+    // Throughput: short frames of one record each, the worst case for framing
+    std::string bulk;
+    for (uint32_t t = 0; t < 200000; ++t) {
+        bulk += cobs_encode(sensor_records(t, 1));
+    }
+    decoder.ClearColumns();
+    auto start = std::chrono::steady_clock::now();
+    size_t samples = 0;
+    for (size_t at = 0; at < bulk.size(); at += 4096) {
+        samples += decoder.Feed(bulk.data() + at, std::min<size_t>(4096, bulk.size() - at)) * 3;
+        decoder.ClearColumns();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert_equal(600000, samples, "Every sample decoded");
+
+    std::cout << "  ✓ Telemetry decoder tests passed (" << static_cast<long long>(samples / seconds / 1000)
+              << "k samples/s)" << std::endl;
+}
+
+void test_monitor_telemetry() {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    grantpt(master);
+    unlockpt(master);
+    std::string path = ptsname(master);
+
+    visualization::SignalAnalyzer analyzer;
+    visualization::WaveformConfig config;
+    config.channel_name = "ax";
+    config.signal_type = visualization::SignalType::ANALOG;
+    config.sample_rate_hz = 1000;
+    config.voltage_scale = 1;
+    config.time_scale_us = 1000;
+    config.visible = true;
+    int channel = analyzer.AddChannel(config);
+    analyzer.StartCapture();
+
+    FrameLayout layout;
+    layout.Parse("t:u32 ax:i16*0.01 temp:f32");
+    SerialMonitor monitor;
+    monitor.SetTelemetryDecoder(
+        std::unique_ptr<TelemetryDecoder>(new TelemetryDecoder(FrameDecoder::Create(FrameDecoder::Framing::SLIP), layout)),
+        [&](const TelemetryDecoder& decoder) {
+            analyzer.AddSamples(channel, decoder.GetColumn(0), decoder.GetColumn(1), decoder.GetRowCount());
+        });
+    assert_true(monitor.Connect(path, 2000000), "Should open the pty");
+    size_t messages = monitor.GetMessageCount();
+
+    const size_t records = 50000;
+    std::thread device([&]() {
+        std::string data;
+        for (uint32_t t = 0; t < records; t += 10) {
+            EspFlasher::SlipEncode(sensor_records(t, 10), data);
+        }
+        for (size_t done = 0; done < data.size();) {
+            ssize_t n = write(master, data.data() + done, std::min<size_t>(1000, data.size() - done));
+            if (n > 0) done += static_cast<size_t>(n);
+        }
+    });
+    size_t seen = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (seen < records && std::chrono::steady_clock::now() < deadline) {
+        seen += monitor.ProcessIncoming();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    device.join();
+    close(master);
+    assert_equal(records, seen, "Every record decoded");
+    assert_equal(messages, monitor.GetMessageCount(), "Binary data does not become text messages");
+    std::vector<visualization::SignalSample> samples = analyzer.GetSamples(channel, 0, 1e9);
+    assert_equal(records, samples.size(), "Columns reach the analyzer");
+    assert_true(samples[1234].timestamp_us == 1234 && std::abs(samples[1234].value - 2.34) < 1e-9,
+                "Samples keep their values");
+
+    std::cout << "  ✓ Monitor telemetry tests passed" << std::endl;
+}
+
+// ============================================================================
+// Serial plotter
+// ============================================================================
+
+void test_plotter_lines() {
+    visualization::SerialPlotter plotter;
+    assert_equal(3, plotter.AddLine("1.5 2\t-3"), "Bare values");
+    assert_equal(2, plotter.AddLine("temp:21.5,hum:40\r"), "Labelled values");
+    assert_equal(1, plotter.AddLine("reading is 7 units"), "Words are skipped");
+    assert_equal(0, plotter.AddLine("I (10) boot: ok"), "Log lines add nothing");
+    assert_equal(5, plotter.GetSeriesCount(), "value 1..3, temp, hum");
+    assert_true(plotter.GetSeriesName(3) == "temp" && plotter.FindSeries("hum") == 4, "Series by label");
+    assert_equal(2, plotter.GetSampleCount(plotter.FindSeries("value 1")), "Positions map to the same series");
+
+    float min;
+    float max;
+    plotter.GetEnvelope(plotter.FindSeries("value 3"), 0, 1, 1, &min, &max);
+    assert_true(min == -3 && max == -3, "Single sample");
+
+    FrameLayout layout;
+    layout.Parse("t:u32 ax:i16*0.01 temp:f32");
+    TelemetryDecoder decoder(FrameDecoder::Create(FrameDecoder::Framing::COBS), layout);
+    std::string frame = cobs_encode(sensor_records(0, 100));
+    decoder.Feed(frame.data(), frame.size());
+    assert_equal(300, plotter.AddColumns(decoder), "Telemetry columns");
+    assert_equal(100, plotter.GetSampleCount(plotter.FindSeries("ax")), "One series per field");
+    assert_equal(101, plotter.GetSampleCount(plotter.FindSeries("temp")), "Shared with the text series");
+
+    // Ever-changing labels stop at the series limit
+    visualization::SerialPlotter::Options options = visualization::SerialPlotter::GetDefaultOptions();
+    options.max_series = 4;
+    visualization::SerialPlotter capped(options);
+    assert_equal(3, capped.AddLine("1 2 3"), "Under the limit");
+    assert_equal(2, capped.AddLine("a:1 b:2 4"), "One more series, then values for new ones are dropped");
+    assert_equal(4, capped.AddLine("a:5 c:6 7 8 9"), "Known series still plot");
+    assert_equal(4, capped.GetSeriesCount(), "Capped");
+    assert_equal(-1, capped.AddSeries("d"), "No room");
+    assert_equal(3, capped.GetSampleCount(capped.FindSeries("value 1")), "Positions unaffected");
+
+    std::cout << "  ✓ Plotter line tests passed" << std::endl;
+}
+
+void test_plotter_pyramid() {
+    // Small rings so that history moves through every level
+    visualization::SerialPlotter::Options options = visualization::SerialPlotter::GetDefaultOptions();
+    options.capacity = 4096;
+    options.decimation = 4;
+    options.levels = 3;
+    options.level_capacity = 1024;
+    visualization::SerialPlotter plotter(options);
+    int series = plotter.AddSeries("saw");
+
+    const uint64_t total = 51203;
+    std::vector<float> values(total);
+    for (uint64_t i = 0; i < total; ++i) {
+        values[i] = static_cast<float>(i % 100) + (i == 30001 ? 1000 : 0) - (i == 51201 ? 500 : 0);
+        plotter.AddSample(series, values[i]);
+    }
+    assert_equal(total, plotter.GetSampleCount(series), "Count");
+
+    auto check = [&](uint64_t first, uint64_t end, size_t columns) {
+        std::vector<float> mins(columns);
+        std::vector<float> maxs(columns);
+        plotter.GetEnvelope(series, first, end, columns, mins.data(), maxs.data());
+        for (size_t c = 0; c < columns; ++c) {
+            uint64_t lo = first + (end - first) * c / columns;
+            uint64_t hi = first + (end - first) * (c + 1) / columns;
+            float min = *std::min_element(values.begin() + lo, values.begin() + hi);
+            float max = *std::max_element(values.begin() + lo, values.begin() + hi);
+            if (mins[c] != min || maxs[c] != max) return false;
+        }
+        return true;
+    };
+    // Column edges on entry boundaries make the envelope exact, at any level
+    assert_true(check(total - 3 - 64 * 50, total - 3, 50), "Recent samples, coarse level");
+    assert_true(check(total - 3 - 64, total, 1), "Live edge from the finer levels");
+    assert_true(check(total - 2000, total, 2000), "Sample level");
+    assert_true(check(0, 64 * 800, 800), "Evicted samples from the coarsest level");
+    assert_true(check(29952, 30016, 1), "Old spikes survive decimation");
+
+    // Older than every level keeps
+    visualization::SerialPlotter::Options tiny = options;
+    tiny.capacity = 64;
+    tiny.level_capacity = 64;
+    visualization::SerialPlotter forgetful(tiny);
+    forgetful.AddSeries("saw");
+    for (uint64_t i = 0; i < total; ++i) forgetful.AddSample(0, values[i]);
+    uint64_t first = forgetful.GetFirstIndex(0);
+    assert_true(first > 0 && first < total - 64, "Coarse levels reach past the samples");
+    float min;
+    float max;
+    forgetful.GetEnvelope(0, 0, first, 1, &min, &max);
+    assert_true(std::isnan(min) && std::isnan(max), "Forgotten ranges are NaN");
+    forgetful.GetEnvelope(0, first, total, 1, &min, &max);
+    assert_true(min == -499 && max == 99, "The rest is covered");
+
+    std::cout << "  ✓ Plotter pyramid tests passed" << std::endl;
+}
+
+void test_plotter_render() {
+    // Ten series at 1 kHz for an hour
+    visualization::SerialPlotter plotter;
+    const int series = 10;
+    const size_t samples = 3600 * 1000;
+    std::vector<double> block(1000);
+    for (int s = 0; s < series; ++s) plotter.AddSeries("ch" + std::to_string(s));
+    auto start = std::chrono::steady_clock::now();
+    for (size_t second = 0; second < samples / block.size(); ++second) {
+        for (int s = 0; s < series; ++s) {
+            for (size_t i = 0; i < block.size(); ++i) {
+                block[i] = s * 10 + std::sin((second * block.size() + i) * 0.001 * (s + 1));
+            }
+            plotter.AddSamples(s, block.data(), block.size());
+        }
+    }
+    double append_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    assert_equal(samples, plotter.GetEndIndex(), "Every sample kept");
+
+    renderer::PureCRenderer renderer;
+    renderer.Initialize(800, 300);
+    auto render = [&](uint64_t span) {
+        renderer.Clear(renderer::Color::Black());
+        auto begin = std::chrono::steady_clock::now();
+        plotter.RenderLatest(renderer, 0, 0, 800, 300, span);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    };
+    double whole = render(samples);
+    double recent = render(4000);
+    assert_true(whole < 0.25, "A full hour renders in time proportional to the width");
+
+    // Every column of the bottom series is drawn in its colour
+    const uint32_t* pixels = renderer.GetFramebuffer();
+    uint32_t color = plotter.GetSeriesColor(0).ToRGBA();
+    int drawn = 0;
+    for (int x = 0; x < 800; ++x) {
+        bool found = false;
+        for (int y = 200; y < 300 && !found; ++y) found = pixels[y * 800 + x] == color;
+        drawn += found;
+    }
+    assert_equal(800, drawn, "Connected trace");
+
+    std::cout << "  ✓ Plotter render tests passed (" << static_cast<long long>(append_seconds * 1000)
+              << " ms for 36M samples, " << static_cast<long long>(whole * 1000) << "/"
+              << static_cast<long long>(recent * 1000) << " ms per frame)" << std::endl;
+}
+
+// ============================================================================
+// Main Test Runner
+// ============================================================================
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "ESP32 Driver IDE - Serial Tests" << std::endl;
+    std::cout << "========================================" << std::endl;
+    std::cout << std::endl;
+
+    try {
+        std::cout << "Codec Tests:" << std::endl;
+        test_md5_and_deflate();
+        test_slip_framing();
+
+        std::cout << "\nFlasher Tests:" << std::endl;
+        test_flash_compressed();
+        test_flash_skips_unchanged();
+        test_flash_newer_chip();
+        test_flash_uncompressed_and_verify();
+        test_connect_without_device();
+        test_flash_with_stub();
+        test_flash_esp8266_rom();
+        test_compile_and_upload();
+
+        std::cout << "\nRing and Monitor Tests:" << std::endl;
+        test_spsc_ring();
+        test_custom_baud_rates();
+        test_monitor_over_pty();
+        test_monitor_batching();
+        test_session_replay();
+        test_multi_port_monitor();
+        test_panic_symbolizer();
+
+        std::cout << "\nLog Store Tests:" << std::endl;
+        test_log_store_spill();
+        test_log_store_bounded();
+        test_archive_seek_and_search();
+        test_monitor_recording();
+
+        std::cout << "\nTelemetry Tests:" << std::endl;
+        test_frame_decoders();
+        test_telemetry_decoder();
+        test_monitor_telemetry();
+
+        std::cout << "\nPlotter Tests:" << std::endl;
+        test_plotter_lines();
+        test_plotter_pyramid();
+        test_plotter_render();
+
+        std::cout << "\nFleet Tests:" << std::endl;
+        test_fleet_flash();
+        test_fleet_slow_board();
+
+        std::cout << std::endl;
+        std::cout << "========================================" << std::endl;
+        std::cout << "✓ ALL SERIAL TESTS PASSED!" << std::endl;
+        std::cout << "========================================" << std::endl;
+
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "✗ TEST FAILED: " << e.what() << std::endl;
+        return 1;
+    }
+}
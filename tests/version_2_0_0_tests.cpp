@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
 
 #include "platform/platform_expansion.h"
 #include "visualization/advanced_visualization.h"
@@ -662,14 +664,32 @@ void test_custom_compilers() {
     auto gcc = compilers.GetCompilerConfig("gcc");
     assert_equal("GCC", gcc.name);
     
-    // Test compilation (simulated)
-    auto result = compilers.Compile("gcc", "main.cpp", "main.o");
+    // Test compilation with the host toolchain
+    auto dir = std::filesystem::temp_directory_path() / "esp32ide_custom_compilers";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream(dir / "main.c") << "int util(void);\nint main(void) { return util(); }\n";
+    std::ofstream(dir / "util.c") << "int util(void) { return 0; }\n";
+    
+    auto result = compilers.Compile("gcc", (dir / "main.c").string(), (dir / "main.o").string());
+    assert_equal(0, result.exit_code);
+    result = compilers.Compile("gcc", (dir / "util.c").string(), (dir / "util.o").string());
     assert_equal(0, result.exit_code);
     
-    // Test linking (simulated)
-    std::vector<std::string> objects = {"main.o", "util.o"};
-    auto link_result = compilers.Link("gcc", objects, "program");
+    // Test linking
+    std::vector<std::string> objects = {(dir / "main.o").string(), (dir / "util.o").string()};
+    auto link_result = compilers.Link("gcc", objects, (dir / "program").string());
     assert_equal(0, link_result.exit_code);
+    assert_true(std::filesystem::exists(dir / "program"), "Linked program should exist");
+    
+    // Compiler errors are reported and parsed
+    std::ofstream(dir / "bad.c") << "int broken(void) { return 0 }\n";
+    auto bad = compilers.Compile("gcc", (dir / "bad.c").string(), (dir / "bad.o").string());
+    assert_true(bad.exit_code != 0, "Broken source should fail to compile");
+    auto diagnostics = compilers.ParseCompilerOutput("gcc", bad.stderr_output);
+    assert_true(!diagnostics.empty(), "Compiler errors should be parsed");
+    assert_equal("error", diagnostics[0].severity);
+    std::filesystem::remove_all(dir);
     
     // Test compiler IDs
     auto ids = compilers.GetCompilerIds();